@@ -0,0 +1,125 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Single translation unit per module directory (cz --amalgamate).
+ */
+
+#include "src/cz.h"
+#include "amalgamate.h"
+#include "transpile.h"
+#include "transpiler.h"
+#include "dirlist.h"
+#include "cache.h"
+#include "sink.h"
+#include "worker.h"
+#include "src/errors.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Copy directory without trailing slashes (NULL on allocation failure) */
+static char *strip_slashes(const char *directory) {
+    size_t len = strlen(directory);
+    while (len > 1 && directory[len - 1] == '/') {
+        len--;
+    }
+    char *copy = malloc(len + 1);
+    if (copy) {
+        memcpy(copy, directory, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+/* Build directory/name (NULL on allocation failure) */
+static char *member_path(const char *directory, const char *name) {
+    size_t len = strlen(directory) + strlen(name) + 2;
+    char *path = malloc(len);
+    if (path) {
+        snprintf(path, len, "%s/%s", directory, name);
+    }
+    return path;
+}
+
+/* Write one amalgamated output, reporting failures */
+static bool write_output(const char *path, const OutputSink_t *sink) {
+    if (sink->failed || !output_write(path, sink->data, sink->length)) {
+        char error_msg[512];
+        snprintf(error_msg, sizeof(error_msg), ERR_CANNOT_WRITE_OUTPUT_FILE, path);
+        cz_error(NULL, NULL, 0, error_msg);
+        return false;
+    }
+    return true;
+}
+
+/* Transpile every .cz file of directory into directory.cz.h and directory.cz.c, interning names in symbols */
+bool amalgamate(const char *directory, SymbolTable *symbols) {
+    char *module = strip_slashes(directory);
+    const DirListing_t *listing = module ? dir_listing_cz(module) : NULL;
+    if (!listing || listing->count == 0) {
+        fprintf(stderr, "[CZ] No .cz files in module directory '%s'\n", directory);
+        free(module);
+        return false;
+    }
+    size_t module_len = strlen(module);
+    char *header_file = malloc(module_len + sizeof(".cz.h"));
+    char *source_file = malloc(module_len + sizeof(".cz.c"));
+    if (!header_file || !source_file) {
+        free(module);
+        free(header_file);
+        free(source_file);
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        return false;
+    }
+    snprintf(header_file, module_len + sizeof(".cz.h"), "%s.cz.h", module);
+    snprintf(source_file, module_len + sizeof(".cz.c"), "%s.cz.c", module);
+    const char *header_name = strrchr(header_file, '/');
+    header_name = header_name ? header_name + 1 : header_file;
+
+    OutputSink_t header, source;
+    sink_init(&header, NULL);
+    sink_init(&source, NULL);
+    transpiler_emit_header_prelude(&header);
+    sink_printf(&source, "#include \"%s\"\n", header_name);
+
+    bool ok = true;
+    for (size_t i = 0; i < listing->count && ok; i++) {
+        char *input_file = member_path(module, listing->names[i]);
+        if (!input_file) {
+            cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+            ok = false;
+            break;
+        }
+        sink_printf(&header, "/* %s */\n", input_file);
+        sink_printf(&source, "\n/* %s */\n", input_file);
+
+        TranspileRequest_t request;
+        request.input_file = input_file;
+        request.output_base = NULL;
+        request.data = NULL;
+        request.size = 0;
+        request.record = NULL;
+        request.dependencies = false;
+        request.minimal_headers = false;
+        request.compact = false;
+        request.trace = false;
+        request.header_output = &header;
+        request.source_output = &source;
+        request.stream_output = NULL;
+        ok = transpile(&request, symbols, NULL);
+        sink_putc(&header, '\n');
+        free(input_file);
+    }
+
+    ok = ok && write_output(header_file, &header) && write_output(source_file, &source);
+    if (ok) {
+        fprintf(worker_stdout(), "%s %s\n", header_file, source_file);
+    }
+    sink_free(&header);
+    sink_free(&source);
+    free(module);
+    free(header_file);
+    free(source_file);
+    return ok;
+}
@@ -0,0 +1,20 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Single translation unit per module directory (cz --amalgamate).
+ *
+ * Every .cz file of a module directory is transpiled, in sorted order, into
+ * one DIR.cz.h holding the exported declarations of the whole module and one
+ * DIR.cz.c holding every definition, with non-exported functions made static.
+ * Build DIR.cz.c instead of the per-file .cz.c files of the module.
+ */
+
+#pragma once
+
+#include "symbols.h"
+#include <stdbool.h>
+
+/* Transpile every .cz file of directory into directory.cz.h and directory.cz.c, interning names in symbols */
+bool amalgamate(const char *directory, SymbolTable *symbols);
@@ -0,0 +1,92 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Bump allocator for per-translation-unit allocations.
+ */
+
+#include "arena.h"
+#include "worker.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Alignment of arena allocations */
+#define ARENA_ALIGN (sizeof(void *) > sizeof(double) ? sizeof(void *) : sizeof(double))
+
+/* Default block size when none is given */
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+/* Bytes handed out by every arena since startup */
+static CZ_THREAD_LOCAL size_t total_allocated = 0;
+
+/* Initialize an empty arena */
+void arena_init(Arena_t *arena, size_t block_size) {
+    arena->head = NULL;
+    arena->block_size = block_size > 0 ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+    arena->allocated = 0;
+}
+
+/* Allocate zeroed, pointer-aligned memory from the arena (NULL on failure) */
+void *arena_alloc(Arena_t *arena, size_t size) {
+    if (!arena || size == 0) {
+        return NULL;
+    }
+
+    /* Round up so every allocation stays aligned */
+    size_t aligned = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (aligned < size) {
+        return NULL; /* Overflow */
+    }
+
+    ArenaBlock_t *block = arena->head;
+    if (!block || block->size - block->used < aligned) {
+        /* Oversized requests get a block of their own */
+        size_t block_size = aligned > arena->block_size ? aligned : arena->block_size;
+        block = malloc(sizeof(ArenaBlock_t) + block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->size = block_size;
+        block->used = 0;
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += aligned;
+    arena->allocated += aligned;
+    total_allocated += aligned;
+    memset(ptr, 0, aligned);
+    return ptr;
+}
+
+/* Copy length bytes of text into the arena as a NUL-terminated string */
+char *arena_strndup(Arena_t *arena, const char *text, size_t length) {
+    if (!text) {
+        return NULL;
+    }
+    char *copy = arena_alloc(arena, length + 1);
+    if (copy) {
+        memcpy(copy, text, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+/* Release every block of the arena at once */
+void arena_free(Arena_t *arena) {
+    ArenaBlock_t *block = arena->head;
+    while (block) {
+        ArenaBlock_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->allocated = 0;
+}
+
+/* Get the bytes handed out by every arena since startup */
+size_t arena_total_allocated(void) {
+    return total_allocated;
+}
@@ -0,0 +1,41 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Bump allocator for per-translation-unit allocations.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/* Arena memory block (allocations are carved from data) */
+typedef struct ArenaBlock_s {
+    struct ArenaBlock_s *next;  /* Previously filled block */
+    size_t size;                /* Usable bytes in data */
+    size_t used;                /* Bytes handed out from data */
+    char data[];                /* Block storage */
+} ArenaBlock_t;
+
+/* Arena structure */
+typedef struct {
+    ArenaBlock_t *head;         /* Current block (NULL until first allocation) */
+    size_t block_size;          /* Default size of new blocks */
+    size_t allocated;           /* Total bytes handed out */
+} Arena_t;
+
+/* Initialize an empty arena */
+void arena_init(Arena_t *arena, size_t block_size);
+
+/* Allocate zeroed, pointer-aligned memory from the arena (NULL on failure) */
+void *arena_alloc(Arena_t *arena, size_t size);
+
+/* Copy length bytes of text into the arena as a NUL-terminated string */
+char *arena_strndup(Arena_t *arena, const char *text, size_t length);
+
+/* Release every block of the arena at once */
+void arena_free(Arena_t *arena);
+
+/* Get the bytes handed out by every arena since startup */
+size_t arena_total_allocated(void);
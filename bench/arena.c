@@ -0,0 +1,43 @@
+#include "../dist/cz.h"
+#include <stdlib.h>
+
+/* Compare request-scoped allocations from malloc/free and from an arena */
+
+#define ALLOCATIONS 16
+
+/* One request: 16 allocations of growing sizes, then free them all */
+static void bench_malloc(void *arg, unsigned long long iterations) {
+    (void)arg;
+    void *pointers[ALLOCATIONS];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        for (int j = 0; j < ALLOCATIONS; j++) {
+            pointers[j] = malloc((size_t)(16 + j * 8));
+            cz_do_not_optimize(pointers[j]);
+        }
+        for (int j = 0; j < ALLOCATIONS; j++) {
+            free(pointers[j]);
+        }
+    }
+}
+
+static void bench_arena(void *arg, unsigned long long iterations) {
+    cz_arena_t *arena = arg;
+    cz_arena_mark_t empty = cz_arena_mark(arena);
+    for (unsigned long long i = 0; i < iterations; i++) {
+        for (int j = 0; j < ALLOCATIONS; j++) {
+            cz_do_not_optimize(cz_arena_alloc(arena, (size_t)(16 + j * 8)));
+        }
+        cz_arena_reset(arena, empty);
+    }
+}
+
+int main(int argc, char **argv) {
+    cz_arena_t arena = CZ_ARENA_INIT;
+    const cz_bench_t benches[] = {
+        { "malloc/free x16", bench_malloc, NULL },
+        { "cz_arena x16 + reset", bench_arena, &arena },
+    };
+    int status = cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+    cz_arena_release(&arena);
+    return status;
+}
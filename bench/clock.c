@@ -0,0 +1,33 @@
+#include "../dist/cz.h"
+
+/* Compare the cost of reading each clock */
+
+static void bench_clock(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_monotonic_clock_ns());
+    }
+}
+
+static void bench_coarse(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_monotonic_coarse_ns());
+    }
+}
+
+static void bench_cycles(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_cycles());
+    }
+}
+
+int main(int argc, char **argv) {
+    static const cz_bench_t benches[] = {
+        { "cz_monotonic_clock_ns", bench_clock, NULL },
+        { "cz_monotonic_coarse_ns", bench_coarse, NULL },
+        { "cz_cycles", bench_cycles, NULL },
+    };
+    return cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+}
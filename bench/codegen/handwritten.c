@@ -0,0 +1,62 @@
+#include "handwritten.h"
+#include <stddef.h>
+
+/* Out of line in main.c, so neither side can inline it */
+void bench_release(void *slot);
+
+/* Cleanup called by hand before each return */
+uint64_t c_defer(uint64_t *slots, uint64_t n) {
+    void *slot = slots + (n & 7);
+    if (n & 8) {
+        bench_release(slot);
+        return n;
+    }
+    bench_release(slot);
+    return n * 3;
+}
+
+uint8_t c_cast(uint32_t value) {
+    return value > 255 ? 255 : (uint8_t)value;
+}
+
+int64_t c_foreach_array(const samples_t *samples) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < sizeof(samples->values) / sizeof(samples->values[0]); i++) {
+        sum += samples->values[i];
+    }
+    return sum;
+}
+
+uint64_t c_foreach_range(uint32_t n) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i <= n; i++) {
+        sum += i;
+    }
+    return sum;
+}
+
+static void counter_add(counter_t *counter, uint64_t amount) {
+    counter->total += amount;
+    counter->calls += 1;
+}
+
+uint64_t c_methods(counter_t *counter, uint64_t amount) {
+    counter_add(counter, amount);
+    return counter->total;
+}
+
+static int32_t mix(int32_t value, int32_t scale, int32_t offset) {
+    return value * scale + offset;
+}
+
+int32_t c_named(int32_t x) {
+    return mix(x, 3, 7);
+}
+
+int32_t c_ifexpr(int32_t value) {
+    return value < 0 ? -value : value;
+}
+
+int32_t c_ifexpr_nested(int32_t value) {
+    return value < 0 ? 0 : value > 100 ? 100 : value;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+/* The operations of overhead.cz written by hand in C */
+
+typedef struct {
+    uint64_t total;
+    uint64_t calls;
+} counter_t;
+
+typedef struct {
+    int32_t values[256];
+} samples_t;
+
+uint64_t c_defer(uint64_t *slots, uint64_t n);
+uint8_t c_cast(uint32_t value);
+int64_t c_foreach_array(const samples_t *samples);
+uint64_t c_foreach_range(uint32_t n);
+uint64_t c_methods(counter_t *counter, uint64_t amount);
+int32_t c_named(int32_t x);
+int32_t c_ifexpr(int32_t value);
+int32_t c_ifexpr_nested(int32_t value);
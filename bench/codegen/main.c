@@ -0,0 +1,161 @@
+#include "../../dist/cz.h"
+#include "overhead.cz.h"
+#include "defer_inline.cz.h"
+#include "handwritten.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Time each CZar lowering against the same operation written by hand: the two sides live in
+ * their own translation units (no LTO), so every call is a real call to the emitted code */
+
+#define INPUTS 1024
+
+static uint32_t inputs[INPUTS];
+static uint64_t slots[8];
+static Samples_t czar_samples;
+static samples_t c_samples;
+static Counter_t czar_counter;
+static counter_t c_counter;
+
+/* Cleanup of the defer operations */
+void bench_release(void *slot) {
+    *(uint64_t *)slot += 1;
+}
+
+/* Each iteration runs the operation once per input, the results are scaled to one operation
+ * (the clobber stops the pure and const attributes CZar infers from hoisting a call with an
+ * unchanged input out of the loop) */
+#define BENCH_OP(name, call) \
+    static void name(void *arg, unsigned long long iterations) { \
+        (void)arg; \
+        uint64_t sum = 0; \
+        for (unsigned long long i = 0; i < iterations; i++) { \
+            for (size_t j = 0; j < INPUTS; j++) { \
+                uint32_t input = inputs[j]; \
+                (void)input; \
+                sum += (uint64_t)(call); \
+                cz_clobber_memory(); \
+            } \
+        } \
+        cz_do_not_optimize(sum); \
+    }
+
+BENCH_OP(bench_czar_defer, czar_defer(slots, input))
+BENCH_OP(bench_c_defer, c_defer(slots, input))
+BENCH_OP(bench_czar_defer_inline, czar_defer_inline(slots, input))
+BENCH_OP(bench_czar_cast, czar_cast(input))
+BENCH_OP(bench_c_cast, c_cast(input))
+BENCH_OP(bench_czar_foreach_array, czar_foreach_array(&czar_samples))
+BENCH_OP(bench_c_foreach_array, c_foreach_array(&c_samples))
+BENCH_OP(bench_czar_foreach_range, czar_foreach_range(input & 255))
+BENCH_OP(bench_c_foreach_range, c_foreach_range(input & 255))
+BENCH_OP(bench_czar_methods, czar_methods(&czar_counter, input))
+BENCH_OP(bench_c_methods, c_methods(&c_counter, input))
+BENCH_OP(bench_czar_named, czar_named((int32_t)input))
+BENCH_OP(bench_c_named, c_named((int32_t)input))
+BENCH_OP(bench_czar_ifexpr, czar_ifexpr((int32_t)input))
+BENCH_OP(bench_c_ifexpr, c_ifexpr((int32_t)input))
+BENCH_OP(bench_czar_ifexpr_nested, czar_ifexpr_nested((int32_t)(input % 256) - 64))
+BENCH_OP(bench_c_ifexpr_nested, c_ifexpr_nested((int32_t)(input % 256) - 64))
+
+/* A lowering and its hand-written equivalent */
+typedef struct {
+    cz_bench_t czar;
+    cz_bench_t c;
+} pair_t;
+
+int main(int argc, char **argv) {
+    /* Fail when a lowering is both PCT% and N ns slower than hand-written C (a nanosecond
+     * operation moves by more than 10% with the alignment of the loop calling it) */
+    double max_overhead = 10.0;
+    double noise_ns = 0.5;
+    int rounds = 3;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--max-overhead=", 15) == 0) {
+            max_overhead = strtod(argv[i] + 15, NULL);
+        } else if (strncmp(argv[i], "--noise-ns=", 11) == 0) {
+            noise_ns = strtod(argv[i] + 11, NULL);
+        } else if (strncmp(argv[i], "--rounds=", 9) == 0) {
+            rounds = atoi(argv[i] + 9) > 0 ? atoi(argv[i] + 9) : 1;
+        }
+    }
+
+    uint32_t state = 2463534242u;
+    for (size_t i = 0; i < INPUTS; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        inputs[i] = i % 4 == 0 ? state : state % 1000;
+    }
+    for (size_t i = 0; i < 256; i++) {
+        czar_samples.values[i] = (int32_t)inputs[i] - 500;
+        c_samples.values[i] = (int32_t)inputs[i] - 500;
+    }
+
+    static const pair_t pairs[] = {
+        { { "czar defer (cleanup)", bench_czar_defer, NULL }, { "c defer (cleanup)", bench_c_defer, NULL } },
+        { { "czar defer (inline)", bench_czar_defer_inline, NULL }, { "c defer (inline)", bench_c_defer, NULL } },
+        { { "czar cast", bench_czar_cast, NULL }, { "c cast", bench_c_cast, NULL } },
+        { { "czar foreach array", bench_czar_foreach_array, NULL }, { "c foreach array", bench_c_foreach_array, NULL } },
+        { { "czar foreach range", bench_czar_foreach_range, NULL }, { "c foreach range", bench_c_foreach_range, NULL } },
+        { { "czar methods", bench_czar_methods, NULL }, { "c methods", bench_c_methods, NULL } },
+        { { "czar named arguments", bench_czar_named, NULL }, { "c named arguments", bench_c_named, NULL } },
+        { { "czar ifexpr", bench_czar_ifexpr, NULL }, { "c ifexpr", bench_c_ifexpr, NULL } },
+        { { "czar ifexpr nested", bench_czar_ifexpr_nested, NULL }, { "c ifexpr nested", bench_c_ifexpr_nested, NULL } },
+    };
+    enum { PAIRS = sizeof(pairs) / sizeof(pairs[0]) };
+
+    cz_bench_options_t options;
+    cz_bench_options(argc, argv, &options);
+    cz_bench_result_t results[2 * PAIRS];
+    size_t measured[PAIRS];
+    size_t count = 0;
+    for (size_t i = 0; i < PAIRS; i++) {
+        /* Alternate the two sides and keep the fastest round of each, so a round the machine
+         * slowed down as a whole does not decide the comparison (pairs run only if both match --filter) */
+        cz_bench_result_t *czar = &results[count];
+        cz_bench_result_t *c = &results[count + 1];
+        bool ran = true;
+        for (int round = 0; round < rounds && ran; round++) {
+            cz_bench_result_t czar_round;
+            cz_bench_result_t c_round;
+            ran = cz_bench_run(&pairs[i].czar, &options, &czar_round) &&
+                  cz_bench_run(&pairs[i].c, &options, &c_round);
+            if (ran && (round == 0 || czar_round.min_ns < czar->min_ns)) {
+                *czar = czar_round;
+            }
+            if (ran && (round == 0 || c_round.min_ns < c->min_ns)) {
+                *c = c_round;
+            }
+        }
+        measured[i] = ran ? count : SIZE_MAX;
+        count += ran ? 2 : 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        results[i].min_ns /= INPUTS;
+        results[i].median_ns /= INPUTS;
+        results[i].p99_ns /= INPUTS;
+        results[i].mean_ns /= INPUTS;
+        results[i].stddev_ns /= INPUTS;
+        results[i].iterations *= INPUTS;
+    }
+    cz_bench_print(results, count, options.output);
+
+    /* Compare the fastest samples (the least noisy) on stderr, stdout keeps the chosen format */
+    int status = 0;
+    fprintf(stderr, "%-24s %10s %10s %9s\n", "lowering", "czar ns", "c ns", "overhead");
+    for (size_t i = 0; i < PAIRS; i++) {
+        if (measured[i] == SIZE_MAX) {
+            continue;
+        }
+        const cz_bench_result_t *czar = &results[measured[i]];
+        const cz_bench_result_t *c = &results[measured[i] + 1];
+        double overhead = c->min_ns > 0.0 ? 100.0 * (czar->min_ns - c->min_ns) / c->min_ns : 0.0;
+        bool failed = overhead > max_overhead && czar->min_ns - c->min_ns > noise_ns;
+        fprintf(stderr, "%-24s %10.2f %10.2f %8.1f%%%s\n", pairs[i].czar.name + 5, czar->min_ns, c->min_ns,
+                overhead, failed ? "  FAIL" : "");
+        status |= failed;
+    }
+    return status;
+}
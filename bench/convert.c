@@ -0,0 +1,64 @@
+#include "../dist/cz.h"
+#include <stdio.h>
+
+/* Compare the libczar conversions with snprintf */
+
+static void bench_snprintf_lld(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[CZ_DTOA_MAX];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(snprintf(buf, sizeof(buf), "%lld", (long long)i * 7919 - 1000000));
+    }
+}
+
+static void bench_itoa(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[CZ_DTOA_MAX];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_itoa((long long)i * 7919 - 1000000, buf));
+    }
+}
+
+static void bench_snprintf_g(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[CZ_DTOA_MAX];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(snprintf(buf, sizeof(buf), "%.17g", (double)i / 64.0));
+    }
+}
+
+static void bench_dtoa(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[CZ_DTOA_MAX];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_dtoa((double)i / 64.0, buf));
+    }
+}
+
+static void bench_snprintf_p(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[CZ_DTOA_MAX];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(snprintf(buf, sizeof(buf), "%p", (void *)(buf + i)));
+    }
+}
+
+static void bench_ptoa(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[CZ_DTOA_MAX];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_ptoa(buf + i, buf));
+    }
+}
+
+int main(int argc, char **argv) {
+    static const cz_bench_t benches[] = {
+        { "snprintf %lld", bench_snprintf_lld, NULL },
+        { "cz_itoa", bench_itoa, NULL },
+        { "snprintf %.17g", bench_snprintf_g, NULL },
+        { "cz_dtoa", bench_dtoa, NULL },
+        { "snprintf %p", bench_snprintf_p, NULL },
+        { "cz_ptoa", bench_ptoa, NULL },
+    };
+    return cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+}
@@ -0,0 +1,381 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Transpiler scaling benchmark (make bench-cz): generates synthetic .cz inputs of
+ * increasing size mixing every feature, runs cz --profile=json on each and reports
+ * tokens/s, time per feature and peak RSS, as a table and as JSON.
+ *
+ *   scale [--cz=PATH] [--out=FILE] [--label=TEXT] [--runs=N] [--dir=DIR] LINES...
+ */
+
+#define _DEFAULT_SOURCE /* wait4 */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_SIZES 16
+#define MAX_STEPS 64
+
+/* Cost of one profile step at one size */
+typedef struct {
+    char phase[32];
+    char name[32];
+    unsigned long long ns;
+} Step_t;
+
+/* Measurements of one corpus */
+typedef struct {
+    size_t lines;
+    size_t tokens;
+    unsigned long long ns;       /* Sum of the profile steps */
+    unsigned long long wall_ns;  /* Whole process, startup included */
+    long peak_rss_kb;
+    Step_t steps[MAX_STEPS];
+    size_t step_count;
+} Result_t;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+/* Write one unit of code using every feature, returns the number of lines written */
+static size_t write_unit(FILE *out, size_t k) {
+    fprintf(out,
+            "enum Shape%zu {\n"
+            "    SHAPE%zu_CIRCLE,\n"
+            "    SHAPE%zu_SQUARE,\n"
+            "    SHAPE%zu_TRIANGLE\n"
+            "};\n"
+            "\n"
+            "struct Point%zu {\n"
+            "    i32 x;\n"
+            "    i32 y;\n"
+            "};\n"
+            "\n"
+            "i32 Point%zu.sum() {\n"
+            "    return self.x + self.y;\n"
+            "}\n"
+            "\n"
+            "i32 shape%zu_sides(enum Shape%zu shape%zu) {\n"
+            "    switch (shape%zu) {\n"
+            "    case Shape%zu.SHAPE%zu_CIRCLE:\n"
+            "        return 0;\n"
+            "    case Shape%zu.SHAPE%zu_SQUARE:\n"
+            "        return 4;\n"
+            "    case Shape%zu.SHAPE%zu_TRIANGLE:\n"
+            "        return 3;\n"
+            "    default:\n"
+            "        UNREACHABLE(\"Invalid shape\");\n"
+            "    }\n"
+            "}\n"
+            "\n"
+            "i32 scale%zu(i32 value, i32 factor, i32 offset) {\n"
+            "    return value * factor + offset;\n"
+            "}\n"
+            "\n"
+            "i32 work%zu(i32 n) {\n"
+            "    mut i32 total = 0;\n"
+            "    mut void *scratch = malloc(16) #defer {\n"
+            "        free(scratch);\n"
+            "    };\n"
+            "    for (i32 i : 0..n) {\n"
+            "        total += scale%zu(value = i, factor = 2, offset = %zu);\n"
+            "    }\n"
+            "    mut Point%zu p = {0};\n"
+            "    p.x = total;\n"
+            "    p.y = cast<i32>(n, 0);\n"
+            "    u8 small = cast<u8>(total, 0);\n"
+            "    total += p.sum() + shape%zu_sides(SHAPE%zu_SQUARE) + small;\n"
+            "    return total;\n"
+            "}\n"
+            "\n",
+            k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k);
+    return 48;
+}
+
+/* Write a corpus of about lines lines to path */
+static int generate(const char *path, size_t lines) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "[CZ] %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(out, "#include <stdlib.h>\n#include <stdio.h>\n\n");
+    size_t written = 3;
+    size_t units = 0;
+    while (units == 0 || written + 5 < lines) {
+        written += write_unit(out, units++);
+    }
+    fprintf(out, "int main(void) {\n    printf(\"%%d\\n\", work0(10));\n    return 0;\n}\n");
+    fclose(out);
+    return 0;
+}
+
+/* Read the whole file at path (NUL-terminated), NULL on failure */
+static char *read_text(const char *path) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        return NULL;
+    }
+    size_t cap = 4096;
+    size_t size = 0;
+    char *text = malloc(cap);
+    while (text) {
+        size += fread(text + size, 1, cap - size - 1, in);
+        if (size < cap - 1) {
+            break;
+        }
+        char *grown = realloc(text, cap * 2);
+        if (!grown) {
+            free(text);
+            text = NULL;
+            break;
+        }
+        text = grown;
+        cap *= 2;
+    }
+    fclose(in);
+    if (text) {
+        text[size] = '\0';
+    }
+    return text;
+}
+
+/* Copy the JSON string value following key into out */
+static const char *json_string(const char *at, const char *key, char *out, size_t size) {
+    const char *found = strstr(at, key);
+    if (!found) {
+        return NULL;
+    }
+    found += strlen(key);
+    size_t n = 0;
+    while (*found && *found != '"' && n + 1 < size) {
+        out[n++] = *found++;
+    }
+    out[n] = '\0';
+    return found;
+}
+
+/* Fill the steps of result from a cz --profile=json report */
+static int parse_profile(const char *json, Result_t *result) {
+    const char *report = strstr(json, "{\"file\": ");
+    if (!report) {
+        return -1;
+    }
+    const char *at = report;
+    while ((at = strstr(at, "{\"phase\": \"")) && result->step_count < MAX_STEPS) {
+        Step_t *step = &result->steps[result->step_count];
+        at = json_string(at, "{\"phase\": \"", step->phase, sizeof(step->phase));
+        at = at ? json_string(at, "\"name\": \"", step->name, sizeof(step->name)) : NULL;
+        const char *ns = at ? strstr(at, "\"ns\": ") : NULL;
+        const char *tokens = at ? strstr(at, "\"tokens\": ") : NULL;
+        if (!ns || !tokens) {
+            return -1;
+        }
+        step->ns = strtoull(ns + strlen("\"ns\": "), NULL, 10);
+        if (strcmp(step->phase, "lex") == 0) {
+            result->tokens = strtoull(tokens + strlen("\"tokens\": "), NULL, 10);
+        }
+        result->ns += step->ns;
+        result->step_count++;
+    }
+    return result->step_count > 0 ? 0 : -1;
+}
+
+/* Run cz --profile=json on input once, filling result */
+static int run_cz(const char *cz, const char *input, const char *dir, Result_t *result) {
+    char report[4096];
+    snprintf(report, sizeof(report), "%s/profile.json", dir);
+
+    unsigned long long start = now_ns();
+    pid_t pid = fork();
+    if (pid < 0) {
+        return -1;
+    }
+    if (pid == 0) {
+        int null = open("/dev/null", O_WRONLY);
+        int err = open(report, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (null < 0 || err < 0) {
+            _exit(127);
+        }
+        dup2(null, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+        execl(cz, cz, "--profile=json", "-o", dir, input, (char *)NULL);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "[CZ] %s %s failed (see %s)\n", cz, input, report);
+        return -1;
+    }
+    result->wall_ns = now_ns() - start;
+    result->peak_rss_kb = usage.ru_maxrss;
+
+    char *json = read_text(report);
+    int parsed = json ? parse_profile(json, result) : -1;
+    free(json);
+    if (parsed != 0) {
+        fprintf(stderr, "[CZ] %s: no profile report\n", report);
+    }
+    return parsed;
+}
+
+/* Cost of the phase/name step in result, 0 when missing */
+static unsigned long long step_ns(const Result_t *result, const Step_t *step) {
+    for (size_t i = 0; i < result->step_count; i++) {
+        if (strcmp(result->steps[i].phase, step->phase) == 0 && strcmp(result->steps[i].name, step->name) == 0) {
+            return result->steps[i].ns;
+        }
+    }
+    return 0;
+}
+
+/* Nanoseconds per line of a step (0 when it did not run) */
+static double per_line(unsigned long long ns, size_t lines) {
+    return lines > 0 ? (double)ns / (double)lines : 0.0;
+}
+
+static void print_table(const Result_t *results, size_t count) {
+    printf("%10s %10s %10s %12s %10s %10s\n", "lines", "tokens", "ms", "tokens/s", "ns/token", "peak RSS");
+    for (size_t i = 0; i < count; i++) {
+        const Result_t *r = &results[i];
+        double seconds = (double)r->ns / 1e9;
+        printf("%10zu %10zu %10.2f %12.0f %10.1f %8.1fMB\n", r->lines, r->tokens, (double)r->ns / 1e6,
+               seconds > 0 ? (double)r->tokens / seconds : 0.0,
+               r->tokens > 0 ? (double)r->ns / (double)r->tokens : 0.0, (double)r->peak_rss_kb / 1024.0);
+    }
+
+    /* Time per line of each step at each size: constant when linear, growing when not.
+     * The order is the exponent k of time ~ lines^k between the two largest sizes
+     * (small ones still fit in the caches): 1 when linear, 2 when quadratic. */
+    const Result_t *previous = &results[count > 1 ? count - 2 : 0];
+    const Result_t *last = &results[count - 1];
+    printf("\n%-10s %-18s", "phase", "step (ns/line)");
+    for (size_t i = 0; i < count; i++) {
+        printf(" %9zu", results[i].lines);
+    }
+    printf(" %8s\n", "order");
+    for (size_t s = 0; s < last->step_count; s++) {
+        const Step_t *step = &last->steps[s];
+        printf("%-10s %-18s", step->phase, step->name);
+        for (size_t i = 0; i < count; i++) {
+            printf(" %9.1f", per_line(step_ns(&results[i], step), results[i].lines));
+        }
+        unsigned long long base = step_ns(previous, step);
+        double order = base > 0 && step->ns > 0 && last->lines > previous->lines
+                           ? log((double)step->ns / (double)base) / log((double)last->lines / (double)previous->lines)
+                           : 1.0;
+        printf(" %8.2f%s\n", order, order > 1.5 ? " !" : "");
+    }
+}
+
+static int write_json(const char *path, const char *label, const Result_t *results, size_t count) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "[CZ] %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    fprintf(out, "{\"label\": \"%s\", \"sizes\": [", label);
+    for (size_t i = 0; i < count; i++) {
+        const Result_t *r = &results[i];
+        double seconds = (double)r->ns / 1e9;
+        fprintf(out, "%s\n  {\"lines\": %zu, \"tokens\": %zu, \"ns\": %llu, \"wall_ns\": %llu, "
+                     "\"tokens_per_sec\": %.0f, \"peak_rss_kb\": %ld, \"steps\": [",
+                i > 0 ? "," : "", r->lines, r->tokens, r->ns, r->wall_ns,
+                seconds > 0 ? (double)r->tokens / seconds : 0.0, r->peak_rss_kb);
+        for (size_t s = 0; s < r->step_count; s++) {
+            fprintf(out, "%s{\"phase\": \"%s\", \"name\": \"%s\", \"ns\": %llu}", s > 0 ? ", " : "",
+                    r->steps[s].phase, r->steps[s].name, r->steps[s].ns);
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *cz = "../../dist/cz";
+    const char *out = "results.json";
+    const char *label = "";
+    const char *dir = "corpus";
+    int runs = 1;
+    size_t sizes[MAX_SIZES];
+    size_t count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--cz=", 5) == 0) {
+            cz = argv[i] + 5;
+        } else if (strncmp(argv[i], "--out=", 6) == 0) {
+            out = argv[i] + 6;
+        } else if (strncmp(argv[i], "--label=", 8) == 0) {
+            label = argv[i] + 8;
+        } else if (strncmp(argv[i], "--dir=", 6) == 0) {
+            dir = argv[i] + 6;
+        } else if (strncmp(argv[i], "--runs=", 7) == 0) {
+            runs = atoi(argv[i] + 7) > 0 ? atoi(argv[i] + 7) : 1;
+        } else if (argv[i][0] != '-' && count < MAX_SIZES) {
+            sizes[count++] = strtoull(argv[i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--cz=PATH] [--out=FILE] [--label=TEXT] [--runs=N] [--dir=DIR] LINES...\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (count == 0) {
+        sizes[count++] = 1000;
+    }
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "[CZ] %s: %s\n", dir, strerror(errno));
+        return 1;
+    }
+
+    static Result_t results[MAX_SIZES];
+    for (size_t i = 0; i < count; i++) {
+        /* One directory per corpus: cz reads the siblings of its input for their methods */
+        char corpus[1024];
+        char input[1024 + 16];
+        snprintf(corpus, sizeof(corpus), "%s/%zu", dir, sizes[i]);
+        snprintf(input, sizeof(input), "%s/scale.cz", corpus);
+        if ((mkdir(corpus, 0755) != 0 && errno != EEXIST) || generate(input, sizes[i]) != 0) {
+            return 1;
+        }
+        /* Keep the fastest of the runs, with the largest peak RSS */
+        for (int run = 0; run < runs; run++) {
+            Result_t attempt;
+            memset(&attempt, 0, sizeof(attempt));
+            attempt.lines = sizes[i];
+            if (run_cz(cz, input, corpus, &attempt) != 0) {
+                return 1;
+            }
+            long rss = results[i].peak_rss_kb > attempt.peak_rss_kb ? results[i].peak_rss_kb : attempt.peak_rss_kb;
+            if (run == 0 || attempt.ns < results[i].ns) {
+                results[i] = attempt;
+            }
+            results[i].peak_rss_kb = rss;
+        }
+        fprintf(stderr, "[CZ] bench-cz %zu lines: %.2f ms\n", sizes[i], (double)results[i].ns / 1e6);
+    }
+
+    print_table(results, count);
+    if (write_json(out, label, results, count) != 0) {
+        return 1;
+    }
+    printf("\n[CZ] %s\n", out);
+    return 0;
+}
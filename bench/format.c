@@ -0,0 +1,63 @@
+#include "../dist/cz.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Compare the cz_format family with snprintf */
+
+static void bench_snprintf(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[128];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(snprintf(buf, sizeof(buf), "%s took %d ms (%g%%)", "request", (int)i, 12.5));
+    }
+}
+
+static void bench_format(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        char *text = cz_format("{} took {} ms ({}%)", "request", (int)i, 12.5);
+        cz_do_not_optimize(text);
+        free(text);
+    }
+}
+
+static void bench_format_to(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[128];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_format_to(&buf[0], sizeof(buf), "{} took {} ms ({}%)", "request", (int)i, 12.5));
+    }
+}
+
+static void bench_apply_to(void *arg, unsigned long long iterations) {
+    const cz_format_template_t *tpl = arg;
+    char buf[128];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_format_apply_to(&buf[0], sizeof(buf), tpl, "request", (int)i, 12.5));
+    }
+}
+
+/* Builder reset each iteration: the text stays in the inline storage, no allocation */
+static void bench_strbuf(void *arg, unsigned long long iterations) {
+    cz_strbuf_t *sb = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_strbuf_reset(sb);
+        cz_do_not_optimize(cz_strbuf_appendf(sb, "{} took {} ms ({}%)", "request", (int)i, 12.5));
+    }
+}
+
+int main(int argc, char **argv) {
+    cz_format_template_t *tpl = cz_format_compile("{} took {} ms ({}%)");
+    cz_strbuf_t sb = CZ_STRBUF_INIT;
+    const cz_bench_t benches[] = {
+        { "snprintf", bench_snprintf, NULL },
+        { "cz_format", bench_format, NULL },
+        { "cz_format_to", bench_format_to, NULL },
+        { "cz_format_apply_to", bench_apply_to, tpl },
+        { "cz_strbuf_appendf", bench_strbuf, &sb },
+    };
+    int status = cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+    cz_format_template_free(tpl);
+    cz_strbuf_free(&sb);
+    return status;
+}
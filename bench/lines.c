@@ -0,0 +1,96 @@
+#include "../dist/cz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Compare reading a file and splitting it into copied lines with mapping it and walking line views */
+
+#define PATH "lines.bench.txt"
+#define LINES 200000
+
+/* The usual pattern: fread the whole file, then copy each line out */
+static void bench_fread_copy(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        FILE *f = fopen(PATH, "rb");
+        if (!f) {
+            return;
+        }
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        char *data = malloc((size_t)size);
+        size_t read = data ? fread(data, 1, (size_t)size, f) : 0;
+        fclose(f);
+        size_t total = 0;
+        for (size_t start = 0; start < read;) {
+            char *newline = memchr(data + start, '\n', read - start);
+            size_t end = newline ? (size_t)(newline - data) : read;
+            char *line = malloc(end - start + 1);
+            if (line) {
+                memcpy(line, data + start, end - start);
+                line[end - start] = '\0';
+                total += strlen(line);
+                free(line);
+            }
+            start = end + 1;
+        }
+        free(data);
+        cz_do_not_optimize(total);
+    }
+}
+
+static void bench_fgets(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        FILE *f = fopen(PATH, "rb");
+        if (!f) {
+            return;
+        }
+        char line[256];
+        size_t total = 0;
+        while (fgets(line, sizeof(line), f)) {
+            total += strlen(line);
+        }
+        fclose(f);
+        cz_do_not_optimize(total);
+    }
+}
+
+static void bench_mmap_lines(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_file_t file;
+        if (!cz_mmap_file(&file, PATH)) {
+            return;
+        }
+        cz_lines_t lines = cz_lines(file.data, file.size);
+        size_t total = 0;
+        size_t length;
+        for (const char *line; cz_lines_next(&lines, &line, &length);) {
+            total += length;
+        }
+        cz_munmap_file(&file);
+        cz_do_not_optimize(total);
+    }
+}
+
+int main(int argc, char **argv) {
+    FILE *f = fopen(PATH, "wb");
+    if (!f) {
+        return 1;
+    }
+    for (int i = 0; i < LINES; i++) {
+        fprintf(f, "    u32 value_%d = compute(%d, \"label %d\");\n", i, i * 7, i % 100);
+    }
+    fclose(f);
+
+    const cz_bench_t benches[] = {
+        { "fread + copied lines", bench_fread_copy, NULL },
+        { "fgets", bench_fgets, NULL },
+        { "cz_mmap_file + cz_lines_next", bench_mmap_lines, NULL },
+    };
+    int status = cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+    remove(PATH);
+    return status;
+}
@@ -0,0 +1,70 @@
+#include "../dist/cz.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+/* Compare the cost of cz_log() for the caller: synchronous, asynchronous and suppressed */
+
+static void bench_log(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_log_info("a message of a typical length for a service log line");
+    }
+}
+
+static void bench_logf(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_logf(CZ_LOG_INFO, "request {} took {} ms", (int)i, 12.5);
+    }
+}
+
+static void bench_logf_suppressed(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_logf(CZ_LOG_DEBUG, "request {} took {} ms", (int)i, 12.5);
+    }
+}
+
+int main(int argc, char **argv) {
+    cz_bench_options_t options;
+    cz_bench_options(argc, argv, &options);
+    static const cz_bench_t sync_benches[] = {
+        { "cz_log (sync)", bench_log, NULL },
+        { "cz_logf (sync)", bench_logf, NULL },
+    };
+    static const cz_bench_t async_benches[] = {
+        { "cz_log (async)", bench_log, NULL },
+        { "cz_logf (async)", bench_logf, NULL },
+    };
+    static const cz_bench_t suppressed = { "cz_logf (suppressed)", bench_logf_suppressed, NULL };
+    cz_bench_result_t results[5];
+    size_t count = 0;
+
+    /* The log lines go to /dev/null, the results to the real stdout */
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    if (saved < 0 || null < 0) {
+        return 1;
+    }
+    dup2(null, STDOUT_FILENO);
+
+    for (size_t i = 0; i < 2; i++) {
+        count += cz_bench_run(&sync_benches[i], &options, &results[count]);
+    }
+    cz_log_async_start(65536, CZ_LOG_OVERFLOW_BLOCK);
+    for (size_t i = 0; i < 2; i++) {
+        count += cz_bench_run(&async_benches[i], &options, &results[count]);
+    }
+    cz_log_async_stop();
+    cz_log_set_level(CZ_LOG_INFO);
+    count += cz_bench_run(&suppressed, &options, &results[count]);
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(null);
+    close(saved);
+    cz_bench_print(results, count, options.output);
+    return 0;
+}
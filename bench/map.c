@@ -0,0 +1,196 @@
+#include "../dist/cz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Compare cz_map_t with a simple chained hash table (one malloc per node, a pointer chase per probe) */
+
+#define KEYS 4096
+
+/* Node of the chained table */
+typedef struct node_s {
+    struct node_s *next;
+    uint64_t key;
+    const char *string;
+    void *value;
+} node_t;
+
+/* Chained table with a fixed power-of-two bucket count */
+typedef struct {
+    node_t **buckets;
+    size_t mask;
+} chained_t;
+
+static uint64_t chained_hash_int(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    return key ^ (key >> 33);
+}
+
+static uint64_t chained_hash_string(const char *key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = key; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void chained_init(chained_t *table, size_t buckets) {
+    table->buckets = calloc(buckets, sizeof(node_t *));
+    table->mask = buckets - 1;
+}
+
+static void chained_put(chained_t *table, uint64_t hash, uint64_t key, const char *string, void *value) {
+    node_t *node = malloc(sizeof(node_t));
+    if (!node) {
+        return;
+    }
+    node->key = key;
+    node->string = string;
+    node->value = value;
+    node->next = table->buckets[hash & table->mask];
+    table->buckets[hash & table->mask] = node;
+}
+
+static void *chained_get_int(const chained_t *table, uint64_t key) {
+    for (node_t *node = table->buckets[chained_hash_int(key) & table->mask]; node; node = node->next) {
+        if (node->key == key) {
+            return node->value;
+        }
+    }
+    return NULL;
+}
+
+static void *chained_get_string(const chained_t *table, const char *key) {
+    for (node_t *node = table->buckets[chained_hash_string(key) & table->mask]; node; node = node->next) {
+        if (strcmp(node->string, key) == 0) {
+            return node->value;
+        }
+    }
+    return NULL;
+}
+
+static void chained_free(chained_t *table) {
+    for (size_t i = 0; i <= table->mask; i++) {
+        for (node_t *node = table->buckets[i]; node;) {
+            node_t *next = node->next;
+            free(node);
+            node = next;
+        }
+    }
+    free(table->buckets);
+}
+
+/* Keys spread like ids, strings like identifiers */
+static uint64_t g_ints[KEYS];
+static char g_strings[KEYS][24];
+
+static void bench_chained_insert(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        chained_t table;
+        chained_init(&table, KEYS);
+        for (size_t k = 0; k < KEYS; k++) {
+            chained_put(&table, chained_hash_int(g_ints[k]), g_ints[k], NULL, &g_ints[k]);
+        }
+        cz_do_not_optimize(table.buckets);
+        chained_free(&table);
+    }
+}
+
+static void bench_map_insert(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_map_t map;
+        cz_map_init(&map, CZ_MAP_INT);
+        for (size_t k = 0; k < KEYS; k++) {
+            cz_map_put_int(&map, g_ints[k], &g_ints[k]);
+        }
+        cz_do_not_optimize(map.ctrl);
+        cz_map_free(&map);
+    }
+}
+
+static void bench_map_insert_reserved(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_map_t map;
+        cz_map_init(&map, CZ_MAP_INT);
+        cz_map_reserve(&map, KEYS);
+        for (size_t k = 0; k < KEYS; k++) {
+            cz_map_put_int(&map, g_ints[k], &g_ints[k]);
+        }
+        cz_do_not_optimize(map.ctrl);
+        cz_map_free(&map);
+    }
+}
+
+static void bench_chained_get(void *arg, unsigned long long iterations) {
+    const chained_t *table = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        /* Every other key misses */
+        uint64_t key = g_ints[i % KEYS] + (i & 1);
+        cz_do_not_optimize(chained_get_int(table, key));
+    }
+}
+
+static void bench_map_get(void *arg, unsigned long long iterations) {
+    const cz_map_t *map = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        uint64_t key = g_ints[i % KEYS] + (i & 1);
+        cz_do_not_optimize(cz_map_get_int(map, key));
+    }
+}
+
+static void bench_chained_get_string(void *arg, unsigned long long iterations) {
+    const chained_t *table = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(chained_get_string(table, g_strings[i % KEYS]));
+    }
+}
+
+static void bench_map_get_string(void *arg, unsigned long long iterations) {
+    const cz_map_t *map = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_map_get_string(map, g_strings[i % KEYS]));
+    }
+}
+
+int main(int argc, char **argv) {
+    for (size_t k = 0; k < KEYS; k++) {
+        g_ints[k] = (uint64_t)k * 2654435761ULL * 2;
+        snprintf(g_strings[k], sizeof(g_strings[k]), "symbol_%zu_name", k * 31);
+    }
+
+    chained_t ints_chained;
+    chained_t strings_chained;
+    chained_init(&ints_chained, KEYS);
+    chained_init(&strings_chained, KEYS);
+    cz_map_t ints;
+    cz_map_t strings;
+    cz_map_init(&ints, CZ_MAP_INT);
+    cz_map_init(&strings, CZ_MAP_STRING);
+    for (size_t k = 0; k < KEYS; k++) {
+        chained_put(&ints_chained, chained_hash_int(g_ints[k]), g_ints[k], NULL, &g_ints[k]);
+        chained_put(&strings_chained, chained_hash_string(g_strings[k]), 0, g_strings[k], g_strings[k]);
+        cz_map_put_int(&ints, g_ints[k], &g_ints[k]);
+        cz_map_put_string(&strings, g_strings[k], g_strings[k]);
+    }
+
+    const cz_bench_t benches[] = {
+        { "chained insert 4096", bench_chained_insert, NULL },
+        { "cz_map insert 4096", bench_map_insert, NULL },
+        { "cz_map insert 4096 (reserved)", bench_map_insert_reserved, NULL },
+        { "chained get int", bench_chained_get, &ints_chained },
+        { "cz_map get int", bench_map_get, &ints },
+        { "chained get string", bench_chained_get_string, &strings_chained },
+        { "cz_map get string", bench_map_get_string, &strings },
+    };
+    int status = cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+    chained_free(&ints_chained);
+    chained_free(&strings_chained);
+    cz_map_free(&ints);
+    cz_map_free(&strings);
+    return status;
+}
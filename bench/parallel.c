@@ -0,0 +1,79 @@
+#include "../dist/cz.h"
+#include <math.h>
+#include <stdlib.h>
+
+/* Compare a serial loop with cz_parallel_for, and spawning tasks with calling them */
+
+#define ELEMENTS (1 << 20)
+#define TASKS 4096
+
+static float g_input[ELEMENTS];
+static float g_output[ELEMENTS];
+
+static void range_sqrt(size_t begin, size_t end, void *ctx) {
+    (void)ctx;
+    for (size_t i = begin; i < end; i++) {
+        g_output[i] = sqrtf(g_input[i]) * 0.5f + 1.0f;
+    }
+}
+
+static void bench_serial(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        range_sqrt(0, ELEMENTS, NULL);
+        cz_do_not_optimize(g_output[i % ELEMENTS]);
+    }
+}
+
+static void bench_parallel_for(void *arg, unsigned long long iterations) {
+    cz_threadpool_t *pool = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_parallel_for_in(pool, 0, ELEMENTS, 0, range_sqrt, NULL);
+        cz_do_not_optimize(g_output[i % ELEMENTS]);
+    }
+}
+
+/* Tiny task: what spawning costs on top of the call */
+static void task_add(void *ctx) {
+    _Atomic size_t *sum = ctx;
+    *sum += 1;
+}
+
+static void bench_calls(void *arg, unsigned long long iterations) {
+    (void)arg;
+    _Atomic size_t sum = 0;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        for (size_t t = 0; t < TASKS; t++) {
+            task_add((void *)&sum);
+        }
+    }
+    cz_do_not_optimize(sum);
+}
+
+static void bench_spawn(void *arg, unsigned long long iterations) {
+    cz_threadpool_t *pool = arg;
+    _Atomic size_t sum = 0;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_task_group_t group;
+        cz_task_group_init(&group, pool);
+        for (size_t t = 0; t < TASKS; t++) {
+            cz_task_spawn(&group, task_add, (void *)&sum);
+        }
+        cz_task_group_wait(&group);
+    }
+    cz_do_not_optimize(sum);
+}
+
+int main(int argc, char **argv) {
+    for (size_t i = 0; i < ELEMENTS; i++) {
+        g_input[i] = (float)i;
+    }
+    cz_threadpool_t *pool = cz_threadpool_default();
+    const cz_bench_t benches[] = {
+        { "serial loop 1M", bench_serial, NULL },
+        { "cz_parallel_for 1M", bench_parallel_for, pool },
+        { "call 4096", bench_calls, NULL },
+        { "cz_task_spawn 4096", bench_spawn, pool },
+    };
+    return cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+}
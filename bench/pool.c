@@ -0,0 +1,72 @@
+#include "../dist/cz.h"
+#include <stdlib.h>
+
+/* Compare churning fixed-size objects through malloc/free and through a pool */
+
+#define LIVE 64
+
+typedef struct {
+    long id;
+    char payload[56];
+} message_t;
+
+/* Objects alive at once, the oldest is replaced on each iteration */
+static message_t *g_live[LIVE];
+
+static void bench_malloc(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        free(g_live[i % LIVE]);
+        g_live[i % LIVE] = malloc(sizeof(message_t));
+        cz_do_not_optimize(g_live[i % LIVE]);
+    }
+    for (int i = 0; i < LIVE; i++) {
+        free(g_live[i]);
+        g_live[i] = NULL;
+    }
+}
+
+static void bench_cache(void *arg, unsigned long long iterations) {
+    cz_pool_cache_t *cache = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        if (g_live[i % LIVE]) {
+            cz_pool_cache_free(cache, g_live[i % LIVE]);
+        }
+        g_live[i % LIVE] = cz_pool_cache_new(cache, message_t);
+        cz_do_not_optimize(g_live[i % LIVE]);
+    }
+    for (int i = 0; i < LIVE; i++) {
+        if (g_live[i]) {
+            cz_pool_cache_free(cache, g_live[i]);
+            g_live[i] = NULL;
+        }
+    }
+}
+
+static void bench_shared(void *arg, unsigned long long iterations) {
+    cz_pool_t *pool = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_pool_free(pool, g_live[i % LIVE]);
+        g_live[i % LIVE] = cz_pool_alloc(pool);
+        cz_do_not_optimize(g_live[i % LIVE]);
+    }
+    for (int i = 0; i < LIVE; i++) {
+        cz_pool_free(pool, g_live[i]);
+        g_live[i] = NULL;
+    }
+}
+
+int main(int argc, char **argv) {
+    cz_pool_t *pool = cz_pool_create_for(message_t, false);
+    cz_pool_cache_t cache;
+    cz_pool_cache_init(&cache, pool);
+    const cz_bench_t benches[] = {
+        { "malloc/free", bench_malloc, NULL },
+        { "cz_pool_cache", bench_cache, &cache },
+        { "cz_pool (shared)", bench_shared, pool },
+    };
+    int status = cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+    cz_pool_cache_flush(&cache);
+    cz_pool_destroy(pool);
+    return status;
+}
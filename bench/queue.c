@@ -0,0 +1,149 @@
+#include "../dist/cz.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+/* Compare the lock-free queues with a mutex-protected linked list (one malloc per message) */
+
+#define MESSAGES 1024
+#define BATCH 32
+
+/* Node of the locked list */
+typedef struct node_s {
+    struct node_s *next;
+    uint64_t value;
+} node_t;
+
+/* FIFO list behind a mutex */
+typedef struct {
+    pthread_mutex_t lock;
+    node_t *head;
+    node_t *tail;
+} locked_t;
+
+static void locked_push(locked_t *list, uint64_t value) {
+    node_t *node = malloc(sizeof(node_t));
+    if (!node) {
+        return;
+    }
+    node->next = NULL;
+    node->value = value;
+    pthread_mutex_lock(&list->lock);
+    if (list->tail) {
+        list->tail->next = node;
+    } else {
+        list->head = node;
+    }
+    list->tail = node;
+    pthread_mutex_unlock(&list->lock);
+}
+
+static bool locked_pop(locked_t *list, uint64_t *value) {
+    pthread_mutex_lock(&list->lock);
+    node_t *node = list->head;
+    if (node) {
+        list->head = node->next;
+        if (!list->head) {
+            list->tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&list->lock);
+    if (!node) {
+        return false;
+    }
+    *value = node->value;
+    free(node);
+    return true;
+}
+
+/* Each iteration passes MESSAGES messages through the queue */
+
+static void bench_locked(void *arg, unsigned long long iterations) {
+    locked_t *list = arg;
+    uint64_t sum = 0;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        for (uint64_t m = 0; m < MESSAGES; m++) {
+            locked_push(list, m);
+        }
+        uint64_t value = 0;
+        while (locked_pop(list, &value)) {
+            sum += value;
+        }
+    }
+    cz_do_not_optimize(sum);
+}
+
+static void bench_spsc(void *arg, unsigned long long iterations) {
+    cz_spsc_t *queue = arg;
+    uint64_t sum = 0;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        for (uint64_t m = 0; m < MESSAGES; m++) {
+            cz_spsc_push(queue, &m);
+        }
+        uint64_t value = 0;
+        while (cz_spsc_pop(queue, &value)) {
+            sum += value;
+        }
+    }
+    cz_do_not_optimize(sum);
+}
+
+static void bench_mpmc(void *arg, unsigned long long iterations) {
+    cz_mpmc_t *queue = arg;
+    uint64_t sum = 0;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        for (uint64_t m = 0; m < MESSAGES; m++) {
+            cz_mpmc_push(queue, &m);
+        }
+        uint64_t value = 0;
+        while (cz_mpmc_pop(queue, &value)) {
+            sum += value;
+        }
+    }
+    cz_do_not_optimize(sum);
+}
+
+static void bench_mpmc_batch(void *arg, unsigned long long iterations) {
+    cz_mpmc_t *queue = arg;
+    uint64_t batch[BATCH];
+    uint64_t sum = 0;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        for (uint64_t m = 0; m < MESSAGES; m += BATCH) {
+            for (uint64_t b = 0; b < BATCH; b++) {
+                batch[b] = m + b;
+            }
+            cz_mpmc_push_n(queue, batch, BATCH);
+        }
+        for (size_t n; (n = cz_mpmc_pop_n(queue, batch, BATCH)) > 0;) {
+            for (size_t b = 0; b < n; b++) {
+                sum += batch[b];
+            }
+        }
+    }
+    cz_do_not_optimize(sum);
+}
+
+static void *idle_thread(void *arg) {
+    return arg;
+}
+
+int main(int argc, char **argv) {
+    /* Queues sit between threads: start one so the C library takes its multi-threaded locking paths */
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, idle_thread, NULL) == 0) {
+        pthread_join(thread, NULL);
+    }
+
+    locked_t list = { PTHREAD_MUTEX_INITIALIZER, NULL, NULL };
+    cz_spsc_t *spsc = cz_spsc_create_for(MESSAGES, uint64_t);
+    cz_mpmc_t *mpmc = cz_mpmc_create_for(MESSAGES, uint64_t);
+    const cz_bench_t benches[] = {
+        { "locked list 1024", bench_locked, &list },
+        { "cz_spsc 1024", bench_spsc, spsc },
+        { "cz_mpmc 1024", bench_mpmc, mpmc },
+        { "cz_mpmc batch 1024", bench_mpmc_batch, mpmc },
+    };
+    int status = cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+    cz_spsc_destroy(spsc);
+    cz_mpmc_destroy(mpmc);
+    return status;
+}
@@ -0,0 +1,82 @@
+#include "../dist/cz.h"
+#include <stdlib.h>
+
+/* Compare filling an array grown by one realloc per element and a cz_vec_t, then walking it */
+
+#define COUNT 1024
+
+static void bench_realloc(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        int *data = NULL;
+        for (int n = 0; n < COUNT; n++) {
+            int *grown = realloc(data, (size_t)(n + 1) * sizeof(int));
+            if (!grown) {
+                break;
+            }
+            data = grown;
+            data[n] = n;
+        }
+        cz_do_not_optimize(data);
+        free(data);
+    }
+}
+
+static void bench_push(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_vec_t vec = CZ_VEC_INIT(int);
+        for (int n = 0; n < COUNT; n++) {
+            int *slot = cz_vec_push(&vec);
+            if (!slot) {
+                break;
+            }
+            *slot = n;
+        }
+        cz_do_not_optimize(vec.data);
+        cz_vec_free(&vec);
+    }
+}
+
+static void bench_push_reserved(void *arg, unsigned long long iterations) {
+    (void)arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_vec_t vec = CZ_VEC_INIT(int);
+        if (!cz_vec_reserve(&vec, COUNT)) {
+            return;
+        }
+        for (int n = 0; n < COUNT; n++) {
+            *(int *)cz_vec_push(&vec) = n;
+        }
+        cz_do_not_optimize(vec.data);
+        cz_vec_free(&vec);
+    }
+}
+
+/* The loop foreach lowers a vector to: data..data+len with the bound read once */
+static void bench_walk(void *arg, unsigned long long iterations) {
+    const cz_vec_t *vec = arg;
+    for (unsigned long long i = 0; i < iterations; i++) {
+        long total = 0;
+        for (const int *it = vec->data, *end = it + vec->len; it < end; it++) {
+            total += *it;
+        }
+        cz_do_not_optimize(total);
+    }
+}
+
+int main(int argc, char **argv) {
+    cz_vec_t numbers = CZ_VEC_INIT(int);
+    if (!cz_vec_resize(&numbers, COUNT)) {
+        return 1;
+    }
+    const cz_bench_t benches[] = {
+        { "realloc per element", bench_realloc, NULL },
+        { "cz_vec_push", bench_push, NULL },
+        { "cz_vec_push (reserved)", bench_push_reserved, NULL },
+        { "walk 1024", bench_walk, &numbers },
+    };
+    int status = cz_bench_main(argc, argv, benches, sizeof(benches) / sizeof(benches[0]));
+    cz_vec_free(&numbers);
+    return status;
+}
@@ -0,0 +1,423 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Content-hash cache skipping unchanged inputs (cz --cache), and output
+ * files that are only replaced when their bytes change.
+ */
+
+#include "src/cz.h"
+#include "cache.h"
+#include "input.h"
+#include "dirlist.h"
+#include "siblings.h"
+#include "features.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+/* FNV-1a offset basis */
+#define CACHE_HASH_SEED 14695981039346656037ULL
+
+/* The running cz executable, whose bytes identify the build */
+#if defined(__linux__)
+#define CACHE_SELF_EXE "/proc/self/exe"
+#endif
+
+/* FNV-1a hash of size bytes, continuing from hash */
+static uint64_t hash_bytes(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* Hash a NUL-terminated string and its terminator (so "ab","c" differs from "a","bc") */
+static uint64_t hash_string(uint64_t hash, const char *text) {
+    return hash_bytes(hash, text, strlen(text) + 1);
+}
+
+/* Hash the contents of a file, returns false if it cannot be read */
+static bool hash_file(const char *path, uint64_t *hash) {
+    InputFile_t file;
+    if (input_open(&file, path) != INPUT_OK) {
+        return false;
+    }
+    *hash = hash_bytes(CACHE_HASH_SEED, file.data, file.size);
+    input_close(&file);
+    return true;
+}
+
+/* Hash the names of the .cz files of a directory, in the order the emitter lists them */
+static uint64_t hash_cz_listing(uint64_t hash, const char *dir_path) {
+    const DirListing_t *listing = dir_listing_cz(dir_path);
+    if (!listing) {
+        return hash_string(hash, "<no directory>");
+    }
+    for (size_t i = 0; i < listing->count; i++) {
+        hash = hash_string(hash, listing->names[i]);
+    }
+    return hash;
+}
+
+/* Hash of this cz build (once per thread): any rebuild that can change the output gets new keys.
+ * Hashes the executable where the platform exposes it, the compile time of this file otherwise. */
+static uint64_t hash_build_identity(void) {
+    static CZ_THREAD_LOCAL uint64_t identity = 0;
+    if (identity == 0) {
+#ifdef CACHE_SELF_EXE
+        if (!hash_file(CACHE_SELF_EXE, &identity))
+#endif
+        {
+            identity = hash_string(CACHE_HASH_SEED, __DATE__ " " __TIME__);
+        }
+    }
+    return identity;
+}
+
+/* Hash the feature set of this cz build: every registered feature in order, with its
+ * description, hooks, dependencies and trigger words */
+static uint64_t hash_feature_set(uint64_t hash) {
+    FeatureRegistry registry;
+    feature_registry_init(&registry);
+    register_all_features(&registry);
+    for (size_t i = 0; i < registry.count; i++) {
+        const Feature *feature = registry.features[i];
+        hash = hash_string(hash, feature->name);
+        hash = hash_string(hash, feature->description ? feature->description : "");
+        unsigned hooks = (feature->validate ? 1u : 0u) | (feature->transform ? 2u : 0u) |
+                         (feature->visit ? 4u : 0u) | (feature->emit ? 8u : 0u);
+        hash = hash_bytes(hash, &hooks, sizeof(hooks));
+        hash = hash_bytes(hash, &feature->visit_tokens, sizeof(feature->visit_tokens));
+        for (const char **names = feature->visit_names; names && *names; names++) {
+            hash = hash_string(hash, *names);
+        }
+        hash = hash_string(hash, "<dependencies>");
+        for (const char **names = feature->dependencies; names && *names; names++) {
+            hash = hash_string(hash, *names);
+        }
+        hash = hash_string(hash, "<triggers>");
+        for (const char **names = feature->triggers; names && *names; names++) {
+            hash = hash_string(hash, *names);
+        }
+    }
+    feature_registry_free(&registry);
+    return hash;
+}
+
+/* Copy the directory part of path ("." when there is none) */
+static char *directory_of(const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (!slash) {
+        return strdup(".");
+    }
+    size_t len = slash == path ? 1 : (size_t)(slash - path);
+    char *dir = malloc(len + 1);
+    if (dir) {
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+    return dir;
+}
+
+/* Hash the contents of a file into hash (a marker when it cannot be read) */
+static uint64_t hash_contents(uint64_t hash, const char *path) {
+    InputFile_t file;
+    if (input_open(&file, path) != INPUT_OK) {
+        return hash_string(hash, "<missing>");
+    }
+    hash = hash_bytes(hash, &file.size, sizeof(file.size));
+    hash = hash_bytes(hash, file.data, file.size);
+    input_close(&file);
+    return hash;
+}
+
+/* Hash the contents of the .cz files of a directory (what cz --minimal-headers scans siblings for) */
+static uint64_t hash_cz_contents(uint64_t hash, const char *dir_path) {
+    const DirListing_t *listing = dir_listing_cz(dir_path);
+    if (!listing) {
+        return hash_string(hash, "<no directory>");
+    }
+    for (size_t i = 0; i < listing->count; i++) {
+        size_t path_len = strlen(dir_path) + strlen(listing->names[i]) + sizeof("/");
+        char *path = malloc(path_len);
+        if (path) {
+            snprintf(path, path_len, "%s/%s", dir_path, listing->names[i]);
+            hash = hash_contents(hash_string(hash, listing->names[i]), path);
+            free(path);
+        }
+    }
+    return hash;
+}
+
+/* Hash a module directory: the .cz set the emitter includes and the .cz.h headers typedefs are read from */
+static uint64_t hash_module_directory(uint64_t hash, const char *dir_path) {
+    const DirListing_t *listing = dir_listing_cz(dir_path);
+    if (!listing) {
+        return hash_string(hash, "<no directory>");
+    }
+    for (size_t i = 0; i < listing->count; i++) {
+        size_t path_len = strlen(dir_path) + strlen(listing->names[i]) + sizeof("/.h");
+        char *header_path = malloc(path_len);
+        if (header_path) {
+            snprintf(header_path, path_len, "%s/%s.h", dir_path, listing->names[i]);
+            hash = hash_contents(hash_string(hash, listing->names[i]), header_path);
+            free(header_path);
+        }
+    }
+    return hash;
+}
+
+/* Hash what each #import "module" of source resolves to (a module directory, or module.cz.h) */
+static uint64_t hash_imports(uint64_t hash, const char *dir, const char *source, size_t size) {
+    const char *end = source + size;
+    for (const char *line = source; line < end; ) {
+        const char *next = memchr(line, '\n', (size_t)(end - line));
+        next = next ? next + 1 : end;
+
+        const char *p = line;
+        while (p < next && (*p == ' ' || *p == '\t')) p++;
+        if ((size_t)(next - p) > 7 && strncmp(p, "#import", 7) == 0) {
+            const char *open = memchr(p, '"', (size_t)(next - p));
+            const char *close = open ? memchr(open + 1, '"', (size_t)(next - open - 1)) : NULL;
+            if (close) {
+                size_t module_len = (size_t)(close - open - 1);
+                size_t path_len = strlen(dir) + module_len + sizeof("/.cz.h");
+                char *module_path = malloc(path_len);
+                if (module_path) {
+                    snprintf(module_path, path_len, "%s/%.*s", dir, (int)module_len, open + 1);
+                    hash = hash_string(hash, module_path);
+                    struct stat st;
+                    if (stat(module_path, &st) == 0 && S_ISDIR(st.st_mode)) {
+                        hash = hash_module_directory(hash, module_path);
+                    } else {
+                        strcat(module_path, ".cz.h");
+                        hash = hash_contents(hash, module_path);
+                    }
+                    free(module_path);
+                }
+            }
+        }
+        line = next;
+    }
+    return hash;
+}
+
+/* Hash everything the outputs of input_file depend on: the cz build and its feature set, the
+ * source, the modules and headers behind its #import directives and its sibling .cz files
+ * (the methods they declare, their contents too with minimal headers), the emit mode, tracing and the
+ * features disabled from the command line */
+uint64_t cache_input_key(const char *input_file, const char *source, size_t size, bool minimal_headers, bool compact,
+                         bool trace) {
+    uint64_t hash = hash_feature_set(hash_build_identity());
+    hash = hash_string(hash, compact ? "<compact>" : "<full>");
+    hash = hash_string(hash, trace ? "<trace>" : "<untraced>");
+    hash = hash_string(hash_string(hash, "<disabled>"), features_disabled());
+    hash = hash_string(hash, input_file);
+    hash = hash_bytes(hash, &size, sizeof(size));
+    hash = hash_bytes(hash, source, size);
+
+    char *dir = directory_of(input_file);
+    if (dir) {
+        hash = hash_imports(hash, dir, source, size);
+        hash = hash_cz_listing(hash_string(hash, "<siblings>"), dir);
+        /* Method calls resolve against what the siblings and imported modules declare */
+        char *methods = module_methods(input_file, source, size);
+        hash = hash_string(hash_string(hash, "<methods>"), methods ? methods : "<unknown>");
+        free(methods);
+        if (minimal_headers) {
+            /* Which siblings are included depends on the names they declare */
+            hash = hash_cz_contents(hash_string(hash, "<minimal headers>"), dir);
+        }
+        free(dir);
+    }
+    return hash;
+}
+
+/* Build the path of input_file's entry in cache_dir (one entry per input path) */
+static char *entry_path(const char *cache_dir, const char *input_file) {
+    uint64_t name = hash_string(CACHE_HASH_SEED, input_file);
+    size_t len = strlen(cache_dir) + 1 + 16 + sizeof(".entry");
+    char *path = malloc(len);
+    if (path) {
+        snprintf(path, len, "%s/%016llx.entry", cache_dir, (unsigned long long)name);
+    }
+    return path;
+}
+
+/* Fill record with key and the hashes of the current outputs, returns false if one is unreadable */
+bool cache_record_outputs(CacheRecord_t *record, uint64_t key, const char *header_file, const char *source_file) {
+    record->key = key;
+    return hash_file(header_file, &record->header_hash) && hash_file(source_file, &record->source_hash);
+}
+
+/* Check that record has key and that both outputs still hash to the recorded values */
+bool cache_record_matches(const CacheRecord_t *record, uint64_t key, const char *header_file, const char *source_file) {
+    CacheRecord_t current;
+    return record->key == key && cache_record_outputs(&current, key, header_file, source_file) &&
+           current.header_hash == record->header_hash && current.source_hash == record->source_hash;
+}
+
+/* Check that cache_dir recorded key for input_file and that both outputs are still as written */
+bool cache_lookup(const char *cache_dir, const char *input_file, uint64_t key,
+                  const char *header_file, const char *source_file) {
+    char *path = entry_path(cache_dir, input_file);
+    if (!path) {
+        return false;
+    }
+    FILE *entry = fopen(path, "r");
+    free(path);
+    if (!entry) {
+        return false;
+    }
+
+    /* Entry: key, header hash, source hash, then the input path */
+    unsigned long long stored_key, header_hash, source_hash;
+    char stored_input[4096];
+    bool hit = fscanf(entry, "%llx %llx %llx ", &stored_key, &header_hash, &source_hash) == 3 &&
+               fgets(stored_input, sizeof(stored_input), entry) != NULL;
+    fclose(entry);
+    if (!hit) {
+        return false;
+    }
+    stored_input[strcspn(stored_input, "\n")] = '\0';
+
+    CacheRecord_t record;
+    record.key = stored_key;
+    record.header_hash = header_hash;
+    record.source_hash = source_hash;
+    return strcmp(stored_input, input_file) == 0 &&
+           cache_record_matches(&record, key, header_file, source_file);
+}
+
+/* Record key and the current outputs of input_file in cache_dir (best effort) */
+void cache_store(const char *cache_dir, const char *input_file, uint64_t key,
+                 const char *header_file, const char *source_file) {
+    CacheRecord_t record;
+    if (!cache_record_outputs(&record, key, header_file, source_file)) {
+        return;
+    }
+    if (mkdir(cache_dir, 0777) != 0 && errno != EEXIST) {
+        return;
+    }
+
+    char *path = entry_path(cache_dir, input_file);
+    if (!path) {
+        return;
+    }
+    OutputFile_t entry;
+    if (output_open(&entry, path)) {
+        fprintf(entry.file, "%016llx %016llx %016llx %s\n", (unsigned long long)key,
+                (unsigned long long)record.header_hash, (unsigned long long)record.source_hash, input_file);
+        output_commit(&entry);
+    }
+    free(path);
+}
+
+/* Open a temporary file for path, returns false if it cannot be created */
+bool output_open(OutputFile_t *output, const char *path) {
+    size_t len = strlen(path) + sizeof(".tmp");
+    output->path = strdup(path);
+    output->temp_path = malloc(len);
+    output->file = NULL;
+    if (output->path && output->temp_path) {
+        snprintf(output->temp_path, len, "%s.tmp", path);
+        output->file = fopen(output->temp_path, "w");
+    }
+    if (!output->file) {
+        free(output->path);
+        free(output->temp_path);
+        output->path = NULL;
+        output->temp_path = NULL;
+        return false;
+    }
+    return true;
+}
+
+/* Check that two files hold the same bytes */
+static bool same_contents(const char *first, const char *second) {
+    InputFile_t a, b;
+    if (input_open(&a, first) != INPUT_OK) {
+        return false;
+    }
+    if (input_open(&b, second) != INPUT_OK) {
+        input_close(&a);
+        return false;
+    }
+    bool same = a.size == b.size && memcmp(a.data, b.data, a.size) == 0;
+    input_close(&a);
+    input_close(&b);
+    return same;
+}
+
+/* Close the temporary file and move it over path unless path already has the same bytes */
+bool output_commit(OutputFile_t *output) {
+    bool ok = fclose(output->file) == 0;
+    output->file = NULL;
+    if (ok && same_contents(output->temp_path, output->path)) {
+        /* Leave path (and its mtime) alone so downstream builds see no change */
+        remove(output->temp_path);
+    } else if (ok) {
+        ok = rename(output->temp_path, output->path) == 0;
+    }
+    if (!ok) {
+        remove(output->temp_path);
+    }
+    free(output->path);
+    free(output->temp_path);
+    output->path = NULL;
+    output->temp_path = NULL;
+    return ok;
+}
+
+/* Check that path holds exactly size bytes of data */
+static bool file_holds(const char *path, const char *data, size_t size) {
+    InputFile_t file;
+    if (input_open(&file, path) != INPUT_OK) {
+        return false;
+    }
+    bool same = file.size == size && memcmp(file.data, data, size) == 0;
+    input_close(&file);
+    return same;
+}
+
+/* Write data to path through a temporary file, unless path already holds the same bytes */
+bool output_write(const char *path, const char *data, size_t size) {
+    if (file_holds(path, data, size)) {
+        /* Leave path (and its mtime) alone so downstream builds see no change */
+        return true;
+    }
+    OutputFile_t output;
+    if (!output_open(&output, path)) {
+        return false;
+    }
+    if (size > 0 && fwrite(data, 1, size, output.file) != size) {
+        output_discard(&output);
+        return false;
+    }
+    bool ok = fclose(output.file) == 0;
+    output.file = NULL;
+    ok = ok && rename(output.temp_path, output.path) == 0;
+    if (!ok) {
+        remove(output.temp_path);
+    }
+    free(output.path);
+    free(output.temp_path);
+    return ok;
+}
+
+/* Close and remove the temporary file, leaving path untouched */
+void output_discard(OutputFile_t *output) {
+    if (output->file) {
+        fclose(output->file);
+        remove(output->temp_path);
+    }
+    free(output->path);
+    free(output->temp_path);
+    output->file = NULL;
+    output->path = NULL;
+    output->temp_path = NULL;
+}
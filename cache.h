@@ -0,0 +1,65 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Content-hash cache skipping unchanged inputs (cz --cache), and output
+ * files that are only replaced when their bytes change.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Default cache directory (relative to the working directory) */
+#define CACHE_DEFAULT_DIR ".czcache"
+
+/* Hash of everything the outputs of input_file depend on: the cache format and feature set, the
+ * source, the modules and headers behind its #import directives and its sibling .cz files
+ * (their contents too with minimal headers), the emit mode and the features disabled
+ * from the command line */
+uint64_t cache_input_key(const char *input_file, const char *source, size_t size, bool minimal_headers, bool compact,
+                         bool trace);
+
+/* Key and output hashes of the last transpile of one input */
+typedef struct {
+    uint64_t key;                /* cache_input_key of the input */
+    uint64_t header_hash;        /* Hash of the .cz.h as written */
+    uint64_t source_hash;        /* Hash of the .cz.c as written */
+} CacheRecord_t;
+
+/* Fill record with key and the hashes of the current outputs, returns false if one is unreadable */
+bool cache_record_outputs(CacheRecord_t *record, uint64_t key, const char *header_file, const char *source_file);
+
+/* Check that record has key and that both outputs still hash to the recorded values */
+bool cache_record_matches(const CacheRecord_t *record, uint64_t key, const char *header_file, const char *source_file);
+
+/* Check that cache_dir recorded key for input_file and that both outputs are still as written */
+bool cache_lookup(const char *cache_dir, const char *input_file, uint64_t key,
+                  const char *header_file, const char *source_file);
+
+/* Record key and the current outputs of input_file in cache_dir (best effort) */
+void cache_store(const char *cache_dir, const char *input_file, uint64_t key,
+                 const char *header_file, const char *source_file);
+
+/* Output being written to a temporary file next to its final path */
+typedef struct {
+    FILE *file;                  /* Temporary file to write to */
+    char *path;                  /* Final path */
+    char *temp_path;             /* Temporary path (path + ".tmp") */
+} OutputFile_t;
+
+/* Open a temporary file for path, returns false if it cannot be created */
+bool output_open(OutputFile_t *output, const char *path);
+
+/* Close the temporary file and move it over path unless path already has the same bytes */
+bool output_commit(OutputFile_t *output);
+
+/* Write data to path through a temporary file, unless path already holds the same bytes */
+bool output_write(const char *path, const char *data, size_t size);
+
+/* Close and remove the temporary file, leaving path untouched */
+void output_discard(OutputFile_t *output);
@@ -0,0 +1,128 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Compact emit mode (cz --compact): generated C without comments and with
+ * only the whitespace tokens and preprocessor lines need.
+ */
+
+#include "src/cz.h"
+#include "compact.h"
+#include <stdbool.h>
+#include <ctype.h>
+
+/* Check whether c can continue an identifier or a number */
+static bool is_word_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '.' || c == '$';
+}
+
+/* Check whether a space must stay between the last written character and the next one */
+static bool needs_space(char left, char right) {
+    /* Identifiers, keywords and numbers would merge, L "x" would become a wide string */
+    if (is_word_char(left) && (is_word_char(right) || right == '"' || right == '\'')) {
+        return true;
+    }
+    /* 1E +1 would become one number */
+    if ((right == '+' || right == '-') && (left == 'e' || left == 'E' || left == 'p' || left == 'P')) {
+        return true;
+    }
+    /* Operators would fuse (a - -b, a / *p, x < <y) */
+    static const char operators[] = "+-*/%<>=!&|^:#.";
+    return strchr(operators, left) && strchr(operators, right);
+}
+
+/* Compact the C text a memory sink received since start, in place: comments go, whitespace runs become
+ * one space where joining the tokens around them would change them (none otherwise), and
+ * newlines only remain around preprocessor directives */
+void compact_sink(OutputSink_t *sink, size_t start) {
+    if (start >= sink->length) {
+        return;
+    }
+    char *data = sink->data;
+    size_t end = sink->length;
+    size_t out = start;
+    size_t i = start;
+    bool line_start = true;      /* Only blanks since the last newline of the input */
+    bool directive = false;      /* Inside a preprocessor directive */
+    bool space = false;          /* Blanks or comments were skipped since the last written character */
+    bool newline = false;        /* A directive ended since the last written character */
+
+    while (i < end) {
+        char c = data[i];
+        if (c == '\n') {
+            if (directive) {
+                directive = false;
+                newline = true;
+            }
+            space = true;
+            line_start = true;
+            i++;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+            space = true;
+            i++;
+            continue;
+        }
+        if (c == '\\' && i + 1 < end && data[i + 1] == '\n') {
+            /* Line continuation: the directive goes on */
+            space = true;
+            i += 2;
+            continue;
+        }
+        if (c == '/' && i + 1 < end && data[i + 1] == '*') {
+            const char *close = NULL;
+            for (size_t j = i + 2; j + 1 < end; j++) {
+                if (data[j] == '*' && data[j + 1] == '/') {
+                    close = data + j;
+                    break;
+                }
+            }
+            i = close ? (size_t)(close - data) + 2 : end;
+            space = true;
+            continue;
+        }
+        if (c == '/' && i + 1 < end && data[i + 1] == '/') {
+            while (i < end && data[i] != '\n') i++;
+            space = true;
+            continue;
+        }
+
+        /* A significant character: separate it from what was written before */
+        bool at_output_line_start = out == start || data[out - 1] == '\n';
+        if (c == '#' && line_start) {
+            directive = true;
+            if (!at_output_line_start) data[out++] = '\n';
+        } else if (newline) {
+            if (!at_output_line_start) data[out++] = '\n';
+        } else if (space && !at_output_line_start && (directive || needs_space(data[out - 1], c))) {
+            data[out++] = ' ';
+        }
+        space = false;
+        newline = false;
+        line_start = false;
+
+        if (c == '"' || c == '\'') {
+            /* Copy the literal as is, up to its closing quote */
+            data[out++] = data[i++];
+            while (i < end && data[i] != c && data[i] != '\n') {
+                if (data[i] == '\\' && i + 1 < end) {
+                    data[out++] = data[i++];
+                }
+                data[out++] = data[i++];
+            }
+            if (i < end && data[i] == c) {
+                data[out++] = data[i++];
+            }
+            continue;
+        }
+        data[out++] = data[i++];
+    }
+
+    /* Directives and files end with a newline */
+    sink->length = out;
+    if (out > start && data[out - 1] != '\n') {
+        sink_putc(sink, '\n');
+    }
+}
@@ -0,0 +1,19 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Compact emit mode (cz --compact): generated C without comments and with
+ * only the whitespace tokens and preprocessor lines need.
+ */
+
+#pragma once
+
+#include "sink.h"
+#include <stddef.h>
+
+/* Compact the C text a memory sink received since start, in place: comments go, whitespace runs become
+ * one space where joining the tokens around them would change them (none otherwise), and
+ * newlines only remain around preprocessor directives. Line structure is not kept: __LINE__ and compiler
+ * diagnostics refer to the lines of the compacted text, not to those of the .cz source. */
+void compact_sink(OutputSink_t *sink, size_t start);
@@ -0,0 +1,161 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Make-compatible dependency files for cz -MD.
+ */
+
+#include "src/cz.h"
+#include "depfile.h"
+#include "cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+CZ_THREAD_LOCAL DependencyList_t *g_dependencies = NULL;
+
+/* FNV-1a hash of a path (never 0) */
+static uint64_t path_key(const char *path) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = path; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
+
+/* Initialize an empty dependency list */
+void dependency_list_init(DependencyList_t *list) {
+    list->entries = NULL;
+    list->count = 0;
+    list->capacity = 0;
+    hash_table_init(&list->index);
+}
+
+/* Free a dependency list */
+void dependency_list_free(DependencyList_t *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->entries[i].path);
+    }
+    free(list->entries);
+    hash_table_free(&list->index);
+    dependency_list_init(list);
+}
+
+/* Record path in g_dependencies once (no-op when recording is off) */
+void dependency_record(const char *path, DependencyKind kind) {
+    DependencyList_t *list = g_dependencies;
+    if (!list || !path || !*path) {
+        return;
+    }
+
+    uint64_t key = path_key(path);
+    size_t index = hash_table_get(&list->index, key);
+    if (index != HASH_TABLE_MISSING && strcmp(list->entries[index].path, path) == 0) {
+        if (kind == DEPENDENCY_READ) {
+            list->entries[index].kind = DEPENDENCY_READ;
+        }
+        return;
+    }
+
+    if (list->count >= list->capacity) {
+        size_t new_capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        Dependency_t *new_entries = realloc(list->entries, new_capacity * sizeof(Dependency_t));
+        if (!new_entries) {
+            return;
+        }
+        list->entries = new_entries;
+        list->capacity = new_capacity;
+    }
+
+    char *copy = strdup(path);
+    if (!copy) {
+        return;
+    }
+    /* On a hash collision the path is listed twice, which make accepts */
+    if (index == HASH_TABLE_MISSING) {
+        hash_table_put(&list->index, key, list->count);
+    }
+    list->entries[list->count].path = copy;
+    list->entries[list->count].kind = kind;
+    list->count++;
+}
+
+/* Record directory/name in g_dependencies (no-op when recording is off) */
+void dependency_record_in(const char *directory, const char *name, DependencyKind kind) {
+    if (!g_dependencies || !directory || !name) {
+        return;
+    }
+    if (strcmp(directory, ".") == 0) {
+        dependency_record(name, kind);
+        return;
+    }
+    size_t len = strlen(directory) + strlen(name) + 2;
+    char *path = malloc(len);
+    if (path) {
+        snprintf(path, len, "%s/%s", directory, name);
+        dependency_record(path, kind);
+        free(path);
+    }
+}
+
+/* Write a path escaped for make (spaces, '#' and '$') */
+static void write_escaped(FILE *output, const char *path) {
+    for (const char *p = path; *p; p++) {
+        if (*p == ' ' || *p == '#') {
+            fputc('\\', output);
+        } else if (*p == '$') {
+            fputc('$', output);
+        }
+        fputc(*p, output);
+    }
+}
+
+/* Write one rule "targets: dependencies of kind", returns the number of dependencies listed */
+static size_t write_rule(FILE *output, const DependencyList_t *list, const char *const *targets,
+                         size_t target_count, DependencyKind kind) {
+    for (size_t i = 0; i < target_count; i++) {
+        if (i > 0) fputc(' ', output);
+        write_escaped(output, targets[i]);
+    }
+    fputc(':', output);
+    size_t listed = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        if (list->entries[i].kind == kind) {
+            fputs(" \\\n  ", output);
+            write_escaped(output, list->entries[i].path);
+            listed++;
+        }
+    }
+    fputc('\n', output);
+    return listed;
+}
+
+/* Write make rules to path: "outputs: read files", "object: included files", and an
+ * empty rule per dependency so deleted files don't break the build (like cc -MP) */
+bool dependency_write(const DependencyList_t *list, const char *path, const char *const *outputs,
+                      size_t output_count, const char *object) {
+    OutputFile_t output;
+    if (!output_open(&output, path)) {
+        return false;
+    }
+
+    write_rule(output.file, list, outputs, output_count, DEPENDENCY_READ);
+    bool included = false;
+    for (size_t i = 0; i < list->count && !included; i++) {
+        included = list->entries[i].kind == DEPENDENCY_INCLUDED;
+    }
+    if (included && object) {
+        /* Sibling headers are included, not read: listing them on the outputs would make siblings circular */
+        write_rule(output.file, list, &object, 1, DEPENDENCY_INCLUDED);
+    }
+
+    /* The input comes first and is not generated, it gets no empty rule */
+    for (size_t i = 1; i < list->count; i++) {
+        fputc('\n', output.file);
+        write_escaped(output.file, list->entries[i].path);
+        fputs(":\n", output.file);
+    }
+    return output_commit(&output);
+}
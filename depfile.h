@@ -0,0 +1,54 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Make-compatible dependency files for cz -MD.
+ */
+
+#pragma once
+
+#include "hashtable.h"
+#include "worker.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/* How a transpile depends on a file */
+typedef enum {
+    DEPENDENCY_READ,             /* Read while transpiling: the outputs depend on it */
+    DEPENDENCY_INCLUDED,         /* Only #included by the outputs: their object file depends on it */
+} DependencyKind;
+
+/* One dependency */
+typedef struct {
+    char *path;                  /* File path */
+    DependencyKind kind;         /* READ wins when a file is both read and included */
+} Dependency_t;
+
+/* Files a transpile read or made its outputs include, in first-recorded order */
+typedef struct {
+    Dependency_t *entries;       /* Recorded dependencies */
+    size_t count;                /* Number of dependencies */
+    size_t capacity;             /* Capacity of entries array */
+    HashTable_t index;           /* Hash of path -> index in entries */
+} DependencyList_t;
+
+/* Dependencies being recorded, NULL when cz -MD is off */
+extern CZ_THREAD_LOCAL DependencyList_t *g_dependencies;
+
+/* Initialize an empty dependency list */
+void dependency_list_init(DependencyList_t *list);
+
+/* Free a dependency list */
+void dependency_list_free(DependencyList_t *list);
+
+/* Record path in g_dependencies once (no-op when recording is off) */
+void dependency_record(const char *path, DependencyKind kind);
+
+/* Record directory/name in g_dependencies (no-op when recording is off) */
+void dependency_record_in(const char *directory, const char *name, DependencyKind kind);
+
+/* Write make rules to path: "outputs: read files", "object: included files", and an
+ * empty rule per dependency so deleted files don't break the build (like cc -MP) */
+bool dependency_write(const DependencyList_t *list, const char *path, const char *const *outputs,
+                      size_t output_count, const char *object);
@@ -0,0 +1,155 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Sorted .cz listings of directories, read once per run and shared by every file.
+ */
+
+#include "src/cz.h"
+#include "dirlist.h"
+#include "hashtable.h"
+#include "worker.h"
+#include <stdlib.h>
+#include <dirent.h>
+
+/* Listings read in this run (guarded by worker_lock, each listing is its own allocation so it never moves) */
+static DirListing_t **listings = NULL;
+static size_t listing_count = 0;
+static size_t listing_capacity = 0;
+static HashTable_t listing_index;   /* Hash of path -> index in listings */
+
+/* Compare two names for qsort */
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+/* Free one listing */
+static void free_listing(DirListing_t *listing) {
+    for (size_t i = 0; i < listing->count; i++) {
+        free(listing->names[i]);
+    }
+    free(listing->names);
+    free(listing->path);
+    free(listing);
+}
+
+/* Read the .cz names of directory and sort them (NULL if it cannot be opened) */
+static DirListing_t *read_listing(const char *directory) {
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        return NULL;
+    }
+    DirListing_t *listing = calloc(1, sizeof(DirListing_t));
+    if (!listing || !(listing->path = strdup(directory))) {
+        free(listing);
+        closedir(dir);
+        return NULL;
+    }
+
+    size_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t name_len = strlen(entry->d_name);
+        if (name_len <= 3 || strcmp(entry->d_name + name_len - 3, ".cz") != 0) {
+            continue;
+        }
+        if (listing->count >= capacity) {
+            size_t new_capacity = capacity == 0 ? 16 : capacity * 2;
+            char **new_names = realloc(listing->names, new_capacity * sizeof(char *));
+            if (!new_names) {
+                break;
+            }
+            listing->names = new_names;
+            capacity = new_capacity;
+        }
+        char *name = strdup(entry->d_name);
+        if (!name) {
+            break;
+        }
+        listing->names[listing->count++] = name;
+    }
+    closedir(dir);
+
+    if (listing->count > 1) {
+        qsort(listing->names, listing->count, sizeof(char *), compare_names);
+    }
+    return listing;
+}
+
+/* Find the listing of directory (call under worker_lock) */
+static DirListing_t *find_listing(const char *directory, uint64_t key) {
+    size_t index = hash_table_get(&listing_index, key);
+    if (index != HASH_TABLE_MISSING && strcmp(listings[index]->path, directory) == 0) {
+        return listings[index];
+    }
+    return NULL;
+}
+
+/* Keep a listing for the rest of the run, returns false if it could not be kept (call under worker_lock) */
+static bool keep_listing(DirListing_t *listing, uint64_t key) {
+    if (hash_table_get(&listing_index, key) != HASH_TABLE_MISSING) {
+        return false; /* Hash collision, the caller owns the listing */
+    }
+    if (listing_count >= listing_capacity) {
+        size_t new_capacity = listing_capacity == 0 ? 16 : listing_capacity * 2;
+        DirListing_t **new_listings = realloc(listings, new_capacity * sizeof(DirListing_t *));
+        if (!new_listings) {
+            return false;
+        }
+        listings = new_listings;
+        listing_capacity = new_capacity;
+    }
+    if (!hash_table_put(&listing_index, key, listing_count)) {
+        return false;
+    }
+    listings[listing_count++] = listing;
+    return true;
+}
+
+/* Get the sorted .cz listing of directory, reading it the first time it is asked for in this run.
+ * Returns NULL when the directory cannot be opened. The listing stays valid until dir_listing_clear. */
+const DirListing_t *dir_listing_cz(const char *directory) {
+    if (!directory) {
+        return NULL;
+    }
+    uint64_t key = hash_key_string(directory);
+    worker_lock();
+    DirListing_t *listing = find_listing(directory, key);
+    worker_unlock();
+    if (listing) {
+        return listing;
+    }
+
+    /* Read outside the lock: another worker may read the same directory, the first one kept wins */
+    DirListing_t *read = read_listing(directory);
+    if (!read) {
+        return NULL;
+    }
+    worker_lock();
+    listing = find_listing(directory, key);
+    if (!listing && keep_listing(read, key)) {
+        listing = read;
+        read = NULL;
+    }
+    worker_unlock();
+    if (read && listing) {
+        free_listing(read);
+    }
+    /* A listing that could not be kept is leaked rather than freed under its caller */
+    return listing ? listing : read;
+}
+
+/* Forget every listing (at the end of a run, or before a --serve request so new files are seen) */
+void dir_listing_clear(void) {
+    worker_lock();
+    for (size_t i = 0; i < listing_count; i++) {
+        free_listing(listings[i]);
+    }
+    free(listings);
+    listings = NULL;
+    listing_count = 0;
+    listing_capacity = 0;
+    hash_table_free(&listing_index);
+    worker_unlock();
+}
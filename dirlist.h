@@ -0,0 +1,25 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Sorted .cz listings of directories, read once per run and shared by every file.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/* Names of the .cz files of one directory */
+typedef struct {
+    char *path;                  /* Directory path as given */
+    char **names;                /* File names (e.g., "vec2.cz"), sorted with strcmp */
+    size_t count;                /* Number of names */
+} DirListing_t;
+
+/* Get the sorted .cz listing of directory, reading it the first time it is asked for in this run.
+ * Returns NULL when the directory cannot be opened. The listing stays valid until dir_listing_clear. */
+const DirListing_t *dir_listing_cz(const char *directory);
+
+/* Forget every listing (at the end of a run, or before a --serve request so new files are seen) */
+void dir_listing_clear(void);
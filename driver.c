@@ -0,0 +1,505 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Compiler driver (cz cc): transpiles .cz inputs in memory, pipes each source
+ * into the C compiler and links the objects.
+ */
+
+#include "src/cz.h"
+#include "driver.h"
+#include "input.h"
+#include "transpile.h"
+#include "sink.h"
+#include "dirlist.h"
+#include "siblings.h"
+#include "worker.h"
+#include "src/errors.h"
+#include "src/headers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/* NULL-terminated argument vector of a command */
+typedef struct {
+    char **items;                /* Arguments, items[count] is NULL once terminated */
+    size_t count;                /* Number of arguments */
+    size_t capacity;             /* Capacity of items array */
+} ArgList_t;
+
+/* One .cz input of the driver */
+typedef struct {
+    const char *input_file;      /* Source path */
+    OutputSink_t source;         /* Transpiled source, piped into the compiler */
+    char *directory;             /* Directory of the input, searched for its quoted includes */
+    char *object;                /* Object file the compiler writes */
+    bool imports;                /* Has an #import directive: transpiled after the other inputs */
+} DriverInput_t;
+
+/* Inputs and settings of one cz cc run */
+typedef struct {
+    DriverInput_t *inputs;       /* .cz inputs in command-line order */
+    const size_t *order;         /* Input transpiled by each job of the current round */
+    SymbolTable *symbols;        /* Interner shared by a serial run (NULL for one per file) */
+} DriverRun_t;
+
+/* Append an argument (NULL terminates the list without counting) */
+static void arg_push(ArgList_t *list, const char *arg) {
+    if (list->count + 1 >= list->capacity) {
+        size_t new_capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        char **new_items = realloc(list->items, new_capacity * sizeof(char *));
+        if (!new_items) {
+            cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+            return;
+        }
+        list->items = new_items;
+        list->capacity = new_capacity;
+    }
+    list->items[list->count] = (char *)arg;
+    if (arg) {
+        list->count++;
+    }
+}
+
+/* Append every argument of other */
+static void arg_push_all(ArgList_t *list, const ArgList_t *other) {
+    for (size_t i = 0; i < other->count; i++) {
+        arg_push(list, other->items[i]);
+    }
+}
+
+/* Check whether an argument names a .cz input */
+static bool is_cz_input(const char *arg) {
+    size_t length = strlen(arg);
+    return arg[0] != '-' && length > 3 && strcmp(arg + length - 3, ".cz") == 0;
+}
+
+/* Check whether a compiler option takes its value as the next argument */
+static bool takes_value(const char *arg) {
+    static const char *const options[] = {
+        "-I", "-D", "-U", "-L", "-l", "-include", "-isystem", "-iquote", "-idirafter",
+        "-MF", "-MT", "-MQ", "-Xlinker", NULL
+    };
+    for (size_t i = 0; options[i]; i++) {
+        if (strcmp(arg, options[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Check whether a compiler option only matters when linking */
+static bool is_link_option(const char *arg) {
+    return strncmp(arg, "-l", 2) == 0 || strncmp(arg, "-L", 2) == 0 || strncmp(arg, "-Wl,", 4) == 0 ||
+           strcmp(arg, "-Xlinker") == 0 || strcmp(arg, "-static") == 0 || strcmp(arg, "-shared") == 0 ||
+           strcmp(arg, "-rdynamic") == 0;
+}
+
+/* Copy the directory part of path ("." when there is none) */
+static char *directory_of(const char *path) {
+    const char *slash = strrchr(path, '/');
+    if (!slash) {
+        return strdup(".");
+    }
+    size_t len = slash == path ? 1 : (size_t)(slash - path);
+    char *dir = malloc(len + 1);
+    if (dir) {
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+    return dir;
+}
+
+/* Check whether a .cz file has an #import directive (its transpile reads the headers of other inputs) */
+static bool has_import(const char *path) {
+    InputFile_t file;
+    if (input_open(&file, path) != INPUT_OK) {
+        return false;
+    }
+    bool found = false;
+    const char *end = file.data + file.size;
+    for (const char *line = file.data; line < end && !found; ) {
+        const char *next = memchr(line, '\n', (size_t)(end - line));
+        next = next ? next + 1 : end;
+        while (line < next && (*line == ' ' || *line == '\t')) line++;
+        found = (size_t)(next - line) >= 7 && strncmp(line, "#import", 7) == 0;
+        line = next;
+    }
+    input_close(&file);
+    return found;
+}
+
+/* Transpile one input of the run: its header to disk, its source into memory */
+static bool driver_transpile_job(size_t index, void *context) {
+    DriverRun_t *run = (DriverRun_t *)context;
+    DriverInput_t *input = &run->inputs[run->order[index]];
+    SymbolTable local_symbols;
+    SymbolTable *symbols = run->symbols;
+    if (!symbols) {
+        symbols_init(&local_symbols);
+        symbols = &local_symbols;
+    }
+
+    TranspileRequest_t request;
+    request.input_file = input->input_file;
+    request.output_base = NULL;
+    request.data = NULL;
+    request.size = 0;
+    request.record = NULL;
+    request.dependencies = false;
+    request.minimal_headers = false;
+    request.compact = false;
+    request.trace = false;
+    request.header_output = NULL;
+    request.source_output = &input->source;
+    request.stream_output = NULL;
+    bool ok = transpile(&request, symbols, NULL);
+
+    if (symbols == &local_symbols) {
+        symbols_free(&local_symbols);
+    }
+    return ok;
+}
+
+/* Start argv[0] from PATH with its stdin reading from a new pipe, whose write end goes to input_fd
+ * (-1 on failure) */
+static pid_t spawn_with_input(char **argv, int *input_fd) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    /* Compilers started later must not hold this pipe open */
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    pid_t pid;
+    int error = posix_spawnp(&pid, argv[0], &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[0]);
+    if (error != 0) {
+        close(fds[1]);
+        fprintf(stderr, "[CZ] Cannot run '%s': %s\n", argv[0], strerror(error));
+        return -1;
+    }
+    *input_fd = fds[1];
+    return pid;
+}
+
+/* Write size bytes to fd, stopping early if the reader went away (its exit status tells why) */
+static void write_all(int fd, const char *data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        size -= (size_t)written;
+    }
+}
+
+/* Check that a child exited with status 0 */
+static bool exited_ok(int status) {
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Run argv[0] from PATH and wait for it, returns false unless it exits with status 0 */
+static bool run_command(char **argv) {
+    pid_t pid;
+    int error = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
+    if (error != 0) {
+        fprintf(stderr, "[CZ] Cannot run '%s': %s\n", argv[0], strerror(error));
+        return false;
+    }
+    int status;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return exited_ok(status);
+}
+
+/* Start the compiler on the source of input, fed through a pipe, returns false if it cannot start */
+static bool start_compiler(const char *compiler, const ArgList_t *flags, DriverInput_t *input) {
+    ArgList_t args = { NULL, 0, 0 };
+    arg_push(&args, compiler);
+    arg_push_all(&args, flags);
+    /* The source is read from stdin: its own and sibling headers are next to the input */
+    arg_push(&args, "-iquote");
+    arg_push(&args, input->directory);
+    arg_push(&args, "-x");
+    arg_push(&args, "c");
+    arg_push(&args, "-c");
+    arg_push(&args, "-");
+    arg_push(&args, "-o");
+    arg_push(&args, input->object);
+    arg_push(&args, NULL);
+
+    int fd = -1;
+    pid_t pid = spawn_with_input(args.items, &fd);
+    free(args.items);
+    if (pid < 0) {
+        return false;
+    }
+    write_all(fd, input->source.data, input->source.length);
+    close(fd);
+    return true;
+}
+
+/* Compile every input, up to jobs compilers at a time; returns false if one failed */
+static bool compile_inputs(const char *compiler, const ArgList_t *flags, DriverInput_t *inputs,
+                           size_t count, unsigned jobs) {
+    bool ok = true;
+    size_t next = 0;
+    unsigned running = 0;
+    while (next < count || running > 0) {
+        if (ok && next < count && running < jobs) {
+            if (start_compiler(compiler, flags, &inputs[next])) {
+                running++;
+            } else {
+                ok = false;
+            }
+            next++;
+            continue;
+        }
+        if (running == 0) {
+            break;
+        }
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        running--;
+        if (!exited_ok(status)) {
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/* Name the object of every input: input.cz.o with -c (or output for a single input), else in temp_dir */
+static bool name_objects(DriverInput_t *inputs, size_t count, bool compile_only, const char *output,
+                         const char *temp_dir) {
+    for (size_t i = 0; i < count; i++) {
+        const char *input_file = inputs[i].input_file;
+        if (compile_only && output) {
+            inputs[i].object = strdup(output);
+        } else if (compile_only) {
+            size_t len = strlen(input_file) + sizeof(".o");
+            inputs[i].object = malloc(len);
+            if (inputs[i].object) {
+                snprintf(inputs[i].object, len, "%s.o", input_file);
+            }
+        } else {
+            const char *name = strrchr(input_file, '/');
+            name = name ? name + 1 : input_file;
+            size_t len = strlen(temp_dir) + strlen(name) + 32;
+            inputs[i].object = malloc(len);
+            if (inputs[i].object) {
+                snprintf(inputs[i].object, len, "%s/%zu-%s.o", temp_dir, i, name);
+            }
+        }
+        if (!inputs[i].object) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Run cz cc with the arguments following "cc", returns the exit status */
+int driver_cc(int argc, char **argv) {
+    const char *compiler = getenv("CC");
+    if (!compiler || !*compiler) {
+        compiler = "cc";
+    }
+
+    ArgList_t flags = { NULL, 0, 0 };       /* Compile options, also passed when linking */
+    ArgList_t link_flags = { NULL, 0, 0 };  /* Options only passed when linking */
+    ArgList_t others = { NULL, 0, 0 };      /* Inputs other than .cz files (sources, objects, libraries) */
+    const char **cz_inputs = malloc(((size_t)argc + 1) * sizeof(const char *));
+    size_t cz_count = 0;
+    const char *output = NULL;
+    bool compile_only = false;
+    unsigned jobs = 1;
+    if (!cz_inputs) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        return 1;
+    }
+
+    int status = 1;
+    for (int i = 0; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strncmp(arg, "-j", 2) == 0) {
+            const char *value = arg[2] ? arg + 2 : (i + 1 < argc ? argv[++i] : NULL);
+            if (!worker_parse_jobs(value, &jobs)) {
+                fprintf(stderr, "[CZ] Invalid job count for -j\n");
+                goto done;
+            }
+        } else if (strcmp(arg, "-c") == 0) {
+            compile_only = true;
+        } else if (strcmp(arg, "-o") == 0) {
+            if (i + 1 >= argc) {
+                fprintf(stderr, "[CZ] Missing output file for -o\n");
+                goto done;
+            }
+            output = argv[++i];
+        } else if (is_cz_input(arg)) {
+            cz_inputs[cz_count++] = arg;
+        } else if (arg[0] == '-') {
+            ArgList_t *list = is_link_option(arg) ? &link_flags : &flags;
+            arg_push(list, arg);
+            if (takes_value(arg) && i + 1 < argc) {
+                arg_push(list, argv[++i]);
+            }
+        } else {
+            arg_push(&others, arg);
+        }
+    }
+    if (cz_count == 0) {
+        fprintf(stderr, "[CZ] cz cc needs at least one .cz input\n");
+        goto done;
+    }
+    if (compile_only && output && cz_count + others.count > 1) {
+        fprintf(stderr, "[CZ] cz cc -c -o takes a single input\n");
+        goto done;
+    }
+
+    DriverInput_t *inputs = calloc(cz_count, sizeof(DriverInput_t));
+    if (!inputs) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        goto done;
+    }
+    for (size_t i = 0; i < cz_count; i++) {
+        inputs[i].input_file = cz_inputs[i];
+        sink_init(&inputs[i].source, NULL);
+        inputs[i].directory = directory_of(cz_inputs[i]);
+        if (!inputs[i].directory) {
+            cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        }
+        inputs[i].imports = has_import(cz_inputs[i]);
+    }
+
+    /* Objects that are only linked live in a private temporary directory */
+    char temp_dir[4096];
+    temp_dir[0] = '\0';
+    if (!compile_only) {
+        const char *tmp = getenv("TMPDIR");
+        snprintf(temp_dir, sizeof(temp_dir), "%s/cz-cc-XXXXXX", tmp && *tmp ? tmp : "/tmp");
+        if (!mkdtemp(temp_dir)) {
+            fprintf(stderr, "[CZ] Cannot create a temporary directory in %s\n", tmp && *tmp ? tmp : "/tmp");
+            temp_dir[0] = '\0';
+            goto cleanup;
+        }
+    }
+    if (!name_objects(inputs, cz_count, compile_only, output, temp_dir)) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        goto cleanup;
+    }
+
+    /* Transpile everything first, a source may include the header of any sibling. Importers read
+     * the headers of the modules they import, so they go in a second round after the rest. */
+    size_t *order = malloc(cz_count * sizeof(size_t));
+    if (!order) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        goto cleanup;
+    }
+    size_t plain_count = 0;
+    for (size_t i = 0; i < cz_count; i++) {
+        if (!inputs[i].imports) {
+            order[plain_count++] = i;
+        }
+    }
+    size_t importer_count = 0;
+    for (size_t i = 0; i < cz_count; i++) {
+        if (inputs[i].imports) {
+            order[plain_count + importer_count++] = i;
+        }
+    }
+
+    SymbolTable symbols;
+    symbols_init(&symbols);
+    DriverRun_t run;
+    run.inputs = inputs;
+    run.order = order;
+    run.symbols = jobs > 1 && cz_count > 1 ? NULL : &symbols;
+    bool ok = worker_run(plain_count, jobs, driver_transpile_job, &run);
+    run.order = order + plain_count;
+    ok = ok && worker_run(importer_count, jobs, driver_transpile_job, &run);
+    free(order);
+    symbols_free(&symbols);
+    transpiler_free_header_index();
+    dir_listing_clear();
+    sibling_names_clear();
+
+    /* A compiler that exits early must not kill cz while its pipe is written */
+    signal(SIGPIPE, SIG_IGN);
+    ok = ok && compile_inputs(compiler, &flags, inputs, cz_count, jobs);
+
+    if (ok && compile_only && others.count > 0) {
+        ArgList_t args = { NULL, 0, 0 };
+        arg_push(&args, compiler);
+        arg_push_all(&args, &flags);
+        arg_push(&args, "-c");
+        arg_push_all(&args, &others);
+        arg_push(&args, NULL);
+        ok = run_command(args.items);
+        free(args.items);
+    } else if (ok && !compile_only) {
+        ArgList_t args = { NULL, 0, 0 };
+        arg_push(&args, compiler);
+        arg_push_all(&args, &flags);
+        for (size_t i = 0; i < cz_count; i++) {
+            arg_push(&args, inputs[i].object);
+        }
+        arg_push_all(&args, &others);
+        arg_push_all(&args, &link_flags);
+        if (output) {
+            arg_push(&args, "-o");
+            arg_push(&args, output);
+        }
+        arg_push(&args, NULL);
+        ok = run_command(args.items);
+        free(args.items);
+    }
+    status = ok ? 0 : 1;
+
+cleanup:
+    for (size_t i = 0; i < cz_count; i++) {
+        if (temp_dir[0] && inputs[i].object) {
+            unlink(inputs[i].object);
+        }
+        sink_free(&inputs[i].source);
+        free(inputs[i].directory);
+        free(inputs[i].object);
+    }
+    if (temp_dir[0]) {
+        rmdir(temp_dir);
+    }
+    free(inputs);
+
+done:
+    free(flags.items);
+    free(link_flags.items);
+    free(others.items);
+    free(cz_inputs);
+    return status;
+}
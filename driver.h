@@ -0,0 +1,20 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Compiler driver (cz cc): transpiles .cz inputs in memory, pipes each source
+ * into the C compiler and links the objects.
+ *
+ *   cz cc [-j N] [cc flags] a.cz b.cz [other.c lib.a ...] [-c | -o app]
+ *
+ * Each .cz.h is still written next to its input (siblings and importers include
+ * it), the .cz.c never touches the disk. The compiler is $CC (default cc), run
+ * up to N at a time. With -c, input.cz gives input.cz.o; otherwise objects are
+ * temporary and linked together with the other inputs.
+ */
+
+#pragma once
+
+/* Run cz cc with the arguments following "cc", returns the exit status */
+int driver_cc(int argc, char **argv);
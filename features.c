@@ -6,6 +6,7 @@
  * Registers all CZar transpiler features with the registry.
  */
 
+#include "src/cz.h"
 #include "features.h"
 #include "src/deprecated.h"
 #include "src/validation.h"
@@ -18,6 +19,7 @@
 #include "src/unreachable.h"
 #include "src/todo.h"
 #include "src/fixme.h"
+#include "src/hints.h"
 #include "src/arguments.h"
 #include "src/mutability.h"
 #include "src/defer.h"
@@ -26,6 +28,10 @@
 #include "src/unused.h"
 #include "src/ifexpr.h"
 #include "src/foreach.h"
+#include "src/comptime.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 /* Wrapper functions to adapt existing functions to feature interface */
 
@@ -47,6 +53,10 @@ static void validate_functions(ASTNode_t *ast, const char *filename, const char
 }
 
 /* Transform wrappers */
+static void transform_comptime(ASTNode_t *ast, const char *filename, const char *source) {
+    transpiler_transform_comptime(ast, filename, source);
+}
+
 static void transform_deprecated(ASTNode_t *ast, const char *filename, const char *source) {
     (void)filename;
     (void)source;
@@ -58,13 +68,11 @@ static void transform_functions(ASTNode_t *ast, const char *filename, const char
     (void)source;
     transpiler_transform_functions(ast);
     transpiler_add_warn_unused_result(ast);
-    transpiler_add_pure(ast);
+    transpiler_infer_function_attributes(ast);
 }
 
 static void transform_structs(ASTNode_t *ast, const char *filename, const char *source) {
-    (void)filename;
-    (void)source;
-    transpiler_transform_structs(ast);
+    transpiler_transform_structs(ast, filename, source);
     transpiler_transform_struct_init(ast);
 }
 
@@ -88,19 +96,20 @@ static void transform_enums(ASTNode_t *ast, const char *filename, const char *so
     transpiler_transform_enums(ast, filename);
 }
 
-static void transform_unreachable(ASTNode_t *ast, const char *filename, const char *source) {
-    (void)source;
-    transpiler_expand_unreachable(ast, filename);
+static size_t visit_unreachable(FeatureVisit_t *visit, size_t index) {
+    return transpiler_visit_unreachable(visit->ast, index, visit->filename, &visit->rewrite);
 }
 
-static void transform_todo(ASTNode_t *ast, const char *filename, const char *source) {
-    (void)source;
-    transpiler_expand_todo(ast, filename);
+static size_t visit_todo(FeatureVisit_t *visit, size_t index) {
+    return transpiler_visit_todo(visit->ast, index, visit->filename, &visit->rewrite);
 }
 
-static void transform_fixme(ASTNode_t *ast, const char *filename, const char *source) {
-    (void)source;
-    transpiler_expand_fixme(ast, filename);
+static size_t visit_fixme(FeatureVisit_t *visit, size_t index) {
+    return transpiler_visit_fixme(visit->ast, index, visit->filename, &visit->rewrite);
+}
+
+static size_t visit_hints(FeatureVisit_t *visit, size_t index) {
+    return transpiler_visit_hints(visit->ast, index, &visit->rewrite);
 }
 
 static void transform_arguments(ASTNode_t *ast, const char *filename, const char *source) {
@@ -127,21 +136,67 @@ static void transform_foreach(ASTNode_t *ast, const char *filename, const char *
     transpiler_transform_foreach(ast, filename, source);
 }
 
-static void transform_types_and_constants(ASTNode_t *ast, const char *filename, const char *source) {
-    (void)ast;
-    (void)filename;
-    (void)source;
-    /* This is handled by transform_node in transpiler.c */
-    /* Types and constants are transformed inline */
+/* Replace _ with an unused name, CZar types and constants with their C spelling */
+static size_t visit_types_and_constants(FeatureVisit_t *visit, size_t index) {
+    Token *token = &visit->ast->children[index]->token;
+
+    /* Check if this is the special _ identifier */
+    if (strcmp(token->text, "_") == 0) {
+        /* Replace _ with unique unused variable name */
+        char *new_text = transpiler_transform_unused_identifier();
+        if (new_text) {
+            token_take_text(token, new_text);
+        } else {
+            /* If transformation fails, create a fallback name to avoid duplicate _ */
+            static CZ_THREAD_LOCAL int fallback_counter = 0;
+            char fallback[32];
+            snprintf(fallback, sizeof(fallback), "_unused_fallback_%d", fallback_counter++);
+            char *fallback_text = strdup(fallback);
+            if (fallback_text) {
+                token_take_text(token, fallback_text);
+            }
+            /* If even fallback fails, keep original _ (may cause C compilation error) */
+        }
+        return index;
+    }
+
+    /* Check if this identifier is a CZar type */
+    const char *c_type = transpiler_get_c_type(token->text);
+    if (c_type) {
+        /* Replace CZar type with C type (keeps the original text on failure) */
+        token_set_text(token, c_type);
+        return index;
+    }
+
+    /* Check if this identifier is a CZar constant */
+    const char *c_constant = transpiler_get_c_constant(token->text);
+    if (c_constant) {
+        /* Replace CZar constant with C constant (keeps the original text on failure) */
+        token_set_text(token, c_constant);
+    }
+    return index;
 }
 
 /* Emit wrappers */
-static void emit_defer_functions(FILE *output) {
+static void emit_defer_functions(OutputSink_t *output) {
     transpiler_emit_defer_functions(output);
 }
 
 /* Feature definitions */
 
+static const char *comptime_triggers[] = { "comptime", NULL };
+static Feature feature_comptime = {
+    .name = "comptime",
+    .description = "Expand comptime tables to precomputed static const arrays",
+    .enabled = true,
+    .validate = NULL,
+    .transform = transform_comptime,
+    .emit = NULL,
+    .dependencies = NULL,
+    .triggers = comptime_triggers
+};
+
+static const char *deprecated_triggers[] = { "deprecated", NULL };
 static Feature feature_deprecated = {
     .name = "deprecated",
     .description = "Transform #deprecated directives to __attribute__((deprecated))",
@@ -149,7 +204,8 @@ static Feature feature_deprecated = {
     .validate = NULL,
     .transform = transform_deprecated,
     .emit = NULL,
-    .dependencies = NULL
+    .dependencies = NULL,
+    .triggers = deprecated_triggers
 };
 
 static Feature feature_validation = {
@@ -170,10 +226,12 @@ static Feature feature_casts = {
     .validate = validate_casts,
     .transform = NULL,  /* Transform is called separately after types_constants */
     .emit = NULL,
+    .table_bytes = transpiler_cast_table_bytes,
     .dependencies = casts_deps
 };
 
 static const char *enum_deps[] = { NULL };
+static const char *enum_triggers[] = { "enum", "switch", NULL };
 static Feature feature_enums = {
     .name = "enums",
     .description = "Validate enum declarations and switch exhaustiveness",
@@ -181,7 +239,9 @@ static Feature feature_enums = {
     .validate = validate_enums,
     .transform = transform_enums,
     .emit = NULL,
-    .dependencies = enum_deps
+    .table_bytes = transpiler_enum_table_bytes,
+    .dependencies = enum_deps,
+    .triggers = enum_triggers
 };
 
 static Feature feature_functions = {
@@ -201,6 +261,7 @@ static Feature feature_structs = {
     .validate = NULL,
     .transform = transform_structs,
     .emit = NULL,
+    .table_bytes = transpiler_struct_table_bytes,
     .dependencies = NULL
 };
 
@@ -212,6 +273,7 @@ static Feature feature_methods = {
     .validate = NULL,
     .transform = transform_methods,
     .emit = NULL,
+    .table_bytes = transpiler_method_table_bytes,
     .dependencies = methods_deps
 };
 
@@ -234,37 +296,68 @@ static Feature feature_autodereference = {
     .validate = NULL,
     .transform = transform_autodereference,
     .emit = NULL,
+    .table_bytes = transpiler_autodereference_table_bytes,
     .dependencies = autodereference_deps
 };
 
+static const char *unreachable_names[] = { "UNREACHABLE", NULL };
 static Feature feature_unreachable = {
     .name = "unreachable",
     .description = "Expand unreachable() runtime function calls",
     .enabled = true,
     .validate = NULL,
-    .transform = transform_unreachable,
+    .transform = NULL,
+    .visit = visit_unreachable,
+    .visit_tokens = FEATURE_VISIT_TOKEN(TOKEN_IDENTIFIER),
+    .visit_names = unreachable_names,
     .emit = NULL,
-    .dependencies = NULL
+    .dependencies = NULL,
+    .triggers = unreachable_names
 };
 
+static const char *todo_names[] = { "TODO", NULL };
 static Feature feature_todo = {
     .name = "todo",
     .description = "Expand todo() runtime function calls",
     .enabled = true,
     .validate = NULL,
-    .transform = transform_todo,
+    .transform = NULL,
+    .visit = visit_todo,
+    .visit_tokens = FEATURE_VISIT_TOKEN(TOKEN_IDENTIFIER),
+    .visit_names = todo_names,
     .emit = NULL,
-    .dependencies = NULL
+    .dependencies = NULL,
+    .triggers = todo_names
 };
 
+static const char *fixme_names[] = { "FIXME", NULL };
 static Feature feature_fixme = {
     .name = "fixme",
     .description = "Expand fixme() runtime function calls",
     .enabled = true,
     .validate = NULL,
-    .transform = transform_fixme,
+    .transform = NULL,
+    .visit = visit_fixme,
+    .visit_tokens = FEATURE_VISIT_TOKEN(TOKEN_IDENTIFIER),
+    .visit_names = fixme_names,
     .emit = NULL,
-    .dependencies = NULL
+    .dependencies = NULL,
+    .triggers = fixme_names
+};
+
+static const char *hints_names[] = { "likely", "unlikely", "hot", "cold", NULL };
+static Feature feature_hints = {
+    .name = "hints",
+    .description = "Expand likely()/unlikely() and hot/cold qualifiers to compiler hints",
+    .enabled = true,
+    .validate = NULL,
+    .transform = NULL,
+    .visit = visit_hints,
+    .visit_tokens = FEATURE_VISIT_TOKEN(TOKEN_IDENTIFIER),
+    .visit_names = hints_names,
+    .emit = NULL,
+    .dependencies = NULL,
+    .triggers = hints_names
 };
 
 static Feature feature_arguments = {
@@ -274,6 +367,7 @@ static Feature feature_arguments = {
     .validate = NULL,
     .transform = transform_arguments,
     .emit = NULL,
+    .table_bytes = transpiler_function_table_bytes,
     .dependencies = NULL
 };
 
@@ -289,6 +383,7 @@ static Feature feature_mutability = {
 };
 
 static const char *defer_deps[] = { "mutability", NULL };
+static const char *defer_triggers[] = { "defer", NULL };
 static Feature feature_defer = {
     .name = "defer",
     .description = "Transform defer statements to cleanup attribute pattern",
@@ -296,7 +391,9 @@ static Feature feature_defer = {
     .validate = NULL,
     .transform = transform_defer,
     .emit = emit_defer_functions,
-    .dependencies = defer_deps
+    .table_bytes = transpiler_defer_table_bytes,
+    .dependencies = defer_deps,
+    .triggers = defer_triggers
 };
 
 static Feature feature_types_constants = {
@@ -304,11 +401,15 @@ static Feature feature_types_constants = {
     .description = "Transform CZar types and constants to C types and constants",
     .enabled = true,
     .validate = NULL,
-    .transform = transform_types_and_constants,
+    .transform = NULL,
+    .visit = visit_types_and_constants,
+    .visit_tokens = FEATURE_VISIT_TOKEN(TOKEN_IDENTIFIER),
+    .visit_names = NULL,
     .emit = NULL,
     .dependencies = NULL
 };
 
+static const char *ifexpr_triggers[] = { "if", NULL };
 static Feature feature_ifexpr = {
     .name = "ifexpr",
     .description = "Transform if-expressions to ternary operators",
@@ -316,9 +417,12 @@ static Feature feature_ifexpr = {
     .validate = NULL,
     .transform = transform_ifexpr,
     .emit = NULL,
-    .dependencies = NULL
+    .table_bytes = transpiler_ifexpr_table_bytes,
+    .dependencies = NULL,
+    .triggers = ifexpr_triggers
 };
 
+static const char *foreach_triggers[] = { "for", NULL };
 static Feature feature_foreach = {
     .name = "foreach",
     .description = "Transform foreach-like syntax to standard C for loops",
@@ -326,9 +430,67 @@ static Feature feature_foreach = {
     .validate = NULL,
     .transform = transform_foreach,
     .emit = NULL,
-    .dependencies = NULL
+    .dependencies = NULL,
+    .triggers = foreach_triggers
 };
 
+/* Names of the features disabled from the command line (set before any transpile starts) */
+static char disabled_names[512];
+
+/* Apply a comma-separated --disable (or --only) list to every registry, copies an unknown name to unknown */
+bool features_select(const char *names, bool only, char *unknown, size_t unknown_size) {
+    /* The enabled flags live in the shared feature definitions, so a scratch registry reaches them */
+    FeatureRegistry registry;
+    feature_registry_init(&registry);
+    register_all_features(&registry);
+
+    size_t capacity = 1;
+    for (const char *c = names; *c; c++) {
+        capacity += *c == ',';
+    }
+    Feature **selected = calloc(capacity, sizeof(Feature *));
+    size_t selected_count = 0;
+    bool ok = selected != NULL;
+    for (const char *name = names; ok && *name; ) {
+        size_t length = strcspn(name, ",");
+        Feature *feature = feature_registry_match(&registry, name, length);
+        if (!feature) {
+            snprintf(unknown, unknown_size, "%.*s", (int)length, name);
+            ok = false;
+        } else {
+            selected[selected_count++] = feature;
+        }
+        name += length + (name[length] == ',');
+    }
+
+    if (ok) {
+        for (size_t i = 0; only && i < registry.count; i++) {
+            registry.features[i]->enabled = false;
+        }
+        for (size_t i = 0; i < selected_count; i++) {
+            selected[i]->enabled = only;
+        }
+
+        size_t length = 0;
+        disabled_names[0] = '\0';
+        for (size_t i = 0; i < registry.count; i++) {
+            if (!registry.features[i]->enabled && length < sizeof(disabled_names)) {
+                length += (size_t)snprintf(disabled_names + length, sizeof(disabled_names) - length, "%s%s",
+                                           length > 0 ? "," : "", registry.features[i]->name);
+            }
+        }
+    }
+
+    free(selected);
+    feature_registry_free(&registry);
+    return ok;
+}
+
+/* Names of the features disabled from the command line, comma-separated ("" when none) */
+const char *features_disabled(void) {
+    return disabled_names;
+}
+
 /* Register all built-in features with the registry */
 void register_all_features(FeatureRegistry *registry) {
     if (!registry) {
@@ -343,6 +505,7 @@ void register_all_features(FeatureRegistry *registry) {
     feature_registry_register(registry, &feature_functions);
 
     /* Transform phase features (order matters!) */
+    feature_registry_register(registry, &feature_comptime);
     feature_registry_register(registry, &feature_deprecated);
     feature_registry_register(registry, &feature_foreach);
     feature_registry_register(registry, &feature_structs);
@@ -352,6 +515,7 @@ void register_all_features(FeatureRegistry *registry) {
     feature_registry_register(registry, &feature_unreachable);
     feature_registry_register(registry, &feature_todo);
     feature_registry_register(registry, &feature_fixme);
+    feature_registry_register(registry, &feature_hints);
     feature_registry_register(registry, &feature_arguments);
     feature_registry_register(registry, &feature_mutability);
     feature_registry_register(registry, &feature_defer);
@@ -12,3 +12,9 @@
 
 /* Register all built-in features with the registry */
 void register_all_features(FeatureRegistry *registry);
+
+/* Apply a comma-separated --disable (or --only) list to every registry, copies an unknown name to unknown */
+bool features_select(const char *names, bool only, char *unknown, size_t unknown_size);
+
+/* Names of the features disabled from the command line, comma-separated ("" when none) */
+const char *features_disabled(void);
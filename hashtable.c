@@ -0,0 +1,117 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Growable open-addressing hash table from integer keys to indices.
+ */
+
+#include "hashtable.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Initial number of slots */
+#define HASH_TABLE_INITIAL_SLOTS 64
+
+/* Mix key bits so sequential IDs and aligned pointers spread over the slots */
+static size_t hash_key(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (size_t)key;
+}
+
+/* Initialize an empty hash table */
+void hash_table_init(HashTable_t *table) {
+    table->keys = NULL;
+    table->values = NULL;
+    table->count = 0;
+    table->slot_count = 0;
+}
+
+/* Forget every key, keeping the slots for reuse */
+void hash_table_clear(HashTable_t *table) {
+    if (table->keys) {
+        memset(table->keys, 0, table->slot_count * sizeof(uint64_t));
+    }
+    table->count = 0;
+}
+
+/* Free the slots */
+void hash_table_free(HashTable_t *table) {
+    free(table->keys);
+    free(table->values);
+    hash_table_init(table);
+}
+
+/* Find the slot holding key, or the empty slot where it belongs */
+static size_t find_slot(const HashTable_t *table, uint64_t key) {
+    size_t mask = table->slot_count - 1;
+    size_t slot = hash_key(key) & mask;
+    while (table->keys[slot] != 0 && table->keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/* Rehash every key into twice as many slots */
+static int grow_slots(HashTable_t *table) {
+    size_t new_count = table->slot_count == 0 ? HASH_TABLE_INITIAL_SLOTS : table->slot_count * 2;
+    HashTable_t grown;
+    grown.keys = calloc(new_count, sizeof(uint64_t));
+    grown.values = malloc(new_count * sizeof(size_t));
+    grown.count = table->count;
+    grown.slot_count = new_count;
+    if (!grown.keys || !grown.values) {
+        free(grown.keys);
+        free(grown.values);
+        return 0;
+    }
+
+    for (size_t i = 0; i < table->slot_count; i++) {
+        if (table->keys[i] != 0) {
+            size_t slot = find_slot(&grown, table->keys[i]);
+            grown.keys[slot] = table->keys[i];
+            grown.values[slot] = table->values[i];
+        }
+    }
+
+    free(table->keys);
+    free(table->values);
+    *table = grown;
+    return 1;
+}
+
+/* Insert or replace the value of key (non-zero), returns 0 on allocation failure */
+int hash_table_put(HashTable_t *table, uint64_t key, size_t value) {
+    if (!table || key == 0) {
+        return 0;
+    }
+
+    /* Keep the load factor under one half */
+    if ((table->count + 1) * 2 > table->slot_count && !grow_slots(table)) {
+        return 0;
+    }
+
+    size_t slot = find_slot(table, key);
+    if (table->keys[slot] == 0) {
+        table->keys[slot] = key;
+        table->count++;
+    }
+    table->values[slot] = value;
+    return 1;
+}
+
+/* Get the value of key, or HASH_TABLE_MISSING */
+size_t hash_table_get(const HashTable_t *table, uint64_t key) {
+    if (!table || table->count == 0 || key == 0) {
+        return HASH_TABLE_MISSING;
+    }
+    size_t slot = find_slot(table, key);
+    return table->keys[slot] == key ? table->values[slot] : HASH_TABLE_MISSING;
+}
+
+/* Get the bytes held by the slots */
+size_t hash_table_bytes(const HashTable_t *table) {
+    return table->keys ? table->slot_count * (sizeof(uint64_t) + sizeof(size_t)) : 0;
+}
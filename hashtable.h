@@ -0,0 +1,61 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Growable open-addressing hash table from integer keys to indices.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Value returned by hash_table_get for missing keys */
+#define HASH_TABLE_MISSING ((size_t)-1)
+
+/* Hash table of non-zero 64-bit keys (symbol IDs, interned pointers, packed pairs) */
+typedef struct {
+    uint64_t *keys;             /* Slot keys, 0 marks an empty slot */
+    size_t *values;             /* Slot values */
+    size_t count;               /* Number of stored keys */
+    size_t slot_count;          /* Number of slots (power of two, 0 until first insert) */
+} HashTable_t;
+
+/* Initialize an empty hash table */
+void hash_table_init(HashTable_t *table);
+
+/* Forget every key, keeping the slots for reuse */
+void hash_table_clear(HashTable_t *table);
+
+/* Free the slots */
+void hash_table_free(HashTable_t *table);
+
+/* Insert or replace the value of key (non-zero), returns 0 on allocation failure */
+int hash_table_put(HashTable_t *table, uint64_t key, size_t value);
+
+/* Get the value of key, or HASH_TABLE_MISSING */
+size_t hash_table_get(const HashTable_t *table, uint64_t key);
+
+/* Get the bytes held by the slots */
+size_t hash_table_bytes(const HashTable_t *table);
+
+/* Pack two 32-bit IDs into one key */
+static inline uint64_t hash_key_pair(int first, int second) {
+    return ((uint64_t)(uint32_t)first << 32) | (uint64_t)(uint32_t)second;
+}
+
+/* Use a pointer (e.g., an interned name) as a key */
+static inline uint64_t hash_key_pointer(const void *pointer) {
+    return (uint64_t)(uintptr_t)pointer;
+}
+
+/* Use the FNV-1a hash of a string (e.g., a path) as a key, never 0 */
+static inline uint64_t hash_key_string(const char *text) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = text; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
@@ -0,0 +1,121 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Read-only access to source and header files (memory-mapped where available).
+ */
+
+#include "src/cz.h"
+#include "input.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define INPUT_MMAP
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/* Shared contents of every empty file */
+static const char empty_input[1] = "";
+
+/* Read path into a heap buffer with stdio */
+static InputStatus read_buffered(InputFile_t *file, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return INPUT_OPEN_FAILED;
+    }
+
+    if (fseek(f, 0, SEEK_END) != 0) {
+        fclose(f);
+        return INPUT_SIZE_FAILED;
+    }
+    long size = ftell(f);
+    if (size < 0 || fseek(f, 0, SEEK_SET) != 0) {
+        fclose(f);
+        return INPUT_SIZE_FAILED;
+    }
+
+    char *buffer = malloc((size_t)size + 1);
+    if (!buffer) {
+        fclose(f);
+        return INPUT_READ_FAILED;
+    }
+
+    /* Text mode may translate line endings, so trust the byte count read */
+    size_t bytes_read = fread(buffer, 1, (size_t)size, f);
+    buffer[bytes_read] = '\0';
+    fclose(f);
+
+    file->data = buffer;
+    file->size = bytes_read;
+    file->mapped = 0;
+    return INPUT_OK;
+}
+
+/* Open path and expose its contents without copying when possible */
+InputStatus input_open(InputFile_t *file, const char *path) {
+    file->data = empty_input;
+    file->size = 0;
+    file->mapped = 0;
+
+#ifdef INPUT_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return INPUT_OPEN_FAILED;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return INPUT_SIZE_FAILED;
+    }
+
+    /* The bytes past EOF in the last page of a mapping read as zero, so a file
+     * that does not end on a page boundary is NUL-terminated for free.
+     * Anything else (pipes, exact page multiples) goes through stdio. */
+    long page = sysconf(_SC_PAGESIZE);
+    if (S_ISREG(st.st_mode) && st.st_size > 0 && page > 0 && st.st_size % page != 0) {
+        size_t size = (size_t)st.st_size;
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) {
+            return read_buffered(file, path);
+        }
+        posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+        file->data = map;
+        file->size = size;
+        file->mapped = size;
+        return INPUT_OK;
+    }
+
+    int is_empty = S_ISREG(st.st_mode) && st.st_size == 0;
+    close(fd);
+    if (is_empty) {
+        return INPUT_OK;
+    }
+#endif
+
+    return read_buffered(file, path);
+}
+
+/* Release the contents of an input file */
+void input_close(InputFile_t *file) {
+    if (!file || !file->data) {
+        return;
+    }
+#ifdef INPUT_MMAP
+    if (file->mapped) {
+        munmap((void *)file->data, file->mapped);
+    }
+#endif
+    if (!file->mapped && file->data != empty_input) {
+        free((void *)file->data);
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+}
@@ -0,0 +1,32 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Read-only access to source and header files (memory-mapped where available).
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/* Result of opening an input file */
+typedef enum {
+    INPUT_OK,                   /* data holds the whole file */
+    INPUT_OPEN_FAILED,          /* File could not be opened */
+    INPUT_SIZE_FAILED,          /* File size could not be determined */
+    INPUT_READ_FAILED           /* File could not be mapped or read into memory */
+} InputStatus;
+
+/* Input file contents, always NUL-terminated at data[size] */
+typedef struct {
+    const char *data;           /* File contents (read-only) */
+    size_t size;                /* Number of bytes in data */
+    size_t mapped;              /* Length of the mapping, 0 when data is on the heap */
+} InputFile_t;
+
+/* Open path and expose its contents without copying when possible */
+InputStatus input_open(InputFile_t *file, const char *path);
+
+/* Release the contents of an input file */
+void input_close(InputFile_t *file);
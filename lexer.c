@@ -7,6 +7,7 @@
  */
 
 #include "lexer.h"
+#include "worker.h"
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -19,14 +20,124 @@ void lexer_init(Lexer *lexer, const char *input, size_t input_length) {
     lexer->position = 0;
     lexer->line = 1;
     lexer->column = 1;
+    lexer->symbols = NULL;
+
+    /* Every token needs at most its length plus a terminator, and there are
+     * never more tokens than input bytes, so twice the input always fits */
+    lexer->pool_size = input_length * 2 + 1;
+    lexer->pool_used = 0;
+    lexer->pool = malloc(lexer->pool_size);
+    if (!lexer->pool) {
+        /* Fall back to one allocation per token */
+        lexer->pool_size = 0;
+    }
+}
+
+/* Release lexer resources (token views become invalid) */
+void lexer_cleanup(Lexer *lexer) {
+    free(lexer->pool);
+    lexer->pool = NULL;
+    lexer->pool_size = 0;
+    lexer->pool_used = 0;
+}
+
+/* Shared text for tokens emptied by transformations */
+static char empty_text[1] = "";
+
+/* Arena backing rewritten token text (NULL to use the heap) */
+static CZ_THREAD_LOCAL Arena_t *text_arena = NULL;
+
+/* Allocate rewritten token text from arena (NULL to use the heap) */
+void token_use_arena(Arena_t *arena) {
+    text_arena = arena;
+}
+
+/* Number of rewrites that turned a token into or out of a bracket */
+static CZ_THREAD_LOCAL unsigned long bracket_generation = 0;
+
+/* Check if text is a single bracket character */
+static int is_bracket_text(const char *text) {
+    return text && text[0] != '\0' && text[1] == '\0' && strchr("()[]{}", text[0]) != NULL;
+}
+
+/* Invalidate bracket tables when a rewrite changes bracket structure */
+static void note_text_change(const Token *token, const char *text) {
+    if (is_bracket_text(token->text) || is_bracket_text(text)) {
+        bracket_generation++;
+    }
+}
+
+/* Get the bracket generation (changes whenever a bracket token is rewritten) */
+unsigned long token_bracket_generation(void) {
+    return bracket_generation;
 }
 
 /* Free token resources */
 void token_free(Token *token) {
-    if (token->text) {
+    if (token->text && !token->is_view) {
         free(token->text);
-        token->text = NULL;
     }
+    token->text = NULL;
+    token->is_view = 0;
+}
+
+/* Empty token text in place, bypassing bracket tracking (used for pending deletions) */
+void token_clear_text(Token *token) {
+    token_free(token);
+    token->text = empty_text;
+    token->length = 0;
+    token->is_view = 1;
+    token->symbol = SYM_NONE;
+}
+
+/* Replace token text with a copy of text, returns 0 on allocation failure */
+int token_set_text(Token *token, const char *text) {
+    if (!token || !text) {
+        return 0;
+    }
+    note_text_change(token, text);
+
+    /* Emptied tokens are common (deletions), so they borrow a shared string */
+    if (text[0] == '\0') {
+        token_clear_text(token);
+        return 1;
+    }
+
+    size_t length = strlen(text);
+    if (text_arena) {
+        char *copy = arena_strndup(text_arena, text, length);
+        if (!copy) {
+            return 0;
+        }
+        token_free(token);
+        token->text = copy;
+        token->length = length;
+        token->is_view = 1;
+        token->symbol = symbols_keyword(copy, length);
+        return 1;
+    }
+
+    char *copy = malloc(length + 1);
+    if (!copy) {
+        return 0;
+    }
+    memcpy(copy, text, length + 1);
+    token_take_text(token, copy);
+    return 1;
+}
+
+/* Replace token text with a heap-allocated string, taking ownership of it */
+void token_take_text(Token *token, char *text) {
+    if (!token) {
+        return;
+    }
+    note_text_change(token, text);
+    token_free(token);
+    token->text = text;
+    token->length = text ? strlen(text) : 0;
+    token->is_view = 0;
+    /* Rewritten text keeps a keyword ID so integer compares stay valid */
+    token->symbol = symbols_keyword(text, token->length);
 }
 
 /* Check if character is valid in an identifier */
@@ -68,6 +179,142 @@ static char advance(Lexer *lexer) {
     return c;
 }
 
+/* Fast-path scanning: SSE2/NEON handle 16 bytes at a time, the portable
+ * fallback one byte at a time. Define CZ_LEXER_SCALAR to force the fallback. */
+#if !defined(CZ_LEXER_SCALAR) && defined(__GNUC__) && defined(__SSE2__)
+    #define LEXER_SIMD_SSE2
+    #include <emmintrin.h>
+#elif !defined(CZ_LEXER_SCALAR) && defined(__GNUC__) && defined(__ARM_NEON)
+    #define LEXER_SIMD_NEON
+    #include <arm_neon.h>
+#endif
+
+/* Bytes per SIMD block */
+#define SCAN_BLOCK 16
+
+#if defined(LEXER_SIMD_SSE2)
+/* Bitmask of bytes equal to a, b or c in a 16-byte block */
+static unsigned block_match3(const char *p, char a, char b, char c) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(a)),
+                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8(b)));
+    hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)));
+    return (unsigned)_mm_movemask_epi8(hits);
+}
+
+/* Bitmask of whitespace bytes (' ' and '\t'..'\r') in a 16-byte block */
+static unsigned block_whitespace(const char *p) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+    __m128i ctrl = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+    __m128i is_ctrl = _mm_cmpeq_epi8(_mm_min_epu8(ctrl, _mm_set1_epi8('\r' - '\t')), ctrl);
+    __m128i is_space = _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' '));
+    return (unsigned)_mm_movemask_epi8(_mm_or_si128(is_ctrl, is_space));
+}
+#elif defined(LEXER_SIMD_NEON)
+/* Pack a NEON byte mask into a 16-bit bitmask */
+static unsigned neon_movemask(uint8x16_t mask) {
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t bits = vandq_u8(mask, vld1q_u8(weights));
+    unsigned low = vaddv_u8(vget_low_u8(bits));
+    unsigned high = vaddv_u8(vget_high_u8(bits));
+    return low | (high << 8);
+}
+
+/* Bitmask of bytes equal to a, b or c in a 16-byte block */
+static unsigned block_match3(const char *p, char a, char b, char c) {
+    uint8x16_t chunk = vld1q_u8((const uint8_t *)p);
+    uint8x16_t hits = vorrq_u8(vceqq_u8(chunk, vdupq_n_u8((uint8_t)a)),
+                               vceqq_u8(chunk, vdupq_n_u8((uint8_t)b)));
+    hits = vorrq_u8(hits, vceqq_u8(chunk, vdupq_n_u8((uint8_t)c)));
+    return neon_movemask(hits);
+}
+
+/* Bitmask of whitespace bytes (' ' and '\t'..'\r') in a 16-byte block */
+static unsigned block_whitespace(const char *p) {
+    uint8x16_t chunk = vld1q_u8((const uint8_t *)p);
+    uint8x16_t is_ctrl = vcleq_u8(vsubq_u8(chunk, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t'));
+    uint8x16_t is_space = vceqq_u8(chunk, vdupq_n_u8(' '));
+    return neon_movemask(vorrq_u8(is_ctrl, is_space));
+}
+#endif
+
+/* Check for a C locale whitespace character */
+static int is_space_byte(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/* Count bytes from position that are whitespace */
+static size_t scan_whitespace(const Lexer *lexer) {
+    const char *p = lexer->input + lexer->position;
+    size_t n = lexer->input_length - lexer->position;
+    size_t i = 0;
+#if defined(LEXER_SIMD_SSE2) || defined(LEXER_SIMD_NEON)
+    while (i + SCAN_BLOCK <= n) {
+        unsigned other = ~block_whitespace(p + i) & 0xFFFFu;
+        if (other) {
+            return i + (size_t)__builtin_ctz(other);
+        }
+        i += SCAN_BLOCK;
+    }
+#endif
+    while (i < n && is_space_byte(p[i])) {
+        i++;
+    }
+    return i;
+}
+
+/* Count bytes from position before the first a, b or c (or the end of input) */
+static size_t scan_until(const Lexer *lexer, char a, char b, char c) {
+    const char *p = lexer->input + lexer->position;
+    size_t n = lexer->input_length - lexer->position;
+    size_t i = 0;
+#if defined(LEXER_SIMD_SSE2) || defined(LEXER_SIMD_NEON)
+    while (i + SCAN_BLOCK <= n) {
+        unsigned hits = block_match3(p + i, a, b, c);
+        if (hits) {
+            return i + (size_t)__builtin_ctz(hits);
+        }
+        i += SCAN_BLOCK;
+    }
+#endif
+    while (i < n && p[i] != a && p[i] != b && p[i] != c) {
+        i++;
+    }
+    return i;
+}
+
+/* Consume count bytes at once, counting newlines in bulk for line/column */
+static void advance_span(Lexer *lexer, size_t count) {
+    const char *p = lexer->input + lexer->position;
+    size_t i = 0;
+    size_t last_newline = count; /* count means none seen */
+    int newlines = 0;
+#if defined(LEXER_SIMD_SSE2) || defined(LEXER_SIMD_NEON)
+    while (i + SCAN_BLOCK <= count) {
+        unsigned hits = block_match3(p + i, '\n', '\n', '\n');
+        if (hits) {
+            newlines += __builtin_popcount(hits);
+            last_newline = i + (size_t)(31 - __builtin_clz(hits));
+        }
+        i += SCAN_BLOCK;
+    }
+#endif
+    for (; i < count; i++) {
+        if (p[i] == '\n') {
+            newlines++;
+            last_newline = i;
+        }
+    }
+
+    lexer->position += count;
+    if (newlines > 0) {
+        lexer->line += newlines;
+        lexer->column = (int)(count - last_newline);
+    } else {
+        lexer->column += (int)count;
+    }
+}
+
 /* Create token from current position */
 static Token make_token(Lexer *lexer, TokenType type, size_t start, size_t length) {
     Token token;
@@ -75,6 +322,18 @@ static Token make_token(Lexer *lexer, TokenType type, size_t start, size_t lengt
     token.length = length;
     token.line = lexer->line;
     token.column = lexer->column;
+    token.is_view = 0;
+    token.symbol = SYM_NONE;
+
+    /* Borrow token text from the text pool when possible */
+    if (lexer->pool && lexer->pool_used + length + 1 <= lexer->pool_size) {
+        token.text = &lexer->pool[lexer->pool_used];
+        memcpy(token.text, &lexer->input[start], length);
+        token.text[length] = '\0';
+        lexer->pool_used += length + 1;
+        token.is_view = 1;
+        return token;
+    }
 
     /* Allocate and copy token text */
     token.text = malloc(length + 1);
@@ -89,45 +348,6 @@ static Token make_token(Lexer *lexer, TokenType type, size_t start, size_t lengt
     return token;
 }
 
-/* Check if a string is a C or CZar keyword */
-static int is_keyword(const char *text) {
-    if (!text) return 0;
-    
-    /* C keywords */
-    static const char *c_keywords[] = {
-        "auto", "break", "case", "char", "const", "continue", "default", "do",
-        "double", "else", "enum", "extern", "float", "for", "goto", "if",
-        "inline", "int", "long", "register", "restrict", "return", "short", "signed",
-        "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned", "void",
-        "volatile", "while", "_Alignas", "_Alignof", "_Atomic", "_Bool", "_Complex",
-        "_Generic", "_Imaginary", "_Noreturn", "_Static_assert", "_Thread_local",
-        NULL
-    };
-    
-    /* CZar keywords */
-    static const char *czar_keywords[] = {
-        "mut", "defer", "unreachable", "todo", "fixme",
-        NULL
-    };
-    
-    /* Check C keywords */
-    for (int i = 0; c_keywords[i] != NULL; i++) {
-        if (strcmp(text, c_keywords[i]) == 0) {
-            return 1;
-        }
-    }
-    
-    /* Check CZar keywords */
-    for (int i = 0; czar_keywords[i] != NULL; i++) {
-        if (strcmp(text, czar_keywords[i]) == 0) {
-            return 1;
-        }
-    }
-    
-    return 0;
-}
-
-
 /* Lex identifier or keyword */
 static Token lex_identifier(Lexer *lexer) {
     size_t start = lexer->position;
@@ -143,9 +363,14 @@ static Token lex_identifier(Lexer *lexer) {
     token.line = start_line;
     token.column = start_column;
     
-    /* Check if this identifier is actually a keyword */
-    if (token.text && is_keyword(token.text)) {
-        token.type = TOKEN_KEYWORD;
+    /* Classify keywords and intern identifiers */
+    if (token.text) {
+        token.symbol = symbols_keyword(token.text, token.length);
+        if (token.symbol != SYM_NONE) {
+            token.type = TOKEN_KEYWORD;
+        } else if (lexer->symbols) {
+            token.symbol = symbols_intern(lexer->symbols, token.text, token.length);
+        }
     }
 
     return token;
@@ -255,12 +480,7 @@ static Token lex_number(Lexer *lexer) {
             snprintf(decimal_str, sizeof(decimal_str), "%llu%s", value, suffix);
 
             /* Update token text */
-            free(token.text);
-            token.text = malloc(strlen(decimal_str) + 1);
-            if (token.text) {
-                strcpy(token.text, decimal_str);
-                token.length = strlen(token.text);
-            } else {
+            if (!token_set_text(&token, decimal_str)) {
                 /* Memory allocation failed */
                 token.length = 0;
                 token.type = TOKEN_UNKNOWN;
@@ -282,6 +502,11 @@ static Token lex_string(Lexer *lexer) {
     advance(lexer); /* opening " */
 
     while (peek(lexer) && peek(lexer) != '"') {
+        /* Skip plain characters up to the next quote or escape */
+        advance_span(lexer, scan_until(lexer, '"', '\\', '\0'));
+        if (!peek(lexer) || peek(lexer) == '"') {
+            break;
+        }
         if (peek(lexer) == '\\') {
             advance(lexer); /* escape */
             if (peek(lexer)) {
@@ -344,9 +569,8 @@ static Token lex_line_comment(Lexer *lexer) {
     advance(lexer); /* / */
     advance(lexer); /* / */
 
-    while (peek(lexer) && peek(lexer) != '\n') {
-        advance(lexer);
-    }
+    /* Stop at the newline (or a stray NUL, like the byte-wise scan) */
+    advance_span(lexer, scan_until(lexer, '\n', '\0', '\0'));
 
     size_t length = lexer->position - start;
     Token token = make_token(lexer, TOKEN_COMMENT, start, length);
@@ -366,6 +590,8 @@ static Token lex_block_comment(Lexer *lexer) {
     advance(lexer); /* * */
 
     while (peek(lexer)) {
+        /* Jump to the next candidate terminator */
+        advance_span(lexer, scan_until(lexer, '*', '\0', '\0'));
         if (peek(lexer) == '*' && peek_at(lexer, 1) == '/') {
             advance(lexer); /* * */
             advance(lexer); /* / */
@@ -468,9 +694,7 @@ static Token lex_whitespace(Lexer *lexer) {
     int start_line = lexer->line;
     int start_column = lexer->column;
 
-    while (peek(lexer) && isspace(peek(lexer))) {
-        advance(lexer);
-    }
+    advance_span(lexer, scan_whitespace(lexer));
 
     size_t length = lexer->position - start;
     Token token = make_token(lexer, TOKEN_WHITESPACE, start, length);
@@ -487,6 +711,8 @@ Token lexer_next_token(Lexer *lexer) {
         token.type = TOKEN_EOF;
         token.text = NULL;
         token.length = 0;
+        token.is_view = 0;
+        token.symbol = SYM_NONE;
         token.line = lexer->line;
         token.column = lexer->column;
         return token;
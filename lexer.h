@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include "symbols.h"
+#include "arena.h"
 #include <stddef.h>
 
 /* Token types */
@@ -29,10 +31,12 @@ typedef enum {
 /* Token structure */
 typedef struct {
     TokenType type;
-    char *text;       /* Token text (owned by token, must be freed) */
+    char *text;       /* Token text (NUL-terminated, owned by token unless is_view) */
     size_t length;    /* Length of token text */
     int line;         /* Line number (for error reporting) */
     int column;       /* Column number (for error reporting) */
+    int is_view;      /* Text borrows from the lexer pool or an arena, must not be freed */
+    int symbol;       /* Symbol ID for identifiers and keywords (SYM_NONE otherwise) */
 } Token;
 
 /* Lexer structure */
@@ -42,16 +46,38 @@ typedef struct {
     size_t position;        /* Current position in input */
     int line;               /* Current line number */
     int column;             /* Current column number */
+    char *pool;             /* Text pool backing token views (one allocation per input) */
+    size_t pool_size;       /* Capacity of the text pool */
+    size_t pool_used;       /* Bytes used in the text pool */
+    SymbolTable *symbols;   /* Interner for identifiers (NULL for keyword IDs only) */
 } Lexer;
 
 /* Initialize lexer with input string */
 void lexer_init(Lexer *lexer, const char *input, size_t input_length);
 
+/* Release lexer resources (token views become invalid) */
+void lexer_cleanup(Lexer *lexer);
+
 /* Get next token from lexer */
 Token lexer_next_token(Lexer *lexer);
 
 /* Free token resources */
 void token_free(Token *token);
 
+/* Allocate rewritten token text from arena (NULL to use the heap) */
+void token_use_arena(Arena_t *arena);
+
+/* Empty token text in place, bypassing bracket tracking (used for pending deletions) */
+void token_clear_text(Token *token);
+
+/* Replace token text with a copy of text, returns 0 on allocation failure */
+int token_set_text(Token *token, const char *text);
+
+/* Replace token text with a heap-allocated string, taking ownership of it */
+void token_take_text(Token *token, char *text);
+
+/* Get the bracket generation (changes whenever a bracket token is rewritten) */
+unsigned long token_bracket_generation(void);
+
 /* Check if character is valid in an identifier */
 int is_identifier_char(char c, int first);
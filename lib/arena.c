@@ -0,0 +1,127 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Arena implementation - Bump allocation over chained blocks
+ */
+
+#include "cz.h"
+#include <stdlib.h>
+
+/* Scratch arena of each thread */
+static CZ_THREAD_LOCAL cz_arena_t g_scratch = CZ_ARENA_INIT;
+
+/* Initialize an empty arena (block_size 0 for CZ_ARENA_BLOCK_SIZE) */
+void cz_arena_init(cz_arena_t *arena, size_t block_size) {
+    arena->head = NULL;
+    arena->spare = NULL;
+    arena->block_size = block_size;
+}
+
+/* Offset in data at which an allocation aligned to align can start, SIZE_MAX if it does not fit */
+static size_t block_fit(const cz_arena_block_t *block, size_t size, size_t align) {
+    uintptr_t start = (uintptr_t)(block->data + block->used);
+    size_t offset = block->used + (size_t)((align - (start & (align - 1))) & (align - 1));
+    if (offset > block->size || block->size - offset < size) {
+        return SIZE_MAX;
+    }
+    return offset;
+}
+
+/* Make a new current block able to hold size bytes at align, reusing the spare block if it fits */
+static cz_arena_block_t *arena_grow(cz_arena_t *arena, size_t size, size_t align) {
+    cz_arena_block_t *block = arena->spare;
+    if (block) {
+        block->used = 0;
+        if (block_fit(block, size, align) != SIZE_MAX) {
+            arena->spare = NULL;
+            block->next = arena->head;
+            arena->head = block;
+            return block;
+        }
+    }
+
+    /* Oversized requests get a block of their own */
+    size_t block_size = arena->block_size > 0 ? arena->block_size : CZ_ARENA_BLOCK_SIZE;
+    size_t needed = size + (align > _Alignof(max_align_t) ? align : 0);
+    if (needed < size || needed > SIZE_MAX - sizeof(cz_arena_block_t)) {
+        return NULL; /* Overflow */
+    }
+    if (needed > block_size) {
+        block_size = needed;
+    }
+    block = malloc(sizeof(cz_arena_block_t) + block_size);
+    if (!block) {
+        return NULL;
+    }
+    block->size = block_size;
+    block->used = 0;
+    block->next = arena->head;
+    arena->head = block;
+    return block;
+}
+
+/* Allocate uninitialized memory aligned to align (a power of two), NULL on failure */
+void *cz_arena_alloc_aligned(cz_arena_t *arena, size_t size, size_t align) {
+    if (!arena || align == 0 || (align & (align - 1)) != 0) {
+        return NULL;
+    }
+    if (size == 0) {
+        size = 1; /* Distinct pointers, like malloc(0) may give */
+    }
+
+    cz_arena_block_t *block = arena->head;
+    size_t offset = block ? block_fit(block, size, align) : SIZE_MAX;
+    if (offset == SIZE_MAX) {
+        block = arena_grow(arena, size, align);
+        if (!block) {
+            return NULL;
+        }
+        offset = block_fit(block, size, align);
+    }
+    block->used = offset + size;
+    return block->data + offset;
+}
+
+/* Allocate uninitialized memory aligned for any type, NULL on failure */
+void *cz_arena_alloc(cz_arena_t *arena, size_t size) {
+    return cz_arena_alloc_aligned(arena, size, _Alignof(max_align_t));
+}
+
+/* Current position, everything allocated after it goes away with cz_arena_reset() */
+cz_arena_mark_t cz_arena_mark(const cz_arena_t *arena) {
+    cz_arena_mark_t mark = { arena->head, arena->head ? arena->head->used : 0 };
+    return mark;
+}
+
+/* Free what was allocated since mark (a zero mark empties the arena), one block is kept for reuse */
+void cz_arena_reset(cz_arena_t *arena, cz_arena_mark_t mark) {
+    while (arena->head && arena->head != mark.block) {
+        cz_arena_block_t *block = arena->head;
+        arena->head = block->next;
+        /* Keep the largest block seen so the next request does not go back to malloc */
+        if (!arena->spare || arena->spare->size < block->size) {
+            free(arena->spare);
+            arena->spare = block;
+        } else {
+            free(block);
+        }
+    }
+    if (arena->head) {
+        arena->head->used = mark.used;
+    }
+}
+
+/* Free every block of the arena */
+void cz_arena_release(cz_arena_t *arena) {
+    cz_arena_mark_t empty = { NULL, 0 };
+    cz_arena_reset(arena, empty);
+    free(arena->spare);
+    arena->spare = NULL;
+}
+
+/* Scratch arena of the calling thread */
+cz_arena_t *cz_arena_scratch(void) {
+    return &g_scratch;
+}
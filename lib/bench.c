@@ -0,0 +1,157 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Bench implementation - Micro-benchmarks with calibration and statistics
+ */
+
+#include "cz.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(__GNUC__) && !defined(__clang__)
+volatile uintptr_t cz_bench_sink;
+#endif
+
+/* Defaults, overridden by --csv, --json, --filter=text and --samples=n */
+void cz_bench_options(int argc, char **argv, cz_bench_options_t *options) {
+    options->warmup_ns = 20000000ULL;
+    options->sample_ns = 5000000ULL;
+    options->samples = 25;
+    options->filter = NULL;
+    options->output = CZ_BENCH_TEXT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--csv") == 0) {
+            options->output = CZ_BENCH_CSV;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            options->output = CZ_BENCH_JSON;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            options->filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--samples=", 10) == 0) {
+            long samples = strtol(argv[i] + 10, NULL, 10);
+            options->samples = samples > 0 ? (size_t)samples : 1;
+        }
+    }
+}
+
+/* Time iterations runs of a benchmark */
+static unsigned long long time_run(const cz_bench_t *bench, unsigned long long iterations) {
+    unsigned long long start = cz_monotonic_clock_ns();
+    bench->fn(bench->arg, iterations);
+    return cz_monotonic_clock_ns() - start;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Warm up, calibrate and measure one benchmark, false if filtered out */
+bool cz_bench_run(const cz_bench_t *bench, const cz_bench_options_t *options, cz_bench_result_t *result) {
+    if (options->filter && !strstr(bench->name, options->filter)) {
+        return false;
+    }
+
+    /* Calibrate: grow the iterations until one run lasts about a sample */
+    unsigned long long iterations = 1;
+    unsigned long long elapsed = time_run(bench, iterations);
+    while (elapsed < options->sample_ns && iterations < (1ULL << 40)) {
+        unsigned long long factor = elapsed > 0 ? options->sample_ns / elapsed + 1 : 10;
+        iterations *= factor < 2 ? 2 : (factor > 10 ? 10 : factor);
+        elapsed = time_run(bench, iterations);
+    }
+
+    /* Warm up caches, branch predictors and clock frequency */
+    unsigned long long warmed = 0;
+    while (warmed < options->warmup_ns) {
+        warmed += time_run(bench, iterations);
+    }
+
+    size_t samples = options->samples > 0 ? options->samples : 1;
+    double *per_op = malloc(samples * sizeof(double));
+    if (!per_op) {
+        return false;
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < samples; i++) {
+        per_op[i] = (double)time_run(bench, iterations) / (double)iterations;
+        sum += per_op[i];
+    }
+    qsort(per_op, samples, sizeof(double), compare_doubles);
+
+    double mean = sum / (double)samples;
+    double variance = 0.0;
+    for (size_t i = 0; i < samples; i++) {
+        variance += (per_op[i] - mean) * (per_op[i] - mean);
+    }
+    /* Nearest rank */
+    size_t p99 = (99 * samples + 99) / 100;
+
+    result->name = bench->name;
+    result->iterations = iterations;
+    result->samples = samples;
+    result->min_ns = per_op[0];
+    result->median_ns = samples % 2 ? per_op[samples / 2] : (per_op[samples / 2 - 1] + per_op[samples / 2]) / 2.0;
+    result->p99_ns = per_op[p99 > 0 ? p99 - 1 : 0];
+    result->mean_ns = mean;
+    result->stddev_ns = samples > 1 ? sqrt(variance / (double)(samples - 1)) : 0.0;
+    free(per_op);
+    return true;
+}
+
+/* Print results on stdout */
+void cz_bench_print(const cz_bench_result_t *results, size_t count, cz_bench_output_t output) {
+    switch (output) {
+        case CZ_BENCH_TEXT:
+            printf("%-32s %10s %10s %10s %10s %12s\n", "benchmark (ns/op)", "min", "median", "p99", "stddev", "iterations");
+            for (size_t i = 0; i < count; i++) {
+                const cz_bench_result_t *r = &results[i];
+                printf("%-32s %10.2f %10.2f %10.2f %10.2f %12llu\n",
+                       r->name, r->min_ns, r->median_ns, r->p99_ns, r->stddev_ns, r->iterations);
+            }
+            break;
+        case CZ_BENCH_CSV:
+            printf("name,iterations,samples,min_ns,median_ns,p99_ns,mean_ns,stddev_ns\n");
+            for (size_t i = 0; i < count; i++) {
+                const cz_bench_result_t *r = &results[i];
+                printf("%s,%llu,%zu,%.3f,%.3f,%.3f,%.3f,%.3f\n", r->name, r->iterations, r->samples,
+                       r->min_ns, r->median_ns, r->p99_ns, r->mean_ns, r->stddev_ns);
+            }
+            break;
+        case CZ_BENCH_JSON:
+            printf("[\n");
+            for (size_t i = 0; i < count; i++) {
+                const cz_bench_result_t *r = &results[i];
+                printf("  {\"name\": \"%s\", \"iterations\": %llu, \"samples\": %zu, \"min_ns\": %.3f, "
+                       "\"median_ns\": %.3f, \"p99_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f}%s\n",
+                       r->name, r->iterations, r->samples, r->min_ns, r->median_ns, r->p99_ns,
+                       r->mean_ns, r->stddev_ns, i + 1 < count ? "," : "");
+            }
+            printf("]\n");
+            break;
+    }
+    fflush(stdout);
+}
+
+/* Run and print a suite with options from the command line, returns the exit status */
+int cz_bench_main(int argc, char **argv, const cz_bench_t *benches, size_t count) {
+    cz_bench_options_t options;
+    cz_bench_options(argc, argv, &options);
+    cz_bench_result_t *results = malloc((count > 0 ? count : 1) * sizeof(cz_bench_result_t));
+    if (!results) {
+        return 1;
+    }
+    size_t ran = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (cz_bench_run(&benches[i], &options, &results[ran])) {
+            ran++;
+        }
+    }
+    cz_bench_print(results, ran, options.output);
+    free(results);
+    return 0;
+}
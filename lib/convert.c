@@ -0,0 +1,151 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Convert implementation - Number to text conversions without stdio
+ */
+
+#include "cz.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* "00" to "99": two digits per table lookup */
+static const char cz_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* Write value in decimal to buf (at least CZ_ITOA_MAX bytes), returns the length */
+size_t cz_utoa(unsigned long long value, char *buf) {
+    char tmp[CZ_ITOA_MAX];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    while (value >= 100) {
+        unsigned pair = (unsigned)(value % 100) * 2;
+        value /= 100;
+        *--p = cz_digit_pairs[pair + 1];
+        *--p = cz_digit_pairs[pair];
+    }
+    if (value >= 10) {
+        unsigned pair = (unsigned)value * 2;
+        *--p = cz_digit_pairs[pair + 1];
+        *--p = cz_digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    size_t length = (size_t)(end - p);
+    memcpy(buf, p, length);
+    buf[length] = '\0';
+    return length;
+}
+
+/* Write value in decimal to buf (at least CZ_ITOA_MAX bytes), returns the length */
+size_t cz_itoa(long long value, char *buf) {
+    if (value < 0) {
+        buf[0] = '-';
+        /* Negate as unsigned so LLONG_MIN doesn't overflow */
+        return 1 + cz_utoa(0ULL - (unsigned long long)value, buf + 1);
+    }
+    return cz_utoa((unsigned long long)value, buf);
+}
+
+/* Write a pointer as 0x-prefixed lowercase hex to buf (at least CZ_PTOA_MAX bytes), returns the length */
+size_t cz_ptoa(const void *pointer, char *buf) {
+    static const char hex[] = "0123456789abcdef";
+    uintptr_t value = (uintptr_t)pointer;
+    char tmp[CZ_PTOA_MAX];
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    do {
+        *--p = hex[value & 0xf];
+        value >>= 4;
+    } while (value != 0);
+    *--p = 'x';
+    *--p = '0';
+    size_t length = (size_t)(end - p);
+    memcpy(buf, p, length);
+    buf[length] = '\0';
+    return length;
+}
+
+/* Powers of ten exact in a double */
+static const double cz_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+/* Largest integer below which every integer is exact in a double */
+#define CZ_DTOA_EXACT 9007199254740992.0
+
+/* Write value with the fewest digits that read back to the same double to buf
+ * (at least CZ_DTOA_MAX bytes), returns the length */
+size_t cz_dtoa(double value, char *buf) {
+    if (isnan(value)) {
+        memcpy(buf, "nan", 4);
+        return 3;
+    }
+
+    size_t length = 0;
+    if (signbit(value)) {
+        buf[length++] = '-';
+        value = -value;
+    }
+    if (isinf(value)) {
+        memcpy(buf + length, "inf", 4);
+        return length + 3;
+    }
+
+    /* Fast path: value = n / 10^k exactly with n < 2^53, the smallest such k gives the fewest digits.
+     * n / 10^k is correctly rounded (both exact), so it equals value only if the digits round-trip. */
+    for (int k = 0; k < (int)(sizeof(cz_powers_of_ten) / sizeof(cz_powers_of_ten[0])); k++) {
+        double scaled = value * cz_powers_of_ten[k];
+        if (scaled >= CZ_DTOA_EXACT) {
+            break;
+        }
+        unsigned long long n = (unsigned long long)(scaled + 0.5);
+        if ((double)n / cz_powers_of_ten[k] != value) {
+            continue;
+        }
+
+        char digits[CZ_ITOA_MAX];
+        size_t count = cz_utoa(n, digits);
+        if (k == 0) {
+            memcpy(buf + length, digits, count + 1);
+            return length + count;
+        }
+        /* Insert the decimal point k digits from the right, padding with zeros */
+        if (count <= (size_t)k) {
+            buf[length++] = '0';
+            buf[length++] = '.';
+            for (size_t z = count; z < (size_t)k; z++) {
+                buf[length++] = '0';
+            }
+            memcpy(buf + length, digits, count + 1);
+            return length + count;
+        }
+        size_t whole = count - (size_t)k;
+        memcpy(buf + length, digits, whole);
+        length += whole;
+        buf[length++] = '.';
+        memcpy(buf + length, digits + whole, (size_t)k + 1);
+        return length + (size_t)k;
+    }
+
+    /* Very large, very small or 16+ significant digits: the shortest %.Ng that round-trips */
+    for (int precision = 15; precision <= 17; precision++) {
+        int written = snprintf(buf + length, CZ_DTOA_MAX - length, "%.*g", precision, value);
+        if (precision == 17 || strtod(buf + length, NULL) == value) {
+            return length + (size_t)(written > 0 ? written : 0);
+        }
+    }
+    return length;
+}
@@ -22,18 +22,346 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/* Storage class for per-thread state */
+#ifndef CZ_THREAD_LOCAL
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define CZ_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+    #define CZ_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+    #define CZ_THREAD_LOCAL __declspec(thread)
+#else
+    #define CZ_THREAD_LOCAL
+#endif
+#endif
+
+/* Branch and code placement hints for the optimizer */
+#if defined(__GNUC__) || defined(__clang__)
+    #define CZ_LIKELY(x) __builtin_expect(!!(x), 1)
+    #define CZ_UNLIKELY(x) __builtin_expect(!!(x), 0)
+    #define CZ_COLD __attribute__((cold))
+    #define CZ_NORETURN __attribute__((noreturn))
+    #define CZ_UNREACHABLE() __builtin_unreachable()
+#elif defined(_MSC_VER)
+    #define CZ_LIKELY(x) (x)
+    #define CZ_UNLIKELY(x) (x)
+    #define CZ_COLD
+    #define CZ_NORETURN __declspec(noreturn)
+    #define CZ_UNREACHABLE() __assume(0)
+#else
+    #define CZ_LIKELY(x) (x)
+    #define CZ_UNLIKELY(x) (x)
+    #define CZ_COLD
+    #define CZ_NORETURN
+    #define CZ_UNREACHABLE() ((void)0)
+#endif
+
 /* ============================================================================
  * Assert - Runtime assertions with detailed error messages
  * ============================================================================ */
 
-/* Assert that a condition is true, abort with message if false */
+/* Assert that a condition is true, abort with message if false (always checked) */
 #define cz_assert(cond) do { \
-    if (!(cond)) { \
+    if (CZ_UNLIKELY(!(cond))) { \
         cz_assert_fail(#cond, __FILE__, __LINE__); \
     } \
 } while (0)
 
-void cz_assert_fail(const char *condition, const char *file, int line);
+/* Assert in debug builds only: with NDEBUG the condition is not evaluated */
+#ifdef NDEBUG
+    #define cz_debug_assert(cond) do { (void)sizeof(!(cond)); } while (0)
+#else
+    #define cz_debug_assert(cond) cz_assert(cond)
+#endif
+
+/* Invariant checked in debug builds, promised to the optimizer with NDEBUG
+ * (a false condition is then undefined behavior, keep it free of side effects) */
+#ifdef NDEBUG
+    #define cz_assume(cond) do { \
+        if (!(cond)) { \
+            CZ_UNREACHABLE(); \
+        } \
+    } while (0)
+#else
+    #define cz_assume(cond) cz_assert(cond)
+#endif
+
+/* Report a failed assertion and abort, kept out of the callers' hot paths */
+CZ_COLD CZ_NORETURN void cz_assert_fail(const char *condition, const char *file, int line);
+
+
+/* ============================================================================
+ * Arena - Bump allocation over chained blocks, released at once
+ * ============================================================================ */
+
+/* Block of arena memory (allocations are carved from data) */
+typedef struct cz_arena_block_s {
+    struct cz_arena_block_s *next;  /* Previously filled block */
+    size_t size;                    /* Usable bytes in data */
+    size_t used;                    /* Bytes handed out from data */
+    _Alignas(max_align_t) char data[];
+} cz_arena_block_t;
+
+/* Arena: zero-initialized (CZ_ARENA_INIT) it allocates blocks of CZ_ARENA_BLOCK_SIZE */
+typedef struct {
+    cz_arena_block_t *head;         /* Current block (NULL until the first allocation) */
+    cz_arena_block_t *spare;        /* Block kept by a reset for the next allocations */
+    size_t block_size;              /* Size of new blocks (0 for CZ_ARENA_BLOCK_SIZE) */
+} cz_arena_t;
+
+/* Position in an arena to reset to */
+typedef struct {
+    cz_arena_block_t *block;
+    size_t used;
+} cz_arena_mark_t;
+
+#define CZ_ARENA_BLOCK_SIZE (64 * 1024)
+#define CZ_ARENA_INIT { NULL, NULL, 0 }
+
+/* Initialize an empty arena (block_size 0 for CZ_ARENA_BLOCK_SIZE) */
+void cz_arena_init(cz_arena_t *arena, size_t block_size);
+
+/* Allocate uninitialized memory aligned for any type, NULL on failure */
+void *cz_arena_alloc(cz_arena_t *arena, size_t size);
+
+/* Allocate uninitialized memory aligned to align (a power of two), NULL on failure */
+void *cz_arena_alloc_aligned(cz_arena_t *arena, size_t size, size_t align);
+
+/* Typed allocations: cz_arena_new(&a, struct conn) */
+#define cz_arena_new(arena, type) ((type *)cz_arena_alloc_aligned((arena), sizeof(type), _Alignof(type)))
+#define cz_arena_array(arena, type, count) \
+    ((size_t)(count) > SIZE_MAX / sizeof(type) ? (type *)NULL \
+        : (type *)cz_arena_alloc_aligned((arena), sizeof(type) * (size_t)(count), _Alignof(type)))
+
+/* Current position, everything allocated after it goes away with cz_arena_reset() */
+cz_arena_mark_t cz_arena_mark(const cz_arena_t *arena);
+
+/* Free what was allocated since mark (a zero mark empties the arena), one block is kept for reuse */
+void cz_arena_reset(cz_arena_t *arena, cz_arena_mark_t mark);
+
+/* Free every block of the arena: in .cz code pair it with the declaration (#pragma czar defer inline)
+ *   mut cz_arena_t a = CZ_ARENA_INIT #defer { cz_arena_release(&a); };
+ * and every allocation of the scope is a pointer bump plus this one release */
+void cz_arena_release(cz_arena_t *arena);
+
+/* Scratch arena of the calling thread, for temporaries of a bounded scope:
+ *   mut cz_arena_t *scratch = cz_arena_scratch();
+ *   cz_arena_mark_t mark = cz_arena_mark(scratch) #defer { cz_arena_reset(scratch, mark); };
+ * (a thread should cz_arena_release() it before exiting) */
+cz_arena_t *cz_arena_scratch(void);
+
+
+/* ============================================================================
+ * Pool - Fixed-size blocks recycled through intrusive free lists
+ * ============================================================================ */
+
+/* Shared pool of blocks of one size (opaque, thread-safe) */
+typedef struct cz_pool_s cz_pool_t;
+
+/* Per-thread cache in front of a shared pool: owned by one thread, no locking */
+typedef struct {
+    cz_pool_t *pool;
+    void *free;                     /* Free blocks, linked through their first word */
+    size_t count;                   /* Blocks in free */
+    size_t limit;                   /* Blocks kept before half go back to the pool */
+    bool poison;                    /* Every block goes through the checked slow path */
+} cz_pool_cache_t;
+
+/* Create a pool of size-byte blocks aligned to align (0 for any type), NULL on failure;
+ * poison fills freed blocks and checks them on reuse to catch writes after free */
+cz_pool_t *cz_pool_create(size_t size, size_t align, bool poison);
+#define cz_pool_create_for(type, poison) cz_pool_create(sizeof(type), _Alignof(type), (poison))
+
+/* Free the pool and every block it handed out */
+void cz_pool_destroy(cz_pool_t *pool);
+
+/* Take or give back a block through the shared pool (locked), NULL when out of memory */
+void *cz_pool_alloc(cz_pool_t *pool);
+void cz_pool_free(cz_pool_t *pool, void *block);
+
+/* Attach a cache to a pool, refilled and drained a batch at a time */
+void cz_pool_cache_init(cz_pool_cache_t *cache, cz_pool_t *pool);
+
+/* Give every cached block back to the pool (before the owning thread exits) */
+void cz_pool_cache_flush(cz_pool_cache_t *cache);
+
+/* Slow paths of the cache: refill or drain a batch, poisoning */
+void *cz_pool_cache_alloc_slow(cz_pool_cache_t *cache);
+void cz_pool_cache_free_slow(cz_pool_cache_t *cache, void *block);
+
+/* Take a block from the cache, NULL when out of memory */
+static inline void *cz_pool_cache_alloc(cz_pool_cache_t *cache) {
+    void *block = cache->free;
+    if (block && !cache->poison) {
+        cache->free = *(void **)block;
+        cache->count--;
+        return block;
+    }
+    return cz_pool_cache_alloc_slow(cache);
+}
+
+/* Give a block (not NULL) back to the cache */
+static inline void cz_pool_cache_free(cz_pool_cache_t *cache, void *block) {
+    if (cache->count < cache->limit && !cache->poison) {
+        *(void **)block = cache->free;
+        cache->free = block;
+        cache->count++;
+        return;
+    }
+    cz_pool_cache_free_slow(cache, block);
+}
+
+/* Typed allocation: struct conn *c = cz_pool_cache_new(&cache, struct conn); */
+#define cz_pool_cache_new(cache, type) ((type *)cz_pool_cache_alloc(cache))
+
+
+/* ============================================================================
+ * Vec - Growable arrays of elements of one size
+ * ============================================================================ */
+
+/* Vector: len elements in data, room for cap (data is NULL until the first growth) */
+typedef struct {
+    void *data;
+    size_t len;
+    size_t cap;
+    size_t size;                    /* Bytes per element */
+} cz_vec_t;
+
+/* Elements a vector grows to at first */
+#define CZ_VEC_MIN_CAP 8
+
+#define CZ_VEC_INIT(type) { NULL, 0, 0, sizeof(type) }
+
+/* Initialize an empty vector of size-byte elements */
+void cz_vec_init(cz_vec_t *vec, size_t size);
+
+/* Make room for count elements in total (capacity at least doubles), false on failure */
+bool cz_vec_reserve(cz_vec_t *vec, size_t count);
+
+/* Set the length, new elements are zeroed, false on failure */
+bool cz_vec_resize(cz_vec_t *vec, size_t len);
+
+/* Give back the capacity beyond the length (all of it when empty) */
+void cz_vec_shrink(cz_vec_t *vec);
+
+/* Copy count elements at the end, false on failure */
+bool cz_vec_append(cz_vec_t *vec, const void *elements, size_t count);
+
+/* Free the elements, the vector stays usable and empty */
+void cz_vec_free(cz_vec_t *vec);
+
+/* Move the elements out without copying: the returned vector owns them, vec is left empty */
+cz_vec_t cz_vec_move(cz_vec_t *vec);
+
+/* Take the buffer out (free() it), vec is left empty */
+void *cz_vec_take(cz_vec_t *vec);
+
+/* Slot for one more element at the end (uninitialized), NULL on failure */
+static inline void *cz_vec_push(cz_vec_t *vec) {
+    if (vec->len == vec->cap && !cz_vec_reserve(vec, vec->len + 1)) {
+        return NULL;
+    }
+    return (char *)vec->data + vec->len++ * vec->size;
+}
+
+/* Drop the last element (the vector is not empty) */
+static inline void cz_vec_pop(cz_vec_t *vec) {
+    vec->len--;
+}
+
+/* Empty the vector, keeping its capacity */
+static inline void cz_vec_clear(cz_vec_t *vec) {
+    vec->len = 0;
+}
+
+/* Typed access: cz_vec_push_value(&v, int, 42); int *ints = cz_vec_data(&v, int);
+ * in .cz code foreach walks the elements: for (_, int x : v) { ... } */
+#define cz_vec_push_value(vec, type, value) cz_vec_append((vec), &(type){ (value) }, 1)
+#define cz_vec_data(vec, type) ((type *)(vec)->data)
+#define cz_vec_at(vec, type, index) (((type *)(vec)->data)[index])
+
+
+/* ============================================================================
+ * Map - Open-addressing hash maps probed a group of slots at a time
+ * ============================================================================ */
+
+/* Kind of keys of a map */
+typedef enum {
+    CZ_MAP_INT,                     /* 64-bit integers */
+    CZ_MAP_STRING                   /* NUL-terminated strings, copied into the map */
+} cz_map_keys_t;
+
+/* Key and value, kept in insertion order */
+typedef struct {
+    union {
+        uint64_t integer;
+        const char *string;
+    } key;
+    size_t length;                  /* Bytes of a string key */
+    uint64_t hash;                  /* Hash of the key (never 0), 0 once removed */
+    void *value;
+} cz_map_entry_t;
+
+/* Map: control bytes (7 bits of hash per slot) matched 8 at a time, each slot indexes the dense entries */
+typedef struct {
+    uint8_t *ctrl;                  /* Per slot: empty, removed, or the top 7 bits of the hash */
+    uint32_t *slots;                /* Per slot: index in entries */
+    size_t slot_count;              /* Power of two (0 before the first insert) */
+    size_t used;                    /* Slots not empty, removed ones included */
+    size_t count;                   /* Live entries */
+    cz_vec_t entries;               /* cz_map_entry_t, removed ones stay until the next rehash */
+    cz_arena_t keys;                /* Copies of the string keys */
+    cz_map_keys_t kind;
+} cz_map_t;
+
+/* Initialize an empty map of kind keys */
+void cz_map_init(cz_map_t *map, cz_map_keys_t kind);
+
+/* Make room for count entries in total without rehashing, false on failure */
+bool cz_map_reserve(cz_map_t *map, size_t count);
+
+/* Insert or replace the value of a key, false on failure */
+bool cz_map_put_int(cz_map_t *map, uint64_t key, void *value);
+bool cz_map_put_string(cz_map_t *map, const char *key, void *value);
+
+/* Value slot of a key (valid until the next insertion), NULL when missing */
+void **cz_map_get_int(const cz_map_t *map, uint64_t key);
+void **cz_map_get_string(const cz_map_t *map, const char *key);
+
+/* Remove a key, false when missing (a string key's copy is freed with the map) */
+bool cz_map_remove_int(cz_map_t *map, uint64_t key);
+bool cz_map_remove_string(cz_map_t *map, const char *key);
+
+/* Next live entry in insertion order from *cursor (start at 0), NULL at the end; the order survives rehashes:
+ *   size_t cursor = 0;
+ *   for (cz_map_entry_t *e; (e = cz_map_next(&map, &cursor)) != NULL;) { ... } */
+cz_map_entry_t *cz_map_next(const cz_map_t *map, size_t *cursor);
+
+/* Remove every entry, keeping the storage */
+void cz_map_clear(cz_map_t *map);
+
+/* Free the storage, the map stays usable and empty */
+void cz_map_free(cz_map_t *map);
+
+
+/* ============================================================================
+ * Convert - Number to text conversions without stdio
+ * ============================================================================ */
+
+/* Buffer sizes (with the NUL) for any value of each conversion */
+#define CZ_ITOA_MAX 21
+#define CZ_PTOA_MAX 19
+#define CZ_DTOA_MAX 32
+
+/* Write value in decimal to buf, returns the length */
+size_t cz_itoa(long long value, char *buf);
+size_t cz_utoa(unsigned long long value, char *buf);
+
+/* Write a pointer as 0x-prefixed lowercase hex to buf, returns the length */
+size_t cz_ptoa(const void *pointer, char *buf);
+
+/* Write value with the fewest digits that read back to the same double to buf, returns the length */
+size_t cz_dtoa(double value, char *buf);
 
 
 /* ============================================================================
@@ -66,9 +394,42 @@ typedef struct {
     } v;
 } cz_any_t;
 
-/* Internal format implementation */
+/* Segment of a compiled template: literal bytes, or a placeholder when text is NULL */
+typedef struct {
+    const char *text;
+    size_t length;
+} cz_format_segment_t;
+
+/* Compiled template: parsed once, applied any number of times (immutable, shareable across threads) */
+typedef struct {
+    const cz_format_segment_t *segments;
+    size_t count;
+} cz_format_template_t;
+
+/* Static templates need no parsing at all:
+ * static const cz_format_segment_t hello_segments[] = { CZ_FORMAT_TEXT("Hello, "), CZ_FORMAT_SLOT };
+ * static const cz_format_template_t hello = CZ_FORMAT_TEMPLATE(hello_segments); */
+#define CZ_FORMAT_TEXT(literal) { (literal), sizeof(literal) - 1 }
+#define CZ_FORMAT_SLOT { NULL, 0 }
+#define CZ_FORMAT_TEMPLATE(segments) { (segments), sizeof(segments) / sizeof((segments)[0]) }
+
+/* Parse fmt once into a template owning a copy of its text (cz_format_template_free() it), NULL on failure */
+cz_format_template_t* cz_format_compile(const char *fmt);
+
+/* Free a template from cz_format_compile() */
+void cz_format_template_free(cz_format_template_t *tpl);
+
+/* Internal format implementation, returns a new string (free() it) */
 char* cz_format_impl(const char *fmt, int argc, cz_any_t *argv);
 
+/* Internal format implementation into caller storage: writes at most cap bytes, NUL-terminated
+ * when cap > 0, and returns the full length (the output was truncated if it is >= cap) */
+size_t cz_format_to_impl(char *buf, size_t cap, const char *fmt, int argc, cz_any_t *argv);
+
+/* Internal template implementations, like cz_format_impl() and cz_format_to_impl() */
+char* cz_format_apply_impl(const cz_format_template_t *tpl, int argc, cz_any_t *argv);
+size_t cz_format_apply_to_impl(char *buf, size_t cap, const cz_format_template_t *tpl, int argc, cz_any_t *argv);
+
 /* Helper constructors for any_t */
 static inline cz_any_t cz_any_int(int val) {
     cz_any_t a; a.type = CZ_ANY_INT; a.v.i = val; return a;
@@ -112,43 +473,144 @@ static inline cz_any_t cz_any_ptr(const void *val) {
     default: cz_any_ptr \
 )(x)
 
-/* Format macro implementations for different argument counts */
-#define cz_format_1(fmt) cz_format_impl(fmt, 0, NULL)
-#define cz_format_2(fmt, a1) ({ \
+/* Format macro implementations for different argument counts: call(fmt, argc, argv) */
+#define CZ_FORMAT_CALL_1(call, fmt) call(fmt, 0, NULL)
+#define CZ_FORMAT_CALL_2(call, fmt, a1) ({ \
     cz_any_t _args[] = {CZ_TO_ANY(a1)}; \
-    cz_format_impl(fmt, 1, _args); \
+    call(fmt, 1, _args); \
 })
-#define cz_format_3(fmt, a1, a2) ({ \
+#define CZ_FORMAT_CALL_3(call, fmt, a1, a2) ({ \
     cz_any_t _args[] = {CZ_TO_ANY(a1), CZ_TO_ANY(a2)}; \
-    cz_format_impl(fmt, 2, _args); \
+    call(fmt, 2, _args); \
 })
-#define cz_format_4(fmt, a1, a2, a3) ({ \
+#define CZ_FORMAT_CALL_4(call, fmt, a1, a2, a3) ({ \
     cz_any_t _args[] = {CZ_TO_ANY(a1), CZ_TO_ANY(a2), CZ_TO_ANY(a3)}; \
-    cz_format_impl(fmt, 3, _args); \
+    call(fmt, 3, _args); \
 })
-#define cz_format_5(fmt, a1, a2, a3, a4) ({ \
+#define CZ_FORMAT_CALL_5(call, fmt, a1, a2, a3, a4) ({ \
     cz_any_t _args[] = {CZ_TO_ANY(a1), CZ_TO_ANY(a2), CZ_TO_ANY(a3), CZ_TO_ANY(a4)}; \
-    cz_format_impl(fmt, 4, _args); \
+    call(fmt, 4, _args); \
 })
-#define cz_format_6(fmt, a1, a2, a3, a4, a5) ({ \
+#define CZ_FORMAT_CALL_6(call, fmt, a1, a2, a3, a4, a5) ({ \
     cz_any_t _args[] = {CZ_TO_ANY(a1), CZ_TO_ANY(a2), CZ_TO_ANY(a3), CZ_TO_ANY(a4), CZ_TO_ANY(a5)}; \
-    cz_format_impl(fmt, 5, _args); \
+    call(fmt, 5, _args); \
 })
-#define cz_format_7(fmt, a1, a2, a3, a4, a5, a6) ({ \
+#define CZ_FORMAT_CALL_7(call, fmt, a1, a2, a3, a4, a5, a6) ({ \
     cz_any_t _args[] = {CZ_TO_ANY(a1), CZ_TO_ANY(a2), CZ_TO_ANY(a3), CZ_TO_ANY(a4), CZ_TO_ANY(a5), CZ_TO_ANY(a6)}; \
-    cz_format_impl(fmt, 6, _args); \
+    call(fmt, 6, _args); \
 })
-#define cz_format_8(fmt, a1, a2, a3, a4, a5, a6, a7) ({ \
+#define CZ_FORMAT_CALL_8(call, fmt, a1, a2, a3, a4, a5, a6, a7) ({ \
     cz_any_t _args[] = {CZ_TO_ANY(a1), CZ_TO_ANY(a2), CZ_TO_ANY(a3), CZ_TO_ANY(a4), CZ_TO_ANY(a5), CZ_TO_ANY(a6), CZ_TO_ANY(a7)}; \
-    cz_format_impl(fmt, 7, _args); \
+    call(fmt, 7, _args); \
 })
+#define CZ_FORMAT_TO_CALL(fmt, argc, argv) cz_format_to_impl(_cz_buf, _cz_cap, fmt, argc, argv)
+#define CZ_FORMAT_LEN_CALL(fmt, argc, argv) cz_format_to_impl(NULL, 0, fmt, argc, argv)
+#define CZ_FORMAT_APPLY_TO_CALL(tpl, argc, argv) cz_format_apply_to_impl(_cz_buf, _cz_cap, tpl, argc, argv)
 
 /* Argument counting and dispatch */
 #define CZ_ARG_COUNT(...) CZ_ARG_COUNT_IMPL(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1)
 #define CZ_ARG_COUNT_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
 #define CZ_CONCAT(a, b) CZ_CONCAT_IMPL(a, b)
 #define CZ_CONCAT_IMPL(a, b) a##b
-#define cz_format(...) CZ_CONCAT(cz_format_, CZ_ARG_COUNT(__VA_ARGS__))(__VA_ARGS__)
+#define CZ_FORMAT_DISPATCH(call, ...) CZ_CONCAT(CZ_FORMAT_CALL_, CZ_ARG_COUNT(__VA_ARGS__))(call, __VA_ARGS__)
+
+/* Format into a new string sized exactly (free() it) */
+#define cz_format(...) CZ_FORMAT_DISPATCH(cz_format_impl, __VA_ARGS__)
+
+/* Format into caller storage without allocating, returns the full length (truncated if >= cap) */
+#define cz_format_to(buf, cap, ...) ({ \
+    char *_cz_buf = (buf); \
+    size_t _cz_cap = (cap); \
+    CZ_FORMAT_DISPATCH(CZ_FORMAT_TO_CALL, __VA_ARGS__); \
+})
+
+/* Length of a format without writing it (add 1 for the NUL of a cz_format_to buffer) */
+#define cz_format_len(...) CZ_FORMAT_DISPATCH(CZ_FORMAT_LEN_CALL, __VA_ARGS__)
+
+/* Apply a compiled template (pointer) like cz_format() and cz_format_to() */
+#define cz_format_apply(...) CZ_FORMAT_DISPATCH(cz_format_apply_impl, __VA_ARGS__)
+#define cz_format_apply_to(buf, cap, ...) ({ \
+    char *_cz_buf = (buf); \
+    size_t _cz_cap = (cap); \
+    CZ_FORMAT_DISPATCH(CZ_FORMAT_APPLY_TO_CALL, __VA_ARGS__); \
+})
+
+
+/* ============================================================================
+ * Strbuf - String builder with inline storage for short texts
+ * ============================================================================ */
+
+/* Bytes stored inline (with the NUL) before a builder moves to the heap */
+#define CZ_STRBUF_SMALL 64
+
+/* Builder: zero-initialized (CZ_STRBUF_INIT) it is empty, the text is always NUL-terminated
+ * (it may be copied by value: nothing points into the struct itself) */
+typedef struct {
+    char *heap;                     /* Heap storage once the text outgrew small (NULL before) */
+    size_t len;                     /* Bytes of text, without the NUL */
+    size_t cap;                     /* Bytes of heap */
+    char small[CZ_STRBUF_SMALL];    /* Inline storage */
+} cz_strbuf_t;
+
+#define CZ_STRBUF_INIT { NULL, 0, 0, { 0 } }
+
+/* Initialize an empty builder */
+void cz_strbuf_init(cz_strbuf_t *sb);
+
+/* Make room for extra more bytes (capacity at least doubles), false on failure */
+bool cz_strbuf_reserve(cz_strbuf_t *sb, size_t extra);
+
+/* Append n bytes, false on failure (the text is unchanged) */
+bool cz_strbuf_append(cz_strbuf_t *sb, const char *data, size_t n);
+
+/* Free the heap storage, the builder stays usable and empty */
+void cz_strbuf_free(cz_strbuf_t *sb);
+
+/* Take the text out as a heap string (free() it), NULL on failure; the builder is left empty */
+char *cz_strbuf_take(cz_strbuf_t *sb);
+
+/* Internal formatted append, like cz_format_to_impl() */
+bool cz_strbuf_appendf_impl(cz_strbuf_t *sb, const char *fmt, int argc, cz_any_t *argv);
+
+/* The text (valid until the next change) */
+static inline const char *cz_strbuf_str(const cz_strbuf_t *sb) {
+    return sb->heap ? sb->heap : sb->small;
+}
+
+/* Empty the builder, keeping its storage for the next text */
+static inline void cz_strbuf_reset(cz_strbuf_t *sb) {
+    sb->len = 0;
+    (sb->heap ? sb->heap : sb->small)[0] = '\0';
+}
+
+/* Append a NUL-terminated string, false on failure */
+static inline bool cz_strbuf_puts(cz_strbuf_t *sb, const char *text) {
+    size_t n = 0;
+    while (text[n]) {
+        n++;
+    }
+    return cz_strbuf_append(sb, text, n);
+}
+
+/* Append one character, false on failure */
+static inline bool cz_strbuf_putc(cz_strbuf_t *sb, char c) {
+    char *data = sb->heap ? sb->heap : sb->small;
+    size_t cap = sb->heap ? sb->cap : CZ_STRBUF_SMALL;
+    if (cap - sb->len < 2) {
+        return cz_strbuf_append(sb, &c, 1);
+    }
+    data[sb->len++] = c;
+    data[sb->len] = '\0';
+    return true;
+}
+
+/* Append a format (same placeholders as cz_format()), false on failure:
+ * cz_strbuf_appendf(&sb, "{} = {}\n", name, value); */
+#define CZ_STRBUF_APPENDF_CALL(fmt, argc, argv) cz_strbuf_appendf_impl(_cz_sb, fmt, argc, argv)
+#define cz_strbuf_appendf(sb, ...) ({ \
+    cz_strbuf_t *_cz_sb = (sb); \
+    CZ_FORMAT_DISPATCH(CZ_STRBUF_APPENDF_CALL, __VA_ARGS__); \
+})
 
 
 /* ============================================================================
@@ -168,11 +630,56 @@ void cz_log_set_level(cz_log_level_t level);
 /* Log a message at the specified level */
 void cz_log(cz_log_level_t level, const char *message);
 
+/* What a full ring does with a new message in async mode */
+typedef enum {
+    CZ_LOG_OVERFLOW_DROP,   /* Drop it silently (cz_log_dropped() still counts it) */
+    CZ_LOG_OVERFLOW_BLOCK,  /* Wait for the writer thread to free a slot */
+    CZ_LOG_OVERFLOW_COUNT   /* Drop it and have the writer log how many were dropped */
+} cz_log_overflow_t;
+
+/* Bytes of message kept per async record (longer messages are truncated) */
+#define CZ_LOG_RECORD_TEXT 240
+
+/* Log from a background thread: cz_log() only copies into a ring of capacity records
+ * (rounded up to a power of two), stopped at exit; false if it could not start */
+bool cz_log_async_start(size_t capacity, cz_log_overflow_t overflow);
+
+/* Write what is queued, stop the background thread and log synchronously again */
+void cz_log_async_stop(void);
+
+/* Wait until every message logged before the call is written and flushed */
+void cz_log_flush(void);
+
+/* Number of messages dropped because the async ring was full */
+unsigned long long cz_log_dropped(void);
+
+/* Levels below this are compiled out of the macros (define it before including cz.h, e.g. -DCZ_LOG_MIN_LEVEL=CZ_LOG_WARN);
+ * their arguments are then not evaluated */
+#ifndef CZ_LOG_MIN_LEVEL
+#define CZ_LOG_MIN_LEVEL CZ_LOG_DEBUG
+#endif
+
+/* Whether a message at this level would be emitted at runtime */
+bool cz_log_enabled(cz_log_level_t level);
+
 /* Convenience macros */
-#define cz_log_debug(msg) cz_log(CZ_LOG_DEBUG, msg)
-#define cz_log_info(msg) cz_log(CZ_LOG_INFO, msg)
-#define cz_log_warn(msg) cz_log(CZ_LOG_WARN, msg)
-#define cz_log_error(msg) cz_log(CZ_LOG_ERROR, msg)
+#define cz_log_debug(msg) (CZ_LOG_MIN_LEVEL <= CZ_LOG_DEBUG ? cz_log(CZ_LOG_DEBUG, msg) : (void)0)
+#define cz_log_info(msg) (CZ_LOG_MIN_LEVEL <= CZ_LOG_INFO ? cz_log(CZ_LOG_INFO, msg) : (void)0)
+#define cz_log_warn(msg) (CZ_LOG_MIN_LEVEL <= CZ_LOG_WARN ? cz_log(CZ_LOG_WARN, msg) : (void)0)
+#define cz_log_error(msg) (CZ_LOG_MIN_LEVEL <= CZ_LOG_ERROR ? cz_log(CZ_LOG_ERROR, msg) : (void)0)
+
+/* Format then log, see cz_logf() */
+void cz_logf_impl(cz_log_level_t level, const char *fmt, int argc, cz_any_t *argv);
+
+/* Log a cz_format() template: the arguments are only evaluated and formatted when the level is enabled
+ * cz_logf(CZ_LOG_INFO, "{} requests in {} ms", count, elapsed); */
+#define CZ_LOGF_CALL(fmt, argc, argv) cz_logf_impl(_cz_level, fmt, argc, argv)
+#define cz_logf(level, ...) do { \
+    cz_log_level_t _cz_level = (level); \
+    if ((int)_cz_level >= (int)(CZ_LOG_MIN_LEVEL) && cz_log_enabled(_cz_level)) { \
+        CZ_FORMAT_DISPATCH(CZ_LOGF_CALL, __VA_ARGS__); \
+    } \
+} while (0)
 
 
 /* ============================================================================
@@ -185,5 +692,249 @@ unsigned long long cz_monotonic_clock_ns(void);
 /* Get nanoseconds since program start */
 unsigned long long cz_monotonic_timer_ns(void);
 
+/* Cheaper clocks with tick granularity (a few ms), for timestamps rather than measurements */
+unsigned long long cz_monotonic_coarse_ns(void);
+unsigned long long cz_monotonic_coarse_timer_ns(void);
+
+/* Read the CPU cycle counter (rdtsc, cntvct_el0, or the monotonic clock elsewhere),
+ * only differences are meaningful: convert them with cz_cycles_to_ns() */
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+static inline unsigned long long cz_cycles(void) {
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    return __builtin_ia32_rdtsc();
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif defined(__aarch64__) && defined(__GNUC__)
+    unsigned long long value;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return cz_monotonic_clock_ns();
+#endif
+}
+
+/* Convert a difference of cz_cycles() to nanoseconds (the first call calibrates, up to 1ms after start) */
+unsigned long long cz_cycles_to_ns(unsigned long long cycles);
+
 /* Sleep for specified nanoseconds */
 void cz_nanosleep(unsigned long long nanoseconds);
+
+
+/* ============================================================================
+ * Bench - Micro-benchmarks with calibration and statistics
+ * ============================================================================ */
+
+/* Keep a value (and memory) observable so the computation producing it is not optimized away */
+#if defined(__GNUC__) || defined(__clang__)
+#define cz_do_not_optimize(x) do { \
+    __typeof__(x) _cz_value = (x); \
+    __asm__ volatile("" : : "r,m"(_cz_value) : "memory"); \
+} while (0)
+#define cz_clobber_memory() __asm__ volatile("" : : : "memory")
+#else
+extern volatile uintptr_t cz_bench_sink;
+#define cz_do_not_optimize(x) (cz_bench_sink += (uintptr_t)(x))
+#define cz_clobber_memory() ((void)0)
+#endif
+
+/* Body of a benchmark: runs the measured operation iterations times */
+typedef void (*cz_bench_fn_t)(void *arg, unsigned long long iterations);
+
+/* Named benchmark */
+typedef struct {
+    const char *name;
+    cz_bench_fn_t fn;
+    void *arg;
+} cz_bench_t;
+
+typedef enum {
+    CZ_BENCH_TEXT,
+    CZ_BENCH_CSV,
+    CZ_BENCH_JSON
+} cz_bench_output_t;
+
+/* How benchmarks are run and reported (cz_bench_options() fills the defaults) */
+typedef struct {
+    unsigned long long warmup_ns;   /* Time spent running before measuring */
+    unsigned long long sample_ns;   /* Target duration of one sample, sets the iterations */
+    size_t samples;                 /* Samples measured per benchmark */
+    const char *filter;             /* Only benchmarks whose name contains it (NULL for all) */
+    cz_bench_output_t output;
+} cz_bench_options_t;
+
+/* Nanoseconds per operation over the samples of one benchmark */
+typedef struct {
+    const char *name;
+    unsigned long long iterations;  /* Per sample */
+    size_t samples;
+    double min_ns;
+    double median_ns;
+    double p99_ns;
+    double mean_ns;
+    double stddev_ns;
+} cz_bench_result_t;
+
+/* Defaults, overridden by --csv, --json, --filter=text and --samples=n */
+void cz_bench_options(int argc, char **argv, cz_bench_options_t *options);
+
+/* Warm up, calibrate and measure one benchmark, false if filtered out */
+bool cz_bench_run(const cz_bench_t *bench, const cz_bench_options_t *options, cz_bench_result_t *result);
+
+/* Print results on stdout */
+void cz_bench_print(const cz_bench_result_t *results, size_t count, cz_bench_output_t output);
+
+/* Run and print a suite with options from the command line, returns the exit status */
+int cz_bench_main(int argc, char **argv, const cz_bench_t *benches, size_t count);
+
+
+/* ============================================================================
+ * Trace - Per-thread timing zones exported as Chrome trace JSON
+ * ============================================================================ */
+
+/* Events kept per thread, later ones are counted as dropped */
+#define CZ_TRACE_EVENTS (64 * 1024)
+
+/* Start or stop recording (starts at startup when CZ_TRACE=path is set, written there at exit) */
+void cz_trace_enable(bool enabled);
+
+/* Open a zone named by a string that outlives the trace (a literal), close the innermost one */
+void cz_trace_begin(const char *name);
+void cz_trace_end(void);
+
+/* Scoped zones, closed at scope exit:
+ *   void *zone = cz_trace_zone("parse") #defer { cz_trace_end_zone(&zone); };   (.cz)
+ *   CZ_TRACE_SCOPE("parse");                                                    (GNU C) */
+void *cz_trace_zone(const char *name);
+void cz_trace_end_zone(void **zone);
+#if defined(__GNUC__) || defined(__clang__)
+#define CZ_TRACE_SCOPE(name) \
+    __attribute__((cleanup(cz_trace_end_zone))) void *CZ_CONCAT(_cz_trace_zone_, __LINE__) = cz_trace_zone(name)
+#endif
+
+/* Write every thread's events as Chrome/Perfetto trace JSON (chrome://tracing, ui.perfetto.dev) */
+bool cz_trace_write(const char *path);
+
+/* Events dropped because a thread's buffer was full */
+unsigned long long cz_trace_dropped(void);
+
+
+/* ============================================================================
+ * Threads - Work-stealing thread pools, task groups and parallel loops
+ * ============================================================================ */
+
+/* Thread pool: one deque per worker, idle workers steal from the others (opaque) */
+typedef struct cz_threadpool_s cz_threadpool_t;
+
+/* Task body and parallel loop body (called on a sub-range [begin, end)) */
+typedef void (*cz_task_fn)(void *ctx);
+typedef void (*cz_range_fn)(size_t begin, size_t end, void *ctx);
+
+/* Tasks spawned together and waited for at once */
+typedef struct {
+    cz_threadpool_t *pool;
+    _Atomic size_t pending;         /* Tasks spawned and not finished */
+} cz_task_group_t;
+
+/* Start a pool of workers threads (0 for one less than the hardware threads), NULL on failure */
+cz_threadpool_t *cz_threadpool_create(size_t workers);
+
+/* Stop and join the workers (every group must have been waited for) */
+void cz_threadpool_destroy(cz_threadpool_t *pool);
+
+/* Shared pool started on first use and stopped at exit, NULL on failure */
+cz_threadpool_t *cz_threadpool_default(void);
+
+/* Number of worker threads of a pool */
+size_t cz_threadpool_workers(const cz_threadpool_t *pool);
+
+/* Attach a group to a pool (NULL for the default pool) */
+void cz_task_group_init(cz_task_group_t *group, cz_threadpool_t *pool);
+
+/* Queue fn(ctx) in the group: on the spawning worker's deque, or on the pool's shared queue
+ * from other threads (a full deque runs the task right away) */
+void cz_task_spawn(cz_task_group_t *group, cz_task_fn fn, void *ctx);
+
+/* Run queued tasks until every task of the group is finished */
+void cz_task_group_wait(cz_task_group_t *group);
+
+/* Call fn on sub-ranges of [begin, end) of at most grain indexes (0 to pick one) in parallel,
+ * split in halves on demand so idle workers steal the largest ones, and return once done */
+void cz_parallel_for(size_t begin, size_t end, size_t grain, cz_range_fn fn, void *ctx);
+void cz_parallel_for_in(cz_threadpool_t *pool, size_t begin, size_t end, size_t grain, cz_range_fn fn, void *ctx);
+
+
+/* ============================================================================
+ * Queue - Bounded lock-free queues of fixed-size elements
+ * ============================================================================ */
+
+/* Ring for one producer thread and one consumer thread (opaque) */
+typedef struct cz_spsc_s cz_spsc_t;
+
+/* Ring for any number of producer and consumer threads, a sequence number per slot (opaque) */
+typedef struct cz_mpmc_s cz_mpmc_t;
+
+/* Create a queue of capacity (rounded up to a power of two) elements of size bytes, NULL on failure */
+cz_spsc_t *cz_spsc_create(size_t capacity, size_t size);
+cz_mpmc_t *cz_mpmc_create(size_t capacity, size_t size);
+#define cz_spsc_create_for(capacity, type) cz_spsc_create((capacity), sizeof(type))
+#define cz_mpmc_create_for(capacity, type) cz_mpmc_create((capacity), sizeof(type))
+
+/* Free a queue (and the elements still in it) */
+void cz_spsc_destroy(cz_spsc_t *queue);
+void cz_mpmc_destroy(cz_mpmc_t *queue);
+
+/* Copy one element in or out, false when full or empty */
+bool cz_spsc_push(cz_spsc_t *queue, const void *item);
+bool cz_spsc_pop(cz_spsc_t *queue, void *item);
+bool cz_mpmc_push(cz_mpmc_t *queue, const void *item);
+bool cz_mpmc_pop(cz_mpmc_t *queue, void *item);
+
+/* Copy up to count consecutive elements in or out at once, returns how many */
+size_t cz_spsc_push_n(cz_spsc_t *queue, const void *items, size_t count);
+size_t cz_spsc_pop_n(cz_spsc_t *queue, void *items, size_t count);
+size_t cz_mpmc_push_n(cz_mpmc_t *queue, const void *items, size_t count);
+size_t cz_mpmc_pop_n(cz_mpmc_t *queue, void *items, size_t count);
+
+/* Elements in the queue (a snapshot while other threads use it) */
+size_t cz_spsc_count(const cz_spsc_t *queue);
+size_t cz_mpmc_count(const cz_mpmc_t *queue);
+
+
+/* ============================================================================
+ * File - Memory-mapped files and zero-copy line views
+ * ============================================================================ */
+
+/* Read-only contents of a file (not NUL-terminated, use size) */
+typedef struct {
+    const char *data;
+    size_t size;
+    size_t mapped;                  /* Length of the mapping, 0 when data is on the heap */
+} cz_file_t;
+
+/* Map path read-only with a sequential access hint, or read it into a buffer where it
+ * cannot be mapped (pipes, empty files); false when it cannot be opened or read */
+bool cz_mmap_file(cz_file_t *file, const char *path);
+
+/* Unmap or free the contents of a file */
+void cz_munmap_file(cz_file_t *file);
+
+/* Cursor over the lines of a text */
+typedef struct {
+    const char *next;
+    const char *end;
+} cz_lines_t;
+
+/* Iterate the lines of size bytes at data */
+static inline cz_lines_t cz_lines(const char *data, size_t size) {
+    cz_lines_t lines = { data, data + size };
+    return lines;
+}
+
+/* Next line as a view into the text without its "\n" or "\r\n" (the last one may lack it),
+ * false after the last line:
+ *   cz_lines_t lines = cz_lines(file.data, file.size);
+ *   size_t length;
+ *   for (const char *line; cz_lines_next(&lines, &line, &length);) { ... } */
+bool cz_lines_next(cz_lines_t *lines, const char **line, size_t *length);
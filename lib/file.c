@@ -0,0 +1,152 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * File implementation - Memory-mapped files and zero-copy line views
+ */
+
+#include "cz.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CZ_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Contents of every empty file */
+static const char empty_file[1] = "";
+
+/* Read what path holds into a heap buffer, growing it (the size of pipes is unknown) */
+static bool read_buffered(cz_file_t *file, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    size_t cap = 64 * 1024;
+    size_t size = 0;
+    char *buffer = malloc(cap);
+    while (buffer) {
+        size += fread(buffer + size, 1, cap - size, f);
+        if (size < cap) {
+            break;
+        }
+        char *grown = cap <= SIZE_MAX / 2 ? realloc(buffer, cap * 2) : NULL;
+        if (!grown) {
+            free(buffer);
+            buffer = NULL;
+            break;
+        }
+        buffer = grown;
+        cap *= 2;
+    }
+    bool failed = !buffer || ferror(f);
+    fclose(f);
+    if (failed) {
+        free(buffer);
+        return false;
+    }
+    if (size == 0) {
+        free(buffer);
+        return true;
+    }
+    file->data = buffer;
+    file->size = size;
+    return true;
+}
+
+/* Map path read-only with a sequential access hint, or read it into a buffer */
+bool cz_mmap_file(cz_file_t *file, const char *path) {
+    file->data = empty_file;
+    file->size = 0;
+    file->mapped = 0;
+
+#ifdef CZ_PLATFORM_WINDOWS
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (GetFileType(handle) == FILE_TYPE_DISK && GetFileSizeEx(handle, &size) &&
+        size.QuadPart > 0 && (unsigned long long)size.QuadPart <= SIZE_MAX) {
+        HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+        void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        if (view) {
+            CloseHandle(handle);
+            file->data = view;
+            file->size = (size_t)size.QuadPart;
+            file->mapped = file->size;
+            return true;
+        }
+    }
+    CloseHandle(handle);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        (unsigned long long)st.st_size <= SIZE_MAX) {
+        size_t size = (size_t)st.st_size;
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            close(fd);
+            posix_madvise(map, size, POSIX_MADV_SEQUENTIAL);
+            file->data = map;
+            file->size = size;
+            file->mapped = size;
+            return true;
+        }
+    }
+    close(fd);
+#endif
+
+    return read_buffered(file, path);
+}
+
+/* Unmap or free the contents of a file */
+void cz_munmap_file(cz_file_t *file) {
+    if (!file || !file->data) {
+        return;
+    }
+    if (file->mapped) {
+#ifdef CZ_PLATFORM_WINDOWS
+        UnmapViewOfFile((void *)file->data);
+#else
+        munmap((void *)file->data, file->mapped);
+#endif
+    } else if (file->data != empty_file) {
+        free((void *)file->data);
+    }
+    file->data = NULL;
+    file->size = 0;
+    file->mapped = 0;
+}
+
+/* Next line as a view into the text without its "\n" or "\r\n", false after the last line */
+bool cz_lines_next(cz_lines_t *lines, const char **line, size_t *length) {
+    const char *start = lines->next;
+    if (start >= lines->end) {
+        return false;
+    }
+    const char *newline = memchr(start, '\n', (size_t)(lines->end - start));
+    const char *stop = newline ? newline : lines->end;
+    lines->next = newline ? newline + 1 : lines->end;
+    if (stop > start && stop[-1] == '\r') {
+        stop--;
+    }
+    *line = start;
+    *length = (size_t)(stop - start);
+    return true;
+}
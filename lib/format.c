@@ -9,116 +9,191 @@
 #include "cz.h"
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 
-/* Internal format implementation */
+/* Output of one format: writes what fits in cap, counts everything */
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t length;
+} cz_format_writer_t;
+
+/* Append n bytes, keeping room for the terminating NUL */
+static void writer_put(cz_format_writer_t *w, const char *bytes, size_t n) {
+    if (w->length + 1 < w->cap) {
+        size_t room = w->cap - 1 - w->length;
+        memcpy(w->buf + w->length, bytes, n < room ? n : room);
+    }
+    w->length += n;
+}
+
+/* Append the text of one argument */
+static void writer_put_any(cz_format_writer_t *w, const cz_any_t *arg) {
+    char tmp[CZ_DTOA_MAX];
+    size_t n = 0;
+    switch (arg->type) {
+        case CZ_ANY_INT:
+        case CZ_ANY_LONG:
+            n = cz_itoa(arg->v.i, tmp);
+            break;
+        case CZ_ANY_UINT:
+        case CZ_ANY_ULONG:
+        case CZ_ANY_SIZE:
+            n = cz_utoa(arg->v.u, tmp);
+            break;
+        case CZ_ANY_DOUBLE:
+            n = cz_dtoa(arg->v.d, tmp);
+            break;
+        case CZ_ANY_CHAR:
+            writer_put(w, &arg->v.c, 1);
+            return;
+        case CZ_ANY_CSTR:
+            if (arg->v.s) {
+                writer_put(w, arg->v.s, strlen(arg->v.s));
+            }
+            return;
+        case CZ_ANY_PTR:
+            n = cz_ptoa(arg->v.p, tmp);
+            break;
+    }
+    writer_put(w, tmp, n);
+}
+
+/* Read the next segment of the template at *p: a literal run or a placeholder (NULL text), false at the end */
+static bool next_segment(const char **p, cz_format_segment_t *segment) {
+    const char *s = *p;
+    if (!*s) {
+        return false;
+    }
+
+    if (s[0] == '{' && s[1] == '}') {
+        /* {} placeholder */
+        segment->text = NULL;
+        segment->length = 0;
+        *p = s + 2;
+        return true;
+    }
+    if (s[0] == '{' && s[1] == '{') {
+        /* {{name}} placeholder, the name is only documentation (unterminated: the template ends) */
+        const char *close = strstr(s + 2, "}}");
+        if (!close) {
+            return false;
+        }
+        segment->text = NULL;
+        segment->length = 0;
+        *p = close + 2;
+        return true;
+    }
+
+    /* Literal run up to the next placeholder (a lone '{' is literal) */
+    const char *end = s + 1;
+    while ((end = strchr(end, '{')) != NULL && end[1] != '}' && end[1] != '{') {
+        end++;
+    }
+    if (!end) {
+        end = s + strlen(s);
+    }
+    segment->text = s;
+    segment->length = (size_t)(end - s);
+    *p = end;
+    return true;
+}
+
+/* Write one segment, consuming an argument for a placeholder */
+static void writer_put_segment(cz_format_writer_t *w, const cz_format_segment_t *segment,
+                               int argc, cz_any_t *argv, int *arg_idx) {
+    if (segment->text) {
+        writer_put(w, segment->text, segment->length);
+    } else if (*arg_idx < argc) {
+        writer_put_any(w, &argv[(*arg_idx)++]);
+    }
+}
+
+/* NUL-terminate the output and return its full length */
+static size_t writer_finish(cz_format_writer_t *w) {
+    if (w->cap > 0) {
+        w->buf[w->length < w->cap ? w->length : w->cap - 1] = '\0';
+    }
+    return w->length;
+}
+
+/* Format into buf (at most cap bytes, NUL-terminated when cap > 0), returns the full length */
+size_t cz_format_to_impl(char *buf, size_t cap, const char *fmt, int argc, cz_any_t *argv) {
+    cz_format_writer_t w = { buf, buf ? cap : 0, 0 };
+    int arg_idx = 0;
+    const char *p = fmt ? fmt : "";
+    cz_format_segment_t segment;
+    while (next_segment(&p, &segment)) {
+        writer_put_segment(&w, &segment, argc, argv, &arg_idx);
+    }
+    return writer_finish(&w);
+}
+
+/* Format into a new string sized exactly (free() it), sizing pass first */
 char* cz_format_impl(const char *fmt, int argc, cz_any_t *argv) {
-    if (!fmt) {
+    size_t length = cz_format_to_impl(NULL, 0, fmt, argc, argv);
+    char *result = malloc(length + 1);
+    if (!result) {
         char *empty = (char*)malloc(1);
         if (empty) empty[0] = '\0';
         return empty;
     }
+    cz_format_to_impl(result, length + 1, fmt, argc, argv);
+    return result;
+}
+
+/* Parse fmt once into a template owning a copy of its text (cz_format_template_free() it), NULL on failure */
+cz_format_template_t* cz_format_compile(const char *fmt) {
+    const char *p = fmt ? fmt : "";
+    size_t count = 0;
+    cz_format_segment_t segment;
+    while (next_segment(&p, &segment)) {
+        count++;
+    }
+
+    /* One block: the template, its segments, then the text they point into */
+    size_t text_length = strlen(fmt ? fmt : "");
+    cz_format_template_t *tpl = malloc(sizeof(cz_format_template_t) + count * sizeof(cz_format_segment_t) + text_length + 1);
+    if (!tpl) {
+        return NULL;
+    }
+    cz_format_segment_t *segments = (cz_format_segment_t *)(tpl + 1);
+    char *text = (char *)(segments + count);
+    memcpy(text, fmt ? fmt : "", text_length + 1);
+
+    const char *q = text;
+    size_t filled = 0;
+    while (filled < count && next_segment(&q, &segments[filled])) {
+        filled++;
+    }
+    tpl->segments = segments;
+    tpl->count = count;
+    return tpl;
+}
 
-    /* Estimate buffer size */
-    size_t estimated_size = strlen(fmt) + argc * 64 + 1;
-    char *result = malloc(estimated_size);
+/* Free a template from cz_format_compile() */
+void cz_format_template_free(cz_format_template_t *tpl) {
+    free(tpl);
+}
+
+/* Apply a template into buf (at most cap bytes, NUL-terminated when cap > 0), returns the full length */
+size_t cz_format_apply_to_impl(char *buf, size_t cap, const cz_format_template_t *tpl, int argc, cz_any_t *argv) {
+    cz_format_writer_t w = { buf, buf ? cap : 0, 0 };
+    int arg_idx = 0;
+    for (size_t i = 0; tpl && i < tpl->count; i++) {
+        writer_put_segment(&w, &tpl->segments[i], argc, argv, &arg_idx);
+    }
+    return writer_finish(&w);
+}
+
+/* Apply a template into a new string sized exactly (free() it) */
+char* cz_format_apply_impl(const cz_format_template_t *tpl, int argc, cz_any_t *argv) {
+    size_t length = cz_format_apply_to_impl(NULL, 0, tpl, argc, argv);
+    char *result = malloc(length + 1);
     if (!result) {
         char *empty = (char*)malloc(1);
         if (empty) empty[0] = '\0';
         return empty;
     }
-
-    char *out = result;
-    int arg_idx = 0;
-    const char *p = fmt;
-
-    while (*p) {
-        if (*p == '{' && *(p+1) == '}') {
-            /* Handle {} placeholder */
-            if (arg_idx < argc) {
-                cz_any_t arg = argv[arg_idx++];
-                switch (arg.type) {
-                    case CZ_ANY_INT:
-                        out += sprintf(out, "%ld", arg.v.i);
-                        break;
-                    case CZ_ANY_UINT:
-                        out += sprintf(out, "%lu", arg.v.u);
-                        break;
-                    case CZ_ANY_LONG:
-                        out += sprintf(out, "%ld", arg.v.i);
-                        break;
-                    case CZ_ANY_ULONG:
-                        out += sprintf(out, "%lu", arg.v.u);
-                        break;
-                    case CZ_ANY_SIZE:
-                        out += sprintf(out, "%zu", (size_t)arg.v.u);
-                        break;
-                    case CZ_ANY_DOUBLE:
-                        out += sprintf(out, "%g", arg.v.d);
-                        break;
-                    case CZ_ANY_CHAR:
-                        *out++ = arg.v.c;
-                        break;
-                    case CZ_ANY_CSTR:
-                        if (arg.v.s) {
-                            strcpy(out, arg.v.s);
-                            out += strlen(arg.v.s);
-                        }
-                        break;
-                    case CZ_ANY_PTR:
-                        out += sprintf(out, "%p", arg.v.p);
-                        break;
-                }
-            }
-            p += 2;
-        } else if (*p == '{' && *(p+1) == '{') {
-            /* Handle {{name}} placeholder */
-            p += 2;
-            /* Skip the name part */
-            while (*p && !(*p == '}' && *(p+1) == '}')) p++;
-            if (*p == '}' && *(p+1) == '}') {
-                /* Use next argument */
-                if (arg_idx < argc) {
-                    cz_any_t arg = argv[arg_idx++];
-                    switch (arg.type) {
-                        case CZ_ANY_INT:
-                            out += sprintf(out, "%ld", arg.v.i);
-                            break;
-                        case CZ_ANY_UINT:
-                            out += sprintf(out, "%lu", arg.v.u);
-                            break;
-                        case CZ_ANY_LONG:
-                            out += sprintf(out, "%ld", arg.v.i);
-                            break;
-                        case CZ_ANY_ULONG:
-                            out += sprintf(out, "%lu", arg.v.u);
-                            break;
-                        case CZ_ANY_SIZE:
-                            out += sprintf(out, "%zu", (size_t)arg.v.u);
-                            break;
-                        case CZ_ANY_DOUBLE:
-                            out += sprintf(out, "%g", arg.v.d);
-                            break;
-                        case CZ_ANY_CHAR:
-                            *out++ = arg.v.c;
-                            break;
-                        case CZ_ANY_CSTR:
-                            if (arg.v.s) {
-                                strcpy(out, arg.v.s);
-                                out += strlen(arg.v.s);
-                            }
-                            break;
-                        case CZ_ANY_PTR:
-                            out += sprintf(out, "%p", arg.v.p);
-                            break;
-                    }
-                }
-                p += 2;
-            }
-        } else {
-            *out++ = *p++;
-        }
-    }
-    *out = '\0';
+    cz_format_apply_to_impl(result, length + 1, tpl, argc, argv);
     return result;
 }
@@ -9,9 +9,16 @@
 #include "cz.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef CZ_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 /* Global log level setting */
 static cz_log_level_t g_log_level = CZ_LOG_DEBUG;
 
@@ -20,42 +27,337 @@ void cz_log_set_level(cz_log_level_t level) {
     g_log_level = level;
 }
 
-/* Log a message at the specified level */
-void cz_log(cz_log_level_t level, const char *message) {
-    if (level < g_log_level) {
-        return; /* Suppress messages below threshold */
+/* Whether a message at this level would be emitted */
+bool cz_log_enabled(cz_log_level_t level) {
+    return level >= g_log_level;
+}
+
+/* Name and stream of a level */
+static const char *level_name(cz_log_level_t level, FILE **out) {
+    *out = level == CZ_LOG_ERROR ? stderr : stdout;
+    switch (level) {
+        case CZ_LOG_DEBUG: return "DEBUG";
+        case CZ_LOG_INFO: return "INFO";
+        case CZ_LOG_WARN: return "WARN";
+        case CZ_LOG_ERROR: return "ERROR";
+        default: return "UNKNOWN";
     }
+}
+
+/* ----------------------------------------------------------------------------
+ * Async mode: producers claim fixed-size records in a bounded MPSC ring (each slot
+ * carries a sequence number), one background thread formats them in batches.
+ * ---------------------------------------------------------------------------- */
 
-    const char *level_str;
+/* One message waiting in the ring */
+typedef struct {
+    atomic_size_t sequence;              /* Position it is free for, or position + 1 once written */
+    cz_log_level_t level;
+    unsigned long long elapsed_ns;
+    size_t length;
+    char text[CZ_LOG_RECORD_TEXT];
+} cz_log_record_t;
+
+/* Ring shared by producers and the writer thread */
+typedef struct {
+    cz_log_record_t *records;
+    size_t mask;                         /* Capacity - 1 (capacity is a power of two) */
+    cz_log_overflow_t overflow;
+    _Alignas(64) atomic_size_t head;     /* Next position producers claim */
+    _Alignas(64) atomic_size_t written;  /* Positions written out and flushed */
+    atomic_ullong dropped;               /* Messages dropped since the start */
+    atomic_ullong reported;              /* Drops already reported (CZ_LOG_OVERFLOW_COUNT) */
+    atomic_bool stopping;
+    atomic_size_t producers;             /* Producers inside log_async, the writer outlives them */
+#ifdef CZ_PLATFORM_WINDOWS
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+} cz_log_ring_t;
+
+static cz_log_ring_t g_ring;
+static atomic_bool g_async = false;
+
+/* Bytes gathered per stream before a write */
+#define CZ_LOG_BATCH 65536
+
+/* Pending output of one stream */
+typedef struct {
     FILE *out;
+    size_t length;
+    char data[CZ_LOG_BATCH];
+} cz_log_batch_t;
 
-    switch (level) {
-        case CZ_LOG_DEBUG:
-            level_str = "DEBUG";
-            out = stdout;
-            break;
-        case CZ_LOG_INFO:
-            level_str = "INFO";
-            out = stdout;
-            break;
-        case CZ_LOG_WARN:
-            level_str = "WARN";
-            out = stdout;
-            break;
-        case CZ_LOG_ERROR:
-            level_str = "ERROR";
-            out = stderr;
+/* Write a batch out with one call */
+static void batch_flush(cz_log_batch_t *batch) {
+    if (batch->length > 0) {
+        fwrite(batch->data, 1, batch->length, batch->out);
+        batch->length = 0;
+    }
+    fflush(batch->out);
+}
+
+/* Append one formatted line to a batch, writing it out first if full */
+static void batch_line(cz_log_batch_t *batch, const char *level_str, unsigned long long elapsed_ns,
+                       const char *text, size_t length) {
+    char line[CZ_LOG_RECORD_TEXT + 64];
+    int n = snprintf(line, sizeof(line), "[CZAR] %.2fs %s %.*s\n",
+                     elapsed_ns / 1000000000.0, level_str, (int)length, text);
+    if (n <= 0) {
+        return;
+    }
+    size_t size = (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1;
+    if (batch->length + size > sizeof(batch->data)) {
+        fwrite(batch->data, 1, batch->length, batch->out);
+        batch->length = 0;
+    }
+    memcpy(batch->data + batch->length, line, size);
+    batch->length += size;
+}
+
+/* Write out everything producers finished, returns the number of records consumed */
+static size_t drain(size_t *tail, cz_log_batch_t *out, cz_log_batch_t *err) {
+    size_t consumed = 0;
+    for (;;) {
+        cz_log_record_t *record = &g_ring.records[*tail & g_ring.mask];
+        if (atomic_load_explicit(&record->sequence, memory_order_acquire) != *tail + 1) {
             break;
-        default:
-            level_str = "UNKNOWN";
-            out = stdout;
+        }
+        FILE *stream = NULL;
+        const char *level_str = level_name(record->level, &stream);
+        batch_line(stream == stderr ? err : out, level_str, record->elapsed_ns, record->text, record->length);
+        /* Hand the slot back for the next lap */
+        atomic_store_explicit(&record->sequence, *tail + g_ring.mask + 1, memory_order_release);
+        (*tail)++;
+        consumed++;
+    }
+
+    unsigned long long dropped = atomic_load(&g_ring.dropped);
+    unsigned long long reported = atomic_load(&g_ring.reported);
+    if (g_ring.overflow == CZ_LOG_OVERFLOW_COUNT && dropped > reported) {
+        char text[64];
+        int n = snprintf(text, sizeof(text), "%llu messages dropped (log ring full)", dropped - reported);
+        batch_line(err, "WARN", cz_monotonic_coarse_timer_ns(), text, (size_t)(n > 0 ? n : 0));
+        atomic_store(&g_ring.reported, dropped);
+    }
+
+    if (consumed > 0) {
+        batch_flush(out);
+        batch_flush(err);
+        atomic_store_explicit(&g_ring.written, *tail, memory_order_release);
+    }
+    return consumed;
+}
+
+/* Writer thread: drain, and sleep a little when idle */
+#ifdef CZ_PLATFORM_WINDOWS
+static DWORD WINAPI writer_main(LPVOID unused) {
+#else
+static void *writer_main(void *unused) {
+#endif
+    (void)unused;
+    static cz_log_batch_t out;
+    static cz_log_batch_t err;
+    out.out = stdout;
+    err.out = stderr;
+    size_t tail = atomic_load(&g_ring.written);
+
+    unsigned long long idle_ns = 1000;
+    for (;;) {
+        /* Producers arriving after this see g_async cleared and log synchronously */
+        bool stopping = atomic_load(&g_ring.stopping) && atomic_load(&g_ring.producers) == 0;
+        if (drain(&tail, &out, &err) > 0) {
+            idle_ns = 1000;
+            continue;
+        }
+        if (stopping && tail == atomic_load(&g_ring.head)) {
             break;
+        }
+        cz_nanosleep(idle_ns);
+        idle_ns = idle_ns < 1000000 ? idle_ns * 2 : idle_ns;
+    }
+    return 0;
+}
+
+/* Claim a slot at the head, NULL if the ring is full */
+static cz_log_record_t *claim(size_t *position) {
+    size_t pos = atomic_load_explicit(&g_ring.head, memory_order_relaxed);
+    for (;;) {
+        cz_log_record_t *record = &g_ring.records[pos & g_ring.mask];
+        size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&g_ring.head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *position = pos;
+                return record;
+            }
+        } else if (diff < 0) {
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&g_ring.head, memory_order_relaxed);
+        }
     }
+}
+
+/* Queue a message for the writer thread, returns false once stopping (log it synchronously) */
+static bool log_async(cz_log_level_t level, const char *message) {
+    atomic_fetch_add(&g_ring.producers, 1);
+    if (!atomic_load(&g_async)) {
+        atomic_fetch_sub(&g_ring.producers, 1);
+        return false;
+    }
+    size_t position = 0;
+    cz_log_record_t *record = claim(&position);
+    while (!record && g_ring.overflow == CZ_LOG_OVERFLOW_BLOCK) {
+        if (atomic_load(&g_ring.stopping)) {
+            atomic_fetch_sub(&g_ring.producers, 1);
+            return false;
+        }
+        cz_nanosleep(1000);
+        record = claim(&position);
+    }
+    if (!record) {
+        atomic_fetch_add(&g_ring.dropped, 1);
+        atomic_fetch_sub(&g_ring.producers, 1);
+        return true;
+    }
+
+    size_t length = message ? strlen(message) : 0;
+    record->level = level;
+    record->elapsed_ns = cz_monotonic_coarse_timer_ns();
+    record->length = length < CZ_LOG_RECORD_TEXT ? length : CZ_LOG_RECORD_TEXT;
+    if (record->length > 0) {
+        memcpy(record->text, message, record->length);
+    }
+    atomic_store_explicit(&record->sequence, position + 1, memory_order_release);
+    atomic_fetch_sub(&g_ring.producers, 1);
+    return true;
+}
+
+/* Stop the writer thread at exit, after writing what is queued */
+static void stop_at_exit(void) {
+    cz_log_async_stop();
+}
+
+/* Log from a background thread through a ring of capacity records (rounded up to a power of two) */
+bool cz_log_async_start(size_t capacity, cz_log_overflow_t overflow) {
+    if (atomic_load(&g_async)) {
+        return true;
+    }
+
+    size_t size = 2;
+    while (size < capacity) {
+        size *= 2;
+    }
+    g_ring.records = malloc(size * sizeof(cz_log_record_t));
+    if (!g_ring.records) {
+        return false;
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&g_ring.records[i].sequence, i);
+    }
+    g_ring.mask = size - 1;
+    g_ring.overflow = overflow;
+    atomic_store(&g_ring.head, 0);
+    atomic_store(&g_ring.written, 0);
+    atomic_store(&g_ring.dropped, 0);
+    atomic_store(&g_ring.reported, 0);
+    atomic_store(&g_ring.stopping, false);
+    atomic_store(&g_ring.producers, 0);
+
+    fflush(stdout);
+    fflush(stderr);
+#ifdef CZ_PLATFORM_WINDOWS
+    g_ring.thread = CreateThread(NULL, 0, writer_main, NULL, 0, NULL);
+    bool started = g_ring.thread != NULL;
+#else
+    bool started = pthread_create(&g_ring.thread, NULL, writer_main, NULL) == 0;
+#endif
+    if (!started) {
+        free(g_ring.records);
+        g_ring.records = NULL;
+        return false;
+    }
+
+    static bool registered = false;
+    if (!registered) {
+        registered = atexit(stop_at_exit) == 0;
+    }
+    atomic_store(&g_async, true);
+    return true;
+}
+
+/* Write what is queued, stop the writer thread and log synchronously again.
+ * The writer exits once no producer is inside log_async, so the ring is never freed under one. */
+void cz_log_async_stop(void) {
+    if (!atomic_exchange(&g_async, false)) {
+        return;
+    }
+    atomic_store(&g_ring.stopping, true);
+#ifdef CZ_PLATFORM_WINDOWS
+    WaitForSingleObject(g_ring.thread, INFINITE);
+    CloseHandle(g_ring.thread);
+#else
+    pthread_join(g_ring.thread, NULL);
+#endif
+    free(g_ring.records);
+    g_ring.records = NULL;
+}
+
+/* Wait until every message logged before the call is written and flushed */
+void cz_log_flush(void) {
+    if (atomic_load(&g_async)) {
+        size_t target = atomic_load(&g_ring.head);
+        while (atomic_load_explicit(&g_ring.written, memory_order_acquire) < target) {
+            cz_nanosleep(1000);
+        }
+    }
+    fflush(stdout);
+    fflush(stderr);
+}
+
+/* Number of messages dropped because the ring was full */
+unsigned long long cz_log_dropped(void) {
+    return atomic_load(&g_ring.dropped);
+}
+
+/* Log a message at the specified level */
+void cz_log(cz_log_level_t level, const char *message) {
+    if (level < g_log_level) {
+        return; /* Suppress messages below threshold */
+    }
+
+    if (atomic_load_explicit(&g_async, memory_order_acquire) && log_async(level, message)) {
+        return;
+    }
+
+    FILE *out;
+    const char *level_str = level_name(level, &out);
 
     /* Get elapsed time since program start */
-    unsigned long long elapsed_ns = cz_monotonic_timer_ns();
+    unsigned long long elapsed_ns = cz_monotonic_coarse_timer_ns();
     double elapsed_s = elapsed_ns / 1000000000.0;
 
     fprintf(out, "[CZAR] %.2fs %s %s\n", elapsed_s, level_str, message ? message : "");
     fflush(out);
 }
+
+/* Format into a line on the stack (the heap only for longer messages) then log it */
+void cz_logf_impl(cz_log_level_t level, const char *fmt, int argc, cz_any_t *argv) {
+    char line[CZ_LOG_RECORD_TEXT + 1];
+    size_t length = cz_format_to_impl(line, sizeof(line), fmt, argc, argv);
+    if (length < sizeof(line)) {
+        cz_log(level, line);
+        return;
+    }
+    char *message = malloc(length + 1);
+    if (!message) {
+        cz_log(level, line);
+        return;
+    }
+    cz_format_to_impl(message, length + 1, fmt, argc, argv);
+    cz_log(level, message);
+    free(message);
+}
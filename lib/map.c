@@ -0,0 +1,367 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Map implementation - Open-addressing hash maps with SWAR group probing
+ */
+
+#include "cz.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Control bytes: the top bit marks a free slot, full slots hold the top 7 bits of the hash */
+#define CTRL_EMPTY 0x80
+#define CTRL_REMOVED 0xFE
+
+/* Slots probed at once: 8 control bytes read as one word */
+#define GROUP 8
+#define GROUP_LSB 0x0101010101010101ULL
+#define GROUP_MSB 0x8080808080808080ULL
+
+/* Final mix of 64 bits (MurmurHash3) */
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/* Hash of an integer key, never 0: one multiply with the high half folded into the low bits
+ * that pick the group (the full mix64 chain costs more than the probe of a warm map) */
+static uint64_t hash_int(uint64_t key) {
+    uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 32;
+    return hash ? hash : 1;
+}
+
+/* Hash of a string key a word at a time, never 0 */
+static uint64_t hash_string(const char *key, size_t length) {
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ length;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, key + i, 8);
+        hash = (hash ^ word) * 0xbf58476d1ce4e5b9ULL;
+        hash ^= hash >> 31;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, key + i, length - i);
+    hash = mix64(hash ^ tail);
+    return hash ? hash : 1;
+}
+
+/* Control bytes of a group, the first slot in the lowest byte */
+static uint64_t load_group(const uint8_t *ctrl) {
+    uint64_t group;
+    memcpy(&group, ctrl, sizeof(group));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    group = __builtin_bswap64(group);
+#endif
+    return group;
+}
+
+/* Top bit set in the bytes equal to h2 (rare false positives, the keys are compared anyway) */
+static uint64_t match_byte(uint64_t group, uint8_t h2) {
+    uint64_t x = group ^ (GROUP_LSB * h2);
+    return (x - GROUP_LSB) & ~x & GROUP_MSB;
+}
+
+/* Top bit set in the empty bytes (0x80 has bit 1 clear, unlike 0xFE) */
+static uint64_t match_empty(uint64_t group) {
+    return group & (~group << 6) & GROUP_MSB;
+}
+
+/* Top bit set in the empty or removed bytes */
+static uint64_t match_free(uint64_t group) {
+    return group & GROUP_MSB;
+}
+
+/* Index of the lowest byte flagged in bits */
+static size_t lowest_byte(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (size_t)__builtin_ctzll(bits) / 8;
+#else
+    size_t n = 0;
+    while (!(bits & 0x80)) {
+        bits >>= 8;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* Top 7 bits of a hash (the low bits pick the group) */
+static uint8_t hash_h2(uint64_t hash) {
+    return (uint8_t)(hash >> 57);
+}
+
+/* Whether an entry holds the key */
+static bool entry_is(const cz_map_t *map, const cz_map_entry_t *entry, uint64_t hash,
+                     uint64_t integer, const char *string, size_t length) {
+    if (entry->hash != hash) {
+        return false;
+    }
+    if (map->kind == CZ_MAP_INT) {
+        return entry->key.integer == integer;
+    }
+    return entry->length == length && memcmp(entry->key.string, string, length) == 0;
+}
+
+/* Slot of the key, SIZE_MAX when missing (groups are visited in triangular order, all of them);
+ * inlined into one copy per kind of key so the comparison folds */
+static inline size_t find_kind(const cz_map_t *map, cz_map_keys_t kind, uint64_t hash,
+                               uint64_t integer, const char *string, size_t length) {
+    if (map->slot_count == 0) {
+        return SIZE_MAX;
+    }
+    const cz_map_entry_t *entries = map->entries.data;
+    size_t mask = map->slot_count / GROUP - 1;
+    size_t g = (size_t)hash & mask;
+    uint8_t h2 = hash_h2(hash);
+    for (size_t step = 1;; step++) {
+        uint64_t group = load_group(map->ctrl + g * GROUP);
+        for (uint64_t bits = match_byte(group, h2); bits; bits &= bits - 1) {
+            size_t slot = g * GROUP + lowest_byte(bits);
+            const cz_map_entry_t *entry = &entries[map->slots[slot]];
+            if (kind == CZ_MAP_INT ? entry->hash == hash && entry->key.integer == integer
+                                   : entry_is(map, entry, hash, integer, string, length)) {
+                return slot;
+            }
+        }
+        /* The key would have gone in an empty slot of this group */
+        if (match_empty(group)) {
+            return SIZE_MAX;
+        }
+        g = (g + step) & mask;
+    }
+}
+
+static size_t find(const cz_map_t *map, uint64_t hash, uint64_t integer, const char *string, size_t length) {
+    return map->kind == CZ_MAP_INT ? find_kind(map, CZ_MAP_INT, hash, integer, NULL, 0)
+                                   : find_kind(map, CZ_MAP_STRING, hash, 0, string, length);
+}
+
+/* First empty or removed slot along the probe sequence of hash (the load factor leaves some) */
+static size_t find_free(const cz_map_t *map, uint64_t hash) {
+    size_t mask = map->slot_count / GROUP - 1;
+    size_t g = (size_t)hash & mask;
+    for (size_t step = 1;; step++) {
+        uint64_t bits = match_free(load_group(map->ctrl + g * GROUP));
+        if (bits) {
+            return g * GROUP + lowest_byte(bits);
+        }
+        g = (g + step) & mask;
+    }
+}
+
+/* Slots usable before a rehash (7/8 of them) */
+static size_t max_load(size_t slot_count) {
+    return slot_count / 8 * 7;
+}
+
+/* Rebuild the slots for capacity entries, dropping removed entries (in order, so iteration order stays) */
+static bool rehash(cz_map_t *map, size_t capacity) {
+    if (capacity >= UINT32_MAX) {
+        return false;
+    }
+    size_t slot_count = GROUP;
+    while (max_load(slot_count) < capacity) {
+        slot_count *= 2;
+    }
+    uint8_t *ctrl = malloc(slot_count);
+    uint32_t *slots = malloc(slot_count * sizeof(uint32_t));
+    if (!ctrl || !slots) {
+        free(ctrl);
+        free(slots);
+        return false;
+    }
+    memset(ctrl, CTRL_EMPTY, slot_count);
+
+    cz_map_entry_t *entries = map->entries.data;
+    size_t live = 0;
+    for (size_t i = 0; i < map->entries.len; i++) {
+        if (entries[i].hash != 0) {
+            entries[live++] = entries[i];
+        }
+    }
+    map->entries.len = live;
+
+    free(map->ctrl);
+    free(map->slots);
+    map->ctrl = ctrl;
+    map->slots = slots;
+    map->slot_count = slot_count;
+    map->used = live;
+    for (size_t i = 0; i < live; i++) {
+        size_t slot = find_free(map, entries[i].hash);
+        ctrl[slot] = hash_h2(entries[i].hash);
+        slots[slot] = (uint32_t)i;
+    }
+    return true;
+}
+
+/* Insert or replace */
+static bool put(cz_map_t *map, uint64_t hash, uint64_t integer, const char *string, size_t length, void *value) {
+    size_t slot = find(map, hash, integer, string, length);
+    if (slot != SIZE_MAX) {
+        ((cz_map_entry_t *)map->entries.data)[map->slots[slot]].value = value;
+        return true;
+    }
+
+    /* Out of slots, or of entries after many removals: doubles, or stays put when mostly removed */
+    if (map->used + 1 > max_load(map->slot_count) || map->entries.len >= map->slot_count) {
+        size_t capacity = map->count * 2 > map->count + 1 ? map->count * 2 : map->count + 1;
+        if (!rehash(map, capacity)) {
+            return false;
+        }
+    }
+
+    char *copy = NULL;
+    if (string) {
+        copy = cz_arena_alloc_aligned(&map->keys, length + 1, 1);
+        if (!copy) {
+            return false;
+        }
+        memcpy(copy, string, length + 1);
+    }
+    cz_map_entry_t *entry = cz_vec_push(&map->entries);
+    if (!entry) {
+        return false;
+    }
+    if (copy) {
+        entry->key.string = copy;
+    } else {
+        entry->key.integer = integer;
+    }
+    entry->length = length;
+    entry->hash = hash;
+    entry->value = value;
+
+    slot = find_free(map, hash);
+    if (map->ctrl[slot] == CTRL_EMPTY) {
+        map->used++;
+    }
+    map->ctrl[slot] = hash_h2(hash);
+    map->slots[slot] = (uint32_t)(map->entries.len - 1);
+    map->count++;
+    return true;
+}
+
+/* Remove, leaving a removed marker so probes go on past the slot */
+static bool remove_key(cz_map_t *map, uint64_t hash, uint64_t integer, const char *string, size_t length) {
+    size_t slot = find(map, hash, integer, string, length);
+    if (slot == SIZE_MAX) {
+        return false;
+    }
+    ((cz_map_entry_t *)map->entries.data)[map->slots[slot]].hash = 0;
+    map->ctrl[slot] = CTRL_REMOVED;
+    map->count--;
+    return true;
+}
+
+/* Value slot of a found key, NULL when missing */
+static void **value_of(const cz_map_t *map, size_t slot) {
+    if (slot == SIZE_MAX) {
+        return NULL;
+    }
+    return &((cz_map_entry_t *)map->entries.data)[map->slots[slot]].value;
+}
+
+/* Initialize an empty map of kind keys */
+void cz_map_init(cz_map_t *map, cz_map_keys_t kind) {
+    map->ctrl = NULL;
+    map->slots = NULL;
+    map->slot_count = 0;
+    map->used = 0;
+    map->count = 0;
+    cz_vec_init(&map->entries, sizeof(cz_map_entry_t));
+    cz_arena_init(&map->keys, 4096);
+    map->kind = kind;
+}
+
+/* Make room for count entries in total without rehashing, false on failure */
+bool cz_map_reserve(cz_map_t *map, size_t count) {
+    if (count <= map->count) {
+        return true;
+    }
+    /* Removed slots and entries count against the room until a rehash drops them */
+    size_t removed = map->used - map->count;
+    size_t dead = map->entries.len - map->count;
+    if (count > max_load(map->slot_count) - removed || count + dead > map->slot_count) {
+        if (!rehash(map, count)) {
+            return false;
+        }
+    }
+    return cz_vec_reserve(&map->entries, count + (map->entries.len - map->count));
+}
+
+/* Insert or replace the value of a key, false on failure */
+bool cz_map_put_int(cz_map_t *map, uint64_t key, void *value) {
+    return map->kind == CZ_MAP_INT && put(map, hash_int(key), key, NULL, 0, value);
+}
+
+bool cz_map_put_string(cz_map_t *map, const char *key, void *value) {
+    size_t length = strlen(key);
+    return map->kind == CZ_MAP_STRING && put(map, hash_string(key, length), 0, key, length, value);
+}
+
+/* Value slot of a key (valid until the next insertion), NULL when missing */
+void **cz_map_get_int(const cz_map_t *map, uint64_t key) {
+    if (map->kind != CZ_MAP_INT) {
+        return NULL;
+    }
+    return value_of(map, find_kind(map, CZ_MAP_INT, hash_int(key), key, NULL, 0));
+}
+
+void **cz_map_get_string(const cz_map_t *map, const char *key) {
+    if (map->kind != CZ_MAP_STRING) {
+        return NULL;
+    }
+    size_t length = strlen(key);
+    return value_of(map, find_kind(map, CZ_MAP_STRING, hash_string(key, length), 0, key, length));
+}
+
+/* Remove a key, false when missing (a string key's copy is freed with the map) */
+bool cz_map_remove_int(cz_map_t *map, uint64_t key) {
+    return map->kind == CZ_MAP_INT && remove_key(map, hash_int(key), key, NULL, 0);
+}
+
+bool cz_map_remove_string(cz_map_t *map, const char *key) {
+    size_t length = strlen(key);
+    return map->kind == CZ_MAP_STRING && remove_key(map, hash_string(key, length), 0, key, length);
+}
+
+/* Next live entry in insertion order from *cursor (start at 0), NULL at the end */
+cz_map_entry_t *cz_map_next(const cz_map_t *map, size_t *cursor) {
+    cz_map_entry_t *entries = map->entries.data;
+    while (*cursor < map->entries.len) {
+        cz_map_entry_t *entry = &entries[(*cursor)++];
+        if (entry->hash != 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/* Remove every entry, keeping the storage */
+void cz_map_clear(cz_map_t *map) {
+    if (map->ctrl) {
+        memset(map->ctrl, CTRL_EMPTY, map->slot_count);
+    }
+    map->used = 0;
+    map->count = 0;
+    cz_vec_clear(&map->entries);
+    cz_arena_reset(&map->keys, (cz_arena_mark_t){ NULL, 0 });
+}
+
+/* Free the storage, the map stays usable and empty */
+void cz_map_free(cz_map_t *map) {
+    free(map->ctrl);
+    free(map->slots);
+    cz_vec_free(&map->entries);
+    cz_arena_release(&map->keys);
+    cz_map_init(map, map->kind);
+}
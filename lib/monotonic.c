@@ -14,6 +14,7 @@
 #endif
 
 #include "cz.h"
+#include <stdatomic.h>
 
 #ifdef CZ_PLATFORM_WINDOWS
 #include <windows.h>
@@ -22,16 +23,30 @@
 #include <unistd.h>
 #endif
 
+/* Performance counter ticks per second, cached by cz_timer_init() */
+#ifdef CZ_PLATFORM_WINDOWS
+static unsigned long long g_qpc_frequency = 0;
+
+/* Ticks to nanoseconds, split so that ticks * 1e9 cannot overflow */
+static unsigned long long qpc_to_ns(unsigned long long ticks) {
+    if (g_qpc_frequency == 0) {
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+        g_qpc_frequency = (unsigned long long)frequency.QuadPart;
+    }
+    unsigned long long seconds = ticks / g_qpc_frequency;
+    unsigned long long rest = ticks % g_qpc_frequency;
+    return seconds * 1000000000ULL + rest * 1000000000ULL / g_qpc_frequency;
+}
+#endif
+
 /* Get current time in nanoseconds from monotonic clock */
 unsigned long long cz_monotonic_clock_ns(void) {
 #ifdef CZ_PLATFORM_WINDOWS
     /* Windows implementation using QueryPerformanceCounter */
-    LARGE_INTEGER frequency;
     LARGE_INTEGER counter;
-    QueryPerformanceFrequency(&frequency);
     QueryPerformanceCounter(&counter);
-    /* Convert to nanoseconds: (counter * 1e9) / frequency */
-    return (unsigned long long)((counter.QuadPart * 1000000000ULL) / frequency.QuadPart);
+    return qpc_to_ns((unsigned long long)counter.QuadPart);
 #else
     /* POSIX implementation using clock_gettime with CLOCK_MONOTONIC */
     struct timespec ts;
@@ -43,6 +58,23 @@ unsigned long long cz_monotonic_clock_ns(void) {
 #endif
 }
 
+/* Get current time in nanoseconds from the cheap tick-granular monotonic clock */
+unsigned long long cz_monotonic_coarse_ns(void) {
+#ifdef CZ_PLATFORM_WINDOWS
+    /* Milliseconds, updated every tick (10-16ms) */
+    return (unsigned long long)GetTickCount64() * 1000000ULL;
+#elif defined(CLOCK_MONOTONIC_COARSE)
+    /* Read from the vDSO without touching the hardware clock */
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC_COARSE, &ts) != 0) {
+        return cz_monotonic_clock_ns();
+    }
+    return (unsigned long long)(ts.tv_sec) * 1000000000ULL + (unsigned long long)(ts.tv_nsec);
+#else
+    return cz_monotonic_clock_ns();
+#endif
+}
+
 /* Sleep for specified nanoseconds */
 void cz_nanosleep(unsigned long long nanoseconds) {
 #ifdef CZ_PLATFORM_WINDOWS
@@ -62,10 +94,21 @@ void cz_nanosleep(unsigned long long nanoseconds) {
 /* Timer: nanoseconds since program start */
 static unsigned long long g_timer_start = 0;
 
+/* Cycle counter calibration: a reference point taken at start, the rate measured once */
+static unsigned long long g_cycles_start = 0;
+static _Atomic double g_ns_per_cycle = 0.0;
+
+/* Shortest window used to measure the cycle counter rate */
+#define CZ_CYCLES_CALIBRATION_NS 1000000ULL
+
 #ifdef __GNUC__
 __attribute__((constructor))
 #endif
 static void cz_timer_init(void) {
+#ifdef CZ_PLATFORM_WINDOWS
+    qpc_to_ns(0);  /* Cache the counter frequency */
+#endif
+    g_cycles_start = cz_cycles();
     g_timer_start = cz_monotonic_clock_ns();
 }
 
@@ -76,3 +119,47 @@ unsigned long long cz_monotonic_timer_ns(void) {
     }
     return cz_monotonic_clock_ns() - g_timer_start;
 }
+
+unsigned long long cz_monotonic_coarse_timer_ns(void) {
+    if (g_timer_start == 0) {
+        cz_timer_init();
+    }
+    /* The coarse clock lags by up to a tick, never report before the start */
+    unsigned long long now = cz_monotonic_coarse_ns();
+    return now > g_timer_start ? now - g_timer_start : 0;
+}
+
+/* Nanoseconds per cycle, measured against the monotonic clock since start (spinning if it is too early) */
+static double cycles_rate(void) {
+#if defined(__aarch64__) && defined(__GNUC__)
+    /* The virtual counter advertises its frequency */
+    unsigned long long frequency;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+    return 1e9 / (double)frequency;
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(_MSC_VER))
+    if (g_timer_start == 0) {
+        cz_timer_init();
+    }
+    unsigned long long cycles = 0;
+    unsigned long long elapsed = 0;
+    do {
+        cycles = cz_cycles();
+        elapsed = cz_monotonic_clock_ns() - g_timer_start;
+    } while (elapsed < CZ_CYCLES_CALIBRATION_NS);
+    return (double)elapsed / (double)(cycles - g_cycles_start);
+#else
+    /* cz_cycles() falls back to the monotonic clock */
+    return 1.0;
+#endif
+}
+
+/* Convert a cz_cycles() difference to nanoseconds */
+unsigned long long cz_cycles_to_ns(unsigned long long cycles) {
+    double rate = g_ns_per_cycle;
+    if (rate == 0.0) {
+        /* Racing threads measure the same rate, any of them may win */
+        rate = cycles_rate();
+        g_ns_per_cycle = rate;
+    }
+    return (unsigned long long)((double)cycles * rate);
+}
@@ -0,0 +1,270 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Pool implementation - Fixed-size blocks with per-thread caches
+ */
+
+#include "cz.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CZ_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/* Bytes of blocks carved per chunk (at least one batch) */
+#define CZ_POOL_CHUNK_SIZE (64 * 1024)
+
+/* Blocks moved between a cache and its pool at once */
+#define CZ_POOL_BATCH 32
+
+/* Byte pattern of freed blocks when poisoning */
+#define CZ_POOL_POISON 0xDD
+
+/* Memory the blocks are carved from */
+typedef struct cz_pool_chunk_s {
+    struct cz_pool_chunk_s *next;
+} cz_pool_chunk_t;
+
+struct cz_pool_s {
+    size_t block_size;              /* Requested size rounded up to the alignment and a link */
+    size_t size;                    /* Requested size */
+    size_t align;
+    size_t per_chunk;               /* Blocks carved per chunk */
+    bool poison;
+    void *free;                     /* Free blocks, linked through their first word */
+    cz_pool_chunk_t *chunks;
+#ifdef CZ_PLATFORM_WINDOWS
+    CRITICAL_SECTION lock;
+#else
+    pthread_mutex_t lock;
+#endif
+};
+
+static void pool_lock(cz_pool_t *pool) {
+#ifdef CZ_PLATFORM_WINDOWS
+    EnterCriticalSection(&pool->lock);
+#else
+    pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+static void pool_unlock(cz_pool_t *pool) {
+#ifdef CZ_PLATFORM_WINDOWS
+    LeaveCriticalSection(&pool->lock);
+#else
+    pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+/* Create a pool of size-byte blocks aligned to align (0 for any type), NULL on failure */
+cz_pool_t *cz_pool_create(size_t size, size_t align, bool poison) {
+    if (align == 0) {
+        align = _Alignof(max_align_t);
+    }
+    if ((align & (align - 1)) != 0 || size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    if (align < _Alignof(void *)) {
+        align = _Alignof(void *);
+    }
+
+    cz_pool_t *pool = malloc(sizeof(cz_pool_t));
+    if (!pool) {
+        return NULL;
+    }
+    size_t block_size = size > sizeof(void *) ? size : sizeof(void *);
+    pool->block_size = (block_size + align - 1) & ~(align - 1);
+    pool->size = size;
+    pool->align = align;
+    pool->per_chunk = CZ_POOL_CHUNK_SIZE / pool->block_size;
+    if (pool->per_chunk < CZ_POOL_BATCH) {
+        pool->per_chunk = CZ_POOL_BATCH;
+    }
+    pool->poison = poison;
+    pool->free = NULL;
+    pool->chunks = NULL;
+#ifdef CZ_PLATFORM_WINDOWS
+    InitializeCriticalSection(&pool->lock);
+#else
+    pthread_mutex_init(&pool->lock, NULL);
+#endif
+    return pool;
+}
+
+/* Free the pool and every block it handed out */
+void cz_pool_destroy(cz_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    cz_pool_chunk_t *chunk = pool->chunks;
+    while (chunk) {
+        cz_pool_chunk_t *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+#ifdef CZ_PLATFORM_WINDOWS
+    DeleteCriticalSection(&pool->lock);
+#else
+    pthread_mutex_destroy(&pool->lock);
+#endif
+    free(pool);
+}
+
+/* Fill a freed block past its link */
+static void poison_block(const cz_pool_t *pool, void *block) {
+    if (pool->block_size > sizeof(void *)) {
+        memset((char *)block + sizeof(void *), CZ_POOL_POISON, pool->block_size - sizeof(void *));
+    }
+}
+
+/* Check a block leaving the free list was not written to after its free */
+static void check_block(const cz_pool_t *pool, const void *block) {
+    const unsigned char *bytes = (const unsigned char *)block;
+    for (size_t i = sizeof(void *); i < pool->block_size; i++) {
+        if (CZ_UNLIKELY(bytes[i] != CZ_POOL_POISON)) {
+            cz_assert_fail("pool block written after free", __FILE__, __LINE__);
+        }
+    }
+}
+
+/* Carve a new chunk into the free list (locked), false when out of memory */
+static bool pool_grow(cz_pool_t *pool) {
+    size_t header = (sizeof(cz_pool_chunk_t) + pool->align - 1) & ~(pool->align - 1);
+    cz_pool_chunk_t *chunk = malloc(header + pool->align + pool->per_chunk * pool->block_size);
+    if (!chunk) {
+        return false;
+    }
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    /* malloc only guarantees max_align_t, align the first block by hand */
+    uintptr_t start = (uintptr_t)chunk + header;
+    start = (start + pool->align - 1) & ~(uintptr_t)(pool->align - 1);
+    char *blocks = (char *)start;
+    for (size_t i = pool->per_chunk; i-- > 0;) {
+        void *block = blocks + i * pool->block_size;
+        if (pool->poison) {
+            poison_block(pool, block);
+        }
+        *(void **)block = pool->free;
+        pool->free = block;
+    }
+    return true;
+}
+
+/* Move up to count free blocks of the pool onto *list (locked), returns how many */
+static size_t pool_take(cz_pool_t *pool, void **list, size_t count) {
+    size_t taken = 0;
+    pool_lock(pool);
+    while (taken < count) {
+        if (!pool->free && !pool_grow(pool)) {
+            break;
+        }
+        void *block = pool->free;
+        pool->free = *(void **)block;
+        *(void **)block = *list;
+        *list = block;
+        taken++;
+    }
+    pool_unlock(pool);
+    return taken;
+}
+
+/* Take a block through the shared pool (locked), NULL when out of memory */
+void *cz_pool_alloc(cz_pool_t *pool) {
+    void *block = NULL;
+    if (pool_take(pool, &block, 1) == 0) {
+        return NULL;
+    }
+    if (pool->poison) {
+        check_block(pool, block);
+    }
+    return block;
+}
+
+/* Give a block back through the shared pool (locked) */
+void cz_pool_free(cz_pool_t *pool, void *block) {
+    if (!block) {
+        return;
+    }
+    if (pool->poison) {
+        poison_block(pool, block);
+    }
+    pool_lock(pool);
+    *(void **)block = pool->free;
+    pool->free = block;
+    pool_unlock(pool);
+}
+
+/* Attach a cache to a pool, refilled and drained a batch at a time */
+void cz_pool_cache_init(cz_pool_cache_t *cache, cz_pool_t *pool) {
+    cache->pool = pool;
+    cache->free = NULL;
+    cache->count = 0;
+    cache->limit = 2 * CZ_POOL_BATCH;
+    cache->poison = pool->poison;
+}
+
+/* Give count cached blocks back to the pool under one lock */
+static void cache_drain(cz_pool_cache_t *cache, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    /* Detach the first count blocks as one list */
+    void *first = cache->free;
+    void *last = first;
+    for (size_t i = 1; i < count; i++) {
+        last = *(void **)last;
+    }
+    cache->free = *(void **)last;
+    cache->count -= count;
+
+    cz_pool_t *pool = cache->pool;
+    pool_lock(pool);
+    *(void **)last = pool->free;
+    pool->free = first;
+    pool_unlock(pool);
+}
+
+/* Refill an empty cache with a batch, or check a poisoned block */
+void *cz_pool_cache_alloc_slow(cz_pool_cache_t *cache) {
+    if (!cache->free) {
+        cache->count += pool_take(cache->pool, &cache->free, CZ_POOL_BATCH);
+        if (!cache->free) {
+            return NULL;
+        }
+    }
+    void *block = cache->free;
+    cache->free = *(void **)block;
+    cache->count--;
+    if (cache->poison) {
+        check_block(cache->pool, block);
+    }
+    return block;
+}
+
+/* Poison a freed block, or send half of a full cache back to the pool */
+void cz_pool_cache_free_slow(cz_pool_cache_t *cache, void *block) {
+    if (!block) {
+        return;
+    }
+    if (cache->poison) {
+        poison_block(cache->pool, block);
+    }
+    if (cache->count >= cache->limit) {
+        cache_drain(cache, cache->limit / 2);
+    }
+    *(void **)block = cache->free;
+    cache->free = block;
+    cache->count++;
+}
+
+/* Give every cached block back to the pool */
+void cz_pool_cache_flush(cz_pool_cache_t *cache) {
+    cache_drain(cache, cache->count);
+}
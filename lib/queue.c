@@ -0,0 +1,312 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Queue implementation - Bounded lock-free SPSC and MPMC rings
+ */
+
+#include "cz.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Positions are free-running counters, a slot is position & mask */
+
+struct cz_spsc_s {
+    atomic_size_t head;                 /* Next position to pop, written by the consumer */
+    size_t cached_tail;                 /* Consumer's last view of tail */
+    char head_line[64 - 2 * sizeof(size_t)];
+    atomic_size_t tail;                 /* Next position to push, written by the producer */
+    size_t cached_head;                 /* Producer's last view of head */
+    char tail_line[64 - 2 * sizeof(size_t)];
+    size_t mask;                        /* Capacity - 1 */
+    size_t size;
+    unsigned char *data;
+};
+
+struct cz_mpmc_s {
+    atomic_size_t enqueue;              /* Next position producers claim */
+    char enqueue_line[64 - sizeof(size_t)];
+    atomic_size_t dequeue;              /* Next position consumers claim */
+    char dequeue_line[64 - sizeof(size_t)];
+    size_t mask;                        /* Capacity - 1 */
+    size_t size;
+    size_t stride;                      /* Bytes per cell: the sequence, then the element */
+    unsigned char *cells;
+};
+
+/* Capacity rounded up to a power of two, 0 when too large for elements of stride bytes */
+static size_t ring_capacity(size_t capacity, size_t stride) {
+    if (capacity > SIZE_MAX / 2) {
+        return 0;
+    }
+    size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+    if (stride == 0 || rounded > SIZE_MAX / stride) {
+        return 0;
+    }
+    return rounded;
+}
+
+/* Copy one element, with fixed-size copies for the common sizes (no call to memcpy) */
+static inline void copy_item(void *to, const void *from, size_t size) {
+    switch (size) {
+        case 4: memcpy(to, from, 4); break;
+        case 8: memcpy(to, from, 8); break;
+        case 16: memcpy(to, from, 16); break;
+        default: memcpy(to, from, size); break;
+    }
+}
+
+/* Copy count elements into the ring from position, in two parts when it wraps */
+static void ring_write(unsigned char *data, size_t mask, size_t size, size_t position,
+                       const unsigned char *items, size_t count) {
+    size_t index = position & mask;
+    size_t first = count < mask + 1 - index ? count : mask + 1 - index;
+    if (count == 1) {
+        copy_item(data + index * size, items, size);
+        return;
+    }
+    memcpy(data + index * size, items, first * size);
+    memcpy(data, items + first * size, (count - first) * size);
+}
+
+/* Copy count elements out of the ring from position, in two parts when it wraps */
+static void ring_read(const unsigned char *data, size_t mask, size_t size, size_t position,
+                      unsigned char *items, size_t count) {
+    size_t index = position & mask;
+    size_t first = count < mask + 1 - index ? count : mask + 1 - index;
+    if (count == 1) {
+        copy_item(items, data + index * size, size);
+        return;
+    }
+    memcpy(items, data + index * size, first * size);
+    memcpy(items + first * size, data, (count - first) * size);
+}
+
+/* ----------------------------------------------------------------------------
+ * SPSC: each side owns one index and caches the other, re-reading it only when
+ * the ring looks full (producer) or empty (consumer).
+ * ---------------------------------------------------------------------------- */
+
+/* Create a queue of capacity (rounded up to a power of two) elements of size bytes, NULL on failure */
+cz_spsc_t *cz_spsc_create(size_t capacity, size_t size) {
+    size_t rounded = ring_capacity(capacity, size);
+    if (rounded == 0) {
+        return NULL;
+    }
+    cz_spsc_t *queue = malloc(sizeof(cz_spsc_t));
+    if (!queue) {
+        return NULL;
+    }
+    queue->data = malloc(rounded * size);
+    if (!queue->data) {
+        free(queue);
+        return NULL;
+    }
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cached_tail = 0;
+    queue->cached_head = 0;
+    queue->mask = rounded - 1;
+    queue->size = size;
+    return queue;
+}
+
+/* Free a queue (and the elements still in it) */
+void cz_spsc_destroy(cz_spsc_t *queue) {
+    if (queue) {
+        free(queue->data);
+        free(queue);
+    }
+}
+
+/* Copy up to count elements in, returns how many (producer thread only) */
+size_t cz_spsc_push_n(cz_spsc_t *queue, const void *items, size_t count) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t capacity = queue->mask + 1;
+    if (capacity - (tail - queue->cached_head) < count) {
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    }
+    size_t free_slots = capacity - (tail - queue->cached_head);
+    size_t n = count < free_slots ? count : free_slots;
+    if (n == 0) {
+        return 0;
+    }
+    ring_write(queue->data, queue->mask, queue->size, tail, items, n);
+    atomic_store_explicit(&queue->tail, tail + n, memory_order_release);
+    return n;
+}
+
+/* Copy up to count elements out, returns how many (consumer thread only) */
+size_t cz_spsc_pop_n(cz_spsc_t *queue, void *items, size_t count) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (queue->cached_tail - head < count) {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    }
+    size_t available = queue->cached_tail - head;
+    size_t n = count < available ? count : available;
+    if (n == 0) {
+        return 0;
+    }
+    ring_read(queue->data, queue->mask, queue->size, head, items, n);
+    atomic_store_explicit(&queue->head, head + n, memory_order_release);
+    return n;
+}
+
+/* Copy one element in, false when full */
+bool cz_spsc_push(cz_spsc_t *queue, const void *item) {
+    return cz_spsc_push_n(queue, item, 1) == 1;
+}
+
+/* Copy one element out, false when empty */
+bool cz_spsc_pop(cz_spsc_t *queue, void *item) {
+    return cz_spsc_pop_n(queue, item, 1) == 1;
+}
+
+/* Elements in the queue */
+size_t cz_spsc_count(const cz_spsc_t *queue) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    return tail - head;
+}
+
+/* ----------------------------------------------------------------------------
+ * MPMC: a cell at position p is free for the producer of p when its sequence is
+ * p, and filled for the consumer of p when it is p + 1; the consumer hands it to
+ * the producer of the next lap with p + capacity. A batch claims consecutive
+ * cells that are all ready with a single compare-and-swap.
+ * ---------------------------------------------------------------------------- */
+
+static atomic_size_t *cell_sequence(const cz_mpmc_t *queue, size_t position) {
+    return (atomic_size_t *)(void *)(queue->cells + (position & queue->mask) * queue->stride);
+}
+
+static unsigned char *cell_item(const cz_mpmc_t *queue, size_t position) {
+    return queue->cells + (position & queue->mask) * queue->stride + sizeof(atomic_size_t);
+}
+
+/* Create a queue of capacity (rounded up to a power of two) elements of size bytes, NULL on failure */
+cz_mpmc_t *cz_mpmc_create(size_t capacity, size_t size) {
+    if (size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    size_t align = _Alignof(atomic_size_t);
+    size_t stride = sizeof(atomic_size_t) + (size + align - 1) / align * align;
+    size_t rounded = ring_capacity(capacity, stride);
+    if (rounded == 0) {
+        return NULL;
+    }
+    cz_mpmc_t *queue = malloc(sizeof(cz_mpmc_t));
+    if (!queue) {
+        return NULL;
+    }
+    queue->cells = malloc(rounded * stride);
+    if (!queue->cells) {
+        free(queue);
+        return NULL;
+    }
+    queue->mask = rounded - 1;
+    queue->size = size;
+    queue->stride = stride;
+    for (size_t i = 0; i < rounded; i++) {
+        atomic_init(cell_sequence(queue, i), i);
+    }
+    atomic_init(&queue->enqueue, 0);
+    atomic_init(&queue->dequeue, 0);
+    return queue;
+}
+
+/* Free a queue (and the elements still in it) */
+void cz_mpmc_destroy(cz_mpmc_t *queue) {
+    if (queue) {
+        free(queue->cells);
+        free(queue);
+    }
+}
+
+/* Copy up to count consecutive elements in, returns how many (0 when full) */
+size_t cz_mpmc_push_n(cz_mpmc_t *queue, const void *items, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t position = atomic_load_explicit(&queue->enqueue, memory_order_relaxed);
+    for (;;) {
+        size_t sequence = atomic_load_explicit(cell_sequence(queue, position), memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+        if (diff == 0) {
+            size_t n = 1;
+            while (n < count &&
+                   atomic_load_explicit(cell_sequence(queue, position + n), memory_order_acquire) == position + n) {
+                n++;
+            }
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue, &position, position + n,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                const unsigned char *bytes = items;
+                for (size_t i = 0; i < n; i++) {
+                    copy_item(cell_item(queue, position + i), bytes + i * queue->size, queue->size);
+                    atomic_store_explicit(cell_sequence(queue, position + i), position + i + 1, memory_order_release);
+                }
+                return n;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            position = atomic_load_explicit(&queue->enqueue, memory_order_relaxed);
+        }
+    }
+}
+
+/* Copy up to count consecutive elements out, returns how many (0 when empty) */
+size_t cz_mpmc_pop_n(cz_mpmc_t *queue, void *items, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t position = atomic_load_explicit(&queue->dequeue, memory_order_relaxed);
+    for (;;) {
+        size_t sequence = atomic_load_explicit(cell_sequence(queue, position), memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(position + 1);
+        if (diff == 0) {
+            size_t n = 1;
+            while (n < count &&
+                   atomic_load_explicit(cell_sequence(queue, position + n), memory_order_acquire) == position + n + 1) {
+                n++;
+            }
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue, &position, position + n,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                unsigned char *bytes = items;
+                for (size_t i = 0; i < n; i++) {
+                    copy_item(bytes + i * queue->size, cell_item(queue, position + i), queue->size);
+                    atomic_store_explicit(cell_sequence(queue, position + i), position + i + queue->mask + 1,
+                                          memory_order_release);
+                }
+                return n;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            position = atomic_load_explicit(&queue->dequeue, memory_order_relaxed);
+        }
+    }
+}
+
+/* Copy one element in, false when full */
+bool cz_mpmc_push(cz_mpmc_t *queue, const void *item) {
+    return cz_mpmc_push_n(queue, item, 1) == 1;
+}
+
+/* Copy one element out, false when empty */
+bool cz_mpmc_pop(cz_mpmc_t *queue, void *item) {
+    return cz_mpmc_pop_n(queue, item, 1) == 1;
+}
+
+/* Elements claimed by producers and not yet by consumers (at most the capacity) */
+size_t cz_mpmc_count(const cz_mpmc_t *queue) {
+    size_t dequeue = atomic_load_explicit(&queue->dequeue, memory_order_acquire);
+    size_t enqueue = atomic_load_explicit(&queue->enqueue, memory_order_acquire);
+    size_t count = enqueue - dequeue;
+    return count <= queue->mask + 1 ? count : queue->mask + 1;
+}
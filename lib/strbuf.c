@@ -0,0 +1,96 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Strbuf implementation - String builder with inline storage for short texts
+ */
+
+#include "cz.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Initialize an empty builder */
+void cz_strbuf_init(cz_strbuf_t *sb) {
+    sb->heap = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+    sb->small[0] = '\0';
+}
+
+/* Make room for extra more bytes (capacity at least doubles), false on failure */
+bool cz_strbuf_reserve(cz_strbuf_t *sb, size_t extra) {
+    size_t cap = sb->heap ? sb->cap : CZ_STRBUF_SMALL;
+    if (extra < cap - sb->len) {
+        return true;
+    }
+    if (extra > SIZE_MAX - sb->len - 1) {
+        return false; /* Overflow */
+    }
+    size_t needed = sb->len + extra + 1;
+    size_t grown = cap <= SIZE_MAX / 2 ? cap * 2 : SIZE_MAX;
+    if (grown < needed) {
+        grown = needed;
+    }
+
+    /* Leaving small: the text moves once, afterwards realloc may grow in place */
+    char *heap = realloc(sb->heap, grown);
+    if (!heap) {
+        return false;
+    }
+    if (!sb->heap) {
+        memcpy(heap, sb->small, sb->len + 1);
+    }
+    sb->heap = heap;
+    sb->cap = grown;
+    return true;
+}
+
+/* Append n bytes, false on failure (the text is unchanged) */
+bool cz_strbuf_append(cz_strbuf_t *sb, const char *data, size_t n) {
+    if (!cz_strbuf_reserve(sb, n)) {
+        return false;
+    }
+    char *text = sb->heap ? sb->heap : sb->small;
+    memmove(text + sb->len, data, n);
+    sb->len += n;
+    text[sb->len] = '\0';
+    return true;
+}
+
+/* Format straight into the free space, once more after growing when it did not fit */
+bool cz_strbuf_appendf_impl(cz_strbuf_t *sb, const char *fmt, int argc, cz_any_t *argv) {
+    size_t room = (sb->heap ? sb->cap : CZ_STRBUF_SMALL) - sb->len;
+    char *text = sb->heap ? sb->heap : sb->small;
+    size_t n = cz_format_to_impl(text + sb->len, room, fmt, argc, argv);
+    if (n >= room) {
+        if (!cz_strbuf_reserve(sb, n)) {
+            text[sb->len] = '\0';
+            return false;
+        }
+        text = sb->heap;
+        cz_format_to_impl(text + sb->len, n + 1, fmt, argc, argv);
+    }
+    sb->len += n;
+    return true;
+}
+
+/* Free the heap storage, the builder stays usable and empty */
+void cz_strbuf_free(cz_strbuf_t *sb) {
+    free(sb->heap);
+    cz_strbuf_init(sb);
+}
+
+/* Take the text out as a heap string (free() it), NULL on failure; the builder is left empty */
+char *cz_strbuf_take(cz_strbuf_t *sb) {
+    char *text = sb->heap;
+    if (!text) {
+        text = malloc(sb->len + 1);
+        if (!text) {
+            return NULL;
+        }
+        memcpy(text, sb->small, sb->len + 1);
+    }
+    cz_strbuf_init(sb);
+    return text;
+}
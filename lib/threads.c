@@ -0,0 +1,558 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Threads implementation - Work-stealing thread pool, task groups and parallel loops
+ */
+
+#include "cz.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#ifdef CZ_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+/* Tasks a worker's deque holds (a power of two), a spawn beyond that runs right away */
+#define CZ_DEQUE_SIZE 1024
+
+/* Searches for work that come back empty before a thread yields, or a worker sleeps */
+#define CZ_IDLE_SPINS 64
+
+/* Queued task: fn(ctx), or a range task (fn NULL) covering [begin, end) of the loop at ctx */
+typedef struct {
+    cz_task_fn fn;
+    void *ctx;
+    cz_task_group_t *group;
+    size_t begin;
+    size_t end;
+} cz_task_t;
+
+/* Deque cell: read by thieves while the owner may reuse it, so every field is atomic */
+typedef struct {
+    _Atomic(cz_task_fn) fn;
+    _Atomic(void *) ctx;
+    _Atomic(cz_task_group_t *) group;
+    atomic_size_t begin;
+    atomic_size_t end;
+} cz_deque_cell_t;
+
+/* Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from the top */
+typedef struct {
+    _Atomic int64_t top;
+    char top_line[64 - sizeof(int64_t)];        /* Thieves and owner on separate cache lines */
+    _Atomic int64_t bottom;
+    char bottom_line[64 - sizeof(int64_t)];
+    cz_deque_cell_t cells[CZ_DEQUE_SIZE];
+} cz_deque_t;
+
+/* Worker thread and its deque */
+typedef struct {
+    cz_deque_t deque;
+    cz_threadpool_t *pool;
+    uint64_t seed;                              /* Victim selection */
+#ifdef CZ_PLATFORM_WINDOWS
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+} cz_worker_t;
+
+struct cz_threadpool_s {
+    cz_worker_t *workers;
+    size_t count;
+    size_t started;                             /* Workers whose thread runs */
+    cz_task_t *shared;                          /* Ring of tasks spawned outside the workers (locked) */
+    size_t shared_head;
+    size_t shared_cap;                          /* Power of two */
+    atomic_size_t shared_count;                 /* Tasks in shared, peeked at without the lock */
+    atomic_size_t epoch;                        /* Bumped by every spawn, sleepers wait for a change */
+    atomic_size_t sleepers;
+    atomic_bool stopping;
+#ifdef CZ_PLATFORM_WINDOWS
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE wake;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+#endif
+};
+
+/* Parallel loop shared by its range tasks */
+typedef struct {
+    cz_range_fn fn;
+    void *ctx;
+    size_t grain;
+} cz_loop_t;
+
+/* Worker running on this thread, NULL outside of any pool */
+static CZ_THREAD_LOCAL cz_worker_t *g_worker = NULL;
+
+/* Victim selection of threads that are not workers */
+static CZ_THREAD_LOCAL uint64_t g_seed = 0;
+
+static _Atomic(cz_threadpool_t *) g_default = NULL;
+
+static void threadpool_lock(cz_threadpool_t *pool) {
+#ifdef CZ_PLATFORM_WINDOWS
+    EnterCriticalSection(&pool->lock);
+#else
+    pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+static void threadpool_unlock(cz_threadpool_t *pool) {
+#ifdef CZ_PLATFORM_WINDOWS
+    LeaveCriticalSection(&pool->lock);
+#else
+    pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+static void thread_yield(void) {
+#ifdef CZ_PLATFORM_WINDOWS
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+/* Hardware threads of the machine, at least 1 */
+static size_t hardware_threads(void) {
+#ifdef CZ_PLATFORM_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (size_t)info.dwNumberOfProcessors : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+/* xorshift64 */
+static uint64_t next_random(uint64_t *seed) {
+    uint64_t x = *seed ? *seed : 0x9e3779b97f4a7c15ULL;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seed = x;
+    return x;
+}
+
+static void cell_store(cz_deque_cell_t *cell, const cz_task_t *task) {
+    atomic_store_explicit(&cell->fn, task->fn, memory_order_relaxed);
+    atomic_store_explicit(&cell->ctx, task->ctx, memory_order_relaxed);
+    atomic_store_explicit(&cell->group, task->group, memory_order_relaxed);
+    atomic_store_explicit(&cell->begin, task->begin, memory_order_relaxed);
+    atomic_store_explicit(&cell->end, task->end, memory_order_relaxed);
+}
+
+static void cell_load(cz_deque_cell_t *cell, cz_task_t *task) {
+    task->fn = atomic_load_explicit(&cell->fn, memory_order_relaxed);
+    task->ctx = atomic_load_explicit(&cell->ctx, memory_order_relaxed);
+    task->group = atomic_load_explicit(&cell->group, memory_order_relaxed);
+    task->begin = atomic_load_explicit(&cell->begin, memory_order_relaxed);
+    task->end = atomic_load_explicit(&cell->end, memory_order_relaxed);
+}
+
+/* Owner: push at the bottom, false when full */
+static bool deque_push(cz_deque_t *deque, const cz_task_t *task) {
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= CZ_DEQUE_SIZE) {
+        return false;
+    }
+    cell_store(&deque->cells[bottom & (CZ_DEQUE_SIZE - 1)], task);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+/* Owner: pop the newest task at the bottom, racing thieves for the last one */
+static bool deque_pop(cz_deque_t *deque, cz_task_t *task) {
+    int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+    cell_load(&deque->cells[bottom & (CZ_DEQUE_SIZE - 1)], task);
+    if (top == bottom) {
+        bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                           memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+/* Thief: take the oldest (largest) task at the top, retrying while other thieves win */
+static bool deque_steal(cz_deque_t *deque, cz_task_t *task) {
+    for (;;) {
+        int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        cell_load(&deque->cells[top & (CZ_DEQUE_SIZE - 1)], task);
+        if (atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                    memory_order_seq_cst, memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+/* Append to the shared ring (locked), false when out of memory */
+static bool shared_push(cz_threadpool_t *pool, const cz_task_t *task) {
+    size_t count = atomic_load_explicit(&pool->shared_count, memory_order_relaxed);
+    if (count == pool->shared_cap) {
+        size_t cap = pool->shared_cap * 2;
+        cz_task_t *shared = malloc(cap * sizeof(cz_task_t));
+        if (!shared) {
+            return false;
+        }
+        for (size_t i = 0; i < count; i++) {
+            shared[i] = pool->shared[(pool->shared_head + i) & (pool->shared_cap - 1)];
+        }
+        free(pool->shared);
+        pool->shared = shared;
+        pool->shared_head = 0;
+        pool->shared_cap = cap;
+    }
+    pool->shared[(pool->shared_head + count) & (pool->shared_cap - 1)] = *task;
+    atomic_store_explicit(&pool->shared_count, count + 1, memory_order_release);
+    return true;
+}
+
+/* Take the oldest task of the shared ring (locked) */
+static bool shared_pop(cz_threadpool_t *pool, cz_task_t *task) {
+    size_t count = atomic_load_explicit(&pool->shared_count, memory_order_relaxed);
+    if (count == 0) {
+        return false;
+    }
+    *task = pool->shared[pool->shared_head];
+    pool->shared_head = (pool->shared_head + 1) & (pool->shared_cap - 1);
+    atomic_store_explicit(&pool->shared_count, count - 1, memory_order_relaxed);
+    return true;
+}
+
+/* Next task for self (NULL when not one of the pool's workers): own deque, shared ring, then steal */
+static bool find_task(cz_threadpool_t *pool, cz_worker_t *self, cz_task_t *task) {
+    if (self && deque_pop(&self->deque, task)) {
+        return true;
+    }
+    if (atomic_load_explicit(&pool->shared_count, memory_order_acquire) > 0) {
+        threadpool_lock(pool);
+        bool found = shared_pop(pool, task);
+        threadpool_unlock(pool);
+        if (found) {
+            return true;
+        }
+    }
+    size_t start = (size_t)(next_random(self ? &self->seed : &g_seed) % pool->count);
+    for (size_t i = 0; i < pool->count; i++) {
+        cz_worker_t *victim = &pool->workers[(start + i) % pool->count];
+        if (victim != self && deque_steal(&victim->deque, task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Wake a sleeping worker for a task just queued */
+static void wake_one(cz_threadpool_t *pool) {
+    atomic_fetch_add(&pool->epoch, 1);
+    if (atomic_load(&pool->sleepers) > 0) {
+        threadpool_lock(pool);
+#ifdef CZ_PLATFORM_WINDOWS
+        WakeConditionVariable(&pool->wake);
+#else
+        pthread_cond_signal(&pool->wake);
+#endif
+        threadpool_unlock(pool);
+    }
+}
+
+static void run_task(cz_task_t *task);
+
+/* Queue a task of its group (counted as pending), or run it when it cannot be queued */
+static void spawn_task(cz_task_t *task) {
+    cz_threadpool_t *pool = task->group->pool;
+    atomic_fetch_add_explicit(&task->group->pending, 1, memory_order_relaxed);
+    bool queued = false;
+    if (pool && g_worker && g_worker->pool == pool) {
+        queued = deque_push(&g_worker->deque, task);
+    } else if (pool) {
+        threadpool_lock(pool);
+        queued = shared_push(pool, task);
+        threadpool_unlock(pool);
+    }
+    if (queued) {
+        wake_one(pool);
+    } else {
+        run_task(task);
+    }
+}
+
+/* Split the range in halves down to the grain (queueing the upper ones), then run the rest */
+static void run_range(const cz_task_t *task) {
+    const cz_loop_t *loop = task->ctx;
+    size_t begin = task->begin;
+    size_t end = task->end;
+    while (end - begin > loop->grain) {
+        size_t middle = begin + (end - begin) / 2;
+        cz_task_t upper = { NULL, task->ctx, task->group, middle, end };
+        spawn_task(&upper);
+        end = middle;
+    }
+    loop->fn(begin, end, loop->ctx);
+}
+
+/* Run a task and count it as finished (its group may be gone right after) */
+static void run_task(cz_task_t *task) {
+    if (task->fn) {
+        task->fn(task->ctx);
+    } else {
+        run_range(task);
+    }
+    atomic_fetch_sub_explicit(&task->group->pending, 1, memory_order_acq_rel);
+}
+
+/* Worker thread: run tasks, sleep when none is found for a while, leave once stopping */
+#ifdef CZ_PLATFORM_WINDOWS
+static DWORD WINAPI worker_main(LPVOID arg) {
+#else
+static void *worker_main(void *arg) {
+#endif
+    cz_worker_t *self = arg;
+    cz_threadpool_t *pool = self->pool;
+    g_worker = self;
+
+    unsigned idle = 0;
+    for (;;) {
+        cz_task_t task;
+        if (find_task(pool, self, &task)) {
+            run_task(&task);
+            idle = 0;
+            continue;
+        }
+        if (atomic_load(&pool->stopping)) {
+            break;
+        }
+        if (++idle < CZ_IDLE_SPINS) {
+            thread_yield();
+            continue;
+        }
+
+        /* Spawns after this read change the epoch, so one queued since the search is not missed */
+        size_t epoch = atomic_load(&pool->epoch);
+        if (find_task(pool, self, &task)) {
+            run_task(&task);
+            idle = 0;
+            continue;
+        }
+        threadpool_lock(pool);
+        atomic_fetch_add(&pool->sleepers, 1);
+        while (atomic_load(&pool->epoch) == epoch && !atomic_load(&pool->stopping)) {
+#ifdef CZ_PLATFORM_WINDOWS
+            SleepConditionVariableCS(&pool->wake, &pool->lock, INFINITE);
+#else
+            pthread_cond_wait(&pool->wake, &pool->lock);
+#endif
+        }
+        atomic_fetch_sub(&pool->sleepers, 1);
+        threadpool_unlock(pool);
+        idle = 0;
+    }
+
+    g_worker = NULL;
+    return 0;
+}
+
+/* Start a pool of workers threads (0 for one less than the hardware threads), NULL on failure */
+cz_threadpool_t *cz_threadpool_create(size_t workers) {
+    if (workers == 0) {
+        size_t hardware = hardware_threads();
+        workers = hardware > 1 ? hardware - 1 : 1;
+    }
+
+    cz_threadpool_t *pool = calloc(1, sizeof(cz_threadpool_t));
+    if (!pool) {
+        return NULL;
+    }
+    pool->workers = calloc(workers, sizeof(cz_worker_t));
+    pool->shared_cap = 64;
+    pool->shared = malloc(pool->shared_cap * sizeof(cz_task_t));
+    if (!pool->workers || !pool->shared) {
+        free(pool->workers);
+        free(pool->shared);
+        free(pool);
+        return NULL;
+    }
+    pool->count = workers;
+    atomic_init(&pool->shared_count, 0);
+    atomic_init(&pool->epoch, 0);
+    atomic_init(&pool->sleepers, 0);
+    atomic_init(&pool->stopping, false);
+#ifdef CZ_PLATFORM_WINDOWS
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->wake);
+#else
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+#endif
+
+    for (size_t i = 0; i < workers; i++) {
+        cz_worker_t *worker = &pool->workers[i];
+        atomic_init(&worker->deque.top, 0);
+        atomic_init(&worker->deque.bottom, 0);
+        worker->pool = pool;
+        worker->seed = (uint64_t)(i + 1) * 0x9e3779b97f4a7c15ULL;
+    }
+    for (size_t i = 0; i < workers; i++) {
+        cz_worker_t *worker = &pool->workers[i];
+#ifdef CZ_PLATFORM_WINDOWS
+        worker->thread = CreateThread(NULL, 0, worker_main, worker, 0, NULL);
+        bool started = worker->thread != NULL;
+#else
+        bool started = pthread_create(&worker->thread, NULL, worker_main, worker) == 0;
+#endif
+        if (!started) {
+            cz_threadpool_destroy(pool);
+            return NULL;
+        }
+        pool->started++;
+    }
+    return pool;
+}
+
+/* Stop and join the workers (every group must have been waited for) */
+void cz_threadpool_destroy(cz_threadpool_t *pool) {
+    if (!pool) {
+        return;
+    }
+    threadpool_lock(pool);
+    atomic_store(&pool->stopping, true);
+#ifdef CZ_PLATFORM_WINDOWS
+    WakeAllConditionVariable(&pool->wake);
+#else
+    pthread_cond_broadcast(&pool->wake);
+#endif
+    threadpool_unlock(pool);
+
+    for (size_t i = 0; i < pool->started; i++) {
+#ifdef CZ_PLATFORM_WINDOWS
+        WaitForSingleObject(pool->workers[i].thread, INFINITE);
+        CloseHandle(pool->workers[i].thread);
+#else
+        pthread_join(pool->workers[i].thread, NULL);
+#endif
+    }
+#ifdef CZ_PLATFORM_WINDOWS
+    DeleteCriticalSection(&pool->lock);
+#else
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+#endif
+    free(pool->shared);
+    free(pool->workers);
+    free(pool);
+}
+
+/* Stop the default pool at exit */
+static void destroy_default_at_exit(void) {
+    cz_threadpool_destroy(atomic_exchange(&g_default, NULL));
+}
+
+/* Shared pool started on first use and stopped at exit, NULL on failure */
+cz_threadpool_t *cz_threadpool_default(void) {
+    cz_threadpool_t *pool = atomic_load_explicit(&g_default, memory_order_acquire);
+    if (pool) {
+        return pool;
+    }
+    cz_threadpool_t *created = cz_threadpool_create(0);
+    if (!created) {
+        return NULL;
+    }
+    if (!atomic_compare_exchange_strong(&g_default, &pool, created)) {
+        cz_threadpool_destroy(created);
+        return pool;
+    }
+    atexit(destroy_default_at_exit);
+    return created;
+}
+
+/* Number of worker threads of a pool */
+size_t cz_threadpool_workers(const cz_threadpool_t *pool) {
+    return pool ? pool->count : 0;
+}
+
+/* Attach a group to a pool (NULL for the default pool) */
+void cz_task_group_init(cz_task_group_t *group, cz_threadpool_t *pool) {
+    group->pool = pool ? pool : cz_threadpool_default();
+    atomic_init(&group->pending, 0);
+}
+
+/* Queue fn(ctx) in the group (run right away without a pool) */
+void cz_task_spawn(cz_task_group_t *group, cz_task_fn fn, void *ctx) {
+    cz_task_t task = { fn, ctx, group, 0, 0 };
+    spawn_task(&task);
+}
+
+/* Run queued tasks until every task of the group is finished */
+void cz_task_group_wait(cz_task_group_t *group) {
+    cz_threadpool_t *pool = group->pool;
+    cz_worker_t *self = g_worker && g_worker->pool == pool ? g_worker : NULL;
+    unsigned idle = 0;
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+        cz_task_t task;
+        if (pool && find_task(pool, self, &task)) {
+            run_task(&task);
+            idle = 0;
+        } else if (++idle >= CZ_IDLE_SPINS) {
+            thread_yield();
+        }
+    }
+}
+
+/* Call fn on sub-ranges of [begin, end) in parallel on a pool (NULL for the default pool) */
+void cz_parallel_for_in(cz_threadpool_t *pool, size_t begin, size_t end, size_t grain, cz_range_fn fn, void *ctx) {
+    if (begin >= end) {
+        return;
+    }
+    if (!pool) {
+        pool = cz_threadpool_default();
+    }
+    size_t count = end - begin;
+    if (grain == 0) {
+        /* About 8 ranges per thread (the workers and the caller) */
+        grain = pool ? count / (8 * (pool->count + 1)) : count;
+        grain = grain > 0 ? grain : 1;
+    }
+    if (!pool || count <= grain) {
+        fn(begin, end, ctx);
+        return;
+    }
+
+    /* The caller runs the whole range, queueing halves for the workers, then helps until done */
+    cz_loop_t loop = { fn, ctx, grain };
+    cz_task_group_t group;
+    cz_task_group_init(&group, pool);
+    atomic_store_explicit(&group.pending, 1, memory_order_relaxed);
+    cz_task_t root = { NULL, &loop, &group, begin, end };
+    run_task(&root);
+    cz_task_group_wait(&group);
+}
+
+/* Call fn on sub-ranges of [begin, end) in parallel on the default pool */
+void cz_parallel_for(size_t begin, size_t end, size_t grain, cz_range_fn fn, void *ctx) {
+    cz_parallel_for_in(NULL, begin, end, grain, fn, ctx);
+}
@@ -0,0 +1,196 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Trace implementation - Per-thread timing zones exported as Chrome trace JSON
+ */
+
+#include "cz.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef CZ_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/* One zone boundary: a name opens, NULL closes */
+typedef struct {
+    const char *name;
+    unsigned long long cycles;
+} cz_trace_event_t;
+
+/* Events of one thread, kept after it exits so they are written too */
+typedef struct cz_trace_buffer_s {
+    struct cz_trace_buffer_s *next;
+    unsigned tid;
+    atomic_size_t count;            /* Events published to the writer */
+    unsigned long long dropped;
+    cz_trace_event_t events[CZ_TRACE_EVENTS];
+} cz_trace_buffer_t;
+
+static atomic_bool g_enabled = false;
+static unsigned long long g_start_cycles = 0;
+static atomic_uint g_next_tid = 1;
+static CZ_THREAD_LOCAL cz_trace_buffer_t *t_buffer = NULL;
+
+/* Every thread's buffer, guarded by g_lock */
+static cz_trace_buffer_t *g_buffers = NULL;
+#ifdef CZ_PLATFORM_WINDOWS
+static SRWLOCK g_lock = SRWLOCK_INIT;
+#define TRACE_LOCK() AcquireSRWLockExclusive(&g_lock)
+#define TRACE_UNLOCK() ReleaseSRWLockExclusive(&g_lock)
+#else
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+#define TRACE_LOCK() pthread_mutex_lock(&g_lock)
+#define TRACE_UNLOCK() pthread_mutex_unlock(&g_lock)
+#endif
+
+/* Output path from CZ_TRACE */
+static const char *g_exit_path = NULL;
+
+static void write_at_exit(void) {
+    cz_trace_write(g_exit_path);
+}
+
+#ifdef __GNUC__
+__attribute__((constructor))
+#endif
+static void cz_trace_init(void) {
+    g_exit_path = getenv("CZ_TRACE");
+    if (g_exit_path && *g_exit_path) {
+        cz_trace_enable(true);
+        atexit(write_at_exit);
+    }
+}
+
+/* Start or stop recording */
+void cz_trace_enable(bool enabled) {
+    if (enabled && g_start_cycles == 0) {
+        g_start_cycles = cz_cycles();
+    }
+    atomic_store(&g_enabled, enabled);
+}
+
+/* Buffer of the calling thread, registered on first use (NULL when out of memory) */
+static cz_trace_buffer_t *thread_buffer(void) {
+    if (!t_buffer) {
+        cz_trace_buffer_t *buffer = malloc(sizeof(cz_trace_buffer_t));
+        if (!buffer) {
+            return NULL;
+        }
+        buffer->tid = atomic_fetch_add(&g_next_tid, 1);
+        atomic_init(&buffer->count, 0);
+        buffer->dropped = 0;
+        TRACE_LOCK();
+        buffer->next = g_buffers;
+        g_buffers = buffer;
+        TRACE_UNLOCK();
+        t_buffer = buffer;
+    }
+    return t_buffer;
+}
+
+/* Append one event to the calling thread's buffer */
+static void record(const char *name) {
+    if (!atomic_load_explicit(&g_enabled, memory_order_relaxed)) {
+        return;
+    }
+    cz_trace_buffer_t *buffer = thread_buffer();
+    if (!buffer) {
+        return;
+    }
+    size_t count = atomic_load_explicit(&buffer->count, memory_order_relaxed);
+    if (count >= CZ_TRACE_EVENTS) {
+        buffer->dropped++;
+        return;
+    }
+    buffer->events[count].name = name;
+    buffer->events[count].cycles = cz_cycles();
+    atomic_store_explicit(&buffer->count, count + 1, memory_order_release);
+}
+
+/* Open a zone */
+void cz_trace_begin(const char *name) {
+    record(name ? name : "?");
+}
+
+/* Close the innermost zone */
+void cz_trace_end(void) {
+    record(NULL);
+}
+
+/* Open a zone closed by cz_trace_end() or cz_trace_end_zone() at scope exit */
+void *cz_trace_zone(const char *name) {
+    cz_trace_begin(name);
+    return (void *)name;
+}
+
+/* Cleanup function of a scoped zone */
+void cz_trace_end_zone(void **zone) {
+    (void)zone;
+    cz_trace_end();
+}
+
+/* Write a zone name as a JSON string */
+static void write_name(FILE *out, const char *name) {
+    fputc('"', out);
+    for (const char *p = name; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fputc('\\', out);
+            fputc(*p, out);
+        } else if ((unsigned char)*p < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned)(unsigned char)*p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* Write every thread's events as Chrome/Perfetto trace JSON */
+bool cz_trace_write(const char *path) {
+    if (!path) {
+        return false;
+    }
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        return false;
+    }
+
+    fputs("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n", out);
+    bool first = true;
+    TRACE_LOCK();
+    for (cz_trace_buffer_t *buffer = g_buffers; buffer; buffer = buffer->next) {
+        size_t count = atomic_load_explicit(&buffer->count, memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            const cz_trace_event_t *event = &buffer->events[i];
+            unsigned long long cycles = event->cycles > g_start_cycles ? event->cycles - g_start_cycles : 0;
+            fprintf(out, "%s  {\"ph\": \"%c\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f",
+                    first ? "" : ",\n", event->name ? 'B' : 'E', buffer->tid, cz_cycles_to_ns(cycles) / 1000.0);
+            if (event->name) {
+                fputs(", \"name\": ", out);
+                write_name(out, event->name);
+            }
+            fputc('}', out);
+            first = false;
+        }
+    }
+    TRACE_UNLOCK();
+    fputs("\n]}\n", out);
+    return fclose(out) == 0;
+}
+
+/* Events dropped because a thread's buffer was full */
+unsigned long long cz_trace_dropped(void) {
+    unsigned long long dropped = 0;
+    TRACE_LOCK();
+    for (cz_trace_buffer_t *buffer = g_buffers; buffer; buffer = buffer->next) {
+        dropped += buffer->dropped;
+    }
+    TRACE_UNLOCK();
+    return dropped;
+}
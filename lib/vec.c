@@ -0,0 +1,109 @@
+/*
+ * libCZar - empowering runtime library
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Vec implementation - Growable arrays with geometric growth
+ */
+
+#include "cz.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Initialize an empty vector of size-byte elements */
+void cz_vec_init(cz_vec_t *vec, size_t size) {
+    vec->data = NULL;
+    vec->len = 0;
+    vec->cap = 0;
+    vec->size = size;
+}
+
+/* Make room for count elements in total (capacity at least doubles), false on failure */
+bool cz_vec_reserve(cz_vec_t *vec, size_t count) {
+    if (count <= vec->cap) {
+        return true;
+    }
+    if (vec->size == 0) {
+        return false;
+    }
+
+    /* Doubling keeps pushes amortized O(1) */
+    size_t cap = vec->cap < CZ_VEC_MIN_CAP / 2 ? CZ_VEC_MIN_CAP : vec->cap * 2;
+    if (cap < vec->cap || cap < count) {
+        cap = count;
+    }
+    if (cap > SIZE_MAX / vec->size) {
+        return false; /* Overflow */
+    }
+    void *data = realloc(vec->data, cap * vec->size);
+    if (!data) {
+        return false;
+    }
+    vec->data = data;
+    vec->cap = cap;
+    return true;
+}
+
+/* Set the length, new elements are zeroed, false on failure */
+bool cz_vec_resize(cz_vec_t *vec, size_t len) {
+    if (len > vec->len) {
+        if (!cz_vec_reserve(vec, len)) {
+            return false;
+        }
+        memset((char *)vec->data + vec->len * vec->size, 0, (len - vec->len) * vec->size);
+    }
+    vec->len = len;
+    return true;
+}
+
+/* Give back the capacity beyond the length (all of it when empty) */
+void cz_vec_shrink(cz_vec_t *vec) {
+    if (vec->len == vec->cap) {
+        return;
+    }
+    if (vec->len == 0) {
+        free(vec->data);
+        vec->data = NULL;
+        vec->cap = 0;
+        return;
+    }
+    void *data = realloc(vec->data, vec->len * vec->size);
+    if (data) {
+        vec->data = data;
+        vec->cap = vec->len;
+    }
+}
+
+/* Copy count elements at the end, false on failure */
+bool cz_vec_append(cz_vec_t *vec, const void *elements, size_t count) {
+    if (count > SIZE_MAX - vec->len || !cz_vec_reserve(vec, vec->len + count)) {
+        return false;
+    }
+    if (count > 0) {
+        memcpy((char *)vec->data + vec->len * vec->size, elements, count * vec->size);
+        vec->len += count;
+    }
+    return true;
+}
+
+/* Free the elements, the vector stays usable and empty */
+void cz_vec_free(cz_vec_t *vec) {
+    free(vec->data);
+    vec->data = NULL;
+    vec->len = 0;
+    vec->cap = 0;
+}
+
+/* Move the elements out without copying: the returned vector owns them, vec is left empty */
+cz_vec_t cz_vec_move(cz_vec_t *vec) {
+    cz_vec_t moved = *vec;
+    vec->data = NULL;
+    vec->len = 0;
+    vec->cap = 0;
+    return moved;
+}
+
+/* Take the buffer out (free() it), vec is left empty */
+void *cz_vec_take(cz_vec_t *vec) {
+    return cz_vec_move(vec).data;
+}
@@ -12,210 +12,390 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
-#include "lexer.h"
-#include "parser.h"
-#include "transpiler.h"
+#include <errno.h>
+#include <sys/stat.h>
+#include "transpile.h"
+#include "serve.h"
+#include "amalgamate.h"
+#include "driver.h"
+#include "profile.h"
+#include "stats.h"
+#include "cache.h"
+#include "dirlist.h"
+#include "siblings.h"
+#include "worker.h"
+#include "features.h"
 #include "src/errors.h"
+#include "src/headers.h"
+#include "src/structs.h"
 
-bool transpile(const char *input_file) {
-    /* Generate output file names */
-    size_t input_len = strlen(input_file);
+/* Files and settings shared by the transpile jobs of one run */
+typedef struct {
+    const char **files;          /* Input files in command-line order */
+    SymbolTable *symbols;        /* Interner shared by a serial run (NULL for one per file) */
+    const char *cache_dir;       /* Incremental cache directory (NULL when caching is off) */
+    bool dependencies;           /* Write a .cz.d dependency file per input (-MD) */
+    bool minimal_headers;        /* Forward declare opaque structs, include only referenced siblings */
+    bool compact;                /* Strip comments and redundant whitespace from the outputs */
+    bool trace;                  /* Open a libczar trace zone in every exported function */
+    const char *output_dir;      /* Write the outputs below this directory (NULL for next to each input) */
+    OutputSink_t *stream;        /* Collect the header and source of the input here (--stdout, NULL for files) */
+    bool profiling;              /* Record a profile per file */
+    ProfileFormat profile_format; /* Format of profile reports */
+    Profile_t *profiles;         /* Per-file profiles (profiling only) */
+    bool stats;                  /* Record memory stats per file (--stats) */
+    ProfileFormat stats_format;  /* Format of stats reports */
+    Stats_t *file_stats;         /* Per-file stats (stats only) */
+    bool layout_report;          /* Print the estimated layout of every struct (--layout-report) */
+} TranspileRun_t;
 
-    /* Check for overflow: input_len + 3 should not overflow */
-    if (input_len > SIZE_MAX - 3) {
-        cz_error(NULL, NULL, 0, "Input filename too long");
-        return false;
+/* Create the missing parent directories of path (errors surface when the output is written) */
+static void make_parent_directories(char *path) {
+    for (char *p = path + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path, 0777) != 0 && errno != EEXIST) {
+                *p = '/';
+                return;
+            }
+            *p = '/';
+        }
     }
+}
 
-    char *header_file = malloc(input_len + 3);  /* input_file + .h + \0 */
-    char *source_file = malloc(input_len + 3);  /* input_file + .c + \0 */
-
-    if (!header_file || !source_file) {
-        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
-        free(header_file);
-        free(source_file);
-        return false;
+/* Build the output base of input_file below output_dir and create its directories: the input's
+ * relative path, or its file name for absolute paths and paths leaving the working directory */
+static char *output_base_in(const char *output_dir, const char *input_file) {
+    const char *relative = input_file;
+    while (strncmp(relative, "./", 2) == 0) {
+        relative += 2;
     }
-
-    snprintf(header_file, input_len + 3, "%s.h", input_file);
-    snprintf(source_file, input_len + 3, "%s.c", input_file);
-
-    /* Extract just the filename for the include directive */
-    const char *filename_only = strrchr(input_file, '/');
-    filename_only = filename_only ? filename_only + 1 : input_file;
-    size_t filename_len = strlen(filename_only);
-
-    /* Check for overflow: filename_len + 3 should not overflow */
-    if (filename_len > SIZE_MAX - 3) {
-        cz_error(NULL, NULL, 0, "Filename too long");
-        free(header_file);
-        free(source_file);
-        return false;
+    if (relative[0] == '/' || strncmp(relative, "../", 3) == 0 || strstr(relative, "/../")) {
+        const char *slash = strrchr(relative, '/');
+        relative = slash ? slash + 1 : relative;
     }
-
-    char *header_name = malloc(filename_len + 3);
-    if (!header_name) {
+    size_t len = strlen(output_dir) + strlen(relative) + 2;
+    char *output_base = malloc(len);
+    if (!output_base) {
         cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
-        free(header_file);
-        free(source_file);
-        return false;
+        return NULL;
     }
-    snprintf(header_name, filename_len + 3, "%s.h", filename_only);
+    snprintf(output_base, len, "%s/%s", output_dir, relative);
+    make_parent_directories(output_base);
+    return output_base;
+}
 
-    /* Open input file */
-    FILE *input = fopen(input_file, "r");
-    if (!input) {
-        char error_msg[512];
-        snprintf(error_msg, sizeof(error_msg), ERR_CANNOT_OPEN_INPUT_FILE, input_file);
-        cz_error(NULL, NULL, 0, error_msg);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+/* Transpile one file of the run */
+static bool transpile_job(size_t index, void *context) {
+    TranspileRun_t *run = (TranspileRun_t *)context;
+    char *output_base = NULL;
+    SymbolTable local_symbols;
+    SymbolTable *symbols = run->symbols;
+    if (!symbols) {
+        symbols_init(&local_symbols);
+        symbols = &local_symbols;
     }
-
-    /* Read entire input file into memory */
-    if (fseek(input, 0, SEEK_END) != 0) {
-        cz_error(NULL, NULL, 0, ERR_FAILED_TO_SEEK_INPUT_FILE);
-        fclose(input);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+    if (run->profiling) {
+        g_profile = &run->profiles[index];
+        g_profile->files = 1;
     }
-
-    long input_size = ftell(input);
-    if (input_size < 0) {
-        cz_error(NULL, NULL, 0, ERR_FAILED_TO_GET_INPUT_FILE_SIZE);
-        fclose(input);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+    if (run->stats) {
+        g_stats = &run->file_stats[index];
+        g_stats->files = 1;
     }
-
-    /* Handle empty input file */
-    if (input_size == 0) {
-        fclose(input);
-        /* For empty input, create empty output files */
-        FILE *h_out = fopen(header_file, "w");
-        FILE *c_out = fopen(source_file, "w");
-        if (h_out) fclose(h_out);
-        if (c_out) fclose(c_out);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return 0;
+    if (run->layout_report) {
+        g_layout_report = worker_stderr();
     }
 
-    if (fseek(input, 0, SEEK_SET) != 0) {
-        cz_error(NULL, NULL, 0, ERR_FAILED_TO_SEEK_INPUT_FILE);
-        fclose(input);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+    TranspileRequest_t request;
+    request.input_file = run->files[index];
+    request.output_base = NULL;
+    if (run->output_dir) {
+        output_base = output_base_in(run->output_dir, run->files[index]);
+        request.output_base = output_base;
     }
+    request.data = NULL;
+    request.size = 0;
+    request.record = NULL;
+    request.dependencies = run->dependencies;
+    request.minimal_headers = run->minimal_headers;
+    request.compact = run->compact;
+    request.trace = run->trace;
+    request.header_output = NULL;
+    request.source_output = NULL;
+    request.stream_output = run->stream;
+    bool ok = transpile(&request, symbols, run->cache_dir);
+    free(output_base);
+    g_layout_report = NULL;
 
-    char *input_buffer = malloc(input_size + 1);
-    if (!input_buffer) {
-        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
-        fclose(input);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+    if (run->profiling) {
+        g_profile = NULL;
+        profile_print(worker_stderr(), &run->profiles[index], run->files[index], run->profile_format);
     }
-
-    size_t bytes_read = fread(input_buffer, 1, input_size, input);
-    input_buffer[bytes_read] = '\0';
-    fclose(input);
-
-    /* Initialize lexer */
-    Lexer lexer;
-    lexer_init(&lexer, input_buffer, bytes_read);
-
-    /* Initialize parser */
-    Parser parser;
-    parser_init(&parser, &lexer);
-
-    /* Parse input into AST */
-    ASTNode_t *ast = parser_parse(&parser);
-    if (!ast) {
-        cz_error(NULL, NULL, 0, ERR_FAILED_TO_PARSE_INPUT);
-        free(input_buffer);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+    if (run->stats) {
+        g_stats = NULL;
+        stats_print(worker_stderr(), &run->file_stats[index], run->files[index], run->stats_format);
     }
-
-    /* Initialize transpiler */
-    Transpiler_t transpiler;
-    transpiler_init(&transpiler, ast, input_file, input_buffer);
-
-    /* Transform AST */
-    transpiler_transform(&transpiler);
-
-    /* Open header output file */
-    FILE *h_output = fopen(header_file, "w");
-    if (!h_output) {
-        char error_msg[512];
-        snprintf(error_msg, sizeof(error_msg), ERR_CANNOT_OPEN_OUTPUT_FILE, header_file);
-        cz_error(NULL, NULL, 0, error_msg);
-        ast_node_free(ast);
-        free(input_buffer);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+    if (symbols == &local_symbols) {
+        symbols_free(&local_symbols);
     }
+    return ok;
+}
 
-    /* Emit header file */
-    transpiler_emit_header(&transpiler, h_output);
-    fclose(h_output);
+/* Print usage to stderr */
+static void usage(const char *program) {
+    fprintf(stderr, "Usage: %s [-j N] [-MD] [-o DIR] [--minimal-headers] [--compact] [--trace] [--cache[=DIR]] [--profile[=table|json]] [--stats[=table|json]] [--layout-report] [--disable=F,...|--only=F,...] <input_file.cz ...>\n", program);
+    fprintf(stderr, "       %s --serve [-MD] [--minimal-headers] [--compact] [--cache[=DIR]]\n", program);
+    fprintf(stderr, "       %s --stdout [--minimal-headers] [--compact] [--trace] [--layout-report] <input_file.cz>\n", program);
+    fprintf(stderr, "       %s --amalgamate <module_dir>\n", program);
+    fprintf(stderr, "       %s cc [-j N] [cc flags] <input_file.cz ...> [-c | -o output] (see driver.h)\n", program);
+    fprintf(stderr, "Generates .cz.h and .cz.c files\n");
+    fprintf(stderr, "  -j N                Transpile up to N files in parallel (0 for one per CPU)\n");
+    fprintf(stderr, "  -MD                 Write a make rule of every file read or included to <input_file>.cz.d\n");
+    fprintf(stderr, "  -o DIR              Write the outputs below DIR instead of next to each input\n");
+    fprintf(stderr, "  -o -, --stdout      Write the header then the source to stdout as one translation unit\n");
+    fprintf(stderr, "  --minimal-headers   Forward declare structs headers only use by pointer, include only referenced siblings\n");
+    fprintf(stderr, "  --compact           Drop comments and whitespace the generated C does not need (lines are\n");
+    fprintf(stderr, "                      joined: __LINE__ and compiler diagnostics report lines of the compacted file)\n");
+    fprintf(stderr, "  --trace             Open a trace zone in every exported function (link libczar, run with CZ_TRACE=file.json)\n");
+    fprintf(stderr, "  --cache[=DIR]       Skip inputs unchanged since the last run (default DIR: %s)\n", CACHE_DEFAULT_DIR);
+    fprintf(stderr, "  --profile[=FORMAT]  Print time and counters per phase and feature to stderr\n");
+    fprintf(stderr, "  --stats[=FORMAT]    Print tokens, AST nodes and bytes held per file (token text, symbol tables, peak RSS) to stderr\n");
+    fprintf(stderr, "  --layout-report     Print the estimated size, alignment and padding holes of every struct to stderr\n");
+    fprintf(stderr, "  --disable=F,...     Skip these features (names or unique prefixes, see --profile)\n");
+    fprintf(stderr, "  --only=F,...        Run only these features\n");
+    fprintf(stderr, "  --serve             Transpile requests read from stdin until 'quit' (see serve.h)\n");
+    fprintf(stderr, "  --amalgamate        Transpile a module directory into one <module_dir>.cz.h and .cz.c\n");
+}
 
-    /* Open source output file */
-    FILE *c_output = fopen(source_file, "w");
-    if (!c_output) {
-        char error_msg[512];
-        snprintf(error_msg, sizeof(error_msg), ERR_CANNOT_OPEN_OUTPUT_FILE, source_file);
-        cz_error(NULL, NULL, 0, error_msg);
-        ast_node_free(ast);
-        free(input_buffer);
-        free(header_file);
-        free(source_file);
-        free(header_name);
-        return false;
+int main(int argc, char *argv[]) {
+    /* The compiler driver takes compiler flags, not cz options */
+    if (argc > 1 && strcmp(argv[1], "cc") == 0) {
+        return driver_cc(argc - 2, argv + 2);
     }
 
-    /* Emit source file */
-    transpiler_emit_source(&transpiler, c_output, header_name);
-    fclose(c_output);
-
-    fprintf(stdout, "%s %s\n", header_file, source_file);
+    bool profiling = false;
+    ProfileFormat profile_format = PROFILE_FORMAT_TABLE;
+    bool stats = false;
+    ProfileFormat stats_format = PROFILE_FORMAT_TABLE;
+    unsigned jobs = 1;
+    const char *cache_dir = NULL;
+    bool serving = false;
+    bool amalgamating = false;
+    bool dependencies = false;
+    bool minimal_headers = false;
+    bool compact = false;
+    bool trace = false;
+    bool streaming = false;
+    bool layout_report = false;
+    const char *output_dir = NULL;
+    const char **files = malloc((size_t)argc * sizeof(const char *));
+    size_t file_count = 0;
+    if (!files) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        return 1;
+    }
 
-    /* Clean up */
-    transpiler_cleanup(&transpiler);
-    ast_node_free(ast);
-    free(input_buffer);
-    free(header_file);
-    free(source_file);
-    free(header_name);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--profile") == 0 || strcmp(argv[i], "--profile=table") == 0) {
+            profiling = true;
+        } else if (strcmp(argv[i], "--profile=json") == 0) {
+            profiling = true;
+            profile_format = PROFILE_FORMAT_JSON;
+        } else if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=table") == 0) {
+            stats = true;
+        } else if (strcmp(argv[i], "--stats=json") == 0) {
+            stats = true;
+            stats_format = PROFILE_FORMAT_JSON;
+        } else if (strcmp(argv[i], "-MD") == 0) {
+            dependencies = true;
+        } else if (strcmp(argv[i], "--minimal-headers") == 0) {
+            minimal_headers = true;
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            compact = true;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace = true;
+        } else if (strcmp(argv[i], "--layout-report") == 0) {
+            layout_report = true;
+        } else if (strcmp(argv[i], "--stdout") == 0) {
+            streaming = true;
+        } else if (strncmp(argv[i], "-o", 2) == 0) {
+            const char *value = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : NULL);
+            if (!value || !*value) {
+                fprintf(stderr, "[CZ] Missing output directory for -o\n");
+                usage(argv[0]);
+                free(files);
+                return 1;
+            }
+            if (strcmp(value, "-") == 0) {
+                streaming = true;
+            } else {
+                output_dir = value;
+            }
+        } else if (strcmp(argv[i], "--serve") == 0) {
+            serving = true;
+        } else if (strcmp(argv[i], "--amalgamate") == 0) {
+            amalgamating = true;
+        } else if (strcmp(argv[i], "--cache") == 0) {
+            cache_dir = CACHE_DEFAULT_DIR;
+        } else if (strncmp(argv[i], "--cache=", 8) == 0 && argv[i][8]) {
+            cache_dir = argv[i] + 8;
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            const char *value = argv[i][2] ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : NULL);
+            if (!worker_parse_jobs(value, &jobs)) {
+                fprintf(stderr, "[CZ] Invalid job count for -j\n");
+                usage(argv[0]);
+                free(files);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--disable=", 10) == 0 || strncmp(argv[i], "--only=", 7) == 0) {
+            bool only = argv[i][2] == 'o';
+            char unknown[64];
+            if (!features_select(strchr(argv[i], '=') + 1, only, unknown, sizeof(unknown))) {
+                fprintf(stderr, "[CZ] Unknown feature '%s' for %s\n", unknown, only ? "--only" : "--disable");
+                usage(argv[0]);
+                free(files);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            fprintf(stderr, "[CZ] Unknown option '%s'\n", argv[i]);
+            usage(argv[0]);
+            free(files);
+            return 1;
+        } else {
+            files[file_count++] = argv[i];
+        }
+    }
+    if (amalgamating) {
+        const char *directory = file_count == 1 ? files[0] : NULL;
+        free(files);
+        if (!directory || serving || dependencies || minimal_headers || compact || trace || streaming || output_dir || cache_dir || profiling || stats || layout_report) {
+            fprintf(stderr, "[CZ] --amalgamate takes one module directory and no other mode\n");
+            usage(argv[0]);
+            return 1;
+        }
+        SymbolTable symbols;
+        symbols_init(&symbols);
+        bool ok = amalgamate(directory, &symbols);
+        symbols_free(&symbols);
+        transpiler_free_header_index();
+        dir_listing_clear();
+        return ok ? 0 : 1;
+    }
+    if (serving) {
+        free(files);
+        if (file_count > 0 || profiling || stats || streaming || output_dir || layout_report || trace) {
+            fprintf(stderr, "[CZ] --serve reads its input files from stdin\n");
+            usage(argv[0]);
+            return 1;
+        }
+        return serve(stdin, cache_dir, dependencies, minimal_headers, compact);
+    }
+    if (file_count == 0) {
+        usage(argv[0]);
+        free(files);
+        return 1;
+    }
+    if (layout_report && cache_dir) {
+        /* Cached inputs are never transformed, so they would go unreported */
+        fprintf(stderr, "[CZ] --layout-report transpiles every input, without --cache\n");
+        usage(argv[0]);
+        free(files);
+        return 1;
+    }
+    if (streaming && (file_count > 1 || dependencies || cache_dir || output_dir)) {
+        fprintf(stderr, "[CZ] --stdout writes one input and no files\n");
+        usage(argv[0]);
+        free(files);
+        return 1;
+    }
 
-    return true;
-}
+    /* A serial run shares one interner, workers each intern per file */
+    SymbolTable symbols;
+    symbols_init(&symbols);
+    TranspileRun_t run;
+    run.files = files;
+    run.symbols = jobs > 1 && file_count > 1 ? NULL : &symbols;
+    run.cache_dir = cache_dir;
+    run.dependencies = dependencies;
+    run.minimal_headers = minimal_headers;
+    run.compact = compact;
+    run.trace = trace;
+    run.output_dir = output_dir;
+    run.stream = NULL;
+    OutputSink_t stream;
+    if (streaming) {
+        /* Collected in memory: a failed transpile writes nothing to stdout */
+        sink_init(&stream, NULL);
+        run.stream = &stream;
+    }
+    run.profiling = profiling;
+    run.profile_format = profile_format;
+    run.profiles = NULL;
+    run.stats = stats;
+    run.stats_format = stats_format;
+    run.file_stats = NULL;
+    run.layout_report = layout_report;
+    if (profiling) {
+        run.profiles = malloc(file_count * sizeof(Profile_t));
+        if (!run.profiles) {
+            cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        }
+        for (size_t i = 0; i < file_count; i++) {
+            profile_init(&run.profiles[i]);
+        }
+    }
+    if (stats) {
+        run.file_stats = malloc(file_count * sizeof(Stats_t));
+        if (!run.file_stats) {
+            cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        }
+        for (size_t i = 0; i < file_count; i++) {
+            stats_init(&run.file_stats[i]);
+        }
+    }
 
-int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <input_file.cz ...>\n", argv[0]);
-        fprintf(stderr, "Generates .cz.h and .cz.c files\n");
-        return 1;
+    bool ok = worker_run(file_count, jobs, transpile_job, &run);
+    if (streaming) {
+        if (ok && (stream.failed || fwrite(stream.data, 1, stream.length, stdout) != stream.length || fflush(stdout) != 0)) {
+            fprintf(stderr, "[CZ] Failed to write to stdout\n");
+            ok = false;
+        }
+        sink_free(&stream);
     }
+    symbols_free(&symbols);
+    transpiler_free_header_index();
+    dir_listing_clear();
+    sibling_names_clear();
 
-    for (int i = 1; i < argc; i++) {
-        transpile(argv[i]);
+    /* Totals are only worth a report when several files were given */
+    if (profiling) {
+        Profile_t total_profile;
+        profile_init(&total_profile);
+        for (size_t i = 0; i < file_count; i++) {
+            profile_merge(&total_profile, &run.profiles[i]);
+            profile_free(&run.profiles[i]);
+        }
+        if (ok && file_count > 1) {
+            profile_print(stderr, &total_profile, "total", profile_format);
+        }
+        profile_free(&total_profile);
+        free(run.profiles);
+    }
+    if (stats) {
+        Stats_t total_stats;
+        stats_init(&total_stats);
+        for (size_t i = 0; i < file_count; i++) {
+            stats_merge(&total_stats, &run.file_stats[i]);
+            stats_free(&run.file_stats[i]);
+        }
+        if (ok && file_count > 1) {
+            stats_print(stderr, &total_stats, "total", stats_format);
+        }
+        stats_free(&total_stats);
+        free(run.file_stats);
     }
+    free(files);
 
-    return 0;
+    return ok ? 0 : 1;
 }
@@ -7,37 +7,76 @@
  */
 
 #include "parser.h"
+#include "profile.h"
+#include "worker.h"
 #include "src/errors.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
+/* Arena of the parser currently building or owning the AST */
+static CZ_THREAD_LOCAL Arena_t *ast_arena = NULL;
+
+/* Node arena block size (a few thousand nodes per block) */
+#define AST_ARENA_BLOCK_SIZE (256 * 1024)
+
 /* Initialize parser with lexer */
 void parser_init(Parser *parser, Lexer *lexer) {
     parser->lexer = lexer;
     parser->current_token.type = TOKEN_EOF;
     parser->current_token.text = NULL;
     parser->current_token.length = 0;
+    parser->current_token.is_view = 0;
+    parser->current_token.symbol = SYM_NONE;
+    parser->lex_ns = 0;
+
+    /* Nodes and rewritten token text come from the parser arena */
+    arena_init(&parser->arena, AST_ARENA_BLOCK_SIZE);
+    ast_arena = &parser->arena;
+    token_use_arena(&parser->arena);
+}
+
+/* Release the parser arena (all AST nodes become invalid) */
+void parser_cleanup(Parser *parser) {
+    if (ast_arena == &parser->arena) {
+        ast_arena = NULL;
+        token_use_arena(NULL);
+    }
+    arena_free(&parser->arena);
 }
 
 /* Create new AST node */
 static ASTNode_t *ast_node_create(ASTNodeType type) {
-    ASTNode_t *node = malloc(sizeof(ASTNode_t));
+    /* Arena memory is zeroed: no children, empty EOF token (SYM_NONE) */
+    ASTNode_t *node = arena_alloc(ast_arena, sizeof(ASTNode_t));
     if (!node) {
         return NULL;
     }
 
     node->type = type;
-    node->children = NULL;
-    node->child_count = 0;
-    node->child_capacity = 0;
-
-    /* Initialize token fields */
     node->token.type = TOKEN_EOF;
-    node->token.text = NULL;
-    node->token.length = 0;
-    node->token.line = 0;
-    node->token.column = 0;
+
+    return node;
+}
+
+/* Create a token node (text copied) from the current AST arena */
+ASTNode_t *ast_token_create(TokenType type, const char *text, int line, int column) {
+    ASTNode_t *node = ast_node_create(AST_TOKEN);
+    if (!node || !text) {
+        return NULL;
+    }
+
+    size_t length = strlen(text);
+    node->token.text = arena_strndup(ast_arena, text, length);
+    if (!node->token.text) {
+        return NULL;
+    }
+    node->token.type = type;
+    node->token.length = length;
+    node->token.is_view = 1;
+    node->token.symbol = symbols_keyword(node->token.text, length);
+    node->token.line = line;
+    node->token.column = column;
 
     return node;
 }
@@ -48,7 +87,7 @@ static void ast_node_add_child(ASTNode_t *parent, ASTNode_t *child) {
         return;
     }
 
-    /* Grow children array if needed */
+    /* Grow children array if needed (kept on the heap: features resize it) */
     if (parent->child_count >= parent->child_capacity) {
         size_t new_capacity = parent->child_capacity == 0 ? 8 : parent->child_capacity * 2;
         ASTNode_t **new_children = realloc(parent->children, new_capacity * sizeof(ASTNode_t *));
@@ -64,24 +103,185 @@ static void ast_node_add_child(ASTNode_t *parent, ASTNode_t *child) {
     parent->children[parent->child_count++] = child;
 }
 
-/* Free AST node and all children */
+/* Classify a bracket token: 0-2 for ( [ {, 3-5 for ) ] }, -1 for anything else */
+static int bracket_kind(const ASTNode_t *node) {
+    if (node->type != AST_TOKEN || node->token.type != TOKEN_PUNCTUATION ||
+        node->token.length != 1 || !node->token.text) {
+        return -1;
+    }
+    switch (node->token.text[0]) {
+        case '(': return 0;
+        case '[': return 1;
+        case '{': return 2;
+        case ')': return 3;
+        case ']': return 4;
+        case '}': return 5;
+        default: return -1;
+    }
+}
+
+/* Unclosed brackets, one stack per kind so each kind nests independently */
+typedef struct {
+    size_t *open[3];
+    size_t depth[3];
+    size_t capacity[3];
+} BracketStacks;
+
+/* Record the bracket match of child index in matches */
+static void bracket_track(BracketStacks *stacks, size_t *matches, const ASTNode_t *child, size_t index) {
+    matches[index] = AST_NO_MATCH;
+
+    int kind = bracket_kind(child);
+    if (kind < 0) {
+        return;
+    }
+
+    if (kind < 3) {
+        if (stacks->depth[kind] >= stacks->capacity[kind]) {
+            size_t new_capacity = stacks->capacity[kind] == 0 ? 64 : stacks->capacity[kind] * 2;
+            size_t *new_open = realloc(stacks->open[kind], new_capacity * sizeof(size_t));
+            if (!new_open) {
+                cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+                return;
+            }
+            stacks->open[kind] = new_open;
+            stacks->capacity[kind] = new_capacity;
+        }
+        stacks->open[kind][stacks->depth[kind]++] = index;
+        return;
+    }
+
+    kind -= 3;
+    if (stacks->depth[kind] > 0) {
+        size_t open = stacks->open[kind][--stacks->depth[kind]];
+        matches[open] = index;
+        matches[index] = open;
+    }
+}
+
+/* Release bracket stacks */
+static void bracket_stacks_free(BracketStacks *stacks) {
+    for (int kind = 0; kind < 3; kind++) {
+        free(stacks->open[kind]);
+    }
+}
+
+/* Rebuild the bracket table of parent from its current children */
+static void build_matches(ASTNode_t *parent) {
+    size_t *matches = realloc(parent->matches, (parent->child_count + 1) * sizeof(size_t));
+    if (!matches) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        return;
+    }
+
+    BracketStacks stacks = {{NULL, NULL, NULL}, {0, 0, 0}, {0, 0, 0}};
+    for (size_t i = 0; i < parent->child_count; i++) {
+        bracket_track(&stacks, matches, parent->children[i], i);
+    }
+    bracket_stacks_free(&stacks);
+
+    parent->matches = matches;
+    parent->matches_generation = token_bracket_generation();
+}
+
+/* Get the index of the bracket matching parent->children[index], or AST_NO_MATCH */
+size_t ast_match(ASTNode_t *parent, size_t index) {
+    if (!parent || index >= parent->child_count) {
+        return AST_NO_MATCH;
+    }
+
+    /* Rewrites that add, remove or retype brackets make the table stale */
+    if (!parent->matches || parent->matches_generation != token_bracket_generation()) {
+        build_matches(parent);
+    }
+    return parent->matches[index];
+}
+
+/* Drop the bracket table of parent (rebuilt on the next ast_match) */
+void ast_invalidate_matches(ASTNode_t *parent) {
+    if (!parent) {
+        return;
+    }
+    free(parent->matches);
+    parent->matches = NULL;
+}
+
+/* Bumped whenever children are relinked (parse, rewrite commit), so tables keyed by child index go stale */
+static CZ_THREAD_LOCAL unsigned long structure_generation = 0;
+
+/* Get the structure generation (changes whenever any parent's children are relinked) */
+unsigned long ast_structure_generation(void) {
+    return structure_generation;
+}
+
+/* Check if a child is whitespace or a comment */
+static int is_trivia(const ASTNode_t *node) {
+    return node->type == AST_TOKEN &&
+           (node->token.type == TOKEN_WHITESPACE || node->token.type == TOKEN_COMMENT);
+}
+
+/* Link every child of parent to its nearest non-trivia siblings (after parse and each rewrite) */
+void ast_link_significant(ASTNode_t *parent) {
+    structure_generation++;
+    if (!parent || parent->child_count == 0) {
+        return;
+    }
+
+    size_t next = parent->child_count;
+    for (size_t i = parent->child_count; i-- > 0;) {
+        if (!is_trivia(parent->children[i])) {
+            next = i;
+        }
+        parent->children[i]->next_significant = next;
+    }
+
+    size_t prev = AST_NO_MATCH;
+    for (size_t i = 0; i < parent->child_count; i++) {
+        if (!is_trivia(parent->children[i])) {
+            prev = i;
+        }
+        parent->children[i]->prev_significant = prev;
+    }
+}
+
+/* Skip whitespace and comment children from index, returns count if none are left */
+size_t ast_skip_trivia(ASTNode_t **children, size_t count, size_t index) {
+    if (index >= count) {
+        return count;
+    }
+    if (!is_trivia(children[index])) {
+        return index;
+    }
+    size_t next = children[index]->next_significant;
+    return next < count ? next : count;
+}
+
+/* Get the index of the last non-trivia child before index, or AST_NO_MATCH */
+size_t ast_prev_significant(ASTNode_t **children, size_t index) {
+    if (index == 0) {
+        return AST_NO_MATCH;
+    }
+    return children[index - 1]->prev_significant;
+}
+
+/* Free AST node resources (node memory is released by parser_cleanup) */
 void ast_node_free(ASTNode_t *node) {
     if (!node) {
         return;
     }
 
-    /* Free children recursively */
+    /* Release heap-owned token text of children, then the children array */
     for (size_t i = 0; i < node->child_count; i++) {
         ast_node_free(node->children[i]);
     }
     free(node->children);
+    ast_invalidate_matches(node);
+    node->children = NULL;
+    node->child_count = 0;
+    node->child_capacity = 0;
 
-    /* Free token text */
-    if (node->token.text) {
-        free(node->token.text);
-    }
-
-    free(node);
+    /* Free token text (views are released with the lexer or arena) */
+    token_free(&node->token);
 }
 
 /* Parse input into AST */
@@ -92,10 +292,18 @@ ASTNode_t *parser_parse(Parser *parser) {
         return NULL;
     }
 
-    /* Parse all tokens into the AST */
+    /* Parse all tokens into the AST, matching brackets as they arrive */
+    BracketStacks stacks = {{NULL, NULL, NULL}, {0, 0, 0}, {0, 0, 0}};
+    size_t matches_capacity = 0;
     Token token;
     while (1) {
-        token = lexer_next_token(parser->lexer);
+        if (g_profile) {
+            unsigned long long start = profile_clock_ns();
+            token = lexer_next_token(parser->lexer);
+            parser->lex_ns += profile_clock_ns() - start;
+        } else {
+            token = lexer_next_token(parser->lexer);
+        }
 
         if (token.type == TOKEN_EOF) {
             token_free(&token);
@@ -106,6 +314,7 @@ ASTNode_t *parser_parse(Parser *parser) {
         ASTNode_t *token_node = ast_node_create(AST_TOKEN);
         if (!token_node) {
             token_free(&token);
+            bracket_stacks_free(&stacks);
             ast_node_free(root);
             return NULL;
         }
@@ -115,7 +324,21 @@ ASTNode_t *parser_parse(Parser *parser) {
 
         /* Add token node to root */
         ast_node_add_child(root, token_node);
+
+        /* Keep the bracket table as large as the children array */
+        if (root->child_capacity > matches_capacity) {
+            size_t *matches = realloc(root->matches, root->child_capacity * sizeof(size_t));
+            if (!matches) {
+                cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+            }
+            root->matches = matches;
+            matches_capacity = root->child_capacity;
+        }
+        bracket_track(&stacks, root->matches, token_node, root->child_count - 1);
     }
 
+    bracket_stacks_free(&stacks);
+    root->matches_generation = token_bracket_generation();
+    ast_link_significant(root);
     return root;
 }
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "lexer.h"
+#include "arena.h"
 #include <stddef.h>
 
 /* AST Node types */
@@ -24,19 +25,52 @@ typedef struct ASTNode_s {
     struct ASTNode_s **children; /* Child nodes */
     size_t child_count;       /* Number of children */
     size_t child_capacity;    /* Capacity of children array */
+    size_t *matches;          /* Matching bracket index per child (see ast_match) */
+    unsigned long matches_generation; /* Bracket generation matches was built for */
+    size_t next_significant;  /* First non-trivia sibling index at or after this one */
+    size_t prev_significant;  /* Last non-trivia sibling index at or before this one, or AST_NO_MATCH */
 } ASTNode_t;
 
+/* Index returned by ast_match for children without a matching bracket */
+#define AST_NO_MATCH ((size_t)-1)
+
 /* Parser structure */
 typedef struct {
     Lexer *lexer;
     Token current_token;
+    Arena_t arena;            /* Backs every AST node of the translation unit */
+    unsigned long long lex_ns; /* Time spent in the lexer while profiling */
 } Parser;
 
 /* Initialize parser with lexer */
 void parser_init(Parser *parser, Lexer *lexer);
 
+/* Release the parser arena (all AST nodes become invalid) */
+void parser_cleanup(Parser *parser);
+
 /* Parse input into AST */
 ASTNode_t *parser_parse(Parser *parser);
 
-/* Free AST node and all children */
+/* Create a token node (text copied) from the current AST arena */
+ASTNode_t *ast_token_create(TokenType type, const char *text, int line, int column);
+
+/* Get the index of the bracket matching parent->children[index], or AST_NO_MATCH */
+size_t ast_match(ASTNode_t *parent, size_t index);
+
+/* Drop the bracket table of parent (rebuilt on the next ast_match) */
+void ast_invalidate_matches(ASTNode_t *parent);
+
+/* Link every child of parent to its nearest non-trivia siblings (after parse and each rewrite) */
+void ast_link_significant(ASTNode_t *parent);
+
+/* Get the structure generation (changes whenever any parent's children are relinked) */
+unsigned long ast_structure_generation(void);
+
+/* Skip whitespace and comment children from index, returns count if none are left */
+size_t ast_skip_trivia(ASTNode_t **children, size_t count, size_t index);
+
+/* Get the index of the last non-trivia child before index, or AST_NO_MATCH */
+size_t ast_prev_significant(ASTNode_t **children, size_t index);
+
+/* Free AST node resources (node memory is released by parser_cleanup) */
 void ast_node_free(ASTNode_t *node);
@@ -0,0 +1,202 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Per-phase and per-feature timings and counters for cz --profile.
+ */
+
+#include "src/cz.h"
+#include "profile.h"
+#include "arena.h"
+#include "rewrite.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/* Profile being recorded, NULL when profiling is off */
+CZ_THREAD_LOCAL Profile_t *g_profile = NULL;
+
+/* Get the monotonic clock in nanoseconds (same clock as cz_monotonic_clock_ns) */
+unsigned long long profile_clock_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)((counter.QuadPart * 1000000000ULL) / frequency.QuadPart);
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (unsigned long long)(ts.tv_sec) * 1000000000ULL + (unsigned long long)(ts.tv_nsec);
+#endif
+}
+
+/* Initialize an empty profile */
+void profile_init(Profile_t *profile) {
+    profile->entries = NULL;
+    profile->count = 0;
+    profile->capacity = 0;
+    profile->files = 0;
+}
+
+/* Forget recorded steps, keeping the storage */
+void profile_reset(Profile_t *profile) {
+    profile->count = 0;
+    profile->files = 0;
+}
+
+/* Free profile storage */
+void profile_free(Profile_t *profile) {
+    free(profile->entries);
+    profile_init(profile);
+}
+
+/* Find the phase/name step, adding it if missing (NULL on allocation failure) */
+static ProfileEntry_t *profile_entry(Profile_t *profile, const char *phase, const char *name) {
+    /* Names are mostly string literals, so try pointers before comparing text */
+    for (size_t i = 0; i < profile->count; i++) {
+        if (profile->entries[i].phase == phase && profile->entries[i].name == name) {
+            return &profile->entries[i];
+        }
+    }
+    for (size_t i = 0; i < profile->count; i++) {
+        if (strcmp(profile->entries[i].phase, phase) == 0 && strcmp(profile->entries[i].name, name) == 0) {
+            return &profile->entries[i];
+        }
+    }
+
+    if (profile->count >= profile->capacity) {
+        size_t new_capacity = profile->capacity == 0 ? 32 : profile->capacity * 2;
+        ProfileEntry_t *new_entries = realloc(profile->entries, new_capacity * sizeof(ProfileEntry_t));
+        if (!new_entries) {
+            return NULL;
+        }
+        profile->entries = new_entries;
+        profile->capacity = new_capacity;
+    }
+
+    ProfileEntry_t *entry = &profile->entries[profile->count++];
+    memset(entry, 0, sizeof(*entry));
+    entry->phase = phase;
+    entry->name = name;
+    return entry;
+}
+
+/* Add cost to the phase/name step of profile */
+static void profile_add(Profile_t *profile, const char *phase, const char *name, unsigned long long ns,
+                        size_t tokens, size_t inserted, size_t deleted, size_t bytes) {
+    ProfileEntry_t *entry = profile_entry(profile, phase, name ? name : "");
+    if (!entry) {
+        return;
+    }
+    entry->ns += ns;
+    entry->tokens += tokens;
+    entry->inserted += inserted;
+    entry->deleted += deleted;
+    entry->bytes += bytes;
+}
+
+/* Add cost to the phase/name step of g_profile (no-op when profiling is off) */
+void profile_record(const char *phase, const char *name, unsigned long long ns, size_t tokens,
+                    size_t inserted, size_t deleted, size_t bytes) {
+    if (g_profile) {
+        profile_add(g_profile, phase, name, ns, tokens, inserted, deleted, bytes);
+    }
+}
+
+/* Start measuring a step that walks over tokens (no-op when profiling is off) */
+void profile_begin(ProfileMark_t *mark, size_t tokens) {
+    if (!g_profile) {
+        return;
+    }
+    mark->tokens = tokens;
+    ast_rewrite_totals(&mark->inserted, &mark->deleted);
+    mark->bytes = arena_total_allocated();
+    mark->ns = profile_clock_ns();
+}
+
+/* Record the step started at mark (no-op when profiling is off) */
+void profile_end(const ProfileMark_t *mark, const char *phase, const char *name) {
+    if (!g_profile) {
+        return;
+    }
+    unsigned long long now = profile_clock_ns();
+    size_t inserted = 0;
+    size_t deleted = 0;
+    ast_rewrite_totals(&inserted, &deleted);
+    profile_add(g_profile, phase, name, now - mark->ns, mark->tokens,
+                inserted - mark->inserted, deleted - mark->deleted,
+                arena_total_allocated() - mark->bytes);
+}
+
+/* Add every step of profile into total */
+void profile_merge(Profile_t *total, const Profile_t *profile) {
+    for (size_t i = 0; i < profile->count; i++) {
+        const ProfileEntry_t *entry = &profile->entries[i];
+        profile_add(total, entry->phase, entry->name, entry->ns, entry->tokens,
+                    entry->inserted, entry->deleted, entry->bytes);
+    }
+    total->files += profile->files;
+}
+
+/* Print a string as a JSON string literal */
+void profile_print_json_string(FILE *output, const char *text) {
+    fputc('"', output);
+    for (const char *c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', output);
+            fputc(*c, output);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(output, "\\u%04x", (unsigned)(unsigned char)*c);
+        } else {
+            fputc(*c, output);
+        }
+    }
+    fputc('"', output);
+}
+
+/* Print profile as a table or JSON, labelled with a file name (or "total") */
+void profile_print(FILE *output, const Profile_t *profile, const char *label, ProfileFormat format) {
+    unsigned long long total_ns = 0;
+    for (size_t i = 0; i < profile->count; i++) {
+        total_ns += profile->entries[i].ns;
+    }
+
+    if (format == PROFILE_FORMAT_JSON) {
+        fprintf(output, "{\"file\": ");
+        profile_print_json_string(output, label);
+        fprintf(output, ", \"files\": %zu, \"ns\": %llu, \"steps\": [",
+                profile->files, total_ns);
+        for (size_t i = 0; i < profile->count; i++) {
+            const ProfileEntry_t *entry = &profile->entries[i];
+            fprintf(output, "%s{\"phase\": ", i > 0 ? ", " : "");
+            profile_print_json_string(output, entry->phase);
+            fprintf(output, ", \"name\": ");
+            profile_print_json_string(output, entry->name);
+            fprintf(output, ", \"ns\": %llu, \"tokens\": %zu, \"inserted\": %zu, \"deleted\": %zu, \"bytes\": %zu}",
+                    entry->ns, entry->tokens, entry->inserted, entry->deleted, entry->bytes);
+        }
+        fprintf(output, "]}\n");
+        return;
+    }
+
+    fprintf(output, "[CZ] profile: %s\n", label);
+    fprintf(output, "  %-10s %-18s %10s %6s %10s %9s %9s %10s\n",
+            "phase", "step", "ms", "%", "tokens", "inserted", "deleted", "bytes");
+    for (size_t i = 0; i < profile->count; i++) {
+        const ProfileEntry_t *entry = &profile->entries[i];
+        double percent = total_ns > 0 ? 100.0 * (double)entry->ns / (double)total_ns : 0.0;
+        fprintf(output, "  %-10s %-18s %10.3f %6.1f %10zu %9zu %9zu %10zu\n",
+                entry->phase, entry->name, (double)entry->ns / 1e6, percent,
+                entry->tokens, entry->inserted, entry->deleted, entry->bytes);
+    }
+    fprintf(output, "  %-10s %-18s %10.3f\n", "total", "", (double)total_ns / 1e6);
+}
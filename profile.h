@@ -0,0 +1,81 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Per-phase and per-feature timings and counters for cz --profile.
+ */
+
+#pragma once
+
+#include "worker.h"
+#include <stdio.h>
+#include <stddef.h>
+
+/* Output format of a profile report */
+typedef enum {
+    PROFILE_FORMAT_TABLE,        /* Aligned text table */
+    PROFILE_FORMAT_JSON,         /* One JSON object per report */
+} ProfileFormat;
+
+/* Accumulated cost of one step (a phase, or a feature within a phase) */
+typedef struct {
+    const char *phase;           /* Phase name (e.g., "lex", "validate", "transform") */
+    const char *name;            /* Step name within the phase (e.g., feature name) */
+    unsigned long long ns;       /* Wall time spent in the step */
+    size_t tokens;               /* Tokens the step walked over */
+    size_t inserted;             /* AST nodes inserted */
+    size_t deleted;              /* AST nodes deleted */
+    size_t bytes;                /* Bytes allocated */
+} ProfileEntry_t;
+
+/* Profile - steps in first-recorded order */
+typedef struct {
+    ProfileEntry_t *entries;     /* Recorded steps */
+    size_t count;                /* Number of steps */
+    size_t capacity;             /* Capacity of entries array */
+    size_t files;                /* Number of files merged in */
+} Profile_t;
+
+/* Clock and counters when a step started */
+typedef struct {
+    unsigned long long ns;       /* Start time */
+    size_t tokens;               /* Tokens the step will walk over */
+    size_t inserted;             /* Rewrite inserts so far */
+    size_t deleted;              /* Rewrite deletes so far */
+    size_t bytes;                /* Arena bytes so far */
+} ProfileMark_t;
+
+/* Profile being recorded, NULL when profiling is off */
+extern CZ_THREAD_LOCAL Profile_t *g_profile;
+
+/* Get the monotonic clock in nanoseconds */
+unsigned long long profile_clock_ns(void);
+
+/* Initialize an empty profile */
+void profile_init(Profile_t *profile);
+
+/* Forget recorded steps, keeping the storage */
+void profile_reset(Profile_t *profile);
+
+/* Free profile storage */
+void profile_free(Profile_t *profile);
+
+/* Add cost to the phase/name step of g_profile (no-op when profiling is off) */
+void profile_record(const char *phase, const char *name, unsigned long long ns, size_t tokens,
+                    size_t inserted, size_t deleted, size_t bytes);
+
+/* Start measuring a step that walks over tokens (no-op when profiling is off) */
+void profile_begin(ProfileMark_t *mark, size_t tokens);
+
+/* Record the step started at mark (no-op when profiling is off) */
+void profile_end(const ProfileMark_t *mark, const char *phase, const char *name);
+
+/* Add every step of profile into total */
+void profile_merge(Profile_t *total, const Profile_t *profile);
+
+/* Print a string as a JSON string literal */
+void profile_print_json_string(FILE *output, const char *text);
+
+/* Print profile as a table or JSON, labelled with a file name (or "total") */
+void profile_print(FILE *output, const Profile_t *profile, const char *label, ProfileFormat format);
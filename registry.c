@@ -7,6 +7,8 @@
  */
 
 #include "registry.h"
+#include "profile.h"
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -15,6 +17,11 @@ void feature_registry_init(FeatureRegistry *registry) {
     registry->features = NULL;
     registry->count = 0;
     registry->capacity = 0;
+    for (int phase = 0; phase < FEATURE_PHASE_COUNT; phase++) {
+        registry->order[phase] = NULL;
+        registry->order_count[phase] = 0;
+    }
+    registry->resolved = false;
 }
 
 /* Register a feature with the registry */
@@ -35,6 +42,7 @@ void feature_registry_register(FeatureRegistry *registry, Feature *feature) {
     }
 
     registry->features[registry->count++] = feature;
+    registry->resolved = false;
 }
 
 /* Get a feature by name */
@@ -52,6 +60,28 @@ Feature *feature_registry_get(FeatureRegistry *registry, const char *name) {
     return NULL;
 }
 
+/* Get a feature by its name or a prefix only it starts with (length bytes, not NUL-terminated) */
+Feature *feature_registry_match(FeatureRegistry *registry, const char *name, size_t length) {
+    if (!registry || !name || length == 0) {
+        return NULL;
+    }
+
+    Feature *prefixed = NULL;
+    size_t prefix_count = 0;
+    for (size_t i = 0; i < registry->count; i++) {
+        const char *candidate = registry->features[i]->name;
+        if (strncmp(candidate, name, length) != 0) {
+            continue;
+        }
+        if (candidate[length] == '\0') {
+            return registry->features[i];
+        }
+        prefixed = registry->features[i];
+        prefix_count++;
+    }
+    return prefix_count == 1 ? prefixed : NULL;
+}
+
 /* Enable or disable a feature */
 void feature_registry_set_enabled(FeatureRegistry *registry, const char *name, bool enabled) {
     Feature *feature = feature_registry_get(registry, name);
@@ -60,102 +90,360 @@ void feature_registry_set_enabled(FeatureRegistry *registry, const char *name, b
     }
 }
 
-/* Check if all dependencies are satisfied and run first */
-static bool check_dependencies(FeatureRegistry *registry, Feature *feature, bool *visited, size_t feature_idx) {
-    if (!feature->dependencies) {
-        return true; /* No dependencies */
+/* Check if feature has work in phase */
+static bool feature_in_phase(const Feature *feature, FeaturePhase phase) {
+    switch (phase) {
+        case FEATURE_PHASE_VALIDATE: return feature->validate != NULL;
+        case FEATURE_PHASE_TRANSFORM: return feature->transform != NULL || feature->visit != NULL;
+        case FEATURE_PHASE_EMIT: return feature->emit != NULL;
+        default: return false;
     }
+}
+
+/* Feature dependency graph as registry indices */
+typedef struct {
+    size_t *deps;            /* Dependency indices of all features, back to back */
+    size_t *start;           /* First entry in deps for each feature (count + 1 entries) */
+    unsigned char *state;    /* DFS state per feature: 0 new, 1 on stack, 2 done */
+} DependencyGraph_t;
 
-    /* Check for circular dependencies */
-    if (visited[feature_idx]) {
+/* Visit feature and its dependencies depth-first, appending phase members to order (NULL to only check) */
+static bool place_feature(FeatureRegistry *registry, DependencyGraph_t *graph, size_t index,
+                          FeaturePhase phase, Feature **order, size_t *order_count) {
+    if (graph->state[index] == 2) {
+        return true;
+    }
+    if (graph->state[index] == 1) {
         return false; /* Circular dependency detected */
     }
 
-    visited[feature_idx] = true;
+    graph->state[index] = 1;
+    for (size_t d = graph->start[index]; d < graph->start[index + 1]; d++) {
+        if (!place_feature(registry, graph, graph->deps[d], phase, order, order_count)) {
+            return false;
+        }
+    }
+    graph->state[index] = 2;
+
+    Feature *feature = registry->features[index];
+    if (order && feature_in_phase(feature, phase)) {
+        order[(*order_count)++] = feature;
+    }
+    return true;
+}
+
+/* Drop the resolved phase orders */
+static void free_orders(FeatureRegistry *registry) {
+    for (int phase = 0; phase < FEATURE_PHASE_COUNT; phase++) {
+        free(registry->order[phase]);
+        registry->order[phase] = NULL;
+        registry->order_count[phase] = 0;
+    }
+    registry->resolved = false;
+}
+
+/* Resolve per-phase execution orders, returns false (setting *failed) on missing or circular dependencies */
+bool feature_registry_resolve(FeatureRegistry *registry, const char **failed) {
+    if (failed) {
+        *failed = NULL;
+    }
+    if (!registry) {
+        return false;
+    }
+    free_orders(registry);
 
-    for (size_t i = 0; feature->dependencies[i] != NULL; i++) {
-        Feature *dep = feature_registry_get(registry, feature->dependencies[i]);
-        if (!dep) {
-            return false; /* Dependency not found */
+    /* Resolve dependency names to indices once */
+    size_t total = 0;
+    for (size_t i = 0; i < registry->count; i++) {
+        const char **deps = registry->features[i]->dependencies;
+        for (size_t d = 0; deps && deps[d] != NULL; d++) {
+            total++;
         }
+    }
+
+    DependencyGraph_t graph;
+    graph.deps = malloc((total > 0 ? total : 1) * sizeof(size_t));
+    graph.start = malloc((registry->count + 1) * sizeof(size_t));
+    graph.state = calloc(registry->count > 0 ? registry->count : 1, 1);
+    bool ok = graph.deps && graph.start && graph.state;
 
-        /* Find dependency index */
-        size_t dep_idx = 0;
-        for (dep_idx = 0; dep_idx < registry->count; dep_idx++) {
-            if (registry->features[dep_idx] == dep) {
+    size_t next = 0;
+    for (size_t i = 0; ok && i < registry->count; i++) {
+        Feature *feature = registry->features[i];
+        graph.start[i] = next;
+        for (size_t d = 0; feature->dependencies && feature->dependencies[d] != NULL; d++) {
+            Feature *dep = feature_registry_get(registry, feature->dependencies[d]);
+            size_t dep_idx = 0;
+            while (dep && dep_idx < registry->count && registry->features[dep_idx] != dep) {
+                dep_idx++;
+            }
+            if (!dep || dep_idx >= registry->count) {
+                if (failed) *failed = feature->name; /* Dependency not found */
+                ok = false;
                 break;
             }
+            graph.deps[next++] = dep_idx;
+        }
+    }
+    if (ok) {
+        graph.start[registry->count] = next;
+    }
+
+    /* Reject cycles anywhere in the graph, even among features a phase would skip */
+    for (size_t i = 0; ok && i < registry->count; i++) {
+        if (!place_feature(registry, &graph, i, FEATURE_PHASE_VALIDATE, NULL, NULL)) {
+            if (failed) *failed = registry->features[i]->name;
+            ok = false;
+        }
+    }
+
+    /* Registration order, with a member's dependencies pulled in front of it */
+    for (int phase = 0; ok && phase < FEATURE_PHASE_COUNT; phase++) {
+        registry->order[phase] = malloc((registry->count > 0 ? registry->count : 1) * sizeof(Feature *));
+        if (!registry->order[phase]) {
+            ok = false;
+            break;
+        }
+        memset(graph.state, 0, registry->count);
+        for (size_t i = 0; i < registry->count; i++) {
+            if (feature_in_phase(registry->features[i], (FeaturePhase)phase)) {
+                place_feature(registry, &graph, i, (FeaturePhase)phase,
+                              registry->order[phase], &registry->order_count[phase]);
+            }
         }
+    }
+
+    free(graph.deps);
+    free(graph.start);
+    free(graph.state);
 
-        if (dep_idx < registry->count) {
-            if (!check_dependencies(registry, dep, visited, dep_idx)) {
-                return false;
+    if (!ok) {
+        free_orders(registry);
+        return false;
+    }
+    registry->resolved = true;
+    return true;
+}
+
+/* Resolve orders on first use if registration did not */
+static bool ensure_resolved(FeatureRegistry *registry) {
+    return registry->resolved || feature_registry_resolve(registry, NULL);
+}
+
+/* Remove feature from the phase orders of this registry only */
+static void drop_feature(FeatureRegistry *registry, const Feature *feature) {
+    for (int phase = 0; phase < FEATURE_PHASE_COUNT; phase++) {
+        size_t kept = 0;
+        for (size_t i = 0; i < registry->order_count[phase]; i++) {
+            if (registry->order[phase][i] != feature) {
+                registry->order[phase][kept++] = registry->order[phase][i];
             }
         }
+        registry->order_count[phase] = kept;
     }
+}
 
-    visited[feature_idx] = false;
+/* Skip a feature in this registry only (the shared enabled flag is untouched), returns false if unknown */
+bool feature_registry_disable(FeatureRegistry *registry, const char *name, size_t length) {
+    Feature *feature = feature_registry_match(registry, name, length);
+    if (!feature || !ensure_resolved(registry)) {
+        return false;
+    }
+    drop_feature(registry, feature);
     return true;
 }
 
+/* Check if a feature is enabled and still in a phase order of this registry */
+bool feature_registry_runs(FeatureRegistry *registry, const char *name) {
+    Feature *feature = feature_registry_get(registry, name);
+    if (!feature || !feature->enabled || !ensure_resolved(registry)) {
+        return false;
+    }
+    for (int phase = 0; phase < FEATURE_PHASE_COUNT; phase++) {
+        for (size_t i = 0; i < registry->order_count[phase]; i++) {
+            if (registry->order[phase][i] == feature) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Check if word (length bytes, not NUL-terminated) is one of the NULL-terminated words */
+static bool word_in(const char **words, const char *word, size_t length) {
+    for (size_t i = 0; words[i] != NULL; i++) {
+        if (words[i][0] == word[0] && strncmp(words[i], word, length) == 0 && words[i][length] == '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Drop the features whose trigger words don't appear in source from the phase orders */
+void feature_registry_prescan(FeatureRegistry *registry, const char *source) {
+    if (!registry || !source || !ensure_resolved(registry) || registry->count == 0) {
+        return;
+    }
+
+    bool *present = calloc(registry->count, sizeof(bool));
+    if (!present) {
+        return;
+    }
+    size_t pending = 0;
+    for (size_t i = 0; i < registry->count; i++) {
+        present[i] = registry->features[i]->triggers == NULL;
+        pending += !present[i];
+    }
+
+    /* One pass over the words of the raw buffer (comments and strings included, which only keeps more) */
+    const char *p = source;
+    while (*p && pending > 0) {
+        if (!isalpha((unsigned char)*p) && *p != '_') {
+            p++;
+            continue;
+        }
+        const char *word = p;
+        while (isalnum((unsigned char)*p) || *p == '_') {
+            p++;
+        }
+        for (size_t i = 0; i < registry->count; i++) {
+            if (!present[i] && word_in(registry->features[i]->triggers, word, (size_t)(p - word))) {
+                present[i] = true;
+                pending--;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < registry->count; i++) {
+        if (!present[i]) {
+            drop_feature(registry, registry->features[i]);
+        }
+    }
+    free(present);
+}
+
 /* Execute all enabled features in the validation phase */
 void feature_registry_validate(FeatureRegistry *registry, ASTNode_t *ast, const char *filename, const char *source) {
-    if (!registry || !ast) {
+    if (!registry || !ast || !ensure_resolved(registry)) {
         return;
     }
 
-    bool *visited = calloc(registry->count, sizeof(bool));
-    if (!visited) {
+    Feature **order = registry->order[FEATURE_PHASE_VALIDATE];
+    for (size_t i = 0; i < registry->order_count[FEATURE_PHASE_VALIDATE]; i++) {
+        if (order[i]->enabled) {
+            ProfileMark_t mark;
+            profile_begin(&mark, ast->child_count);
+            order[i]->validate(ast, filename, source);
+            profile_end(&mark, "validate", order[i]->name);
+        }
+    }
+}
+
+/* Check if a visitor feature subscribes to token */
+static bool feature_subscribes(const Feature *feature, const Token *token) {
+    if (!(feature->visit_tokens & FEATURE_VISIT_TOKEN(token->type))) {
+        return false;
+    }
+    if (!feature->visit_names) {
+        return true;
+    }
+    if (!token->text) {
+        return false;
+    }
+    for (size_t i = 0; feature->visit_names[i] != NULL; i++) {
+        if (strcmp(token->text, feature->visit_names[i]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Run a group of visitor features in one traversal, keeping per-feature order */
+static void run_fused_visitors(Feature **group, size_t count, ASTNode_t *ast, const char *filename, const char *source) {
+    /* Next child each feature may visit, so skipped ranges stay per-feature */
+    size_t *resume = calloc(count, sizeof(size_t));
+    if (!resume) {
         return;
     }
 
-    for (size_t i = 0; i < registry->count; i++) {
-        Feature *feature = registry->features[i];
-        if (feature && feature->enabled && feature->validate) {
-            /* Check dependencies */
-            if (check_dependencies(registry, feature, visited, i)) {
-                feature->validate(ast, filename, source);
+    FeatureVisit_t visit;
+    visit.ast = ast;
+    visit.filename = filename;
+    visit.source = source;
+    ast_rewrite_init(&visit.rewrite, ast);
+
+    /* Children only change on commit, so child_count is stable here */
+    for (size_t i = 0; i < ast->child_count; i++) {
+        ASTNode_t *node = ast->children[i];
+        if (node->type != AST_TOKEN) {
+            continue;
+        }
+        for (size_t f = 0; f < count; f++) {
+            if (i < resume[f] || !feature_subscribes(group[f], &node->token)) {
+                continue;
             }
+            ProfileMark_t mark;
+            profile_begin(&mark, 1);
+            size_t last = group[f]->visit(&visit, i);
+            profile_end(&mark, "transform", group[f]->name);
+            resume[f] = (last > i ? last : i) + 1;
         }
     }
 
-    free(visited);
+    ast_rewrite_commit(&visit.rewrite);
+    free(resume);
 }
 
 /* Execute all enabled features in the transformation phase */
 void feature_registry_transform(FeatureRegistry *registry, ASTNode_t *ast, const char *filename, const char *source) {
-    if (!registry || !ast) {
+    if (!registry || !ast || !ensure_resolved(registry)) {
         return;
     }
 
-    bool *visited = calloc(registry->count, sizeof(bool));
-    if (!visited) {
+    Feature **order = registry->order[FEATURE_PHASE_TRANSFORM];
+    size_t count = registry->order_count[FEATURE_PHASE_TRANSFORM];
+    Feature **group = malloc((count > 0 ? count : 1) * sizeof(Feature *));
+    if (!group) {
         return;
     }
 
-    for (size_t i = 0; i < registry->count; i++) {
-        Feature *feature = registry->features[i];
-        if (feature && feature->enabled && feature->transform) {
-            /* Check dependencies */
-            if (check_dependencies(registry, feature, visited, i)) {
-                feature->transform(ast, filename, source);
-            }
+    /* Consecutive visitor features are fused, whole-AST transforms split the groups */
+    size_t group_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        Feature *feature = order[i];
+        if (!feature->enabled) {
+            continue;
+        }
+        if (feature->visit) {
+            group[group_count++] = feature;
+            continue;
+        }
+        if (group_count > 0) {
+            run_fused_visitors(group, group_count, ast, filename, source);
+            group_count = 0;
         }
+        ProfileMark_t mark;
+        profile_begin(&mark, ast->child_count);
+        feature->transform(ast, filename, source);
+        profile_end(&mark, "transform", feature->name);
+    }
+    if (group_count > 0) {
+        run_fused_visitors(group, group_count, ast, filename, source);
     }
 
-    free(visited);
+    free(group);
 }
 
 /* Execute all enabled features in the emission phase */
-void feature_registry_emit(FeatureRegistry *registry, FILE *output) {
-    if (!registry || !output) {
+void feature_registry_emit(FeatureRegistry *registry, OutputSink_t *output) {
+    if (!registry || !output || !ensure_resolved(registry)) {
         return;
     }
 
-    for (size_t i = 0; i < registry->count; i++) {
-        Feature *feature = registry->features[i];
-        if (feature && feature->enabled && feature->emit) {
-            feature->emit(output);
+    Feature **order = registry->order[FEATURE_PHASE_EMIT];
+    for (size_t i = 0; i < registry->order_count[FEATURE_PHASE_EMIT]; i++) {
+        if (order[i]->enabled) {
+            order[i]->emit(output);
         }
     }
 }
@@ -170,4 +458,5 @@ void feature_registry_free(FeatureRegistry *registry) {
     registry->features = NULL;
     registry->count = 0;
     registry->capacity = 0;
+    free_orders(registry);
 }
@@ -10,6 +10,8 @@
 #pragma once
 
 #include "parser.h"
+#include "rewrite.h"
+#include "sink.h"
 #include <stdio.h>
 #include <stdbool.h>
 
@@ -21,6 +23,7 @@ typedef enum {
     FEATURE_PHASE_VALIDATE,      /* Validation phase - check AST for errors */
     FEATURE_PHASE_TRANSFORM,     /* Transform phase - modify AST */
     FEATURE_PHASE_EMIT,          /* Emit phase - output code */
+    FEATURE_PHASE_COUNT          /* Number of phases */
 } FeaturePhase;
 
 /* Feature function signature for validation */
@@ -29,8 +32,25 @@ typedef void (*FeatureValidateFunc)(ASTNode_t *ast, const char *filename, const
 /* Feature function signature for transformation */
 typedef void (*FeatureTransformFunc)(ASTNode_t *ast, const char *filename, const char *source);
 
+/* State shared by the token visitors of one fused traversal */
+typedef struct {
+    ASTNode_t *ast;              /* Translation unit being traversed */
+    const char *filename;        /* Source filename */
+    const char *source;          /* Source text */
+    ASTRewrite_t rewrite;        /* Structural edits, committed once the traversal ends */
+} FeatureVisit_t;
+
+/* Feature function signature for token visits, returns the last child index it consumed */
+typedef size_t (*FeatureVisitFunc)(FeatureVisit_t *visit, size_t index);
+
+/* Token kind bit for Feature.visit_tokens */
+#define FEATURE_VISIT_TOKEN(type) (1u << (type))
+
 /* Feature function signature for emission */
-typedef void (*FeatureEmitFunc)(FILE *output);
+typedef void (*FeatureEmitFunc)(OutputSink_t *output);
+
+/* Feature function signature for the bytes held by its symbol tables */
+typedef size_t (*FeatureTableBytesFunc)(void);
 
 /* Feature descriptor - describes a CZar feature */
 typedef struct {
@@ -44,11 +64,26 @@ typedef struct {
     /* Transformation function (optional) */
     FeatureTransformFunc transform;
 
+    /* Token visitor (optional, used instead of transform): consecutive visitor features
+     * share one traversal, each still sees the tokens in order as if it ran alone.
+     * Visitors must only edit the tokens they consume and queue structural edits
+     * on the shared rewrite. */
+    FeatureVisitFunc visit;
+    unsigned visit_tokens;               /* FEATURE_VISIT_TOKEN() mask of token kinds to visit */
+    const char **visit_names;            /* NULL-terminated token texts to visit (NULL for any text) */
+
     /* Emission function (optional) */
     FeatureEmitFunc emit;
 
+    /* Bytes held by the feature's symbol tables for the current translation unit (optional, cz --stats) */
+    FeatureTableBytesFunc table_bytes;
+
     /* Dependencies - NULL-terminated array of feature names that must run before this one */
     const char **dependencies;
+
+    /* Trigger words - NULL-terminated identifiers, one of which must appear in the source for
+     * the feature to have any effect (NULL if it may apply to any source) */
+    const char **triggers;
 } Feature;
 
 /* Feature registry - manages all features */
@@ -56,6 +91,9 @@ typedef struct {
     Feature **features;      /* Array of feature pointers */
     size_t count;            /* Number of registered features */
     size_t capacity;         /* Capacity of features array */
+    Feature **order[FEATURE_PHASE_COUNT];      /* Per-phase execution order, dependencies first */
+    size_t order_count[FEATURE_PHASE_COUNT];   /* Number of features in each phase order */
+    bool resolved;           /* Orders match the registered features */
 } FeatureRegistry;
 
 /* Initialize the feature registry */
@@ -64,12 +102,27 @@ void feature_registry_init(FeatureRegistry *registry);
 /* Register a feature with the registry */
 void feature_registry_register(FeatureRegistry *registry, Feature *feature);
 
+/* Resolve per-phase execution orders, returns false (setting *failed) on missing or circular dependencies */
+bool feature_registry_resolve(FeatureRegistry *registry, const char **failed);
+
+/* Drop the features whose trigger words don't appear in source from the phase orders */
+void feature_registry_prescan(FeatureRegistry *registry, const char *source);
+
 /* Get a feature by name */
 Feature *feature_registry_get(FeatureRegistry *registry, const char *name);
 
+/* Get a feature by its name or a prefix only it starts with (length bytes, not NUL-terminated) */
+Feature *feature_registry_match(FeatureRegistry *registry, const char *name, size_t length);
+
 /* Enable or disable a feature */
 void feature_registry_set_enabled(FeatureRegistry *registry, const char *name, bool enabled);
 
+/* Skip a feature in this registry only (the shared enabled flag is untouched), returns false if unknown */
+bool feature_registry_disable(FeatureRegistry *registry, const char *name, size_t length);
+
+/* Check if a feature is enabled and still in a phase order of this registry */
+bool feature_registry_runs(FeatureRegistry *registry, const char *name);
+
 /* Execute all enabled features in the validation phase */
 void feature_registry_validate(FeatureRegistry *registry, ASTNode_t *ast, const char *filename, const char *source);
 
@@ -77,7 +130,7 @@ void feature_registry_validate(FeatureRegistry *registry, ASTNode_t *ast, const
 void feature_registry_transform(FeatureRegistry *registry, ASTNode_t *ast, const char *filename, const char *source);
 
 /* Execute all enabled features in the emission phase */
-void feature_registry_emit(FeatureRegistry *registry, FILE *output);
+void feature_registry_emit(FeatureRegistry *registry, OutputSink_t *output);
 
 /* Free the feature registry */
 void feature_registry_free(FeatureRegistry *registry);
@@ -0,0 +1,213 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Batched edits over an AST node's children, applied in one linear pass.
+ */
+
+#include "rewrite.h"
+#include "worker.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Edits recorded by every rewrite since startup */
+static CZ_THREAD_LOCAL size_t total_inserted = 0;
+static CZ_THREAD_LOCAL size_t total_deleted = 0;
+
+/* Start an empty edit list for parent */
+void ast_rewrite_init(ASTRewrite_t *rewrite, ASTNode_t *parent) {
+    rewrite->parent = parent;
+    rewrite->edits = NULL;
+    rewrite->count = 0;
+    rewrite->capacity = 0;
+    rewrite->sorted = 1;
+}
+
+/* Record one edit, keeping track of whether the list is still in order */
+static int record_edit(ASTRewrite_t *rewrite, size_t position, ASTNode_t *node) {
+    if (rewrite->count >= rewrite->capacity) {
+        size_t new_capacity = rewrite->capacity == 0 ? 16 : rewrite->capacity * 2;
+        ASTEdit_t *new_edits = realloc(rewrite->edits, new_capacity * sizeof(ASTEdit_t));
+        if (!new_edits) {
+            return 0;
+        }
+        rewrite->edits = new_edits;
+        rewrite->capacity = new_capacity;
+    }
+
+    if (rewrite->count > 0 && rewrite->edits[rewrite->count - 1].position > position) {
+        rewrite->sorted = 0;
+    }
+
+    ASTEdit_t *edit = &rewrite->edits[rewrite->count];
+    edit->position = position;
+    edit->sequence = rewrite->count;
+    edit->node = node;
+    rewrite->count++;
+    if (node) {
+        total_inserted++;
+    } else {
+        total_deleted++;
+    }
+    return 1;
+}
+
+/* Insert node before child position (child_count appends), returns 0 on failure */
+int ast_rewrite_insert(ASTRewrite_t *rewrite, size_t position, ASTNode_t *node) {
+    if (!rewrite || !rewrite->parent || !node || position > rewrite->parent->child_count) {
+        return 0;
+    }
+    return record_edit(rewrite, position, node);
+}
+
+/* Insert count nodes in order before child position, returns 0 on failure */
+int ast_rewrite_insert_many(ASTRewrite_t *rewrite, size_t position, ASTNode_t **nodes, size_t count) {
+    if (!nodes) {
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (nodes[i] && !ast_rewrite_insert(rewrite, position, nodes[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Delete child position on commit (its text is cleared right away), returns 0 on failure */
+int ast_rewrite_delete(ASTRewrite_t *rewrite, size_t position) {
+    if (!rewrite || !rewrite->parent || position >= rewrite->parent->child_count) {
+        return 0;
+    }
+
+    /* Later scans in the same pass see an empty token, as if it were already gone,
+     * while bracket matches keep describing the children before commit */
+    ASTNode_t *child = rewrite->parent->children[position];
+    if (child->type == AST_TOKEN && child->token.text) {
+        token_clear_text(&child->token);
+    }
+    return record_edit(rewrite, position, NULL);
+}
+
+/* Delete count children starting at position, returns 0 on failure */
+int ast_rewrite_delete_range(ASTRewrite_t *rewrite, size_t position, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!ast_rewrite_delete(rewrite, position + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Replace child position with node, returns 0 on failure */
+int ast_rewrite_replace(ASTRewrite_t *rewrite, size_t position, ASTNode_t *node) {
+    return ast_rewrite_insert(rewrite, position, node) && ast_rewrite_delete(rewrite, position);
+}
+
+/* Order edits by position, then by recording order */
+static int compare_edits(const void *a, const void *b) {
+    const ASTEdit_t *ea = (const ASTEdit_t *)a;
+    const ASTEdit_t *eb = (const ASTEdit_t *)b;
+    if (ea->position != eb->position) return ea->position < eb->position ? -1 : 1;
+    if (ea->sequence != eb->sequence) return ea->sequence < eb->sequence ? -1 : 1;
+    return 0;
+}
+
+/* Apply all edits in one merge pass and reset the list, returns 0 on failure (children untouched) */
+int ast_rewrite_commit(ASTRewrite_t *rewrite) {
+    if (!rewrite || !rewrite->parent) {
+        return 0;
+    }
+    if (rewrite->count == 0) {
+        ast_rewrite_free(rewrite);
+        return 1;
+    }
+
+    ASTNode_t *parent = rewrite->parent;
+    if (!rewrite->sorted) {
+        qsort(rewrite->edits, rewrite->count, sizeof(ASTEdit_t), compare_edits);
+    }
+
+    /* Worst case every edit is an insert */
+    size_t capacity = parent->child_count + rewrite->count;
+    ASTNode_t **children = malloc(capacity * sizeof(ASTNode_t *));
+    if (!children) {
+        ast_rewrite_free(rewrite);
+        return 0;
+    }
+
+    size_t out = 0;
+    size_t e = 0;
+    for (size_t i = 0; i <= parent->child_count; i++) {
+        int deleted = 0;
+        while (e < rewrite->count && rewrite->edits[e].position == i) {
+            if (rewrite->edits[e].node) {
+                children[out++] = rewrite->edits[e].node;
+            } else {
+                deleted = 1;
+            }
+            e++;
+        }
+        if (i == parent->child_count) {
+            break;
+        }
+        if (deleted) {
+            token_free(&parent->children[i]->token);
+        } else {
+            children[out++] = parent->children[i];
+        }
+    }
+
+    free(parent->children);
+    ast_invalidate_matches(parent);
+    parent->children = children;
+    parent->child_count = out;
+    parent->child_capacity = capacity;
+    ast_link_significant(parent);
+
+    ast_rewrite_free(rewrite);
+    return 1;
+}
+
+/* Drop pending edits without applying them */
+void ast_rewrite_free(ASTRewrite_t *rewrite) {
+    if (!rewrite) {
+        return;
+    }
+    free(rewrite->edits);
+    rewrite->edits = NULL;
+    rewrite->count = 0;
+    rewrite->capacity = 0;
+    rewrite->sorted = 1;
+}
+
+/* Get the number of inserts and deletes recorded by every rewrite since startup */
+void ast_rewrite_totals(size_t *inserted, size_t *deleted) {
+    if (inserted) *inserted = total_inserted;
+    if (deleted) *deleted = total_deleted;
+}
+
+/* Empty children [start, end) in place, keeping the line breaks of whitespace so lines stay in place */
+void ast_clear_range(ASTNode_t **children, size_t start, size_t end) {
+    for (size_t k = start; k < end; k++) {
+        Token *t = &children[k]->token;
+        if (!t->text || t->text[0] == '\0') {
+            continue;
+        }
+        if (t->type != TOKEN_WHITESPACE || !strchr(t->text, '\n')) {
+            token_set_text(t, "");
+            continue;
+        }
+        size_t n = 0;
+        for (const char *c = t->text; *c; c++) {
+            n += *c == '\n';
+        }
+        char *newlines = malloc(n + 1);
+        if (!newlines) {
+            continue; /* Out of memory: the whitespace stays, and so do the lines */
+        }
+        memset(newlines, '\n', n);
+        newlines[n] = '\0';
+        token_take_text(t, newlines);
+    }
+}
@@ -0,0 +1,58 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Batched edits over an AST node's children, applied in one linear pass.
+ */
+
+#pragma once
+
+#include "parser.h"
+#include <stddef.h>
+
+/* Pending edit, positions always refer to the children before commit */
+typedef struct {
+    size_t position;            /* Child index the edit applies to */
+    size_t sequence;            /* Recording order (keeps inserts at one position stable) */
+    ASTNode_t *node;            /* Node to insert before position, NULL to delete the child */
+} ASTEdit_t;
+
+/* Edit list for one parent node */
+typedef struct {
+    ASTNode_t *parent;          /* Node whose children are rewritten */
+    ASTEdit_t *edits;           /* Recorded edits */
+    size_t count;               /* Number of recorded edits */
+    size_t capacity;            /* Capacity of edits array */
+    int sorted;                 /* Edits were recorded in position order */
+} ASTRewrite_t;
+
+/* Start an empty edit list for parent */
+void ast_rewrite_init(ASTRewrite_t *rewrite, ASTNode_t *parent);
+
+/* Insert node before child position (child_count appends), returns 0 on failure */
+int ast_rewrite_insert(ASTRewrite_t *rewrite, size_t position, ASTNode_t *node);
+
+/* Insert count nodes in order before child position, returns 0 on failure */
+int ast_rewrite_insert_many(ASTRewrite_t *rewrite, size_t position, ASTNode_t **nodes, size_t count);
+
+/* Delete child position on commit (its text is cleared right away), returns 0 on failure */
+int ast_rewrite_delete(ASTRewrite_t *rewrite, size_t position);
+
+/* Delete count children starting at position, returns 0 on failure */
+int ast_rewrite_delete_range(ASTRewrite_t *rewrite, size_t position, size_t count);
+
+/* Replace child position with node, returns 0 on failure */
+int ast_rewrite_replace(ASTRewrite_t *rewrite, size_t position, ASTNode_t *node);
+
+/* Apply all edits in one merge pass and reset the list, returns 0 on failure (children untouched) */
+int ast_rewrite_commit(ASTRewrite_t *rewrite);
+
+/* Drop pending edits without applying them */
+void ast_rewrite_free(ASTRewrite_t *rewrite);
+
+/* Empty children [start, end) in place, keeping the line breaks of whitespace so lines stay in place */
+void ast_clear_range(ASTNode_t **children, size_t start, size_t end);
+
+/* Get the number of inserts and deletes recorded by every rewrite since startup */
+void ast_rewrite_totals(size_t *inserted, size_t *deleted);
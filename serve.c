@@ -0,0 +1,242 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Long-running transpile server for build systems and editors (cz --serve).
+ */
+
+#include "src/cz.h"
+#include "serve.h"
+#include "transpile.h"
+#include "hashtable.h"
+#include "dirlist.h"
+#include "siblings.h"
+#include "worker.h"
+#include "src/headers.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Outputs of the last request for one input and output base */
+typedef struct {
+    char *input_file;            /* Source path */
+    char *output_base;           /* Output base path */
+    CacheRecord_t record;        /* Key and output hashes of the last transpile */
+} ServeEntry_t;
+
+/* State kept warm between requests */
+typedef struct {
+    SymbolTable symbols;         /* Interner shared by every request */
+    const char *cache_dir;       /* Incremental cache directory (NULL when caching is off) */
+    bool dependencies;           /* Write a .d file per transpile (-MD) */
+    bool minimal_headers;        /* Minimal headers per transpile (--minimal-headers) */
+    bool compact;                /* Compact outputs per transpile (--compact) */
+    ServeEntry_t *entries;       /* One entry per input and output base seen */
+    size_t entry_count;          /* Number of entries */
+    size_t entry_capacity;       /* Capacity of entries array */
+    HashTable_t entry_index;     /* Hash of input and output base -> index in entries */
+} ServeSession_t;
+
+/* One request handed to the isolated job */
+typedef struct {
+    ServeSession_t *session;     /* Session state */
+    TranspileRequest_t request;  /* Input to transpile */
+} ServeJob_t;
+
+/* FNV-1a hash of an input path and output base (never 0) */
+static uint64_t entry_key(const char *input_file, const char *output_base) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char *p = input_file; ; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+        if (!*p) break;
+    }
+    for (const char *p = output_base; *p; p++) {
+        hash ^= (unsigned char)*p;
+        hash *= 1099511628211ULL;
+    }
+    return hash ? hash : 1;
+}
+
+/* Find or add the entry of an input and output base (NULL on allocation failure) */
+static ServeEntry_t *session_entry(ServeSession_t *session, const char *input_file, const char *output_base) {
+    uint64_t key = entry_key(input_file, output_base);
+    size_t index = hash_table_get(&session->entry_index, key);
+    if (index != HASH_TABLE_MISSING &&
+        strcmp(session->entries[index].input_file, input_file) == 0 &&
+        strcmp(session->entries[index].output_base, output_base) == 0) {
+        return &session->entries[index];
+    }
+
+    if (session->entry_count >= session->entry_capacity) {
+        size_t new_capacity = session->entry_capacity == 0 ? 16 : session->entry_capacity * 2;
+        ServeEntry_t *new_entries = realloc(session->entries, new_capacity * sizeof(ServeEntry_t));
+        if (!new_entries) {
+            return NULL;
+        }
+        session->entries = new_entries;
+        session->entry_capacity = new_capacity;
+    }
+
+    ServeEntry_t *entry = &session->entries[session->entry_count];
+    entry->input_file = strdup(input_file);
+    entry->output_base = strdup(output_base);
+    entry->record.key = 0;
+    entry->record.header_hash = 0;
+    entry->record.source_hash = 0;
+    if (!entry->input_file || !entry->output_base ||
+        !hash_table_put(&session->entry_index, key, session->entry_count)) {
+        free(entry->input_file);
+        free(entry->output_base);
+        return NULL;
+    }
+    session->entry_count++;
+    return entry;
+}
+
+/* Transpile the request of a job */
+static bool serve_job(size_t index, void *context) {
+    (void)index;
+    ServeJob_t *job = (ServeJob_t *)context;
+    return transpile(&job->request, &job->session->symbols, job->session->cache_dir);
+}
+
+/* Read exactly size bytes following a buffer request, NUL-terminated (NULL on short input) */
+static char *read_buffer(FILE *input, size_t size) {
+    char *data = malloc(size + 1);
+    if (!data) {
+        return NULL;
+    }
+    if (fread(data, 1, size, input) != size) {
+        free(data);
+        return NULL;
+    }
+    data[size] = '\0';
+    return data;
+}
+
+/* Parse a buffer size, returns false if text is not a number */
+static bool parse_size(const char *text, size_t *size) {
+    if (!text || !*text) {
+        return false;
+    }
+    char *end = NULL;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (*end != '\0' || value >= SIZE_MAX) {
+        return false;
+    }
+    *size = (size_t)value;
+    return true;
+}
+
+/* Handle one request line, returns false for malformed requests */
+static bool serve_request(ServeSession_t *session, FILE *input, char *line, bool *quit) {
+    char *save = NULL;
+    const char *command = strtok_r(line, " \t\r\n", &save);
+    if (!command) {
+        return false;
+    }
+    if (strcmp(command, "quit") == 0) {
+        *quit = true;
+        return true;
+    }
+
+    ServeJob_t job;
+    job.session = session;
+    job.request.data = NULL;
+    job.request.size = 0;
+    job.request.dependencies = session->dependencies;
+    job.request.minimal_headers = session->minimal_headers;
+    job.request.compact = session->compact;
+    job.request.trace = false;
+    job.request.header_output = NULL;
+    job.request.source_output = NULL;
+    job.request.stream_output = NULL;
+    char *data = NULL;
+
+    if (strcmp(command, "transpile") == 0) {
+        job.request.input_file = strtok_r(NULL, " \t\r\n", &save);
+    } else if (strcmp(command, "buffer") == 0) {
+        job.request.input_file = strtok_r(NULL, " \t\r\n", &save);
+        if (!parse_size(strtok_r(NULL, " \t\r\n", &save), &job.request.size)) {
+            fprintf(stderr, "[CZ] Invalid buffer size\n");
+            return false;
+        }
+        data = read_buffer(input, job.request.size);
+        if (!data) {
+            fprintf(stderr, "[CZ] Buffer shorter than its size\n");
+            return false;
+        }
+        job.request.data = data;
+    } else {
+        fprintf(stderr, "[CZ] Unknown request '%s'\n", command);
+        return false;
+    }
+
+    if (!job.request.input_file) {
+        fprintf(stderr, "[CZ] Missing input file\n");
+        free(data);
+        return false;
+    }
+    job.request.output_base = strtok_r(NULL, " \t\r\n", &save);
+    if (!job.request.output_base) {
+        job.request.output_base = job.request.input_file;
+    }
+
+    /* Inputs whose key and outputs are unchanged since the last request are skipped */
+    ServeEntry_t *entry = session_entry(session, job.request.input_file, job.request.output_base);
+    job.request.record = entry ? &entry->record : NULL;
+
+    /* Directories are listed again for every request: files may have been added since the last one */
+    dir_listing_clear();
+    sibling_names_clear();
+    bool ok = worker_run_isolated(serve_job, 0, &job);
+    free(data);
+    return ok;
+}
+
+/* Serve requests read from input until quit or end of input, returns the exit status.
+ * With dependencies, every transpile also writes its .d file (cz -MD), with minimal_headers
+ * its headers are minimal (cz --minimal-headers), with compact its outputs are (cz --compact). */
+int serve(FILE *input, const char *cache_dir, bool dependencies, bool minimal_headers, bool compact) {
+    ServeSession_t session;
+    symbols_init(&session.symbols);
+    session.cache_dir = cache_dir;
+    session.dependencies = dependencies;
+    session.minimal_headers = minimal_headers;
+    session.compact = compact;
+    session.entries = NULL;
+    session.entry_count = 0;
+    session.entry_capacity = 0;
+    hash_table_init(&session.entry_index);
+
+    char *line = NULL;
+    size_t line_capacity = 0;
+    bool quit = false;
+    while (!quit && getline(&line, &line_capacity, input) >= 0) {
+        /* Blank lines are not requests */
+        if (line[strspn(line, " \t\r\n")] == '\0') {
+            continue;
+        }
+        bool ok = serve_request(&session, input, line, &quit);
+        if (!quit) {
+            fflush(stderr);
+            fprintf(stdout, "%s\n", ok ? "ok" : "error");
+            fflush(stdout);
+        }
+    }
+    free(line);
+
+    for (size_t i = 0; i < session.entry_count; i++) {
+        free(session.entries[i].input_file);
+        free(session.entries[i].output_base);
+    }
+    free(session.entries);
+    hash_table_free(&session.entry_index);
+    symbols_free(&session.symbols);
+    transpiler_free_header_index();
+    dir_listing_clear();
+    sibling_names_clear();
+    return 0;
+}
@@ -0,0 +1,26 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Long-running transpile server for build systems and editors (cz --serve).
+ *
+ * Requests are read one per line from the input stream:
+ *   transpile PATH [OUTPUT_BASE]        transpile PATH into OUTPUT_BASE.h/.c (default PATH)
+ *   buffer PATH SIZE [OUTPUT_BASE]      transpile the SIZE bytes following the line as the
+ *                                       contents of PATH (e.g., an unsaved editor buffer)
+ *   quit                                end the session
+ * Paths cannot contain whitespace. Each request prints the usual output and
+ * diagnostics, then a line "ok" or "error" on stdout. Errors end the request,
+ * not the session.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* Serve requests read from input until quit or end of input, returns the exit status.
+ * With dependencies, every transpile also writes its .d file (cz -MD), with minimal_headers
+ * its headers are minimal (cz --minimal-headers), with compact its outputs are (cz --compact). */
+int serve(FILE *input, const char *cache_dir, bool dependencies, bool minimal_headers, bool compact);
@@ -0,0 +1,422 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Names declared by sibling .cz files, so that cz --minimal-headers only
+ * auto-includes the sibling headers a file references, and the methods
+ * declared by the .cz files a file sees, so it can call them.
+ */
+
+#include "src/cz.h"
+#include "siblings.h"
+#include "input.h"
+#include "lexer.h"
+#include "worker.h"
+#include "dirlist.h"
+#include "depfile.h"
+#include "sink.h"
+#include <stdlib.h>
+#include <sys/stat.h>
+
+/* Top-level names of one scanned file */
+typedef struct {
+    char *path;                  /* File path */
+    long long size;              /* File size when scanned */
+    long long mtime;             /* Modification time when scanned (seconds) */
+    uint64_t *names;             /* hash_key_string of each declared name */
+    size_t name_count;           /* Number of names */
+    char *methods;               /* "Struct.method\n" of each declared method (NULL for none) */
+} SiblingNames_t;
+
+/* Scanned files (guarded by worker_lock, kept until sibling_names_clear) */
+static SiblingNames_t *siblings = NULL;
+static size_t sibling_count = 0;
+static size_t sibling_capacity = 0;
+static HashTable_t sibling_index;   /* Hash of path -> index in siblings */
+
+/* Growable list of name hashes, and the methods found along */
+typedef struct {
+    uint64_t *items;             /* Hashes */
+    size_t count;                /* Number of hashes */
+    size_t capacity;             /* Capacity of items */
+    OutputSink_t methods;        /* "Struct.method\n" lines */
+} NameList_t;
+
+/* Append the hash of length bytes of text */
+static void add_name(NameList_t *list, const char *text, size_t length) {
+    if (list->count >= list->capacity) {
+        size_t new_capacity = list->capacity == 0 ? 16 : list->capacity * 2;
+        uint64_t *new_items = realloc(list->items, new_capacity * sizeof(uint64_t));
+        if (!new_items) {
+            return;
+        }
+        list->items = new_items;
+        list->capacity = new_capacity;
+    }
+    char name[256];
+    if (length >= sizeof(name)) {
+        return;
+    }
+    memcpy(name, text, length);
+    name[length] = '\0';
+    list->items[list->count++] = hash_key_string(name);
+}
+
+/* Check whether a token is the single punctuation character c */
+static int is_punctuation(const Token *token, char c) {
+    return token->type == TOKEN_PUNCTUATION && token->length == 1 && token->text[0] == c;
+}
+
+/* Add the name a #define directive defines */
+static void add_macro_name(NameList_t *list, const Token *token) {
+    const char *p = token->text + 1;
+    const char *end = token->text + token->length;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if ((size_t)(end - p) < 6 || strncmp(p, "define", 6) != 0) {
+        return;
+    }
+    p += 6;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    const char *name = p;
+    while (p < end && is_identifier_char(*p, p == name)) p++;
+    if (p > name) {
+        add_name(list, name, (size_t)(p - name));
+    }
+}
+
+/* Add a method declaration "Struct.method(" */
+static void add_method(NameList_t *list, const char *struct_name, const Token *method) {
+    sink_puts(&list->methods, struct_name);
+    sink_putc(&list->methods, '.');
+    sink_write(&list->methods, method->text, method->length);
+    sink_putc(&list->methods, '\n');
+}
+
+/* Collect the names source declares outside function bodies: the identifier right before
+ * '(' ';' '=' ',' '[' or '{' at the top level, enum members, macros, and methods */
+static void scan_names(NameList_t *list, const char *source, size_t size) {
+    Lexer lexer;
+    lexer_init(&lexer, source, size);
+
+    int depth = 0;               /* Brace depth */
+    int parens = 0;              /* Parenthesis depth at the top level */
+    int enum_pending = 0;        /* Saw "enum" at the top level, its '{' opens a member list */
+    int enum_depth = 0;          /* Brace depth of the enum member list (0 outside) */
+    Token last;                  /* Last significant token */
+    int has_last = 0;
+    char method_struct[256];     /* Struct of "Struct.method(" at the top level */
+    int method_state = 0;        /* Tokens of it seen: 1 for "Struct.", 2 for "Struct.method" */
+
+    for (;;) {
+        Token token = lexer_next_token(&lexer);
+        if (token.type == TOKEN_EOF) {
+            token_free(&token);
+            break;
+        }
+        if (token.type == TOKEN_WHITESPACE || token.type == TOKEN_COMMENT) {
+            token_free(&token);
+            continue;
+        }
+        if (token.type == TOKEN_PREPROCESSOR) {
+            add_macro_name(list, &token);
+            token_free(&token);
+            has_last = 0;
+            continue;
+        }
+
+        int at_top = depth == 0 && parens == 0;
+        int in_enum = enum_depth > 0 && depth == enum_depth;
+        if (at_top && method_state == 2 && is_punctuation(&token, '(')) {
+            add_method(list, method_struct, &last);
+            method_state = 0;
+        } else if (at_top && method_state == 1 && token.type == TOKEN_IDENTIFIER) {
+            method_state = 2;
+        } else if (at_top && has_last && last.type == TOKEN_IDENTIFIER && last.length < sizeof(method_struct) &&
+                   token.length == 1 && token.text[0] == '.') {
+            memcpy(method_struct, last.text, last.length);
+            method_struct[last.length] = '\0';
+            method_state = 1;
+        } else {
+            method_state = 0;
+        }
+        if (has_last && last.type == TOKEN_IDENTIFIER && token.type == TOKEN_PUNCTUATION && token.length == 1) {
+            char c = token.text[0];
+            if ((at_top && (c == '(' || c == ';' || c == '=' || c == ',' || c == '[' || c == '{')) ||
+                (in_enum && (c == ',' || c == '=' || c == '}'))) {
+                add_name(list, last.text, last.length);
+            }
+        }
+
+        if (at_top && token.type == TOKEN_KEYWORD && token.length == 4 && strncmp(token.text, "enum", 4) == 0) {
+            enum_pending = 1;
+        } else if (is_punctuation(&token, '{')) {
+            depth++;
+            if (enum_pending && depth == 1) {
+                enum_depth = 1;
+            }
+            enum_pending = 0;
+        } else if (is_punctuation(&token, '}')) {
+            if (depth == enum_depth) {
+                enum_depth = 0;
+            }
+            if (depth > 0) depth--;
+        } else if (depth == 0 && is_punctuation(&token, '(')) {
+            parens++;
+        } else if (depth == 0 && is_punctuation(&token, ')')) {
+            if (parens > 0) parens--;
+        } else if (at_top && is_punctuation(&token, ';')) {
+            enum_pending = 0;
+        }
+
+        if (has_last) {
+            token_free(&last);
+        }
+        last = token;
+        has_last = 1;
+    }
+    if (has_last) {
+        token_free(&last);
+    }
+    lexer_cleanup(&lexer);
+}
+
+/* Free the names of a scanned file */
+static void free_sibling(SiblingNames_t *sibling) {
+    free(sibling->path);
+    free(sibling->names);
+    free(sibling->methods);
+}
+
+/* Get the cached names of path if it is unchanged since scanned (call under worker_lock) */
+static SiblingNames_t *find_sibling(const char *path, uint64_t key, long long size, long long mtime) {
+    size_t index = hash_table_get(&sibling_index, key);
+    if (index == HASH_TABLE_MISSING) {
+        return NULL;
+    }
+    SiblingNames_t *sibling = &siblings[index];
+    if (strcmp(sibling->path, path) != 0 || sibling->size != size || sibling->mtime != mtime) {
+        return NULL;
+    }
+    return sibling;
+}
+
+/* Keep the names scanned from path, replacing an outdated entry (call under worker_lock) */
+static void keep_sibling(const char *path, uint64_t key, long long size, long long mtime, NameList_t *names) {
+    size_t index = hash_table_get(&sibling_index, key);
+    if (index != HASH_TABLE_MISSING) {
+        if (strcmp(siblings[index].path, path) != 0) {
+            free(names->items); /* Hash collision, keep the other file */
+            sink_free(&names->methods);
+            return;
+        }
+        free(siblings[index].names);
+        free(siblings[index].methods);
+    } else {
+        if (sibling_count >= sibling_capacity) {
+            size_t new_capacity = sibling_capacity == 0 ? 16 : sibling_capacity * 2;
+            SiblingNames_t *new_siblings = realloc(siblings, new_capacity * sizeof(SiblingNames_t));
+            if (!new_siblings) {
+                free(names->items);
+                sink_free(&names->methods);
+                return;
+            }
+            siblings = new_siblings;
+            sibling_capacity = new_capacity;
+        }
+        char *path_copy = strdup(path);
+        if (!path_copy || !hash_table_put(&sibling_index, key, sibling_count)) {
+            free(path_copy);
+            free(names->items);
+            sink_free(&names->methods);
+            return;
+        }
+        index = sibling_count++;
+        siblings[index].path = path_copy;
+    }
+    siblings[index].size = size;
+    siblings[index].mtime = mtime;
+    siblings[index].names = names->items;
+    siblings[index].name_count = names->count;
+    siblings[index].methods = names->methods.length > 0 ? sink_take(&names->methods) : NULL;
+    sink_free(&names->methods);
+}
+
+/* Check whether one of count names is in identifiers */
+static bool any_name_in(const uint64_t *names, size_t count, const HashTable_t *identifiers) {
+    for (size_t i = 0; i < count; i++) {
+        if (hash_table_get(identifiers, names[i]) != HASH_TABLE_MISSING) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* What a request asks of a scanned file */
+typedef struct {
+    const HashTable_t *identifiers; /* Names to look for (sibling_referenced) */
+    bool referenced;                /* One of them is declared */
+    OutputSink_t *methods;          /* Methods to append to (module_methods) */
+} SiblingQuery_t;
+
+/* Answer query from the names of one file (under worker_lock for cached entries) */
+static void answer(SiblingQuery_t *query, const uint64_t *names, size_t count, const char *methods,
+                   size_t methods_length) {
+    if (query->identifiers) {
+        query->referenced = any_name_in(names, count, query->identifiers);
+    }
+    if (query->methods && methods) {
+        sink_write(query->methods, methods, methods_length);
+    }
+}
+
+/* Answer query from the .cz file at path, scanning it unless unchanged since the last scan.
+ * Returns false if the file cannot be read. */
+static bool query_sibling(const char *path, SiblingQuery_t *query) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    uint64_t key = hash_key_string(path);
+    long long size = (long long)st.st_size;
+    long long mtime = (long long)st.st_mtime;
+
+    worker_lock();
+    SiblingNames_t *sibling = find_sibling(path, key, size, mtime);
+    if (sibling) {
+        answer(query, sibling->names, sibling->name_count, sibling->methods,
+               sibling->methods ? strlen(sibling->methods) : 0);
+    }
+    worker_unlock();
+    if (sibling) {
+        return true;
+    }
+
+    /* Scan outside the lock, the last scan of a file is kept */
+    InputFile_t input;
+    if (input_open(&input, path) != INPUT_OK) {
+        return false;
+    }
+    NameList_t names = { NULL, 0, 0, { 0 } };
+    sink_init(&names.methods, NULL);
+    scan_names(&names, input.data, input.size);
+    input_close(&input);
+
+    answer(query, names.items, names.count, names.methods.data, names.methods.length);
+    worker_lock();
+    keep_sibling(path, key, size, mtime, &names);
+    worker_unlock();
+    return true;
+}
+
+/* Check whether a name the .cz file at path declares at top level (functions, methods, types,
+ * enum members, globals, macros) is in identifiers, a set of hash_key_string keys.
+ * Files that cannot be read count as referenced. */
+bool sibling_referenced(const char *path, const HashTable_t *identifiers) {
+    SiblingQuery_t query = { identifiers, false, NULL };
+    return !query_sibling(path, &query) || query.referenced;
+}
+
+/* Append the methods of directory/name, recording it as read (cz -MD) */
+static void add_file_methods(OutputSink_t *methods, const char *directory, const char *name) {
+    size_t len = strlen(directory) + strlen(name) + 2;
+    char *path = malloc(len);
+    if (!path) {
+        return;
+    }
+    if (strcmp(directory, ".") == 0) {
+        snprintf(path, len, "%s", name);
+    } else {
+        snprintf(path, len, "%s/%s", directory, name);
+    }
+    SiblingQuery_t query = { NULL, false, methods };
+    if (query_sibling(path, &query)) {
+        dependency_record_in(directory, name, DEPENDENCY_READ);
+    }
+    free(path);
+}
+
+/* Append the methods of every .cz file of directory but skip (NULL for none) */
+static void add_directory_methods(OutputSink_t *methods, const char *directory, const char *skip) {
+    const DirListing_t *listing = dir_listing_cz(directory);
+    for (size_t i = 0; listing && i < listing->count; i++) {
+        if (!skip || strcmp(listing->names[i], skip) != 0) {
+            add_file_methods(methods, directory, listing->names[i]);
+        }
+    }
+}
+
+/* Get the methods declared by the .cz files input_file sees: its siblings, and the module
+ * directories or module.cz files of the #import directives of source (size bytes).
+ * Returns "Struct.method\n" lines to free ("" when none, NULL on allocation failure). */
+char *module_methods(const char *input_file, const char *source, size_t size) {
+    OutputSink_t methods;
+    sink_init(&methods, NULL);
+
+    const char *slash = strrchr(input_file, '/');
+    size_t dir_len = slash ? (slash == input_file ? 1 : (size_t)(slash - input_file)) : 1;
+    char *directory = malloc(dir_len + 1);
+    if (!directory) {
+        return sink_take(&methods);
+    }
+    memcpy(directory, slash ? input_file : ".", dir_len);
+    directory[dir_len] = '\0';
+    add_directory_methods(&methods, directory, slash ? slash + 1 : input_file);
+
+    /* #import "module" at the start of a line, like the emitter and the cache key */
+    const char *end = source + size;
+    for (const char *line = source; line < end; ) {
+        const char *next = memchr(line, '\n', (size_t)(end - line));
+        next = next ? next + 1 : end;
+
+        const char *p = line;
+        while (p < next && (*p == ' ' || *p == '\t')) p++;
+        if ((size_t)(next - p) > 7 && strncmp(p, "#import", 7) == 0) {
+            const char *open = memchr(p, '"', (size_t)(next - p));
+            const char *close = open ? memchr(open + 1, '"', (size_t)(next - open - 1)) : NULL;
+            if (close) {
+                size_t module_len = (size_t)(close - open - 1);
+                size_t path_len = dir_len + module_len + sizeof("/.cz");
+                char *module_path = malloc(path_len);
+                if (module_path) {
+                    if (strcmp(directory, ".") == 0) {
+                        snprintf(module_path, path_len, "%.*s", (int)module_len, open + 1);
+                    } else {
+                        snprintf(module_path, path_len, "%s/%.*s", directory, (int)module_len, open + 1);
+                    }
+                    struct stat st;
+                    if (stat(module_path, &st) == 0 && S_ISDIR(st.st_mode)) {
+                        add_directory_methods(&methods, module_path, NULL);
+                    } else {
+                        strcat(module_path, ".cz");
+                        char *module_slash = strrchr(module_path, '/');
+                        if (module_slash) {
+                            *module_slash = '\0';
+                            add_file_methods(&methods, module_path, module_slash + 1);
+                        } else {
+                            add_file_methods(&methods, ".", module_path);
+                        }
+                    }
+                    free(module_path);
+                }
+            }
+        }
+        line = next;
+    }
+    free(directory);
+    return sink_take(&methods);
+}
+
+/* Forget every scanned file */
+void sibling_names_clear(void) {
+    worker_lock();
+    for (size_t i = 0; i < sibling_count; i++) {
+        free_sibling(&siblings[i]);
+    }
+    free(siblings);
+    siblings = NULL;
+    sibling_count = 0;
+    sibling_capacity = 0;
+    hash_table_free(&sibling_index);
+    worker_unlock();
+}
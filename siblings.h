@@ -0,0 +1,28 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Names declared by sibling .cz files, so that cz --minimal-headers only
+ * auto-includes the sibling headers a file references, and the methods
+ * declared by the .cz files a file sees, so it can call them.
+ */
+
+#pragma once
+
+#include "hashtable.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Check whether a name the .cz file at path declares at top level (functions, methods, types,
+ * enum members, globals, macros) is in identifiers, a set of hash_key_string keys.
+ * Files that cannot be read count as referenced. */
+bool sibling_referenced(const char *path, const HashTable_t *identifiers);
+
+/* Get the methods declared by the .cz files input_file sees: its siblings, and the module
+ * directories or module.cz files of the #import directives of source (size bytes).
+ * Returns "Struct.method\n" lines to free ("" when none, NULL on allocation failure). */
+char *module_methods(const char *input_file, const char *source, size_t size);
+
+/* Forget every scanned file */
+void sibling_names_clear(void);
@@ -0,0 +1,113 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Contiguous output buffer the emitters write into, kept in memory or flushed to a stream.
+ */
+
+#include "src/cz.h"
+#include "sink.h"
+#include <stdlib.h>
+
+/* Initialize a sink writing to file, or collecting everything in memory when file is NULL */
+void sink_init(OutputSink_t *sink, FILE *file) {
+    sink->data = NULL;
+    sink->length = 0;
+    sink->capacity = 0;
+    sink->file = file;
+    sink->failed = false;
+}
+
+/* Free the buffer (without flushing) */
+void sink_free(OutputSink_t *sink) {
+    free(sink->data);
+    sink->data = NULL;
+    sink->length = 0;
+    sink->capacity = 0;
+}
+
+/* Write the buffered bytes to the stream and empty the buffer */
+static void write_out(OutputSink_t *sink) {
+    if (sink->file && sink->length > 0) {
+        if (fwrite(sink->data, 1, sink->length, sink->file) != sink->length) {
+            sink->failed = true;
+        }
+        sink->length = 0;
+    }
+}
+
+/* Make room for size more bytes, flushing or growing the buffer; returns false on failure */
+bool sink_reserve(OutputSink_t *sink, size_t size) {
+    if (sink->capacity - sink->length >= size) {
+        return true;
+    }
+    if (sink->failed) {
+        return false;
+    }
+    write_out(sink);
+    if (sink->capacity - sink->length >= size) {
+        return true;
+    }
+
+    size_t new_capacity = sink->capacity == 0 ? (sink->file ? SINK_STREAM_BUFFER : 4096) : sink->capacity;
+    while (new_capacity - sink->length < size) {
+        new_capacity *= 2;
+    }
+    char *new_data = realloc(sink->data, new_capacity);
+    if (!new_data) {
+        sink->failed = true;
+        return false;
+    }
+    sink->data = new_data;
+    sink->capacity = new_capacity;
+    return true;
+}
+
+/* Write the buffered bytes to the stream (no-op for memory sinks), returns false if any write failed */
+bool sink_flush(OutputSink_t *sink) {
+    write_out(sink);
+    if (sink->file && fflush(sink->file) != 0) {
+        sink->failed = true;
+    }
+    return !sink->failed;
+}
+
+/* NUL-terminate the text of a memory sink and hand it over (the sink is left empty), NULL if any write failed */
+char *sink_take(OutputSink_t *sink) {
+    sink_putc(sink, '\0');
+    char *text = sink->failed ? NULL : sink->data;
+    if (!text) {
+        free(sink->data);
+    }
+    sink->data = NULL;
+    sink->length = 0;
+    sink->capacity = 0;
+    return text;
+}
+
+/* Append formatted text from a va_list */
+void sink_vprintf(OutputSink_t *sink, const char *format, va_list args) {
+    va_list again;
+    va_copy(again, args);
+    char small[256];
+    int needed = vsnprintf(small, sizeof(small), format, args);
+    if (needed < 0) {
+        sink->failed = true;
+    } else if ((size_t)needed < sizeof(small)) {
+        sink_write(sink, small, (size_t)needed);
+    } else if (sink_reserve(sink, (size_t)needed + 1)) {
+        /* Longer than the scratch buffer: format straight into the sink */
+        vsnprintf(sink->data + sink->length, (size_t)needed + 1, format, again);
+        sink->length += (size_t)needed;
+    }
+    va_end(again);
+}
+
+/* Append formatted text */
+void sink_printf(OutputSink_t *sink, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    sink_vprintf(sink, format, args);
+    va_end(args);
+}
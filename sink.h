@@ -0,0 +1,74 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Contiguous output buffer the emitters write into, kept in memory or flushed to a stream.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+
+/* Bytes buffered before a stream sink writes them out */
+#define SINK_STREAM_BUFFER (64 * 1024)
+
+/* Output sink: everything lands in one buffer, written to file in large blocks when there is one */
+typedef struct {
+    char *data;                  /* Buffered bytes */
+    size_t length;               /* Number of buffered bytes */
+    size_t capacity;             /* Capacity of data */
+    FILE *file;                  /* Stream flushed to when the buffer fills (NULL keeps everything in memory) */
+    bool failed;                 /* An allocation or write failed, output is incomplete */
+} OutputSink_t;
+
+/* Initialize a sink writing to file, or collecting everything in memory when file is NULL */
+void sink_init(OutputSink_t *sink, FILE *file);
+
+/* Free the buffer (without flushing) */
+void sink_free(OutputSink_t *sink);
+
+/* Make room for size more bytes, flushing or growing the buffer; returns false on failure */
+bool sink_reserve(OutputSink_t *sink, size_t size);
+
+/* Write the buffered bytes to the stream (no-op for memory sinks), returns false if any write failed */
+bool sink_flush(OutputSink_t *sink);
+
+/* NUL-terminate the text of a memory sink and hand it over (the sink is left empty), NULL if any write failed */
+char *sink_take(OutputSink_t *sink);
+
+/* Append formatted text from a va_list */
+void sink_vprintf(OutputSink_t *sink, const char *format, va_list args);
+
+/* Append formatted text */
+void sink_printf(OutputSink_t *sink, const char *format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+/* Append size bytes */
+static inline void sink_write(OutputSink_t *sink, const char *data, size_t size) {
+    if (sink->capacity - sink->length < size && !sink_reserve(sink, size)) {
+        return;
+    }
+    memcpy(sink->data + sink->length, data, size);
+    sink->length += size;
+}
+
+/* Append a NUL-terminated string */
+static inline void sink_puts(OutputSink_t *sink, const char *text) {
+    sink_write(sink, text, strlen(text));
+}
+
+/* Append one character */
+static inline void sink_putc(OutputSink_t *sink, char c) {
+    if (sink->length == sink->capacity && !sink_reserve(sink, 1)) {
+        return;
+    }
+    sink->data[sink->length++] = c;
+}
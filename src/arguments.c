@@ -9,30 +9,62 @@
 #include "cz.h"
 #include "arguments.h"
 #include "errors.h"
+#include "headers.h"
+#include "../hashtable.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-/* Maximum function declarations we can track */
-#define MAX_FUNCTIONS 256
+/* Maximum parameters tracked per function declaration or call */
 #define MAX_PARAMS 32
 
-/* Function parameter info */
+/* Function parameter info (registered names are interned) */
 typedef struct {
-    char *name;
-    char *type;  /* Parameter type for ambiguity checking */
+    const char *name;
+    const char *type;  /* Parameter type for ambiguity checking */
 } ParamInfo;
 
 /* Function declaration info */
 typedef struct {
-    char *name;
-    ParamInfo params[MAX_PARAMS];
+    const char *name;
+    ParamInfo *params;
     int param_count;
 } FunctionInfo;
 
 /* Global tracking */
-static FunctionInfo g_functions[MAX_FUNCTIONS];
-static int g_function_count = 0;
+static CZ_THREAD_LOCAL FunctionInfo *g_functions = NULL;
+static CZ_THREAD_LOCAL int g_function_count = 0;
+static CZ_THREAD_LOCAL int g_function_capacity = 0;
+
+/* Interned function name -> index in g_functions */
+static CZ_THREAD_LOCAL HashTable_t g_function_index;
+
+/* Forget registered functions (names stay in the interner) */
+static void clear_functions(void) {
+    for (int i = 0; i < g_function_count; i++) {
+        free(g_functions[i].params);
+    }
+    g_function_count = 0;
+    hash_table_clear(&g_function_index);
+}
+
+/* Release the function registry of the current translation unit */
+void transpiler_free_function_tables(void) {
+    clear_functions();
+    free(g_functions);
+    g_functions = NULL;
+    g_function_capacity = 0;
+    hash_table_free(&g_function_index);
+}
+
+/* Get the bytes held by the function registry (cz --stats) */
+size_t transpiler_function_table_bytes(void) {
+    size_t bytes = (size_t)g_function_capacity * sizeof(FunctionInfo);
+    for (int i = 0; i < g_function_count; i++) {
+        bytes += (size_t)g_functions[i].param_count * sizeof(ParamInfo);
+    }
+    return bytes + hash_table_bytes(&g_function_index);
+}
 
 /* Helper function to check if token text matches */
 static int token_text_equals(Token *token, const char *text) {
@@ -42,62 +74,76 @@ static int token_text_equals(Token *token, const char *text) {
     return strcmp(token->text, text) == 0;
 }
 
-/* Skip whitespace and comment tokens */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t i) {
-    while (i < count) {
-        if (children[i]->type != AST_TOKEN) {
-            i++;
-            continue;
-        }
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            break;
-        }
-        i++;
-    }
-    return i;
+/* Find a registered function by its interned name */
+static FunctionInfo *find_function(const char *interned_name) {
+    size_t index = hash_table_get(&g_function_index, hash_key_pointer(interned_name));
+    return index == HASH_TABLE_MISSING ? NULL : &g_functions[index];
 }
 
 /* Register a function declaration with its parameters */
 static void register_function(const char *func_name, ParamInfo *params, int param_count) {
-    if (g_function_count >= MAX_FUNCTIONS) {
+    /* Check if already registered */
+    const char *interned_name = cz_intern_name(func_name);
+    if (!interned_name || find_function(interned_name)) {
         return;
     }
 
-    /* Check if already registered */
-    for (int i = 0; i < g_function_count; i++) {
-        if (g_functions[i].name && strcmp(g_functions[i].name, func_name) == 0) {
-            return; /* Already registered */
+    if (g_function_count >= g_function_capacity) {
+        int new_capacity = g_function_capacity == 0 ? 16 : g_function_capacity * 2;
+        FunctionInfo *new_functions = realloc(g_functions, (size_t)new_capacity * sizeof(FunctionInfo));
+        if (!new_functions) {
+            return;
         }
+        g_functions = new_functions;
+        g_function_capacity = new_capacity;
     }
 
     FunctionInfo *func = &g_functions[g_function_count];
-    func->name = strdup(func_name);
+    func->name = interned_name;
     func->param_count = param_count;
+    func->params = malloc((size_t)param_count * sizeof(ParamInfo));
+    if (!func->params) {
+        return;
+    }
 
-    for (int i = 0; i < param_count && i < MAX_PARAMS; i++) {
-        func->params[i].name = params[i].name ? strdup(params[i].name) : NULL;
-        func->params[i].type = params[i].type ? strdup(params[i].type) : NULL;
+    for (int i = 0; i < param_count; i++) {
+        func->params[i].name = params[i].name ? cz_intern_name(params[i].name) : NULL;
+        func->params[i].type = params[i].type ? cz_intern_name(params[i].type) : NULL;
     }
 
+    if (!hash_table_put(&g_function_index, hash_key_pointer(interned_name), (size_t)g_function_count)) {
+        free(func->params);
+        return;
+    }
     g_function_count++;
 }
 
-/* Find a registered function by name */
-static FunctionInfo *find_function(const char *func_name) {
-    for (int i = 0; i < g_function_count; i++) {
-        if (g_functions[i].name && strcmp(g_functions[i].name, func_name) == 0) {
-            return &g_functions[i];
+/* Register the prototypes of an imported header (functions of this file were registered first and win) */
+static void register_header_functions(const HeaderIndex_t *header, void *context) {
+    (void)context;
+    for (size_t i = 0; i < header->function_count; i++) {
+        const HeaderFunction_t *function = &header->functions[i];
+        if (function->param_count == 0 || function->param_count > MAX_PARAMS) {
+            continue;
+        }
+        ParamInfo params[MAX_PARAMS];
+        for (size_t j = 0; j < function->param_count; j++) {
+            params[j].name = function->params[j].name;
+            params[j].type = function->params[j].type;
         }
+        register_function(function->name, params, (int)function->param_count);
     }
-    return NULL;
 }
 
 /* Check if a token is a type keyword or identifier */
 static int is_type_token(Token *token) {
     if (!token || !token->text) return 0;
 
-    if (token->type == TOKEN_KEYWORD) return 1;
+    /* Statement keywords come before calls ("return f(...)"), not declarations */
+    if (token->type == TOKEN_KEYWORD) {
+        return strcmp(token->text, "return") != 0 && strcmp(token->text, "else") != 0 &&
+               strcmp(token->text, "do") != 0 && strcmp(token->text, "case") != 0;
+    }
     if (token->type != TOKEN_IDENTIFIER) return 0;
 
     /* Check common type names */
@@ -125,18 +171,16 @@ static void scan_function_declarations(ASTNode_t **children, size_t count) {
         Token *tok = &children[i]->token;
 
         /* Look for function name followed by ( */
-        size_t j = skip_whitespace(children, count, i + 1);
+        size_t j = ast_skip_trivia(children, count, i + 1);
         if (j >= count) continue;
         if (children[j]->type != AST_TOKEN) continue;
         if (!token_text_equals(&children[j]->token, "(")) continue;
 
         /* Check if this is a function declaration by looking backward for return type */
         int is_function_decl = 0;
-        for (int k = (int)i - 1; k >= 0 && k >= (int)i - 10; k--) {
-            if (children[k]->type != AST_TOKEN) continue;
-            if (children[k]->token.type == TOKEN_WHITESPACE ||
-                children[k]->token.type == TOKEN_COMMENT) continue;
-
+        for (size_t k = ast_prev_significant(children, i);
+             k != AST_NO_MATCH && k + 10 >= i;
+             k = ast_prev_significant(children, k)) {
             if (is_type_token(&children[k]->token)) {
                 is_function_decl = 1;
                 break;
@@ -177,13 +221,13 @@ static void scan_function_declarations(ASTNode_t **children, size_t count) {
                 /* If we see a type, look ahead for the parameter name */
                 if (is_type_token(t)) {
                     const char *param_type = t->text;
-                    size_t k = skip_whitespace(children, count, j + 1);
+                    size_t k = ast_skip_trivia(children, count, j + 1);
 
                     /* Skip pointer markers */
                     while (k < count && children[k]->type == AST_TOKEN &&
                            children[k]->token.type == TOKEN_OPERATOR &&
                            token_text_equals(&children[k]->token, "*")) {
-                        k = skip_whitespace(children, count, k + 1);
+                        k = ast_skip_trivia(children, count, k + 1);
                     }
 
                     /* Get parameter name */
@@ -191,11 +235,7 @@ static void scan_function_declarations(ASTNode_t **children, size_t count) {
                         (children[k]->token.type == TOKEN_IDENTIFIER || 
                          children[k]->token.type == TOKEN_KEYWORD)) {
                         params[param_count].name = children[k]->token.text;
-                        params[param_count].type = strdup(param_type);
-                        if (!params[param_count].type) {
-                            /* Memory allocation failed, skip this parameter */
-                            continue;
-                        }
+                        params[param_count].type = param_type;
                         param_count++;
                     }
                 }
@@ -218,10 +258,11 @@ static void transform_function_call(ASTNode_t **children, size_t count, size_t c
     if (children[call_pos]->type != AST_TOKEN) return;
 
     const char *func_name = children[call_pos]->token.text;
-    FunctionInfo *func_info = find_function(func_name);
+    FunctionInfo *func_info = g_function_count > 0 ?
+        find_function(cz_symbol_name(cz_token_symbol(&children[call_pos]->token))) : NULL;
 
     /* Find opening paren */
-    size_t j = skip_whitespace(children, count, call_pos + 1);
+    size_t j = ast_skip_trivia(children, count, call_pos + 1);
     if (j >= count || children[j]->type != AST_TOKEN) return;
     if (!token_text_equals(&children[j]->token, "(")) return;
 
@@ -259,7 +300,7 @@ static void transform_function_call(ASTNode_t **children, size_t count, size_t c
 
         /* Check if this argument has a label */
         if (paren_depth == 1 && (t->type == TOKEN_IDENTIFIER || t->type == TOKEN_KEYWORD)) {
-            size_t k = skip_whitespace(children, count, scan_j + 1);
+            size_t k = ast_skip_trivia(children, count, scan_j + 1);
             if (k < count && children[k]->type == AST_TOKEN &&
                 children[k]->token.type == TOKEN_OPERATOR &&
                 token_text_equals(&children[k]->token, "=")) {
@@ -274,8 +315,8 @@ static void transform_function_call(ASTNode_t **children, size_t count, size_t c
     if (func_info && arg_count >= 2) {
         for (int i = 0; i < func_info->param_count - 1 && i < arg_count - 1; i++) {
             /* Check if consecutive parameters have the same type */
-            if (func_info->params[i].type && func_info->params[i + 1].type &&
-                strcmp(func_info->params[i].type, func_info->params[i + 1].type) == 0) {
+            if (func_info->params[i].type &&
+                func_info->params[i].type == func_info->params[i + 1].type) {
 
                 /* Check if both arguments are unlabeled */
                 if (!arg_labeled[i] && !arg_labeled[i + 1]) {
@@ -291,7 +332,7 @@ static void transform_function_call(ASTNode_t **children, size_t count, size_t c
                                 func_info->params[i + 1].name);
                         snprintf(error_msg, sizeof(error_msg),
                                 ERR_AMBIGUOUS_ARGUMENTS, suggestion);
-                        cz_error(g_filename, g_source, children[call_pos]->token.line, error_msg);
+                        cz_error_at(g_filename, g_source, children[call_pos]->token.line, children[call_pos]->token.column, error_msg);
                     }
                     break;  /* Only error once per function call */
                 }
@@ -325,7 +366,7 @@ static void transform_function_call(ASTNode_t **children, size_t count, size_t c
 
         /* Look for pattern: identifier = value */
         if (paren_depth == 1 && (t->type == TOKEN_IDENTIFIER || t->type == TOKEN_KEYWORD)) {
-            size_t k = skip_whitespace(children, count, j + 1);
+            size_t k = ast_skip_trivia(children, count, j + 1);
             if (k < count && children[k]->type == AST_TOKEN &&
                 children[k]->token.type == TOKEN_OPERATOR &&
                 token_text_equals(&children[k]->token, "=")) {
@@ -344,7 +385,7 @@ static void transform_function_call(ASTNode_t **children, size_t count, size_t c
                                     "Named argument '%s' at position %d does not match expected parameter '%s'. "
                                     "Named arguments must preserve parameter order.",
                                     label, arg_index + 1, expected_param);
-                            cz_error(g_filename, g_source, t->line, error_msg);
+                            cz_error_at(g_filename, g_source, t->line, t->column, error_msg);
                         }
                     }
                 } else {
@@ -354,32 +395,24 @@ static void transform_function_call(ASTNode_t **children, size_t count, size_t c
 
                 /* Strip the label, =, and any whitespace after = */
                 /* Strip the label */
-                free(t->text);
-                t->text = strdup("");
-                t->length = 0;
+                token_set_text(t, "");
 
                 /* Strip whitespace between label and = */
                 for (size_t m = j + 1; m < k; m++) {
                     if (children[m]->type == AST_TOKEN &&
                         children[m]->token.type == TOKEN_WHITESPACE) {
-                        free(children[m]->token.text);
-                        children[m]->token.text = strdup("");
-                        children[m]->token.length = 0;
+                        token_set_text(&children[m]->token, "");
                     }
                 }
 
                 /* Strip the = operator */
-                free(children[k]->token.text);
-                children[k]->token.text = strdup("");
-                children[k]->token.length = 0;
+                token_set_text(&children[k]->token, "");
 
                 /* Strip whitespace after = */
                 size_t m = k + 1;
                 while (m < count && children[m]->type == AST_TOKEN &&
                        children[m]->token.type == TOKEN_WHITESPACE) {
-                    free(children[m]->token.text);
-                    children[m]->token.text = strdup("");
-                    children[m]->token.length = 0;
+                    token_set_text(&children[m]->token, "");
                     m++;
                 }
             }
@@ -397,13 +430,14 @@ void transpiler_transform_named_arguments(ASTNode_t *ast, const char *filename,
 
     g_filename = filename;
     g_source = source;
-    g_function_count = 0;
+    clear_functions();
 
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
 
     /* First pass: scan for function declarations */
     scan_function_declarations(children, count);
+    header_index_imports(ast, filename, register_header_functions, NULL);
 
     /* Second pass: transform function calls with named arguments */
     for (size_t i = 0; i < count; i++) {
@@ -422,18 +456,16 @@ void transpiler_transform_named_arguments(ASTNode_t *ast, const char *filename,
         }
 
         /* Look for function call pattern: identifier ( */
-        size_t j = skip_whitespace(children, count, i + 1);
+        size_t j = ast_skip_trivia(children, count, i + 1);
         if (j >= count) continue;
         if (children[j]->type != AST_TOKEN) continue;
         if (!token_text_equals(&children[j]->token, "(")) continue;
 
         /* Check if this is NOT a function declaration */
         int is_declaration = 0;
-        for (int k = (int)i - 1; k >= 0 && k >= (int)i - 10; k--) {
-            if (children[k]->type != AST_TOKEN) continue;
-            if (children[k]->token.type == TOKEN_WHITESPACE ||
-                children[k]->token.type == TOKEN_COMMENT) continue;
-
+        for (size_t k = ast_prev_significant(children, i);
+             k != AST_NO_MATCH && k + 10 >= i;
+             k = ast_prev_significant(children, k)) {
             if (is_type_token(&children[k]->token)) {
                 is_declaration = 1;
                 break;
@@ -447,13 +479,6 @@ void transpiler_transform_named_arguments(ASTNode_t *ast, const char *filename,
         }
     }
 
-    /* Cleanup */
-    for (int i = 0; i < g_function_count; i++) {
-        free(g_functions[i].name);
-        for (int j = 0; j < g_functions[i].param_count; j++) {
-            free(g_functions[i].params[j].name);
-            free(g_functions[i].params[j].type);
-        }
-    }
-    g_function_count = 0;
+    /* Cleanup (names stay in the interner) */
+    clear_functions();
 }
@@ -16,3 +16,9 @@
 
 /* Transform named arguments in function calls by stripping labels */
 void transpiler_transform_named_arguments(ASTNode_t *ast, const char *filename, const char *source);
+
+/* Release the function registry of the current translation unit */
+void transpiler_free_function_tables(void);
+
+/* Get the bytes held by the function registry (cz --stats) */
+size_t transpiler_function_table_bytes(void);
@@ -9,80 +9,63 @@
 
 #include "cz.h"
 #include "autodereference.h"
+#include "scopes.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
 
-/* Maximum number of identifiers we can track */
-#define MAX_TRACKED_IDENTIFIERS 1024
-
 /* Search window for looking ahead/back in token stream */
 #define TOKEN_SEARCH_WINDOW 5
 
-/* Tracked identifier (variable/parameter that is a pointer) */
-typedef struct {
-    char *name;
-    int is_pointer;
-    size_t declaration_index; /* Position in token stream where this was declared */
-} TrackedIdentifier;
-
-/* Global state for tracking identifiers */
-static TrackedIdentifier tracked_ids[MAX_TRACKED_IDENTIFIERS];
-static size_t tracked_count = 0;
-
-/* Add an identifier to tracking */
-static void track_identifier(const char *name, int is_pointer, size_t position) {
-    if (tracked_count >= MAX_TRACKED_IDENTIFIERS) {
-        return; /* Tracking limit reached */
-    }
+/* Pointer parameters and locals, bound in the block that declares them (value 1 for pointers) */
+static CZ_THREAD_LOCAL ScopeTable_t tracked_scopes;
 
-    /* Check if already tracked - update if so (keep the earliest declaration) */
-    for (size_t i = 0; i < tracked_count; i++) {
-        if (tracked_ids[i].name && strcmp(tracked_ids[i].name, name) == 0) {
-            /* Only update if this is an earlier declaration */
-            if (position < tracked_ids[i].declaration_index) {
-                tracked_ids[i].is_pointer = is_pointer;
-                tracked_ids[i].declaration_index = position;
-            }
+/* Pointer parameters of the function declarator being scanned, bound when its body opens */
+static CZ_THREAD_LOCAL int *pending_params = NULL;
+static CZ_THREAD_LOCAL size_t pending_count = 0;
+static CZ_THREAD_LOCAL size_t pending_capacity = 0;
+
+/* Remember a pointer parameter until the function body opens */
+static void track_parameter(int name) {
+    if (name == SYM_NONE) {
+        return;
+    }
+    if (pending_count >= pending_capacity) {
+        size_t new_capacity = pending_capacity == 0 ? 16 : pending_capacity * 2;
+        int *new_params = realloc(pending_params, new_capacity * sizeof(int));
+        if (!new_params) {
             return;
         }
+        pending_params = new_params;
+        pending_capacity = new_capacity;
     }
-
-    /* Add new tracking entry */
-    char *name_copy = strdup(name);
-    if (!name_copy) {
-        return; /* Memory allocation failed, cannot track */
-    }
-
-    tracked_ids[tracked_count].name = name_copy;
-    tracked_ids[tracked_count].is_pointer = is_pointer;
-    tracked_ids[tracked_count].declaration_index = position;
-    tracked_count++;
+    pending_params[pending_count++] = name;
 }
 
-/* Check if an identifier is tracked as a pointer at a given position */
-static int is_tracked_pointer_at(const char *name, size_t position) {
-    for (size_t i = 0; i < tracked_count; i++) {
-        if (tracked_ids[i].name && strcmp(tracked_ids[i].name, name) == 0) {
-            /* Only consider it a pointer if this usage is after the declaration */
-            if (position > tracked_ids[i].declaration_index) {
-                return tracked_ids[i].is_pointer;
-            }
-        }
-    }
-    return 0; /* Not tracked or not a pointer or used before declaration */
+/* Check if an identifier is a pointer in the innermost scope declaring it */
+static int is_tracked_pointer(int name) {
+    return scope_lookup(&tracked_scopes, name) == 1;
 }
 
 /* Clear tracking (called at start of each translation unit) */
 static void clear_tracking(void) {
-    for (size_t i = 0; i < tracked_count; i++) {
-        if (tracked_ids[i].name) {
-            free(tracked_ids[i].name);
-            tracked_ids[i].name = NULL;
-        }
-    }
-    tracked_count = 0;
+    scope_clear(&tracked_scopes);
+    pending_count = 0;
+}
+
+/* Release identifier tracking of the current translation unit */
+void transpiler_free_autodereference_tables(void) {
+    scope_free(&tracked_scopes);
+    free(pending_params);
+    pending_params = NULL;
+    pending_count = 0;
+    pending_capacity = 0;
+}
+
+/* Get the bytes held by identifier tracking (cz --stats) */
+size_t transpiler_autodereference_table_bytes(void) {
+    return scope_bytes(&tracked_scopes) + pending_capacity * sizeof(int);
 }
 
 /* Check if a token represents a pointer type (contains '*') */
@@ -93,108 +76,117 @@ static int token_is_pointer_type(const Token *token) {
     return strchr(token->text, '*') != NULL;
 }
 
-/* Scan AST to track pointer declarations and parameters */
-static void scan_for_pointers(ASTNode_t *node) {
-    if (!node) {
-        return;
-    }
-
-    if (node->type == AST_TRANSLATION_UNIT) {
-        int paren_depth = 0;
-        int in_function_params = 0;
-        int brace_depth = 0;
-
-        /* Track brace depth to know when we're in a function body */
-        /* Track paren depth to know when we're in function parameters */
-        /* Only track pointer parameters from function declarations */
-
-        for (size_t i = 0; i < node->child_count; i++) {
-            ASTNode_t *child = node->children[i];
-            if (child->type != AST_TOKEN) continue;
-
-            Token *tok = &child->token;
-
-            /* Track braces for scope */
-            if (tok->type == TOKEN_PUNCTUATION) {
-                if (strcmp(tok->text, "{") == 0) {
-                    brace_depth++;
-                } else if (strcmp(tok->text, "}") == 0) {
-                    brace_depth--;
-                }
-            }
-
-            /* Track parentheses */
-            if (tok->type == TOKEN_PUNCTUATION) {
-                if (strcmp(tok->text, "(") == 0) {
-                    paren_depth++;
-                    /* Check if this might be function parameters */
-                    /* Look back to see if there's an identifier before ( */
-                    if (i > 0 && brace_depth == 0) {
-                        /* Skip back over whitespace */
-                        for (int j = (int)i - 1; j >= 0 && j >= (int)i - TOKEN_SEARCH_WINDOW; j--) {
-                            ASTNode_t *prev = node->children[j];
-                            if (prev->type != AST_TOKEN) continue;
-                            Token *prevtok = &prev->token;
-                            if (prevtok->type == TOKEN_WHITESPACE) continue;
-                            if (prevtok->type == TOKEN_IDENTIFIER) {
-                                /* Found identifier before (, likely a function declaration */
-                                in_function_params = 1;
-                            }
-                            break;
-                        }
-                    }
-                } else if (strcmp(tok->text, ")") == 0) {
-                    paren_depth--;
-                    if (paren_depth == 0) {
-                        in_function_params = 0;
+/* Track the pointer parameters of a function declarator at file scope */
+static void scan_parameter(ASTNode_t *node, size_t i, int *paren_depth, int *in_function_params) {
+    Token *tok = &node->children[i]->token;
+
+    /* Track parentheses */
+    if (tok->type == TOKEN_PUNCTUATION) {
+        if (strcmp(tok->text, "(") == 0) {
+            (*paren_depth)++;
+            /* Check if this might be function parameters */
+            /* Look back to see if there's an identifier before ( */
+            if (i > 0) {
+                /* Skip back over whitespace */
+                for (int j = (int)i - 1; j >= 0 && j >= (int)i - TOKEN_SEARCH_WINDOW; j--) {
+                    ASTNode_t *prev = node->children[j];
+                    if (prev->type != AST_TOKEN) continue;
+                    Token *prevtok = &prev->token;
+                    if (prevtok->type == TOKEN_WHITESPACE) continue;
+                    if (prevtok->type == TOKEN_IDENTIFIER) {
+                        /* Found identifier before (, likely a function declaration */
+                        *in_function_params = 1;
                     }
+                    break;
                 }
             }
+        } else if (strcmp(tok->text, ")") == 0) {
+            (*paren_depth)--;
+            if (*paren_depth == 0) {
+                *in_function_params = 0;
+            }
+        } else if (strcmp(tok->text, ";") == 0 && *paren_depth == 0) {
+            /* A prototype, its parameters have no body to be bound in */
+            pending_count = 0;
+        }
+    }
 
-            /* Only track pointers in function parameter lists */
-            if (in_function_params && paren_depth > 0 && brace_depth == 0) {
-                /* Look for pointer operator * */
-                if (tok->type == TOKEN_OPERATOR && token_is_pointer_type(tok)) {
-                    /* Look ahead for identifier, skipping whitespace */
-                    for (size_t j = i + 1; j < node->child_count && j < i + TOKEN_SEARCH_WINDOW; j++) {
-                        ASTNode_t *next_node = node->children[j];
-                        if (next_node->type != AST_TOKEN) continue;
-
-                        Token *next = &next_node->token;
-                        if (next->type == TOKEN_WHITESPACE) {
-                            continue; /* Skip whitespace */
-                        } else if (next->type == TOKEN_IDENTIFIER) {
-                            track_identifier(next->text, 1, j);
-                            break;
-                        } else {
-                            break; /* Hit something else, stop looking */
-                        }
-                    }
+    /* Only track pointers in function parameter lists */
+    if (*in_function_params && *paren_depth > 0) {
+        /* Look for pointer operator * */
+        if (tok->type == TOKEN_OPERATOR && token_is_pointer_type(tok)) {
+            /* Look ahead for identifier, skipping whitespace */
+            for (size_t j = i + 1; j < node->child_count && j < i + TOKEN_SEARCH_WINDOW; j++) {
+                ASTNode_t *next_node = node->children[j];
+                if (next_node->type != AST_TOKEN) continue;
+
+                Token *next = &next_node->token;
+                if (next->type == TOKEN_WHITESPACE) {
+                    continue; /* Skip whitespace */
+                } else if (next->type == TOKEN_IDENTIFIER) {
+                    track_parameter(cz_token_symbol(next));
+                    break;
+                } else {
+                    break; /* Hit something else, stop looking */
                 }
             }
         }
     }
 }
 
-/* Transform member access operators */
+/* Transform member access operators, resolving each name in the scope it is used in */
 static void transform_autodereference_node(ASTNode_t *node) {
     if (!node || node->type != AST_TRANSLATION_UNIT) {
         return;
     }
 
-    /* Look for patterns: identifier . identifier */
+    int paren_depth = 0;
+    int in_function_params = 0;
+
     for (size_t i = 0; i < node->child_count; i++) {
+        ASTNode_t *child = node->children[i];
+        if (child->type != AST_TOKEN) continue;
+
+        Token *tok = &child->token;
+
+        /* Parameters are bound in the function body, locals in the block declaring them */
+        if (tracked_scopes.depth == 0) {
+            scan_parameter(node, i, &paren_depth, &in_function_params);
+        }
+        if (tok->type == TOKEN_PUNCTUATION && strcmp(tok->text, "{") == 0) {
+            scope_push(&tracked_scopes, 0);
+            if (tracked_scopes.depth == 1) {
+                for (size_t k = 0; k < pending_count; k++) {
+                    scope_bind(&tracked_scopes, pending_params[k], 1);
+                }
+                pending_count = 0;
+            }
+            continue;
+        }
+        if (tok->type == TOKEN_PUNCTUATION && strcmp(tok->text, "}") == 0) {
+            scope_pop(&tracked_scopes);
+            continue;
+        }
+
+        ScopeDeclaration_t declaration;
+        if (tracked_scopes.depth > 0 &&
+            scope_match_declaration(node->children, node->child_count, i, &declaration)) {
+            /* Locals shadow outer names, pointers or not */
+            scope_bind(&tracked_scopes, cz_token_symbol(&node->children[declaration.name]->token),
+                       declaration.pointer ? 1 : 0);
+        }
+
+        /* Look for patterns: identifier . identifier */
         if (i + 2 >= node->child_count) {
             continue; /* Need at least 3 tokens for member access */
         }
 
-        ASTNode_t *left_node = node->children[i];
         ASTNode_t *op_node = node->children[i + 1];
         ASTNode_t *right_node = node->children[i + 2];
 
         /* Check if this is a member access pattern */
-        if (left_node->type == AST_TOKEN && op_node->type == AST_TOKEN && right_node->type == AST_TOKEN) {
-            Token *left = &left_node->token;
+        if (op_node->type == AST_TOKEN && right_node->type == AST_TOKEN) {
+            Token *left = tok;
             Token *op = &op_node->token;
             Token *right = &right_node->token;
 
@@ -204,17 +196,15 @@ static void transform_autodereference_node(ASTNode_t *node) {
                 op->text && strcmp(op->text, ".") == 0 &&
                 right->type == TOKEN_IDENTIFIER) {
 
-                /* Check if left side is a tracked pointer at this position */
-                if (is_tracked_pointer_at(left->text, i)) {
+                /* Check if left side is a pointer in this scope */
+                if (tracked_scopes.count > 0 && is_tracked_pointer(cz_token_symbol(left))) {
                     /* Transform . to -> */
                     char *new_text = strdup("->");
                     if (!new_text) {
                         /* Memory allocation failed, leave unchanged */
                         continue;
                     }
-                    free(op->text);
-                    op->text = new_text;
-                    op->length = strlen(new_text);
+                    token_take_text(op, new_text);
                 }
             }
         }
@@ -230,9 +220,6 @@ void transpiler_transform_autodereference(ASTNode_t *ast) {
     /* Clear previous tracking state */
     clear_tracking();
 
-    /* First pass: scan for pointer declarations */
-    scan_for_pointers(ast);
-
-    /* Second pass: transform member access operators */
+    /* Single pass: track pointer declarations per scope and transform member access operators */
     transform_autodereference_node(ast);
 }
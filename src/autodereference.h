@@ -12,3 +12,9 @@
 
 /* Transform member access operators (. to -> for pointers) */
 void transpiler_transform_autodereference(ASTNode_t *ast);
+
+/* Release identifier tracking of the current translation unit */
+void transpiler_free_autodereference_tables(void);
+
+/* Get the bytes held by identifier tracking (cz --stats) */
+size_t transpiler_autodereference_table_bytes(void);
@@ -9,6 +9,8 @@
  * - WARNs for unsafe casts (narrowing, sign changes)
  * - Allows safe widening casts (u8→u16, i8→i32) without warning
  * - Enforced explicit narrowing casts
+ * - Range checks of cast<Type>(value, fallback) are folded for literals, dropped
+ *   when the value's declared type already fits, and marked cold otherwise
  */
 
 #include "cz.h"
@@ -16,6 +18,10 @@
 #include "../transpiler.h"
 #include "errors.h"
 #include "warnings.h"
+#include "scopes.h"
+#include "hints.h"
+#include "../sink.h"
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +34,10 @@ typedef struct {
     int bits;
 } TypeInfo;
 
+/* Fixed-width types of locals in the open blocks (symbol ID -> type token position, or
+ * HASH_TABLE_MISSING when unknown: pointers, arrays, other declarators...) */
+static CZ_THREAD_LOCAL ScopeTable_t cast_scopes;
+
 /* Get type information for known types */
 static TypeInfo get_type_info(const char *type_name) {
     TypeInfo info = {type_name, 0, 0};
@@ -104,20 +114,106 @@ static int token_text_equals(Token *token, const char *text) {
     return strcmp(token->text, text) == 0;
 }
 
-/* Skip whitespace and comment tokens */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t i) {
-    while (i < count) {
-        if (children[i]->type != AST_TOKEN) {
-            i++;
+/* Get the largest value of a fixed-width type (0 when unknown) */
+static unsigned long long get_type_max_value(const char *type_name) {
+    if (!get_type_max(type_name)) {
+        return 0;
+    }
+    TypeInfo info = get_type_info(type_name);
+    return (~0ULL) >> (64 - info.bits + info.is_signed);
+}
+
+/* Parse an integer literal with an optional u/l suffix, returns 0 for anything else */
+static int parse_integer_literal(const Token *token, unsigned long long *value) {
+    if (!token->text || token->type != TOKEN_NUMBER || !isdigit((unsigned char)token->text[0])) {
+        return 0;
+    }
+    char *end = NULL;
+    errno = 0;
+    *value = strtoull(token->text, &end, 0);
+    if (errno != 0 || end == token->text) {
+        return 0;
+    }
+    return end[strspn(end, "uUlL")] == '\0';
+}
+
+/* Bind the declared local (a fixed-width type or unknown) and the names of its other declarators */
+static void track_declaration(ASTNode_t **children, size_t count, const ScopeDeclaration_t *declaration) {
+    size_t next = ast_skip_trivia(children, count, declaration->name + 1);
+    int array = next < count && children[next]->type == AST_TOKEN &&
+                token_text_equals(&children[next]->token, "[");
+    size_t type = get_type_max(children[declaration->type]->token.text) && !declaration->pointer && !array
+                      ? declaration->type : HASH_TABLE_MISSING;
+    scope_bind(&cast_scopes, cz_token_symbol(&children[declaration->name]->token), type);
+
+    /* "T a = 1, b;" also declares b, of a type not worth tracking */
+    int depth = 0;
+    int in_declarator = 0;
+    size_t declarator_name = AST_NO_MATCH;
+    for (size_t k = next; k < count && children[k]->type == AST_TOKEN; k++) {
+        Token *t = &children[k]->token;
+        if (!t->text || t->text[0] == '\0') {
             continue;
         }
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
+        if (t->type == TOKEN_IDENTIFIER && in_declarator) {
+            declarator_name = k;
+        } else if (t->type == TOKEN_PUNCTUATION && strchr("([{", t->text[0])) {
+            depth++;
+        } else if (t->type == TOKEN_PUNCTUATION && strchr(")]}", t->text[0])) {
+            if (--depth < 0) break;
+        } else if (depth == 0 && (token_text_equals(t, ",") || token_text_equals(t, ";") ||
+                                  token_text_equals(t, "="))) {
+            if (in_declarator && declarator_name != AST_NO_MATCH) {
+                scope_bind(&cast_scopes, cz_token_symbol(&children[declarator_name]->token), HASH_TABLE_MISSING);
+            }
+            if (token_text_equals(t, ";")) break;
+            in_declarator = token_text_equals(t, ",");
+            declarator_name = AST_NO_MATCH;
+        }
+    }
+}
+
+/* Shadow the name declared (or assigned) by a for-init clause, its type is not tracked */
+static void track_for_init(ASTNode_t **children, size_t count, size_t for_idx) {
+    size_t open = ast_skip_trivia(children, count, for_idx + 1);
+    if (open >= count || children[open]->type != AST_TOKEN || !token_text_equals(&children[open]->token, "(")) {
+        return;
+    }
+    size_t last_identifier = AST_NO_MATCH;
+    for (size_t k = open + 1; k < count && children[k]->type == AST_TOKEN; k++) {
+        Token *t = &children[k]->token;
+        if (t->type == TOKEN_IDENTIFIER) {
+            last_identifier = k;
+        } else if (token_text_equals(t, "=") || token_text_equals(t, ";") || token_text_equals(t, ",") ||
+                   token_text_equals(t, ")")) {
             break;
         }
-        i++;
     }
-    return i;
+    if (last_identifier != AST_NO_MATCH) {
+        scope_bind(&cast_scopes, cz_token_symbol(&children[last_identifier]->token), HASH_TABLE_MISSING);
+    }
+}
+
+/* Get the declared fixed-width type of the local named by the single token in [start, end), or NULL */
+static const char *get_local_type(ASTNode_t **children, size_t start, size_t end) {
+    size_t value = ast_skip_trivia(children, end, start);
+    if (value >= end || children[value]->type != AST_TOKEN ||
+        children[value]->token.type != TOKEN_IDENTIFIER ||
+        ast_skip_trivia(children, end, value + 1) < end) {
+        return NULL;
+    }
+    size_t type = scope_lookup(&cast_scopes, cz_token_symbol(&children[value]->token));
+    return type == HASH_TABLE_MISSING ? NULL : children[type]->token.text;
+}
+
+/* Release the local types tracked for casts */
+void transpiler_free_cast_tables(void) {
+    scope_free(&cast_scopes);
+}
+
+/* Get the bytes held by the local types tracked for casts (cz --stats) */
+size_t transpiler_cast_table_bytes(void) {
+    return scope_bytes(&cast_scopes);
 }
 
 /* Check for C-style cast pattern: (Type)value */
@@ -130,7 +226,7 @@ static void check_c_style_casts(ASTNode_t **children, size_t count) {
         /* Look for opening parenthesis */
         if (token->type == TOKEN_PUNCTUATION && token_text_equals(token, "(")) {
             /* Check if this could be a C-style cast */
-            size_t j = skip_whitespace(children, count, i + 1);
+            size_t j = ast_skip_trivia(children, count, i + 1);
 
             if (j < count && children[j]->type == AST_TOKEN &&
                 children[j]->token.type == TOKEN_IDENTIFIER) {
@@ -138,20 +234,20 @@ static void check_c_style_casts(ASTNode_t **children, size_t count) {
                 Token *maybe_type = &children[j]->token;
 
                 /* Skip to find closing ) */
-                j = skip_whitespace(children, count, j + 1);
+                j = ast_skip_trivia(children, count, j + 1);
 
                 /* Handle pointer types */
                 while (j < count && children[j]->type == AST_TOKEN &&
                        children[j]->token.type == TOKEN_OPERATOR &&
                        token_text_equals(&children[j]->token, "*")) {
-                    j = skip_whitespace(children, count, j + 1);
+                    j = ast_skip_trivia(children, count, j + 1);
                 }
 
                 if (j < count && children[j]->type == AST_TOKEN &&
                     children[j]->token.type == TOKEN_PUNCTUATION &&
                     token_text_equals(&children[j]->token, ")")) {
                     /* Found closing ), check what comes after */
-                    j = skip_whitespace(children, count, j + 1);
+                    j = ast_skip_trivia(children, count, j + 1);
 
                     if (j < count && children[j]->type == AST_TOKEN) {
                         Token *after_paren = &children[j]->token;
@@ -170,7 +266,7 @@ static void check_c_style_casts(ASTNode_t **children, size_t count) {
                                 snprintf(error_msg, sizeof(error_msg),
                                          ERR_C_STYLE_CAST_NOT_ALLOWED,
                                          maybe_type->text, maybe_type->text);
-                                cz_error(g_filename, g_source, token->line, error_msg);
+                                cz_error_at(g_filename, g_source, token->line, token->column, error_msg);
                             }
                         }
                     }
@@ -182,7 +278,7 @@ static void check_c_style_casts(ASTNode_t **children, size_t count) {
 
 /* Extract type name from template-like syntax: func<Type> */
 static char *extract_template_type(ASTNode_t **children, size_t count, size_t start, size_t *out_end) {
-    size_t i = skip_whitespace(children, count, start);
+    size_t i = ast_skip_trivia(children, count, start);
 
     /* Expect < */
     if (i >= count || children[i]->type != AST_TOKEN ||
@@ -191,7 +287,7 @@ static char *extract_template_type(ASTNode_t **children, size_t count, size_t st
         return NULL;
     }
 
-    i = skip_whitespace(children, count, i + 1);
+    i = ast_skip_trivia(children, count, i + 1);
 
     /* Expect type name */
     if (i >= count || children[i]->type != AST_TOKEN ||
@@ -203,7 +299,7 @@ static char *extract_template_type(ASTNode_t **children, size_t count, size_t st
     if (!type_name) {
         return NULL;
     }
-    i = skip_whitespace(children, count, i + 1);
+    i = ast_skip_trivia(children, count, i + 1);
 
     /* Expect > */
     if (i >= count || children[i]->type != AST_TOKEN ||
@@ -235,12 +331,12 @@ static void check_cast_functions(ASTNode_t **children, size_t count) {
                 char error_msg[256];
                 snprintf(error_msg, sizeof(error_msg),
                          ERR_CAST_REQUIRES_TEMPLATE_SYNTAX);
-                cz_error(g_filename, g_source, token->line, error_msg);
+                cz_error_at(g_filename, g_source, token->line, token->column, error_msg);
                 continue;
             }
 
             /* Expect ( */
-            j = skip_whitespace(children, count, j);
+            j = ast_skip_trivia(children, count, j);
             if (j >= count || children[j]->type != AST_TOKEN ||
                 children[j]->token.type != TOKEN_PUNCTUATION ||
                 !token_text_equals(&children[j]->token, "(")) {
@@ -248,14 +344,14 @@ static void check_cast_functions(ASTNode_t **children, size_t count) {
                 char error_msg[256];
                 snprintf(error_msg, sizeof(error_msg),
                          ERR_CAST_REQUIRES_PARENTHESES);
-                cz_error(g_filename, g_source, token->line, error_msg);
+                cz_error_at(g_filename, g_source, token->line, token->column, error_msg);
                 continue;
             }
 
             /* Count arguments */
             int paren_depth = 1;
             int arg_count = 1;
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
 
             while (j < count && paren_depth > 0) {
                 if (children[j]->type == AST_TOKEN) {
@@ -277,7 +373,7 @@ static void check_cast_functions(ASTNode_t **children, size_t count) {
             /* Validate argument count - 1 or 2 arguments allowed */
             if (arg_count < 1 || arg_count > 2) {
                 free(type_name);
-                cz_error(g_filename, g_source, token->line, ERR_CAST_INVALID_ARG_COUNT);
+                cz_error_at(g_filename, g_source, token->line, token->column, ERR_CAST_INVALID_ARG_COUNT);
                 continue;
             }
 
@@ -287,7 +383,7 @@ static void check_cast_functions(ASTNode_t **children, size_t count) {
                 snprintf(warning_msg, sizeof(warning_msg),
                          WARN_CAST_WITHOUT_FALLBACK,
                          type_name, type_name);
-                cz_warning(g_filename, g_source, token->line, warning_msg);
+                cz_warning_at(g_filename, g_source, token->line, token->column, warning_msg);
             }
 
             /* Check if this cast is potentially unsafe */
@@ -332,17 +428,27 @@ void transpiler_transform_casts(ASTNode_t *ast) {
 
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
+    scope_clear(&cast_scopes);
 
     for (size_t i = 0; i < count; i++) {
         if (children[i]->type != AST_TOKEN) continue;
 
         Token *token = &children[i]->token;
 
+        /* Track the types of locals for range checks */
+        scope_track_braces(&cast_scopes, children, i, 0);
+        ScopeDeclaration_t declaration;
+        if (cast_scopes.depth > 0 && scope_match_declaration(children, count, i, &declaration)) {
+            track_declaration(children, count, &declaration);
+        } else if (cast_scopes.depth > 0 && token->type == TOKEN_KEYWORD && token->symbol == SYM_FOR) {
+            track_for_init(children, count, i);
+        }
+
         /* Transform cast<Type>(value[, fallback]) */
         if (token->type == TOKEN_IDENTIFIER && strcmp(token->text, "cast") == 0) {
 
             /* Find the template type */
-            size_t j = skip_whitespace(children, count, i + 1);
+            size_t j = ast_skip_trivia(children, count, i + 1);
 
             /* Expect < */
             if (j >= count || children[j]->type != AST_TOKEN ||
@@ -352,7 +458,7 @@ void transpiler_transform_casts(ASTNode_t *ast) {
             }
             size_t open_angle = j;
 
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
 
             /* Get type name */
             if (j >= count || children[j]->type != AST_TOKEN ||
@@ -365,7 +471,7 @@ void transpiler_transform_casts(ASTNode_t *ast) {
                 continue;
             }
 
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
 
             /* Expect > */
             if (j >= count || children[j]->type != AST_TOKEN ||
@@ -376,7 +482,7 @@ void transpiler_transform_casts(ASTNode_t *ast) {
             }
             size_t close_angle = j;
 
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
 
             /* Expect ( */
             if (j >= count || children[j]->type != AST_TOKEN ||
@@ -391,7 +497,7 @@ void transpiler_transform_casts(ASTNode_t *ast) {
             int paren_depth = 1;
             size_t comma_pos = 0;
             size_t close_paren = 0;
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
 
             while (j < count && paren_depth > 0) {
                 if (children[j]->type == AST_TOKEN) {
@@ -413,8 +519,51 @@ void transpiler_transform_casts(ASTNode_t *ast) {
                 j++;
             }
 
-            if (comma_pos > 0) {
-                /* cast<Type>(value, fallback) -> ((value) > MAX ? (fallback) : (Type)(value)) */
+            /* Decide the range check at transpile time when the value is known to fit (or not) */
+            int check = comma_pos > 0 && get_type_max(type_name);
+            int fits = 0;
+            if (check) {
+                unsigned long long literal = 0;
+                size_t value_idx = ast_skip_trivia(children, comma_pos, open_paren + 1);
+                const char *local_type = get_local_type(children, open_paren + 1, comma_pos);
+                if (value_idx < comma_pos && ast_skip_trivia(children, comma_pos, value_idx + 1) == comma_pos &&
+                    parse_integer_literal(&children[value_idx]->token, &literal)) {
+                    /* Literal: keep the value or the fallback only */
+                    check = 0;
+                    fits = literal <= get_type_max_value(type_name);
+                } else if (local_type && get_type_max_value(local_type) <= get_type_max_value(type_name)) {
+                    /* Widening, or the same range: the value is never above MAX */
+                    check = 0;
+                    fits = 1;
+                }
+            }
+
+            if (comma_pos > 0 && !check && !fits && get_type_max(type_name)) {
+                /* cast<Type>(LITERAL, fallback) with LITERAL > MAX -> ((fallback)) */
+                token_set_text(&children[i]->token, "(");
+                children[i]->token.type = TOKEN_PUNCTUATION;
+                for (size_t k = open_angle; k <= comma_pos; k++) {
+                    if (k != open_paren && children[k]->type == AST_TOKEN) {
+                        token_set_text(&children[k]->token, "");
+                    }
+                }
+                token_set_text(&children[close_paren]->token, "))");
+
+            } else if (comma_pos > 0 && fits) {
+                /* cast<Type>(value, fallback) -> (Type)(value) when value always fits */
+                token_set_text(&children[i]->token, "(");
+                children[i]->token.type = TOKEN_PUNCTUATION;
+                token_set_text(&children[open_angle]->token, "");
+                token_set_text(&children[close_angle]->token, ")");
+                children[close_angle]->token.type = TOKEN_PUNCTUATION;
+                for (size_t k = comma_pos; k < close_paren; k++) {
+                    if (children[k]->type == AST_TOKEN) {
+                        token_set_text(&children[k]->token, "");
+                    }
+                }
+
+            } else if (comma_pos > 0) {
+                /* cast<Type>(value, fallback) -> (_CZ_UNLIKELY((value) > MAX) ? (fallback) : (Type)(value)) */
 
                 const char *type_max = get_type_max(type_name);
                 if (!type_max) {
@@ -423,100 +572,72 @@ void transpiler_transform_casts(ASTNode_t *ast) {
                     continue;
                 }
 
-                /* Extract the value expression as a string (for re-injection) */
-                /* This is a workaround for token duplication - we'll reconstruct the value text */
-                char value_text[1024] = "";
-                size_t value_text_len = 0;
-                size_t value_start = open_paren + 1;
-                for (size_t k = value_start; k < comma_pos && k < count; k++) {
-                    if (children[k]->type == AST_TOKEN && children[k]->token.text &&
-                        children[k]->token.length > 0) {
-                        size_t token_len = children[k]->token.length;
-                        /* Check if adding this token would overflow the buffer */
-                        if (value_text_len + token_len + 1 > sizeof(value_text)) {
-                            /* Buffer would overflow - stop concatenating */
-                            break;
-                        }
-                        /* Use memcpy instead of strcat for better safety and performance */
-                        memcpy(value_text + value_text_len, children[k]->token.text, token_len);
-                        value_text_len += token_len;
-                        value_text[value_text_len] = '\0';
+                /* False branch ") : (Type)(value))", repeating the value tokens (of any length) */
+                OutputSink_t sink;
+                sink_init(&sink, NULL);
+                sink_printf(&sink, ") : (%s)(", type_name);
+                for (size_t k = open_paren + 1; k < comma_pos && k < count; k++) {
+                    if (children[k]->type == AST_TOKEN && children[k]->token.text) {
+                        sink_write(&sink, children[k]->token.text, children[k]->token.length);
                     }
                 }
+                sink_puts(&sink, "))");
+                char *ternary_false = sink_take(&sink);
+                sink_init(&sink, NULL);
+                sink_printf(&sink, ") > %s) ? (", type_max);
+                char *ternary_cond_end = sink_take(&sink);
+                if (!ternary_false || !ternary_cond_end) {
+                    free(ternary_false);
+                    free(ternary_cond_end);
+                    free(type_name);
+                    continue;
+                }
 
-                /* Build ternary components */
-                char ternary_start[512];
-                snprintf(ternary_start, sizeof(ternary_start), "((");
-
-                char ternary_cond_end[512];
-                snprintf(ternary_cond_end, sizeof(ternary_cond_end), ") > %s ? (", type_max);
-
-                char ternary_false_start[1025+64];
-                snprintf(ternary_false_start, sizeof(ternary_false_start),
-                         ") : (%s)(%s))", type_name, value_text);
+                /* The fallback is the cold path */
+                hints_use_branch();
 
                 /* Transform tokens */
 
-                /* Replace 'cast' with '((' */
-                free(children[i]->token.text);
-                children[i]->token.text = strdup(ternary_start);
-                children[i]->token.length = strlen(ternary_start);
+                /* Replace 'cast' with '(_CZ_UNLIKELY((' */
+                token_set_text(&children[i]->token, "(_CZ_UNLIKELY((");
                 children[i]->token.type = TOKEN_PUNCTUATION;
 
                 /* Remove '<' */
-                free(children[open_angle]->token.text);
-                children[open_angle]->token.text = strdup("");
-                children[open_angle]->token.length = 0;
+                token_set_text(&children[open_angle]->token, "");
 
                 /* Remove type name */
-                free(children[type_idx]->token.text);
-                children[type_idx]->token.text = strdup("");
-                children[type_idx]->token.length = 0;
+                token_set_text(&children[type_idx]->token, "");
 
                 /* Remove '>' */
-                free(children[close_angle]->token.text);
-                children[close_angle]->token.text = strdup("");
-                children[close_angle]->token.length = 0;
+                token_set_text(&children[close_angle]->token, "");
 
                 /* Remove open_paren (we already have (( from cast replacement) */
-                free(children[open_paren]->token.text);
-                children[open_paren]->token.text = strdup("");
-                children[open_paren]->token.length = 0;
+                token_set_text(&children[open_paren]->token, "");
 
                 /* value tokens stay as-is (between open_paren and comma) */
 
-                /* Replace comma with ternary condition end: ) > MAX ? ( */
-                free(children[comma_pos]->token.text);
-                children[comma_pos]->token.text = strdup(ternary_cond_end);
-                children[comma_pos]->token.length = strlen(ternary_cond_end);
+                /* Replace comma with ternary condition end: ) > MAX) ? ( */
+                token_take_text(&children[comma_pos]->token, ternary_cond_end);
 
                 /* fallback tokens stay as-is (between comma and close_paren) */
 
                 /* Replace close_paren with false branch: ) : (Type)(value)) */
-                free(children[close_paren]->token.text);
-                children[close_paren]->token.text = strdup(ternary_false_start);
-                children[close_paren]->token.length = strlen(ternary_false_start);
+                token_take_text(&children[close_paren]->token, ternary_false);
 
             } else {
                 /* cast<Type>(value) -> (Type)(value) - simple cast */
 
                 /* Replace 'cast' with '(' */
-                free(children[i]->token.text);
-                children[i]->token.text = strdup("(");
-                children[i]->token.length = 1;
+                token_set_text(&children[i]->token, "(");
                 children[i]->token.type = TOKEN_PUNCTUATION;
 
                 /* Remove '<' */
-                free(children[open_angle]->token.text);
-                children[open_angle]->token.text = strdup("");
-                children[open_angle]->token.length = 0;
+                token_set_text(&children[open_angle]->token, "");
 
                 /* Type name stays as-is */
 
                 /* Replace '>' with ')' */
-                free(children[close_angle]->token.text);
-                children[close_angle]->token.text = strdup(")");
-                children[close_angle]->token.length = 1;
+                token_set_text(&children[close_angle]->token, ")");
                 children[close_angle]->token.type = TOKEN_PUNCTUATION;
             }
 
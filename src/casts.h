@@ -15,3 +15,9 @@ void transpiler_validate_casts(ASTNode_t *ast, const char *filename, const char
 
 /* Transform cast expressions to C equivalents */
 void transpiler_transform_casts(ASTNode_t *ast);
+
+/* Release the local types tracked for casts */
+void transpiler_free_cast_tables(void);
+
+/* Get the bytes held by the local types tracked for casts (cz --stats) */
+size_t transpiler_cast_table_bytes(void);
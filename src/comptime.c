@@ -0,0 +1,544 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Evaluates compile-time lookup tables.
+ *
+ * comptime u8 bits[256] = [i] (i & 1) + bits[i >> 1];
+ * → static const uint8_t bits[256] = { 0, 1, 1, 2, ... };
+ *
+ * Notes:
+ * - The expression is evaluated for every index with 64-bit two's complement arithmetic, then
+ *   truncated to the element type (integer types only)
+ * - Values are signed or unsigned as in C: literals with a u suffix or too large for long long
+ *   (or for int when hex or octal), and elements of unsigned tables of 32 bits or more are unsigned;
+ *   an operation with an unsigned operand is unsigned (logical >>, unsigned / % and comparisons)
+ * - It may use integer and character literals, the index, the C integer operators (including
+ *   ?: and short-circuits), earlier elements of the table and elements of earlier tables
+ * - The declaration stays on its line so diagnostics keep their line numbers
+ */
+
+#include "cz.h"
+#include "comptime.h"
+#include "errors.h"
+#include "types.h"
+#include "../rewrite.h"
+#include <stdbool.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Largest table a comptime declaration may generate */
+#define COMPTIME_MAX_COUNT 65536
+
+/* A table evaluated so far */
+typedef struct {
+    int symbol;              /* Symbol ID of its name */
+    long long *values;       /* Values (truncated to the element type) */
+    bool is_unsigned;        /* Its elements stay unsigned in expressions (unsigned, 32 bits or more) */
+    size_t count;            /* Number of elements */
+    size_t filled;           /* Number of elements evaluated so far */
+} ComptimeTable_t;
+
+/* A value and the signedness C gives it (the width is always 64 bits) */
+typedef struct {
+    long long value;
+    bool is_unsigned;
+} ComptimeValue_t;
+
+/* Evaluation of an expression over [pos, end) */
+typedef struct {
+    ASTNode_t **children;
+    size_t pos;              /* Current token */
+    size_t end;              /* First token after the expression */
+    int index_symbol;        /* Symbol ID of the index, SYM_NONE outside tables */
+    long long index;         /* Value of the index */
+    const ComptimeTable_t *tables;
+    size_t table_count;      /* Tables the expression may read (the last one is being filled) */
+    int skip;                /* Nesting of branches not taken: parsed, not evaluated */
+    const char *error;       /* First error, or NULL */
+    size_t error_pos;        /* Token of the first error */
+} Evaluator_t;
+
+/* Integer element types and their width */
+static const struct {
+    const char *name;
+    int bits;
+    bool is_signed;
+} element_types[] = {
+    { "uint8_t", 8, false }, { "int8_t", 8, true },
+    { "uint16_t", 16, false }, { "int16_t", 16, true },
+    { "uint32_t", 32, false }, { "int32_t", 32, true },
+    { "uint64_t", 64, false }, { "int64_t", 64, true },
+    { "size_t", 64, false }, { "ptrdiff_t", 64, true },
+    { "int", 32, true }, { "unsigned", 32, false },
+    { "bool", 1, false },
+    { NULL, 0, false }
+};
+
+/* Binary operators by precedence level, loosest first */
+static const char *const binary_levels[][5] = {
+    { "||", NULL }, { "&&", NULL }, { "|", NULL }, { "^", NULL }, { "&", NULL },
+    { "==", "!=", NULL }, { "<", "<=", ">", ">=", NULL }, { "<<", ">>", NULL },
+    { "+", "-", NULL }, { "*", "/", "%", NULL }
+};
+#define BINARY_LEVELS ((int)(sizeof(binary_levels) / sizeof(binary_levels[0])))
+
+/* Check if token text matches */
+static bool token_equals(const Token *token, const char *text) {
+    return token && token->text && strcmp(token->text, text) == 0;
+}
+
+/* Get the current token of the evaluator, or NULL at the end */
+static Token *current(Evaluator_t *ev) {
+    ev->pos = ast_skip_trivia(ev->children, ev->end, ev->pos);
+    return ev->pos < ev->end ? &ev->children[ev->pos]->token : NULL;
+}
+
+/* Make a value */
+static ComptimeValue_t make_value(long long value, bool is_unsigned) {
+    ComptimeValue_t result = { value, is_unsigned };
+    return result;
+}
+
+/* Record the first error */
+static ComptimeValue_t fail(Evaluator_t *ev, const char *error) {
+    if (!ev->error) {
+        ev->error = error;
+        ev->error_pos = ev->pos < ev->end ? ev->pos : ev->end - 1;
+    }
+    return make_value(0, false);
+}
+
+/* Consume the current token if its text is text */
+static bool accept(Evaluator_t *ev, const char *text) {
+    Token *token = current(ev);
+    if (!token || !token_equals(token, text)) {
+        return false;
+    }
+    ev->pos++;
+    return true;
+}
+
+static ComptimeValue_t eval_expression(Evaluator_t *ev);
+
+/* Parse an integer or character literal */
+static bool parse_literal(const Token *token, ComptimeValue_t *value) {
+    if (token->type == TOKEN_CHAR) {
+        /* 'c' or a simple escape (an int) */
+        const char *text = token->text;
+        if (token->length == 3) {
+            *value = make_value((unsigned char)text[1], false);
+            return true;
+        }
+        if (token->length == 4 && text[1] == '\\') {
+            const char *escapes = "n\nt\tr\r0\0\\\\''";
+            for (const char *e = escapes; e[0]; e += 2) {
+                if (text[2] == e[0]) {
+                    *value = make_value((unsigned char)e[1], false);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    char *suffix = NULL;
+    unsigned long long parsed = strtoull(token->text, &suffix, 0);
+    if (suffix == token->text || suffix[strspn(suffix, "uUlL")] != '\0') {
+        return false;
+    }
+    /* Unsigned by suffix, or as the first type that holds it (hex and octal may be unsigned int) */
+    bool is_unsigned = strpbrk(suffix, "uU") != NULL || parsed > (unsigned long long)LLONG_MAX;
+    if (token->text[0] == '0' && token->text[1] && parsed > (unsigned long long)INT_MAX && parsed <= UINT_MAX &&
+        !strpbrk(suffix, "lL")) {
+        is_unsigned = true;
+    }
+    *value = make_value((long long)parsed, is_unsigned);
+    return true;
+}
+
+/* primary: literal | index | table[expression] | (expression) */
+static ComptimeValue_t eval_primary(Evaluator_t *ev) {
+    Token *token = current(ev);
+    if (!token) {
+        return fail(ev, "expected a value");
+    }
+
+    if (accept(ev, "(")) {
+        ComptimeValue_t value = eval_expression(ev);
+        if (!accept(ev, ")")) {
+            return fail(ev, "expected ')'");
+        }
+        return value;
+    }
+
+    if (token->type == TOKEN_NUMBER || token->type == TOKEN_CHAR) {
+        ComptimeValue_t value = make_value(0, false);
+        if (!parse_literal(token, &value)) {
+            return fail(ev, "only integer literals are allowed");
+        }
+        ev->pos++;
+        return value;
+    }
+
+    if (token->type == TOKEN_IDENTIFIER) {
+        int symbol = cz_token_symbol(token);
+        ev->pos++;
+        if (symbol == ev->index_symbol) {
+            return make_value(ev->index, false);
+        }
+
+        for (size_t t = 0; t < ev->table_count; t++) {
+            const ComptimeTable_t *table = &ev->tables[t];
+            if (table->symbol != symbol) continue;
+
+            if (!accept(ev, "[")) {
+                return fail(ev, "comptime tables are only read with table[index]");
+            }
+            size_t subscript_pos = ev->pos;
+            ComptimeValue_t subscript = eval_expression(ev);
+            if (!accept(ev, "]")) {
+                return fail(ev, "expected ']'");
+            }
+            if (ev->skip) {
+                return make_value(0, table->is_unsigned);
+            }
+            if ((!subscript.is_unsigned && subscript.value < 0) || (unsigned long long)subscript.value >= table->filled) {
+                ev->pos = subscript_pos;
+                return fail(ev, "table element read before it is computed or out of bounds");
+            }
+            return make_value(table->values[subscript.value], table->is_unsigned);
+        }
+        ev->pos--;
+        return fail(ev, "only the index, literals and earlier comptime tables are allowed");
+    }
+
+    return fail(ev, "unexpected token");
+}
+
+/* unary: (- + ~ !) unary | primary */
+static ComptimeValue_t eval_unary(Evaluator_t *ev) {
+    if (accept(ev, "-")) {
+        ComptimeValue_t operand = eval_unary(ev);
+        return make_value((long long)(0ULL - (unsigned long long)operand.value), operand.is_unsigned);
+    }
+    if (accept(ev, "+")) return eval_unary(ev);
+    if (accept(ev, "~")) {
+        ComptimeValue_t operand = eval_unary(ev);
+        return make_value(~operand.value, operand.is_unsigned);
+    }
+    if (accept(ev, "!")) return make_value(!eval_unary(ev).value, false);
+    return eval_primary(ev);
+}
+
+/* Compare a and b as the usual arithmetic conversions do: -1, 0 or 1 */
+static int compare(ComptimeValue_t a, ComptimeValue_t b) {
+    if (a.is_unsigned || b.is_unsigned) {
+        unsigned long long ua = (unsigned long long)a.value;
+        unsigned long long ub = (unsigned long long)b.value;
+        return (ua > ub) - (ua < ub);
+    }
+    return (a.value > b.value) - (a.value < b.value);
+}
+
+/* Apply a binary operator (wrapping arithmetic, shifts by 0..63 only) */
+static ComptimeValue_t apply(Evaluator_t *ev, const char *op, ComptimeValue_t left, ComptimeValue_t right) {
+    long long a = left.value;
+    long long b = right.value;
+    unsigned long long ua = (unsigned long long)a;
+    unsigned long long ub = (unsigned long long)b;
+    bool is_unsigned = left.is_unsigned || right.is_unsigned;
+    switch (op[0]) {
+    case '|': return op[1] ? make_value(a || b, false) : make_value((long long)(ua | ub), is_unsigned);
+    case '&': return op[1] ? make_value(a && b, false) : make_value((long long)(ua & ub), is_unsigned);
+    case '^': return make_value((long long)(ua ^ ub), is_unsigned);
+    case '=': return make_value(a == b, false);
+    case '!': return make_value(a != b, false);
+    case '+': return make_value((long long)(ua + ub), is_unsigned);
+    case '-': return make_value((long long)(ua - ub), is_unsigned);
+    case '*': return make_value((long long)(ua * ub), is_unsigned);
+    case '/':
+    case '%':
+        if (ev->skip) return make_value(0, is_unsigned);
+        if (b == 0) return fail(ev, "division by zero");
+        if (is_unsigned) return make_value((long long)(op[0] == '/' ? ua / ub : ua % ub), true);
+        if (a == LLONG_MIN && b == -1) return make_value(op[0] == '/' ? a : 0, false);
+        return make_value(op[0] == '/' ? a / b : a % b, false);
+    case '<':
+    case '>':
+        if (op[1] == op[0]) {
+            /* The result has the type of the left operand */
+            if (ev->skip) return make_value(0, left.is_unsigned);
+            if ((!right.is_unsigned && b < 0) || ub > 63) return fail(ev, "shift count out of range");
+            if (op[0] == '<') return make_value((long long)(ua << ub), left.is_unsigned);
+            return make_value(left.is_unsigned ? (long long)(ua >> ub) : a >> b, left.is_unsigned);
+        }
+        if (op[0] == '<') return make_value(op[1] ? compare(left, right) <= 0 : compare(left, right) < 0, false);
+        return make_value(op[1] ? compare(left, right) >= 0 : compare(left, right) > 0, false);
+    default:
+        return fail(ev, "unsupported operator");
+    }
+}
+
+/* Binary operators of level and tighter, left-associative (&& and || short-circuit) */
+static ComptimeValue_t eval_binary(Evaluator_t *ev, int level) {
+    if (level >= BINARY_LEVELS) {
+        return eval_unary(ev);
+    }
+
+    ComptimeValue_t value = eval_binary(ev, level + 1);
+    for (;;) {
+        const char *op = NULL;
+        for (int k = 0; binary_levels[level][k]; k++) {
+            if (accept(ev, binary_levels[level][k])) {
+                op = binary_levels[level][k];
+                break;
+            }
+        }
+        if (!op || ev->error) {
+            return value;
+        }
+
+        bool short_circuit = (strcmp(op, "&&") == 0 && !value.value) || (strcmp(op, "||") == 0 && value.value);
+        ev->skip += short_circuit;
+        ComptimeValue_t right = eval_binary(ev, level + 1);
+        ev->skip -= short_circuit;
+        value = short_circuit ? make_value(value.value != 0, false) : apply(ev, op, value, right);
+    }
+}
+
+/* expression: binary [? expression : expression] */
+static ComptimeValue_t eval_expression(Evaluator_t *ev) {
+    ComptimeValue_t condition = eval_binary(ev, 0);
+    if (!accept(ev, "?")) {
+        return condition;
+    }
+
+    bool taken = condition.value != 0;
+    ev->skip += !taken;
+    ComptimeValue_t then_value = eval_expression(ev);
+    ev->skip -= !taken;
+    if (!accept(ev, ":")) {
+        return fail(ev, "expected ':'");
+    }
+    ev->skip += taken;
+    ComptimeValue_t else_value = eval_expression(ev);
+    ev->skip -= taken;
+    /* Both branches convert to their common type */
+    return make_value(taken ? then_value.value : else_value.value, then_value.is_unsigned || else_value.is_unsigned);
+}
+
+/* Evaluate the whole of [start, end), reporting errors; returns false on error */
+static bool evaluate(Evaluator_t *ev, size_t start, size_t end, ComptimeValue_t *value,
+                     const char *filename, const char *source) {
+    ev->pos = start;
+    ev->end = end;
+    ev->skip = 0;
+    ev->error = NULL;
+    *value = eval_expression(ev);
+    if (!ev->error && current(ev)) {
+        fail(ev, "unexpected token");
+    }
+    if (ev->error) {
+        const Token *token = &ev->children[ev->error_pos]->token;
+        char error_msg[512];
+        snprintf(error_msg, sizeof(error_msg), ERR_COMPTIME_INVALID_EXPRESSION, ev->error);
+        cz_error_at(filename, source, token->line, token->column, error_msg);
+        return false;
+    }
+    return true;
+}
+
+/* Truncate value to bits, sign-extending signed types */
+static long long truncate_value(long long value, int bits, bool is_signed) {
+    if (bits == 1) {
+        return value != 0;
+    }
+    if (bits >= 64) {
+        return value;
+    }
+    unsigned long long mask = (1ULL << bits) - 1;
+    unsigned long long truncated = (unsigned long long)value & mask;
+    if (is_signed && (truncated >> (bits - 1))) {
+        return (long long)(truncated | ~mask);
+    }
+    return (long long)truncated;
+}
+
+/* Write "static const type name[count] = { values }" into a new string, or NULL */
+static char *format_table(const char *type, const char *name, const ComptimeTable_t *table, bool is_signed) {
+    size_t capacity = strlen(type) + strlen(name) + 64 + table->count * 24;
+    char *text = malloc(capacity);
+    if (!text) {
+        return NULL;
+    }
+
+    size_t length = (size_t)snprintf(text, capacity, "static const %s %s[%zu] = {", type, name, table->count);
+    for (size_t k = 0; k < table->count; k++) {
+        long long value = table->values[k];
+        const char *separator = k == 0 ? " " : ", ";
+        if (is_signed && value == LLONG_MIN) {
+            length += (size_t)snprintf(text + length, capacity - length, "%s(-%lld - 1)", separator, LLONG_MAX);
+        } else if (is_signed || value >= 0) {
+            length += (size_t)snprintf(text + length, capacity - length, "%s%lld", separator, value);
+        } else {
+            length += (size_t)snprintf(text + length, capacity - length, "%s%lluu", separator, (unsigned long long)value);
+        }
+    }
+    snprintf(text + length, capacity - length, " }");
+    return text;
+}
+
+/* Report an invalid comptime declaration at token */
+static void report(const Token *token, const char *reason, const char *filename, const char *source) {
+    char error_msg[512];
+    snprintf(error_msg, sizeof(error_msg), ERR_COMPTIME_INVALID_DECLARATION, reason);
+    cz_error_at(filename, source, token->line, token->column, error_msg);
+}
+
+/* Expand "comptime type name[count] = [index] expression;" at position start, returns false on error */
+static bool expand_table(ASTNode_t *ast, size_t start, ComptimeTable_t *tables, size_t *table_count,
+                         const char *filename, const char *source) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    const Token *keyword = &children[start]->token;
+
+    /* Type and name */
+    size_t type_pos = ast_skip_trivia(children, count, start + 1);
+    size_t name_pos = ast_skip_trivia(children, count, type_pos + 1);
+    size_t open = ast_skip_trivia(children, count, name_pos + 1);
+    if (open >= count || children[name_pos]->token.type != TOKEN_IDENTIFIER ||
+        !token_equals(&children[open]->token, "[")) {
+        report(keyword, "expected 'comptime type name[count] = [index] expression;'", filename, source);
+        return false;
+    }
+    const char *type = transpiler_get_c_type(children[type_pos]->token.text);
+    type = type ? type : children[type_pos]->token.text;
+    int bits = 0;
+    bool is_signed = false;
+    for (int k = 0; element_types[k].name; k++) {
+        if (strcmp(element_types[k].name, type) == 0) {
+            bits = element_types[k].bits;
+            is_signed = element_types[k].is_signed;
+        }
+    }
+    if (bits == 0) {
+        report(&children[type_pos]->token, "the element type must be an integer type", filename, source);
+        return false;
+    }
+
+    /* [count] = [index] */
+    size_t close = ast_match(ast, open);
+    size_t assign = close == AST_NO_MATCH ? count : ast_skip_trivia(children, count, close + 1);
+    size_t index_open = ast_skip_trivia(children, count, assign + 1);
+    size_t index_pos = ast_skip_trivia(children, count, index_open + 1);
+    size_t index_close = ast_skip_trivia(children, count, index_pos + 1);
+    if (index_close >= count || !token_equals(&children[assign]->token, "=") ||
+        !token_equals(&children[index_open]->token, "[") ||
+        children[index_pos]->token.type != TOKEN_IDENTIFIER ||
+        !token_equals(&children[index_close]->token, "]")) {
+        report(keyword, "expected 'comptime type name[count] = [index] expression;'", filename, source);
+        return false;
+    }
+
+    /* The expression ends at the ';' outside brackets */
+    size_t end = index_close + 1;
+    while (end < count && !token_equals(&children[end]->token, ";")) {
+        const Token *t = &children[end]->token;
+        if (token_equals(t, "(") || token_equals(t, "[")) {
+            size_t match = ast_match(ast, end);
+            end = match == AST_NO_MATCH ? count : match;
+        } else if (token_equals(t, "{") || token_equals(t, "}")) {
+            end = count;
+            break;
+        }
+        end++;
+    }
+    if (end >= count) {
+        report(keyword, "expected ';' after the expression", filename, source);
+        return false;
+    }
+
+    Evaluator_t ev = { children, 0, 0, SYM_NONE, 0, tables, *table_count, 0, NULL, 0 };
+    ComptimeValue_t length = make_value(0, false);
+    if (!evaluate(&ev, open + 1, close, &length, filename, source)) {
+        return false;
+    }
+    if (length.value == 0 || (!length.is_unsigned && length.value < 0) ||
+        (unsigned long long)length.value > COMPTIME_MAX_COUNT) {
+        report(&children[open]->token, "the count must be between 1 and 65536", filename, source);
+        return false;
+    }
+
+    ComptimeTable_t *table = &tables[*table_count];
+    table->symbol = cz_token_symbol(&children[name_pos]->token);
+    table->count = (size_t)length.value;
+    table->is_unsigned = !is_signed && bits >= 32;
+    table->filled = 0;
+    table->values = malloc(table->count * sizeof(long long));
+    if (!table->values) {
+        return false;
+    }
+
+    ev.index_symbol = cz_token_symbol(&children[index_pos]->token);
+    ev.table_count = *table_count + 1;
+    for (size_t k = 0; k < table->count; k++) {
+        ComptimeValue_t value = make_value(0, false);
+        ev.index = (long long)k;
+        if (!evaluate(&ev, index_close + 1, end, &value, filename, source)) {
+            free(table->values);
+            return false;
+        }
+        table->values[k] = truncate_value(value.value, bits, is_signed);
+        table->filled = k + 1;
+    }
+    (*table_count)++;
+
+    char *text = format_table(type, children[name_pos]->token.text, table, is_signed);
+    if (text) {
+        /* The ';' stays a token of its own so the declaration still ends there */
+        ast_clear_range(children, start + 1, end);
+        token_take_text(&children[start]->token, text);
+    }
+    return true;
+}
+
+/* Expand comptime tables to static const arrays with their values precomputed */
+void transpiler_transform_comptime(ASTNode_t *ast, const char *filename, const char *source) {
+    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
+        return;
+    }
+
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    ComptimeTable_t *tables = NULL;
+    size_t table_count = 0;
+    size_t table_capacity = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        Token *token = &children[i]->token;
+        if (token->type != TOKEN_IDENTIFIER || !token_equals(token, "comptime")) {
+            continue;
+        }
+
+        if (table_count == table_capacity) {
+            size_t new_capacity = table_capacity == 0 ? 8 : table_capacity * 2;
+            ComptimeTable_t *grown = realloc(tables, new_capacity * sizeof(ComptimeTable_t));
+            if (!grown) {
+                break;
+            }
+            tables = grown;
+            table_capacity = new_capacity;
+        }
+        expand_table(ast, i, tables, &table_count, filename, source);
+    }
+
+    for (size_t t = 0; t < table_count; t++) {
+        free(tables[t].values);
+    }
+    free(tables);
+}
@@ -0,0 +1,18 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Evaluates compile-time lookup tables.
+ *
+ * Supported pattern:
+ * - comptime type name[count] = [index] expression;
+ *   → static const type name[count] = { expression at 0, expression at 1, ... };
+ */
+
+#pragma once
+
+#include "../parser.h"
+
+/* Expand comptime tables to static const arrays with their values precomputed */
+void transpiler_transform_comptime(ASTNode_t *ast, const char *filename, const char *source);
@@ -8,6 +8,9 @@
 
 #define _POSIX_C_SOURCE 200809L
 #include <string.h>
+#include "../lexer.h"
+#include "../symbols.h"
+#include "../worker.h"
 
 #if defined(_MSC_VER) && !defined(strdup)
     /* Map calls to strdup(...) to MSVC's _strdup(...) */
@@ -15,5 +18,23 @@
 #endif
 
 /* Global context for error/warning reporting */
-extern const char *g_filename;
-extern const char *g_source;
+extern CZ_THREAD_LOCAL const char *g_filename;
+extern CZ_THREAD_LOCAL const char *g_source;
+
+/* Interner shared by the lexer and every feature (see Transpiler_t) */
+extern CZ_THREAD_LOCAL SymbolTable *g_symbols;
+
+/* Intern length bytes of text in the shared table, returns its symbol ID */
+int cz_intern_length(const char *text, size_t length);
+
+/* Intern a NUL-terminated name in the shared table, returns its symbol ID */
+int cz_intern(const char *name);
+
+/* Get the interned copy of a name (equal names share one pointer), or NULL */
+const char *cz_intern_name(const char *name);
+
+/* Get the symbol ID of a token's text (IDs assigned by the lexer are reused) */
+int cz_token_symbol(const Token *token);
+
+/* Get the interned text of a symbol ID (stable until the table is freed), or NULL */
+const char *cz_symbol_name(int id);
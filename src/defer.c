@@ -6,21 +6,129 @@
  * Handles #defer keyword for scope-exit cleanup using cleanup attribute.
  * Transforms: type var = init() #defer { code };
  * Into: Generated cleanup function + __attribute__((cleanup(...))) type var = init();
+ * With #pragma czar defer inline: type var = init(); and { code } before each
+ * return, break, continue and closing brace leaving the scope.
  */
 
 #include "cz.h"
 #include "defer.h"
+#include "errors.h"
+#include "pragma.h"
+#include "../hashtable.h"
+#include "../rewrite.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
 /* Counter for generating unique cleanup function names */
-static int defer_counter = 0;
+static CZ_THREAD_LOCAL int defer_counter = 0;
+
+/* Generated cleanup functions (memory sink, grows geometrically) */
+static CZ_THREAD_LOCAL OutputSink_t generated_defer_functions;
+
+/* Body of the #defer block being transformed, and scratch text for its replacement */
+static CZ_THREAD_LOCAL OutputSink_t defer_body;
+static CZ_THREAD_LOCAL OutputSink_t defer_text;
+
+/* Stands for the deferred variable in the body a cleanup function is shared by */
+#define DEFER_VARIABLE_MARK '\x01'
+
+/* One generated cleanup function */
+typedef struct {
+    size_t key;              /* Offset in helper_text of its body, variable marked */
+    size_t name;             /* Offset in helper_text of its name */
+} DeferHelper_t;
+
+/* Generated cleanup functions, shared by every #defer with the same body */
+static CZ_THREAD_LOCAL DeferHelper_t *helpers = NULL;
+static CZ_THREAD_LOCAL size_t helper_count = 0;
+static CZ_THREAD_LOCAL size_t helper_capacity = 0;
+static CZ_THREAD_LOCAL OutputSink_t helper_text;     /* NUL-terminated keys and names */
+static CZ_THREAD_LOCAL HashTable_t helper_bodies;    /* Hash of key -> index in helpers */
+static CZ_THREAD_LOCAL HashTable_t helper_names;     /* Hash of name -> index in helpers */
+
+/* Statements break and continue leave */
+typedef enum {
+    JUMP_LOOP,
+    JUMP_SWITCH
+} JumpKind_t;
+
+/* #defer in scope while lowering inline */
+typedef struct {
+    size_t depth;            /* Brace depth of the block it belongs to */
+    size_t body;             /* Offset of its NUL-terminated body in inline_bodies */
+} InlineDefer_t;
+
+/* Loop or switch being walked while lowering inline */
+typedef struct {
+    JumpKind_t kind;         /* What it is to break and continue */
+    size_t mark;             /* Defers in scope when it started (leaving it runs the later ones) */
+    size_t depth;            /* Brace depth of its keyword */
+    int braced;              /* Its body is a { block } (else a single statement) */
+    int is_do;               /* do ... while (...); */
+} InlineJump_t;
+
+/* Inline lowering state (thread-local so an error can't leak it) */
+static CZ_THREAD_LOCAL InlineDefer_t *inline_defers = NULL;
+static CZ_THREAD_LOCAL size_t inline_defer_count = 0;
+static CZ_THREAD_LOCAL size_t inline_defer_capacity = 0;
+static CZ_THREAD_LOCAL InlineJump_t *inline_jumps = NULL;
+static CZ_THREAD_LOCAL size_t inline_jump_count = 0;
+static CZ_THREAD_LOCAL size_t inline_jump_capacity = 0;
+static CZ_THREAD_LOCAL OutputSink_t inline_bodies;
+static CZ_THREAD_LOCAL OutputSink_t inline_return;   /* Return type of the function being walked ("" if unknown) */
+static CZ_THREAD_LOCAL ASTRewrite_t inline_rewrite;
+
+/* Forget the generated cleanup functions, keeping the memory */
+static void clear_defer_tables(void) {
+    defer_counter = 0;
+    generated_defer_functions.length = 0;
+    generated_defer_functions.failed = false;
+    helper_text.length = 0;
+    helper_text.failed = false;
+    helper_count = 0;
+    hash_table_clear(&helper_bodies);
+    hash_table_clear(&helper_names);
+    inline_defer_count = 0;
+    inline_jump_count = 0;
+    inline_bodies.length = 0;
+    inline_bodies.failed = false;
+    inline_return.length = 0;
+    inline_return.failed = false;
+    ast_rewrite_free(&inline_rewrite);
+}
+
+/* Release the cleanup functions generated for the current translation unit */
+void transpiler_free_defer_tables(void) {
+    clear_defer_tables();
+    sink_free(&generated_defer_functions);
+    sink_free(&defer_body);
+    sink_free(&defer_text);
+    sink_free(&helper_text);
+    free(helpers);
+    helpers = NULL;
+    helper_capacity = 0;
+    hash_table_free(&helper_bodies);
+    hash_table_free(&helper_names);
+    sink_free(&inline_bodies);
+    sink_free(&inline_return);
+    free(inline_defers);
+    inline_defers = NULL;
+    inline_defer_capacity = 0;
+    free(inline_jumps);
+    inline_jumps = NULL;
+    inline_jump_capacity = 0;
+}
 
-/* Buffer to store generated cleanup functions */
-static char *generated_defer_functions = NULL;
-static size_t generated_defer_functions_size = 0;
+/* Get the bytes held by the generated cleanup functions (cz --stats) */
+size_t transpiler_defer_table_bytes(void) {
+    return generated_defer_functions.capacity + defer_body.capacity + defer_text.capacity +
+           helper_capacity * sizeof(DeferHelper_t) + helper_text.capacity +
+           hash_table_bytes(&helper_bodies) + hash_table_bytes(&helper_names) +
+           inline_defer_capacity * sizeof(InlineDefer_t) + inline_jump_capacity * sizeof(InlineJump_t) +
+           inline_bodies.capacity + inline_return.capacity;
+}
 
 /* Helper to check if token text matches a string */
 static int token_matches(Token *tok, const char *str) {
@@ -29,19 +137,6 @@ static int token_matches(Token *tok, const char *str) {
     return tok->length == len && strncmp(tok->text, str, len) == 0;
 }
 
-/* Helper to skip whitespace and comments */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t start) {
-    if (!children) return count;
-    for (size_t i = start; i < count; i++) {
-        if (!children[i] || children[i]->type != AST_TOKEN) continue;
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            return i;
-        }
-    }
-    return count;
-}
-
 /* Extract variable name from declaration by scanning backwards */
 static char* extract_variable_name(ASTNode_t **children, size_t count __attribute__((unused)), size_t defer_pos) {
 
@@ -98,165 +193,621 @@ static char* extract_variable_name(ASTNode_t **children, size_t count __attribut
     return NULL;
 }
 
-/* Transform #defer declarations to cleanup attribute pattern */
-void transpiler_transform_defer(ASTNode_t *ast) {
-    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
-        return;
+/* Check whether c can be part of an identifier */
+static bool is_word_char(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+/* Write body with each whole-word var_name replaced by replacement, or by
+ * DEFER_VARIABLE_MARK outside string and character literals when NULL */
+static void write_substituted(OutputSink_t *out, const char *body, const char *var_name, const char *replacement) {
+    size_t var_len = strlen(var_name);
+    const char *src = body;
+    while (*src) {
+        /* A key keeps literals verbatim: "freeing p" and "freeing q" are different bodies */
+        if (!replacement && (*src == '"' || *src == '\'')) {
+            char quote = *src;
+            sink_putc(out, *src++);
+            while (*src && *src != quote) {
+                if (*src == '\\' && src[1]) {
+                    sink_putc(out, *src++);
+                }
+                sink_putc(out, *src++);
+            }
+            if (*src) {
+                sink_putc(out, *src++);
+            }
+            continue;
+        }
+        /* Check we're at the variable name and it's not part of a larger word */
+        if (strncmp(src, var_name, var_len) == 0 &&
+            (src == body || !is_word_char(src[-1])) && !is_word_char(src[var_len])) {
+            if (replacement) {
+                sink_printf(out, "(*%s)", replacement);
+            } else {
+                sink_putc(out, DEFER_VARIABLE_MARK);
+            }
+            src += var_len;
+            continue;
+        }
+        sink_putc(out, *src++);
     }
+}
 
-    if (!ast->children || ast->child_count == 0) {
-        return;
+/* Get the cleanup function of a declaration defer, generating it unless one with
+ * the same body exists; returns its offset in helper_text, or HASH_TABLE_MISSING */
+static size_t cleanup_function(const char *var_name, const char *cleanup_code) {
+    /* Key: the body with the variable marked, so "free(p)" and "free(q)" share one function */
+    size_t key = helper_text.length;
+    write_substituted(&helper_text, cleanup_code, var_name, NULL);
+    sink_putc(&helper_text, '\0');
+    if (helper_text.failed) {
+        return HASH_TABLE_MISSING;
+    }
+    uint64_t key_hash = hash_key_string(helper_text.data + key);
+    size_t index = hash_table_get(&helper_bodies, key_hash);
+    if (index != HASH_TABLE_MISSING && strcmp(helper_text.data + helpers[index].key, helper_text.data + key) == 0) {
+        helper_text.length = key;
+        return helpers[index].name;
     }
 
-    /* Reset defer counter and clear previous generated functions */
-    defer_counter = 0;
-    free(generated_defer_functions);
-    generated_defer_functions = NULL;
-    generated_defer_functions_size = 0;
+    /* Name it after the variable, numbered when another body already took that name */
+    size_t name = helper_text.length;
+    sink_printf(&helper_text, "_cz_cleanup_%s", var_name);
+    sink_putc(&helper_text, '\0');
+    if (helper_text.failed) {
+        return HASH_TABLE_MISSING;
+    }
+    uint64_t name_hash = hash_key_string(helper_text.data + name);
+    if (hash_table_get(&helper_names, name_hash) != HASH_TABLE_MISSING) {
+        helper_text.length = name;
+        sink_printf(&helper_text, "_cz_cleanup_%s_%d", var_name, defer_counter);
+        sink_putc(&helper_text, '\0');
+        if (helper_text.failed) {
+            return HASH_TABLE_MISSING;
+        }
+        name_hash = hash_key_string(helper_text.data + name);
+    }
 
-    /* Scan for #defer patterns in declarations */
-    for (size_t i = 0; i < ast->child_count; i++) {
-        if (!ast->children[i]) continue;
-        if (ast->children[i]->type != AST_TOKEN) continue;
+    if (helper_count >= helper_capacity) {
+        size_t new_capacity = helper_capacity == 0 ? 16 : helper_capacity * 2;
+        DeferHelper_t *new_helpers = realloc(helpers, new_capacity * sizeof(DeferHelper_t));
+        if (!new_helpers) {
+            return HASH_TABLE_MISSING;
+        }
+        helpers = new_helpers;
+        helper_capacity = new_capacity;
+    }
+    if (!hash_table_put(&helper_bodies, key_hash, helper_count) ||
+        !hash_table_put(&helper_names, name_hash, helper_count)) {
+        return HASH_TABLE_MISSING;
+    }
+    helpers[helper_count].key = key;
+    helpers[helper_count].name = name;
+    helper_count++;
+
+    /* For declaration defer, the function gets a pointer: replace var_name with (*var_name) */
+    OutputSink_t *out = &generated_defer_functions;
+    sink_printf(out, "static void %s(void **%s) {\n    ", helper_text.data + name, var_name);
+    write_substituted(out, cleanup_code, var_name, var_name);
+    sink_puts(out, "\n}\n");
+    return out->failed ? HASH_TABLE_MISSING : name;
+}
 
-        Token *tok = &ast->children[i]->token;
+/* Check if a token is a #defer directive (not #defer_something) */
+static int is_defer_directive(const Token *tok) {
+    if (tok->type != TOKEN_PREPROCESSOR || !tok->text) {
+        return 0;
+    }
 
-        /* Look for #defer preprocessor directive */
-        if (tok->type != TOKEN_PREPROCESSOR) continue;
-        if (!tok->text) continue;
+    /* Check for #defer */
+    size_t defer_len = strlen("#defer");
+    if (tok->length < defer_len) return 0;
+    if (strncmp(tok->text, "#defer", defer_len) != 0) return 0;
+
+    /* Check it's exactly #defer, not #defer_something */
+    if (tok->length > defer_len) {
+        char next_char = tok->text[defer_len];
+        if (next_char != ' ' && next_char != '\t' && next_char != '\r' && next_char != '\n' && next_char != '{') {
+            return 0;
+        }
+    }
+    return 1;
+}
 
+/* Read the { block } of the #defer directive at index i into defer_body (NUL-terminated),
+ * setting end_token_idx to its last token; returns 0 if there is no complete block */
+static int read_defer_block(ASTNode_t *ast, size_t i, size_t *end_token_idx) {
+    Token *tok = &ast->children[i]->token;
+    size_t defer_len = strlen("#defer");
 
-        /* Check for #defer */
-        size_t defer_len = strlen("#defer");
-        if (tok->length < defer_len) continue;
-        if (strncmp(tok->text, "#defer", defer_len) != 0) continue;
+    /* Extract the code block from the #defer directive */
+    /* The block might span multiple tokens if it's multiline */
 
+    /* First, check if the opening brace is in this token */
+    const char *block_start = tok->text + defer_len;
+    while (*block_start && (*block_start == ' ' || *block_start == '\t')) {
+        block_start++;
+    }
 
-        /* Check it's exactly #defer, not #defer_something */
-        if (tok->length > defer_len) {
-            char next_char = tok->text[defer_len];
-            if (next_char != ' ' && next_char != '\t' && next_char != '\r' && next_char != '\n' && next_char != '{') {
-                continue;
+    int brace_in_token = (*block_start == '{');
+    int have_code = 0;
+    *end_token_idx = i;
+    defer_body.length = 0;
+    defer_body.failed = false;
+
+    if (brace_in_token && tok->length > (size_t)(block_start - tok->text + 1)) {
+        /* Opening brace is in this token, try to find closing brace within token */
+        int brace_count = 0;
+        const char *code_start = block_start + 1;
+        const char *block_end = code_start;
+
+        for (const char *p = block_start; *p; p++) {
+            if (*p == '{') brace_count++;
+            if (*p == '}') {
+                brace_count--;
+                if (brace_count == 0) {
+                    block_end = p;
+                    break;
+                }
             }
         }
 
-        /* Extract the code block from the #defer directive */
-        /* The block might span multiple tokens if it's multiline */
+        if (brace_count == 0) {
+            /* Complete block in single token */
+            sink_write(&defer_body, code_start, (size_t)(block_end - code_start));
+            have_code = 1;
+        }
+    }
+
+    if (!have_code) {
+        /* Block spans multiple tokens - collect them */
+        /* Find opening brace first */
+        size_t brace_start_idx = i;
+        int found_open_brace = brace_in_token;
 
-        /* First, check if the opening brace is in this token */
-        const char *block_start = tok->text + defer_len;
-        while (*block_start && (*block_start == ' ' || *block_start == '\t')) {
-            block_start++;
+        if (!found_open_brace) {
+            /* Look forward for opening brace */
+            for (size_t j = i + 1; j < ast->child_count; j++) {
+                if (!ast->children[j] || ast->children[j]->type != AST_TOKEN) continue;
+                Token *t = &ast->children[j]->token;
+                if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT) continue;
+                if (t->type == TOKEN_PUNCTUATION && token_matches(t, "{")) {
+                    brace_start_idx = j;
+                    found_open_brace = 1;
+                    break;
+                }
+                /* If we hit something else, not a defer block */
+                break;
+            }
         }
 
-        int brace_in_token = (*block_start == '{');
-        char *cleanup_code = NULL;
-        size_t end_token_idx = i;
+        if (!found_open_brace) {
+            /* Not a code block defer */
+            return 0;
+        }
 
-        if (brace_in_token && tok->length > (size_t)(block_start - tok->text + 1)) {
-            /* Opening brace is in this token, try to find closing brace within token */
-            int brace_count = 0;
-            const char *code_start = block_start + 1;
-            const char *block_end = code_start;
+        /* Now collect tokens until we find matching closing brace */
+        int brace_count = 1;
+        for (size_t j = brace_start_idx + 1; j < ast->child_count && brace_count > 0; j++) {
+            if (!ast->children[j] || ast->children[j]->type != AST_TOKEN) continue;
+            Token *t = &ast->children[j]->token;
 
-            for (const char *p = block_start; *p; p++) {
-                if (*p == '{') brace_count++;
-                if (*p == '}') {
+            /* Check for braces */
+            if (t->type == TOKEN_PUNCTUATION) {
+                if (token_matches(t, "{")) brace_count++;
+                else if (token_matches(t, "}")) {
                     brace_count--;
                     if (brace_count == 0) {
-                        block_end = p;
+                        *end_token_idx = j;
                         break;
                     }
                 }
             }
 
-            if (brace_count == 0) {
-                /* Complete block in single token */
-                size_t code_len = block_end - code_start;
-                cleanup_code = malloc(code_len + 1);
-                if (!cleanup_code) continue;
-                memcpy(cleanup_code, code_start, code_len);
-                cleanup_code[code_len] = '\0';
+            /* Append token text to the body */
+            if (t->text) {
+                sink_write(&defer_body, t->text, t->length);
             }
+            *end_token_idx = j;
         }
 
-        if (!cleanup_code) {
-            /* Block spans multiple tokens - collect them */
-            /* Find opening brace first */
-            size_t brace_start_idx = i;
-            int found_open_brace = brace_in_token;
+        if (brace_count != 0) {
+            return 0;
+        }
+    }
 
-            if (!found_open_brace) {
-                /* Look forward for opening brace */
-                for (size_t j = i + 1; j < ast->child_count; j++) {
-                    if (!ast->children[j] || ast->children[j]->type != AST_TOKEN) continue;
-                    Token *t = &ast->children[j]->token;
-                    if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT) continue;
-                    if (t->type == TOKEN_PUNCTUATION && token_matches(t, "{")) {
-                        brace_start_idx = j;
-                        found_open_brace = 1;
-                        break;
-                    }
-                    /* If we hit something else, not a defer block */
-                    break;
-                }
-            }
+    sink_putc(&defer_body, '\0');
+    if (defer_body.failed) {
+        return 0;
+    }
+    return 1;
+}
 
-            if (!found_open_brace) {
-                /* Not a code block defer */
-                continue;
+/* Check if a child is a token with exactly this text */
+static int child_is(ASTNode_t **children, size_t count, size_t index, const char *text) {
+    return index < count && children[index]->type == AST_TOKEN && token_matches(&children[index]->token, text);
+}
+
+/* Get the next significant child after index (count if none) */
+static size_t next_significant(ASTNode_t **children, size_t count, size_t index) {
+    return ast_skip_trivia(children, count, index + 1);
+}
+
+/* Insert a copy of code (lexed again, comments dropped) before position */
+static void insert_code(size_t position, const char *code, int line, int column) {
+    Lexer lexer;
+    lexer_init(&lexer, code, strlen(code));
+    for (;;) {
+        Token token = lexer_next_token(&lexer);
+        if (token.type == TOKEN_EOF) {
+            token_free(&token);
+            break;
+        }
+        ASTNode_t *node = NULL;
+        if (token.type == TOKEN_WHITESPACE) {
+            /* Keep the expansion on the line of the exit it precedes */
+            node = ast_token_create(TOKEN_WHITESPACE, " ", line, column);
+        } else if (token.type != TOKEN_COMMENT && token.text) {
+            node = ast_token_create(token.type, token.text, line, column);
+        }
+        token_free(&token);
+        if (node) {
+            ast_rewrite_insert(&inline_rewrite, position, node);
+        }
+    }
+    lexer_cleanup(&lexer);
+}
+
+/* Insert the bodies of defers [first, inline_defer_count), latest first, before position */
+static void insert_cleanups(size_t position, size_t first, const Token *at) {
+    for (size_t d = inline_defer_count; d > first; d--) {
+        insert_code(position, "{ ", at->line, at->column);
+        insert_code(position, inline_bodies.data + inline_defers[d - 1].body, at->line, at->column);
+        insert_code(position, " } ", at->line, at->column);
+    }
+}
+
+/* Find the ';' ending the statement starting at index (brackets skipped), or count */
+static size_t statement_end(ASTNode_t *ast, size_t index) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    for (size_t j = index; j < count; j++) {
+        if (children[j]->type != AST_TOKEN || children[j]->token.type != TOKEN_PUNCTUATION) continue;
+        Token *t = &children[j]->token;
+        if (token_matches(t, ";")) {
+            return j;
+        }
+        if (token_matches(t, "(") || token_matches(t, "[") || token_matches(t, "{")) {
+            size_t match = ast_match(ast, j);
+            if (match == AST_NO_MATCH) {
+                return count;
             }
+            j = match;
+        }
+    }
+    return count;
+}
 
-            /* Now collect tokens until we find matching closing brace */
-            int brace_count = 1;
-            size_t code_buffer_size = 1024;
-            cleanup_code = malloc(code_buffer_size);
-            if (!cleanup_code) continue;
-            cleanup_code[0] = '\0';
-            size_t code_len = 0;
+/* Run the defers [first, inline_defer_count) before the jump statement at index,
+ * as "{ { cleanup } break; }" so a braceless if/else body stays one statement */
+static void lower_jump(ASTNode_t *ast, size_t index, size_t first) {
+    size_t end = statement_end(ast, index);
+    if (first >= inline_defer_count || end >= ast->child_count) {
+        return;
+    }
+    const Token *at = &ast->children[index]->token;
+    insert_code(index, "{ ", at->line, at->column);
+    insert_cleanups(index, first, at);
+    insert_code(end + 1, " }", at->line, at->column);
+}
 
-            for (size_t j = brace_start_idx + 1; j < ast->child_count && brace_count > 0; j++) {
-                if (!ast->children[j] || ast->children[j]->type != AST_TOKEN) continue;
-                Token *t = &ast->children[j]->token;
+/* Run the defers in scope after "return expr;" computed its value, as
+ * "{ type _cz_ret = expr; { cleanup } return _cz_ret; }" so the cleanups can't free what expr reads */
+static void lower_return(ASTNode_t *ast, size_t index, size_t end) {
+    if (inline_defer_count == 0 || end >= ast->child_count) {
+        return;
+    }
+    Token *at = &ast->children[index]->token;
+    int line = at->line;
+    int column = at->column;
+    insert_code(index, "{ ", line, column);
+    insert_code(index, inline_return.data, line, column);
+    insert_code(index, " _cz_ret =", line, column);
+    token_set_text(at, "");
+    at->type = TOKEN_WHITESPACE;
+    insert_code(end + 1, " ", line, column);
+    insert_cleanups(end + 1, 0, at);
+    insert_code(end + 1, "return _cz_ret; }", line, column);
+}
 
-                /* Check for braces */
-                if (t->type == TOKEN_PUNCTUATION) {
-                    if (token_matches(t, "{")) brace_count++;
-                    else if (token_matches(t, "}")) {
-                        brace_count--;
-                        if (brace_count == 0) {
-                            end_token_idx = j;
-                            break;
-                        }
-                    }
+/* Check if a token is a storage class or function specifier (not part of the return type) */
+static int is_function_specifier(Token *tok) {
+    static const char *specifiers[] = { "static", "inline", "extern", "export", "_Noreturn", "__inline",
+                                        "__inline__", "__extension__", NULL };
+    for (size_t k = 0; specifiers[k]; k++) {
+        if (token_matches(tok, specifiers[k])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Read into inline_return the return type of the function whose body opens at index
+ * (specifiers and __attribute__ dropped), "" when it is not a function or its type can't be told */
+static void read_return_type(ASTNode_t *ast, size_t index) {
+    ASTNode_t **children = ast->children;
+    inline_return.length = 0;
+    inline_return.failed = false;
+
+    /* Skip "__attribute__((...))" after the parameters, then the parameters and the name */
+    size_t j = ast_prev_significant(children, index);
+    for (;;) {
+        if (j == AST_NO_MATCH || !child_is(children, ast->child_count, j, ")")) return;
+        size_t open = ast_match(ast, j);
+        if (open == AST_NO_MATCH || open == 0) return;
+        j = ast_prev_significant(children, open);
+        if (j == AST_NO_MATCH || children[j]->token.type != TOKEN_IDENTIFIER) return;
+        if (!token_matches(&children[j]->token, "__attribute__")) break;
+        j = ast_prev_significant(children, j);
+    }
+
+    /* Walk back to the end of the previous declaration */
+    size_t first = j;
+    for (size_t k = ast_prev_significant(children, j); k != AST_NO_MATCH; k = ast_prev_significant(children, k)) {
+        Token *t = &children[k]->token;
+        if (children[k]->type != AST_TOKEN || t->type == TOKEN_PREPROCESSOR || token_matches(t, ";") ||
+            token_matches(t, "}") || token_matches(t, "{")) {
+            break;
+        }
+        if (token_matches(t, ")")) {
+            /* Only __attribute__((...)) has parentheses before the name */
+            size_t open = ast_match(ast, k);
+            size_t attribute = open == AST_NO_MATCH ? AST_NO_MATCH : ast_prev_significant(children, open);
+            if (attribute == AST_NO_MATCH || !token_matches(&children[attribute]->token, "__attribute__")) return;
+            k = attribute;
+            continue;
+        }
+        first = k;
+    }
+
+    for (size_t k = first; k < j; k++) {
+        Token *t = &children[k]->token;
+        if (children[k]->type != AST_TOKEN || t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT || !t->text ||
+            !t->text[0] || is_function_specifier(t)) {
+            continue;
+        }
+        if (strncmp(t->text, "__attribute__", 13) == 0 && t->text[13]) {
+            continue; /* Added by a feature as one token */
+        }
+        if (token_matches(t, "__attribute__")) {
+            size_t open = next_significant(children, ast->child_count, k);
+            size_t close = child_is(children, ast->child_count, open, "(") ? ast_match(ast, open) : AST_NO_MATCH;
+            if (close == AST_NO_MATCH) break;
+            k = close;
+            continue;
+        }
+        if (inline_return.length > 0) sink_putc(&inline_return, ' ');
+        sink_puts(&inline_return, t->text);
+    }
+    if (inline_return.failed) {
+        inline_return.length = 0;
+    }
+    sink_putc(&inline_return, '\0');
+    inline_return.length--;
+}
+
+/* Push the loop or switch whose keyword is at index, returns the last child of its header */
+static size_t push_jump(ASTNode_t *ast, size_t index, JumpKind_t kind, int is_do, size_t depth) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    size_t header_end = index;
+    if (!is_do) {
+        size_t open = next_significant(children, count, index);
+        size_t close = child_is(children, count, open, "(") ? ast_match(ast, open) : AST_NO_MATCH;
+        if (close == AST_NO_MATCH) {
+            return index;
+        }
+        header_end = close;
+    }
+
+    if (inline_jump_count >= inline_jump_capacity) {
+        size_t new_capacity = inline_jump_capacity == 0 ? 16 : inline_jump_capacity * 2;
+        InlineJump_t *new_jumps = realloc(inline_jumps, new_capacity * sizeof(InlineJump_t));
+        if (!new_jumps) {
+            return header_end;
+        }
+        inline_jumps = new_jumps;
+        inline_jump_capacity = new_capacity;
+    }
+    InlineJump_t *jump = &inline_jumps[inline_jump_count++];
+    jump->kind = kind;
+    jump->mark = inline_defer_count;
+    jump->depth = depth;
+    jump->braced = child_is(children, count, next_significant(children, count, header_end), "{");
+    jump->is_do = is_do;
+    return header_end;
+}
+
+/* Pop the braceless loops and switches at depth whose statement ends at index */
+static int close_braceless(ASTNode_t **children, size_t count, size_t index, size_t depth) {
+    int after_do = 0;
+    if (child_is(children, count, next_significant(children, count, index), "else")) {
+        return 0;
+    }
+    while (inline_jump_count > 0 && !inline_jumps[inline_jump_count - 1].braced &&
+           inline_jumps[inline_jump_count - 1].depth == depth) {
+        after_do = inline_jumps[inline_jump_count - 1].is_do;
+        inline_jump_count--;
+        if (after_do) {
+            break; /* Its "while (...);" follows */
+        }
+    }
+    return after_do;
+}
+
+/* Track a #defer in scope, its body copied to inline_bodies */
+static void push_defer(size_t depth) {
+    if (inline_defer_count >= inline_defer_capacity) {
+        size_t new_capacity = inline_defer_capacity == 0 ? 16 : inline_defer_capacity * 2;
+        InlineDefer_t *new_defers = realloc(inline_defers, new_capacity * sizeof(InlineDefer_t));
+        if (!new_defers) {
+            return;
+        }
+        inline_defers = new_defers;
+        inline_defer_capacity = new_capacity;
+    }
+    size_t body = inline_bodies.length;
+    sink_puts(&inline_bodies, defer_body.data);
+    sink_putc(&inline_bodies, '\0');
+    if (inline_bodies.failed) {
+        return;
+    }
+    InlineDefer_t *defer = &inline_defers[inline_defer_count++];
+    defer->depth = depth;
+    defer->body = body;
+}
+
+/* Expand each #defer body at every exit of its scope instead of generating cleanup functions */
+static void lower_defers_inline(ASTNode_t *ast) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    ast_rewrite_init(&inline_rewrite, ast);
+
+    size_t depth = 0;
+    int after_do = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (children[i]->type != AST_TOKEN) continue;
+        Token *tok = &children[i]->token;
+        if (tok->type == TOKEN_WHITESPACE || tok->type == TOKEN_COMMENT || !tok->text) continue;
+        int closing_do = after_do;
+        after_do = 0;
+
+        if (is_defer_directive(tok)) {
+            size_t end_token_idx = i;
+            if (depth == 0 || !read_defer_block(ast, i, &end_token_idx)) continue;
+            char *var_name = extract_variable_name(children, count, i);
+            int is_standalone = (var_name == NULL);
+            push_defer(depth);
+            free(var_name);
+
+            /* Declaration defer keeps "type var = init;", a standalone one disappears */
+            token_set_text(tok, is_standalone ? "" : ";");
+            tok->type = is_standalone ? TOKEN_WHITESPACE : TOKEN_PUNCTUATION;
+            for (size_t j = i + 1; j <= end_token_idx && j < count; j++) {
+                if (children[j]->type == AST_TOKEN) {
+                    token_set_text(&children[j]->token, "");
                 }
+            }
+            i = end_token_idx;
+            continue;
+        }
 
-                /* Append token text to cleanup_code */
-                if (t->text) {
-                    size_t needed = code_len + t->length + 1;
-                    if (needed > code_buffer_size) {
-                        code_buffer_size = needed * 2;
-                        char *new_buf = realloc(cleanup_code, code_buffer_size);
-                        if (!new_buf) {
-                            free(cleanup_code);
-                            cleanup_code = NULL;
-                            break;
-                        }
-                        cleanup_code = new_buf;
-                    }
-                    memcpy(cleanup_code + code_len, t->text, t->length);
-                    code_len += t->length;
-                    cleanup_code[code_len] = '\0';
+        if (tok->type == TOKEN_PUNCTUATION) {
+            if (token_matches(tok, "{")) {
+                if (depth == 0) {
+                    read_return_type(ast, i);
+                }
+                depth++;
+            } else if (token_matches(tok, "}") && depth > 0) {
+                /* The block ends: its defers run, latest first */
+                size_t first = inline_defer_count;
+                while (first > 0 && inline_defers[first - 1].depth == depth) {
+                    first--;
+                }
+                insert_cleanups(i, first, tok);
+                inline_defer_count = first;
+                depth--;
+
+                if (inline_jump_count > 0 && inline_jumps[inline_jump_count - 1].braced &&
+                    inline_jumps[inline_jump_count - 1].depth == depth) {
+                    InlineJump_t *jump = &inline_jumps[--inline_jump_count];
+                    after_do = jump->is_do;
                 }
-                end_token_idx = j;
+                if (!after_do) {
+                    after_do = close_braceless(children, count, i, depth);
+                }
+            } else if (token_matches(tok, ";")) {
+                after_do = close_braceless(children, count, i, depth);
             }
+            continue;
+        }
 
-            if (!cleanup_code || brace_count != 0) {
-                free(cleanup_code);
-                continue;
+        if (tok->type != TOKEN_KEYWORD && tok->type != TOKEN_IDENTIFIER) continue;
+        if (token_matches(tok, "while") && closing_do) {
+            /* "while (...);" closing a do loop */
+            size_t open = next_significant(children, count, i);
+            size_t close = child_is(children, count, open, "(") ? ast_match(ast, open) : AST_NO_MATCH;
+            if (close != AST_NO_MATCH) {
+                i = close;
+            }
+        } else if (token_matches(tok, "for") || token_matches(tok, "while")) {
+            i = push_jump(ast, i, JUMP_LOOP, 0, depth);
+        } else if (token_matches(tok, "switch")) {
+            i = push_jump(ast, i, JUMP_SWITCH, 0, depth);
+        } else if (token_matches(tok, "do")) {
+            push_jump(ast, i, JUMP_LOOP, 1, depth);
+        } else if (inline_defer_count == 0) {
+            continue;
+        } else if (token_matches(tok, "return")) {
+            size_t end = statement_end(ast, i);
+            if (child_is(children, count, next_significant(children, count, i), ";") ||
+                strcmp(inline_return.data ? inline_return.data : "", "void") == 0) {
+                lower_jump(ast, i, 0);
+            } else if (inline_return.length > 0) {
+                lower_return(ast, i, end);
+            } else {
+                cz_error_at(g_filename, g_source, tok->line, tok->column, ERR_DEFER_INLINE_RETURN_TYPE);
+            }
+        } else if (token_matches(tok, "break") && inline_jump_count > 0) {
+            lower_jump(ast, i, inline_jumps[inline_jump_count - 1].mark);
+        } else if (token_matches(tok, "continue")) {
+            for (size_t j = inline_jump_count; j > 0; j--) {
+                if (inline_jumps[j - 1].kind == JUMP_LOOP) {
+                    lower_jump(ast, i, inline_jumps[j - 1].mark);
+                    break;
+                }
             }
+        } else if (token_matches(tok, "goto")) {
+            cz_error_at(g_filename, g_source, tok->line, tok->column, ERR_DEFER_INLINE_GOTO);
         }
+    }
+
+    ast_rewrite_commit(&inline_rewrite);
+    inline_defer_count = 0;
+    inline_jump_count = 0;
+}
+
+/* Transform #defer declarations to cleanup attribute pattern */
+void transpiler_transform_defer(ASTNode_t *ast) {
+    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
+        return;
+    }
+
+    if (!ast->children || ast->child_count == 0) {
+        return;
+    }
+
+    /* Reset defer counter and clear previous generated functions */
+    clear_defer_tables();
+
+    if (g_pragmas && g_pragmas->defer_inline) {
+        lower_defers_inline(ast);
+        return;
+    }
+
+    /* Scan for #defer patterns in declarations */
+    for (size_t i = 0; i < ast->child_count; i++) {
+        if (!ast->children[i]) continue;
+        if (ast->children[i]->type != AST_TOKEN) continue;
+
+        Token *tok = &ast->children[i]->token;
 
+        /* Look for #defer preprocessor directive and its block */
+        if (!is_defer_directive(tok)) continue;
+        size_t end_token_idx = i;
+        if (!read_defer_block(ast, i, &end_token_idx)) continue;
+        const char *cleanup_code = defer_body.data;
 
         /* Extract variable name from the declaration */
         char *var_name = extract_variable_name(ast->children, ast->child_count, i);
@@ -266,21 +817,14 @@ void transpiler_transform_defer(ASTNode_t *ast) {
         if (is_standalone) {
             var_name = malloc(64);
             if (!var_name) {
-                free(cleanup_code);
                 continue;
             }
             snprintf(var_name, 64, "_cz_defer_%d", defer_counter);
         }
 
-
-
-        /* Generate cleanup function name */
-        char cleanup_func_name[128];
-        snprintf(cleanup_func_name, sizeof(cleanup_func_name), "_cz_cleanup_%s", var_name);
-
-        defer_counter++;
-
         if (is_standalone) {
+            defer_counter++;
+
             /* For standalone defer blocks that need to access outer scope variables,
              * we need nested functions (GCC extension) or blocks (Clang extension).
              * Since these are compiler-specific, we use conditional compilation.
@@ -288,15 +832,20 @@ void transpiler_transform_defer(ASTNode_t *ast) {
              * GCC: Use nested functions (fully supported)
              * Clang: Use blocks if available, otherwise compile error with helpful message
              */
-            char standalone_code[4096];
+            defer_text.length = 0;
+            defer_text.failed = false;
 
             /* Use nested functions with conditional compilation */
-            snprintf(standalone_code, sizeof(standalone_code),
+            sink_printf(&defer_text,
                 "#ifdef __GNUC__\n"
                 "#ifndef __clang__\n"
                 "/* GCC: Use nested functions for scope-exit cleanup with variable capture */\n"
-                "{ void %s(int *_cz_defer_var __attribute__((unused))) { %s } "
-                "int __attribute__((cleanup(%s))) %s __attribute__((unused)) = 0; }\n"
+                "{ void _cz_cleanup_%s(int *_cz_defer_var __attribute__((unused))) { ",
+                var_name);
+            sink_puts(&defer_text, cleanup_code);
+            sink_printf(&defer_text,
+                " } "
+                "int __attribute__((cleanup(_cz_cleanup_%s))) %s __attribute__((unused)) = 0; }\n"
                 "#else\n"
                 "/* Clang: Nested functions not supported. Standalone #defer blocks cannot access outer variables. */\n"
                 "#error \"Standalone #defer blocks with variable capture require GCC nested functions. Use declaration-time defer instead: TYPE VAR = INIT #defer { cleanup };\"\n"
@@ -304,11 +853,14 @@ void transpiler_transform_defer(ASTNode_t *ast) {
                 "#else\n"
                 "#error \"Standalone #defer blocks require GCC or Clang. Compiler not supported.\"\n"
                 "#endif\n",
-                cleanup_func_name, cleanup_code, cleanup_func_name, var_name);
+                var_name, var_name);
+            sink_putc(&defer_text, '\0');
+            free(var_name);
+            if (defer_text.failed) {
+                continue;
+            }
 
-            free(tok->text);
-            tok->text = strdup(standalone_code);
-            tok->length = strlen(standalone_code);
+            token_set_text(tok, defer_text.data);
             tok->type = TOKEN_IDENTIFIER;
 
             /* Remove tokens from i+1 to end_token_idx (inclusive) */
@@ -316,171 +868,90 @@ void transpiler_transform_defer(ASTNode_t *ast) {
                 for (size_t j = i + 1; j <= end_token_idx && j < ast->child_count; j++) {
                     if (ast->children[j] && ast->children[j]->type == AST_TOKEN) {
                         Token *t = &ast->children[j]->token;
-                        free(t->text);
-                        t->text = strdup("");
-                        t->length = 0;
+                        token_set_text(t, "");
                     }
                 }
             }
-
-            free(cleanup_code);
-            free(var_name);
             continue; /* Skip to next defer - no static function needed */
         }
 
-        /* For declaration defer, generate static cleanup function and apply attribute */
-        /* Generate the cleanup function */
-        char func_buf[2048];
-        int n;
-
-        /* For declaration defer, replace var_name with (*var_name) */
-        char modified_cleanup_code[2048];
-        char *mod_code = modified_cleanup_code;
-        const char *src = cleanup_code;
-        size_t remaining = sizeof(modified_cleanup_code) - 1;
-
-        /* Simple replacement: replace var_name with (*var_name) */
-        while (*src && remaining > 0) {
-            /* Check if we're at the start of the variable name */
-            if (strncmp(src, var_name, strlen(var_name)) == 0) {
-                /* Check it's not part of a larger word */
-                if ((src == cleanup_code || !isalnum(src[-1])) &&
-                    !isalnum(src[strlen(var_name)])) {
-                    /* Replace with (*var_name) */
-                    int written = snprintf(mod_code, remaining, "(*%s)", var_name);
-                    if (written > 0 && (size_t)written < remaining) {
-                        mod_code += written;
-                        remaining -= written;
-                    }
-                    src += strlen(var_name);
-                    continue;
+        /* For declaration defer, find the type token by scanning backwards from #defer */
+        size_t type_pos = 0;
+        int found = 0;
+
+        for (size_t j = i; j > 0; j--) {
+            size_t idx = j - 1;
+            if (!ast->children[idx] || ast->children[idx]->type != AST_TOKEN) continue;
+
+            Token *t = &ast->children[idx]->token;
+
+            /* Skip whitespace and comments */
+            if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT) continue;
+
+            /* If we hit a semicolon or opening brace, the type should be after it */
+            if (t->type == TOKEN_PUNCTUATION) {
+                if (token_matches(t, ";") || token_matches(t, "{")) {
+                    /* Type should be the next non-whitespace token */
+                    type_pos = ast_skip_trivia(ast->children, ast->child_count, idx + 1);
+                    found = 1;
+                    break;
                 }
             }
-            *mod_code++ = *src++;
-            remaining--;
+
+            /* Keep track of potential type position */
+            type_pos = idx;
         }
-        *mod_code = '\0';
 
-        n = snprintf(func_buf, sizeof(func_buf),
-            "static void %s(void **%s) {\n"
-            "    %s\n"
-            "}\n",
-            cleanup_func_name, var_name, modified_cleanup_code);
+        /* If we didn't find a ; or {, use the beginning */
+        if (!found && type_pos == 0) {
+            type_pos = ast_skip_trivia(ast->children, ast->child_count, 0);
+        }
 
-        if (n < 0 || n >= (int)sizeof(func_buf)) {
-            free(cleanup_code);
+        Token *type_tok = type_pos < i && ast->children[type_pos] ? &ast->children[type_pos]->token : NULL;
+        if (!type_tok || !type_tok->text) {
+            defer_counter++;
             free(var_name);
             continue;
         }
 
-        /* Add to global generated functions buffer */
-        size_t func_len = strlen(func_buf);
-        char *new_gen_funcs = realloc(generated_defer_functions, generated_defer_functions_size + func_len + 1);
-        if (!new_gen_funcs) {
-            free(cleanup_code);
-            free(var_name);
+        /* Generate (or reuse) the static cleanup function */
+        size_t name = cleanup_function(var_name, cleanup_code);
+        defer_counter++;
+        free(var_name);
+        if (name == HASH_TABLE_MISSING) {
             continue;
         }
-        generated_defer_functions = new_gen_funcs;
-        memcpy(generated_defer_functions + generated_defer_functions_size, func_buf, func_len);
-        generated_defer_functions_size += func_len;
-        generated_defer_functions[generated_defer_functions_size] = '\0';
-
-        /* For declaration defer, find the type token and prepend attribute */
-            /* Find the type token by scanning backwards from #defer */
-            size_t type_pos = 0;
-            int found = 0;
-
-            for (size_t j = i; j > 0; j--) {
-                size_t idx = j - 1;
-                if (!ast->children[idx] || ast->children[idx]->type != AST_TOKEN) continue;
-
-                Token *t = &ast->children[idx]->token;
-
-                /* Skip whitespace and comments */
-                if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT) continue;
-
-                /* If we hit a semicolon or opening brace, the type should be after it */
-                if (t->type == TOKEN_PUNCTUATION) {
-                    if (token_matches(t, ";") || token_matches(t, "{")) {
-                        /* Type should be the next non-whitespace token */
-                        type_pos = skip_whitespace(ast->children, ast->child_count, idx + 1);
-                        found = 1;
-                        break;
-                    }
-                }
-
-                /* Keep track of potential type position */
-                type_pos = idx;
-            }
-
-            /* If we didn't find a ; or {, use the beginning */
-            if (!found && type_pos == 0) {
-                type_pos = skip_whitespace(ast->children, ast->child_count, 0);
-            }
-
-            if (type_pos >= i || !ast->children[type_pos]) {
-                free(cleanup_code);
-                free(var_name);
-                continue;
-            }
-
-            /* Insert __attribute__((cleanup(func))) before the type */
-            char attr_buf[256];
-            n = snprintf(attr_buf, sizeof(attr_buf), "__attribute__((cleanup(%s))) ", cleanup_func_name);
-            if (n < 0 || n >= (int)sizeof(attr_buf)) {
-                free(cleanup_code);
-                free(var_name);
-                continue;
-            }
-
-            /* Prepend the attribute to the type token */
-            Token *type_tok = &ast->children[type_pos]->token;
-            if (!type_tok->text) {
-                free(cleanup_code);
-                free(var_name);
-                continue;
-            }
-
-            size_t new_len = strlen(attr_buf) + type_tok->length + 1;
-            char *new_text = malloc(new_len);
-            if (!new_text) {
-                free(cleanup_code);
-                free(var_name);
-                continue;
-            }
 
-            snprintf(new_text, new_len, "%s%s", attr_buf, type_tok->text);
-            free(type_tok->text);
-            type_tok->text = new_text;
-            type_tok->length = strlen(new_text);
+        /* Prepend __attribute__((cleanup(func))) to the type token */
+        defer_text.length = 0;
+        defer_text.failed = false;
+        sink_printf(&defer_text, "__attribute__((cleanup(%s))) ", helper_text.data + name);
+        sink_write(&defer_text, type_tok->text, type_tok->length);
+        sink_putc(&defer_text, '\0');
+        if (defer_text.failed || !token_set_text(type_tok, defer_text.data)) {
+            continue;
+        }
 
-            /* Replace the #defer token with just a semicolon */
-            free(tok->text);
-            tok->text = strdup(";");
-            tok->length = 1;
-            tok->type = TOKEN_PUNCTUATION;
+        /* Replace the #defer token with just a semicolon */
+        token_set_text(tok, ";");
+        tok->type = TOKEN_PUNCTUATION;
 
-            /* Remove tokens from i+1 to end_token_idx (inclusive) - these are the { cleanup_code } tokens */
-            if (end_token_idx > i) {
-                for (size_t j = i + 1; j <= end_token_idx && j < ast->child_count; j++) {
-                    if (ast->children[j] && ast->children[j]->type == AST_TOKEN) {
-                        Token *t = &ast->children[j]->token;
-                        free(t->text);
-                        t->text = strdup("");
-                        t->length = 0;
-                    }
+        /* Remove tokens from i+1 to end_token_idx (inclusive) - these are the { cleanup_code } tokens */
+        if (end_token_idx > i) {
+            for (size_t j = i + 1; j <= end_token_idx && j < ast->child_count; j++) {
+                if (ast->children[j] && ast->children[j]->type == AST_TOKEN) {
+                    Token *t = &ast->children[j]->token;
+                    token_set_text(t, "");
                 }
             }
-
-        free(cleanup_code);
-        free(var_name);
+        }
     }
 }
 
 /* Emit generated defer cleanup functions to output */
-void transpiler_emit_defer_functions(FILE *output) {
-    if (generated_defer_functions && generated_defer_functions_size > 0) {
-        fprintf(output, "%s\n", generated_defer_functions);
+void transpiler_emit_defer_functions(OutputSink_t *output) {
+    if (generated_defer_functions.length > 0) {
+        sink_write(output, generated_defer_functions.data, generated_defer_functions.length);
+        sink_putc(output, '\n');
     }
 }
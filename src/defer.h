@@ -9,10 +9,17 @@
 #pragma once
 
 #include "../parser.h"
+#include "../sink.h"
 #include <stdio.h>
 
 /* Transform defer statements to cleanup attribute pattern */
 void transpiler_transform_defer(ASTNode_t *ast);
 
 /* Emit generated defer cleanup functions to output */
-void transpiler_emit_defer_functions(FILE *output);
+void transpiler_emit_defer_functions(OutputSink_t *output);
+
+/* Release the cleanup functions generated for the current translation unit */
+void transpiler_free_defer_tables(void);
+
+/* Get the bytes held by the generated cleanup functions (cz --stats) */
+size_t transpiler_defer_table_bytes(void);
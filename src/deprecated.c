@@ -23,23 +23,10 @@
 /* Helper to clear token text (emit function handles NULL text) */
 static void clear_token_text(Token *token) {
     if (!token) return;
-    free(token->text);
-    token->text = NULL;
+    token_free(token);
     token->length = 0;
 }
 
-/* Skip whitespace and comments */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t start) {
-    for (size_t i = start; i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            return i;
-        }
-    }
-    return count;
-}
-
 /* Check if this position is the start of a function declaration/definition */
 static int is_function_declaration(ASTNode_t **children, size_t count, size_t start) {
     size_t i = start;
@@ -115,7 +102,7 @@ void transpiler_transform_deprecated(ASTNode_t *ast) {
         }
 
         /* Found #deprecated, check if it's followed by a function declaration */
-        size_t next_pos = skip_whitespace(ast->children, ast->child_count, i + 1);
+        size_t next_pos = ast_skip_trivia(ast->children, ast->child_count, i + 1);
 
         if (next_pos >= ast->child_count) {
             /* Just remove the #deprecated if nothing follows */
@@ -128,9 +115,7 @@ void transpiler_transform_deprecated(ASTNode_t *ast) {
             /* Replace #deprecated with __attribute__((deprecated)) followed by a space */
             char *replacement = strdup(ATTRIBUTE_DEPRECATED);
             if (replacement) {
-                free(ast->children[i]->token.text);
-                ast->children[i]->token.text = replacement;
-                ast->children[i]->token.length = strlen(replacement);
+                token_take_text(&ast->children[i]->token, replacement);
                 /* Change to TOKEN_KEYWORD so it's treated as part of the function declaration */
                 ast->children[i]->token.type = TOKEN_KEYWORD;
             } else {
@@ -9,34 +9,90 @@
 #include "cz.h"
 #include "enums.h"
 #include "switches.h"
+#include "pragma.h"
+#include "scopes.h"
+#include "types.h"
 #include "../transpiler.h"
 #include "errors.h"
 #include "warnings.h"
+#include "../hashtable.h"
+#include "../rewrite.h"
+#include "../sink.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
-/* Maximum number of enums and enum members we can track */
-#define MAX_ENUMS 256
-#define MAX_ENUM_MEMBERS 256
-
-/* Structure to hold enum member information */
+/* Structure to hold enum member information (registered names are interned) */
 typedef struct {
-    char *name;
-    char *original_name;  /* Original name from source */
+    const char *name;
+    const char *original_name;  /* Original name from source */
+    long long value;            /* Value, when known */
+    int has_value;              /* The value is an integer literal, or follows one */
 } EnumMember;
 
 /* Structure to hold enum information */
 typedef struct {
-    char *name;           /* Name of the enum */
-    EnumMember members[MAX_ENUM_MEMBERS];
+    const char *name;     /* Name of the enum (interned) */
+    EnumMember *members;  /* Members in declaration order */
     int member_count;
+    int dense;            /* Values are known, distinct and contiguous */
+    long long min_value;  /* Smallest value of a dense enum */
 } EnumInfo;
 
 /* Global enum registry */
-static EnumInfo g_enums[MAX_ENUMS];
-static int g_enum_count = 0;
+static CZ_THREAD_LOCAL EnumInfo *g_enums = NULL;
+static CZ_THREAD_LOCAL int g_enum_count = 0;
+static CZ_THREAD_LOCAL int g_enum_capacity = 0;
+
+/* Interned enum name -> index in g_enums */
+static CZ_THREAD_LOCAL HashTable_t g_enum_index;
+
+/* Interned original member name -> packed (enum index, member index) of its first declaration */
+static CZ_THREAD_LOCAL HashTable_t g_member_index;
+
+/* Packed (enum index, member symbol ID) -> member index within that enum */
+static CZ_THREAD_LOCAL HashTable_t g_enum_member_index;
+
+/* Interned variable name -> index in g_enums of its first "enum Name var" declaration
+ * (VARIABLE_NOT_ENUM when Name is not a registered enum) */
+static CZ_THREAD_LOCAL HashTable_t g_variable_index;
+
+#define VARIABLE_NOT_ENUM ((size_t)-2)
+
+/* Forget registered enums (names stay in the interner) */
+static void clear_enums(void) {
+    for (int i = 0; i < g_enum_count; i++) {
+        free(g_enums[i].members);
+    }
+    g_enum_count = 0;
+    hash_table_clear(&g_enum_index);
+    hash_table_clear(&g_member_index);
+    hash_table_clear(&g_enum_member_index);
+    hash_table_clear(&g_variable_index);
+}
+
+/* Release the enum registry of the current translation unit */
+void transpiler_free_enum_tables(void) {
+    clear_enums();
+    free(g_enums);
+    g_enums = NULL;
+    g_enum_capacity = 0;
+    hash_table_free(&g_enum_index);
+    hash_table_free(&g_member_index);
+    hash_table_free(&g_enum_member_index);
+    hash_table_free(&g_variable_index);
+}
+
+/* Get the bytes held by the enum registry (cz --stats) */
+size_t transpiler_enum_table_bytes(void) {
+    size_t bytes = (size_t)g_enum_capacity * sizeof(EnumInfo);
+    for (int i = 0; i < g_enum_count; i++) {
+        bytes += (size_t)g_enums[i].member_count * sizeof(EnumMember);
+    }
+    return bytes + hash_table_bytes(&g_enum_index) + hash_table_bytes(&g_member_index) +
+           hash_table_bytes(&g_enum_member_index) + hash_table_bytes(&g_variable_index);
+}
 
 /* Helper function to check if token text matches */
 static int token_text_equals(Token *token, const char *text) {
@@ -46,22 +102,6 @@ static int token_text_equals(Token *token, const char *text) {
     return strcmp(token->text, text) == 0;
 }
 
-/* Skip whitespace and comment tokens */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t i) {
-    while (i < count) {
-        if (children[i]->type != AST_TOKEN) {
-            i++;
-            continue;
-        }
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            break;
-        }
-        i++;
-    }
-    return i;
-}
-
 /* Check if a string is all uppercase (allows underscores and digits) */
 static int is_all_uppercase(const char *str) {
     if (!str || !*str) {
@@ -147,75 +187,179 @@ static char *generate_prefixed_name(const char *enum_name, const char *value_nam
     return result;
 }
 
+/* Check if members have known distinct values filling [min, min + member_count) */
+static int members_are_dense(const EnumMember *members, int member_count, long long *min) {
+    if (member_count <= 0) {
+        return 0;
+    }
+
+    long long low = members[0].value;
+    long long high = members[0].value;
+    for (int i = 0; i < member_count; i++) {
+        if (!members[i].has_value) {
+            return 0;
+        }
+        if (members[i].value < low) low = members[i].value;
+        if (members[i].value > high) high = members[i].value;
+    }
+    if ((unsigned long long)high - (unsigned long long)low != (unsigned long long)(member_count - 1)) {
+        return 0;
+    }
+
+    /* As many slots as members: dense when no two members share one */
+    unsigned char *seen = calloc((size_t)member_count, 1);
+    if (!seen) {
+        return 0;
+    }
+    int dense = 1;
+    for (int i = 0; i < member_count && dense; i++) {
+        size_t slot = (size_t)((unsigned long long)members[i].value - (unsigned long long)low);
+        dense = !seen[slot];
+        seen[slot] = 1;
+    }
+    free(seen);
+    *min = low;
+    return dense;
+}
+
 /* Register an enum declaration */
 static void register_enum(const char *enum_name, EnumMember *members, int member_count) {
-    if (g_enum_count >= MAX_ENUMS) {
-        /* Warn about capacity limit - validation may be incomplete */
-        char warning_msg[256];
-        snprintf(warning_msg, sizeof(warning_msg), WARN_MAX_ENUM_TRACKING_LIMIT,
-                MAX_ENUMS, enum_name);
-        cz_warning(g_filename, g_source, 0, warning_msg);
+    /* Check if enum already exists */
+    const char *interned_name = cz_intern_name(enum_name);
+    if (!interned_name) {
+        /* Memory allocation failed, cannot register enum */
+        return;
+    }
+    if (hash_table_get(&g_enum_index, hash_key_pointer(interned_name)) != HASH_TABLE_MISSING) {
+        /* Already registered, skip */
         return;
     }
 
-    /* Check if enum already exists */
-    for (int i = 0; i < g_enum_count; i++) {
-        if (g_enums[i].name && strcmp(g_enums[i].name, enum_name) == 0) {
-            /* Already registered, skip */
+    if (g_enum_count >= g_enum_capacity) {
+        int new_capacity = g_enum_capacity == 0 ? 16 : g_enum_capacity * 2;
+        EnumInfo *new_enums = realloc(g_enums, (size_t)new_capacity * sizeof(EnumInfo));
+        if (!new_enums) {
             return;
         }
+        g_enums = new_enums;
+        g_enum_capacity = new_capacity;
     }
 
     EnumInfo *info = &g_enums[g_enum_count];
-    info->name = strdup(enum_name);
-    if (!info->name) {
-        /* Memory allocation failed, cannot register enum */
+    info->name = interned_name;
+    info->member_count = member_count;
+    info->members = malloc((size_t)member_count * sizeof(EnumMember));
+    if (!info->members) {
         return;
     }
-    info->member_count = member_count;
 
-    for (int i = 0; i < member_count && i < MAX_ENUM_MEMBERS; i++) {
-        info->members[i].name = strdup(members[i].name);
+    info->dense = members_are_dense(members, member_count, &info->min_value);
+    for (int i = 0; i < member_count; i++) {
+        info->members[i].value = members[i].value;
+        info->members[i].has_value = members[i].has_value;
+        info->members[i].name = cz_intern_name(members[i].name);
         info->members[i].original_name = members[i].original_name ?
-                                          strdup(members[i].original_name) : NULL;
+                                          cz_intern_name(members[i].original_name) : NULL;
         if (!info->members[i].name) {
-            /* Memory allocation failed, clean up and return */
-            for (int j = 0; j < i; j++) {
-                free(info->members[j].name);
-                free(info->members[j].original_name);
-            }
-            free(info->name);
+            /* Memory allocation failed, cannot register enum */
+            free(info->members);
             return;
         }
     }
 
+    if (!hash_table_put(&g_enum_index, hash_key_pointer(interned_name), (size_t)g_enum_count)) {
+        free(info->members);
+        return;
+    }
+    for (int i = 0; i < member_count; i++) {
+        uint64_t key = hash_key_pointer(info->members[i].original_name);
+        if (key != 0 && hash_table_get(&g_member_index, key) == HASH_TABLE_MISSING) {
+            hash_table_put(&g_member_index, key, (size_t)hash_key_pair(g_enum_count, i));
+        }
+        uint64_t scoped = hash_key_pair(g_enum_count, cz_intern(info->members[i].original_name ?
+                                                                info->members[i].original_name :
+                                                                info->members[i].name));
+        if (hash_table_get(&g_enum_member_index, scoped) == HASH_TABLE_MISSING) {
+            hash_table_put(&g_enum_member_index, scoped, (size_t)i);
+        }
+    }
     g_enum_count++;
 }
 
 /* Find enum by name */
 static EnumInfo *find_enum(const char *enum_name) {
-    if (!enum_name) {
+    if (!enum_name || g_enum_count == 0) {
         return NULL;
     }
 
-    for (int i = 0; i < g_enum_count; i++) {
-        if (g_enums[i].name && strcmp(g_enums[i].name, enum_name) == 0) {
-            return &g_enums[i];
+    size_t index = hash_table_get(&g_enum_index, hash_key_pointer(cz_intern_name(enum_name)));
+    return index == HASH_TABLE_MISSING ? NULL : &g_enums[index];
+}
+
+/* Find the enum whose declaration holds a member named identifier (interned), or NULL */
+static EnumInfo *find_enum_of_member(const char *identifier, int *member_index) {
+    size_t packed = hash_table_get(&g_member_index, hash_key_pointer(identifier));
+    if (packed == HASH_TABLE_MISSING) {
+        return NULL;
+    }
+    *member_index = (int)(uint32_t)packed;
+    return &g_enums[(uint64_t)packed >> 32];
+}
+
+/* Find the index of the member of enum_info whose original name is the token's text, or -1 */
+static int find_member(const EnumInfo *enum_info, const Token *token) {
+    uint64_t key = hash_key_pair((int)(enum_info - g_enums), cz_token_symbol(token));
+    size_t index = hash_table_get(&g_enum_member_index, key);
+    return index == HASH_TABLE_MISSING ? -1 : (int)index;
+}
+
+/* Find the enum declaring a member named as the token once prefixed (interned), or NULL */
+static EnumInfo *find_enum_of_prefixed_member(const Token *token, int *member_index) {
+    const char *name = cz_symbol_name(cz_token_symbol(token));
+    for (int e = 0; name && e < g_enum_count; e++) {
+        for (int m = 0; m < g_enums[e].member_count; m++) {
+            if (g_enums[e].members[m].name == name) {
+                *member_index = m;
+                return &g_enums[e];
+            }
         }
     }
     return NULL;
 }
 
+/* Parse the value of an enum member in [start, end): an integer literal with an optional sign */
+static int parse_member_value(ASTNode_t **children, size_t start, size_t end, long long *value) {
+    int negative = 0;
+    size_t i = ast_skip_trivia(children, end, start);
+    if (i < end && children[i]->token.type == TOKEN_OPERATOR &&
+        (token_text_equals(&children[i]->token, "-") || token_text_equals(&children[i]->token, "+"))) {
+        negative = children[i]->token.text[0] == '-';
+        i = ast_skip_trivia(children, end, i + 1);
+    }
+    if (i >= end || children[i]->token.type != TOKEN_NUMBER ||
+        ast_skip_trivia(children, end, i + 1) < end) {
+        return 0;
+    }
+
+    char *suffix = NULL;
+    long long parsed = strtoll(children[i]->token.text, &suffix, 0);
+    if (suffix == children[i]->token.text || suffix[strspn(suffix, "uUlL")] != '\0') {
+        return 0;
+    }
+    *value = negative ? -parsed : parsed;
+    return 1;
+}
+
 /* Parse enum declaration and register it */
 static void parse_enum_declaration(ASTNode_t **children, size_t count, size_t enum_pos) {
-    size_t i = skip_whitespace(children, count, enum_pos + 1);
+    size_t i = ast_skip_trivia(children, count, enum_pos + 1);
 
     /* Get enum name (optional) */
     char *enum_name = NULL;
     if (i < count && children[i]->type == AST_TOKEN &&
         children[i]->token.type == TOKEN_IDENTIFIER) {
         enum_name = children[i]->token.text;
-        i = skip_whitespace(children, count, i + 1);
+        i = ast_skip_trivia(children, count, i + 1);
     }
 
     /* Find opening brace */
@@ -225,13 +369,16 @@ static void parse_enum_declaration(ASTNode_t **children, size_t count, size_t en
         return; /* Not an enum definition */
     }
 
-    i = skip_whitespace(children, count, i + 1);
+    i = ast_skip_trivia(children, count, i + 1);
 
     /* Parse enum members */
-    EnumMember members[MAX_ENUM_MEMBERS];
+    EnumMember *members = NULL;
     int member_count = 0;
+    int member_capacity = 0;
+    long long next_value = 0;
+    int next_known = 1;
 
-    while (i < count && member_count < MAX_ENUM_MEMBERS) {
+    while (i < count) {
         /* Check for closing brace */
         if (children[i]->type == AST_TOKEN &&
             children[i]->token.type == TOKEN_PUNCTUATION &&
@@ -254,31 +401,43 @@ static void parse_enum_declaration(ASTNode_t **children, size_t count, size_t en
                          original_name, enum_name,
                          uppercase_suggestion ? uppercase_suggestion : "UPPERCASE_VERSION");
                 free(uppercase_suggestion);
-                cz_error(g_filename, g_source, member_token->line, error_msg);
+                cz_error_at(g_filename, g_source, member_token->line, member_token->column, error_msg);
+            }
+
+            if (member_count >= member_capacity) {
+                int new_capacity = member_capacity == 0 ? 16 : member_capacity * 2;
+                EnumMember *new_members = realloc(members, (size_t)new_capacity * sizeof(EnumMember));
+                if (!new_members) {
+                    break;
+                }
+                members = new_members;
+                member_capacity = new_capacity;
             }
 
             /* Store original name and generate prefixed name */
-            members[member_count].original_name = (char *)original_name;
+            members[member_count].original_name = original_name;
+            members[member_count].name = original_name;
             if (enum_name) {
-                members[member_count].name = generate_prefixed_name(enum_name, original_name);
-                if (!members[member_count].name) {
-                    /* Memory allocation failed, use original */
-                    members[member_count].name = (char *)original_name;
+                char *prefixed_name = generate_prefixed_name(enum_name, original_name);
+                if (prefixed_name) {
+                    /* Registered (interned) below, the temporary is freed after */
+                    members[member_count].name = prefixed_name;
                 }
-            } else {
-                members[member_count].name = (char *)original_name;
             }
+            members[member_count].value = next_value;
+            members[member_count].has_value = next_known;
             member_count++;
 
-            i = skip_whitespace(children, count, i + 1);
+            i = ast_skip_trivia(children, count, i + 1);
 
             /* Skip optional = value */
             if (i < count && children[i]->type == AST_TOKEN &&
                 children[i]->token.type == TOKEN_OPERATOR &&
                 token_text_equals(&children[i]->token, "=")) {
-                i = skip_whitespace(children, count, i + 1);
+                i = ast_skip_trivia(children, count, i + 1);
 
                 /* Skip value (number or expression) */
+                size_t value_start = i;
                 while (i < count && children[i]->type == AST_TOKEN) {
                     Token *tok = &children[i]->token;
                     if (tok->type == TOKEN_PUNCTUATION &&
@@ -287,14 +446,18 @@ static void parse_enum_declaration(ASTNode_t **children, size_t count, size_t en
                     }
                     i++;
                 }
-                i = skip_whitespace(children, count, i);
+                EnumMember *member = &members[member_count - 1];
+                member->has_value = parse_member_value(children, value_start, i, &member->value);
+                i = ast_skip_trivia(children, count, i);
             }
+            next_value = members[member_count - 1].value + 1;
+            next_known = members[member_count - 1].has_value;
 
             /* Skip comma */
             if (i < count && children[i]->type == AST_TOKEN &&
                 children[i]->token.type == TOKEN_PUNCTUATION &&
                 token_text_equals(&children[i]->token, ",")) {
-                i = skip_whitespace(children, count, i + 1);
+                i = ast_skip_trivia(children, count, i + 1);
             }
         } else {
             i++;
@@ -309,84 +472,94 @@ static void parse_enum_declaration(ASTNode_t **children, size_t count, size_t en
     /* Clean up dynamically allocated prefixed names */
     for (int j = 0; j < member_count; j++) {
         if (members[j].name != members[j].original_name) {
-            free(members[j].name);
+            free((char *)members[j].name);
         }
     }
+    free(members);
 }
 
-/* Check if a variable is of enum type */
-static EnumInfo *get_variable_enum_type(ASTNode_t **children, size_t count, const char *var_name) {
-    /* Search forward through AST for variable declaration
-     * Note: This implementation has limitations - it may not detect:
-     * - typedef'd enum types
-     * - enum variables passed as function parameters
-     * - enum members of structs/unions
-     */
+/* Index every "enum EnumName var" declaration, so switches look their variable up once.
+ * Note: This implementation has limitations - it may not detect:
+ * - typedef'd enum types
+ * - enum variables passed as function parameters
+ * - enum members of structs/unions
+ */
+static void index_enum_variables(ASTNode_t **children, size_t count) {
     for (size_t i = 0; i < count; i++) {
         if (children[i]->type != AST_TOKEN) continue;
         Token *tok = &children[i]->token;
 
         /* Look for "enum EnumName var_name" pattern */
-        if ((tok->type == TOKEN_KEYWORD || tok->type == TOKEN_IDENTIFIER) &&
-            strcmp(tok->text, "enum") == 0) {
-
-            size_t j = skip_whitespace(children, count, i + 1);
+        if (tok->symbol != SYM_ENUM) {
+            continue;
+        }
 
-            /* Get enum type name */
-            if (j < count && children[j]->type == AST_TOKEN &&
-                children[j]->token.type == TOKEN_IDENTIFIER) {
-                char *enum_type = children[j]->token.text;
+        size_t j = ast_skip_trivia(children, count, i + 1);
 
-                j = skip_whitespace(children, count, j + 1);
+        /* Get enum type name */
+        if (j >= count || children[j]->type != AST_TOKEN ||
+            children[j]->token.type != TOKEN_IDENTIFIER) {
+            continue;
+        }
+        EnumInfo *enum_info = find_enum(children[j]->token.text);
+        size_t value = enum_info ? (size_t)(enum_info - g_enums) : VARIABLE_NOT_ENUM;
 
-                /* Check if this declaration is for our variable */
-                while (j < count) {
-                    if (children[j]->type != AST_TOKEN) {
-                        j++;
-                        continue;
-                    }
+        j = ast_skip_trivia(children, count, j + 1);
 
-                    Token *vtok = &children[j]->token;
+        /* Every variable of the declaration, the first declaration of a name wins */
+        while (j < count) {
+            if (children[j]->type != AST_TOKEN) {
+                j++;
+                continue;
+            }
 
-                    /* Skip pointer markers */
-                    if (vtok->type == TOKEN_OPERATOR && token_text_equals(vtok, "*")) {
-                        j = skip_whitespace(children, count, j + 1);
-                        continue;
-                    }
+            Token *vtok = &children[j]->token;
 
-                    /* Check if this is our variable */
-                    if (vtok->type == TOKEN_IDENTIFIER && strcmp(vtok->text, var_name) == 0) {
-                        /* Found it! Return the enum info */
-                        return find_enum(enum_type);
-                    }
+            /* Skip pointer markers */
+            if (vtok->type == TOKEN_OPERATOR && token_text_equals(vtok, "*")) {
+                j = ast_skip_trivia(children, count, j + 1);
+                continue;
+            }
 
-                    /* If we hit a semicolon or comma, check next variable */
-                    if (vtok->type == TOKEN_PUNCTUATION) {
-                        if (token_text_equals(vtok, ";")) {
-                            break; /* End of declaration */
-                        } else if (token_text_equals(vtok, ",")) {
-                            j = skip_whitespace(children, count, j + 1);
-                            continue; /* Next variable in declaration */
-                        } else if (token_text_equals(vtok, "=") || token_text_equals(vtok, "(") ||
-                                   token_text_equals(vtok, "[")) {
-                            /* Skip initialization or function params */
-                            break;
-                        }
-                    }
+            if (vtok->type == TOKEN_IDENTIFIER) {
+                uint64_t key = hash_key_pointer(cz_symbol_name(cz_token_symbol(vtok)));
+                if (key != 0 && hash_table_get(&g_variable_index, key) == HASH_TABLE_MISSING) {
+                    hash_table_put(&g_variable_index, key, value);
+                }
+            }
 
-                    j++;
+            /* If we hit a semicolon or comma, check next variable */
+            if (vtok->type == TOKEN_PUNCTUATION) {
+                if (token_text_equals(vtok, ";")) {
+                    break; /* End of declaration */
+                } else if (token_text_equals(vtok, ",")) {
+                    j = ast_skip_trivia(children, count, j + 1);
+                    continue; /* Next variable in declaration */
+                } else if (token_text_equals(vtok, "=") || token_text_equals(vtok, "(") ||
+                           token_text_equals(vtok, "[")) {
+                    /* Skip initialization or function params */
+                    break;
                 }
             }
+
+            j++;
         }
     }
+}
 
-    return NULL;
+/* Check if a variable is of enum type */
+static EnumInfo *get_variable_enum_type(const Token *var) {
+    size_t index = hash_table_get(&g_variable_index, hash_key_pointer(cz_symbol_name(cz_token_symbol(var))));
+    return index == HASH_TABLE_MISSING || index == VARIABLE_NOT_ENUM ? NULL : &g_enums[index];
 }
 
 /* Validate switch statement for exhaustiveness and default case */
-static void validate_switch_exhaustiveness(ASTNode_t **children, size_t count, size_t switch_pos) {
+static void validate_switch_exhaustiveness(ASTNode_t *ast, size_t switch_pos) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+
     /* Find the switch expression */
-    size_t i = skip_whitespace(children, count, switch_pos + 1);
+    size_t i = ast_skip_trivia(children, count, switch_pos + 1);
 
     if (i >= count || children[i]->type != AST_TOKEN ||
         children[i]->token.type != TOKEN_PUNCTUATION ||
@@ -394,38 +567,25 @@ static void validate_switch_exhaustiveness(ASTNode_t **children, size_t count, s
         return;
     }
 
-    i = skip_whitespace(children, count, i + 1);
+    size_t open_paren = i;
+    i = ast_skip_trivia(children, count, i + 1);
 
     /* Get the switched variable/expression */
-    char *switch_var = NULL;
-    if (i < count && children[i]->type == AST_TOKEN &&
-        children[i]->token.type == TOKEN_IDENTIFIER) {
-        switch_var = children[i]->token.text;
-    }
-
-    if (!switch_var) {
+    if (i >= count || children[i]->type != AST_TOKEN ||
+        children[i]->token.type != TOKEN_IDENTIFIER) {
         return; /* Can't determine what we're switching on */
     }
 
     /* Check if the variable is of enum type */
-    EnumInfo *enum_info = get_variable_enum_type(children, count, switch_var);
+    EnumInfo *enum_info = get_variable_enum_type(&children[i]->token);
 
     /* Find closing paren */
-    int paren_depth = 1;
-    i++;
-    while (i < count && paren_depth > 0) {
-        if (children[i]->type == AST_TOKEN &&
-            children[i]->token.type == TOKEN_PUNCTUATION) {
-            if (token_text_equals(&children[i]->token, "(")) {
-                paren_depth++;
-            } else if (token_text_equals(&children[i]->token, ")")) {
-                paren_depth--;
-            }
-        }
-        i++;
+    size_t close_paren = ast_match(ast, open_paren);
+    if (close_paren == AST_NO_MATCH) {
+        return;
     }
 
-    i = skip_whitespace(children, count, i);
+    i = ast_skip_trivia(children, count, close_paren + 1);
 
     /* Find opening brace of switch body */
     if (i >= count || children[i]->type != AST_TOKEN ||
@@ -437,26 +597,21 @@ static void validate_switch_exhaustiveness(ASTNode_t **children, size_t count, s
     size_t switch_body_start = i;
 
     /* Find closing brace of switch body */
-    int brace_depth = 1;
-    i++;
-    size_t switch_body_end = i;
-    while (i < count && brace_depth > 0) {
-        if (children[i]->type == AST_TOKEN &&
-            children[i]->token.type == TOKEN_PUNCTUATION) {
-            if (token_text_equals(&children[i]->token, "{")) {
-                brace_depth++;
-            } else if (token_text_equals(&children[i]->token, "}")) {
-                brace_depth--;
-                if (brace_depth == 0) {
-                    switch_body_end = i;
-                }
-            }
-        }
-        i++;
+    size_t switch_body_end = ast_match(ast, switch_body_start);
+    if (switch_body_end == AST_NO_MATCH) {
+        return;
     }
 
-    /* Track which enum members are covered and if default exists */
-    int covered[MAX_ENUM_MEMBERS] = {0};
+    /* Track which enum members are covered (one bit each) and if default exists */
+    uint64_t covered_inline[4] = {0};
+    uint64_t *covered = covered_inline;
+    size_t covered_words = enum_info ? ((size_t)enum_info->member_count + 63) / 64 : 0;
+    if (covered_words > sizeof(covered_inline) / sizeof(covered_inline[0])) {
+        covered = calloc(covered_words, sizeof(uint64_t));
+        if (!covered) {
+            return;
+        }
+    }
     int has_default = 0;
 
     /* Scan switch body for case labels and default */
@@ -473,51 +628,45 @@ static void validate_switch_exhaustiveness(ASTNode_t **children, size_t count, s
         if ((tok->type == TOKEN_KEYWORD || tok->type == TOKEN_IDENTIFIER) &&
             strcmp(tok->text, "case") == 0) {
 
-            size_t j = skip_whitespace(children, count, i + 1);
+            size_t j = ast_skip_trivia(children, count, i + 1);
 
             /* Get case label - could be EnumName.MEMBER or just MEMBER */
             if (j < count && children[j]->type == AST_TOKEN &&
                 children[j]->token.type == TOKEN_IDENTIFIER) {
 
-                char *case_label = children[j]->token.text;
+                Token *case_label = &children[j]->token;
                 int is_scoped = 0;
 
                 /* Check for enum prefix (EnumName.MEMBER syntax) */
                 size_t label_start_pos = j;
-                j = skip_whitespace(children, count, j + 1);
+                j = ast_skip_trivia(children, count, j + 1);
                 if (j < count && children[j]->type == AST_TOKEN &&
                     children[j]->token.type == TOKEN_OPERATOR &&
                     token_text_equals(&children[j]->token, ".")) {
 
-                    j = skip_whitespace(children, count, j + 1);
+                    j = ast_skip_trivia(children, count, j + 1);
                     if (j < count && children[j]->type == AST_TOKEN &&
                         children[j]->token.type == TOKEN_IDENTIFIER) {
-                        case_label = children[j]->token.text;
+                        case_label = &children[j]->token;
                         is_scoped = 1;
                     }
                 }
 
                 /* If this is an enum switch, mark member as covered and warn if unscoped */
-                if (enum_info) {
-                    for (int k = 0; k < enum_info->member_count; k++) {
-                        /* Compare against original name since validation happens before transformation */
-                        const char *member_name_to_check = enum_info->members[k].original_name ?
-                                                            enum_info->members[k].original_name :
-                                                            enum_info->members[k].name;
-                        if (strcmp(member_name_to_check, case_label) == 0) {
-                            covered[k] = 1;
-
-                            /* Warn if using unscoped enum constant */
-                            if (!is_scoped) {
-                                char warning_msg[512];
-                                snprintf(warning_msg, sizeof(warning_msg),
-                                         WARN_UNSCOPED_ENUM_CONSTANT,
-                                         case_label, enum_info->name, case_label);
-                                cz_warning(g_filename, g_source,
-                                          children[label_start_pos]->token.line, warning_msg);
-                            }
-                            break;
-                        }
+                /* Members are matched by original name since validation happens before transformation */
+                int k = enum_info ? find_member(enum_info, case_label) : -1;
+                if (k >= 0) {
+                    covered[k / 64] |= (uint64_t)1 << (k % 64);
+
+                    /* Warn if using unscoped enum constant */
+                    if (!is_scoped) {
+                        char warning_msg[512];
+                        snprintf(warning_msg, sizeof(warning_msg),
+                                 WARN_UNSCOPED_ENUM_CONSTANT,
+                                 case_label->text, enum_info->name, case_label->text);
+                        cz_warning_at(g_filename, g_source,
+                                      children[label_start_pos]->token.line,
+                                      children[label_start_pos]->token.column, warning_msg);
                     }
                 }
             }
@@ -532,20 +681,20 @@ static void validate_switch_exhaustiveness(ASTNode_t **children, size_t count, s
             snprintf(error_msg, sizeof(error_msg),
                      ERR_ENUM_SWITCH_MISSING_DEFAULT,
                      enum_info->name);
-            cz_error(g_filename, g_source, children[switch_pos]->token.line, error_msg);
+            cz_error_at(g_filename, g_source, children[switch_pos]->token.line, children[switch_pos]->token.column, error_msg);
         } else {
             /* WARNING: non-enum switch should have default case */
             char warning_msg[512];
             snprintf(warning_msg, sizeof(warning_msg),
                      WARN_SWITCH_MISSING_DEFAULT);
-            cz_warning(g_filename, g_source, children[switch_pos]->token.line, warning_msg);
+            cz_warning_at(g_filename, g_source, children[switch_pos]->token.line, children[switch_pos]->token.column, warning_msg);
         }
     }
 
     /* For enum switches with default, check if all members are covered */
     if (enum_info && has_default) {
         for (int k = 0; k < enum_info->member_count; k++) {
-            if (!covered[k]) {
+            if (!(covered[k / 64] & ((uint64_t)1 << (k % 64)))) {
                 /* Missing case! Use original name for error message */
                 const char *member_name = enum_info->members[k].original_name ?
                                           enum_info->members[k].original_name :
@@ -554,10 +703,13 @@ static void validate_switch_exhaustiveness(ASTNode_t **children, size_t count, s
                 snprintf(error_msg, sizeof(error_msg),
                          ERR_ENUM_SWITCH_NOT_EXHAUSTIVE,
                          enum_info->name, member_name);
-                cz_error(g_filename, g_source, children[switch_pos]->token.line, error_msg);
+                cz_error_at(g_filename, g_source, children[switch_pos]->token.line, children[switch_pos]->token.column, error_msg);
             }
         }
     }
+    if (covered != covered_inline) {
+        free(covered);
+    }
 }
 
 /* Scan AST for enum declarations */
@@ -575,8 +727,7 @@ static void scan_enum_declarations(ASTNode_t *ast) {
         Token *token = &children[i]->token;
 
         /* Look for "enum" keyword */
-        if ((token->type == TOKEN_KEYWORD || token->type == TOKEN_IDENTIFIER) &&
-            strcmp(token->text, "enum") == 0) {
+        if (token->symbol == SYM_ENUM) {
             parse_enum_declaration(children, count, i);
         }
     }
@@ -600,7 +751,7 @@ static void scan_switch_statements(ASTNode_t *ast) {
         if ((token->type == TOKEN_KEYWORD || token->type == TOKEN_IDENTIFIER) &&
             strcmp(token->text, "switch") == 0) {
             /* Only validate enum-specific exhaustiveness */
-            validate_switch_exhaustiveness(children, count, i);
+            validate_switch_exhaustiveness(ast, i);
         }
     }
 }
@@ -611,14 +762,8 @@ void transpiler_validate_enums(ASTNode_t *ast, const char *filename, const char
         return;
     }
 
-    /* Reset global state */
-    for (int i = 0; i < g_enum_count; i++) {
-        free(g_enums[i].name);
-        for (int j = 0; j < g_enums[i].member_count; j++) {
-            free(g_enums[i].members[j].name);
-        }
-    }
-    g_enum_count = 0;
+    /* Reset global state (names stay in the interner) */
+    clear_enums();
 
     /* Set global context for error reporting */
     g_filename = filename;
@@ -626,6 +771,7 @@ void transpiler_validate_enums(ASTNode_t *ast, const char *filename, const char
 
     /* First pass: scan for enum declarations */
     scan_enum_declarations(ast);
+    index_enum_variables(ast->children, ast->child_count);
 
     /* Validate switch case control flow (generic switch validation) */
     transpiler_validate_switch_case_control_flow(ast, filename, source);
@@ -660,42 +806,23 @@ static void strip_enum_prefixes(ASTNode_t *ast) {
         }
 
         /* Check if this is EnumName followed by . and MEMBER */
-        size_t j = skip_whitespace(children, count, i + 1);
+        size_t j = ast_skip_trivia(children, count, i + 1);
         if (j < count && children[j]->type == AST_TOKEN &&
             children[j]->token.type == TOKEN_OPERATOR &&
             token_text_equals(&children[j]->token, ".")) {
 
-            size_t k = skip_whitespace(children, count, j + 1);
+            size_t k = ast_skip_trivia(children, count, j + 1);
             if (k < count && children[k]->type == AST_TOKEN &&
                 children[k]->token.type == TOKEN_IDENTIFIER) {
 
-                const char *member_name = children[k]->token.text;
-
                 /* Verify this is actually an enum member */
-                int is_member = 0;
-                for (int m = 0; m < enum_info->member_count; m++) {
-                    if (enum_info->members[m].original_name &&
-                        strcmp(enum_info->members[m].original_name, member_name) == 0) {
-                        is_member = 1;
-                        break;
-                    }
-                }
-
-                if (is_member) {
+                if (find_member(enum_info, &children[k]->token) >= 0) {
                     /* This is EnumName.MEMBER pattern - remove EnumName and dot */
                     /* Replace EnumName with empty string */
-                    free(children[i]->token.text);
-                    children[i]->token.text = strdup("");
-                    if (children[i]->token.text) {
-                        children[i]->token.length = 0;
-                    }
+                    token_set_text(&children[i]->token, "");
 
                     /* Replace . with empty string */
-                    free(children[j]->token.text);
-                    children[j]->token.text = strdup("");
-                    if (children[j]->token.text) {
-                        children[j]->token.length = 0;
-                    }
+                    token_set_text(&children[j]->token, "");
                 }
             }
         }
@@ -721,11 +848,10 @@ static void prefix_enum_members(ASTNode_t *ast) {
         Token *token = &children[i]->token;
 
         /* Look for enum keyword */
-        if ((token->type == TOKEN_KEYWORD || token->type == TOKEN_IDENTIFIER) &&
-            token_text_equals(token, "enum")) {
+        if (token->symbol == SYM_ENUM) {
 
             /* Skip to get enum name */
-            size_t j = skip_whitespace(children, count, i + 1);
+            size_t j = ast_skip_trivia(children, count, i + 1);
             if (j >= count || children[j]->type != AST_TOKEN ||
                 children[j]->token.type != TOKEN_IDENTIFIER) {
                 continue;
@@ -738,13 +864,13 @@ static void prefix_enum_members(ASTNode_t *ast) {
             }
 
             /* Find opening brace */
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
             if (j >= count || children[j]->type != AST_TOKEN ||
                 children[j]->token.type != TOKEN_PUNCTUATION ||
                 !token_text_equals(&children[j]->token, "{")) {
                 continue;
             }
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
 
             /* Replace member names with prefixed versions */
             int member_idx = 0;
@@ -762,12 +888,11 @@ static void prefix_enum_members(ASTNode_t *ast) {
 
                     /* Check if this matches the original member name */
                     if (enum_info->members[member_idx].original_name &&
-                        strcmp(children[j]->token.text, enum_info->members[member_idx].original_name) == 0) {
+                        enum_info->members[member_idx].original_name ==
+                            cz_symbol_name(cz_token_symbol(&children[j]->token))) {
 
                         /* Replace with prefixed name */
-                        free(children[j]->token.text);
-                        children[j]->token.text = strdup(enum_info->members[member_idx].name);
-                        children[j]->token.length = strlen(enum_info->members[member_idx].name);
+                        token_set_text(&children[j]->token, enum_info->members[member_idx].name);
                         member_idx++;
                     }
                 }
@@ -777,72 +902,394 @@ static void prefix_enum_members(ASTNode_t *ast) {
     }
 
     /* Second pass: Update all references to enum members */
-    for (size_t i = 0; i < count; i++) {
+    for (size_t i = 0; g_enum_count > 0 && i < count; i++) {
         if (children[i]->type != AST_TOKEN ||
             children[i]->token.type != TOKEN_IDENTIFIER) {
             continue;
         }
 
-        const char *identifier = children[i]->token.text;
+        const char *identifier = cz_symbol_name(cz_token_symbol(&children[i]->token));
 
         /* Check all registered enums to see if this is a member */
-        for (int e = 0; e < g_enum_count; e++) {
-            EnumInfo *enum_info = &g_enums[e];
-            for (int m = 0; m < enum_info->member_count; m++) {
-                if (enum_info->members[m].original_name &&
-                    strcmp(identifier, enum_info->members[m].original_name) == 0) {
-
-                    /* Check if this is not already in the enum declaration
-                     * (we don't want to replace it twice) */
-                    int in_enum_decl = 0;
-
-                    /* Look backwards for enum keyword */
-                    for (size_t k = i; k > 0 && k > i - 20; k--) {
-                        if (children[k]->type == AST_TOKEN &&
-                            (children[k]->token.type == TOKEN_KEYWORD ||
-                             children[k]->token.type == TOKEN_IDENTIFIER) &&
-                            token_text_equals(&children[k]->token, "enum")) {
-
-                            /* Check if this enum matches */
-                            size_t name_idx = skip_whitespace(children, count, k + 1);
-                            if (name_idx < count && children[name_idx]->type == AST_TOKEN &&
-                                strcmp(children[name_idx]->token.text, enum_info->name) == 0) {
-                                /* Look for opening brace */
-                                size_t brace_idx = skip_whitespace(children, count, name_idx + 1);
-                                if (brace_idx < count && children[brace_idx]->type == AST_TOKEN &&
-                                    token_text_equals(&children[brace_idx]->token, "{")) {
-                                    /* Find closing brace */
-                                    size_t close_idx = brace_idx + 1;
-                                    int depth = 1;
-                                    while (close_idx < count && depth > 0) {
-                                        if (children[close_idx]->type == AST_TOKEN &&
-                                            children[close_idx]->token.type == TOKEN_PUNCTUATION) {
-                                            if (token_text_equals(&children[close_idx]->token, "{")) depth++;
-                                            else if (token_text_equals(&children[close_idx]->token, "}")) depth--;
-                                        }
-                                        close_idx++;
-                                    }
-                                    /* Check if current position is within enum declaration */
-                                    if (i > brace_idx && i < close_idx) {
-                                        in_enum_decl = 1;
-                                    }
-                                }
-                            }
-                            break;
+        int m = 0;
+        EnumInfo *enum_info = identifier ? find_enum_of_member(identifier, &m) : NULL;
+        if (!enum_info) {
+            continue;
+        }
+
+        /* Check if this is not already in the enum declaration
+         * (we don't want to replace it twice) */
+        int in_enum_decl = 0;
+
+        /* Look backwards for enum keyword */
+        for (size_t k = i; k > 0 && k > i - 20; k--) {
+            if (children[k]->type == AST_TOKEN &&
+                children[k]->token.symbol == SYM_ENUM) {
+
+                /* Check if this enum matches */
+                size_t name_idx = ast_skip_trivia(children, count, k + 1);
+                if (name_idx < count && children[name_idx]->type == AST_TOKEN &&
+                    strcmp(children[name_idx]->token.text, enum_info->name) == 0) {
+                    /* Look for opening brace */
+                    size_t brace_idx = ast_skip_trivia(children, count, name_idx + 1);
+                    if (brace_idx < count && children[brace_idx]->type == AST_TOKEN &&
+                        token_text_equals(&children[brace_idx]->token, "{")) {
+                        /* Find closing brace */
+                        size_t close_idx = ast_match(ast, brace_idx);
+                        /* Check if current position is within enum declaration */
+                        if (i > brace_idx && (close_idx == AST_NO_MATCH || i <= close_idx)) {
+                            in_enum_decl = 1;
                         }
                     }
+                }
+                break;
+            }
+        }
 
-                    if (!in_enum_decl) {
-                        /* Replace with prefixed name */
-                        free(children[i]->token.text);
-                        children[i]->token.text = strdup(enum_info->members[m].name);
-                        children[i]->token.length = strlen(enum_info->members[m].name);
+        if (!in_enum_decl) {
+            /* Replace with prefixed name */
+            token_set_text(&children[i]->token, enum_info->members[m].name);
+        }
+    }
+}
+
+/* Skip trivia and tokens emptied by earlier rewrites (such as stripped EnumName. prefixes) */
+static size_t skip_blank(ASTNode_t **children, size_t count, size_t i) {
+    while ((i = ast_skip_trivia(children, count, i)) < count && children[i]->token.text[0] == '\0') {
+        i++;
+    }
+    return i;
+}
+
+/* Check if the statement starting at index follows "#pragma czar <directive>" */
+static int follows_pragma(ASTNode_t **children, size_t index, const char *directive) {
+    size_t p = ast_prev_significant(children, index);
+    while (p != AST_NO_MATCH && (children[p]->token.symbol == SYM_TYPEDEF ||
+                                 token_text_equals(&children[p]->token, "export"))) {
+        p = ast_prev_significant(children, p);
+    }
+    return p != AST_NO_MATCH && pragma_czar_is(&children[p]->token, directive);
+}
+
+/* Append the helpers of a dense enum: Name_count, Name_names[], Name_is_valid() and Name_name() */
+static void append_enum_names(OutputSink_t *out, const EnumInfo *info) {
+    const char *name = info->name;
+    long long min = info->min_value;
+    long long max = min + info->member_count - 1;
+
+    sink_printf(out, " enum { %s_count = %d }; static const char *const %s_names[%s_count] = {",
+                name, info->member_count, name, name);
+    for (long long value = min; value <= max; value++) {
+        for (int m = 0; m < info->member_count; m++) {
+            if (info->members[m].value == value) {
+                sink_printf(out, "%s \"%s\"", value == min ? "" : ",",
+                            info->members[m].original_name ? info->members[m].original_name :
+                                                             info->members[m].name);
+            }
+        }
+    }
+    sink_printf(out, " }; static inline bool %s_is_valid(long long value) "
+                     "{ return value >= %lld && value <= %lld; }", name, min, max);
+    sink_printf(out, " static inline const char *%s_name(enum %s value) "
+                     "{ return %s_is_valid(value) ? %s_names[value", name, name, name, name);
+    if (min != 0) {
+        sink_printf(out, " - (%lld)", min);
+    }
+    sink_puts(out, "] : \"\"; }");
+}
+
+/* Generate the helpers of enums declared after "#pragma czar names" at the end of their declaration,
+ * so they follow the enum into the header or the source without moving lines */
+static void generate_enum_names(ASTNode_t *ast) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+
+    for (size_t i = 0; i < count; i++) {
+        if (children[i]->type != AST_TOKEN || children[i]->token.symbol != SYM_ENUM ||
+            scope_map_at(ast, i)->depth != 0 || !follows_pragma(children, i, "names")) {
+            continue;
+        }
+
+        size_t j = ast_skip_trivia(children, count, i + 1);
+        EnumInfo *info = j < count && children[j]->token.type == TOKEN_IDENTIFIER ?
+                         find_enum(children[j]->token.text) : NULL;
+        j = ast_skip_trivia(children, count, j + 1);
+        if (!info || j >= count || !token_text_equals(&children[j]->token, "{")) {
+            continue;
+        }
+
+        size_t close = ast_match(ast, j);
+        size_t end = close;
+        while (end < count && !token_text_equals(&children[end]->token, ";")) {
+            end++;
+        }
+        if (close == AST_NO_MATCH || end >= count) {
+            continue;
+        }
+
+        if (!info->dense) {
+            char warning_msg[512];
+            snprintf(warning_msg, sizeof(warning_msg), WARN_ENUM_NAMES_NOT_DENSE, info->name);
+            cz_warning_at(g_filename, g_source, children[i]->token.line, children[i]->token.column, warning_msg);
+            continue;
+        }
+
+        OutputSink_t sink;
+        sink_init(&sink, NULL);
+        sink_puts(&sink, children[end]->token.text);
+        append_enum_names(&sink, info);
+        char *text = sink_take(&sink);
+        if (text) {
+            token_take_text(&children[end]->token, text);
+        }
+        i = end;
+    }
+}
+
+/* Match "return CONSTANT;" at index (a number, character, string, enum member, true, false or NULL,
+ * numbers may be signed), returns the position of ';' or AST_NO_MATCH */
+static size_t match_constant_return(ASTNode_t **children, size_t count, size_t index) {
+    if (index >= count || children[index]->token.symbol != SYM_RETURN) {
+        return AST_NO_MATCH;
+    }
+
+    size_t i = skip_blank(children, count, index + 1);
+    if (i < count && (token_text_equals(&children[i]->token, "-") || token_text_equals(&children[i]->token, "+"))) {
+        i = skip_blank(children, count, i + 1);
+        if (i >= count || children[i]->token.type != TOKEN_NUMBER) {
+            return AST_NO_MATCH;
+        }
+    }
+    if (i >= count) {
+        return AST_NO_MATCH;
+    }
+
+    Token *value = &children[i]->token;
+    int member = 0;
+    int constant = value->type == TOKEN_NUMBER || value->type == TOKEN_CHAR || value->type == TOKEN_STRING ||
+                   (value->type == TOKEN_IDENTIFIER &&
+                    (token_text_equals(value, "true") || token_text_equals(value, "false") ||
+                     token_text_equals(value, "NULL") || find_enum_of_prefixed_member(value, &member)));
+    if (!constant) {
+        return AST_NO_MATCH;
+    }
+
+    /* Adjacent string literals concatenate */
+    do {
+        i = skip_blank(children, count, i + 1);
+    } while (value->type == TOKEN_STRING && i < count && children[i]->token.type == TOKEN_STRING);
+
+    return i < count && token_text_equals(&children[i]->token, ";") ? i : AST_NO_MATCH;
+}
+
+/* Append the tokens of [start, end) on one line, spaced only between words */
+static void append_tokens(OutputSink_t *out, ASTNode_t **children, size_t start, size_t end) {
+    for (size_t k = start; k < end; k++) {
+        Token *t = &children[k]->token;
+        if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT || t->text[0] == '\0') {
+            continue;
+        }
+        int space = out->length > 0 && (isalnum((unsigned char)out->data[out->length - 1]) ||
+                                        out->data[out->length - 1] == '_') &&
+                    (isalnum((unsigned char)t->text[0]) || t->text[0] == '_');
+        if (space) {
+            sink_putc(out, ' ');
+        }
+        sink_write(out, t->text, t->length);
+    }
+}
+
+/* Write the return type of the function named at position name into buffer (CZar types mapped to C) */
+static int function_return_type(ASTNode_t **children, size_t name, char *buffer, size_t size) {
+    size_t words[16];
+    size_t word_count = 0;
+    for (size_t k = ast_prev_significant(children, name);
+         k != AST_NO_MATCH && word_count < sizeof(words) / sizeof(words[0]);
+         k = ast_prev_significant(children, k)) {
+        Token *t = &children[k]->token;
+        int symbol = t->symbol;
+        int type_word = token_text_equals(t, "*") ||
+                        (t->type == TOKEN_IDENTIFIER && !token_text_equals(t, "export")) ||
+                        symbol == SYM_CONST || symbol == SYM_VOLATILE || symbol == SYM_UNSIGNED ||
+                        symbol == SYM_SIGNED || symbol == SYM_CHAR || symbol == SYM_SHORT || symbol == SYM_INT ||
+                        symbol == SYM_LONG || symbol == SYM_FLOAT || symbol == SYM_DOUBLE || symbol == SYM_BOOL ||
+                        symbol == SYM_STRUCT || symbol == SYM_UNION || symbol == SYM_ENUM || symbol == SYM_VOID;
+        if (!type_word) {
+            break;
+        }
+        words[word_count++] = k;
+    }
+
+    size_t length = 0;
+    buffer[0] = '\0';
+    for (size_t w = word_count; w-- > 0;) {
+        const char *text = children[words[w]]->token.text;
+        const char *c_type = transpiler_get_c_type(text);
+        int written = snprintf(buffer + length, size - length, "%s%s", length > 0 ? " " : "", c_type ? c_type : text);
+        if (written < 0 || (size_t)written >= size - length) {
+            return 0;
+        }
+        length += (size_t)written;
+    }
+    return length > 0 && strcmp(buffer, "void") != 0;
+}
+
+/* Lower a "#pragma czar table" switch to a lookup in a static array, returns why it was left, or NULL */
+static const char *lower_table_switch(ASTNode_t *ast, size_t index) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+
+    /* switch (variable) { */
+    size_t open = skip_blank(children, count, index + 1);
+    size_t variable = skip_blank(children, count, open + 1);
+    size_t close = skip_blank(children, count, variable + 1);
+    size_t body = skip_blank(children, count, close + 1);
+    if (body >= count || !token_text_equals(&children[open]->token, "(") ||
+        children[variable]->token.type != TOKEN_IDENTIFIER || ast_match(ast, open) != close ||
+        !token_text_equals(&children[body]->token, "{")) {
+        return "the switched value must be a plain variable";
+    }
+    size_t body_end = ast_match(ast, body);
+    if (body_end == AST_NO_MATCH) {
+        return "the switch body is not closed";
+    }
+
+    const ScopeEntry_t *scope = scope_map_at(ast, index);
+    char type[256];
+    if (scope->function == AST_NO_MATCH || !function_return_type(children, scope->function, type, sizeof(type))) {
+        return "the enclosing function must return a value";
+    }
+
+    /* Arms: "case A: [case B:] return CONSTANT; [break;]", then a last "default:" */
+    EnumInfo *info = NULL;
+    size_t *slots = NULL;   /* Slot (value - min) -> position of its returned constant */
+    int *pending = NULL;    /* Slots of the labels of the current arm */
+    int pending_count = 0;
+    size_t default_colon = AST_NO_MATCH;
+    const char *reason = NULL;
+
+    size_t k = skip_blank(children, count, body + 1);
+    while (!reason && k < body_end) {
+        Token *t = &children[k]->token;
+        if (t->symbol == SYM_CASE) {
+            size_t label = skip_blank(children, count, k + 1);
+            size_t colon = skip_blank(children, count, label + 1);
+            int m = -1;
+            EnumInfo *label_enum = label < body_end ? find_enum_of_prefixed_member(&children[label]->token, &m) : NULL;
+            if (!label_enum || (info && label_enum != info) || colon >= body_end ||
+                !token_text_equals(&children[colon]->token, ":")) {
+                reason = "case labels must be members of one enum";
+            } else if (!label_enum->dense) {
+                reason = "the enum values must be contiguous";
+            } else {
+                if (!info) {
+                    info = label_enum;
+                    slots = malloc((size_t)info->member_count * sizeof(size_t));
+                    pending = malloc((size_t)info->member_count * sizeof(int));
+                    if (!slots || !pending) {
+                        reason = "out of memory";
+                        break;
+                    }
+                    for (int s = 0; s < info->member_count; s++) {
+                        slots[s] = AST_NO_MATCH;
                     }
-                    goto next_identifier;
                 }
+                pending[pending_count++] = (int)(info->members[m].value - info->min_value);
+                k = skip_blank(children, count, colon + 1);
+            }
+        } else if (t->symbol == SYM_RETURN && pending_count > 0) {
+            size_t semicolon = match_constant_return(children, count, k);
+            if (semicolon == AST_NO_MATCH) {
+                reason = "arms must only return a constant";
+                break;
+            }
+            while (pending_count > 0) {
+                slots[pending[--pending_count]] = skip_blank(children, count, k + 1);
+            }
+            k = skip_blank(children, count, semicolon + 1);
+            size_t after = skip_blank(children, count, k + 1);
+            if (k < body_end && children[k]->token.symbol == SYM_BREAK &&
+                after < body_end && token_text_equals(&children[after]->token, ";")) {
+                k = skip_blank(children, count, after + 1);
+            }
+        } else if (t->symbol == SYM_DEFAULT && pending_count == 0) {
+            default_colon = skip_blank(children, count, k + 1);
+            if (default_colon >= body_end || !token_text_equals(&children[default_colon]->token, ":")) {
+                reason = "the default label is malformed";
+            }
+            break;
+        } else {
+            reason = pending_count > 0 ? "arms must only return a constant" : "the default arm must come last";
+        }
+    }
+
+    /* The default arm runs for values outside the enum, it must not leave the switch */
+    for (size_t d = default_colon; !reason && d != AST_NO_MATCH && d < body_end; d++) {
+        int symbol = children[d]->token.symbol;
+        if (symbol == SYM_CASE || symbol == SYM_DEFAULT || symbol == SYM_BREAK || symbol == SYM_CONTINUE) {
+            reason = "the default arm must come last and not break out of the switch";
+        }
+    }
+    if (!reason && (!info || default_colon == AST_NO_MATCH)) {
+        reason = "the switch needs enum case labels and a default arm";
+    }
+    for (int s = 0; !reason && s < info->member_count; s++) {
+        if (slots[s] == AST_NO_MATCH) {
+            reason = "every enum member needs an arm";
+        }
+    }
+
+    if (!reason) {
+        const char *value = children[variable]->token.text;
+        OutputSink_t sink;
+        sink_init(&sink, NULL);
+        sink_printf(&sink, "{ static %s const _cz_table[%d] = {", type, info->member_count);
+        for (int s = 0; s < info->member_count; s++) {
+            size_t semicolon = slots[s];
+            while (!token_text_equals(&children[semicolon]->token, ";")) {
+                semicolon++;
             }
+            sink_puts(&sink, s == 0 ? " " : ", ");
+            append_tokens(&sink, children, slots[s], semicolon);
+        }
+        if (info->min_value == 0) {
+            sink_printf(&sink, " }; if ((unsigned long long)(%s) < %d) return _cz_table[%s];",
+                        value, info->member_count, value);
+        } else {
+            sink_printf(&sink, " }; if ((unsigned long long)((long long)(%s) - (%lld)) < %d) "
+                               "return _cz_table[(long long)(%s) - (%lld)];",
+                        value, info->min_value, info->member_count, value, info->min_value);
+        }
+        char *text = sink_take(&sink);
+        if (text) {
+            ast_clear_range(children, index + 1, default_colon + 1);
+            token_take_text(&children[index]->token, text);
+        } else {
+            reason = "out of memory";
+        }
+    }
+    free(slots);
+    free(pending);
+    return reason;
+}
+
+/* Lower switches marked "#pragma czar table" whose arms only return constants of a dense enum */
+static void lower_table_switches(ASTNode_t *ast) {
+    for (size_t i = 0; i < ast->child_count; i++) {
+        ASTNode_t **children = ast->children;
+        if (children[i]->type != AST_TOKEN || children[i]->token.symbol != SYM_SWITCH ||
+            !follows_pragma(children, i, "table")) {
+            continue;
+        }
+
+        int line = children[i]->token.line;
+        int column = children[i]->token.column;
+        const char *reason = lower_table_switch(ast, i);
+        if (reason) {
+            char warning_msg[512];
+            snprintf(warning_msg, sizeof(warning_msg), WARN_TABLE_SWITCH_IGNORED, reason);
+            cz_warning_at(g_filename, g_source, line, column, warning_msg);
         }
-        next_identifier:;
     }
 }
 
@@ -858,6 +1305,10 @@ void transpiler_transform_enums(ASTNode_t *ast, const char *filename) {
     /* Prefix enum members in declarations and update all references */
     prefix_enum_members(ast);
 
+    /* Generate name tables of "#pragma czar names" enums, lower "#pragma czar table" switches */
+    generate_enum_names(ast);
+    lower_table_switches(ast);
+
     /* Transform continue in switch cases to fallthrough (generic switch transformation) */
     transpiler_transform_switch_continue_to_fallthrough(ast);
 
@@ -19,8 +19,6 @@
  * - ERROR if case has code but no explicit control flow
  *
  * Limitations:
- * - Maximum 256 enum types can be tracked per compilation unit
- * - Maximum 256 members per enum type
  * - Exhaustiveness checking only works for direct enum variable declarations
  * - Does not currently handle typedef'd enums, function parameters, or struct members
  */
@@ -37,3 +35,9 @@ void transpiler_validate_enums(ASTNode_t *ast, const char *filename, const char
  * - Transforms continue to fallthrough attributes in switch cases
  * - Inserts default cases where missing */
 void transpiler_transform_enums(ASTNode_t *ast, const char *filename);
+
+/* Release the enum registry of the current translation unit */
+void transpiler_free_enum_tables(void);
+
+/* Get the bytes held by the enum registry (cz --stats) */
+size_t transpiler_enum_table_bytes(void);
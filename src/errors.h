@@ -12,14 +12,21 @@
 /* Error reporting function */
 void cz_error(const char *filename, const char *source, int line, const char *message);
 
+/* Error reporting with a caret under column (1-based, 0 if unknown) */
+void cz_error_at(const char *filename, const char *source, int line, int column, const char *message);
+
 /* Main/CLI Errors */
 #define ERR_CANNOT_OPEN_INPUT_FILE "Cannot open input file '%s'"
 #define ERR_CANNOT_OPEN_OUTPUT_FILE "Cannot open output file '%s'"
+#define ERR_CANNOT_WRITE_OUTPUT_FILE "Cannot write output file '%s'"
 #define ERR_FAILED_TO_SEEK_INPUT_FILE "Failed to seek input file"
 #define ERR_FAILED_TO_GET_INPUT_FILE_SIZE "Failed to get input file size"
 #define ERR_MEMORY_ALLOCATION_FAILED "Memory allocation failed"
 #define ERR_FAILED_TO_PARSE_INPUT "Failed to parse input"
 
+/* Feature Registry Errors */
+#define ERR_FEATURE_DEPENDENCY_UNRESOLVED "Feature '%s' has a missing or circular dependency"
+
 /* Parser Errors */
 #define ERR_MEMORY_ALLOCATION_FAILED_IN_AST_NODE "Memory allocation failed in ast_node_add_child"
 
@@ -43,3 +50,14 @@ void cz_error(const char *filename, const char *source, int line, const char *me
 
 /* Named Arguments Errors */
 #define ERR_AMBIGUOUS_ARGUMENTS "Ambiguous function call with consecutive same-type parameters without labels. Use named arguments for clarity: %s"
+
+/* Struct Errors */
+#define ERR_LAYOUT_COMPACT_POSITIONAL_INIT "Positional initializer of struct '%s', whose fields '#pragma czar layout(compact)' reorders. Use designated initializers (.field = value)."
+
+/* Defer Errors */
+#define ERR_DEFER_INLINE_RETURN_TYPE "Inline #defer needs the return type of this function to keep the return value before its cleanups run. Declare it as 'type name(params)', or use '#pragma czar defer cleanup'."
+#define ERR_DEFER_INLINE_GOTO "goto cannot leave the scope of an inline #defer (its cleanup would be skipped). Use break or return, or '#pragma czar defer cleanup'."
+
+/* Comptime Errors */
+#define ERR_COMPTIME_INVALID_DECLARATION "Invalid comptime table: %s"
+#define ERR_COMPTIME_INVALID_EXPRESSION "Cannot evaluate comptime expression: %s"
@@ -4,11 +4,15 @@
  * https://github.com/shkschneider/czar
  *
  * Handles inline expansion of FIXME() calls without macros.
- * Replaces FIXME("msg") with direct fprintf+abort using .cz file location.
+ * Replaces FIXME("msg") with a call to the cold fprintf+abort helper using .cz file location
+ * (in release mode too: unlike UNREACHABLE, reaching it is expected until it is done).
  */
 
 #include "cz.h"
 #include "fixme.h"
+#include "unreachable.h"
+#include "../rewrite.h"
+#include "scopes.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -19,18 +23,6 @@ static int token_text_equals(Token *token, const char *text) {
     return strcmp(token->text, text) == 0;
 }
 
-/* Skip whitespace and comments */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t start) {
-    for (size_t i = start; i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            return i;
-        }
-    }
-    return count;
-}
-
 /* Extract string content from a string token (removes quotes) */
 static char *extract_string_content(const char *str_with_quotes) {
     if (!str_with_quotes) return NULL;
@@ -47,56 +39,59 @@ static char *extract_string_content(const char *str_with_quotes) {
     return result;
 }
 
-/* Find the function name containing this position */
-static const char *find_function_name(ASTNode_t **children, size_t count, size_t current_pos) {
-    int brace_depth = 0;
-    const char *function_name = NULL;
-
-    /* Scan from start to find which function we're in */
-    for (size_t i = 0; i < current_pos && i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
-
-        Token *tok = &children[i]->token;
-
-        if (tok->type == TOKEN_PUNCTUATION) {
-            if (token_text_equals(tok, "{")) {
-                brace_depth++;
-                /* If brace_depth is 1, we just entered a top-level block (likely a function) */
-                if (brace_depth == 1) {
-                    for (int j = (int)i - 1; j >= 0 && j >= (int)i - 30; j--) {
-                        if (children[j]->type == AST_TOKEN &&
-                            children[j]->token.type == TOKEN_IDENTIFIER) {
-                            /* Check if followed by ( */
-                            size_t k = j + 1;
-                            while (k < i && children[k]->type == AST_TOKEN &&
-                                   children[k]->token.type == TOKEN_WHITESPACE) {
-                                k++;
-                            }
-                            if (k < i && children[k]->type == AST_TOKEN &&
-                                children[k]->token.type == TOKEN_PUNCTUATION &&
-                                token_text_equals(&children[k]->token, "(")) {
-                                /* Exclude keywords */
-                                if (strcmp(children[j]->token.text, "if") != 0 &&
-                                    strcmp(children[j]->token.text, "while") != 0 &&
-                                    strcmp(children[j]->token.text, "for") != 0 &&
-                                    strcmp(children[j]->token.text, "switch") != 0) {
-                                    function_name = children[j]->token.text;
-                                }
-                                break;
-                            }
-                        }
-                    }
-                }
-            } else if (token_text_equals(tok, "}")) {
-                brace_depth--;
-                if (brace_depth == 0) {
-                    function_name = NULL;
-                }
-            }
-        }
+/* Expand the FIXME(...) call at index, returns the last child index it consumed */
+size_t transpiler_visit_fixme(ASTNode_t *ast, size_t index, const char *filename, ASTRewrite_t *rewrite) {
+    if (ast->children[index]->type != AST_TOKEN) return index;
+    if (ast->children[index]->token.type != TOKEN_IDENTIFIER) return index;
+
+    Token *tok = &ast->children[index]->token;
+    if (!token_text_equals(tok, "FIXME")) return index;
+
+    /* Found FIXME, check for ( ... ) */
+    size_t j = ast_skip_trivia(ast->children, ast->child_count, index + 1);
+    if (j >= ast->child_count) return index;
+    if (ast->children[j]->type != AST_TOKEN) return index;
+    if (!token_text_equals(&ast->children[j]->token, "(")) return index;
+
+    /* Find the message string argument */
+    size_t k = ast_skip_trivia(ast->children, ast->child_count, j + 1);
+    if (k >= ast->child_count) return index;
+    if (ast->children[k]->type != AST_TOKEN) return index;
+    if (ast->children[k]->token.type != TOKEN_STRING) return index;
+
+    char *msg_content = extract_string_content(ast->children[k]->token.text);
+    if (!msg_content) return index;
+
+    /* Find closing ) */
+    size_t closing_paren = ast_skip_trivia(ast->children, ast->child_count, k + 1);
+    if (closing_paren >= ast->child_count) {
+        free(msg_content);
+        return index;
+    }
+    if (!token_text_equals(&ast->children[closing_paren]->token, ")")) {
+        free(msg_content);
+        return index;
     }
 
-    return (brace_depth > 0) ? function_name : NULL;
+    /* Get location info from the original FIXME token */
+    int line = tok->line;
+    const char *func_name = scope_map_function(ast, index);
+    if (!func_name) func_name = "<unknown>";
+
+    /* Build the replacement code (sized to the message) */
+    char *replacement_text = unreachable_site_code(filename, line, func_name, "FIXME", msg_content, 0);
+
+    free(msg_content);
+    if (!replacement_text) return index;
+
+    /* Replace tokens from index to closing_paren with the inline code */
+
+    token_take_text(&ast->children[index]->token, replacement_text);
+    ast->children[index]->token.type = TOKEN_PUNCTUATION;
+
+    /* Remove tokens from index+1 to closing_paren (inclusive) */
+    ast_rewrite_delete_range(rewrite, index + 1, closing_paren - index);
+    return closing_paren;
 }
 
 /* Expand FIXME() calls inline */
@@ -105,75 +100,13 @@ void transpiler_expand_fixme(ASTNode_t *ast, const char *filename) {
         return;
     }
 
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
+
     /* Scan for FIXME(...) patterns */
     for (size_t i = 0; i < ast->child_count; i++) {
-        if (ast->children[i]->type != AST_TOKEN) continue;
-        if (ast->children[i]->token.type != TOKEN_IDENTIFIER) continue;
-
-        Token *tok = &ast->children[i]->token;
-        if (!token_text_equals(tok, "FIXME")) continue;
-
-        /* Found FIXME, check for ( ... ) */
-        size_t j = skip_whitespace(ast->children, ast->child_count, i + 1);
-        if (j >= ast->child_count) continue;
-        if (ast->children[j]->type != AST_TOKEN) continue;
-        if (!token_text_equals(&ast->children[j]->token, "(")) continue;
-
-        /* Find the message string argument */
-        size_t k = skip_whitespace(ast->children, ast->child_count, j + 1);
-        if (k >= ast->child_count) continue;
-        if (ast->children[k]->type != AST_TOKEN) continue;
-        if (ast->children[k]->token.type != TOKEN_STRING) continue;
-
-        char *msg_content = extract_string_content(ast->children[k]->token.text);
-        if (!msg_content) continue;
-
-        /* Find closing ) */
-        size_t closing_paren = skip_whitespace(ast->children, ast->child_count, k + 1);
-        if (closing_paren >= ast->child_count) {
-            free(msg_content);
-            continue;
-        }
-        if (!token_text_equals(&ast->children[closing_paren]->token, ")")) {
-            free(msg_content);
-            continue;
-        }
-
-        /* Get location info from the original FIXME token */
-        int line = tok->line;
-        const char *func_name = find_function_name(ast->children, ast->child_count, i);
-        if (!func_name) func_name = "<unknown>";
-
-        /* Build the replacement code */
-        char replacement_code[1024];
-        snprintf(replacement_code, sizeof(replacement_code),
-                 "{ fprintf(stderr, \"%s:%d: %s: FIXME: %s\\n\"); abort(); }",
-                 filename, line, func_name, msg_content);
-
-        free(msg_content);
-
-        /* Replace tokens from i to closing_paren with the inline code */
-        char *replacement_text = strdup(replacement_code);
-        if (!replacement_text) continue;
-
-        free(ast->children[i]->token.text);
-        ast->children[i]->token.text = replacement_text;
-        ast->children[i]->token.length = strlen(replacement_text);
-        ast->children[i]->token.type = TOKEN_PUNCTUATION;
-
-        /* Remove tokens from i+1 to closing_paren (inclusive) */
-        size_t tokens_to_remove = closing_paren - i;
-        for (size_t m = i + 1; m <= closing_paren && m < ast->child_count; m++) {
-            if (ast->children[m]->token.text) {
-                free(ast->children[m]->token.text);
-            }
-            free(ast->children[m]);
-        }
-
-        /* Shift remaining tokens */
-        for (size_t m = i + 1; m + tokens_to_remove < ast->child_count; m++) {
-            ast->children[m] = ast->children[m + tokens_to_remove];
-        }
-        ast->child_count -= tokens_to_remove;
+        i = transpiler_visit_fixme(ast, i, filename, &rewrite);
     }
+
+    ast_rewrite_commit(&rewrite);
 }
@@ -7,8 +7,10 @@
  *
  * Currently implemented:
  * - Range iteration: for (type var : start..end) → for (mut type var = start; var <= end; var++)
+ *   (a non-literal end is evaluated once: { type _cz_end_var = end; for (...; var <= _cz_end_var; ...) { ... } })
  * - Array with index: for (type idx, type val : array) → for (mut type idx = 0; idx < sizeof(array)/sizeof(array[0]); idx++) { type val = array[idx]; ... }
  * - Array without index: for (_, type val : array) → for (mut size_t _cz_idx = 0; _cz_idx < sizeof(array)/sizeof(array[0]); _cz_idx++) { type val = array[_cz_idx]; ... }
+ * - Vector (declared as cz_vec_t or cz_vec_t *): for (_, type val : vec) → for (mut type *_cz_it_val = vec.data, *_cz_end_val = _cz_it_val + vec.len; _cz_it_val < _cz_end_val; _cz_it_val++) { type val = *_cz_it_val; ... }
  *
  * Planned (TODO):
  * - String iteration: for (char c : str) → for (size_t _i = 0; str[_i] != '\0'; _i++) { char c = str[_i]; ... }
@@ -20,10 +22,14 @@
  * - Array index variables are automatically marked as `mut`
  * - Works with both CZar types (u8, u32, etc.) and standard C types (int, char, etc.)
  * - The user explicitly provides the value type, so no type inference is needed
+ * - With #pragma czar simd, each lowered loop is preceded by the vectorization hint of the compiler
  */
 
 #include "foreach.h"
 #include "errors.h"
+#include "pragma.h"
+#include "../rewrite.h"
+#include "../sink.h"
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -32,112 +38,53 @@
 /* Maximum size for temporary token text buffers */
 #define MAX_TOKEN_BUFFER_SIZE 256
 
+/* Maximum tokens cloned at once (a value type, or a chunk of a range end) */
+#define MAX_TYPE_TOKENS 32
+
 /* Default loop variable name when var name is unavailable */
 #define DEFAULT_LOOP_VAR "i"
 
+/* Vectorization hint put before lowered loops with #pragma czar simd (clang also defines __GNUC__) */
+#define SIMD_HINT \
+    "\n#if defined(__clang__)\n#pragma clang loop vectorize(enable)\n" \
+    "#elif defined(__GNUC__)\n#pragma GCC ivdep\n" \
+    "#elif defined(_OPENMP)\n#pragma omp simd\n" \
+    "#endif\n"
+
 /* Helper: Check if token equals string */
 static int token_equals(const Token *tok, const char *str) {
     return tok && tok->text && strcmp(tok->text, str) == 0;
 }
 
-/* Helper: Skip whitespace and comment tokens */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t start) {
-    while (start < count && children[start]->type == AST_TOKEN) {
-        Token *tok = &children[start]->token;
-        if (tok->type != TOKEN_WHITESPACE && tok->type != TOKEN_COMMENT) {
-            break;
-        }
-        start++;
-    }
-    return start;
-}
-
-/* Helper: Duplicate a string */
-static char *strdup_safe(const char *str) {
-    if (!str) return NULL;
-    size_t len = strlen(str);
-    char *dup = malloc(len + 1);
-    if (dup) {
-        memcpy(dup, str, len);
-        dup[len] = '\0';
-    }
-    return dup;
-}
-
-/* Helper: Mark a token for deletion by replacing its text with empty string */
-static void mark_for_deletion(ASTNode_t *node) {
-    if (node && node->type == AST_TOKEN && node->token.text) {
-        free(node->token.text);
-        node->token.text = strdup_safe("");
-        node->token.length = 0;
-    }
-}
-
 /* Helper: Create a new token with specific text */
 static ASTNode_t *create_token_node(const char *text, TokenType type, int line, int column) {
-    ASTNode_t *node = calloc(1, sizeof(ASTNode_t));
-    if (!node) return NULL;
-    
-    node->type = AST_TOKEN;
-    node->token.type = type;
-    node->token.text = strdup_safe(text);
-    node->token.length = text ? strlen(text) : 0;
-    node->token.line = line;
-    node->token.column = column;
-    node->children = NULL;
-    node->child_count = 0;
-    node->child_capacity = 0;
-    
-    return node;
+    return ast_token_create(type, text ? text : "", line, column);
 }
 
-/* Helper: Insert nodes after a position */
-static void insert_nodes_after(ASTNode_t *ast, size_t pos, ASTNode_t **new_nodes, size_t new_count) {
-    if (!ast || !new_nodes || new_count == 0) return;
-    
-    /* Expand capacity if needed */
-    size_t required_capacity = ast->child_count + new_count;
-    if (required_capacity > ast->child_capacity) {
-        size_t new_capacity = ast->child_capacity * 2;
-        if (new_capacity < required_capacity) {
-            new_capacity = required_capacity;
-        }
-        ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t*));
-        if (!new_children) {
-            /* Memory allocation failed - cannot proceed with insertion */
-            return;
-        }
-        ast->children = new_children;
-        ast->child_capacity = new_capacity;
-    }
-    
-    /* Shift existing nodes */
-    for (size_t i = ast->child_count; i > pos + 1; i--) {
-        ast->children[i + new_count - 1] = ast->children[i - 1];
-    }
-    
-    /* Insert new nodes */
-    for (size_t i = 0; i < new_count; i++) {
-        ast->children[pos + 1 + i] = new_nodes[i];
-    }
-    
-    ast->child_count += new_count;
+/* Helper: Create a new token with formatted text, sized to fit */
+static ASTNode_t *create_formatted_node(TokenType type, int line, int column, const char *format, ...) {
+    OutputSink_t sink;
+    sink_init(&sink, NULL);
+    va_list args;
+    va_start(args, format);
+    sink_vprintf(&sink, format, args);
+    va_end(args);
+    char *text = sink_take(&sink);
+    ASTNode_t *node = create_token_node(text, type, line, column);
+    free(text);
+    return node;
 }
 
 /* Helper: Replace token text */
 static void replace_token_text(Token *tok, const char *new_text) {
     if (!tok) return;
-    if (tok->text) {
-        free(tok->text);
-    }
-    tok->text = strdup_safe(new_text);
-    tok->length = new_text ? strlen(new_text) : 0;
+    token_set_text(tok, new_text ? new_text : "");
 }
 
 /* Helper: Check if we're looking at a foreach pattern */
 static int is_foreach_pattern(ASTNode_t **children, size_t count, size_t for_idx, size_t *colon_idx) {
     /* Look for pattern: for ( ... : ... ) */
-    size_t idx = skip_whitespace(children, count, for_idx + 1);
+    size_t idx = ast_skip_trivia(children, count, for_idx + 1);
     if (idx >= count || !token_equals(&children[idx]->token, "(")) {
         return 0;
     }
@@ -168,11 +115,234 @@ static int is_foreach_pattern(ASTNode_t **children, size_t count, size_t for_idx
     return found_colon;
 }
 
+/* Clone the tokens [start, end) into nodes (whitespace collapsed or leading dropped, "mut" dropped), returns the number cloned */
+static size_t clone_tokens(ASTNode_t **children, size_t start, size_t end, ASTNode_t **nodes, size_t max,
+                           int line, int col) {
+    size_t cloned = 0;
+    for (size_t i = start; i < end && cloned < max; i++) {
+        Token *tok = &children[i]->token;
+        if (children[i]->type != AST_TOKEN || !tok->text || tok->text[0] == '\0' ||
+            tok->type == TOKEN_COMMENT || token_equals(tok, "mut")) {
+            continue;
+        }
+        /* No leading whitespace (e.g. the one after a dropped "mut") */
+        if (tok->type == TOKEN_WHITESPACE && cloned == 0) {
+            continue;
+        }
+        ASTNode_t *node = create_token_node(tok->type == TOKEN_WHITESPACE ? " " : tok->text, tok->type, line, col);
+        if (node) {
+            nodes[cloned++] = node;
+        }
+    }
+    return cloned;
+}
+
+/* Insert clones of the tokens [start, end) before position */
+static void copy_tokens(ASTRewrite_t *rewrite, ASTNode_t **children, size_t start, size_t end,
+                        size_t position, int line, int col) {
+    ASTNode_t *nodes[MAX_TYPE_TOKENS];
+    while (start < end) {
+        /* Clone in chunks, the end of a range may be a long expression */
+        size_t chunk_end = end - start > MAX_TYPE_TOKENS ? start + MAX_TYPE_TOKENS : end;
+        size_t cloned = clone_tokens(children, start, chunk_end, nodes, MAX_TYPE_TOKENS, line, col);
+        ast_rewrite_insert_many(rewrite, position, nodes, cloned);
+        start = chunk_end;
+    }
+}
+
+/* Evaluate the end of a range once: "{ type _cz_end_var = end; for (...; var <= _cz_end_var; ...) { ... } }".
+ * Only for braced bodies and ends that are not a single literal; returns 0 when not hoisted. */
+static int hoist_range_end(ASTNode_t *ast, ASTRewrite_t *rewrite, size_t for_idx, size_t type_idx, size_t var_idx,
+                           size_t end_start, size_t close_paren_idx, const char *var_name) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+
+    size_t end_last = close_paren_idx;
+    while (end_last > end_start && children[end_last - 1]->type == AST_TOKEN &&
+           (children[end_last - 1]->token.type == TOKEN_WHITESPACE || children[end_last - 1]->token.type == TOKEN_COMMENT)) {
+        end_last--;
+    }
+    size_t first = ast_skip_trivia(children, count, end_start);
+    if (first >= end_last || (first + 1 == end_last && children[first]->token.type == TOKEN_NUMBER)) {
+        return 0;
+    }
+    size_t body_start = ast_skip_trivia(children, count, close_paren_idx + 1);
+    if (body_start >= count || !token_equals(&children[body_start]->token, "{")) {
+        return 0;
+    }
+    size_t body_end = ast_match(ast, body_start);
+    if (body_end == AST_NO_MATCH) {
+        return 0;
+    }
+
+    char name[MAX_TOKEN_BUFFER_SIZE];
+    int written = snprintf(name, sizeof(name), "_cz_end_%s", var_name);
+    if (written < 0 || (size_t)written >= sizeof(name)) {
+        return 0;
+    }
+    Token *ref_tok = &children[for_idx]->token;
+    int line = ref_tok->line;
+    int col = ref_tok->column;
+
+    /* "{ type _cz_end_var = end; " before the loop (mutability makes it const) */
+    ast_rewrite_insert(rewrite, for_idx, create_token_node("{", TOKEN_PUNCTUATION, line, col));
+    ast_rewrite_insert(rewrite, for_idx, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    copy_tokens(rewrite, children, type_idx, var_idx, for_idx, line, col);
+    ast_rewrite_insert(rewrite, for_idx, create_token_node(name, TOKEN_IDENTIFIER, line, col));
+    ast_rewrite_insert(rewrite, for_idx, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    ast_rewrite_insert(rewrite, for_idx, create_token_node("=", TOKEN_OPERATOR, line, col));
+    ast_rewrite_insert(rewrite, for_idx, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    copy_tokens(rewrite, children, first, end_last, for_idx, line, col);
+    ast_rewrite_insert(rewrite, for_idx, create_token_node(";", TOKEN_PUNCTUATION, line, col));
+    ast_rewrite_insert(rewrite, for_idx, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+
+    /* The condition reads the local, " }" closes the block after the body */
+    ast_rewrite_insert(rewrite, end_start, create_token_node(name, TOKEN_IDENTIFIER, line, col));
+    ast_rewrite_delete_range(rewrite, end_start, close_paren_idx - end_start);
+    ast_rewrite_insert(rewrite, body_end + 1, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    ast_rewrite_insert(rewrite, body_end + 1, create_token_node("}", TOKEN_PUNCTUATION, line, col));
+    return 1;
+}
+
+/* Insert clones of the type tokens [start, end) before position as a declaration's type,
+ * type words as identifiers so mutability makes the declaration const unless 'mut' */
+static void copy_declaration_type(ASTRewrite_t *rewrite, ASTNode_t **children, size_t start, size_t end,
+                                  size_t position, int line, int col) {
+    ASTNode_t *nodes[MAX_TYPE_TOKENS];
+    size_t cloned = clone_tokens(children, start, end, nodes, MAX_TYPE_TOKENS, line, col);
+    for (size_t t = 0; t < cloned; t++) {
+        if (nodes[t]->token.type == TOKEN_KEYWORD) {
+            nodes[t]->token.type = TOKEN_IDENTIFIER;
+        }
+    }
+    ast_rewrite_insert_many(rewrite, position, nodes, cloned);
+}
+
+/* Insert "name = value;" before position (the name its own token, for mutability to find the declaration) */
+static void insert_initialization(ASTRewrite_t *rewrite, size_t position, const char *name, const char *value,
+                                  int line, int col) {
+    ast_rewrite_insert(rewrite, position, create_token_node(name, TOKEN_IDENTIFIER, line, col));
+    ast_rewrite_insert(rewrite, position, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    ast_rewrite_insert(rewrite, position, create_token_node("=", TOKEN_OPERATOR, line, col));
+    ast_rewrite_insert(rewrite, position, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    ast_rewrite_insert(rewrite, position, create_token_node(value, TOKEN_IDENTIFIER, line, col));
+    ast_rewrite_insert(rewrite, position, create_token_node(";", TOKEN_PUNCTUATION, line, col));
+}
+
+/* Whether the identifier at name_idx was declared as a cz_vec_t before for_idx: 0 no, 1 value, 2 pointer */
+static int vec_declaration(ASTNode_t **children, size_t for_idx, size_t name_idx) {
+    const char *name = children[name_idx]->token.text;
+    if (!name || children[name_idx]->token.type != TOKEN_IDENTIFIER) {
+        return 0;
+    }
+    /* The nearest declaration of the name wins (a rough approximation of shadowing) */
+    for (size_t i = for_idx; i-- > 0;) {
+        if (children[i]->type != AST_TOKEN || !token_equals(&children[i]->token, name)) {
+            continue;
+        }
+        size_t prev = ast_prev_significant(children, i);
+        int pointer = 0;
+        if (prev != AST_NO_MATCH && token_equals(&children[prev]->token, "*")) {
+            pointer = 1;
+            prev = ast_prev_significant(children, prev);
+        }
+        if (prev != AST_NO_MATCH && token_equals(&children[prev]->token, "cz_vec_t")) {
+            return pointer ? 2 : 1;
+        }
+    }
+    return 0;
+}
+
+/* Lower for (idx, type val : vec) to a walk of data..data+len with the bound hoisted:
+ *   for (mut type *_cz_it_val = vec.data, *_cz_end_val = vec.len ? _cz_it_val + vec.len : _cz_it_val;
+ *        _cz_it_val < _cz_end_val; _cz_it_val++) {
+ *       idx_type idx = _cz_it_val - _cz_begin_val; type val = *_cz_it_val; ... }
+ * (_cz_begin_val is declared with the others only for an index). Needs a braced body, returns 0 otherwise. */
+static int lower_vec_loop(ASTNode_t *ast, ASTRewrite_t *rewrite, size_t paren_idx, size_t close_paren_idx,
+                          size_t left_start, size_t idx_var_idx, size_t val_type_start, size_t val_type_end,
+                          int val_has_mut, const char *idx_var_name, const char *val_var_name,
+                          const char *collection_name, int pointer) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    size_t body_start = ast_skip_trivia(children, count, close_paren_idx + 1);
+    if (body_start >= count || !token_equals(&children[body_start]->token, "{")) {
+        return 0;
+    }
+
+    char it[MAX_TOKEN_BUFFER_SIZE];
+    char end[MAX_TOKEN_BUFFER_SIZE];
+    char begin[MAX_TOKEN_BUFFER_SIZE];
+    char buf[4 * MAX_TOKEN_BUFFER_SIZE];
+    const char *access = pointer ? "->" : ".";
+    int w1 = snprintf(it, sizeof(it), "_cz_it_%s", val_var_name);
+    int w2 = snprintf(end, sizeof(end), "_cz_end_%s", val_var_name);
+    int w3 = snprintf(begin, sizeof(begin), "_cz_begin_%s", val_var_name);
+    if (w1 < 0 || w2 < 0 || w3 < 0 || (size_t)w1 >= sizeof(it) || (size_t)w2 >= sizeof(end) ||
+        (size_t)w3 >= sizeof(begin)) {
+        return 0;
+    }
+
+    Token *ref_tok = &children[paren_idx]->token;
+    int line = ref_tok->line;
+    int col = ref_tok->column;
+    size_t header = paren_idx + 1;
+
+    /* mut type *_cz_it_val = vec.data, */
+    ast_rewrite_insert(rewrite, header, create_token_node("mut", TOKEN_KEYWORD, line, col));
+    ast_rewrite_insert(rewrite, header, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    copy_tokens(rewrite, children, val_type_start, val_type_end, header, line, col);
+    ast_rewrite_insert(rewrite, header, create_token_node("*", TOKEN_OPERATOR, line, col));
+    ast_rewrite_insert(rewrite, header, create_token_node(it, TOKEN_IDENTIFIER, line, col));
+    ast_rewrite_insert(rewrite, header, create_token_node(" = ", TOKEN_WHITESPACE, line, col));
+    ast_rewrite_insert(rewrite, header,
+                       create_formatted_node(TOKEN_IDENTIFIER, line, col, "%s%sdata", collection_name, access));
+
+    /* *_cz_end_val = vec.len ? _cz_it_val + vec.len : _cz_it_val[, *_cz_begin_val = _cz_it_val];
+     * (an empty vector may have NULL data, and NULL + 0 is undefined in C) */
+    ast_rewrite_insert(rewrite, header,
+                       create_formatted_node(TOKEN_IDENTIFIER, line, col, ", *%s = %s%slen ? %s + %s%slen : %s", end,
+                                             collection_name, access, it, collection_name, access, it));
+    if (idx_var_name) {
+        snprintf(buf, sizeof(buf), ", *%s = %s", begin, it);
+        ast_rewrite_insert(rewrite, header, create_token_node(buf, TOKEN_IDENTIFIER, line, col));
+    }
+
+    /* _cz_it_val < _cz_end_val; _cz_it_val++ */
+    snprintf(buf, sizeof(buf), "; %s < %s; %s++", it, end, it);
+    ast_rewrite_insert(rewrite, header, create_token_node(buf, TOKEN_IDENTIFIER, line, col));
+
+    /* Body: [idx_type idx = _cz_it_val - _cz_begin_val;] [mut] type val = *_cz_it_val; */
+    Token *brace_tok = &children[body_start]->token;
+    line = brace_tok->line;
+    col = brace_tok->column;
+    size_t body = body_start + 1;
+    if (idx_var_name) {
+        ast_rewrite_insert(rewrite, body, create_token_node("\n        ", TOKEN_WHITESPACE, line, col));
+        copy_declaration_type(rewrite, children, left_start, idx_var_idx, body, line, col);
+        snprintf(buf, sizeof(buf), "%s - %s", it, begin);
+        insert_initialization(rewrite, body, idx_var_name, buf, line, col);
+    }
+    ast_rewrite_insert(rewrite, body, create_token_node("\n        ", TOKEN_WHITESPACE, line, col));
+    if (val_has_mut) {
+        ast_rewrite_insert(rewrite, body, create_token_node("mut", TOKEN_KEYWORD, line, col));
+        ast_rewrite_insert(rewrite, body, create_token_node(" ", TOKEN_WHITESPACE, line, col));
+    }
+    copy_declaration_type(rewrite, children, val_type_start, val_type_end, body, line, col);
+    snprintf(buf, sizeof(buf), "*%s", it);
+    insert_initialization(rewrite, body, val_var_name, buf, line, col);
+
+    /* Deleting clears the text of the old header, so it goes last */
+    ast_rewrite_delete_range(rewrite, header, close_paren_idx - header);
+    return 1;
+}
+
 /* Transform: for (type var : collection) patterns */
-static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *filename, const char *source) {
+static void transform_foreach_loop(ASTNode_t *ast, ASTRewrite_t *rewrite, size_t for_idx, const char *filename, const char *source) {
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
     
+    int lowered = 0;
+
     /* Find colon position */
     size_t colon_idx = 0;
     if (!is_foreach_pattern(children, count, for_idx, &colon_idx)) {
@@ -180,14 +350,14 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
     }
     
     /* Find opening paren */
-    size_t paren_idx = skip_whitespace(children, count, for_idx + 1);
+    size_t paren_idx = ast_skip_trivia(children, count, for_idx + 1);
     if (paren_idx >= count || !token_equals(&children[paren_idx]->token, "(")) {
         return;
     }
     
     /* Parse the left side of colon (variable declarations) */
     /* Can be: type var, type idx, type val, or _, var */
-    size_t left_start = skip_whitespace(children, count, paren_idx + 1);
+    size_t left_start = ast_skip_trivia(children, count, paren_idx + 1);
     size_t left_end = colon_idx;
     
     /* Skip backwards from colon to find last non-whitespace */
@@ -198,21 +368,12 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
     }
     
     /* Parse right side of colon (collection or range) */
-    size_t right_start = skip_whitespace(children, count, colon_idx + 1);
+    size_t right_start = ast_skip_trivia(children, count, colon_idx + 1);
     
     /* Find closing paren */
-    size_t close_paren_idx = right_start;
-    int depth = 1;
-    for (size_t i = paren_idx + 1; i < count && depth > 0; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
-        if (token_equals(&children[i]->token, "(")) depth++;
-        else if (token_equals(&children[i]->token, ")")) {
-            depth--;
-            if (depth == 0) {
-                close_paren_idx = i;
-                break;
-            }
-        }
+    size_t close_paren_idx = ast_match(ast, paren_idx);
+    if (close_paren_idx == AST_NO_MATCH) {
+        close_paren_idx = right_start;
     }
     
     /* Check if right side is a range (contains ..) */
@@ -284,15 +445,7 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                 Token *ref_tok = &children[type_idx]->token;
                 mut_nodes[0] = create_token_node("mut", TOKEN_KEYWORD, ref_tok->line, ref_tok->column);
                 mut_nodes[1] = create_token_node(" ", TOKEN_WHITESPACE, ref_tok->line, ref_tok->column);
-                insert_nodes_after(ast, type_idx - 1, mut_nodes, 2);
-                
-                /* Adjust indices after insertion */
-                colon_idx += 2;
-                var_idx += 2;
-                right_start += 2;
-                close_paren_idx += 2;
-                count = ast->child_count;
-                children = ast->children;
+                ast_rewrite_insert_many(rewrite, type_idx, mut_nodes, 2);
             }
             
             /* Change colon to = with spaces */
@@ -331,7 +484,12 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                     replace_token_text(&children[i]->token, "; ");
                     
                     /* Handle the second token based on its format */
-                    if (children[i + 1]->token.text && children[i + 1]->token.text[0] == '.') {
+                    if (children[i + 1]->token.type != TOKEN_NUMBER) {
+                        /* It's a second ., need to replace with "var <= " (and the end, evaluated once) */
+                        snprintf(buf, sizeof(buf), "%s <= ", var_name ? var_name : DEFAULT_LOOP_VAR);
+                        hoist_range_end(ast, rewrite, for_idx, type_idx, var_idx, i + 2, close_paren_idx,
+                                        var_name ? var_name : DEFAULT_LOOP_VAR);
+                    } else if (children[i + 1]->token.text && children[i + 1]->token.text[0] == '.') {
                         /* It's .N, need to replace with "var <= N" */
                         const char *end_val = &children[i + 1]->token.text[1]; /* Skip the leading . */
                         /* Use snprintf and check return value to ensure no truncation */
@@ -357,7 +515,8 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                     snprintf(buf, sizeof(buf), "%s++", var_name ? var_name : DEFAULT_LOOP_VAR);
                     new_nodes[1] = create_token_node(buf, TOKEN_IDENTIFIER, line, col);
                     
-                    insert_nodes_after(ast, close_paren_idx - 1, new_nodes, 2);
+                    ast_rewrite_insert_many(rewrite, close_paren_idx, new_nodes, 2);
+                    lowered = 1;
                     break;
                 }
             }
@@ -392,33 +551,27 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
             }
             
             /* Parse value type (between comma and value variable) */
-            size_t val_type_start = skip_whitespace(children, count, comma_idx + 1);
+            size_t val_type_start = ast_skip_trivia(children, count, comma_idx + 1);
             size_t val_type_end = val_var_idx;
             
-            /* Copy value type to a buffer NOW, before we mark tokens for deletion */
-            /* Also check if the value type has 'mut' keyword */
-            char val_type_buf[MAX_TOKEN_BUFFER_SIZE] = {0};
-            size_t val_type_len = 0;
+            /* Clone the value type tokens NOW, before we mark tokens for deletion */
+            /* (token by token so CZar types are still lowered, 'mut' is put back separately) */
             int val_has_mut = 0;
-            
-            for (size_t i = val_type_start; i < val_type_end && val_type_len < MAX_TOKEN_BUFFER_SIZE - 2; i++) {
-                if (children[i]->type == AST_TOKEN && children[i]->token.text &&
-                    children[i]->token.text[0] != '\0') {
-                    /* Check if this is the 'mut' keyword - if so, skip it */
-                    if ((children[i]->token.type == TOKEN_KEYWORD || children[i]->token.type == TOKEN_IDENTIFIER) &&
-                        strcmp(children[i]->token.text, "mut") == 0) {
-                        val_has_mut = 1;
-                        continue; /* Skip copying 'mut' */
-                    }
-                    
-                    size_t tok_len = strlen(children[i]->token.text);
-                    if (val_type_len + tok_len < MAX_TOKEN_BUFFER_SIZE - 2) {
-                        memcpy(val_type_buf + val_type_len, children[i]->token.text, tok_len);
-                        val_type_len += tok_len;
-                    }
+            for (size_t i = val_type_start; i < val_type_end; i++) {
+                if (children[i]->type == AST_TOKEN && token_equals(&children[i]->token, "mut")) {
+                    val_has_mut = 1;
+                }
+            }
+            ASTNode_t *val_type_nodes[MAX_TYPE_TOKENS];
+            size_t val_type_count = clone_tokens(children, val_type_start, val_type_end, val_type_nodes,
+                                                 MAX_TYPE_TOKENS, children[paren_idx]->token.line,
+                                                 children[paren_idx]->token.column);
+            /* Type words go in as identifiers, which mutability makes const unless 'mut' */
+            for (size_t t = 0; t < val_type_count; t++) {
+                if (val_type_nodes[t]->token.type == TOKEN_KEYWORD) {
+                    val_type_nodes[t]->token.type = TOKEN_IDENTIFIER;
                 }
             }
-            val_type_buf[val_type_len] = '\0';
             
             /* Check if index is _ (underscore - meaning we don't want the index variable) */
             int skip_index = 0;
@@ -457,19 +610,29 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                 }
                 
                 /* Build collection name by concatenating tokens */
-                char collection_name[MAX_TOKEN_BUFFER_SIZE] = {0};
-                size_t coll_len = 0;
-                for (size_t i = collection_start; i < collection_end && coll_len < MAX_TOKEN_BUFFER_SIZE - 1; i++) {
+                OutputSink_t collection;
+                sink_init(&collection, NULL);
+                for (size_t i = collection_start; i < collection_end; i++) {
                     if (children[i]->type == AST_TOKEN && children[i]->token.text) {
-                        size_t tok_len = strlen(children[i]->token.text);
-                        if (coll_len + tok_len < MAX_TOKEN_BUFFER_SIZE - 1) {
-                            memcpy(collection_name + coll_len, children[i]->token.text, tok_len);
-                            coll_len += tok_len;
-                        }
+                        sink_write(&collection, children[i]->token.text, children[i]->token.length);
                     }
                 }
-                collection_name[coll_len] = '\0';
-                
+                char *collection_name = sink_take(&collection);
+                if (!collection_name) {
+                    return; /* Out of memory */
+                }
+
+                /* A cz_vec_t walks its elements, up to a length read once */
+                int vec = collection_end > collection_start ?
+                    vec_declaration(children, for_idx, collection_end - 1) : 0;
+                if (vec) {
+                    lowered = lower_vec_loop(ast, rewrite, paren_idx, close_paren_idx, left_start, idx_var_idx,
+                                             val_type_start, val_type_end, val_has_mut, idx_var_name,
+                                             val_var_name, collection_name, vec == 2);
+                    free(collection_name);
+                    goto hint;
+                }
+
                 /* Use a loop index variable - either the specified one or generate one */
                 const char *loop_idx_var = skip_index ? "_cz_idx" : idx_var_name;
                 
@@ -485,6 +648,7 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                 size_t new_token_count = 0;
                 
                 if (!new_tokens) {
+                    free(collection_name);
                     return; /* Out of memory */
                 }
                 
@@ -529,8 +693,9 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                 new_tokens[new_token_count++] = create_token_node(" ", TOKEN_WHITESPACE, line, col);
                 new_tokens[new_token_count++] = create_token_node("<", TOKEN_OPERATOR, line, col);
                 new_tokens[new_token_count++] = create_token_node(" ", TOKEN_WHITESPACE, line, col);
-                snprintf(buf, sizeof(buf), "sizeof(%s)/sizeof(%s[0])", collection_name, collection_name);
-                new_tokens[new_token_count++] = create_token_node(buf, TOKEN_IDENTIFIER, line, col);
+                new_tokens[new_token_count++] = create_formatted_node(TOKEN_IDENTIFIER, line, col,
+                                                                      "sizeof(%s)/sizeof(%s[0])",
+                                                                      collection_name, collection_name);
                 new_tokens[new_token_count++] = create_token_node(";", TOKEN_PUNCTUATION, line, col);
                 new_tokens[new_token_count++] = create_token_node(" ", TOKEN_WHITESPACE, line, col);
                 
@@ -538,25 +703,14 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                 snprintf(buf, sizeof(buf), "%s++", loop_idx_var);
                 new_tokens[new_token_count++] = create_token_node(buf, TOKEN_IDENTIFIER, line, col);
                 
-                /* Now mark all tokens between ( and ) for deletion */
-                for (size_t i = paren_idx + 1; i < close_paren_idx; i++) {
-                    if (children[i]->type == AST_TOKEN) {
-                        mark_for_deletion(children[i]);
-                    }
-                }
-                
-                /* Insert all new tokens after opening paren */
-                insert_nodes_after(ast, paren_idx, new_tokens, new_token_count);
+                /* Replace all tokens between ( and ) with the new header */
+                ast_rewrite_insert_many(rewrite, paren_idx + 1, new_tokens, new_token_count);
+                ast_rewrite_delete_range(rewrite, paren_idx + 1, close_paren_idx - paren_idx - 1);
                 free(new_tokens);
                 
-                /* Update indices after insertion */
-                close_paren_idx += new_token_count;
-                count = ast->child_count;
-                children = ast->children;
-                
                 /* Now find the loop body and insert the value variable declaration */
                 /* The loop body starts after the closing paren */
-                size_t body_start = skip_whitespace(children, count, close_paren_idx + 1);
+                size_t body_start = ast_skip_trivia(children, count, close_paren_idx + 1);
                 
                 /* Check if body is a block { } or a single statement */
                 if (body_start < count && children[body_start]->type == AST_TOKEN &&
@@ -564,10 +718,11 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                     
                     /* Insert after the opening brace */
                     /* Build: val_type val = collection[loop_idx_var]; */
-                    ASTNode_t **val_decl_tokens = malloc(sizeof(ASTNode_t*) * 30);
+                    ASTNode_t **val_decl_tokens = malloc(sizeof(ASTNode_t*) * (30 + val_type_count));
                     size_t val_decl_count = 0;
                     
                     if (!val_decl_tokens) {
+                        free(collection_name);
                         return; /* Out of memory */
                     }
                     
@@ -586,8 +741,9 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                     }
                     
                     /* Add the value type */
-                    val_decl_tokens[val_decl_count++] = create_token_node(val_type_buf, TOKEN_IDENTIFIER,
-                                                                          brace_tok->line, brace_tok->column);
+                    for (size_t t = 0; t < val_type_count; t++) {
+                        val_decl_tokens[val_decl_count++] = val_type_nodes[t];
+                    }
                     
                     /* Add: val = collection[loop_idx_var]; */
                     val_decl_tokens[val_decl_count++] = create_token_node(" ", TOKEN_WHITESPACE,
@@ -600,16 +756,18 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
                                                                           brace_tok->line, brace_tok->column);
                     val_decl_tokens[val_decl_count++] = create_token_node(" ", TOKEN_WHITESPACE,
                                                                           brace_tok->line, brace_tok->column);
-                    snprintf(buf, sizeof(buf), "%s[%s]", collection_name, loop_idx_var);
-                    val_decl_tokens[val_decl_count++] = create_token_node(buf, TOKEN_IDENTIFIER,
-                                                                          brace_tok->line, brace_tok->column);
+                    val_decl_tokens[val_decl_count++] = create_formatted_node(TOKEN_IDENTIFIER, brace_tok->line,
+                                                                              brace_tok->column, "%s[%s]",
+                                                                              collection_name, loop_idx_var);
                     val_decl_tokens[val_decl_count++] = create_token_node(";", TOKEN_PUNCTUATION,
                                                                           brace_tok->line, brace_tok->column);
                     
                     /* Insert after the opening brace */
-                    insert_nodes_after(ast, body_start, val_decl_tokens, val_decl_count);
+                    ast_rewrite_insert_many(rewrite, body_start + 1, val_decl_tokens, val_decl_count);
                     free(val_decl_tokens);
                 }
+                free(collection_name);
+                lowered = 1;
             }
         } else {
             /* Single variable: for (type var : collection) - not yet implemented */
@@ -617,6 +775,13 @@ static void transform_foreach_loop(ASTNode_t *ast, size_t for_idx, const char *f
             (void)source;
         }
     }
+
+hint:
+    /* The hint goes right before "for" (after a hoisted range end) */
+    if (lowered && g_pragmas && g_pragmas->simd) {
+        Token *for_tok = &children[for_idx]->token;
+        ast_rewrite_insert(rewrite, for_idx, create_token_node(SIMD_HINT, TOKEN_PREPROCESSOR, for_tok->line, for_tok->column));
+    }
 }
 
 /* Main transformation function */
@@ -627,6 +792,8 @@ void transpiler_transform_foreach(ASTNode_t *ast, const char *filename, const ch
     
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
     
     /* Find all for loops and check if they use foreach syntax */
     for (size_t i = 0; i < count; i++) {
@@ -637,11 +804,7 @@ void transpiler_transform_foreach(ASTNode_t *ast, const char *filename, const ch
             /* Check if this is a foreach pattern */
             size_t colon_pos = 0;
             if (is_foreach_pattern(children, count, i, &colon_pos)) {
-                transform_foreach_loop(ast, i, filename, source);
-                
-                /* Update children and count after transformation */
-                children = ast->children;
-                count = ast->child_count;
+                transform_foreach_loop(ast, &rewrite, i, filename, source);
             }
         }
         
@@ -650,4 +813,7 @@ void transpiler_transform_foreach(ASTNode_t *ast, const char *filename, const ch
             transpiler_transform_foreach(children[i], filename, source);
         }
     }
+
+    /* Apply all loop rewrites at once */
+    ast_rewrite_commit(&rewrite);
 }
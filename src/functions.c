@@ -3,18 +3,88 @@
  * MIT License Copyright (c) 2026 ShkSchneider
  * https://github.com/shkschneider/czar
  *
- * Handles function-related transformations and validations.
+ * Handles function-related transformations and validations, and infers
+ * const/pure/noreturn/inline for definitions from their token stream.
  */
 
 #include "cz.h"
 #include "functions.h"
 #include "warnings.h"
+#include "scopes.h"
+#include "../rewrite.h"
+#include "../hashtable.h"
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
 #define ATTRIBUTE_WARN_UNUSED_RESULT "__attribute__((warn_unused_result))\n"
 #define ATTRIBUTE_PURE "__attribute__((pure))\n"
+#define ATTRIBUTE_CONST "__attribute__((const))\n"
+#define ATTRIBUTE_NORETURN "__attribute__((noreturn))\n"
+
+/* Private functions up to this many body tokens are inline candidates (leaf ones up to INLINE_LEAF_TOKENS) */
+#define INLINE_SMALL_TOKENS 16
+#define INLINE_LEAF_TOKENS 48
+
+/* Scope values of the names bound in a function body */
+#define LOCAL_VALUE 1
+#define LOCAL_POINTER 2
+
+/* Library functions the analysis knows: without memory access, reading memory only, never returning */
+static const char *const_library[] = { "abs", "labs", "llabs", NULL };
+static const char *pure_library[] = { "strlen", "strcmp", "strncmp", "memcmp", "strchr", "strrchr", "strstr", NULL };
+static const char *noreturn_library[] = { "abort", "exit", "_Exit", "quick_exit", "longjmp", "siglongjmp",
+                                          "UNREACHABLE", "TODO", "FIXME", NULL };
+
+/* Facts gathered about one function definition */
+typedef struct {
+    size_t name;                 /* Position of the function name */
+    size_t return_type;          /* Position attributes are inserted before */
+    size_t body;                 /* Position of the body '{' */
+    size_t body_end;             /* Position of the body '}' */
+    int symbol;                  /* Symbol ID of the name */
+    bool is_void;                /* Returns void */
+    bool is_main;                /* Is main() */
+    bool is_static;              /* Already static */
+    bool is_inline;              /* Already inline */
+    bool is_exported;            /* Marked export (public) */
+    bool is_cold;                /* Marked cold (kept out of line) */
+    bool annotated;              /* Already carries pure, const or noreturn */
+    bool uses_pointers;          /* Has pointer parameters or locals, or uses '->' */
+    bool reads_globals;          /* Reads names that are not its parameters or locals */
+    bool writes_memory;          /* Writes anything but its own locals */
+    bool opaque;                 /* Does something the analysis can't follow (unknown calls, asm, volatile...) */
+    bool returns;                /* Has a return statement (or goto) */
+    bool calls_itself;           /* Calls its own name */
+    int tail_call;               /* Callee of the last statement (SYM_NONE if not a call) */
+    bool infinite_loop;          /* The last statement is an infinite loop without break */
+    size_t call_count;           /* Number of calls */
+    size_t size;                 /* Significant tokens in the body */
+    bool is_const;               /* Inferred: result only depends on the argument values */
+    bool is_pure;                /* Inferred: no side effects, may read memory */
+    bool is_noreturn;            /* Inferred: never returns */
+} FunctionFacts_t;
+
+/* One call made by an analyzed function */
+typedef struct {
+    size_t caller;               /* Index of the calling function */
+    int callee;                  /* Symbol ID of the called name */
+} FunctionCall_t;
+
+/* Facts about every function definition of the translation unit */
+typedef struct {
+    FunctionFacts_t *functions;  /* Definitions in source order */
+    size_t count;                /* Number of definitions */
+    size_t capacity;             /* Capacity of functions array */
+    FunctionCall_t *calls;       /* Calls made by the definitions */
+    size_t call_count;           /* Number of calls */
+    size_t call_capacity;        /* Capacity of calls array */
+    HashTable_t by_name;         /* Symbol ID -> function index */
+    HashTable_t constants;       /* Symbol ID -> 1 for enum names and members of the translation unit */
+    HashTable_t prototypes;      /* Symbol ID -> 1 for functions also declared by a prototype */
+    ScopeTable_t scopes;         /* Parameters and locals of the function being analyzed */
+} FunctionAnalysis_t;
 
 /* Helper function to check if token text matches */
 static int token_text_equals(Token *token, const char *text) {
@@ -24,22 +94,6 @@ static int token_text_equals(Token *token, const char *text) {
     return strcmp(token->text, text) == 0;
 }
 
-/* Skip whitespace and comment tokens */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t i) {
-    while (i < count) {
-        if (children[i]->type != AST_TOKEN) {
-            i++;
-            continue;
-        }
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            break;
-        }
-        i++;
-    }
-    return i;
-}
-
 /* Validate and transform function declarations */
 void transpiler_validate_functions(ASTNode_t *ast, const char *filename, const char *source) {
     if (!ast || ast->type != AST_TRANSLATION_UNIT) {
@@ -60,7 +114,7 @@ void transpiler_validate_functions(ASTNode_t *ast, const char *filename, const c
         Token *tok = &children[i]->token;
 
         /* Look for function name followed by ( */
-        size_t j = skip_whitespace(children, count, i + 1);
+        size_t j = ast_skip_trivia(children, count, i + 1);
         if (j >= count) continue;
         if (children[j]->type != AST_TOKEN) continue;
         if (!token_text_equals(&children[j]->token, "(")) continue;
@@ -68,11 +122,9 @@ void transpiler_validate_functions(ASTNode_t *ast, const char *filename, const c
         /* This looks like a function call or declaration */
         /* Check if this is a function declaration by looking backward for return type */
         int is_function_decl = 0;
-        for (int k = (int)i - 1; k >= 0 && k >= (int)i - 10; k--) {
-            if (children[k]->type != AST_TOKEN) continue;
-            if (children[k]->token.type == TOKEN_WHITESPACE ||
-                children[k]->token.type == TOKEN_COMMENT) continue;
-
+        for (size_t k = ast_prev_significant(children, i);
+             k != AST_NO_MATCH && k + 10 >= i;
+             k = ast_prev_significant(children, k)) {
             /* Check if previous token is a type keyword or identifier */
             if (children[k]->token.type == TOKEN_KEYWORD ||
                 children[k]->token.type == TOKEN_IDENTIFIER) {
@@ -134,7 +186,7 @@ void transpiler_validate_functions(ASTNode_t *ast, const char *filename, const c
                      "Function '%s' declared with empty parameter list (). "
                      "Prefer explicit 'void' parameter: %s(void)",
                      tok->text, tok->text);
-            cz_warning(g_filename, g_source, tok->line, warning_msg);
+            cz_warning_at(g_filename, g_source, tok->line, tok->column, warning_msg);
         }
     }
 }
@@ -147,6 +199,8 @@ void transpiler_transform_functions(ASTNode_t *ast) {
 
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
 
     /* Scan for function declarations */
     for (size_t i = 0; i < count; i++) {
@@ -159,7 +213,7 @@ void transpiler_transform_functions(ASTNode_t *ast) {
         int is_main = (strcmp(tok->text, "main") == 0);
 
         /* Look for function name followed by ( */
-        size_t j = skip_whitespace(children, count, i + 1);
+        size_t j = ast_skip_trivia(children, count, i + 1);
         if (j >= count) continue;
         if (children[j]->type != AST_TOKEN) continue;
         if (!token_text_equals(&children[j]->token, "(")) continue;
@@ -167,11 +221,9 @@ void transpiler_transform_functions(ASTNode_t *ast) {
         /* This looks like a function */
         /* Check if this is a function declaration by looking backward for return type */
         int return_type_idx = -1;
-        for (int k = (int)i - 1; k >= 0 && k >= (int)i - 10; k--) {
-            if (children[k]->type != AST_TOKEN) continue;
-            if (children[k]->token.type == TOKEN_WHITESPACE ||
-                children[k]->token.type == TOKEN_COMMENT) continue;
-
+        for (size_t k = ast_prev_significant(children, i);
+             k != AST_NO_MATCH && k + 10 >= i;
+             k = ast_prev_significant(children, k)) {
             /* Check if previous token is a type keyword or identifier */
             if (children[k]->token.type == TOKEN_KEYWORD ||
                 children[k]->token.type == TOKEN_IDENTIFIER) {
@@ -193,7 +245,7 @@ void transpiler_transform_functions(ASTNode_t *ast) {
                     strcmp(text, "size_t") == 0 || strcmp(text, "const") == 0 ||
                     strcmp(text, "static") == 0 || strcmp(text, "inline") == 0 ||
                     strcmp(text, "export") == 0) {
-                    return_type_idx = k;
+                    return_type_idx = (int)k;
                     break;
                 }
             }
@@ -211,13 +263,10 @@ void transpiler_transform_functions(ASTNode_t *ast) {
             } else if (strcmp(return_type->text, "u32") == 0 ||
                        strcmp(return_type->text, "uint32_t") == 0) {
                 /* Replace with int */
-                free(return_type->text);
-                return_type->text = strdup("int");
-                if (!return_type->text) {
+                if (!token_set_text(return_type, "int")) {
                     /* Memory allocation failed, skip this function */
                     continue;
                 }
-                return_type->length = 3;
             }
         }
 
@@ -238,39 +287,10 @@ void transpiler_transform_functions(ASTNode_t *ast) {
                         /* If empty parameter list, insert 'void' */
                         if (!has_content) {
                             /* Create new nodes for 'void' */
-                            ASTNode_t *void_node = malloc(sizeof(ASTNode_t));
+                            ASTNode_t *void_node = ast_token_create(TOKEN_KEYWORD, "void", tok->line, tok->column);
                             if (void_node) {
-                                void_node->type = AST_TOKEN;
-                                void_node->token.type = TOKEN_KEYWORD;
-                                void_node->token.text = strdup("void");
-                                void_node->token.length = 4;
-                                void_node->token.line = tok->line;
-                                void_node->token.column = tok->column;
-                                void_node->children = NULL;
-                                void_node->child_count = 0;
-                                void_node->child_capacity = 0;
-
                                 /* Insert void node after opening paren */
-                                /* Grow array if needed */
-                                if (ast->child_count >= ast->child_capacity) {
-                                    size_t new_capacity = ast->child_capacity == 0 ? 8 : ast->child_capacity * 2;
-                                    ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-                                    if (new_children) {
-                                        ast->children = new_children;
-                                        ast->child_capacity = new_capacity;
-                                        children = ast->children; /* Update local pointer */
-                                    }
-                                }
-
-                                /* Shift elements to make room */
-                                if (ast->child_count < ast->child_capacity) {
-                                    for (size_t m = ast->child_count; m > first_content_idx; m--) {
-                                        ast->children[m] = ast->children[m - 1];
-                                    }
-                                    ast->children[first_content_idx] = void_node;
-                                    ast->child_count++;
-                                    count = ast->child_count; /* Update local count */
-                                }
+                                ast_rewrite_insert(&rewrite, first_content_idx, void_node);
                             }
                         }
                         break;
@@ -286,6 +306,8 @@ void transpiler_transform_functions(ASTNode_t *ast) {
             j++;
         }
     }
+
+    ast_rewrite_commit(&rewrite);
 }
 
 /* Add warn_unused_result attribute to non-void functions */
@@ -296,6 +318,8 @@ void transpiler_add_warn_unused_result(ASTNode_t *ast) {
 
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
 
     /* Scan for function declarations */
     for (size_t i = 0; i < count; i++) {
@@ -303,7 +327,7 @@ void transpiler_add_warn_unused_result(ASTNode_t *ast) {
         if (children[i]->token.type != TOKEN_IDENTIFIER) continue;
 
         /* Look for function name followed by ( */
-        size_t j = skip_whitespace(children, count, i + 1);
+        size_t j = ast_skip_trivia(children, count, i + 1);
         if (j >= count) continue;
         if (children[j]->type != AST_TOKEN) continue;
         if (!token_text_equals(&children[j]->token, "(")) continue;
@@ -313,11 +337,9 @@ void transpiler_add_warn_unused_result(ASTNode_t *ast) {
         int return_type_idx = -1;
         int is_void_return = 0;
 
-        for (int k = (int)i - 1; k >= 0 && k >= (int)i - 15; k--) {
-            if (children[k]->type != AST_TOKEN) continue;
-            if (children[k]->token.type == TOKEN_WHITESPACE ||
-                children[k]->token.type == TOKEN_COMMENT) continue;
-
+        for (size_t k = ast_prev_significant(children, i);
+             k != AST_NO_MATCH && k + 15 >= i;
+             k = ast_prev_significant(children, k)) {
             /* Check if this is __attribute__ - skip it */
             if (children[k]->token.type == TOKEN_KEYWORD &&
                 children[k]->token.text &&
@@ -333,7 +355,7 @@ void transpiler_add_warn_unused_result(ASTNode_t *ast) {
                 /* Check if it's void */
                 if (strcmp(text, "void") == 0) {
                     is_void_return = 1;
-                    return_type_idx = k;
+                    return_type_idx = (int)k;
                     break;
                 }
 
@@ -354,7 +376,7 @@ void transpiler_add_warn_unused_result(ASTNode_t *ast) {
                     strcmp(text, "size_t") == 0 || strcmp(text, "const") == 0 ||
                     strcmp(text, "static") == 0 || strcmp(text, "inline") == 0 ||
                     strcmp(text, "export") == 0) {
-                    return_type_idx = k;
+                    return_type_idx = (int)k;
                     break;
                 }
             }
@@ -379,252 +401,662 @@ void transpiler_add_warn_unused_result(ASTNode_t *ast) {
         if (has_warn_unused_result) continue; /* Already has the attribute */
 
         /* Insert __attribute__((warn_unused_result)) before the return type */
-        ASTNode_t *attr_node = malloc(sizeof(ASTNode_t));
+        ASTNode_t *attr_node = ast_token_create(TOKEN_KEYWORD, ATTRIBUTE_WARN_UNUSED_RESULT, children[return_type_idx]->token.line, children[return_type_idx]->token.column);
         if (!attr_node) continue;
+        ast_rewrite_insert(&rewrite, (size_t)return_type_idx, attr_node);
+    }
 
-        attr_node->type = AST_TOKEN;
-        attr_node->token.type = TOKEN_KEYWORD;
-        attr_node->token.text = strdup(ATTRIBUTE_WARN_UNUSED_RESULT);
-        if (!attr_node->token.text) {
-            free(attr_node);
+    ast_rewrite_commit(&rewrite);
+}
+
+/* Check if text is one of names */
+static bool name_in(const char **names, const char *text) {
+    for (size_t i = 0; text && names[i]; i++) {
+        if (strcmp(names[i], text) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Check if a token is the punctuation or operator text */
+static bool is_symbol_token(ASTNode_t **children, size_t index, const char *text) {
+    return index != AST_NO_MATCH && children[index]->type == AST_TOKEN &&
+           (children[index]->token.type == TOKEN_PUNCTUATION || children[index]->token.type == TOKEN_OPERATOR) &&
+           token_text_equals(&children[index]->token, text);
+}
+
+/* Check if a token is one of the assignment operators (=, +=, <<=...) */
+static bool is_assignment(const Token *token) {
+    if (token->type != TOKEN_OPERATOR || !token->text || token->length == 0 || token->text[token->length - 1] != '=') {
+        return false;
+    }
+    return token->length == 1 ||
+           (strcmp(token->text, "==") != 0 && strcmp(token->text, "!=") != 0 &&
+            strcmp(token->text, "<=") != 0 && strcmp(token->text, ">=") != 0);
+}
+
+/* Find the return type word (attributes go before it) of the function named at index, or AST_NO_MATCH */
+static size_t find_return_type(ASTNode_t **children, size_t index) {
+    for (size_t k = ast_prev_significant(children, index);
+         k != AST_NO_MATCH && k + 15 >= index;
+         k = ast_prev_significant(children, k)) {
+        /* Skip attributes */
+        if (children[k]->token.type == TOKEN_KEYWORD && children[k]->token.text &&
+            strstr(children[k]->token.text, "__attribute__") != NULL) {
             continue;
         }
-        attr_node->token.length = strlen(attr_node->token.text);
-        attr_node->token.line = children[return_type_idx]->token.line;
-        attr_node->token.column = children[return_type_idx]->token.column;
-        attr_node->children = NULL;
-        attr_node->child_count = 0;
-        attr_node->child_capacity = 0;
-
-        /* Grow array if needed */
-        if (ast->child_count >= ast->child_capacity) {
-            size_t new_capacity = ast->child_capacity == 0 ? 8 : ast->child_capacity * 2;
-            ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-            if (new_children) {
-                ast->children = new_children;
-                ast->child_capacity = new_capacity;
-                children = ast->children; /* Update local pointer */
-            } else {
-                free(attr_node->token.text);
-                free(attr_node);
-                continue;
+        if (children[k]->token.type == TOKEN_KEYWORD || children[k]->token.type == TOKEN_IDENTIFIER) {
+            const char *text = children[k]->token.text;
+            if (strcmp(text, "void") == 0 || strcmp(text, "int") == 0 ||
+                strcmp(text, "char") == 0 || strcmp(text, "short") == 0 ||
+                strcmp(text, "long") == 0 || strcmp(text, "float") == 0 ||
+                strcmp(text, "double") == 0 || strcmp(text, "unsigned") == 0 ||
+                strcmp(text, "signed") == 0 || strcmp(text, "u8") == 0 ||
+                strcmp(text, "u16") == 0 || strcmp(text, "u32") == 0 ||
+                strcmp(text, "u64") == 0 || strcmp(text, "i8") == 0 ||
+                strcmp(text, "i16") == 0 || strcmp(text, "i32") == 0 ||
+                strcmp(text, "i64") == 0 || strcmp(text, "uint8_t") == 0 ||
+                strcmp(text, "uint16_t") == 0 || strcmp(text, "uint32_t") == 0 ||
+                strcmp(text, "uint64_t") == 0 || strcmp(text, "int8_t") == 0 ||
+                strcmp(text, "int16_t") == 0 || strcmp(text, "int32_t") == 0 ||
+                strcmp(text, "int64_t") == 0 || strcmp(text, "bool") == 0 ||
+                strcmp(text, "size_t") == 0) {
+                return k;
             }
         }
+        break;
+    }
+    return AST_NO_MATCH;
+}
 
-        /* Insert at return_type_idx */
-        if (ast->child_count < ast->child_capacity) {
-            for (size_t m = ast->child_count; m > (size_t)return_type_idx; m--) {
-                ast->children[m] = ast->children[m - 1];
+/* Check the storage words and attributes written before the return type */
+static void scan_specifiers(ASTNode_t **children, size_t name, FunctionFacts_t *facts) {
+    for (size_t k = ast_prev_significant(children, name);
+         k != AST_NO_MATCH && k + 24 >= name;
+         k = ast_prev_significant(children, k)) {
+        Token *t = &children[k]->token;
+        if (!t->text) break;
+        if (t->type == TOKEN_KEYWORD && strstr(t->text, "__attribute__")) {
+            if (strstr(t->text, "pure") || strstr(t->text, "const") || strstr(t->text, "noreturn")) {
+                facts->annotated = true;
             }
-            ast->children[return_type_idx] = attr_node;
-            ast->child_count++;
-            count = ast->child_count; /* Update local count */
-            i++; /* Adjust loop index since we inserted before current position */
-        } else {
-            free(attr_node->token.text);
-            free(attr_node);
+        } else if (strcmp(t->text, "static") == 0) {
+            facts->is_static = true;
+        } else if (strcmp(t->text, "inline") == 0) {
+            facts->is_inline = true;
+        } else if (strcmp(t->text, "export") == 0) {
+            facts->is_exported = true;
+        } else if (strcmp(t->text, "cold") == 0) {
+            facts->is_cold = true;
+        } else if (strcmp(t->text, "extern") == 0 || strcmp(t->text, "_Noreturn") == 0 ||
+                   strcmp(t->text, "noreturn") == 0) {
+            facts->annotated = true;
+        } else if (t->type != TOKEN_KEYWORD && t->type != TOKEN_IDENTIFIER && strcmp(t->text, "*") != 0) {
+            break;
         }
     }
 }
 
-/* Add pure attribute to functions with no parameters or only immutable parameters */
-void transpiler_add_pure(ASTNode_t *ast) {
-    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
-        return;
-    }
-
+/* Record the enum names and members of the translation unit (constants in function bodies) */
+static void collect_enum_constants(ASTNode_t *ast, FunctionAnalysis_t *analysis) {
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
-
-    /* Scan for function declarations */
     for (size_t i = 0; i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
-        if (children[i]->token.type != TOKEN_IDENTIFIER) continue;
+        if (children[i]->type != AST_TOKEN || children[i]->token.type != TOKEN_KEYWORD ||
+            !token_text_equals(&children[i]->token, "enum")) {
+            continue;
+        }
+        size_t k = ast_skip_trivia(children, count, i + 1);
+        if (k < count && children[k]->token.type == TOKEN_IDENTIFIER) {
+            hash_table_put(&analysis->constants, (uint64_t)(uint32_t)cz_token_symbol(&children[k]->token), 1);
+            k = ast_skip_trivia(children, count, k + 1);
+        }
+        if (!is_symbol_token(children, k, "{")) continue;
+        size_t end = ast_match(ast, k);
+        if (end == AST_NO_MATCH) continue;
+        for (size_t m = k + 1; m < end; m++) {
+            if (children[m]->type == AST_TOKEN && children[m]->token.type == TOKEN_IDENTIFIER) {
+                hash_table_put(&analysis->constants, (uint64_t)(uint32_t)cz_token_symbol(&children[m]->token), 1);
+            }
+        }
+        i = end;
+    }
+}
 
-        /* Look for function name followed by ( */
-        size_t j = skip_whitespace(children, count, i + 1);
-        if (j >= count) continue;
-        if (children[j]->type != AST_TOKEN) continue;
-        if (!token_text_equals(&children[j]->token, "(")) continue;
+/* Bind the parameters of [open, close) in the outermost block, returns false for variadic lists */
+static bool bind_parameters(ASTNode_t **children, size_t open, size_t close, FunctionAnalysis_t *analysis,
+                            FunctionFacts_t *facts) {
+    size_t name = AST_NO_MATCH;
+    bool pointer = false;
+    int depth = 0;
+    for (size_t k = open + 1; k <= close; k++) {
+        Token *t = &children[k]->token;
+        if (children[k]->type != AST_TOKEN || !t->text) continue;
+        if (k == close || (depth == 0 && token_text_equals(t, ","))) {
+            if (name != AST_NO_MATCH) {
+                scope_bind(&analysis->scopes, cz_token_symbol(&children[name]->token),
+                           pointer ? LOCAL_POINTER : LOCAL_VALUE);
+                facts->uses_pointers |= pointer;
+            }
+            name = AST_NO_MATCH;
+            pointer = false;
+        } else if (token_text_equals(t, "...")) {
+            return false;
+        } else if (t->type == TOKEN_IDENTIFIER && depth == 0) {
+            name = k;
+        } else if (token_text_equals(t, "*") || token_text_equals(t, "[") || token_text_equals(t, "(")) {
+            pointer = true;
+        }
+        if (t->type == TOKEN_PUNCTUATION && (t->text[0] == '(' || t->text[0] == '[')) depth++;
+        if (t->type == TOKEN_PUNCTUATION && (t->text[0] == ')' || t->text[0] == ']')) depth--;
+    }
+    return true;
+}
 
-        /* Check if this is a method (has . before function name) */
-        int is_method = 0;
-        for (int k = (int)i - 1; k >= 0 && k >= (int)i - 5; k--) {
-            if (children[k]->type != AST_TOKEN) continue;
-            if (children[k]->token.type == TOKEN_WHITESPACE ||
-                children[k]->token.type == TOKEN_COMMENT) continue;
+/* Bind the other declarators of the declaration statement starting after position (T a = 1, *b;) */
+static void bind_declarators(ASTNode_t **children, size_t count, size_t from, FunctionFacts_t *facts,
+                             FunctionAnalysis_t *analysis) {
+    int depth = 0;
+    for (size_t k = from; k < count && children[k]->type == AST_TOKEN; k++) {
+        Token *t = &children[k]->token;
+        if (!t->text || t->text[0] == '\0') continue;
+        if (t->type == TOKEN_PUNCTUATION && strchr("([{", t->text[0])) {
+            depth++;
+        } else if (t->type == TOKEN_PUNCTUATION && strchr(")]}", t->text[0])) {
+            if (--depth < 0) return;
+        } else if (depth == 0 && token_text_equals(t, ";")) {
+            return;
+        } else if (depth == 0 && token_text_equals(t, ",")) {
+            bool pointer = false;
+            size_t n = ast_skip_trivia(children, count, k + 1);
+            while (is_symbol_token(children, n, "*")) {
+                pointer = true;
+                n = ast_skip_trivia(children, count, n + 1);
+            }
+            if (n < count && children[n]->token.type == TOKEN_IDENTIFIER) {
+                scope_bind(&analysis->scopes, cz_token_symbol(&children[n]->token),
+                           pointer ? LOCAL_POINTER : LOCAL_VALUE);
+                facts->uses_pointers |= pointer;
+            }
+        }
+    }
+}
 
-            if (children[k]->token.type == TOKEN_PUNCTUATION &&
-                children[k]->token.text &&
-                strcmp(children[k]->token.text, ".") == 0) {
-                is_method = 1;
-                break;
+/* Check if the lvalue ending right before index is a local value (x, x.field, x[i]) */
+static bool lvalue_before_is_local(ASTNode_t *ast, size_t index, const FunctionAnalysis_t *analysis) {
+    ASTNode_t **children = ast->children;
+    size_t k = ast_prev_significant(children, index);
+    while (k != AST_NO_MATCH) {
+        if (is_symbol_token(children, k, "]")) {
+            size_t open = ast_match(ast, k);
+            if (open == AST_NO_MATCH) return false;
+            k = ast_prev_significant(children, open);
+            continue;
+        }
+        if (children[k]->token.type != TOKEN_IDENTIFIER) {
+            return false;
+        }
+        size_t before = ast_prev_significant(children, k);
+        if (is_symbol_token(children, before, ".")) {
+            size_t owner = ast_prev_significant(children, before);
+            /* Designated initializers (.x = 1) write the object being declared */
+            if (is_symbol_token(children, owner, "{") || is_symbol_token(children, owner, ",")) {
+                return true;
             }
-            break;
+            k = owner;
+            continue;
+        }
+        if (is_symbol_token(children, before, "->") || is_symbol_token(children, before, "*")) {
+            return false;
         }
+        return scope_lookup(&analysis->scopes, cz_token_symbol(&children[k]->token)) == LOCAL_VALUE;
+    }
+    return false;
+}
 
-        if (is_method) continue; /* Skip struct methods */
+/* Check if the lvalue starting right after index is a local value (++x, --x.field) */
+static bool lvalue_after_is_local(ASTNode_t *ast, size_t index, size_t limit, const FunctionAnalysis_t *analysis) {
+    ASTNode_t **children = ast->children;
+    size_t k = ast_skip_trivia(children, limit, index + 1);
+    if (k >= limit || children[k]->token.type != TOKEN_IDENTIFIER ||
+        scope_lookup(&analysis->scopes, cz_token_symbol(&children[k]->token)) != LOCAL_VALUE) {
+        return false;
+    }
+    for (k = ast_skip_trivia(children, limit, k + 1); k < limit; k = ast_skip_trivia(children, limit, k + 1)) {
+        if (is_symbol_token(children, k, "->")) return false;
+        if (!is_symbol_token(children, k, ".") && !is_symbol_token(children, k, "[")) break;
+        k = is_symbol_token(children, k, "[") ? ast_match(ast, k) : ast_skip_trivia(children, limit, k + 1);
+        if (k == AST_NO_MATCH || k >= limit) return false;
+    }
+    return true;
+}
 
-        /* Find return type */
-        int return_type_idx = -1;
-        for (int k = (int)i - 1; k >= 0 && k >= (int)i - 15; k--) {
-            if (children[k]->type != AST_TOKEN) continue;
-            if (children[k]->token.type == TOKEN_WHITESPACE ||
-                children[k]->token.type == TOKEN_COMMENT) continue;
+/* Record a call made by facts (index caller) */
+static void add_call(FunctionAnalysis_t *analysis, size_t caller, int callee) {
+    if (analysis->call_count >= analysis->call_capacity) {
+        size_t new_capacity = analysis->call_capacity == 0 ? 16 : analysis->call_capacity * 2;
+        FunctionCall_t *new_calls = realloc(analysis->calls, new_capacity * sizeof(FunctionCall_t));
+        if (!new_calls) {
+            analysis->functions[caller].opaque = true;
+            return;
+        }
+        analysis->calls = new_calls;
+        analysis->call_capacity = new_capacity;
+    }
+    analysis->calls[analysis->call_count].caller = caller;
+    analysis->calls[analysis->call_count].callee = callee;
+    analysis->call_count++;
+}
 
-            /* Skip attributes */
-            if (children[k]->token.type == TOKEN_KEYWORD &&
-                children[k]->token.text &&
-                strstr(children[k]->token.text, "__attribute__") != NULL) {
-                continue;
+/* Find how the body ends: a call to tail_call, or an infinite loop without break */
+static void scan_last_statement(ASTNode_t *ast, FunctionFacts_t *facts) {
+    ASTNode_t **children = ast->children;
+    size_t last = ast_prev_significant(children, facts->body_end);
+    if (last == AST_NO_MATCH || last <= facts->body) {
+        return;
+    }
+
+    if (is_symbol_token(children, last, ";")) {
+        /* "name(...);" */
+        size_t close = ast_prev_significant(children, last);
+        if (!is_symbol_token(children, close, ")")) return;
+        size_t open = ast_match(ast, close);
+        size_t callee = open == AST_NO_MATCH ? AST_NO_MATCH : ast_prev_significant(children, open);
+        if (callee == AST_NO_MATCH || children[callee]->token.type != TOKEN_IDENTIFIER) return;
+        size_t before = ast_prev_significant(children, callee);
+        if (is_symbol_token(children, before, ";") || is_symbol_token(children, before, "{") ||
+            is_symbol_token(children, before, "}")) {
+            facts->tail_call = cz_token_symbol(&children[callee]->token);
+        }
+        return;
+    }
+
+    if (is_symbol_token(children, last, "}")) {
+        /* "while (1) { ... }" or "for (;;) { ... }" without break */
+        size_t open = ast_match(ast, last);
+        size_t close_paren = open == AST_NO_MATCH ? AST_NO_MATCH : ast_prev_significant(children, open);
+        if (!is_symbol_token(children, close_paren, ")")) return;
+        size_t open_paren = ast_match(ast, close_paren);
+        size_t keyword = open_paren == AST_NO_MATCH ? AST_NO_MATCH : ast_prev_significant(children, open_paren);
+        if (keyword == AST_NO_MATCH) return;
+
+        char header[16] = "";
+        size_t length = 0;
+        for (size_t k = open_paren + 1; k < close_paren; k++) {
+            Token *t = &children[k]->token;
+            if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT || !t->text) continue;
+            if (length + t->length >= sizeof(header)) return;
+            memcpy(header + length, t->text, t->length);
+            length += t->length;
+            header[length] = '\0';
+        }
+        bool forever = (token_text_equals(&children[keyword]->token, "while") &&
+                        (strcmp(header, "1") == 0 || strcmp(header, "true") == 0)) ||
+                       (token_text_equals(&children[keyword]->token, "for") && strcmp(header, ";;") == 0);
+        if (!forever) return;
+        for (size_t k = open + 1; k < last; k++) {
+            if (children[k]->type == AST_TOKEN && token_text_equals(&children[k]->token, "break")) {
+                return;
             }
+        }
+        facts->infinite_loop = true;
+    }
+}
 
-            if (children[k]->token.type == TOKEN_KEYWORD ||
-                children[k]->token.type == TOKEN_IDENTIFIER) {
-                const char *text = children[k]->token.text;
-                if (strcmp(text, "void") == 0 || strcmp(text, "int") == 0 ||
-                    strcmp(text, "char") == 0 || strcmp(text, "short") == 0 ||
-                    strcmp(text, "long") == 0 || strcmp(text, "float") == 0 ||
-                    strcmp(text, "double") == 0 || strcmp(text, "unsigned") == 0 ||
-                    strcmp(text, "signed") == 0 || strcmp(text, "u8") == 0 ||
-                    strcmp(text, "u16") == 0 || strcmp(text, "u32") == 0 ||
-                    strcmp(text, "u64") == 0 || strcmp(text, "i8") == 0 ||
-                    strcmp(text, "i16") == 0 || strcmp(text, "i32") == 0 ||
-                    strcmp(text, "i64") == 0 || strcmp(text, "uint8_t") == 0 ||
-                    strcmp(text, "uint16_t") == 0 || strcmp(text, "uint32_t") == 0 ||
-                    strcmp(text, "uint64_t") == 0 || strcmp(text, "int8_t") == 0 ||
-                    strcmp(text, "int16_t") == 0 || strcmp(text, "int32_t") == 0 ||
-                    strcmp(text, "int64_t") == 0 || strcmp(text, "bool") == 0 ||
-                    strcmp(text, "size_t") == 0 || strcmp(text, "const") == 0 ||
-                    strcmp(text, "static") == 0 || strcmp(text, "inline") == 0 ||
-                    strcmp(text, "export") == 0) {
-                    return_type_idx = k;
-                    break;
+/* Gather the facts of the body of one function */
+static void scan_body(ASTNode_t *ast, size_t index, FunctionAnalysis_t *analysis) {
+    ASTNode_t **children = ast->children;
+    FunctionFacts_t *facts = &analysis->functions[index];
+    size_t end = facts->body_end;
+
+    /* Positions where the block of a for-init declaration closes */
+    size_t for_ends[32];
+    size_t for_depth = 0;
+
+    for (size_t k = facts->body; k <= end; k++) {
+        if (children[k]->type != AST_TOKEN) continue;
+        Token *t = &children[k]->token;
+
+        scope_track_braces(&analysis->scopes, children, k, 0);
+        while (for_depth > 0 && for_ends[for_depth - 1] == k) {
+            scope_pop(&analysis->scopes);
+            for_depth--;
+        }
+        if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT || !t->text || t->text[0] == '\0') {
+            continue;
+        }
+        if (k > facts->body && k < end) {
+            facts->size++;
+        }
+
+        if (t->type == TOKEN_PREPROCESSOR || t->type == TOKEN_UNKNOWN) {
+            facts->opaque = true;
+            continue;
+        }
+
+        if (t->type == TOKEN_KEYWORD) {
+            if (token_text_equals(t, "return") || token_text_equals(t, "goto")) {
+                facts->returns = true;
+            } else if (token_text_equals(t, "static") || token_text_equals(t, "volatile") ||
+                       token_text_equals(t, "asm") || token_text_equals(t, "__asm__")) {
+                facts->opaque = true;
+            } else if ((token_text_equals(t, "sizeof") || token_text_equals(t, "_Alignof")) &&
+                       is_symbol_token(children, ast_skip_trivia(children, end, k + 1), "(")) {
+                /* Operands of sizeof are not evaluated */
+                size_t close = ast_match(ast, ast_skip_trivia(children, end, k + 1));
+                if (close != AST_NO_MATCH) k = close;
+            } else if (token_text_equals(t, "for")) {
+                /* The loop variable lives until the end of the loop body */
+                size_t open = ast_skip_trivia(children, end, k + 1);
+                size_t close = is_symbol_token(children, open, "(") ? ast_match(ast, open) : AST_NO_MATCH;
+                size_t body = close == AST_NO_MATCH ? AST_NO_MATCH : ast_skip_trivia(children, end, close + 1);
+                size_t body_end = AST_NO_MATCH;
+                if (body != AST_NO_MATCH && is_symbol_token(children, body, "{")) {
+                    body_end = ast_match(ast, body);
+                } else if (body != AST_NO_MATCH) {
+                    for (size_t m = body; m < end && body_end == AST_NO_MATCH; m++) {
+                        if (is_symbol_token(children, m, "{") || is_symbol_token(children, m, "(")) {
+                            m = ast_match(ast, m);
+                            if (m == AST_NO_MATCH) break;
+                        } else if (is_symbol_token(children, m, ";")) {
+                            body_end = m;
+                        }
+                    }
+                }
+                if (body_end == AST_NO_MATCH || for_depth >= sizeof(for_ends) / sizeof(for_ends[0])) {
+                    facts->opaque = true;
+                    continue;
+                }
+                scope_push(&analysis->scopes, 0);
+                for_ends[for_depth++] = body_end;
+                /* "for (type [*] name = ...": the last word before anything else is the name */
+                size_t init = ast_skip_trivia(children, end, open + 1);
+                if (init < close && children[init]->type == AST_TOKEN &&
+                    (children[init]->token.type == TOKEN_KEYWORD || children[init]->token.type == TOKEN_IDENTIFIER)) {
+                    size_t type = init;
+                    size_t name = AST_NO_MATCH;
+                    bool pointer = false;
+                    for (size_t m = type; m < close; m = ast_skip_trivia(children, close, m + 1)) {
+                        Token *w = &children[m]->token;
+                        if (w->type == TOKEN_IDENTIFIER || w->type == TOKEN_KEYWORD) {
+                            name = m;
+                        } else if (token_text_equals(w, "*")) {
+                            pointer = true;
+                        } else {
+                            break;
+                        }
+                    }
+                    if (name != AST_NO_MATCH && name != type) {
+                        scope_bind(&analysis->scopes, cz_token_symbol(&children[name]->token),
+                                   pointer ? LOCAL_POINTER : LOCAL_VALUE);
+                        facts->uses_pointers |= pointer;
+                        k = name;
+                        continue;
+                    }
                 }
             }
-            break;
         }
 
-        if (return_type_idx < 0) continue;
+        ScopeDeclaration_t declaration;
+        if (scope_match_declaration(children, end, k, &declaration)) {
+            scope_bind(&analysis->scopes, cz_token_symbol(&children[declaration.name]->token),
+                       declaration.pointer ? LOCAL_POINTER : LOCAL_VALUE);
+            facts->uses_pointers |= declaration.pointer;
+            bind_declarators(children, end, declaration.name + 1, facts, analysis);
+            k = declaration.name;
+            continue;
+        }
 
-        /* Skip void functions - pure doesn't apply to void returns */
-        if (children[return_type_idx]->token.text &&
-            strcmp(children[return_type_idx]->token.text, "void") == 0) {
+        if (t->type == TOKEN_OPERATOR) {
+            if (token_text_equals(t, "->")) {
+                facts->uses_pointers = true;
+            } else if (is_assignment(t)) {
+                if (!lvalue_before_is_local(ast, k, analysis)) facts->writes_memory = true;
+            } else if (token_text_equals(t, "++") || token_text_equals(t, "--")) {
+                size_t prev = ast_prev_significant(children, k);
+                bool postfix = prev != AST_NO_MATCH &&
+                               (children[prev]->token.type == TOKEN_IDENTIFIER || is_symbol_token(children, prev, "]"));
+                bool local = postfix ? lvalue_before_is_local(ast, k, analysis)
+                                     : lvalue_after_is_local(ast, k, end, analysis);
+                if (!local) facts->writes_memory = true;
+            }
             continue;
         }
 
-        /* Check if pure attribute is already present */
-        int has_pure = 0;
-        for (int k = return_type_idx; k < (int)i; k++) {
-            if (children[k]->type == AST_TOKEN &&
-                children[k]->token.type == TOKEN_KEYWORD &&
-                children[k]->token.text &&
-                strstr(children[k]->token.text, "pure") != NULL) {
-                has_pure = 1;
-                break;
+        if (t->type != TOKEN_IDENTIFIER) continue;
+
+        size_t prev = ast_prev_significant(children, k);
+        size_t next = ast_skip_trivia(children, end, k + 1);
+        int symbol = cz_token_symbol(t);
+
+        /* cast<Type>(value): skip the type */
+        if (token_text_equals(t, "cast") && is_symbol_token(children, next, "<")) {
+            while (next < end && !is_symbol_token(children, next, ">")) next++;
+            k = next;
+            continue;
+        }
+        /* Members, case labels and goto labels */
+        if (is_symbol_token(children, prev, ".") || is_symbol_token(children, prev, "->")) {
+            if (is_symbol_token(children, next, "(")) facts->opaque = true; /* Method call */
+            continue;
+        }
+        if (prev != AST_NO_MATCH && (token_text_equals(&children[prev]->token, "case") ||
+                                     token_text_equals(&children[prev]->token, "goto"))) {
+            continue;
+        }
+        if (is_symbol_token(children, next, ":") &&
+            (is_symbol_token(children, prev, ";") || is_symbol_token(children, prev, "{") ||
+             is_symbol_token(children, prev, "}"))) {
+            continue;
+        }
+
+        size_t local = scope_lookup(&analysis->scopes, symbol);
+        if (is_symbol_token(children, next, "(")) {
+            if (local != HASH_TABLE_MISSING) {
+                facts->opaque = true; /* Call through a function pointer */
+            } else {
+                facts->call_count++;
+                facts->calls_itself |= symbol == facts->symbol;
+                add_call(analysis, index, symbol);
             }
+            continue;
+        }
+        if (local != HASH_TABLE_MISSING ||
+            hash_table_get(&analysis->constants, (uint64_t)(uint32_t)symbol) != HASH_TABLE_MISSING ||
+            hash_table_get(&analysis->by_name, (uint64_t)(uint32_t)symbol) != HASH_TABLE_MISSING ||
+            token_text_equals(t, "true") || token_text_equals(t, "false") || token_text_equals(t, "NULL")) {
+            continue;
         }
+        facts->reads_globals = true;
+    }
 
-        if (has_pure) continue;
+    scan_last_statement(ast, facts);
+}
 
-        /* Analyze parameters - check if function has any real parameters */
-        /* Functions with () or (void) have no parameters */
-        size_t paren_start = j;
-        int paren_depth = 1;
-        int has_params = 0;
-        int token_count = 0; /* Count actual content tokens */
+/* Record the function definition whose name is at index, returns false when it is not one */
+static bool add_function(ASTNode_t *ast, size_t index, FunctionAnalysis_t *analysis) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    size_t open = ast_skip_trivia(children, count, index + 1);
+    size_t close = is_symbol_token(children, open, "(") ? ast_match(ast, open) : AST_NO_MATCH;
+    size_t body = close == AST_NO_MATCH ? AST_NO_MATCH : ast_skip_trivia(children, count, close + 1);
+    if (body >= count || !is_symbol_token(children, body, "{")) {
+        return false;
+    }
+    size_t body_end = ast_match(ast, body);
+    size_t return_type = find_return_type(children, index);
+    size_t prev = ast_prev_significant(children, index);
+    if (body_end == AST_NO_MATCH || return_type == AST_NO_MATCH || is_symbol_token(children, prev, ".")) {
+        return false;
+    }
 
-        for (size_t k = paren_start + 1; k < count && paren_depth > 0; k++) {
-            if (children[k]->type != AST_TOKEN) continue;
+    if (analysis->count >= analysis->capacity) {
+        size_t new_capacity = analysis->capacity == 0 ? 16 : analysis->capacity * 2;
+        FunctionFacts_t *new_functions = realloc(analysis->functions, new_capacity * sizeof(FunctionFacts_t));
+        if (!new_functions) {
+            return false;
+        }
+        analysis->functions = new_functions;
+        analysis->capacity = new_capacity;
+    }
+    FunctionFacts_t *facts = &analysis->functions[analysis->count];
+    memset(facts, 0, sizeof(*facts));
+    facts->name = index;
+    facts->return_type = return_type;
+    facts->body = body;
+    facts->body_end = body_end;
+    facts->symbol = cz_token_symbol(&children[index]->token);
+    facts->tail_call = SYM_NONE;
+    facts->is_void = token_text_equals(&children[return_type]->token, "void") &&
+                     !is_symbol_token(children, ast_skip_trivia(children, count, return_type + 1), "*");
+    facts->is_main = token_text_equals(&children[index]->token, "main");
+    scan_specifiers(children, index, facts);
+
+    /* Parameters are bound in a block around the body */
+    scope_clear(&analysis->scopes);
+    scope_push(&analysis->scopes, 0);
+    if (!bind_parameters(children, open, close, analysis, facts)) {
+        facts->opaque = true;
+    }
+    hash_table_put(&analysis->by_name, (uint64_t)(uint32_t)facts->symbol, analysis->count);
+    analysis->count++;
+    return true;
+}
 
-            Token *tok = &children[k]->token;
+/* Get the facts of the function named symbol in the translation unit, or NULL */
+static const FunctionFacts_t *find_function(const FunctionAnalysis_t *analysis, int symbol) {
+    size_t index = hash_table_get(&analysis->by_name, (uint64_t)(uint32_t)symbol);
+    return index == HASH_TABLE_MISSING ? NULL : &analysis->functions[index];
+}
 
-            /* Track parentheses depth */
-            if (tok->type == TOKEN_PUNCTUATION && tok->text) {
-                if (strcmp(tok->text, "(") == 0) {
-                    paren_depth++;
-                } else if (strcmp(tok->text, ")") == 0) {
-                    paren_depth--;
-                    if (paren_depth == 0) {
-                        break;
-                    }
-                }
-                continue; /* Don't count punctuation as content */
+/* Derive const, pure and noreturn from the gathered facts, until no call changes the outcome */
+static void solve_attributes(FunctionAnalysis_t *analysis) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t f = 0; f < analysis->count; f++) {
+            FunctionFacts_t *facts = &analysis->functions[f];
+            bool calls_const = true;
+            bool calls_pure = true;
+            for (size_t c = 0; c < analysis->call_count; c++) {
+                if (analysis->calls[c].caller != f) continue;
+                int callee = analysis->calls[c].callee;
+                const FunctionFacts_t *target = find_function(analysis, callee);
+                const char *name = cz_symbol_name(callee);
+                bool callee_const = target ? target->is_const : name_in(const_library, name);
+                bool callee_pure = target ? (target->is_pure || target->is_const)
+                                          : (callee_const || name_in(pure_library, name));
+                calls_const &= callee_const;
+                calls_pure &= callee_pure;
             }
 
-            /* Skip whitespace and comments */
-            if (tok->type == TOKEN_WHITESPACE || tok->type == TOKEN_COMMENT) {
-                continue;
+            bool side_effect_free = !facts->is_void && !facts->is_main && !facts->writes_memory &&
+                                    !facts->opaque && !facts->infinite_loop;
+            bool is_pure = side_effect_free && calls_pure;
+            bool is_const = is_pure && calls_const && !facts->uses_pointers && !facts->reads_globals;
+
+            bool is_noreturn = false;
+            if (facts->is_void && !facts->is_main && !facts->returns) {
+                const FunctionFacts_t *target = find_function(analysis, facts->tail_call);
+                is_noreturn = facts->infinite_loop ||
+                              (facts->tail_call != SYM_NONE &&
+                               (target ? target->is_noreturn
+                                       : name_in(noreturn_library, cz_symbol_name(facts->tail_call))));
             }
 
-            /* Count non-trivial tokens */
-            token_count++;
-
-            /* Check if it's just "void" */
-            if (token_count == 1 && tok->type == TOKEN_KEYWORD && tok->text &&
-                strcmp(tok->text, "void") == 0) {
-                /* First token is void - might be (void) which means no params */
-                continue;
+            if (is_pure != facts->is_pure || is_const != facts->is_const || is_noreturn != facts->is_noreturn) {
+                facts->is_pure = is_pure;
+                facts->is_const = is_const;
+                facts->is_noreturn = is_noreturn;
+                changed = true;
             }
-
-            /* Found actual parameter content (not just void) */
-            has_params = 1;
-            break;
         }
+    }
+}
 
-        /* If we only saw "void" or nothing, no params */
-        if (token_count <= 1) {
-            has_params = 0;
+/* Insert a keyword token before position */
+static void insert_keyword(ASTRewrite_t *rewrite, ASTNode_t **children, size_t position, const char *text) {
+    ASTNode_t *node = ast_token_create(TOKEN_KEYWORD, text, children[position]->token.line,
+                                       children[position]->token.column);
+    if (node) {
+        ast_rewrite_insert(rewrite, position, node);
+    }
+}
+
+/* Infer const, pure, noreturn and inline for the function definitions of the translation unit */
+void transpiler_infer_function_attributes(ASTNode_t *ast) {
+    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
+        return;
+    }
+
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    FunctionAnalysis_t analysis;
+    memset(&analysis, 0, sizeof(analysis));
+    hash_table_init(&analysis.by_name);
+    hash_table_init(&analysis.constants);
+    hash_table_init(&analysis.prototypes);
+    scope_init(&analysis.scopes);
+    collect_enum_constants(ast, &analysis);
+
+    /* Gather the facts of every top-level function definition */
+    int depth = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (children[i]->type != AST_TOKEN) continue;
+        Token *t = &children[i]->token;
+        if (is_symbol_token(children, i, "{")) depth++;
+        if (is_symbol_token(children, i, "}")) depth--;
+        if (depth != 0 || t->type != TOKEN_IDENTIFIER) continue;
+        if (add_function(ast, i, &analysis)) {
+            scan_body(ast, analysis.count - 1, &analysis);
+            i = analysis.functions[analysis.count - 1].body_end;
+            continue;
         }
 
-        /* Only add pure if function has no parameters */
-        if (!has_params) {
-            /* Insert __attribute__((pure)) before the return type */
-            ASTNode_t *attr_node = malloc(sizeof(ASTNode_t));
-            if (!attr_node) continue;
+        /* "name(...);" at file scope: a prototype, which keeps the definition's linkage */
+        size_t open = ast_skip_trivia(children, count, i + 1);
+        size_t close = is_symbol_token(children, open, "(") ? ast_match(ast, open) : AST_NO_MATCH;
+        if (close != AST_NO_MATCH && is_symbol_token(children, ast_skip_trivia(children, count, close + 1), ";")) {
+            hash_table_put(&analysis.prototypes, (uint64_t)(uint32_t)cz_token_symbol(t), 1);
+        }
+    }
 
-            attr_node->type = AST_TOKEN;
-            attr_node->token.type = TOKEN_KEYWORD;
-            attr_node->token.text = strdup(ATTRIBUTE_PURE);
-            if (!attr_node->token.text) {
-                free(attr_node);
-                continue;
-            }
-            attr_node->token.length = strlen(attr_node->token.text);
-            attr_node->token.line = children[return_type_idx]->token.line;
-            attr_node->token.column = children[return_type_idx]->token.column;
-            attr_node->children = NULL;
-            attr_node->child_count = 0;
-            attr_node->child_capacity = 0;
-
-            /* Grow array if needed */
-            if (ast->child_count >= ast->child_capacity) {
-                size_t new_capacity = ast->child_capacity == 0 ? 8 : ast->child_capacity * 2;
-                ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-                if (new_children) {
-                    ast->children = new_children;
-                    ast->child_capacity = new_capacity;
-                    children = ast->children;
-                } else {
-                    free(attr_node->token.text);
-                    free(attr_node);
-                    continue;
-                }
-            }
+    solve_attributes(&analysis);
+
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
+    for (size_t f = 0; f < analysis.count; f++) {
+        const FunctionFacts_t *facts = &analysis.functions[f];
+        if (facts->annotated) continue;
+        if (facts->is_const) {
+            insert_keyword(&rewrite, children, facts->return_type, ATTRIBUTE_CONST);
+        } else if (facts->is_pure) {
+            insert_keyword(&rewrite, children, facts->return_type, ATTRIBUTE_PURE);
+        } else if (facts->is_noreturn) {
+            insert_keyword(&rewrite, children, facts->return_type, ATTRIBUTE_NORETURN);
+        }
 
-            /* Insert at return_type_idx */
-            if (ast->child_count < ast->child_capacity) {
-                for (size_t m = ast->child_count; m > (size_t)return_type_idx; m--) {
-                    ast->children[m] = ast->children[m - 1];
-                }
-                ast->children[return_type_idx] = attr_node;
-                ast->child_count++;
-                count = ast->child_count;
-                i++; /* Adjust loop index */
-            } else {
-                free(attr_node->token.text);
-                free(attr_node);
+        /* Private leaf or tiny functions become static inline */
+        bool small = facts->size <= INLINE_SMALL_TOKENS ||
+                     (facts->call_count == 0 && facts->size <= INLINE_LEAF_TOKENS);
+        if (small && !facts->is_exported && !facts->is_main && !facts->is_inline && !facts->calls_itself &&
+            !facts->is_noreturn && !facts->is_cold &&
+            hash_table_get(&analysis.prototypes, (uint64_t)(uint32_t)facts->symbol) == HASH_TABLE_MISSING) {
+            if (!facts->is_static) {
+                insert_keyword(&rewrite, children, facts->return_type, "static");
+                insert_keyword(&rewrite, children, facts->return_type, " ");
             }
+            insert_keyword(&rewrite, children, facts->return_type, "inline");
+            insert_keyword(&rewrite, children, facts->return_type, " ");
         }
     }
+    ast_rewrite_commit(&rewrite);
+
+    free(analysis.functions);
+    free(analysis.calls);
+    hash_table_free(&analysis.by_name);
+    hash_table_free(&analysis.constants);
+    hash_table_free(&analysis.prototypes);
+    scope_free(&analysis.scopes);
 }
@@ -19,5 +19,5 @@ void transpiler_transform_functions(ASTNode_t *ast);
 /* Add warn_unused_result attribute to non-void functions */
 void transpiler_add_warn_unused_result(ASTNode_t *ast);
 
-/* Add pure attribute to functions with no parameters or only immutable parameters */
-void transpiler_add_pure(ASTNode_t *ast);
+/* Infer const, pure, noreturn and inline for the function definitions of the translation unit */
+void transpiler_infer_function_attributes(ASTNode_t *ast);
@@ -0,0 +1,490 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Declarations of the .cz.h headers behind #import directives.
+ */
+
+#include "cz.h"
+#include "headers.h"
+#include "../input.h"
+#include "../lexer.h"
+#include "../hashtable.h"
+#include "../depfile.h"
+#include "../dirlist.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/* Maximum lengths of a struct base name and of a header path */
+#define MAX_STRUCT_NAME_LEN 509
+#define MAX_PATH_LEN 600
+
+/* Parsed headers (guarded by worker_lock, kept for the whole process) */
+static HeaderIndex_t *headers = NULL;
+static size_t header_count = 0;
+static size_t header_capacity = 0;
+static HashTable_t header_index;   /* Hash of path -> index in headers */
+
+/* Get the modification time of a stat result in nanoseconds */
+static long long stat_mtime_ns(const struct stat *st) {
+#if defined(__APPLE__)
+    return (long long)st->st_mtimespec.tv_sec * 1000000000LL + st->st_mtimespec.tv_nsec;
+#elif defined(__linux__) || defined(__unix__)
+    return (long long)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+#else
+    return (long long)st->st_mtime * 1000000000LL;
+#endif
+}
+
+/* Free the name and parameters of a prototype */
+static void free_function(HeaderFunction_t *function) {
+    for (size_t i = 0; i < function->param_count; i++) {
+        free(function->params[i].name);
+        free(function->params[i].type);
+    }
+    free(function->params);
+    free(function->name);
+}
+
+/* Free the declarations of a parsed header (not its path) */
+static void free_declarations(HeaderIndex_t *header) {
+    for (size_t i = 0; i < header->typedef_count; i++) {
+        free(header->typedefs[i]);
+    }
+    free(header->typedefs);
+    for (size_t i = 0; i < header->function_count; i++) {
+        free_function(&header->functions[i]);
+    }
+    free(header->functions);
+}
+
+/* Scan header text for "typedef struct Name_s { ... } Name_t" and collect each Name */
+static void scan_typedefs(HeaderIndex_t *header, const char *data) {
+    size_t capacity = 0;
+
+    /* Simple regex-like scan for: typedef struct Name_s { ... } Name_t; */
+    /* We look for "typedef struct <name>_s" followed eventually by "} <name>_t;" */
+    const char *p = data;
+    while ((p = strstr(p, "typedef struct ")) != NULL) {
+        p += 15; /* Skip "typedef struct " */
+
+        /* Extract struct tag name */
+        while (*p == ' ' || *p == '\t') p++;
+        if (!*p) break;
+
+        const char *tag_start = p;
+        while (*p && (isalnum((unsigned char)*p) || *p == '_')) p++;
+        if (p == tag_start) continue;
+
+        size_t tag_len = p - tag_start;
+        if (tag_len < 3) continue; /* Need at least X_s */
+
+        /* Check if ends with _s */
+        if (tag_start[tag_len - 2] != '_' || tag_start[tag_len - 1] != 's') {
+            continue;
+        }
+
+        /* Extract base name (without _s) */
+        char base_name[MAX_STRUCT_NAME_LEN];
+        if (tag_len - 2 >= sizeof(base_name)) continue;
+        memcpy(base_name, tag_start, tag_len - 2);
+        base_name[tag_len - 2] = '\0';
+
+        /* Find the closing brace and typedef name */
+        /* Look for "} Name_t;" */
+        char *typedef_pattern = malloc(tag_len + 10); /* "} " + base + "_t;" */
+        if (!typedef_pattern) continue;
+        sprintf(typedef_pattern, "} %s_t", base_name);
+
+        const char *typedef_loc = strstr(p, typedef_pattern);
+        free(typedef_pattern);
+        if (!typedef_loc) continue;
+
+        /* Found a match - keep this name */
+        if (header->typedef_count >= capacity) {
+            size_t new_capacity = capacity == 0 ? 8 : capacity * 2;
+            char **new_names = realloc(header->typedefs, new_capacity * sizeof(char *));
+            if (!new_names) break;
+            header->typedefs = new_names;
+            capacity = new_capacity;
+        }
+        header->typedefs[header->typedef_count] = strdup(base_name);
+        if (header->typedefs[header->typedef_count]) {
+            header->typedef_count++;
+        }
+    }
+}
+
+/* Check whether a token is the single punctuation character c */
+static int is_punctuation(const Token *token, char c) {
+    return token->type == TOKEN_PUNCTUATION && token->length == 1 && token->text[0] == c;
+}
+
+/* Check whether a token can be part of a type or parameter name */
+static int is_word(const Token *token) {
+    return token->type == TOKEN_IDENTIFIER || token->type == TOKEN_KEYWORD;
+}
+
+/* Append one parameter (tokens [start, end) of a prototype) to function */
+static int add_param(HeaderFunction_t *function, size_t *capacity, const Token *tokens, size_t start, size_t end) {
+    /* "(void)" and "()" have no parameters */
+    if (start == end || (end - start == 1 && tokens[start].length == 4 &&
+                         strncmp(tokens[start].text, "void", 4) == 0)) {
+        return 1;
+    }
+    if (function->param_count >= *capacity) {
+        size_t new_capacity = *capacity == 0 ? 8 : *capacity * 2;
+        HeaderParam_t *new_params = realloc(function->params, new_capacity * sizeof(HeaderParam_t));
+        if (!new_params) {
+            return 0;
+        }
+        function->params = new_params;
+        *capacity = new_capacity;
+    }
+    HeaderParam_t *param = &function->params[function->param_count++];
+    param->name = NULL;
+    param->type = NULL;
+
+    /* "type name": the name is the last word when it is an identifier after another word */
+    const Token *name = NULL;
+    const Token *type = NULL;
+    for (size_t i = start; i < end; i++) {
+        if (is_punctuation(&tokens[i], '(') || is_punctuation(&tokens[i], '[')) {
+            return 1; /* Function pointer or array: keep it unnamed */
+        }
+        if (is_word(&tokens[i])) {
+            type = name;
+            name = &tokens[i];
+        }
+    }
+    if (name && type && name->type == TOKEN_IDENTIFIER) {
+        param->name = strndup(name->text, name->length);
+        param->type = strndup(type->text, type->length);
+    } else if (name) {
+        param->type = strndup(name->text, name->length);
+    }
+    return 1;
+}
+
+/* Parse the prototype "name(params)" with name at tokens[index], returns the
+ * position after ')' (or index + 1 with no function on failure) */
+static size_t parse_prototype(const Token *tokens, size_t count, size_t index, HeaderFunction_t *function) {
+    memset(function, 0, sizeof(*function));
+    size_t capacity = 0;
+    size_t start = index + 2;
+    int parens = 1;
+    size_t i = start;
+    for (; i < count && parens > 0; i++) {
+        if (is_punctuation(&tokens[i], '(')) {
+            parens++;
+        } else if (is_punctuation(&tokens[i], ')')) {
+            parens--;
+        }
+        if ((parens == 0 || (parens == 1 && is_punctuation(&tokens[i], ','))) &&
+            !add_param(function, &capacity, tokens, start, i)) {
+            break;
+        }
+        if (parens == 1 && is_punctuation(&tokens[i], ',')) {
+            start = i + 1;
+        }
+    }
+
+    /* "name(params);" or "name(params) {" declares it */
+    if (parens == 0 && i < count && (is_punctuation(&tokens[i], ';') || is_punctuation(&tokens[i], '{'))) {
+        function->name = strndup(tokens[index].text, tokens[index].length);
+        if (function->name) {
+            return i;
+        }
+    }
+    free_function(function);
+    memset(function, 0, sizeof(*function));
+    return index + 1;
+}
+
+/* Scan header text for top-level "type name(params);" (or "{") and collect each prototype */
+static void scan_functions(HeaderIndex_t *header, const char *data, size_t size) {
+    /* Significant tokens, their text borrowed from the lexer until cleanup */
+    Lexer lexer;
+    lexer_init(&lexer, data, size);
+    Token *tokens = NULL;
+    size_t count = 0;
+    size_t token_capacity = 0;
+    for (;;) {
+        Token token = lexer_next_token(&lexer);
+        if (token.type == TOKEN_EOF) {
+            token_free(&token);
+            break;
+        }
+        if (token.type == TOKEN_WHITESPACE || token.type == TOKEN_COMMENT ||
+            token.type == TOKEN_PREPROCESSOR || !token.text) {
+            token_free(&token);
+            continue;
+        }
+        if (count >= token_capacity) {
+            size_t new_capacity = token_capacity == 0 ? 256 : token_capacity * 2;
+            Token *new_tokens = realloc(tokens, new_capacity * sizeof(Token));
+            if (!new_tokens) {
+                token_free(&token);
+                break;
+            }
+            tokens = new_tokens;
+            token_capacity = new_capacity;
+        }
+        tokens[count++] = token;
+    }
+
+    size_t capacity = 0;
+    int depth = 0;
+    int parens = 0;
+    size_t i = 0;
+    while (i < count) {
+        const Token *token = &tokens[i];
+        /* "type name(" or "type *name(" at the top level */
+        if (depth == 0 && parens == 0 && token->type == TOKEN_IDENTIFIER && i > 0 && i + 1 < count &&
+            is_punctuation(&tokens[i + 1], '(') &&
+            (is_word(&tokens[i - 1]) || (tokens[i - 1].type == TOKEN_OPERATOR && tokens[i - 1].text[0] == '*'))) {
+            HeaderFunction_t function;
+            size_t next = parse_prototype(tokens, count, i, &function);
+            if (function.name) {
+                if (header->function_count >= capacity) {
+                    size_t new_capacity = capacity == 0 ? 16 : capacity * 2;
+                    HeaderFunction_t *new_functions = realloc(header->functions, new_capacity * sizeof(HeaderFunction_t));
+                    if (!new_functions) {
+                        free_function(&function);
+                        break;
+                    }
+                    header->functions = new_functions;
+                    capacity = new_capacity;
+                }
+                header->functions[header->function_count++] = function;
+            }
+            i = next;
+            continue;
+        }
+        if (is_punctuation(token, '{')) {
+            depth++;
+        } else if (is_punctuation(token, '}')) {
+            if (depth > 0) depth--;
+        } else if (depth == 0 && is_punctuation(token, '(')) {
+            parens++;
+        } else if (depth == 0 && is_punctuation(token, ')')) {
+            if (parens > 0) parens--;
+        }
+        i++;
+    }
+
+    for (size_t j = 0; j < count; j++) {
+        token_free(&tokens[j]);
+    }
+    free(tokens);
+    lexer_cleanup(&lexer);
+}
+
+/* Get the parsed header at path if it is unchanged since parsed (call under worker_lock) */
+static HeaderIndex_t *find_header(const char *path, uint64_t key, long long size, long long mtime_ns) {
+    size_t index = hash_table_get(&header_index, key);
+    if (index == HASH_TABLE_MISSING) {
+        return NULL;
+    }
+    HeaderIndex_t *entry = &headers[index];
+    if (strcmp(entry->path, path) != 0 || entry->size != size || entry->mtime_ns != mtime_ns) {
+        return NULL;
+    }
+    return entry;
+}
+
+/* Keep the declarations parsed from the header at path, replacing an outdated entry (call under worker_lock) */
+static void keep_header(const char *path, uint64_t key, HeaderIndex_t *parsed) {
+    size_t index = hash_table_get(&header_index, key);
+    if (index != HASH_TABLE_MISSING) {
+        if (strcmp(headers[index].path, path) != 0) {
+            free_declarations(parsed); /* Hash collision, leave the other header cached */
+            return;
+        }
+        free_declarations(&headers[index]);
+    } else {
+        if (header_count >= header_capacity) {
+            size_t new_capacity = header_capacity == 0 ? 16 : header_capacity * 2;
+            HeaderIndex_t *new_entries = realloc(headers, new_capacity * sizeof(HeaderIndex_t));
+            if (!new_entries) {
+                free_declarations(parsed);
+                return;
+            }
+            headers = new_entries;
+            header_capacity = new_capacity;
+        }
+        char *path_copy = strdup(path);
+        if (!path_copy || !hash_table_put(&header_index, key, header_count)) {
+            free(path_copy);
+            free_declarations(parsed);
+            return;
+        }
+        index = header_count++;
+        headers[index].path = path_copy;
+    }
+    char *kept_path = headers[index].path;
+    headers[index] = *parsed;
+    headers[index].path = kept_path;
+}
+
+/* Release the declarations parsed from imported headers (shared by every translation unit) */
+void transpiler_free_header_index(void) {
+    worker_lock();
+    for (size_t i = 0; i < header_count; i++) {
+        free(headers[i].path);
+        free_declarations(&headers[i]);
+    }
+    free(headers);
+    headers = NULL;
+    header_count = 0;
+    header_capacity = 0;
+    hash_table_free(&header_index);
+    worker_unlock();
+}
+
+/* Visit the declarations of a .cz.h header file, parsing it only
+ * the first time it is seen (or after it changed) in this process
+ * Returns 1 on success, 0 on failure
+ */
+static int visit_header(const char *source_filename, const char *header_path, HeaderVisitor visit, void *context) {
+    /* Construct full path to header file */
+    char full_path[1024];
+    const char *last_slash = strrchr(source_filename, '/');
+    if (last_slash) {
+        size_t dir_len = last_slash - source_filename + 1;
+        if (dir_len + strlen(header_path) + 1 > sizeof(full_path)) {
+            return 0;
+        }
+        memcpy(full_path, source_filename, dir_len);
+        strcpy(full_path + dir_len, header_path);
+    } else {
+        if (strlen(header_path) + 1 > sizeof(full_path)) {
+            return 0;
+        }
+        strcpy(full_path, header_path);
+    }
+
+    struct stat st;
+    if (stat(full_path, &st) != 0 || st.st_size == 0) {
+        return 0;
+    }
+    dependency_record(full_path, DEPENDENCY_READ);
+
+    /* Reuse the declarations parsed by an earlier translation unit if the header is unchanged */
+    uint64_t key = hash_key_string(full_path);
+    long long size = (long long)st.st_size;
+    long long mtime_ns = stat_mtime_ns(&st);
+    worker_lock();
+    HeaderIndex_t *cached = find_header(full_path, key, size, mtime_ns);
+    if (cached) {
+        visit(cached, context);
+    }
+    worker_unlock();
+    if (cached) {
+        return 1;
+    }
+
+    /* Map the header file (no size limit, nothing is copied) and parse it outside the lock */
+    InputFile_t input;
+    if (input_open(&input, full_path) != INPUT_OK) {
+        return 0;
+    }
+    HeaderIndex_t parsed;
+    memset(&parsed, 0, sizeof(parsed));
+    parsed.path = full_path;
+    parsed.size = size;
+    parsed.mtime_ns = mtime_ns;
+    scan_typedefs(&parsed, input.data);
+    scan_functions(&parsed, input.data, input.size);
+    input_close(&input);
+
+    worker_lock();
+    visit(&parsed, context);
+    keep_header(full_path, key, &parsed);
+    worker_unlock();
+    return 1;
+}
+
+/* Visit the header of every #import of ast: module.cz.h, or each .cz.h of a module directory.
+ * Headers are resolved next to source_filename and recorded as read (cz -MD). */
+void header_index_imports(ASTNode_t *ast, const char *source_filename, HeaderVisitor visit, void *context) {
+    if (!ast || ast->type != AST_TRANSLATION_UNIT || !source_filename) {
+        return;
+    }
+
+    for (size_t i = 0; i < ast->child_count; i++) {
+        if (ast->children[i]->type != AST_TOKEN) {
+            continue;
+        }
+
+        Token *t = &ast->children[i]->token;
+
+        /* Look for #import directives */
+        if (t->type == TOKEN_PREPROCESSOR && t->text &&
+            t->length >= 7 && strncmp(t->text, "#import", 7) == 0) {
+
+            /* Extract the module path from #import "path" */
+            const char *quote_start = strchr(t->text, '"');
+            if (!quote_start) continue;
+
+            const char *quote_end = strchr(quote_start + 1, '"');
+            if (!quote_end) continue;
+
+            size_t path_len = quote_end - quote_start - 1;
+            char module_path[512];
+            if (path_len >= sizeof(module_path)) continue;
+
+            memcpy(module_path, quote_start + 1, path_len);
+            module_path[path_len] = '\0';
+
+            /* Check if it's a directory or a single file */
+            /* Construct the full path to check */
+            char full_module_path[1024];
+            const char *last_slash = strrchr(source_filename, '/');
+            if (last_slash) {
+                size_t dir_len = last_slash - source_filename + 1;
+                if (dir_len + strlen(module_path) + 1 > sizeof(full_module_path)) continue;
+                memcpy(full_module_path, source_filename, dir_len);
+                strcpy(full_module_path + dir_len, module_path);
+            } else {
+                if (strlen(module_path) + 1 > sizeof(full_module_path)) continue;
+                strcpy(full_module_path, module_path);
+            }
+
+            struct stat st;
+            if (stat(full_module_path, &st) == 0 && S_ISDIR(st.st_mode)) {
+                /* It's a directory - visit the header of each of its .cz files (sorted, listed once per run) */
+                const DirListing_t *listing = dir_listing_cz(full_module_path);
+                for (size_t j = 0; listing && j < listing->count; j++) {
+                    /* Validate path length before constructing */
+                    size_t module_len = strlen(module_path);
+                    size_t name_len = strlen(listing->names[j]);
+                    if (module_len + 1 + name_len + 2 + 1 > MAX_PATH_LEN) {
+                        continue; /* Path too long, skip this file */
+                    }
+                    /* Visit this header file (module_path/name.cz.h) */
+                    char header_path[MAX_PATH_LEN];
+                    memcpy(header_path, module_path, module_len);
+                    header_path[module_len] = '/';
+                    memcpy(header_path + module_len + 1, listing->names[j], name_len);
+                    memcpy(header_path + module_len + 1 + name_len, ".h", 3);
+                    visit_header(source_filename, header_path, visit, context);
+                }
+            } else {
+                /* Validate path length before constructing */
+                if (strlen(module_path) + 5 + 1 > MAX_PATH_LEN) {
+                    continue; /* Path too long, skip */
+                }
+                /* Try single file: module_path.cz.h */
+                char header_path[MAX_PATH_LEN];
+                snprintf(header_path, sizeof(header_path), "%s.cz.h", module_path);
+                visit_header(source_filename, header_path, visit, context);
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Declarations of the .cz.h headers behind #import directives, parsed once per
+ * header and process (and again when it changes), shared by every translation
+ * unit and worker: struct typedefs for struct names, function prototypes for
+ * named arguments.
+ */
+
+#pragma once
+
+#include "../parser.h"
+#include <stddef.h>
+
+/* One parameter of a prototype (fields are NULL when not found, e.g. "int" alone) */
+typedef struct {
+    char *name;                  /* Parameter name */
+    char *type;                  /* Last type word before the name */
+} HeaderParam_t;
+
+/* One function prototype (or definition) of a header */
+typedef struct {
+    char *name;                  /* Function name */
+    HeaderParam_t *params;       /* Parameters in order */
+    size_t param_count;          /* Number of parameters (0 for "(void)") */
+} HeaderFunction_t;
+
+/* Declarations of one imported header */
+typedef struct {
+    char *path;                  /* Header path as resolved from the importing file */
+    long long size;              /* File size when parsed */
+    long long mtime_ns;          /* Modification time when parsed */
+    char **typedefs;             /* Base names X of each "typedef struct X_s { ... } X_t" */
+    size_t typedef_count;        /* Number of typedefs */
+    HeaderFunction_t *functions; /* Top-level function prototypes */
+    size_t function_count;       /* Number of functions */
+} HeaderIndex_t;
+
+/* Called with the declarations of one header (under worker_lock: don't keep pointers into it) */
+typedef void (*HeaderVisitor)(const HeaderIndex_t *header, void *context);
+
+/* Visit the header of every #import of ast: module.cz.h, or each .cz.h of a module directory.
+ * Headers are resolved next to source_filename and recorded as read (cz -MD). */
+void header_index_imports(ASTNode_t *ast, const char *source_filename, HeaderVisitor visit, void *context);
+
+/* Release the declarations parsed from imported headers (shared by every translation unit) */
+void transpiler_free_header_index(void);
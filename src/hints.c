@@ -0,0 +1,145 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Handles likely()/unlikely() branch hints and hot/cold function qualifiers.
+ * Transforms likely(x) into _CZ_LIKELY(x) and cold void f(void) into _CZ_COLD void f(void),
+ * the macros being __builtin_expect and __attribute__((hot/cold)) for GCC/Clang.
+ */
+
+#include "cz.h"
+#include "hints.h"
+#include <string.h>
+
+/* Hints used by the translation unit */
+#define HINT_BRANCH 1
+#define HINT_TEMPERATURE 2
+static CZ_THREAD_LOCAL int used_hints = 0;
+
+/* Hint macros (guarded: a source includes its header, amalgamations repeat it per file) */
+#define HINTS_CODE \
+    "#ifndef _CZ_HINTS\n" \
+    "#define _CZ_HINTS\n" \
+    "#if defined(__GNUC__)\n" \
+    "#define _CZ_LIKELY(x) __builtin_expect(!!(x), 1)\n" \
+    "#define _CZ_UNLIKELY(x) __builtin_expect(!!(x), 0)\n" \
+    "#define _CZ_HOT __attribute__((hot))\n" \
+    "#define _CZ_COLD __attribute__((cold))\n" \
+    "#elif defined(_MSC_VER)\n" \
+    "#define _CZ_LIKELY(x) (!!(x))\n" \
+    "#define _CZ_UNLIKELY(x) (!!(x))\n" \
+    "#define _CZ_HOT\n" \
+    "#define _CZ_COLD __declspec(noinline)\n" \
+    "#else\n" \
+    "#define _CZ_LIKELY(x) (!!(x))\n" \
+    "#define _CZ_UNLIKELY(x) (!!(x))\n" \
+    "#define _CZ_HOT\n" \
+    "#define _CZ_COLD\n" \
+    "#endif\n" \
+    "#endif\n"
+
+/* Check if token text matches */
+static int token_text_equals(Token *token, const char *text) {
+    return token && token->text && strcmp(token->text, text) == 0;
+}
+
+/* Check if the words from start lead to a function name and its '(' */
+static int is_function_declaration(ASTNode_t **children, size_t count, size_t start) {
+    int found_identifier = 0;
+    for (size_t i = start; i < count; i = ast_skip_trivia(children, count, i + 1)) {
+        Token *tok = &children[i]->token;
+        if (children[i]->type != AST_TOKEN || !tok->text) {
+            return 0;
+        }
+        if (tok->type == TOKEN_IDENTIFIER) {
+            found_identifier = 1;
+        } else if (tok->type == TOKEN_PUNCTUATION && strcmp(tok->text, "(") == 0) {
+            return found_identifier;
+        } else if (tok->type != TOKEN_KEYWORD && strcmp(tok->text, "*") != 0) {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+/* Check if the token before a hot/cold qualifier starts or continues the specifiers of a declaration */
+static int is_specifier_position(ASTNode_t **children, size_t index) {
+    size_t prev = ast_prev_significant(children, index);
+    if (prev == AST_NO_MATCH) {
+        return 1;
+    }
+    Token *tok = &children[prev]->token;
+    if (!tok->text || tok->type == TOKEN_PREPROCESSOR) {
+        return 1;
+    }
+    return strcmp(tok->text, ";") == 0 || strcmp(tok->text, "}") == 0 || strcmp(tok->text, "export") == 0 ||
+           strcmp(tok->text, "static") == 0 || strcmp(tok->text, "inline") == 0 || strcmp(tok->text, "extern") == 0 ||
+           (tok->type == TOKEN_KEYWORD && strstr(tok->text, "__attribute__"));
+}
+
+/* Check if the token before likely/unlikely allows a call there (not a declaration or member) */
+static int is_call_position(ASTNode_t **children, size_t index) {
+    size_t prev = ast_prev_significant(children, index);
+    if (prev == AST_NO_MATCH) {
+        return 0;
+    }
+    Token *tok = &children[prev]->token;
+    if (tok->type == TOKEN_IDENTIFIER || token_text_equals(tok, ".") || token_text_equals(tok, "->")) {
+        return 0;
+    }
+    return tok->type != TOKEN_KEYWORD || tok->symbol == SYM_RETURN;
+}
+
+/* Expand the likely/unlikely call or hot/cold qualifier at index, returns the last child index it consumed */
+size_t transpiler_visit_hints(ASTNode_t *ast, size_t index, ASTRewrite_t *rewrite) {
+    (void)rewrite;
+    ASTNode_t **children = ast->children;
+    if (children[index]->type != AST_TOKEN || children[index]->token.type != TOKEN_IDENTIFIER) {
+        return index;
+    }
+    Token *tok = &children[index]->token;
+    size_t next = ast_skip_trivia(children, ast->child_count, index + 1);
+    if (next >= ast->child_count || children[next]->type != AST_TOKEN) {
+        return index;
+    }
+
+    /* likely(expr) -> _CZ_LIKELY(expr) */
+    if (token_text_equals(tok, "likely") || token_text_equals(tok, "unlikely")) {
+        if (!token_text_equals(&children[next]->token, "(") || !is_call_position(children, index)) {
+            return index;
+        }
+        token_set_text(tok, tok->text[0] == 'l' ? "_CZ_LIKELY" : "_CZ_UNLIKELY");
+        used_hints |= HINT_BRANCH;
+        return index;
+    }
+
+    /* cold void f(void) -> _CZ_COLD void f(void) */
+    if (token_text_equals(tok, "hot") || token_text_equals(tok, "cold")) {
+        if (!is_specifier_position(children, index) || !is_function_declaration(children, ast->child_count, next)) {
+            return index;
+        }
+        token_set_text(tok, tok->text[0] == 'h' ? "_CZ_HOT" : "_CZ_COLD");
+        /* Treated as part of the function declaration, like #deprecated */
+        tok->type = TOKEN_KEYWORD;
+        used_hints |= HINT_TEMPERATURE;
+    }
+    return index;
+}
+
+/* Record that generated code calls _CZ_LIKELY or _CZ_UNLIKELY (e.g. cast fallbacks) */
+void hints_use_branch(void) {
+    used_hints |= HINT_BRANCH;
+}
+
+/* Emit the hint macros: for the header when functions carry hot/cold, for the source when any hint is used */
+void transpiler_emit_hint_helpers(OutputSink_t *output, bool header) {
+    if (header ? (used_hints & HINT_TEMPERATURE) : used_hints) {
+        sink_puts(output, HINTS_CODE);
+    }
+}
+
+/* Forget the hints used by the translation unit */
+void transpiler_free_hint_tables(void) {
+    used_hints = 0;
+}
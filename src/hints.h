@@ -0,0 +1,29 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Handles likely()/unlikely() branch hints and hot/cold function qualifiers.
+ * Both become _CZ_* macros emitted once per output, spelled for each compiler
+ * and empty where the compiler has no such hint.
+ */
+
+#pragma once
+
+#include "../parser.h"
+#include "../rewrite.h"
+#include "../sink.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Expand the likely/unlikely call or hot/cold qualifier at index, returns the last child index it consumed */
+size_t transpiler_visit_hints(ASTNode_t *ast, size_t index, ASTRewrite_t *rewrite);
+
+/* Record that generated code calls _CZ_LIKELY or _CZ_UNLIKELY (e.g. cast fallbacks) */
+void hints_use_branch(void);
+
+/* Emit the hint macros: for the header when functions carry hot/cold, for the source when any hint is used */
+void transpiler_emit_hint_helpers(OutputSink_t *output, bool header);
+
+/* Forget the hints used by the translation unit */
+void transpiler_free_hint_tables(void);
@@ -7,16 +7,41 @@
  * - if (condition) value1 else value2 -> (condition) ? value1 : value2
  * - Can be used in return statements: return if (cond) val1 else val2;
  * - Can be used in variable declarations: u8 i = if (cond) val1 else val2;
+ * - When both values are side-effect-free integer expressions (literals, integer
+ *   locals and parameters, non-overflowing arithmetic), including nested
+ *   if-expression chains, they are lowered to a branchless mask select instead:
+ *   ((-!!(condition) & ((value1) ^ (value2))) ^ (value2))
+ *   where nested if-expressions use ((-!!(c) & (value1)) | (-!(c) & (value2)))
  */
 
 #include "cz.h"
 #include "ifexpr.h"
+#include "scopes.h"
 #include "../transpiler.h"
+#include "../rewrite.h"
+#include "../sink.h"
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
+/* Kinds of scalars bound in ifexpr_scopes (anything else is bound to SCALAR_OTHER) */
+#define SCALAR_OTHER 0       /* Not an integer, or not known to be one */
+#define SCALAR_INTEGER 1     /* Integer whose arithmetic may overflow (signed, or promoted to int) */
+#define SCALAR_WRAPPING 2    /* Unsigned integer at least as wide as int (arithmetic wraps) */
+
+/* Scalar kinds of parameters and locals in the open blocks */
+static CZ_THREAD_LOCAL ScopeTable_t ifexpr_scopes;
+
+/* Positions of the parts of "if ( condition ) value1 else value2" */
+typedef struct {
+    size_t open;             /* '(' of the condition */
+    size_t close;            /* ')' of the condition */
+    size_t else_pos;         /* 'else' keyword */
+    size_t end;              /* First token after value2 (';', ',' or closing bracket) */
+} IfExpression_t;
+
 /* Helper: Check if token text matches */
 static int token_text_equals(Token *token, const char *text) {
     if (!token || !token->text || !text) {
@@ -25,192 +50,496 @@ static int token_text_equals(Token *token, const char *text) {
     return strcmp(token->text, text) == 0;
 }
 
-/* Helper: Skip whitespace and comment tokens */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t start) {
-    while (start < count && children[start]->type == AST_TOKEN) {
-        Token *t = &children[start]->token;
-        if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT) {
-            start++;
-        } else {
-            break;
-        }
-    }
-    return start;
+/* Check if a child is the 'if' keyword */
+static bool is_if(ASTNode_t **children, size_t index) {
+    Token *token = &children[index]->token;
+    return children[index]->type == AST_TOKEN &&
+           (token->type == TOKEN_IDENTIFIER || token->type == TOKEN_KEYWORD) && token_text_equals(token, "if");
 }
 
-/* Transform if-expressions to ternary operators */
-void transpiler_transform_ifexpr(ASTNode_t *ast) {
-    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
-        return;
+/* Match "if ( condition ) value1 else value2" at index (value1 must not be a '{' block) */
+static bool match_ifexpr(ASTNode_t **children, size_t count, size_t index, IfExpression_t *expression) {
+    if (!is_if(children, index)) {
+        return false;
     }
 
-    ASTNode_t **children = ast->children;
-    size_t count = ast->child_count;
+    /* Expect '(' */
+    size_t j = ast_skip_trivia(children, count, index + 1);
+    if (j >= count || children[j]->type != AST_TOKEN ||
+        children[j]->token.type != TOKEN_PUNCTUATION ||
+        !token_text_equals(&children[j]->token, "(")) {
+        return false;
+    }
+    expression->open = j;
 
-    /* Look for pattern: if ( condition ) value else value2 */
-    for (size_t i = 0; i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
+    /* Find matching ')' for the condition */
+    int paren_depth = 1;
+    j = ast_skip_trivia(children, count, j + 1);
+    while (j < count && paren_depth > 0) {
+        if (children[j]->type == AST_TOKEN) {
+            Token *t = &children[j]->token;
+            if (t->type == TOKEN_PUNCTUATION) {
+                if (token_text_equals(t, "(")) {
+                    paren_depth++;
+                } else if (token_text_equals(t, ")")) {
+                    paren_depth--;
+                    if (paren_depth == 0) {
+                        break;
+                    }
+                }
+            }
+        }
+        j++;
+    }
+    if (j >= count) {
+        return false; /* Couldn't find closing paren */
+    }
+    expression->close = j;
 
-        Token *token = &children[i]->token;
+    /* Followed by '{', it's a regular if statement, not an if-expression */
+    j = ast_skip_trivia(children, count, j + 1);
+    if (j < count && children[j]->type == AST_TOKEN &&
+        children[j]->token.type == TOKEN_PUNCTUATION &&
+        token_text_equals(&children[j]->token, "{")) {
+        return false;
+    }
 
-        /* Look for 'if' keyword that's not followed by a statement block */
-        if ((token->type == TOKEN_IDENTIFIER || token->type == TOKEN_KEYWORD) && 
-            token_text_equals(token, "if")) {
-            
-            /* Skip whitespace */
-            size_t j = skip_whitespace(children, count, i + 1);
-
-            /* Expect '(' */
-            if (j >= count || children[j]->type != AST_TOKEN ||
-                children[j]->token.type != TOKEN_PUNCTUATION ||
-                !token_text_equals(&children[j]->token, "(")) {
-                continue;
-            }
+    /* Collect tokens until 'else' at depth 0, or ';' (no else: a regular if statement) */
+    size_t else_pos = 0;
+    int depth = 0;
+    while (j < count) {
+        if (children[j]->type == AST_TOKEN) {
+            Token *t = &children[j]->token;
 
-            /* Find matching ')' for the condition */
-            int paren_depth = 1;
-            j = skip_whitespace(children, count, j + 1);
-            
-            while (j < count && paren_depth > 0) {
-                if (children[j]->type == AST_TOKEN) {
-                    Token *t = &children[j]->token;
-                    if (t->type == TOKEN_PUNCTUATION) {
-                        if (token_text_equals(t, "(")) {
-                            paren_depth++;
-                        } else if (token_text_equals(t, ")")) {
-                            paren_depth--;
-                            if (paren_depth == 0) {
-                                break;
-                            }
-                        }
-                    }
+            /* Track depth for nested expressions */
+            if (t->type == TOKEN_PUNCTUATION) {
+                if (token_text_equals(t, "(") || token_text_equals(t, "{") || token_text_equals(t, "[")) {
+                    depth++;
+                } else if (token_text_equals(t, ")") || token_text_equals(t, "}") || token_text_equals(t, "]")) {
+                    depth--;
+                } else if (token_text_equals(t, ";") && depth == 0) {
+                    break;
                 }
-                j++;
             }
 
-            if (j >= count) {
-                continue; /* Couldn't find closing paren */
+            if (depth == 0 && (t->type == TOKEN_IDENTIFIER || t->type == TOKEN_KEYWORD) &&
+                token_text_equals(t, "else")) {
+                else_pos = j;
+                break;
             }
-            size_t close_paren = j;
-
-            /* Skip whitespace after ')' */
-            j = skip_whitespace(children, count, j + 1);
+        }
+        j++;
+    }
+    if (else_pos == 0) {
+        return false;
+    }
+    expression->else_pos = else_pos;
 
-            /* Check if this is followed by '{' - if so, it's a regular if statement, not an if-expression */
-            if (j < count && children[j]->type == AST_TOKEN &&
-                children[j]->token.type == TOKEN_PUNCTUATION &&
-                token_text_equals(&children[j]->token, "{")) {
-                continue; /* This is a regular if statement */
-            }
+    /* Followed by '{', 'else' belongs to a regular if statement */
+    j = ast_skip_trivia(children, count, else_pos + 1);
+    if (j < count && children[j]->type == AST_TOKEN &&
+        children[j]->token.type == TOKEN_PUNCTUATION &&
+        token_text_equals(&children[j]->token, "{")) {
+        return false;
+    }
 
-            /* Now we need to find the 'else' keyword to confirm this is an if-expression */
-            /* First, collect tokens until we find 'else' or ';' or '{' */
-            size_t true_value_start = j;
-            size_t else_pos = 0;
-            int depth = 0;
-
-            while (j < count) {
-                if (children[j]->type == AST_TOKEN) {
-                    Token *t = &children[j]->token;
-                    
-                    /* Track depth for nested expressions */
-                    if (t->type == TOKEN_PUNCTUATION) {
-                        if (token_text_equals(t, "(") || token_text_equals(t, "{") || token_text_equals(t, "[")) {
-                            depth++;
-                        } else if (token_text_equals(t, ")") || token_text_equals(t, "}") || token_text_equals(t, "]")) {
-                            depth--;
-                        } else if (token_text_equals(t, ";") && depth == 0) {
-                            /* End of statement without else - not an if-expression */
-                            break;
-                        }
-                    }
-                    
-                    /* Look for 'else' keyword at depth 0 */
-                    if (depth == 0 && (t->type == TOKEN_IDENTIFIER || t->type == TOKEN_KEYWORD) && 
-                        token_text_equals(t, "else")) {
-                        else_pos = j;
+    /* The false value runs until ';' or ',' or an unmatched closing bracket */
+    depth = 0;
+    while (j < count) {
+        if (children[j]->type == AST_TOKEN) {
+            Token *t = &children[j]->token;
+            if (t->type == TOKEN_PUNCTUATION) {
+                if (token_text_equals(t, "(") || token_text_equals(t, "{") || token_text_equals(t, "[")) {
+                    depth++;
+                } else if (token_text_equals(t, ")") || token_text_equals(t, "}") || token_text_equals(t, "]")) {
+                    if (depth == 0) {
                         break;
                     }
+                    depth--;
+                } else if ((token_text_equals(t, ";") || token_text_equals(t, ",")) && depth == 0) {
+                    break;
                 }
-                j++;
             }
+        }
+        j++;
+    }
+    expression->end = j;
+    return true;
+}
 
-            if (else_pos == 0) {
-                continue; /* No 'else' found - this is a regular if statement */
+/* Get the scalar kind of a declared type word */
+static size_t get_scalar_kind(const char *type) {
+    static const char *wrapping[] = {
+        "u32", "u64", "usize", "uint32_t", "uint64_t", "size_t", "unsigned", NULL
+    };
+    static const char *integer[] = {
+        "u8", "u16", "i8", "i16", "i32", "i64", "isize", "uint8_t", "uint16_t", "int8_t", "int16_t",
+        "int32_t", "int64_t", "ptrdiff_t", "char", "short", "int", "long", "signed", "bool", "_Bool", NULL
+    };
+    if (!type) {
+        return SCALAR_OTHER;
+    }
+    for (size_t k = 0; wrapping[k]; k++) {
+        if (strcmp(type, wrapping[k]) == 0) return SCALAR_WRAPPING;
+    }
+    for (size_t k = 0; integer[k]; k++) {
+        if (strcmp(type, integer[k]) == 0) return SCALAR_INTEGER;
+    }
+    return SCALAR_OTHER;
+}
+
+/* Bind the declared local to its scalar kind (pointers and arrays are not scalars) */
+static void track_declaration(ASTNode_t **children, size_t count, const ScopeDeclaration_t *declaration) {
+    size_t next = ast_skip_trivia(children, count, declaration->name + 1);
+    int array = next < count && children[next]->type == AST_TOKEN &&
+                token_text_equals(&children[next]->token, "[");
+    size_t kind = declaration->pointer || array ? SCALAR_OTHER
+                                                : get_scalar_kind(children[declaration->type]->token.text);
+    scope_bind(&ifexpr_scopes, cz_token_symbol(&children[declaration->name]->token), kind);
+}
+
+/* Shadow the name declared (or assigned) by a for-init clause, its kind is not tracked */
+static void track_for_init(ASTNode_t **children, size_t count, size_t for_idx) {
+    size_t open = ast_skip_trivia(children, count, for_idx + 1);
+    if (open >= count || children[open]->type != AST_TOKEN || !token_text_equals(&children[open]->token, "(")) {
+        return;
+    }
+    size_t last_identifier = AST_NO_MATCH;
+    for (size_t k = open + 1; k < count && children[k]->type == AST_TOKEN; k++) {
+        Token *t = &children[k]->token;
+        if (t->type == TOKEN_IDENTIFIER) {
+            last_identifier = k;
+        } else if (token_text_equals(t, "=") || token_text_equals(t, ";") || token_text_equals(t, ",") ||
+                   token_text_equals(t, ")")) {
+            break;
+        }
+    }
+    if (last_identifier != AST_NO_MATCH) {
+        scope_bind(&ifexpr_scopes, cz_token_symbol(&children[last_identifier]->token), SCALAR_OTHER);
+    }
+}
+
+/* Bind the parameters of the function whose body opens at index (call after pushing the body block) */
+static void track_parameters(ASTNode_t *ast, size_t body) {
+    ASTNode_t **children = ast->children;
+    size_t close = ast_prev_significant(children, body);
+    if (close == AST_NO_MATCH || !token_text_equals(&children[close]->token, ")")) {
+        return;
+    }
+    size_t open = ast_match(ast, close);
+    if (open == AST_NO_MATCH) {
+        return;
+    }
+
+    /* Each "type [*] name" between commas, function pointers and arrays are not scalars */
+    size_t type = AST_NO_MATCH;
+    size_t name = AST_NO_MATCH;
+    bool scalar = true;
+    int depth = 0;
+    for (size_t k = open + 1; k <= close; k++) {
+        Token *t = &children[k]->token;
+        if (children[k]->type != AST_TOKEN || t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT ||
+            !t->text || t->text[0] == '\0') {
+            continue;
+        }
+        if (k == close || (depth == 0 && token_text_equals(t, ","))) {
+            if (name != AST_NO_MATCH && children[name]->token.type == TOKEN_IDENTIFIER) {
+                size_t kind = scalar && type != AST_NO_MATCH ? get_scalar_kind(children[type]->token.text)
+                                                             : SCALAR_OTHER;
+                scope_bind(&ifexpr_scopes, cz_token_symbol(&children[name]->token), kind);
             }
+            type = AST_NO_MATCH;
+            name = AST_NO_MATCH;
+            scalar = true;
+        } else if (t->type == TOKEN_PUNCTUATION && strchr("([", t->text[0])) {
+            depth++;
+            scalar = false;
+        } else if (t->type == TOKEN_PUNCTUATION && strchr(")]", t->text[0])) {
+            depth--;
+        } else if (depth == 0 && (t->type == TOKEN_IDENTIFIER || t->type == TOKEN_KEYWORD)) {
+            type = name;
+            name = k;
+        } else if (depth == 0 && t->text[0] == '*') {
+            scalar = false;
+        }
+    }
+}
+
+/* Release the scalar kinds tracked for if-expressions */
+void transpiler_free_ifexpr_tables(void) {
+    scope_free(&ifexpr_scopes);
+}
 
-            size_t true_value_end = else_pos;
+/* Get the bytes held by the scalar kinds tracked for if-expressions (cz --stats) */
+size_t transpiler_ifexpr_table_bytes(void) {
+    return scope_bytes(&ifexpr_scopes);
+}
 
-            /* Skip whitespace after 'else' */
-            j = skip_whitespace(children, count, else_pos + 1);
+/* Check if a number token is an integer literal (not a floating constant) */
+static bool is_integer_literal(const Token *token) {
+    const char *text = token->text;
+    if (!isdigit((unsigned char)text[0]) || strchr(text, '.')) {
+        return false;
+    }
+    bool hex = text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+    return hex ? !strpbrk(text, "pP") : !strpbrk(text, "eEfF");
+}
 
-            /* Check if 'else' is followed by '{' - if so, it's a regular if statement */
-            if (j < count && children[j]->type == AST_TOKEN &&
-                children[j]->token.type == TOKEN_PUNCTUATION &&
-                token_text_equals(&children[j]->token, "{")) {
-                continue; /* This is a regular if statement */
+static bool check_scalar_ifexpr(ASTNode_t **children, size_t count, const IfExpression_t *expression);
+
+/* Check that [start, end) is a non-empty, side-effect-free and non-trapping integer expression */
+static bool check_scalar(ASTNode_t **children, size_t count, size_t start, size_t end) {
+    bool operand = true;     /* The next token starts an operand (so '-', '&' or '*' are unary) */
+    bool empty = true;
+    bool arithmetic = false; /* Uses '+', '-' or '*' on more than a literal */
+    bool overflows = false;  /* Uses an integer whose arithmetic may overflow */
+    for (size_t k = start; k < end; k++) {
+        Token *t = &children[k]->token;
+        if (children[k]->type != AST_TOKEN) {
+            return false;
+        }
+        if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT || !t->text || t->text[0] == '\0') {
+            continue;
+        }
+        empty = false;
+
+        if (is_if(children, k)) {
+            /* Nested if-expressions must be candidates themselves and fit in this value */
+            IfExpression_t nested;
+            if (!operand || !match_ifexpr(children, count, k, &nested) || nested.end > end ||
+                !check_scalar_ifexpr(children, count, &nested)) {
+                return false;
             }
+            k = nested.end - 1;
+            operand = false;
+            continue;
+        }
 
-            /* Collect false value tokens until ';' or ',' or ')' or end */
-            depth = 0;
-
-            while (j < count) {
-                if (children[j]->type == AST_TOKEN) {
-                    Token *t = &children[j]->token;
-                    
-                    if (t->type == TOKEN_PUNCTUATION) {
-                        if (token_text_equals(t, "(") || token_text_equals(t, "{") || token_text_equals(t, "[")) {
-                            depth++;
-                        } else if (token_text_equals(t, ")") || token_text_equals(t, "}") || token_text_equals(t, "]")) {
-                            if (depth == 0) {
-                                /* End of false value */
-                                break;
-                            }
-                            depth--;
-                        } else if ((token_text_equals(t, ";") || token_text_equals(t, ",")) && depth == 0) {
-                            /* End of false value */
-                            break;
-                        }
+        switch (t->type) {
+            case TOKEN_NUMBER:
+                if (!operand || !is_integer_literal(t)) return false;
+                operand = false;
+                break;
+            case TOKEN_CHAR:
+                if (!operand) return false;
+                operand = false;
+                break;
+            case TOKEN_IDENTIFIER: {
+                size_t kind = scope_lookup(&ifexpr_scopes, cz_token_symbol(t));
+                if (!operand || kind == HASH_TABLE_MISSING || kind == SCALAR_OTHER) return false;
+                if (kind == SCALAR_INTEGER) overflows = true;
+                operand = false;
+                break;
+            }
+            case TOKEN_PUNCTUATION:
+                if (token_text_equals(t, "(") && operand) {
+                    break;
+                }
+                if (token_text_equals(t, ")") && !operand) {
+                    break;
+                }
+                return false;
+            case TOKEN_OPERATOR:
+                if (token_text_equals(t, "-") || token_text_equals(t, "+") ||
+                    (token_text_equals(t, "*") && !operand)) {
+                    /* A sign in front of a literal is part of the constant */
+                    size_t next = ast_skip_trivia(children, end, k + 1);
+                    if (!operand || next >= end || children[next]->token.type != TOKEN_NUMBER) {
+                        arithmetic = true;
                     }
+                    operand = true;
+                } else if (token_text_equals(t, "~") || token_text_equals(t, "!")) {
+                    if (!operand) return false;
+                } else if (!operand &&
+                           (token_text_equals(t, "&") || token_text_equals(t, "|") || token_text_equals(t, "^") ||
+                            token_text_equals(t, "==") || token_text_equals(t, "!=") ||
+                            token_text_equals(t, "<") || token_text_equals(t, ">") ||
+                            token_text_equals(t, "<=") || token_text_equals(t, ">=") ||
+                            token_text_equals(t, "&&") || token_text_equals(t, "||"))) {
+                    operand = true;
+                } else {
+                    /* Division and shifts may trap, assignments and address-of have effects */
+                    return false;
                 }
-                j++;
-            }
+                break;
+            default:
+                return false;
+        }
+    }
+    return !empty && !operand && !(arithmetic && overflows);
+}
 
-            /* Now we have all the pieces, transform the if-expression to ternary */
-            /* Pattern: if ( condition ) true_value else false_value
-             * Becomes: ( condition ) ? true_value : false_value
-             */
-
-            /* Remove 'if' keyword by setting it to empty */
-            free(children[i]->token.text);
-            children[i]->token.text = strdup("");
-            children[i]->token.length = 0;
-
-            /* '(' stays as '(' */
-            /* condition tokens stay as-is */
-            /* ')' at close_paren stays as ')' */
-
-            /* Insert '?' after the condition */
-            /* Find first non-whitespace token in true_value */
-            size_t first_true_token = skip_whitespace(children, count, true_value_start);
-            
-            if (first_true_token < true_value_end && first_true_token > close_paren) {
-                /* Prepend '?' to the first true value token */
-                Token *first_t = &children[first_true_token]->token;
-                char *new_text = malloc(first_t->length + 4); /* +4 for " ? " + null */
-                if (new_text) {
-                    snprintf(new_text, first_t->length + 4, " ? %s", first_t->text);
-                    free(first_t->text);
-                    first_t->text = new_text;
-                    first_t->length = strlen(new_text);
-                }
+/* Check a nested if-expression: condition and both values are evaluated unconditionally */
+static bool check_scalar_ifexpr(ASTNode_t **children, size_t count, const IfExpression_t *expression) {
+    return check_scalar(children, count, expression->open + 1, expression->close) &&
+           check_scalar(children, count, expression->close + 1, expression->else_pos) &&
+           check_scalar(children, count, expression->else_pos + 1, expression->end);
+}
+
+static void append_select(ASTNode_t **children, size_t count, const IfExpression_t *expression, OutputSink_t *out);
+
+/* Append [start, end) on one line, nested if-expressions as selects */
+static void append_scalar(ASTNode_t **children, size_t count, size_t start, size_t end, OutputSink_t *out) {
+    bool space = false;
+    bool first = true;
+    for (size_t k = start; k < end; k++) {
+        Token *t = &children[k]->token;
+        if (t->type == TOKEN_WHITESPACE || t->type == TOKEN_COMMENT || !t->text || t->text[0] == '\0') {
+            space = !first;
+            continue;
+        }
+        if (space) {
+            sink_putc(out, ' ');
+        }
+        space = false;
+        first = false;
+
+        IfExpression_t nested;
+        if (is_if(children, k) && match_ifexpr(children, count, k, &nested)) {
+            append_select(children, count, &nested, out);
+            k = nested.end - 1;
+        } else {
+            sink_write(out, t->text, t->length);
+        }
+    }
+}
+
+/* Append "((-!!(condition) & (value1)) | (-!(condition) & (value2)))" for a nested if-expression.
+ * Its condition is pure, so repeating it keeps the text of long chains linear. */
+static void append_select(ASTNode_t **children, size_t count, const IfExpression_t *expression, OutputSink_t *out) {
+    sink_puts(out, "((-!!(");
+    append_scalar(children, count, expression->open + 1, expression->close, out);
+    sink_puts(out, ") & (");
+    append_scalar(children, count, expression->close + 1, expression->else_pos, out);
+    sink_puts(out, ")) | (-!(");
+    append_scalar(children, count, expression->open + 1, expression->close, out);
+    sink_puts(out, ") & (");
+    append_scalar(children, count, expression->else_pos + 1, expression->end, out);
+    sink_puts(out, ")))");
+}
+
+/* Append " & ((value1) ^ (value2))) ^ (value2))" */
+static void append_values(ASTNode_t **children, size_t count, const IfExpression_t *expression, OutputSink_t *out) {
+    sink_puts(out, " & ((");
+    append_scalar(children, count, expression->close + 1, expression->else_pos, out);
+    sink_puts(out, ") ^ (");
+    append_scalar(children, count, expression->else_pos + 1, expression->end, out);
+    sink_puts(out, "))) ^ (");
+    append_scalar(children, count, expression->else_pos + 1, expression->end, out);
+    sink_puts(out, "))");
+}
+
+/* Lower an if-expression whose values are scalar to a branchless select, returns false to leave it */
+static bool lower_branchless(ASTNode_t **children, size_t count, size_t index) {
+    IfExpression_t expression;
+    if (!match_ifexpr(children, count, index, &expression)) {
+        return false;
+    }
+
+    /* The condition stays in place (it is evaluated once, and later features may rewrite it) */
+    for (size_t k = expression.open + 1; k < expression.close; k++) {
+        if (children[k]->type != AST_TOKEN || is_if(children, k) ||
+            children[k]->token.type == TOKEN_PREPROCESSOR) {
+            return false;
+        }
+    }
+
+    /* Both values are evaluated, so they must not trap, overflow or have effects */
+    if (!check_scalar(children, count, expression.close + 1, expression.else_pos) ||
+        !check_scalar(children, count, expression.else_pos + 1, expression.end)) {
+        return false;
+    }
+
+    OutputSink_t sink;
+    sink_init(&sink, NULL);
+    append_values(children, count, &expression, &sink);
+    char *values = sink_take(&sink);
+    if (!values) {
+        return false;
+    }
+
+    /* "if (c) a else b" -> "((-!!(c) & ((a) ^ (b))) ^ (b))" */
+    token_set_text(&children[index]->token, "((-!!");
+    ast_clear_range(children, expression.close + 1, expression.end);
+    token_take_text(&children[expression.else_pos]->token, values);
+    children[expression.else_pos]->token.type = TOKEN_OPERATOR;
+    return true;
+}
+
+/* Lower scalar if-expressions to branchless selects, tracking the kinds of locals per block */
+static void transform_branchless(ASTNode_t *ast) {
+    scope_clear(&ifexpr_scopes);
+    for (size_t i = 0; i < ast->child_count; i++) {
+        ASTNode_t **children = ast->children;
+        size_t count = ast->child_count;
+        if (children[i]->type != AST_TOKEN) continue;
+
+        Token *token = &children[i]->token;
+        if (token->type == TOKEN_PUNCTUATION && token_text_equals(token, "{")) {
+            scope_push(&ifexpr_scopes, 0);
+            if (ifexpr_scopes.depth == 1) {
+                track_parameters(ast, i);
             }
+            continue;
+        }
+        if (token->type == TOKEN_PUNCTUATION && token_text_equals(token, "}")) {
+            scope_pop(&ifexpr_scopes);
+            continue;
+        }
+        if (ifexpr_scopes.depth == 0) {
+            continue;
+        }
 
-            /* Replace 'else' with ' : ' */
-            free(children[else_pos]->token.text);
-            children[else_pos]->token.text = strdup(" : ");
-            children[else_pos]->token.length = 3;
-            children[else_pos]->token.type = TOKEN_OPERATOR;
+        ScopeDeclaration_t declaration;
+        if (scope_match_declaration(children, count, i, &declaration)) {
+            track_declaration(children, count, &declaration);
+        } else if (token->type == TOKEN_KEYWORD && token->symbol == SYM_FOR) {
+            track_for_init(children, count, i);
+        } else if (is_if(children, i)) {
+            lower_branchless(children, count, i);
         }
     }
 }
+
+/* Transform if-expressions to branchless selects or ternary operators in AST */
+void transpiler_transform_ifexpr(ASTNode_t *ast) {
+    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
+        return;
+    }
+
+    /* Scalar values first, so their chains are lowered as a whole */
+    transform_branchless(ast);
+
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+
+    /* Look for pattern: if ( condition ) value else value2 */
+    for (size_t i = 0; i < count; i++) {
+        IfExpression_t expression;
+        if (children[i]->type != AST_TOKEN || !match_ifexpr(children, count, i, &expression)) {
+            continue;
+        }
+
+        /* Pattern: if ( condition ) true_value else false_value
+         * Becomes: ( condition ) ? true_value : false_value
+         */
+
+        /* Remove 'if' keyword by setting it to empty */
+        token_set_text(&children[i]->token, "");
+
+        /* Prepend '?' to the first true value token */
+        size_t first_true_token = ast_skip_trivia(children, count, expression.close + 1);
+        if (first_true_token < expression.else_pos) {
+            Token *first_t = &children[first_true_token]->token;
+            char *new_text = malloc(first_t->length + 4); /* +4 for " ? " + null */
+            if (new_text) {
+                snprintf(new_text, first_t->length + 4, " ? %s", first_t->text);
+                token_take_text(first_t, new_text);
+            }
+        }
+
+        /* Replace 'else' with ' : ' */
+        token_set_text(&children[expression.else_pos]->token, " : ");
+        children[expression.else_pos]->token.type = TOKEN_OPERATOR;
+    }
+}
@@ -10,5 +10,11 @@
 
 #include "../parser.h"
 
-/* Transform if-expressions to ternary operators in AST */
+/* Transform if-expressions to branchless selects (scalar values) or ternary operators in AST */
 void transpiler_transform_ifexpr(ASTNode_t *ast);
+
+/* Release the scalar kinds tracked for if-expressions */
+void transpiler_free_ifexpr_tables(void);
+
+/* Get the bytes held by the scalar kinds tracked for if-expressions (cz --stats) */
+size_t transpiler_ifexpr_table_bytes(void);
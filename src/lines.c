@@ -0,0 +1,135 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Line-start offsets of a translation unit for constant-time diagnostics.
+ */
+
+#include "cz.h"
+#include "lines.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+/* Table used by cz_error/cz_warning (NULL when no translation unit is active) */
+CZ_THREAD_LOCAL const LineTable_t *g_lines = NULL;
+
+/* Record the line starts of source in one pass */
+void line_table_build(LineTable_t *table, const char *source) {
+    table->source = source;
+    table->starts = NULL;
+    table->count = 0;
+    if (!source) {
+        return;
+    }
+
+    size_t capacity = 256;
+    size_t *starts = malloc(capacity * sizeof(size_t));
+    if (!starts) {
+        return; /* Lookups fall back to scanning */
+    }
+
+    starts[table->count++] = 0;
+    for (const char *p = source; (p = strchr(p, '\n')) != NULL; p++) {
+        if (table->count >= capacity) {
+            size_t *new_starts = realloc(starts, capacity * 2 * sizeof(size_t));
+            if (!new_starts) {
+                free(starts);
+                table->count = 0;
+                return;
+            }
+            starts = new_starts;
+            capacity *= 2;
+        }
+        starts[table->count++] = (size_t)(p + 1 - source);
+    }
+    table->starts = starts;
+}
+
+/* Release the offsets (and deactivate the table if it was g_lines) */
+void line_table_free(LineTable_t *table) {
+    if (!table) {
+        return;
+    }
+    if (g_lines == table) {
+        g_lines = NULL;
+    }
+    free(table->starts);
+    table->starts = NULL;
+    table->count = 0;
+}
+
+/* Find line_num (1-based) in source, returns its start and sets length (NULL if out of range) */
+const char *source_line(const char *source, int line_num, size_t *length) {
+    if (!source || line_num < 1) {
+        return NULL;
+    }
+
+    const char *line_start = NULL;
+    if (g_lines && g_lines->source == source && g_lines->starts) {
+        /* Constant-time lookup in the active translation unit */
+        if ((size_t)line_num > g_lines->count) {
+            return NULL;
+        }
+        line_start = source + g_lines->starts[line_num - 1];
+    } else {
+        /* Other buffers are scanned from the start */
+        line_start = source;
+        for (int current_line = 1; current_line < line_num; current_line++) {
+            line_start = strchr(line_start, '\n');
+            if (!line_start) {
+                return NULL;
+            }
+            line_start++;
+        }
+    }
+
+    if (!*line_start) {
+        return NULL;
+    }
+
+    const char *line_end = line_start;
+    while (*line_end && *line_end != '\n' && *line_end != '\r') {
+        line_end++;
+    }
+    *length = (size_t)(line_end - line_start);
+    return line_start;
+}
+
+/* Longest source line shown in a diagnostic */
+#define MAX_SHOWN_LINE 511
+
+/* Print line_num of source (leading whitespace trimmed), with a caret under column when known */
+void print_source_line(FILE *output, const char *source, int line_num, int column) {
+    size_t length = 0;
+    const char *line = source_line(source, line_num, &length);
+    if (!line) {
+        return;
+    }
+
+    /* Trim leading whitespace for display */
+    size_t lead = 0;
+    while (lead < length && isspace((unsigned char)line[lead])) {
+        lead++;
+    }
+    if (lead == length) {
+        return;
+    }
+
+    size_t shown = length - lead;
+    if (shown > MAX_SHOWN_LINE) {
+        shown = MAX_SHOWN_LINE;
+    }
+    fprintf(output, "    > %.*s\n", (int)shown, line + lead);
+
+    /* Columns are 1-based, 0 means unknown (e.g. tokens created by a rewrite) */
+    size_t offset = column > 0 ? (size_t)(column - 1) : 0;
+    if (column <= 0 || offset < lead || offset - lead >= shown) {
+        return;
+    }
+    fputs("      ", output);
+    for (size_t i = lead; i < offset; i++) {
+        fputc(line[i] == '\t' ? '\t' : ' ', output);
+    }
+    fputs("^\n", output);
+}
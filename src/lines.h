@@ -0,0 +1,35 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Line-start offsets of a translation unit for constant-time diagnostics.
+ */
+
+#pragma once
+
+#include "../worker.h"
+#include <stddef.h>
+#include <stdio.h>
+
+/* Offsets of every line start in a source buffer */
+typedef struct {
+    const char *source;     /* Source the offsets refer to */
+    size_t *starts;         /* Offset of line n + 1 at index n */
+    size_t count;           /* Number of lines */
+} LineTable_t;
+
+/* Table used by cz_error/cz_warning (NULL when no translation unit is active) */
+extern CZ_THREAD_LOCAL const LineTable_t *g_lines;
+
+/* Record the line starts of source in one pass */
+void line_table_build(LineTable_t *table, const char *source);
+
+/* Release the offsets (and deactivate the table if it was g_lines) */
+void line_table_free(LineTable_t *table);
+
+/* Find line_num (1-based) in source, returns its start and sets length (NULL if out of range) */
+const char *source_line(const char *source, int line_num, size_t *length);
+
+/* Print line_num of source (leading whitespace trimmed), with a caret under column when known */
+void print_source_line(FILE *output, const char *source, int line_num, int column);
@@ -11,146 +11,106 @@
 
 #include "cz.h"
 #include "methods.h"
-#include "warnings.h"
+#include "../rewrite.h"
+#include "../hashtable.h"
+#include "scopes.h"
+#include "../siblings.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
 
-/* Maximum number of methods we can track */
-#define MAX_METHODS 256
-
-/* Maximum number of struct types we can track */
-#define MAX_STRUCT_TYPES 128
-
-/* Tracked method information */
-typedef struct {
-    char *struct_name;  /* e.g., "Vec2" */
-    char *method_name;  /* e.g., "length" */
-} MethodInfo;
-
 /* Tracked struct type information */
 typedef struct {
-    char *name;  /* struct type name */
+    int name;           /* struct type name */
 } StructType;
 
-/* Global state for tracking methods and struct types */
-static MethodInfo methods[MAX_METHODS];
-static size_t method_count = 0;
-static StructType struct_types[MAX_STRUCT_TYPES];
-static size_t struct_type_count = 0;
+/* Global state for tracking methods and struct types (names are symbol IDs from the shared interner) */
+static CZ_THREAD_LOCAL HashTable_t methods;             /* (struct name, method name) pairs */
+static CZ_THREAD_LOCAL StructType *struct_types = NULL; /* Struct types in declaration order */
+static CZ_THREAD_LOCAL size_t struct_type_count = 0;
+static CZ_THREAD_LOCAL size_t struct_type_capacity = 0;
+static CZ_THREAD_LOCAL HashTable_t struct_type_index;   /* Struct type name -> index in struct_types */
+static CZ_THREAD_LOCAL ScopeTable_t instance_scopes;    /* Local variable -> its struct type name, per block */
 
-/* Add a method to tracking */
-static void track_method(const char *struct_name, const char *method_name) {
-    if (method_count >= MAX_METHODS) {
-        char warning_msg[256];
-        snprintf(warning_msg, sizeof(warning_msg), WARN_MAX_METHOD_TRACKING_LIMIT, MAX_METHODS);
-        cz_warning(g_filename, g_source, 0, warning_msg);
-        return;
-    }
-
-    /* Check if already tracked */
-    for (size_t i = 0; i < method_count; i++) {
-        if (methods[i].struct_name && methods[i].method_name &&
-            strcmp(methods[i].struct_name, struct_name) == 0 &&
-            strcmp(methods[i].method_name, method_name) == 0) {
-            return;
-        }
-    }
+/* Check if a method is tracked */
+static int is_tracked_method(int struct_name, int method_name) {
+    return hash_table_get(&methods, hash_key_pair(struct_name, method_name)) != HASH_TABLE_MISSING;
+}
 
-    /* Add new method */
-    char *struct_name_copy = strdup(struct_name);
-    char *method_name_copy = strdup(method_name);
-    if (!struct_name_copy || !method_name_copy) {
-        /* Memory allocation failed, clean up and return */
-        free(struct_name_copy);
-        free(method_name_copy);
+/* Add a method to tracking */
+static void track_method(int struct_name, int method_name) {
+    if (struct_name == SYM_NONE || method_name == SYM_NONE) {
         return;
     }
-
-    methods[method_count].struct_name = struct_name_copy;
-    methods[method_count].method_name = method_name_copy;
-    method_count++;
+    hash_table_put(&methods, hash_key_pair(struct_name, method_name), 1);
 }
 
-/* Check if a method is tracked */
-static int is_tracked_method(const char *struct_name, const char *method_name) {
-    for (size_t i = 0; i < method_count; i++) {
-        if (methods[i].struct_name && methods[i].method_name &&
-            strcmp(methods[i].struct_name, struct_name) == 0 &&
-            strcmp(methods[i].method_name, method_name) == 0) {
-            return 1;
-        }
-    }
-    return 0;
+/* Check if a symbol is a known struct type */
+static int is_struct_type(int name) {
+    return hash_table_get(&struct_type_index, (uint64_t)(uint32_t)name) != HASH_TABLE_MISSING;
 }
 
 /* Add a struct type to tracking */
-static void track_struct_type(const char *name) {
-    if (struct_type_count >= MAX_STRUCT_TYPES) {
-        char warning_msg[256];
-        snprintf(warning_msg, sizeof(warning_msg), WARN_MAX_STRUCT_TYPE_TRACKING_LIMIT, MAX_STRUCT_TYPES);
-        cz_warning(g_filename, g_source, 0, warning_msg);
+static void track_struct_type(int name) {
+    if (name == SYM_NONE || is_struct_type(name)) {
         return;
     }
 
-    /* Check if already tracked */
-    for (size_t i = 0; i < struct_type_count; i++) {
-        if (struct_types[i].name && strcmp(struct_types[i].name, name) == 0) {
+    if (struct_type_count >= struct_type_capacity) {
+        size_t new_capacity = struct_type_capacity == 0 ? 16 : struct_type_capacity * 2;
+        StructType *new_types = realloc(struct_types, new_capacity * sizeof(StructType));
+        if (!new_types) {
             return;
         }
+        struct_types = new_types;
+        struct_type_capacity = new_capacity;
     }
 
-    /* Add new struct type */
-    char *name_copy = strdup(name);
-    if (!name_copy) {
+    if (!hash_table_put(&struct_type_index, (uint64_t)(uint32_t)name, struct_type_count)) {
         return;
     }
-
-    struct_types[struct_type_count].name = name_copy;
+    struct_types[struct_type_count].name = name;
     struct_type_count++;
 }
 
-/* Check if an identifier is a known struct type */
-static int is_struct_type(const char *name) {
-    for (size_t i = 0; i < struct_type_count; i++) {
-        if (struct_types[i].name && strcmp(struct_types[i].name, name) == 0) {
-            return 1;
-        }
+/* Intern a type name, dropping suffix ("_s" or "_t") when present */
+static int intern_without_suffix(const char *name, const char *suffix) {
+    size_t len = strlen(name);
+    if (len > 2 && strcmp(name + len - 2, suffix) == 0) {
+        len -= 2;
     }
-    return 0;
+    return cz_intern_length(name, len);
 }
 
-/* Clear tracking */
+/* Clear tracking (names stay in the interner) */
 static void clear_tracking(void) {
-    for (size_t i = 0; i < method_count; i++) {
-        free(methods[i].struct_name);
-        free(methods[i].method_name);
-    }
-    method_count = 0;
-
-    for (size_t i = 0; i < struct_type_count; i++) {
-        free(struct_types[i].name);
-    }
+    hash_table_clear(&methods);
+    hash_table_clear(&struct_type_index);
     struct_type_count = 0;
+    scope_clear(&instance_scopes);
 }
 
-/* Helper: Skip whitespace and comments in token stream */
-static size_t skip_whitespace(ASTNode_t *ast, size_t start, size_t max) {
-    for (size_t i = start; i < ast->child_count && i < max; i++) {
-        if (ast->children[i]->type == AST_TOKEN) {
-            Token *t = &ast->children[i]->token;
-            if (t->type != TOKEN_WHITESPACE && t->type != TOKEN_COMMENT) {
-                return i;
-            }
-        }
-    }
-    return ast->child_count;
+/* Release method and struct type tracking of the current translation unit */
+void transpiler_free_method_tables(void) {
+    clear_tracking();
+    hash_table_free(&methods);
+    hash_table_free(&struct_type_index);
+    scope_free(&instance_scopes);
+    free(struct_types);
+    struct_types = NULL;
+    struct_type_capacity = 0;
+}
+
+/* Get the bytes held by method and struct type tracking (cz --stats) */
+size_t transpiler_method_table_bytes(void) {
+    return hash_table_bytes(&methods) + struct_type_capacity * sizeof(StructType) +
+           hash_table_bytes(&struct_type_index) + scope_bytes(&instance_scopes);
 }
 
 /* Helper: Find the next non-whitespace token */
 static ASTNode_t* get_next_non_ws_node(ASTNode_t *ast, size_t start, size_t *out_idx) {
-    size_t idx = skip_whitespace(ast, start, ast->child_count);
+    size_t idx = ast_skip_trivia(ast->children, ast->child_count, start);
     if (out_idx) *out_idx = idx;
     if (idx < ast->child_count) {
         return ast->children[idx];
@@ -172,8 +132,8 @@ static void scan_struct_definitions(ASTNode_t *ast) {
         Token *t = &ast->children[i]->token;
 
         /* Look for: struct StructName { or typedef struct StructName { */
-        if ((t->type == TOKEN_IDENTIFIER || t->type == TOKEN_KEYWORD) && t->text &&
-            (strcmp(t->text, "struct") == 0 || strcmp(t->text, "typedef struct") == 0)) {
+        if (t->symbol == SYM_STRUCT ||
+            (t->text && strcmp(t->text, "typedef struct") == 0)) {
 
             /* Get next non-whitespace token (struct name) */
             size_t name_idx;
@@ -194,41 +154,13 @@ static void scan_struct_definitions(ASTNode_t *ast) {
                         strcmp(brace_token->text, "{") == 0) {
                         /* This is a struct definition */
                         /* Extract base name if it ends with _s (from new typedef format) */
-                        char *base_name = strdup(name_token->text);
-                        if (!base_name) {
-                            /* Memory allocation failed */
-                            continue;
-                        }
-                        size_t len = strlen(base_name);
-                        if (len > 2 && strcmp(base_name + len - 2, "_s") == 0) {
-                            /* Remove _s suffix to get base name for methods */
-                            base_name[len - 2] = '\0';
-                        }
-                        track_struct_type(base_name);
-                        free(base_name);
+                        track_struct_type(intern_without_suffix(name_token->text, "_s"));
 
                         /* Find closing brace and check for typedef name */
-                        int brace_depth = 0;
-                        size_t closing_brace_idx = 0;
-                        for (size_t j = brace_idx; j < ast->child_count; j++) {
-                            if (ast->children[j]->type == AST_TOKEN) {
-                                Token *tj = &ast->children[j]->token;
-                                if (tj->type == TOKEN_PUNCTUATION && tj->text) {
-                                    if (strcmp(tj->text, "{") == 0) {
-                                        brace_depth++;
-                                    } else if (strcmp(tj->text, "}") == 0) {
-                                        brace_depth--;
-                                        if (brace_depth == 0) {
-                                            closing_brace_idx = j;
-                                            break;
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                        size_t closing_brace_idx = ast_match(ast, brace_idx);
 
                         /* Check for typedef name after closing brace */
-                        if (closing_brace_idx > 0) {
+                        if (closing_brace_idx != AST_NO_MATCH) {
                             size_t typedef_name_idx;
                             ASTNode_t *typedef_name_node = get_next_non_ws_node(ast, closing_brace_idx + 1, &typedef_name_idx);
                             if (typedef_name_node && typedef_name_node->type == AST_TOKEN) {
@@ -237,18 +169,7 @@ static void scan_struct_definitions(ASTNode_t *ast) {
                                      typedef_name_token->type == TOKEN_KEYWORD) && 
                                     typedef_name_token->text) {
                                     /* Track the typedef name too, stripping _t suffix if present */
-                                    char *typedef_base = strdup(typedef_name_token->text);
-                                    if (!typedef_base) {
-                                        /* Memory allocation failed */
-                                        continue;
-                                    }
-                                    size_t len = strlen(typedef_base);
-                                    if (len > 2 && strcmp(typedef_base + len - 2, "_t") == 0) {
-                                        /* Remove _t suffix to get base name for methods */
-                                        typedef_base[len - 2] = '\0';
-                                    }
-                                    track_struct_type(typedef_base);
-                                    free(typedef_base);
+                                    track_struct_type(intern_without_suffix(typedef_name_token->text, "_t"));
                                 }
                             }
                         }
@@ -259,8 +180,28 @@ static void scan_struct_definitions(ASTNode_t *ast) {
     }
 }
 
+/* Track the methods of the siblings and imported modules (their struct types too) */
+static void track_module_methods(const char *filename, const char *source) {
+    if (!filename || !source) {
+        return;
+    }
+    char *methods = module_methods(filename, source, strlen(source));
+    for (const char *line = methods; line && *line; ) {
+        const char *dot = strchr(line, '.');
+        const char *end = strchr(line, '\n');
+        if (!dot || !end || dot > end) {
+            break;
+        }
+        int struct_id = cz_intern_length(line, (size_t)(dot - line));
+        track_struct_type(struct_id);
+        track_method(struct_id, cz_intern_length(dot + 1, (size_t)(end - dot - 1)));
+        line = end + 1;
+    }
+    free(methods);
+}
+
 /* Second pass: Transform method declarations */
-static void transform_method_declarations(ASTNode_t *ast) {
+static void transform_method_declarations(ASTNode_t *ast, ASTRewrite_t *rewrite) {
     if (!ast || ast->type != AST_TRANSLATION_UNIT) {
         return;
     }
@@ -279,7 +220,7 @@ static void transform_method_declarations(ASTNode_t *ast) {
         }
 
         /* Skip whitespace */
-        size_t dot_idx = skip_whitespace(ast, i + 1, ast->child_count);
+        size_t dot_idx = ast_skip_trivia(ast->children, ast->child_count, i + 1);
         if (dot_idx >= ast->child_count) {
             continue;
         }
@@ -292,7 +233,7 @@ static void transform_method_declarations(ASTNode_t *ast) {
         }
 
         /* Get the identifier after the dot */
-        size_t method_idx = skip_whitespace(ast, dot_idx + 1, ast->child_count);
+        size_t method_idx = ast_skip_trivia(ast->children, ast->child_count, dot_idx + 1);
         if (method_idx >= ast->child_count) {
             continue;
         }
@@ -304,7 +245,7 @@ static void transform_method_declarations(ASTNode_t *ast) {
         }
 
         /* Check if followed by ( to confirm it's a function declaration */
-        size_t paren_idx = skip_whitespace(ast, method_idx + 1, ast->child_count);
+        size_t paren_idx = ast_skip_trivia(ast->children, ast->child_count, method_idx + 1);
         if (paren_idx >= ast->child_count) {
             continue;
         }
@@ -316,40 +257,25 @@ static void transform_method_declarations(ASTNode_t *ast) {
         }
 
         /* Check if the identifier before the dot is a known struct type */
-        const char *struct_name = n1->token.text;
-        const char *method_name = method_node->token.text;
-
-        if (!is_struct_type(struct_name)) {
+        int struct_id = cz_intern(n1->token.text);
+        if (!is_struct_type(struct_id)) {
             continue;
         }
 
         /* Check if this is a function definition (has a body {...}) or just a call */
         /* First, find the closing paren to see if there's a brace after it */
-        int paren_depth = 0;
-        size_t close_paren_idx = paren_idx;
-        int has_params = 0;
+        size_t close_paren_idx = ast_match(ast, paren_idx);
+        if (close_paren_idx == AST_NO_MATCH) {
+            continue;
+        }
 
-        for (size_t j = paren_idx; j < ast->child_count; j++) {
-            if (ast->children[j]->type == AST_TOKEN) {
-                Token *tj = &ast->children[j]->token;
-                if (tj->type == TOKEN_PUNCTUATION && tj->text) {
-                    if (strcmp(tj->text, "(") == 0) {
-                        paren_depth++;
-                    } else if (strcmp(tj->text, ")") == 0) {
-                        paren_depth--;
-                        if (paren_depth == 0) {
-                            close_paren_idx = j;
-                            break;
-                        }
-                    }
-                }
-                /* Check if there's any non-whitespace content between parens */
-                if (paren_depth > 0 && j > paren_idx) {
-                    if (tj->type != TOKEN_WHITESPACE && tj->type != TOKEN_COMMENT &&
-                        !(tj->type == TOKEN_PUNCTUATION && tj->text && strcmp(tj->text, ")") == 0)) {
-                        has_params = 1;
-                    }
-                }
+        /* Check if there's any non-whitespace content between parens */
+        int has_params = 0;
+        for (size_t j = paren_idx + 1; j < close_paren_idx; j++) {
+            TokenType type = ast->children[j]->token.type;
+            if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
+                has_params = 1;
+                break;
             }
         }
 
@@ -365,16 +291,15 @@ static void transform_method_declarations(ASTNode_t *ast) {
         }
 
         /* This is a method declaration! Now we can transform it. */
-        /* Save copies of names before modifying tokens */
-        char *struct_name_copy = strdup(struct_name);
-        char *method_name_copy = strdup(method_name);
+        /* Interned names stay valid while the tokens are rewritten */
+        int method_id = cz_intern(method_node->token.text);
+        const char *struct_name_copy = cz_symbol_name(struct_id);
+        const char *method_name_copy = cz_symbol_name(method_id);
         if (!struct_name_copy || !method_name_copy) {
-            free(struct_name_copy);
-            free(method_name_copy);
             continue;
         }
 
-        track_method(struct_name_copy, method_name_copy);
+        track_method(struct_id, method_id);
 
         /* Step 1: Replace "StructName.methodName" with "StructName_methodName" */
         size_t new_name_len = strlen(struct_name_copy) + 1 + strlen(method_name_copy) + 1;
@@ -383,182 +308,64 @@ static void transform_method_declarations(ASTNode_t *ast) {
             snprintf(new_name, new_name_len, "%s_%s", struct_name_copy, method_name_copy);
 
             /* Replace the struct name token with the combined name */
-            free(n1->token.text);
-            n1->token.text = new_name;
-            n1->token.length = strlen(new_name);
-
-            /* Remove the dot and method name tokens */
-            /* Mark them for removal by setting text to NULL */
-            if (dot_node->token.text) {
-                free(dot_node->token.text);
-                dot_node->token.text = strdup("");
-                dot_node->token.length = 0;
-            }
-            if (method_node->token.text) {
-                free(method_node->token.text);
-                method_node->token.text = strdup("");
-                method_node->token.length = 0;
-            }
+            token_take_text(&n1->token, new_name);
+
+            /* Blank the dot and method name tokens (kept so later passes don't see a plain call) */
+            token_set_text(&dot_node->token, "");
+            token_set_text(&method_node->token, "");
         }
 
         /* Step 2: Add self parameter */
 
         /* Create struct name token */
-        ASTNode_t *struct_name_node = malloc(sizeof(ASTNode_t));
+        ASTNode_t *struct_name_node = ast_token_create(TOKEN_IDENTIFIER, struct_name_copy, n1->token.line, 0);
         if (!struct_name_node) {
-            free(struct_name_copy);
-            free(method_name_copy);
             continue;
         }
-        struct_name_node->type = AST_TOKEN;
-        struct_name_node->token.type = TOKEN_IDENTIFIER;
-        struct_name_node->token.text = struct_name_copy; /* Transfer ownership */
-        struct_name_node->token.length = strlen(struct_name_copy);
-        struct_name_node->token.line = n1->token.line;
-        struct_name_node->token.column = 0;
-        struct_name_node->children = NULL;
-        struct_name_node->child_count = 0;
-        struct_name_node->child_capacity = 0;
 
         /* Create pointer token */
-        ASTNode_t *ptr_node = malloc(sizeof(ASTNode_t));
+        ASTNode_t *ptr_node = ast_token_create(TOKEN_OPERATOR, "*", n1->token.line, 0);
         if (!ptr_node) {
-            free(struct_name_node);
-            free(method_name_copy);
             continue;
         }
-        ptr_node->type = AST_TOKEN;
-        ptr_node->token.type = TOKEN_OPERATOR;
-        ptr_node->token.text = strdup("*");
-        ptr_node->token.length = 1;
-        ptr_node->token.line = n1->token.line;
-        ptr_node->token.column = 0;
-        ptr_node->children = NULL;
-        ptr_node->child_count = 0;
-        ptr_node->child_capacity = 0;
 
         /* Create space token */
-        ASTNode_t *space_node = malloc(sizeof(ASTNode_t));
+        ASTNode_t *space_node = ast_token_create(TOKEN_WHITESPACE, " ", n1->token.line, 0);
         if (!space_node) {
-            free(struct_name_node);
-            free(ptr_node);
-            free(method_name_copy);
             continue;
         }
-        space_node->type = AST_TOKEN;
-        space_node->token.type = TOKEN_WHITESPACE;
-        space_node->token.text = strdup(" ");
-        space_node->token.length = 1;
-        space_node->token.line = n1->token.line;
-        space_node->token.column = 0;
-        space_node->children = NULL;
-        space_node->child_count = 0;
-        space_node->child_capacity = 0;
 
         /* Create self token */
-        ASTNode_t *self_node = malloc(sizeof(ASTNode_t));
+        ASTNode_t *self_node = ast_token_create(TOKEN_IDENTIFIER, "self", n1->token.line, 0);
         if (!self_node) {
-            free(struct_name_node);
-            free(ptr_node);
-            free(space_node);
-            free(method_name_copy);
             continue;
         }
-        self_node->type = AST_TOKEN;
-        self_node->token.type = TOKEN_IDENTIFIER;
-        self_node->token.text = strdup("self");
-        self_node->token.length = 4;
-        self_node->token.line = n1->token.line;
-        self_node->token.column = 0;
-        self_node->children = NULL;
-        self_node->child_count = 0;
-        self_node->child_capacity = 0;
 
         /* If there are existing params, add "," and " " after self */
         ASTNode_t *comma_node = NULL;
         ASTNode_t *comma_space_node = NULL;
         if (has_params) {
-            comma_node = malloc(sizeof(ASTNode_t));
+            comma_node = ast_token_create(TOKEN_PUNCTUATION, ",", n1->token.line, 0);
             if (!comma_node) {
-                free(struct_name_node);
-                free(ptr_node);
-                free(space_node);
-                free(self_node);
-                free(method_name_copy);
                 continue;
             }
-            comma_node->type = AST_TOKEN;
-            comma_node->token.type = TOKEN_PUNCTUATION;
-            comma_node->token.text = strdup(",");
-            comma_node->token.length = 1;
-            comma_node->token.line = n1->token.line;
-            comma_node->token.column = 0;
-            comma_node->children = NULL;
-            comma_node->child_count = 0;
-            comma_node->child_capacity = 0;
-
-            comma_space_node = malloc(sizeof(ASTNode_t));
+
+            comma_space_node = ast_token_create(TOKEN_WHITESPACE, " ", n1->token.line, 0);
             if (!comma_space_node) {
-                free(struct_name_node);
-                free(ptr_node);
-                free(space_node);
-                free(self_node);
-                free(comma_node);
-                free(method_name_copy);
                 continue;
             }
-            comma_space_node->type = AST_TOKEN;
-            comma_space_node->token.type = TOKEN_WHITESPACE;
-            comma_space_node->token.text = strdup(" ");
-            comma_space_node->token.length = 1;
-            comma_space_node->token.line = n1->token.line;
-            comma_space_node->token.column = 0;
-            comma_space_node->children = NULL;
-            comma_space_node->child_count = 0;
-            comma_space_node->child_capacity = 0;
         }
 
         /* Insert nodes after opening paren: StructName * space self [, space] */
         size_t insert_pos = paren_idx + 1;
-        size_t nodes_to_insert = has_params ? 6 : 4; /* struct_name, *, space, self, [comma, space] */
-        size_t new_count = ast->child_count + nodes_to_insert;
-
-        if (new_count > ast->child_capacity) {
-            size_t new_capacity = new_count * 2;
-            ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-            if (new_children) {
-                ast->children = new_children;
-                ast->child_capacity = new_capacity;
-            } else {
-                free(struct_name_node);
-                free(ptr_node);
-                free(space_node);
-                free(self_node);
-                if (comma_node) free(comma_node);
-                if (comma_space_node) free(comma_space_node);
-                free(method_name_copy);
-                continue;
-            }
-        }
-
-        /* Shift elements */
-        for (size_t j = ast->child_count; j > insert_pos; j--) {
-            ast->children[j + nodes_to_insert - 1] = ast->children[j - 1];
-        }
-
-        /* Insert self parameter tokens */
-        ast->children[insert_pos] = struct_name_node;
-        ast->children[insert_pos + 1] = ptr_node;
-        ast->children[insert_pos + 2] = space_node;
-        ast->children[insert_pos + 3] = self_node;
-        if (has_params && comma_node && comma_space_node) {
-            ast->children[insert_pos + 4] = comma_node;
-            ast->children[insert_pos + 5] = comma_space_node;
+        ast_rewrite_insert(rewrite, insert_pos, struct_name_node);
+        ast_rewrite_insert(rewrite, insert_pos, ptr_node);
+        ast_rewrite_insert(rewrite, insert_pos, space_node);
+        ast_rewrite_insert(rewrite, insert_pos, self_node);
+        if (has_params) {
+            ast_rewrite_insert(rewrite, insert_pos, comma_node);
+            ast_rewrite_insert(rewrite, insert_pos, comma_space_node);
         }
-        ast->child_count += nodes_to_insert;
-
-        /* Free the method name copy (struct name was transferred to node) */
-        free(method_name_copy);
 
         /* Skip past this method declaration */
         i = close_paren_idx;
@@ -566,13 +373,23 @@ static void transform_method_declarations(ASTNode_t *ast) {
 }
 
 /* Third pass: Transform method calls */
-static void transform_method_calls(ASTNode_t *ast) {
+static void transform_method_calls(ASTNode_t *ast, ASTRewrite_t *rewrite) {
     if (!ast || ast->type != AST_TRANSLATION_UNIT) {
         return;
     }
 
     /* Look for pattern: identifier.methodName(...) */
     for (size_t i = 0; i < ast->child_count; i++) {
+        /* Remember the struct type of each local, in the block declaring it */
+        ScopeDeclaration_t declaration;
+        scope_track_braces(&instance_scopes, ast->children, i, 0);
+        if (instance_scopes.depth > 0 &&
+            scope_match_declaration(ast->children, ast->child_count, i, &declaration)) {
+            int type_id = intern_without_suffix(ast->children[declaration.type]->token.text, "_t");
+            scope_bind(&instance_scopes, cz_token_symbol(&ast->children[declaration.name]->token),
+                       !declaration.pointer && is_struct_type(type_id) ? (size_t)type_id : 0);
+        }
+
         if (i + 4 >= ast->child_count) {
             continue;
         }
@@ -585,7 +402,7 @@ static void transform_method_calls(ASTNode_t *ast) {
         }
 
         /* Check for dot */
-        size_t dot_idx = skip_whitespace(ast, i + 1, ast->child_count);
+        size_t dot_idx = ast_skip_trivia(ast->children, ast->child_count, i + 1);
         if (dot_idx >= ast->child_count) {
             continue;
         }
@@ -598,7 +415,7 @@ static void transform_method_calls(ASTNode_t *ast) {
         }
 
         /* Get method name */
-        size_t method_idx = skip_whitespace(ast, dot_idx + 1, ast->child_count);
+        size_t method_idx = ast_skip_trivia(ast->children, ast->child_count, dot_idx + 1);
         if (method_idx >= ast->child_count) {
             continue;
         }
@@ -610,7 +427,7 @@ static void transform_method_calls(ASTNode_t *ast) {
         }
 
         /* Check for opening paren */
-        size_t paren_idx = skip_whitespace(ast, method_idx + 1, ast->child_count);
+        size_t paren_idx = ast_skip_trivia(ast->children, ast->child_count, method_idx + 1);
         if (paren_idx >= ast->child_count) {
             continue;
         }
@@ -622,23 +439,30 @@ static void transform_method_calls(ASTNode_t *ast) {
         }
 
         /* Check if this is a tracked method call */
-        const char *instance_name = n1->token.text;
+        int instance_id = cz_intern(n1->token.text);
+        int method_id = cz_intern(method_node->token.text);
         const char *method_name = method_node->token.text;
 
-        /* Save copies before modifying tokens */
-        char *instance_name_copy = strdup(instance_name);
+        /* Interned copy stays valid while the tokens are rewritten */
+        const char *instance_name_copy = cz_symbol_name(instance_id);
         if (!instance_name_copy) {
             continue;
         }
 
-        /* We need to determine the struct type of the instance */
-        /* For simplicity, we'll try all tracked struct types to see if the method exists */
+        /* We need to determine the struct type of the instance: a local declared in scope gives it,
+         * otherwise (parameters, globals) we try all tracked struct types to see if the method exists */
         /* But skip this if the instance name itself is a struct type (static call) */
-        char *struct_name = NULL;
-        if (!is_struct_type(instance_name_copy)) {
+        const char *struct_name = NULL;
+        int is_static_call = is_struct_type(instance_id);
+        size_t instance_type = is_static_call ? 0 : scope_lookup(&instance_scopes, instance_id);
+        if (instance_type != HASH_TABLE_MISSING && instance_type != 0 &&
+            is_tracked_method((int)instance_type, method_id)) {
+            struct_name = cz_symbol_name((int)instance_type);
+        }
+        if (!is_static_call && !struct_name) {
             for (size_t j = 0; j < struct_type_count; j++) {
-                if (is_tracked_method(struct_types[j].name, method_name)) {
-                    struct_name = struct_types[j].name;
+                if (is_tracked_method(struct_types[j].name, method_id)) {
+                    struct_name = cz_symbol_name(struct_types[j].name);
                     break;
                 }
             }
@@ -646,7 +470,7 @@ static void transform_method_calls(ASTNode_t *ast) {
 
         if (!struct_name) {
             /* Also check if the instance name is itself a struct type (static call) */
-            if (is_struct_type(instance_name_copy) && is_tracked_method(instance_name_copy, method_name)) {
+            if (is_static_call && is_tracked_method(instance_id, method_id)) {
                 /* Static call: StructName.method(...) */
                 /* Special case for Log struct: use cz_log_* naming */
                 char *new_name = NULL;
@@ -668,26 +492,14 @@ static void transform_method_calls(ASTNode_t *ast) {
 
                 if (new_name) {
                     /* Replace instance name with combined name */
-                    free(n1->token.text);
-                    n1->token.text = new_name;
-                    n1->token.length = strlen(new_name);
+                    token_take_text(&n1->token, new_name);
 
                     /* Remove dot and method name */
-                    if (dot_node->token.text) {
-                        free(dot_node->token.text);
-                        dot_node->token.text = strdup("");
-                        dot_node->token.length = 0;
-                    }
-                    if (method_node->token.text) {
-                        free(method_node->token.text);
-                        method_node->token.text = strdup("");
-                        method_node->token.length = 0;
-                    }
+                    token_set_text(&dot_node->token, "");
+                    token_set_text(&method_node->token, "");
                 }
-                free(instance_name_copy);
                 continue;
             }
-            free(instance_name_copy);
             continue;
         }
 
@@ -702,156 +514,65 @@ static void transform_method_calls(ASTNode_t *ast) {
         }
         snprintf(new_name, new_name_len, "%s_%s", struct_name, method_name);
 
-        free(n1->token.text);
-        n1->token.text = new_name;
-        n1->token.length = strlen(new_name);
+        token_take_text(&n1->token, new_name);
 
         /* Remove dot and method name */
-        if (dot_node->token.text) {
-            free(dot_node->token.text);
-            dot_node->token.text = strdup("");
-            dot_node->token.length = 0;
-        }
-        if (method_node->token.text) {
-            free(method_node->token.text);
-            method_node->token.text = strdup("");
-            method_node->token.length = 0;
-        }
+        token_set_text(&dot_node->token, "");
+        token_set_text(&method_node->token, "");
 
         /* Add &instance as first argument */
         /* Find if there are existing arguments */
-        int paren_depth = 0;
-        size_t close_paren_idx = paren_idx;
-        int has_args = 0;
+        size_t close_paren_idx = ast_match(ast, paren_idx);
+        if (close_paren_idx == AST_NO_MATCH) {
+            close_paren_idx = paren_idx;
+        }
 
-        for (size_t j = paren_idx; j < ast->child_count; j++) {
-            if (ast->children[j]->type == AST_TOKEN) {
-                Token *tj = &ast->children[j]->token;
-                if (tj->type == TOKEN_PUNCTUATION && tj->text) {
-                    if (strcmp(tj->text, "(") == 0) {
-                        paren_depth++;
-                    } else if (strcmp(tj->text, ")") == 0) {
-                        paren_depth--;
-                        if (paren_depth == 0) {
-                            close_paren_idx = j;
-                            break;
-                        }
-                    }
-                }
-                /* Check for non-whitespace content */
-                if (paren_depth > 0 && j > paren_idx && tj->type != TOKEN_WHITESPACE && tj->type != TOKEN_COMMENT) {
-                    if (!(tj->type == TOKEN_PUNCTUATION && tj->text && strcmp(tj->text, ")") == 0)) {
-                        has_args = 1;
-                    }
-                }
+        /* Check for non-whitespace content */
+        int has_args = 0;
+        for (size_t j = paren_idx + 1; j < close_paren_idx; j++) {
+            TokenType type = ast->children[j]->token.type;
+            if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
+                has_args = 1;
+                break;
             }
         }
 
         /* Create &instance as separate tokens */
         /* Create & token */
-        ASTNode_t *addr_node = malloc(sizeof(ASTNode_t));
+        ASTNode_t *addr_node = ast_token_create(TOKEN_OPERATOR, "&", n1->token.line, 0);
         if (!addr_node) {
-            free(instance_name_copy);
             continue;
         }
-        addr_node->type = AST_TOKEN;
-        addr_node->token.type = TOKEN_OPERATOR;
-        addr_node->token.text = strdup("&");
-        addr_node->token.length = 1;
-        addr_node->token.line = n1->token.line;
-        addr_node->token.column = 0;
-        addr_node->children = NULL;
-        addr_node->child_count = 0;
-        addr_node->child_capacity = 0;
 
         /* Create instance token */
-        ASTNode_t *instance_node = malloc(sizeof(ASTNode_t));
+        ASTNode_t *instance_node = ast_token_create(TOKEN_IDENTIFIER, instance_name_copy, n1->token.line, 0);
         if (!instance_node) {
-            free(addr_node);
-            free(instance_name_copy);
             continue;
         }
-        instance_node->type = AST_TOKEN;
-        instance_node->token.type = TOKEN_IDENTIFIER;
-        instance_node->token.text = instance_name_copy; /* Transfer ownership */
-        instance_node->token.length = strlen(instance_name_copy);
-        instance_node->token.line = n1->token.line;
-        instance_node->token.column = 0;
-        instance_node->children = NULL;
-        instance_node->child_count = 0;
-        instance_node->child_capacity = 0;
 
         /* If there are existing args, add "," and " " after instance */
         ASTNode_t *comma_node = NULL;
         ASTNode_t *comma_space_node = NULL;
         if (has_args) {
-            comma_node = malloc(sizeof(ASTNode_t));
+            comma_node = ast_token_create(TOKEN_PUNCTUATION, ",", n1->token.line, 0);
             if (!comma_node) {
-                free(addr_node);
-                free(instance_node);
                 continue;
             }
-            comma_node->type = AST_TOKEN;
-            comma_node->token.type = TOKEN_PUNCTUATION;
-            comma_node->token.text = strdup(",");
-            comma_node->token.length = 1;
-            comma_node->token.line = n1->token.line;
-            comma_node->token.column = 0;
-            comma_node->children = NULL;
-            comma_node->child_count = 0;
-            comma_node->child_capacity = 0;
-
-            comma_space_node = malloc(sizeof(ASTNode_t));
+
+            comma_space_node = ast_token_create(TOKEN_WHITESPACE, " ", n1->token.line, 0);
             if (!comma_space_node) {
-                free(addr_node);
-                free(instance_node);
-                free(comma_node);
                 continue;
             }
-            comma_space_node->type = AST_TOKEN;
-            comma_space_node->token.type = TOKEN_WHITESPACE;
-            comma_space_node->token.text = strdup(" ");
-            comma_space_node->token.length = 1;
-            comma_space_node->token.line = n1->token.line;
-            comma_space_node->token.column = 0;
-            comma_space_node->children = NULL;
-            comma_space_node->child_count = 0;
-            comma_space_node->child_capacity = 0;
         }
 
         /* Insert after opening paren: & instance [, space] */
         size_t insert_pos = paren_idx + 1;
-        size_t nodes_to_insert = has_args ? 4 : 2; /* &, instance, [comma, space] */
-        size_t new_count = ast->child_count + nodes_to_insert;
-
-        if (new_count > ast->child_capacity) {
-            size_t new_capacity = new_count * 2;
-            ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-            if (new_children) {
-                ast->children = new_children;
-                ast->child_capacity = new_capacity;
-            } else {
-                free(addr_node);
-                free(instance_node);
-                if (comma_node) free(comma_node);
-                if (comma_space_node) free(comma_space_node);
-                continue;
-            }
-        }
-
-        /* Shift elements */
-        for (size_t j = ast->child_count; j > insert_pos; j--) {
-            ast->children[j + nodes_to_insert - 1] = ast->children[j - 1];
-        }
-
-        /* Insert &instance tokens */
-        ast->children[insert_pos] = addr_node;
-        ast->children[insert_pos + 1] = instance_node;
-        if (has_args && comma_node && comma_space_node) {
-            ast->children[insert_pos + 2] = comma_node;
-            ast->children[insert_pos + 3] = comma_space_node;
+        ast_rewrite_insert(rewrite, insert_pos, addr_node);
+        ast_rewrite_insert(rewrite, insert_pos, instance_node);
+        if (has_args) {
+            ast_rewrite_insert(rewrite, insert_pos, comma_node);
+            ast_rewrite_insert(rewrite, insert_pos, comma_space_node);
         }
-        ast->child_count += nodes_to_insert;
 
         /* Skip past this method call */
         i = close_paren_idx;
@@ -871,20 +592,27 @@ void transpiler_transform_methods(ASTNode_t *ast, const char *filename, const ch
     clear_tracking();
 
     /* Pre-register Log struct and its methods for runtime logging */
-    track_struct_type("Log");
-    track_method("Log", "verbose");
-    track_method("Log", "debug");
-    track_method("Log", "info");
-    track_method("Log", "warning");
-    track_method("Log", "error");
-    track_method("Log", "fatal");
-
-    /* Pass 1: Scan for struct definitions */
+    int log_id = cz_intern("Log");
+    track_struct_type(log_id);
+    track_method(log_id, cz_intern("verbose"));
+    track_method(log_id, cz_intern("debug"));
+    track_method(log_id, cz_intern("info"));
+    track_method(log_id, cz_intern("warning"));
+    track_method(log_id, cz_intern("error"));
+    track_method(log_id, cz_intern("fatal"));
+
+    /* Pass 1: Scan for struct definitions, then the methods other modules declare */
     scan_struct_definitions(ast);
+    track_module_methods(filename, source);
 
     /* Pass 2: Transform method declarations */
-    transform_method_declarations(ast);
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
+    transform_method_declarations(ast, &rewrite);
+    ast_rewrite_commit(&rewrite);
 
     /* Pass 3: Transform method calls */
-    transform_method_calls(ast);
+    ast_rewrite_init(&rewrite, ast);
+    transform_method_calls(ast, &rewrite);
+    ast_rewrite_commit(&rewrite);
 }
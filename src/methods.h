@@ -15,3 +15,9 @@
 
 /* Transform struct method declarations and calls */
 void transpiler_transform_methods(ASTNode_t *ast, const char *filename, const char *source);
+
+/* Release method and struct type tracking of the current translation unit */
+void transpiler_free_method_tables(void);
+
+/* Get the bytes held by method and struct type tracking (cz --stats) */
+size_t transpiler_method_table_bytes(void);
@@ -22,8 +22,11 @@
 
 #include "cz.h"
 #include "mutability.h"
+#include "pragma.h"
 #include "warnings.h"
 #include "errors.h"
+#include "../hashtable.h"
+#include "../rewrite.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -51,6 +54,11 @@ static int token_equals(Token *token, const char *text) {
     return token && token->text && text && strcmp(token->text, text) == 0;
 }
 
+/* Check if token is the given keyword (integer compare on its symbol ID) */
+static int token_is(Token *token, int symbol) {
+    return token && token->symbol == symbol;
+}
+
 /* Check if identifier is a known type keyword */
 static int is_type_keyword(const char *text) {
     if (!text) return 0;
@@ -63,64 +71,24 @@ static int is_type_keyword(const char *text) {
 }
 
 /* Check if token is a type identifier (keyword or struct name) */
-/* Skip whitespace and comments */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t i) {
-    while (i < count) {
-        if (children[i]->type != AST_TOKEN) {
-            i++;
-            continue;
-        }
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            break;
-        }
-        i++;
-    }
-    return i;
-}
-
 /* Look backward skipping whitespace */
 static int find_prev_token(ASTNode_t **children, size_t current, size_t *result) {
-    if (current == 0) return 0;
-
-    for (int i = (int)current - 1; i >= 0; i--) {
-        if (children[i]->type != AST_TOKEN) continue;
-        TokenType type = children[i]->token.type;
-        if (type == TOKEN_WHITESPACE || type == TOKEN_COMMENT) continue;
-        *result = (size_t)i;
-        return 1;
-    }
-    return 0;
+    size_t prev = ast_prev_significant(children, current);
+    if (prev == AST_NO_MATCH) return 0;
+    *result = prev;
+    return 1;
 }
 
 /* Create a new token node */
 static ASTNode_t *create_token_node(const char *text, TokenType type) {
-    ASTNode_t *node = malloc(sizeof(ASTNode_t));
-    if (!node) return NULL;
-
-    node->type = AST_TOKEN;
-    node->children = NULL;
-    node->child_count = 0;
-    node->child_capacity = 0;
-
-    node->token.type = type;
-    node->token.text = strdup(text);
-    node->token.length = strlen(text);
-    node->token.line = 0;
-    node->token.column = 0;
-
-    if (!node->token.text) {
-        free(node);
-        return NULL;
-    }
-
-    return node;
+    return ast_token_create(type, text, 0, 0);
 }
 
 /* Insertion type enum */
 typedef enum {
     INSERT_CONST_BEFORE_TYPE,    /* Insert "const " before type */
-    INSERT_CONST_AFTER_STAR      /* Insert " const " after * */
+    INSERT_CONST_AFTER_STAR,     /* Insert " const " after * */
+    INSERT_RESTRICT_AFTER_STAR   /* Insert " restrict " after * */
 } InsertionType;
 
 /* Struct to track a const insertion */
@@ -129,60 +97,100 @@ typedef struct {
     InsertionType type;          /* Type of insertion */
 } ConstInsertion;
 
-/* Comparison function for qsort - sort by position descending */
+/* Comparison function for qsort - sort by position ascending */
 static int compare_insertions(const void *a, const void *b) {
     const ConstInsertion *ia = (const ConstInsertion *)a;
     const ConstInsertion *ib = (const ConstInsertion *)b;
-    /* Sort descending so we insert from highest position to lowest */
-    if (ia->position > ib->position) return -1;
-    if (ia->position < ib->position) return 1;
+    if (ia->position < ib->position) return -1;
+    if (ia->position > ib->position) return 1;
     return 0;
 }
 
-/* Insert a node at position in AST children */
-static int insert_node_at(ASTNode_t *ast, size_t pos, ASTNode_t *new_node) {
-    if (!ast || !new_node || pos > ast->child_count) {
-        return 0;
-    }
-
-    /* Ensure capacity */
-    if (ast->child_count >= ast->child_capacity) {
-        size_t new_capacity = ast->child_capacity == 0 ? 16 : ast->child_capacity * 2;
-        ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-        if (!new_children) {
-            return 0;
-        }
-        ast->children = new_children;
-        ast->child_capacity = new_capacity;
+/* Parameters of a function whose mut pointer parameters are restrict (bit n = parameter n) */
+typedef struct {
+    uint64_t restricted;         /* Restrict pointer parameters */
+    uint64_t pointers;           /* All pointer parameters */
+} RestrictFunction;
+
+/* Check if the function whose return type starts at index follows "#pragma czar restrict" */
+static int follows_restrict_pragma(ASTNode_t **children, size_t index) {
+    size_t prev = ast_prev_significant(children, index);
+    while (prev != AST_NO_MATCH && (children[prev]->token.type == TOKEN_IDENTIFIER ||
+                                    children[prev]->token.type == TOKEN_KEYWORD)) {
+        prev = ast_prev_significant(children, prev);
     }
+    return prev != AST_NO_MATCH && pragma_czar_is(&children[prev]->token, "restrict");
+}
 
-    /* Shift elements to make room */
-    for (size_t i = ast->child_count; i > pos; i--) {
-        ast->children[i] = ast->children[i - 1];
-    }
+/* Warn about calls passing the same pointer twice to a function with restrict parameters */
+static void check_restrict_calls(ASTNode_t *ast, const HashTable_t *functions, const RestrictFunction *restricts,
+                                 const char *filename, const char *source) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
 
-    /* Insert new node */
-    ast->children[pos] = new_node;
-    ast->child_count++;
+    for (size_t i = 0; i < count; i++) {
+        Token *name = &children[i]->token;
+        if (name->type != TOKEN_IDENTIFIER) continue;
+        size_t index = hash_table_get(functions, (uint64_t)cz_token_symbol(name));
+        if (index == HASH_TABLE_MISSING) continue;
+
+        size_t open = ast_skip_trivia(children, count, i + 1);
+        if (open >= count || !token_equals(&children[open]->token, "(")) continue;
+        size_t close = ast_match(ast, open);
+        if (close == AST_NO_MATCH) continue;
+
+        /* Skip the definition and prototypes: their parameter list follows a type */
+        size_t prev;
+        if (find_prev_token(children, i, &prev) &&
+            (children[prev]->token.type == TOKEN_IDENTIFIER || is_type_keyword(children[prev]->token.text))) {
+            continue;
+        }
 
-    return 1;
-}
+        /* Arguments as [start, end) ranges split at top-level commas */
+        size_t starts[64];
+        size_t ends[64];
+        size_t argument_count = 0;
+        size_t start = open + 1;
+        for (size_t k = open + 1; k <= close && argument_count < 64; k++) {
+            if (k == close || token_equals(&children[k]->token, ",")) {
+                starts[argument_count] = start;
+                ends[argument_count++] = k;
+                start = k + 1;
+            } else if (token_equals(&children[k]->token, "(") || token_equals(&children[k]->token, "[") ||
+                       token_equals(&children[k]->token, "{")) {
+                size_t match = ast_match(ast, k);
+                if (match != AST_NO_MATCH) k = match;
+            }
+        }
 
-/* Mark a token for deletion by replacing its text with empty string */
-static void mark_for_deletion(ASTNode_t *node) {
-    if (node && node->type == AST_TOKEN && node->token.text) {
-        free(node->token.text);
-        node->token.text = strdup("");
-        node->token.length = 0;
+        /* Compare the significant tokens of each restrict argument with the other pointer arguments */
+        const RestrictFunction *function = &restricts[index];
+        for (size_t a = 0; a < argument_count; a++) {
+            if (!(function->restricted & ((uint64_t)1 << a))) continue;
+            for (size_t b = 0; b < argument_count; b++) {
+                if (b == a || !(function->pointers & ((uint64_t)1 << b))) continue;
+                if ((function->restricted & ((uint64_t)1 << b)) && b < a) continue;
+
+                size_t x = ast_skip_trivia(children, ends[a], starts[a]);
+                size_t y = ast_skip_trivia(children, ends[b], starts[b]);
+                while (x < ends[a] && y < ends[b] && token_equals(&children[x]->token, children[y]->token.text)) {
+                    x = ast_skip_trivia(children, ends[a], x + 1);
+                    y = ast_skip_trivia(children, ends[b], y + 1);
+                }
+                if (x == ends[a] && y == ends[b] && starts[a] < ends[a]) {
+                    char warning_msg[512];
+                    snprintf(warning_msg, sizeof(warning_msg), WARN_RESTRICT_ALIASED_ARGUMENT,
+                             name->text, a + 1, b + 1);
+                    cz_warning_at(filename, source, name->line, name->column, warning_msg);
+                }
+            }
+        }
+        i = close;
     }
 }
 
-/* Transform mutability in AST */
-void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const char *source) {
-    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
-        return;
-    }
-
+/* Record the mutability edits of the translation unit */
+static void rewrite_mutability(ASTNode_t *ast, ASTRewrite_t *rewrite, const char *filename, const char *source) {
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
 
@@ -196,17 +204,17 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
         Token *tok = &children[i]->token;
 
         /* Check if this is 'const' keyword in source */
-        if (token_equals(tok, "const")) {
-            cz_error(filename, source, tok->line,
+        if (token_is(tok, SYM_CONST)) {
+            cz_error_at(filename, source, tok->line, tok->column,
                 "Invalid 'const' keyword. In CZar, everything is immutable by default. Use 'mut' for mutable declarations.");
             /* Mark const for deletion to maintain consistent mut philosophy */
-            mark_for_deletion(children[i]);
+            ast_rewrite_delete(rewrite, i);
 
             /* Also mark any whitespace tokens after const for deletion */
             size_t j = i + 1;
             while (j < count && children[j]->type == AST_TOKEN &&
                    children[j]->token.type == TOKEN_WHITESPACE) {
-                mark_for_deletion(children[j]);
+                ast_rewrite_delete(rewrite, j);
                 j++;
             }
         }
@@ -225,10 +233,10 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
         Token *tok = &children[i]->token;
 
         /* Check if this is 'mut' keyword */
-        if (!token_equals(tok, "mut")) continue;
+        if (!token_is(tok, SYM_MUT)) continue;
 
         /* Found 'mut' - look for following type */
-        size_t j = skip_whitespace(children, count, i + 1);
+        size_t j = ast_skip_trivia(children, count, i + 1);
         if (j >= count) continue;
 
         if (children[j]->type == AST_TOKEN &&
@@ -241,7 +249,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             /* This ensures transitivity: mut T* means both the type identifier token T
              * at position j and the pointer operator * at position ptr_idx are mutable.
              * We mark both positions to prevent const from being added to either in Pass 2. */
-            size_t ptr_idx = skip_whitespace(children, count, j + 1);
+            size_t ptr_idx = ast_skip_trivia(children, count, j + 1);
             if (ptr_idx < count && children[ptr_idx]->type == AST_TOKEN &&
                 token_equals(&children[ptr_idx]->token, "*")) {
                 /* Mark the pointer position as mutable for transitivity */
@@ -249,13 +257,13 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             }
 
             /* Mark 'mut' for deletion */
-            mark_for_deletion(children[i]);
+            ast_rewrite_delete(rewrite, i);
 
             /* Also mark any whitespace tokens between mut and type for deletion */
             for (size_t k = i + 1; k < j; k++) {
                 if (children[k]->type == AST_TOKEN &&
                     children[k]->token.type == TOKEN_WHITESPACE) {
-                    mark_for_deletion(children[k]);
+                    ast_rewrite_delete(rewrite, k);
                 }
             }
         }
@@ -274,13 +282,13 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
         if (!is_type_keyword(tok_type->text)) continue;
 
         /* Look ahead for identifier */
-        size_t name_idx = skip_whitespace(children, count, i + 1);
+        size_t name_idx = ast_skip_trivia(children, count, i + 1);
         if (name_idx >= count) continue;
         if (children[name_idx]->type != AST_TOKEN) continue;
         if (children[name_idx]->token.type != TOKEN_IDENTIFIER) continue;
 
         /* Look ahead for ( */
-        size_t paren_idx = skip_whitespace(children, count, name_idx + 1);
+        size_t paren_idx = ast_skip_trivia(children, count, name_idx + 1);
         if (paren_idx >= count) continue;
         if (children[paren_idx]->type != AST_TOKEN) continue;
         if (!token_equals(&children[paren_idx]->token, "(")) continue;
@@ -304,7 +312,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             /* So any identifier followed by * or another identifier is a type */
             if (param_tok->type == TOKEN_IDENTIFIER) {
                 /* Look ahead to see what follows */
-                size_t next_idx = skip_whitespace(children, count, j + 1);
+                size_t next_idx = ast_skip_trivia(children, count, j + 1);
                 if (next_idx >= count || children[next_idx]->type != AST_TOKEN) continue;
 
                 Token *next_tok = &children[next_idx]->token;
@@ -315,11 +323,11 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 }
 
                 /* Skip void */
-                if (token_equals(param_tok, "void")) continue;
+                if (token_is(param_tok, SYM_VOID)) continue;
 
                 /* Skip enum/struct keywords - they're not the type name themselves */
-                if (token_equals(param_tok, "enum") || token_equals(param_tok, "struct") ||
-                    token_equals(param_tok, "union")) {
+                if (token_is(param_tok, SYM_ENUM) || token_is(param_tok, SYM_STRUCT) ||
+                    token_is(param_tok, SYM_UNION)) {
                     continue;
                 }
 
@@ -330,7 +338,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 if (is_mutable[j]) {
                     /* Error if mutable but not a pointer */
                     if (!is_pointer) {
-                        cz_error(filename, source, param_tok->line,
+                        cz_error_at(filename, source, param_tok->line, param_tok->column,
                             "Mutable parameter must be a pointer to have side effects. "
                             "Non-pointer parameters are passed by value. Use pointer type or remove 'mut'.");
                     }
@@ -347,14 +355,14 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
 
         /* Look for & operator */
         if (token_equals(tok, "&")) {
-            size_t next_idx = skip_whitespace(children, count, i + 1);
+            size_t next_idx = ast_skip_trivia(children, count, i + 1);
             if (next_idx >= count || children[next_idx]->type != AST_TOKEN) continue;
             Token *next_tok = &children[next_idx]->token;
 
             /* Check if followed by ( - potential temporary */
             if (token_equals(next_tok, "(")) {
                 /* Scan ahead to see if this is a cast expression or literal */
-                size_t peek_idx = skip_whitespace(children, count, next_idx + 1);
+                size_t peek_idx = ast_skip_trivia(children, count, next_idx + 1);
                 if (peek_idx >= count || children[peek_idx]->type != AST_TOKEN) continue;
                 Token *peek_tok = &children[peek_idx]->token;
 
@@ -366,19 +374,19 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                         "Address-of operator '&' cannot be used with literals or temporary expressions. "
                         "Assign to a variable first: e.g., 'int x = %s; int* p = &x;'",
                         peek_tok->text);
-                    cz_error(filename, source, tok->line, error_msg);
+                    cz_error_at(filename, source, tok->line, tok->column, error_msg);
                 }
 
                 /* Check for cast expression: (Type)value */
                 /* Pattern: & ( Type ) expr */
                 if (peek_tok->type == TOKEN_IDENTIFIER) {
                     /* Look ahead to see if followed by ) - could be cast */
-                    size_t after_type_idx = skip_whitespace(children, count, peek_idx + 1);
+                    size_t after_type_idx = ast_skip_trivia(children, count, peek_idx + 1);
                     if (after_type_idx < count && children[after_type_idx]->type == AST_TOKEN &&
                         token_equals(&children[after_type_idx]->token, ")")) {
                         /* This looks like a cast: &(Type)... */
                         /* Check if followed by something other than an identifier */
-                        size_t after_close_idx = skip_whitespace(children, count, after_type_idx + 1);
+                        size_t after_close_idx = ast_skip_trivia(children, count, after_type_idx + 1);
                         if (after_close_idx < count && children[after_close_idx]->type == AST_TOKEN) {
                             Token *after_close = &children[after_close_idx]->token;
                             /* If it's a number or open paren, it's likely a compound literal or cast */
@@ -388,7 +396,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                                     "Cannot take address of temporary value. "
                                     "Address-of operator '&' cannot be used with cast expressions or compound literals. "
                                     "Assign to a variable first.");
-                                cz_error(filename, source, tok->line, error_msg);
+                                cz_error_at(filename, source, tok->line, tok->column, error_msg);
                             }
                         }
                     }
@@ -448,13 +456,13 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
         /* Only process identifiers, not keywords */
         if (tok->type == TOKEN_IDENTIFIER && tok->text && tok->text[0] != '\0') {
 
-            size_t next_idx = skip_whitespace(children, count, i + 1);
+            size_t next_idx = ast_skip_trivia(children, count, i + 1);
             if (next_idx >= count || children[next_idx]->type != AST_TOKEN) continue;
             Token *next_tok = &children[next_idx]->token;
 
             /* Pattern: Type identifier = ... (non-pointer) */
             if (next_tok->type == TOKEN_IDENTIFIER) {
-                size_t after_name_idx = skip_whitespace(children, count, next_idx + 1);
+                size_t after_name_idx = ast_skip_trivia(children, count, next_idx + 1);
                 if (after_name_idx >= count || children[after_name_idx]->type != AST_TOKEN) continue;
                 Token *after_name = &children[after_name_idx]->token;
 
@@ -470,12 +478,12 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             }
             /* Pattern: Type *identifier = ... (pointer) */
             else if (token_equals(next_tok, "*")) {
-                size_t after_star_idx = skip_whitespace(children, count, next_idx + 1);
+                size_t after_star_idx = ast_skip_trivia(children, count, next_idx + 1);
                 if (after_star_idx >= count || children[after_star_idx]->type != AST_TOKEN) continue;
                 Token *after_star = &children[after_star_idx]->token;
 
                 if (after_star->type == TOKEN_IDENTIFIER) {
-                    size_t after_name_idx = skip_whitespace(children, count, after_star_idx + 1);
+                    size_t after_name_idx = ast_skip_trivia(children, count, after_star_idx + 1);
                     if (after_name_idx >= count || children[after_name_idx]->type != AST_TOKEN) continue;
                     Token *after_name = &children[after_name_idx]->token;
 
@@ -486,11 +494,11 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
 
                         if (pointer_is_mutable) {
                             /* Check if RHS is &identifier */
-                            size_t rhs_idx = skip_whitespace(children, count, after_name_idx + 1);
+                            size_t rhs_idx = ast_skip_trivia(children, count, after_name_idx + 1);
                             if (rhs_idx < count && children[rhs_idx]->type == AST_TOKEN &&
                                 token_equals(&children[rhs_idx]->token, "&")) {
 
-                                size_t target_idx = skip_whitespace(children, count, rhs_idx + 1);
+                                size_t target_idx = ast_skip_trivia(children, count, rhs_idx + 1);
                                 if (target_idx < count && children[target_idx]->type == AST_TOKEN &&
                                     children[target_idx]->token.type == TOKEN_IDENTIFIER) {
 
@@ -512,7 +520,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                                             "Variable '%s' is immutable, but pointer '%s' is declared as mutable. "
                                             "Either declare '%s' as 'mut' or remove 'mut' from the pointer declaration.",
                                             target_name, after_star->text, target_name);
-                                        cz_error(filename, source, after_star->line, error_msg);
+                                        cz_error_at(filename, source, after_star->line, after_star->column, error_msg);
                                     }
                                 }
                             }
@@ -546,6 +554,12 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
         return; /* Out of memory */
     }
 
+    /* Functions with restrict parameters: symbol ID -> index in restricts */
+    HashTable_t restrict_functions;
+    hash_table_init(&restrict_functions);
+    RestrictFunction *restricts = NULL;
+    size_t restrict_count = 0;
+
     /* Scan for function declarations and mark parameter types for const insertion */
     for (size_t i = 0; i + 2 < count; i++) {
         if (children[i]->type != AST_TOKEN) continue;
@@ -553,24 +567,30 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
 
         /* Check if this looks like: type identifier( pattern */
         /* This is more reliable for detecting function declarations */
-        if (tok_type->type != TOKEN_IDENTIFIER) continue;
+        /* (functions returning C keyword types like void only get restrict parameters) */
+        int restrict_only = tok_type->type == TOKEN_KEYWORD;
+        if (tok_type->type != TOKEN_IDENTIFIER && !restrict_only) continue;
 
         /* Check if it's a type keyword (could also be return type) */
         if (!is_type_keyword(tok_type->text)) continue;
 
         /* Look ahead for identifier */
-        size_t name_idx = skip_whitespace(children, count, i + 1);
+        size_t name_idx = ast_skip_trivia(children, count, i + 1);
         if (name_idx >= count) continue;
         if (children[name_idx]->type != AST_TOKEN) continue;
         if (children[name_idx]->token.type != TOKEN_IDENTIFIER) continue;
 
         /* Look ahead for ( */
-        size_t paren_idx = skip_whitespace(children, count, name_idx + 1);
+        size_t paren_idx = ast_skip_trivia(children, count, name_idx + 1);
         if (paren_idx >= count) continue;
         if (children[paren_idx]->type != AST_TOKEN) continue;
         if (!token_equals(&children[paren_idx]->token, "(")) continue;
 
         /* Found function declaration! Now scan the parameter list */
+        int restrict_parameters = (g_pragmas && g_pragmas->restrict_pointers) || follows_restrict_pragma(children, i);
+        if (restrict_only && !restrict_parameters) continue;
+        RestrictFunction function = {0, 0};
+        size_t parameter = 0;
         int depth = 1;
         for (size_t j = paren_idx + 1; j < count && depth > 0; j++) {
             if (children[j]->type != AST_TOKEN) continue;
@@ -581,6 +601,8 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 else if (token_equals(param_tok, ")")) {
                     depth--;
                     if (depth == 0) break; /* End of parameter list */
+                } else if (depth == 1 && token_equals(param_tok, ",")) {
+                    parameter++;
                 }
             }
 
@@ -594,7 +616,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 }
 
                 /* Look ahead to see what follows */
-                size_t next_idx = skip_whitespace(children, count, j + 1);
+                size_t next_idx = ast_skip_trivia(children, count, j + 1);
                 if (next_idx >= count || children[next_idx]->type != AST_TOKEN) continue;
 
                 Token *next_tok = &children[next_idx]->token;
@@ -605,11 +627,11 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 }
 
                 /* Skip void */
-                if (token_equals(param_tok, "void")) continue;
+                if (token_is(param_tok, SYM_VOID)) continue;
 
                 /* Skip enum/struct keywords - they're not the type name themselves */
-                if (token_equals(param_tok, "enum") || token_equals(param_tok, "struct") ||
-                    token_equals(param_tok, "union")) {
+                if (token_is(param_tok, SYM_ENUM) || token_is(param_tok, SYM_STRUCT) ||
+                    token_is(param_tok, SYM_UNION)) {
                     continue;
                 }
 
@@ -617,8 +639,8 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 size_t prev_idx;
                 if (find_prev_token(children, j, &prev_idx)) {
                     Token *prev_tok = &children[prev_idx]->token;
-                    if (token_equals(prev_tok, "enum") || token_equals(prev_tok, "struct") ||
-                        token_equals(prev_tok, "union")) {
+                    if (token_is(prev_tok, SYM_ENUM) || token_is(prev_tok, SYM_STRUCT) ||
+                        token_is(prev_tok, SYM_UNION)) {
                         continue;
                     }
                 }
@@ -626,13 +648,27 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 /* Handle pointers: add const to both type and pointer */
                 /* Pattern: Type *p becomes const Type * const p */
                 int is_pointer = token_equals(next_tok, "*");
+                if (is_pointer && parameter < 64) {
+                    function.pointers |= (uint64_t)1 << parameter;
+                }
+
+                /* Mutable single-level pointers of restrict functions: Type * restrict p */
+                size_t name_after_star = ast_skip_trivia(children, count, next_idx + 1);
+                if (restrict_parameters && is_pointer && is_mutable[j] && is_mutable[next_idx] && parameter < 64 &&
+                    name_after_star < count && children[name_after_star]->token.type == TOKEN_IDENTIFIER &&
+                    insertion_count < count * 2) {
+                    function.restricted |= (uint64_t)1 << parameter;
+                    insertions[insertion_count].position = next_idx;
+                    insertions[insertion_count].type = INSERT_RESTRICT_AFTER_STAR;
+                    insertion_count++;
+                }
 
                 /* Skip if marked as mutable */
-                if (is_mutable[j]) continue;
+                if (is_mutable[j] || restrict_only) continue;
 
                 /* Skip if already has const */
                 if (find_prev_token(children, j, &prev_idx)) {
-                    if (token_equals(&children[prev_idx]->token, "const")) {
+                    if (token_is(&children[prev_idx]->token, SYM_CONST)) {
                         continue;
                     }
                 }
@@ -659,7 +695,25 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 }
             }
         }
+
+        /* Remember restrict functions for the call site check (first declaration wins) */
+        uint64_t key = (uint64_t)cz_token_symbol(&children[name_idx]->token);
+        if (function.restricted && hash_table_get(&restrict_functions, key) == HASH_TABLE_MISSING) {
+            RestrictFunction *grown = realloc(restricts, (restrict_count + 1) * sizeof(RestrictFunction));
+            if (grown) {
+                restricts = grown;
+                restricts[restrict_count] = function;
+                hash_table_put(&restrict_functions, key, restrict_count++);
+            }
+        }
+    }
+
+    /* Pass 2.1: Flag call sites obviously aliasing restrict parameters */
+    if (restrict_count > 0) {
+        check_restrict_calls(ast, &restrict_functions, restricts, filename, source);
     }
+    hash_table_free(&restrict_functions);
+    free(restricts);
 
     /* Pass 2.5: Handle global variable declarations */
     /* Validate that immutable globals don't have dynamic initialization */
@@ -687,20 +741,20 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
         /* Look for variable declarations: Type identifier = or Type identifier; */
         if (tok->type == TOKEN_IDENTIFIER && tok->text && tok->text[0] != '\0') {
             /* Skip keywords */
-            if (token_equals(tok, "typedef") || token_equals(tok, "struct") ||
-                token_equals(tok, "enum") || token_equals(tok, "union") ||
-                token_equals(tok, "static") || token_equals(tok, "extern") ||
-                token_equals(tok, "inline")) {
+            if (token_is(tok, SYM_TYPEDEF) || token_is(tok, SYM_STRUCT) ||
+                token_is(tok, SYM_ENUM) || token_is(tok, SYM_UNION) ||
+                token_is(tok, SYM_STATIC) || token_is(tok, SYM_EXTERN) ||
+                token_is(tok, SYM_INLINE)) {
                 continue;
             }
 
-            size_t next_idx = skip_whitespace(children, count, i + 1);
+            size_t next_idx = ast_skip_trivia(children, count, i + 1);
             if (next_idx >= count || children[next_idx]->type != AST_TOKEN) continue;
             Token *next_tok = &children[next_idx]->token;
 
             /* Pattern: Type identifier = ... (non-pointer) */
             if (next_tok->type == TOKEN_IDENTIFIER) {
-                size_t after_name_idx = skip_whitespace(children, count, next_idx + 1);
+                size_t after_name_idx = ast_skip_trivia(children, count, next_idx + 1);
                 if (after_name_idx >= count || children[after_name_idx]->type != AST_TOKEN) continue;
                 Token *after_name = &children[after_name_idx]->token;
 
@@ -711,7 +765,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
 
                     /* Check if RHS has function call (dynamic initialization) */
                     int has_dynamic_init = 0;
-                    size_t rhs_start = skip_whitespace(children, count, after_name_idx + 1);
+                    size_t rhs_start = ast_skip_trivia(children, count, after_name_idx + 1);
 
                     /* Scan RHS until we hit ; or , */
                     for (size_t j = rhs_start; j < count; j++) {
@@ -725,7 +779,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
 
                         /* Check for function call: identifier followed by ( */
                         if (rhs_tok->type == TOKEN_IDENTIFIER) {
-                            size_t peek_idx = skip_whitespace(children, count, j + 1);
+                            size_t peek_idx = ast_skip_trivia(children, count, j + 1);
                             if (peek_idx < count && children[peek_idx]->type == AST_TOKEN &&
                                 token_equals(&children[peek_idx]->token, "(")) {
                                 has_dynamic_init = 1;
@@ -742,7 +796,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                             "Immutable globals cannot call functions in their initializers. "
                             "Either declare it as 'mut' or use a constant initializer.",
                             next_tok->text);
-                        cz_error(filename, source, next_tok->line, error_msg);
+                        cz_error_at(filename, source, next_tok->line, next_tok->column, error_msg);
                     }
 
                     /* Add const to immutable globals (will be done in the insertion loop) */
@@ -751,7 +805,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                         size_t prev_idx;
                         int has_const = 0;
                         if (find_prev_token(children, i, &prev_idx)) {
-                            if (token_equals(&children[prev_idx]->token, "const")) {
+                            if (token_is(&children[prev_idx]->token, SYM_CONST)) {
                                 has_const = 1;
                             }
                         }
@@ -771,7 +825,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                         size_t prev_idx;
                         int has_const = 0;
                         if (find_prev_token(children, i, &prev_idx)) {
-                            if (token_equals(&children[prev_idx]->token, "const")) {
+                            if (token_is(&children[prev_idx]->token, SYM_CONST)) {
                                 has_const = 1;
                             }
                         }
@@ -786,12 +840,12 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             }
             /* Pattern: Type *identifier = ... (pointer) - similar logic */
             else if (token_equals(next_tok, "*")) {
-                size_t after_star_idx = skip_whitespace(children, count, next_idx + 1);
+                size_t after_star_idx = ast_skip_trivia(children, count, next_idx + 1);
                 if (after_star_idx >= count || children[after_star_idx]->type != AST_TOKEN) continue;
                 Token *after_star = &children[after_star_idx]->token;
 
                 if (after_star->type == TOKEN_IDENTIFIER) {
-                    size_t after_name_idx = skip_whitespace(children, count, after_star_idx + 1);
+                    size_t after_name_idx = ast_skip_trivia(children, count, after_star_idx + 1);
                     if (after_name_idx >= count || children[after_name_idx]->type != AST_TOKEN) continue;
                     Token *after_name = &children[after_name_idx]->token;
 
@@ -800,7 +854,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                         int var_is_mutable = is_mutable[i] && is_mutable[next_idx];
 
                         int has_dynamic_init = 0;
-                        size_t rhs_start = skip_whitespace(children, count, after_name_idx + 1);
+                        size_t rhs_start = ast_skip_trivia(children, count, after_name_idx + 1);
 
                         for (size_t j = rhs_start; j < count; j++) {
                             if (children[j]->type != AST_TOKEN) continue;
@@ -811,7 +865,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                             }
 
                             if (rhs_tok->type == TOKEN_IDENTIFIER) {
-                                size_t peek_idx = skip_whitespace(children, count, j + 1);
+                                size_t peek_idx = ast_skip_trivia(children, count, j + 1);
                                 if (peek_idx < count && children[peek_idx]->type == AST_TOKEN &&
                                     token_equals(&children[peek_idx]->token, "(")) {
                                     has_dynamic_init = 1;
@@ -827,7 +881,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                                 "Immutable globals cannot call functions in their initializers. "
                                 "Either declare it as 'mut' or use a constant initializer.",
                                 after_star->text);
-                            cz_error(filename, source, after_star->line, error_msg);
+                            cz_error_at(filename, source, after_star->line, after_star->column, error_msg);
                         }
                     }
                 }
@@ -879,7 +933,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             }
 
             /* Look ahead to see what follows */
-            size_t next_idx = skip_whitespace(children, count, i + 1);
+            size_t next_idx = ast_skip_trivia(children, count, i + 1);
             if (next_idx >= count || children[next_idx]->type != AST_TOKEN) continue;
 
             Token *next_tok = &children[next_idx]->token;
@@ -892,7 +946,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             /* If followed by *, this could be pointer declaration OR multiplication */
             /* For pointer declaration, * must be followed by identifier (pointer name) */
             if (token_equals(next_tok, "*")) {
-                size_t after_star_idx = skip_whitespace(children, count, next_idx + 1);
+                size_t after_star_idx = ast_skip_trivia(children, count, next_idx + 1);
                 if (after_star_idx >= count || children[after_star_idx]->type != AST_TOKEN) continue;
                 Token *after_star = &children[after_star_idx]->token;
 
@@ -902,7 +956,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
                 }
 
                 /* Check that pointer name is followed by = or ; or , */
-                size_t after_name_idx = skip_whitespace(children, count, after_star_idx + 1);
+                size_t after_name_idx = ast_skip_trivia(children, count, after_star_idx + 1);
                 if (after_name_idx >= count || children[after_name_idx]->type != AST_TOKEN) continue;
                 Token *after_name = &children[after_name_idx]->token;
 
@@ -914,7 +968,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
 
             /* If followed by identifier, check if that's followed by = or ; */
             if (next_tok->type == TOKEN_IDENTIFIER) {
-                size_t after_name_idx = skip_whitespace(children, count, next_idx + 1);
+                size_t after_name_idx = ast_skip_trivia(children, count, next_idx + 1);
                 if (after_name_idx >= count || children[after_name_idx]->type != AST_TOKEN) continue;
                 Token *after_name = &children[after_name_idx]->token;
 
@@ -931,11 +985,19 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             }
 
             /* Skip void */
-            if (token_equals(tok, "void")) continue;
+            if (token_is(tok, SYM_VOID)) continue;
+
+            /* Skip expressions: "return a * b;" and "x = a * b;" are products, not declarations */
+            size_t before_idx;
+            if (find_prev_token(children, i, &before_idx) &&
+                (children[before_idx]->token.type == TOKEN_OPERATOR ||
+                 token_is(&children[before_idx]->token, SYM_RETURN))) {
+                continue;
+            }
 
             /* Skip enum/struct/union keywords */
-            if (token_equals(tok, "enum") || token_equals(tok, "struct") ||
-                token_equals(tok, "union")) {
+            if (token_is(tok, SYM_ENUM) || token_is(tok, SYM_STRUCT) ||
+                token_is(tok, SYM_UNION)) {
                 continue;
             }
 
@@ -943,8 +1005,8 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             size_t prev_idx;
             if (find_prev_token(children, i, &prev_idx)) {
                 Token *prev_tok = &children[prev_idx]->token;
-                if (token_equals(prev_tok, "enum") || token_equals(prev_tok, "struct") ||
-                    token_equals(prev_tok, "union")) {
+                if (token_is(prev_tok, SYM_ENUM) || token_is(prev_tok, SYM_STRUCT) ||
+                    token_is(prev_tok, SYM_UNION)) {
                     continue;
                 }
             }
@@ -957,7 +1019,7 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
 
             /* Skip if already has const */
             if (find_prev_token(children, i, &prev_idx)) {
-                if (token_equals(&children[prev_idx]->token, "const")) {
+                if (token_is(&children[prev_idx]->token, SYM_CONST)) {
                     continue;
                 }
             }
@@ -985,11 +1047,10 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
         }
     }
 
-    /* Sort insertions by position (descending) so we can insert from highest to lowest */
-    /* This way, later insertions don't affect earlier positions */
+    /* Sort insertions by position so they are recorded in order */
     qsort(insertions, insertion_count, sizeof(ConstInsertion), compare_insertions);
 
-    /* Apply all insertions in order (highest position first) */
+    /* Record all insertions (positions refer to the unmodified children) */
     for (size_t idx = 0; idx < insertion_count; idx++) {
         ConstInsertion ins = insertions[idx];
 
@@ -999,51 +1060,28 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
             ASTNode_t *space_node = create_token_node(" ", TOKEN_WHITESPACE);
 
             if (const_node && space_node) {
-                insert_node_at(ast, ins.position, const_node);
-                insert_node_at(ast, ins.position + 1, space_node);
-            } else {
-                /* Cleanup on failure */
-                if (const_node) {
-                    if (const_node->token.text) free(const_node->token.text);
-                    free(const_node);
-                }
-                if (space_node) {
-                    if (space_node->token.text) free(space_node->token.text);
-                    free(space_node);
-                }
+                ast_rewrite_insert(rewrite, ins.position, const_node);
+                ast_rewrite_insert(rewrite, ins.position, space_node);
             }
-        } else if (ins.type == INSERT_CONST_AFTER_STAR) {
-            /* Insert " const " after * */
+        } else if (ins.type == INSERT_CONST_AFTER_STAR || ins.type == INSERT_RESTRICT_AFTER_STAR) {
+            /* Insert " const " or " restrict " after * */
             /* Check if there's already whitespace after * and mark it for deletion */
             if (ins.position + 1 < ast->child_count && ast->children[ins.position + 1]->type == AST_TOKEN &&
                 ast->children[ins.position + 1]->token.type == TOKEN_WHITESPACE) {
                 /* Mark existing whitespace for deletion to avoid double spaces */
-                mark_for_deletion(ast->children[ins.position + 1]);
+                ast_rewrite_delete(rewrite, ins.position + 1);
             }
 
             /* Always insert: space + const + space */
             ASTNode_t *space1_node = create_token_node(" ", TOKEN_WHITESPACE);
-            ASTNode_t *const_node = create_token_node("const", TOKEN_KEYWORD);
+            ASTNode_t *const_node = create_token_node(ins.type == INSERT_RESTRICT_AFTER_STAR ? "restrict" : "const",
+                                                      TOKEN_KEYWORD);
             ASTNode_t *space2_node = create_token_node(" ", TOKEN_WHITESPACE);
 
             if (space1_node && const_node && space2_node) {
-                insert_node_at(ast, ins.position + 1, space1_node);
-                insert_node_at(ast, ins.position + 2, const_node);
-                insert_node_at(ast, ins.position + 3, space2_node);
-            } else {
-                /* Cleanup */
-                if (space1_node) {
-                    if (space1_node->token.text) free(space1_node->token.text);
-                    free(space1_node);
-                }
-                if (const_node) {
-                    if (const_node->token.text) free(const_node->token.text);
-                    free(const_node);
-                }
-                if (space2_node) {
-                    if (space2_node->token.text) free(space2_node->token.text);
-                    free(space2_node);
-                }
+                ast_rewrite_insert(rewrite, ins.position + 1, space1_node);
+                ast_rewrite_insert(rewrite, ins.position + 1, const_node);
+                ast_rewrite_insert(rewrite, ins.position + 1, space2_node);
             }
         }
     }
@@ -1051,3 +1089,15 @@ void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const
     free(insertions);
     free(is_mutable);
 }
+
+/* Transform mutability in AST */
+void transpiler_transform_mutability(ASTNode_t *ast, const char *filename, const char *source) {
+    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
+        return;
+    }
+
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
+    rewrite_mutability(ast, &rewrite, filename, source);
+    ast_rewrite_commit(&rewrite);
+}
@@ -12,10 +12,17 @@
 #include <ctype.h>
 #include <stdlib.h>
 
+/* Settings of the translation unit being transpiled */
+CZ_THREAD_LOCAL const PragmaContext *g_pragmas = NULL;
+
 /* Initialize pragma context with defaults */
 void pragma_context_init(PragmaContext *ctx) {
     if (!ctx) return;
     ctx->debug_mode = 1;  /* Default: debug on */
+    ctx->defer_inline = 0;  /* Default: cleanup functions */
+    ctx->simd = 0;  /* Default: no vectorization hints */
+    ctx->layout_compact = 0;  /* Default: fields in declaration order */
+    ctx->restrict_pointers = 0;  /* Default: restrict only after #pragma czar restrict */
 }
 
 /* Check if string starts with prefix (case insensitive for whitespace-trimmed strings) */
@@ -65,9 +72,72 @@ static void parse_pragma_czar(const char *pragma_text, PragmaContext *ctx) {
         }
         /* Else: ignore invalid values, keep current setting */
     }
+    /* Parse "defer" directive */
+    else if (starts_with(pragma_text, "defer")) {
+        pragma_text = extract_word_after(pragma_text, "defer");
+        if (!pragma_text) return;
+
+        /* Parse inline/cleanup */
+        if (starts_with(pragma_text, "inline")) {
+            ctx->defer_inline = 1;
+        } else if (starts_with(pragma_text, "cleanup")) {
+            ctx->defer_inline = 0;
+        }
+        /* Else: ignore invalid values, keep current setting */
+    }
+    /* Parse "simd" directive (alone or followed by true/false) */
+    else if (starts_with(pragma_text, "simd")) {
+        pragma_text = extract_word_after(pragma_text, "simd");
+        if (!pragma_text) return;
+
+        ctx->simd = !starts_with(pragma_text, "false");
+    }
+    /* Parse "layout" directive: layout(compact) or layout(natural) */
+    else if (starts_with(pragma_text, "layout")) {
+        pragma_text = extract_word_after(pragma_text, "layout");
+        if (!pragma_text) return;
+        if (*pragma_text == '(') {
+            pragma_text++;
+        }
+
+        if (starts_with(pragma_text, "compact")) {
+            ctx->layout_compact = 1;
+        } else if (starts_with(pragma_text, "natural")) {
+            ctx->layout_compact = 0;
+        }
+        /* Else: ignore invalid values, keep current setting */
+    }
+    /* Parse "restrict" directive followed by true/false (alone, it applies to the next function) */
+    else if (starts_with(pragma_text, "restrict")) {
+        pragma_text = extract_word_after(pragma_text, "restrict");
+        if (!pragma_text) return;
+
+        if (starts_with(pragma_text, "true")) {
+            ctx->restrict_pointers = 1;
+        } else if (starts_with(pragma_text, "false")) {
+            ctx->restrict_pointers = 0;
+        }
+    }
     /* Other pragma directives can be added here in the future */
 }
 
+/* Check if a preprocessor token is "#pragma czar <directive>" (for directives applying to the next statement) */
+int pragma_czar_is(const Token *token, const char *directive) {
+    if (!token || token->type != TOKEN_PREPROCESSOR || !token->text || !directive) return 0;
+
+    const char *text = token->text;
+    while (*text && (isspace((unsigned char)*text) || *text == '#')) {
+        text++;
+    }
+    text = extract_word_after(text, "pragma");
+    text = text ? extract_word_after(text, "czar") : NULL;
+    if (!text || !starts_with(text, directive)) return 0;
+
+    /* The directive is a whole word, possibly followed by arguments */
+    char next = text[strlen(directive)];
+    return next == '\0' || next == '(' || isspace((unsigned char)next);
+}
+
 /* Parse and apply #pragma czar directives from AST */
 void transpiler_parse_pragmas(ASTNode_t *ast, PragmaContext *ctx) {
     if (!ast || !ctx) return;
@@ -9,14 +9,25 @@
 #pragma once
 
 #include "../parser.h"
+#include "../worker.h"
 
 /* Pragma context for storing parsed pragma settings */
 typedef struct {
     int debug_mode;  /* 1 = debug on (default), 0 = debug off */
+    int defer_inline; /* 1 = #defer bodies expanded at each scope exit, 0 = cleanup functions (default) */
+    int simd;         /* 1 = foreach loops carry vectorization hints, 0 = none (default) */
+    int layout_compact; /* 1 = private struct fields sorted by alignment, 0 = declaration order (default) */
+    int restrict_pointers; /* 1 = mut pointer parameters are restrict, 0 = only in functions after the pragma (default) */
 } PragmaContext;
 
+/* Settings of the translation unit being transpiled (NULL when none is active) */
+extern CZ_THREAD_LOCAL const PragmaContext *g_pragmas;
+
 /* Initialize pragma context with defaults */
 void pragma_context_init(PragmaContext *ctx);
 
 /* Parse and apply #pragma czar directives from AST */
 void transpiler_parse_pragmas(ASTNode_t *ast, PragmaContext *ctx);
+
+/* Check if a preprocessor token is "#pragma czar <directive>" (for directives applying to the next statement) */
+int pragma_czar_is(const Token *token, const char *directive);
@@ -0,0 +1,351 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Block-scoped symbol table shared by features that resolve local names.
+ */
+
+#include "cz.h"
+#include "scopes.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Initialize an empty table at file scope */
+void scope_init(ScopeTable_t *table) {
+    table->bindings = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->blocks = NULL;
+    table->depth = 0;
+    table->block_capacity = 0;
+    hash_table_init(&table->index);
+}
+
+/* Drop every block and binding, keeping the memory */
+void scope_clear(ScopeTable_t *table) {
+    table->count = 0;
+    table->depth = 0;
+    hash_table_clear(&table->index);
+}
+
+/* Free a table */
+void scope_free(ScopeTable_t *table) {
+    free(table->bindings);
+    free(table->blocks);
+    hash_table_free(&table->index);
+    scope_init(table);
+}
+
+/* Get the bytes held by a table */
+size_t scope_bytes(const ScopeTable_t *table) {
+    return table->capacity * sizeof(ScopeBinding_t) + table->block_capacity * sizeof(ScopeBlock_t) +
+           hash_table_bytes(&table->index);
+}
+
+/* Open a block tagged with tag, returns false on allocation failure */
+bool scope_push(ScopeTable_t *table, size_t tag) {
+    if (table->depth >= table->block_capacity) {
+        size_t new_capacity = table->block_capacity == 0 ? 16 : table->block_capacity * 2;
+        ScopeBlock_t *new_blocks = realloc(table->blocks, new_capacity * sizeof(ScopeBlock_t));
+        if (!new_blocks) {
+            return false;
+        }
+        table->blocks = new_blocks;
+        table->block_capacity = new_capacity;
+    }
+    table->blocks[table->depth].binding_count = table->count;
+    table->blocks[table->depth].tag = tag;
+    table->depth++;
+    return true;
+}
+
+/* Close the innermost block, uncovering the names it shadowed (no-op at file scope) */
+void scope_pop(ScopeTable_t *table) {
+    if (table->depth == 0) {
+        return;
+    }
+    table->depth--;
+    size_t first = table->blocks[table->depth].binding_count;
+    while (table->count > first) {
+        table->count--;
+        const ScopeBinding_t *binding = &table->bindings[table->count];
+        /* A missing shadowed binding reads back as HASH_TABLE_MISSING, like an unbound name */
+        hash_table_put(&table->index, (uint64_t)(uint32_t)binding->name, binding->shadowed);
+    }
+}
+
+/* Get the tag of the open block at level (0 is the outermost), or HASH_TABLE_MISSING */
+size_t scope_tag(const ScopeTable_t *table, size_t level) {
+    return level < table->depth ? table->blocks[level].tag : HASH_TABLE_MISSING;
+}
+
+/* Bind name to value in the innermost block, returns false on allocation failure */
+bool scope_bind(ScopeTable_t *table, int name, size_t value) {
+    if (name == SYM_NONE) {
+        return false;
+    }
+    if (table->count >= table->capacity) {
+        size_t new_capacity = table->capacity == 0 ? 64 : table->capacity * 2;
+        ScopeBinding_t *new_bindings = realloc(table->bindings, new_capacity * sizeof(ScopeBinding_t));
+        if (!new_bindings) {
+            return false;
+        }
+        table->bindings = new_bindings;
+        table->capacity = new_capacity;
+    }
+
+    /* The earlier binding of the name, in this block or an outer one, comes back on pop */
+    uint64_t key = (uint64_t)(uint32_t)name;
+    size_t shadowed = hash_table_get(&table->index, key);
+    if (!hash_table_put(&table->index, key, table->count)) {
+        return false;
+    }
+    ScopeBinding_t *binding = &table->bindings[table->count];
+    binding->name = name;
+    binding->value = value;
+    binding->shadowed = shadowed;
+    table->count++;
+    return true;
+}
+
+/* Get the value of the innermost binding of name, or HASH_TABLE_MISSING */
+size_t scope_lookup(const ScopeTable_t *table, int name) {
+    size_t index = hash_table_get(&table->index, (uint64_t)(uint32_t)name);
+    return index == HASH_TABLE_MISSING ? HASH_TABLE_MISSING : table->bindings[index].value;
+}
+
+/* Open or close a block if the token at index is '{' or '}' (new blocks get tag) */
+void scope_track_braces(ScopeTable_t *table, ASTNode_t **children, size_t index, size_t tag) {
+    const Token *token = &children[index]->token;
+    if (children[index]->type != AST_TOKEN || token->type != TOKEN_PUNCTUATION || !token->text) {
+        return;
+    }
+    if (strcmp(token->text, "{") == 0) {
+        scope_push(table, tag);
+    } else if (strcmp(token->text, "}") == 0) {
+        scope_pop(table);
+    }
+}
+
+/* Check if a token can be part of a declaration's type or name */
+static bool is_declaration_word(const Token *token) {
+    if (token->type == TOKEN_IDENTIFIER) {
+        return true;
+    }
+    if (token->type != TOKEN_KEYWORD) {
+        return false;
+    }
+    switch (token->symbol) {
+        case SYM_AUTO: case SYM_BOOL: case SYM_CHAR: case SYM_CONST: case SYM_DOUBLE:
+        case SYM_ENUM: case SYM_FLOAT: case SYM_INT: case SYM_LONG: case SYM_MUT:
+        case SYM_REGISTER: case SYM_RESTRICT: case SYM_SHORT: case SYM_SIGNED: case SYM_STATIC:
+        case SYM_STRUCT: case SYM_UNION: case SYM_UNSIGNED: case SYM_VOID: case SYM_VOLATILE:
+        case SYM_ATOMIC: case SYM_THREAD_LOCAL:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* Check if a token is a run of pointer markers */
+static bool is_pointer_marker(const Token *token) {
+    return token->type == TOKEN_OPERATOR && token->text && token->text[0] == '*' &&
+           token->text[strspn(token->text, "*")] == '\0';
+}
+
+/* Match a local declaration starting at index, right after '{', '}' or ';'.
+ * Only the first declarator is matched: "T *a, b;" declares a. */
+bool scope_match_declaration(ASTNode_t **children, size_t count, size_t index, ScopeDeclaration_t *declaration) {
+    if (index >= count || children[index]->type != AST_TOKEN || !is_declaration_word(&children[index]->token)) {
+        return false;
+    }
+    size_t prev = ast_prev_significant(children, index);
+    if (prev != AST_NO_MATCH) {
+        const Token *before = &children[prev]->token;
+        if (before->type != TOKEN_PUNCTUATION || !before->text ||
+            (strcmp(before->text, "{") != 0 && strcmp(before->text, "}") != 0 && strcmp(before->text, ";") != 0)) {
+            return false;
+        }
+    }
+
+    size_t type = AST_NO_MATCH;
+    size_t name = AST_NO_MATCH;
+    bool pointer = false;
+    size_t i = index;
+    while (i < count && children[i]->type == AST_TOKEN) {
+        const Token *token = &children[i]->token;
+        if (is_declaration_word(token)) {
+            type = name;
+            name = i;
+        } else if (is_pointer_marker(token)) {
+            pointer = true;
+        } else {
+            break;
+        }
+        i = ast_skip_trivia(children, count, i + 1);
+    }
+
+    /* "type name" then '=', ';', ',' or '[' */
+    if (type == AST_NO_MATCH || i >= count || children[i]->type != AST_TOKEN ||
+        children[name]->token.type != TOKEN_IDENTIFIER) {
+        return false;
+    }
+    const Token *next = &children[i]->token;
+    if (!next->text || (strcmp(next->text, "=") != 0 && strcmp(next->text, ";") != 0 &&
+                        strcmp(next->text, ",") != 0 && strcmp(next->text, "[") != 0)) {
+        return false;
+    }
+
+    declaration->type = type;
+    declaration->name = name;
+    declaration->pointer = pointer;
+    return true;
+}
+
+/* Scope map of the translation unit it was built for */
+typedef struct {
+    const ASTNode_t *ast;       /* Translation unit the entries describe */
+    unsigned long structure;    /* ast_structure_generation() when built */
+    unsigned long brackets;     /* token_bracket_generation() when built */
+    ScopeEntry_t *entries;      /* One entry per child */
+    size_t count;               /* Number of entries */
+    size_t capacity;            /* Capacity of entries array */
+} ScopeMap_t;
+
+static CZ_THREAD_LOCAL ScopeMap_t scope_map;
+
+/* Check if a token is the struct, union or enum keyword */
+static bool is_aggregate_keyword(const Token *token) {
+    return (token->type == TOKEN_KEYWORD || token->type == TOKEN_IDENTIFIER) && token->text &&
+           (strcmp(token->text, "struct") == 0 || strcmp(token->text, "union") == 0 ||
+            strcmp(token->text, "enum") == 0);
+}
+
+/* Check if the block opening at brace is a struct/union/enum body: "struct [Name] {" */
+static bool is_aggregate_body(ASTNode_t **children, size_t brace) {
+    size_t prev = ast_prev_significant(children, brace);
+    if (prev != AST_NO_MATCH && children[prev]->token.type == TOKEN_IDENTIFIER &&
+        !is_aggregate_keyword(&children[prev]->token)) {
+        prev = ast_prev_significant(children, prev);
+    }
+    return prev != AST_NO_MATCH && is_aggregate_keyword(&children[prev]->token);
+}
+
+/* Get the position of the name of the function whose body opens at brace, or AST_NO_MATCH.
+ * "name ( ... ) [__attribute__((...))...] {" */
+static size_t find_function_name(ASTNode_t *ast, size_t brace) {
+    ASTNode_t **children = ast->children;
+    size_t close = ast_prev_significant(children, brace);
+    while (close != AST_NO_MATCH && children[close]->token.text &&
+           strcmp(children[close]->token.text, ")") == 0) {
+        size_t open = ast_match(ast, close);
+        size_t name = open == AST_NO_MATCH ? AST_NO_MATCH : ast_prev_significant(children, open);
+        if (name == AST_NO_MATCH || children[name]->token.type != TOKEN_IDENTIFIER) {
+            return AST_NO_MATCH;
+        }
+        if (strcmp(children[name]->token.text, "__attribute__") != 0 &&
+            strcmp(children[name]->token.text, "__declspec") != 0) {
+            return name;
+        }
+        close = ast_prev_significant(children, name);
+    }
+    return AST_NO_MATCH;
+}
+
+/* Rebuild the scope map of ast in one pass over its children */
+static bool scope_map_build(ASTNode_t *ast) {
+    size_t count = ast->child_count;
+    if (count > scope_map.capacity) {
+        ScopeEntry_t *new_entries = realloc(scope_map.entries, count * sizeof(ScopeEntry_t));
+        if (!new_entries) {
+            return false;
+        }
+        scope_map.entries = new_entries;
+        scope_map.capacity = count;
+    }
+
+    /* Open blocks, innermost last (each stored as the entry of its brace) */
+    ScopeEntry_t *stack = NULL;
+    size_t depth = 0;
+    size_t stack_capacity = 0;
+    ScopeEntry_t current = {AST_NO_MATCH, 0, SCOPE_FILE};
+    ASTNode_t **children = ast->children;
+    for (size_t i = 0; i < count; i++) {
+        const Token *token = &children[i]->token;
+        bool punctuation = children[i]->type == AST_TOKEN && token->type == TOKEN_PUNCTUATION && token->text;
+
+        if (punctuation && strcmp(token->text, "{") == 0) {
+            if (depth >= stack_capacity) {
+                size_t new_capacity = stack_capacity == 0 ? 16 : stack_capacity * 2;
+                ScopeEntry_t *new_stack = realloc(stack, new_capacity * sizeof(ScopeEntry_t));
+                if (!new_stack) {
+                    free(stack);
+                    return false;
+                }
+                stack = new_stack;
+                stack_capacity = new_capacity;
+            }
+            stack[depth++] = current;
+
+            if (current.kind == SCOPE_AGGREGATE || is_aggregate_body(children, i)) {
+                current.kind = SCOPE_AGGREGATE;
+            } else if (current.kind == SCOPE_FILE) {
+                size_t close = ast_prev_significant(children, i);
+                bool function = close != AST_NO_MATCH && children[close]->token.text &&
+                                strcmp(children[close]->token.text, ")") == 0;
+                current.kind = function ? SCOPE_FUNCTION : SCOPE_OTHER;
+                current.function = function ? find_function_name(ast, i) : AST_NO_MATCH;
+            }
+            current.depth = (unsigned int)depth;
+            scope_map.entries[i] = current;
+        } else if (punctuation && strcmp(token->text, "}") == 0 && depth > 0) {
+            scope_map.entries[i] = current;
+            current = stack[--depth];
+        } else {
+            scope_map.entries[i] = current;
+        }
+    }
+    free(stack);
+
+    scope_map.ast = ast;
+    scope_map.structure = ast_structure_generation();
+    scope_map.brackets = token_bracket_generation();
+    scope_map.count = count;
+    return true;
+}
+
+/* Get the scope of child index of a translation unit (the map is rebuilt when children change) */
+const ScopeEntry_t *scope_map_at(ASTNode_t *ast, size_t index) {
+    static const ScopeEntry_t file_scope = {AST_NO_MATCH, 0, SCOPE_FILE};
+    if (!ast || index >= ast->child_count) {
+        return &file_scope;
+    }
+    if (scope_map.ast != ast || scope_map.count != ast->child_count ||
+        scope_map.structure != ast_structure_generation() ||
+        scope_map.brackets != token_bracket_generation()) {
+        if (!scope_map_build(ast)) {
+            scope_map.ast = NULL;
+            return &file_scope;
+        }
+    }
+    return &scope_map.entries[index];
+}
+
+/* Get the name of the function enclosing child index, or NULL outside function bodies */
+const char *scope_map_function(ASTNode_t *ast, size_t index) {
+    const ScopeEntry_t *entry = scope_map_at(ast, index);
+    if (entry->kind != SCOPE_FUNCTION || entry->function == AST_NO_MATCH) {
+        return NULL;
+    }
+    return ast->children[entry->function]->token.text;
+}
+
+/* Release the scope map of the current translation unit */
+void scope_map_free(void) {
+    free(scope_map.entries);
+    scope_map.ast = NULL;
+    scope_map.entries = NULL;
+    scope_map.count = 0;
+    scope_map.capacity = 0;
+}
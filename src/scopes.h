@@ -0,0 +1,109 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Block-scoped symbol table shared by features that resolve local names
+ * (autodereference, methods, validation): blocks are pushed on '{' and popped
+ * on '}', inner bindings shadow outer ones and lookups are hashed.
+ *
+ * Also a scope map of the translation unit: the brace depth, kind of block and
+ * enclosing function of every child, built in one pass and rebuilt only after
+ * the children change, so features query it in O(1) instead of rescanning.
+ */
+
+#pragma once
+
+#include "../parser.h"
+#include "../hashtable.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/* One name bound in a block */
+typedef struct {
+    int name;                /* Symbol ID from the shared interner */
+    size_t value;            /* Value chosen by the feature */
+    size_t shadowed;         /* Binding hidden by this one, or HASH_TABLE_MISSING */
+} ScopeBinding_t;
+
+/* One open block */
+typedef struct {
+    size_t binding_count;    /* Bindings made before the block was opened */
+    size_t tag;              /* Value chosen by the feature (kind of block, owner...) */
+} ScopeBlock_t;
+
+/* Names bound in the open blocks, innermost last */
+typedef struct {
+    ScopeBinding_t *bindings; /* Bindings in declaration order */
+    size_t count;             /* Number of bindings */
+    size_t capacity;          /* Capacity of bindings array */
+    ScopeBlock_t *blocks;     /* Open blocks, outermost first */
+    size_t depth;             /* Number of open blocks (0 at file scope) */
+    size_t block_capacity;    /* Capacity of blocks array */
+    HashTable_t index;        /* Symbol ID -> innermost binding */
+} ScopeTable_t;
+
+/* A declaration "type [*...] name" found at the start of a statement */
+typedef struct {
+    size_t type;             /* Position of the last type word before the name */
+    size_t name;             /* Position of the declared name */
+    bool pointer;            /* A '*' was found between the type and the name */
+} ScopeDeclaration_t;
+
+/* Initialize an empty table at file scope */
+void scope_init(ScopeTable_t *table);
+
+/* Drop every block and binding, keeping the memory */
+void scope_clear(ScopeTable_t *table);
+
+/* Free a table */
+void scope_free(ScopeTable_t *table);
+
+/* Get the bytes held by a table */
+size_t scope_bytes(const ScopeTable_t *table);
+
+/* Open a block tagged with tag, returns false on allocation failure */
+bool scope_push(ScopeTable_t *table, size_t tag);
+
+/* Close the innermost block, uncovering the names it shadowed (no-op at file scope) */
+void scope_pop(ScopeTable_t *table);
+
+/* Get the tag of the open block at level (0 is the outermost), or HASH_TABLE_MISSING */
+size_t scope_tag(const ScopeTable_t *table, size_t level);
+
+/* Bind name to value in the innermost block, returns false on allocation failure */
+bool scope_bind(ScopeTable_t *table, int name, size_t value);
+
+/* Get the value of the innermost binding of name, or HASH_TABLE_MISSING */
+size_t scope_lookup(const ScopeTable_t *table, int name);
+
+/* Open or close a block if the token at index is '{' or '}' (new blocks get tag) */
+void scope_track_braces(ScopeTable_t *table, ASTNode_t **children, size_t index, size_t tag);
+
+/* Match a local declaration starting at index, right after '{', '}' or ';'.
+ * Only the first declarator is matched: "T *a, b;" declares a. */
+bool scope_match_declaration(ASTNode_t **children, size_t count, size_t index, ScopeDeclaration_t *declaration);
+
+/* Kind of the innermost block enclosing a child */
+typedef enum {
+    SCOPE_FILE,              /* Not inside any braces */
+    SCOPE_FUNCTION,          /* Inside a function body (or a block nested in one) */
+    SCOPE_AGGREGATE,         /* Inside a struct/union/enum body (or a block nested in one) */
+    SCOPE_OTHER              /* Inside braces at file scope that are neither (initializers...) */
+} ScopeKind_t;
+
+/* Scope of one child, the braces of a block belong to it */
+typedef struct {
+    size_t function;         /* Position of the enclosing function's name, or AST_NO_MATCH */
+    unsigned int depth;      /* Number of blocks enclosing the child */
+    unsigned char kind;      /* ScopeKind_t of the innermost block */
+} ScopeEntry_t;
+
+/* Get the scope of child index of a translation unit (the map is rebuilt when children change) */
+const ScopeEntry_t *scope_map_at(ASTNode_t *ast, size_t index);
+
+/* Get the name of the function enclosing child index, or NULL outside function bodies */
+const char *scope_map_function(ASTNode_t *ast, size_t index);
+
+/* Release the scope map of the current translation unit */
+void scope_map_free(void);
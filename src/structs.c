@@ -11,76 +11,708 @@
 
 #include "cz.h"
 #include "structs.h"
+#include "headers.h"
+#include "types.h"
+#include "pragma.h"
+#include "errors.h"
+#include "../rewrite.h"
+#include "../hashtable.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <ctype.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <dirent.h>
-#include <unistd.h>
 
-/* Maximum struct name lengths */
-#define MAX_STRUCT_NAME_LEN 509  /* Leave room for "_t" suffix and null terminator */
-#define MAX_TYPEDEF_NAME_LEN 512 /* MAX_STRUCT_NAME_LEN + "_t" (2) + null (1) */
-#define MAX_PATH_LEN 600
+/* Maximum typedef name length ("_t" suffix and null terminator included) */
+#define MAX_TYPEDEF_NAME_LEN 512
 
-/* Maximum number of struct names we can track */
-#define MAX_STRUCT_NAMES 256
-
-/* Tracked struct names */
+/* Tracked struct names (symbol IDs from the shared interner) */
 typedef struct {
-    char *original_name;  /* e.g., "Vec2" */
-    char *typedef_name;   /* e.g., "Vec2_t" */
+    int original_name;    /* e.g., "Vec2" */
+    int typedef_name;     /* e.g., "Vec2_t" */
 } StructNameMapping;
 
-static StructNameMapping struct_name_mappings[MAX_STRUCT_NAMES];
-static size_t struct_name_count = 0;
+static CZ_THREAD_LOCAL StructNameMapping *struct_name_mappings = NULL;
+static CZ_THREAD_LOCAL size_t struct_name_count = 0;
+static CZ_THREAD_LOCAL size_t struct_name_capacity = 0;
+
+/* Original name ID -> index in struct_name_mappings */
+static CZ_THREAD_LOCAL HashTable_t struct_name_index;
+
+/* Estimated layout of a struct of the translation unit (by base name) */
+typedef struct {
+    int name;             /* Symbol ID of the base name, e.g. "Vec2" */
+    size_t size;          /* Size in bytes */
+    size_t align;         /* Alignment in bytes */
+} StructLayout_t;
+
+static CZ_THREAD_LOCAL StructLayout_t *struct_layouts = NULL;
+static CZ_THREAD_LOCAL size_t struct_layout_count = 0;
+static CZ_THREAD_LOCAL size_t struct_layout_capacity = 0;
+
+/* Base name ID -> index in struct_layouts */
+static CZ_THREAD_LOCAL HashTable_t struct_layout_index;
+
+/* Stream receiving struct layout reports (cz --layout-report, NULL when off) */
+CZ_THREAD_LOCAL FILE *g_layout_report = NULL;
 
 /* Track a struct name mapping */
 static void track_struct_name(const char *original, const char *typedef_name) {
-    if (struct_name_count >= MAX_STRUCT_NAMES) {
+    /* Check if already tracked */
+    int original_id = cz_intern(original);
+    int typedef_id = cz_intern(typedef_name);
+    if (original_id == SYM_NONE || typedef_id == SYM_NONE) {
         return;
     }
-    
-    /* Check if already tracked */
-    for (size_t i = 0; i < struct_name_count; i++) {
-        if (struct_name_mappings[i].original_name &&
-            strcmp(struct_name_mappings[i].original_name, original) == 0) {
+    if (hash_table_get(&struct_name_index, (uint64_t)(uint32_t)original_id) != HASH_TABLE_MISSING) {
+        return;
+    }
+
+    if (struct_name_count >= struct_name_capacity) {
+        size_t new_capacity = struct_name_capacity == 0 ? 16 : struct_name_capacity * 2;
+        StructNameMapping *new_mappings = realloc(struct_name_mappings, new_capacity * sizeof(StructNameMapping));
+        if (!new_mappings) {
             return;
         }
+        struct_name_mappings = new_mappings;
+        struct_name_capacity = new_capacity;
     }
-    
-    char *orig_copy = strdup(original);
-    char *typedef_copy = strdup(typedef_name);
-    if (!orig_copy || !typedef_copy) {
-        free(orig_copy);
-        free(typedef_copy);
+
+    if (!hash_table_put(&struct_name_index, (uint64_t)(uint32_t)original_id, struct_name_count)) {
         return;
     }
-    
-    struct_name_mappings[struct_name_count].original_name = orig_copy;
-    struct_name_mappings[struct_name_count].typedef_name = typedef_copy;
+    struct_name_mappings[struct_name_count].original_name = original_id;
+    struct_name_mappings[struct_name_count].typedef_name = typedef_id;
     struct_name_count++;
 }
 
 /* Get typedef name for a struct (returns NULL if not tracked) */
-static const char* get_typedef_name(const char *original) {
-    for (size_t i = 0; i < struct_name_count; i++) {
-        if (struct_name_mappings[i].original_name &&
-            strcmp(struct_name_mappings[i].original_name, original) == 0) {
-            return struct_name_mappings[i].typedef_name;
+static const char* get_typedef_name(const Token *original) {
+    if (struct_name_count == 0) {
+        return NULL;
+    }
+    size_t index = hash_table_get(&struct_name_index, (uint64_t)(uint32_t)cz_token_symbol(original));
+    return index == HASH_TABLE_MISSING ? NULL : cz_symbol_name(struct_name_mappings[index].typedef_name);
+}
+
+/* Release the struct name mappings of the current translation unit */
+void transpiler_free_struct_tables(void) {
+    free(struct_name_mappings);
+    struct_name_mappings = NULL;
+    struct_name_count = 0;
+    struct_name_capacity = 0;
+    hash_table_free(&struct_name_index);
+    free(struct_layouts);
+    struct_layouts = NULL;
+    struct_layout_count = 0;
+    struct_layout_capacity = 0;
+    hash_table_free(&struct_layout_index);
+}
+
+/* Get the bytes held by the struct name mappings and layouts (cz --stats) */
+size_t transpiler_struct_table_bytes(void) {
+    return struct_name_capacity * sizeof(StructNameMapping) + hash_table_bytes(&struct_name_index) +
+           struct_layout_capacity * sizeof(StructLayout_t) + hash_table_bytes(&struct_layout_index);
+}
+
+/* Maximum words of a field type, e.g. "const unsigned long long" */
+#define MAX_FIELD_WORDS 8
+
+/* One field of a struct body with its estimated layout */
+typedef struct {
+    const char *name;     /* Field name */
+    size_t size;          /* Size in bytes (every element of arrays) */
+    size_t align;         /* Alignment in bytes */
+} StructField_t;
+
+/* One declaration of a struct body ("T a, *b;" declares two fields) */
+typedef struct {
+    size_t start;         /* First child, leading whitespace and comments included */
+    size_t end;           /* Child after its ';' and the comment trailing it on the same line */
+    size_t first_field;   /* Index of its first field */
+    size_t field_count;   /* Number of fields it declares */
+    size_t align;         /* Strictest alignment of its fields */
+} StructDeclaration_t;
+
+/* Fields and declarations of one struct body (layout is false when a field can't be estimated) */
+typedef struct {
+    StructField_t *fields;
+    size_t field_count;
+    size_t field_capacity;
+    StructDeclaration_t *declarations;
+    size_t declaration_count;
+    size_t declaration_capacity;
+    bool layout;          /* Every field has a known size and alignment */
+    const char *unknown;  /* Text near the first field that couldn't be estimated */
+} StructBody_t;
+
+/* Record the layout of a struct of the translation unit */
+static void track_struct_layout(const char *name, size_t size, size_t align) {
+    int name_id = cz_intern(name);
+    if (name_id == SYM_NONE || hash_table_get(&struct_layout_index, (uint64_t)(uint32_t)name_id) != HASH_TABLE_MISSING) {
+        return;
+    }
+    if (struct_layout_count >= struct_layout_capacity) {
+        size_t new_capacity = struct_layout_capacity == 0 ? 16 : struct_layout_capacity * 2;
+        StructLayout_t *new_layouts = realloc(struct_layouts, new_capacity * sizeof(StructLayout_t));
+        if (!new_layouts) {
+            return;
+        }
+        struct_layouts = new_layouts;
+        struct_layout_capacity = new_capacity;
+    }
+    if (!hash_table_put(&struct_layout_index, (uint64_t)(uint32_t)name_id, struct_layout_count)) {
+        return;
+    }
+    struct_layouts[struct_layout_count].name = name_id;
+    struct_layouts[struct_layout_count].size = size;
+    struct_layouts[struct_layout_count].align = align;
+    struct_layout_count++;
+}
+
+/* Find the layout of a struct of the translation unit by base name or Name_t, returns false if unknown */
+static bool find_struct_layout(const char *name, size_t *size, size_t *align) {
+    char base[MAX_TYPEDEF_NAME_LEN];
+    size_t len = strlen(name);
+    if (len >= sizeof(base)) {
+        return false;
+    }
+    memcpy(base, name, len + 1);
+    if (len > 2 && strcmp(base + len - 2, "_t") == 0) {
+        base[len - 2] = '\0';
+    }
+    int name_id = cz_intern(base);
+    size_t index = name_id == SYM_NONE ? HASH_TABLE_MISSING : hash_table_get(&struct_layout_index, (uint64_t)(uint32_t)name_id);
+    if (index == HASH_TABLE_MISSING) {
+        return false;
+    }
+    *size = struct_layouts[index].size;
+    *align = struct_layouts[index].align;
+    return true;
+}
+
+/* Resolve the layout of a field type from its words (qualifiers skipped), returns false if unknown */
+static bool resolve_field_type(ASTNode_t **children, const size_t *words, size_t count, size_t *size, size_t *align) {
+    char spelling[128];
+    size_t used = 0;
+    spelling[0] = '\0';
+    for (size_t w = 0; w < count; w++) {
+        const char *text = children[words[w]]->token.text;
+        if (strcmp(text, "const") == 0 || strcmp(text, "volatile") == 0 || strcmp(text, "mut") == 0) {
+            continue;
+        }
+        /* "struct Name" and "enum Name" tags, unions are never estimated */
+        if (strcmp(text, "struct") == 0) {
+            return w + 2 == count && find_struct_layout(children[words[w + 1]]->token.text, size, align);
+        }
+        if (strcmp(text, "enum") == 0) {
+            return transpiler_get_type_layout("int", size, align);
+        }
+        int written = snprintf(spelling + used, sizeof(spelling) - used, "%s%s", used ? " " : "", text);
+        if (written < 0 || (size_t)written >= sizeof(spelling) - used) {
+            return false;
+        }
+        used += (size_t)written;
+    }
+    if (used == 0) {
+        return false;
+    }
+    return transpiler_get_type_layout(spelling, size, align) || find_struct_layout(spelling, size, align);
+}
+
+/* Check if a token is a word of a declaration */
+static bool is_field_word(const Token *token) {
+    return (token->type == TOKEN_IDENTIFIER || token->type == TOKEN_KEYWORD) && token->text && token->text[0];
+}
+
+/* Check if a token is the punctuation or operator text */
+static bool is_field_token(const Token *token, const char *text) {
+    return (token->type == TOKEN_PUNCTUATION || token->type == TOKEN_OPERATOR) && token->text &&
+           strcmp(token->text, text) == 0;
+}
+
+/* Append a field to body, returns false on allocation failure */
+static bool add_struct_field(StructBody_t *body, const char *name, size_t size, size_t align) {
+    if (body->field_count >= body->field_capacity) {
+        size_t new_capacity = body->field_capacity == 0 ? 16 : body->field_capacity * 2;
+        StructField_t *new_fields = realloc(body->fields, new_capacity * sizeof(StructField_t));
+        if (!new_fields) {
+            return false;
+        }
+        body->fields = new_fields;
+        body->field_capacity = new_capacity;
+    }
+    body->fields[body->field_count].name = name;
+    body->fields[body->field_count].size = size;
+    body->fields[body->field_count].align = align;
+    body->field_count++;
+    return true;
+}
+
+/* Estimate the fields of the declaration from start to its ';' at semicolon: "T a, *b, c[4];".
+ * Returns false for bit-fields, function pointers, nested types and unknown types. */
+static bool parse_field_declaration(ASTNode_t **children, size_t start, size_t semicolon, StructBody_t *body) {
+    size_t words[MAX_FIELD_WORDS];
+    size_t word_count = 0;
+    size_t i = ast_skip_trivia(children, semicolon, start);
+    while (i < semicolon && is_field_word(&children[i]->token)) {
+        if (word_count >= MAX_FIELD_WORDS) {
+            return false;
+        }
+        words[word_count++] = i;
+        i = ast_skip_trivia(children, semicolon, i + 1);
+    }
+
+    /* "T name" or "T *name": the last word names the field unless a pointer follows */
+    bool named = i >= semicolon || !children[i]->token.text || children[i]->token.text[0] != '*';
+    size_t type_count = named ? word_count - (word_count > 0) : word_count;
+    size_t base_size = 0;
+    size_t base_align = 0;
+    if (type_count == 0) {
+        return false;
+    }
+    /* Pointers to types of other headers still have a known layout */
+    bool base_known = resolve_field_type(children, words, type_count, &base_size, &base_align);
+    size_t pointer_size;
+    size_t pointer_align;
+    transpiler_get_type_layout("void *", &pointer_size, &pointer_align);
+
+    const char *name = named ? children[words[word_count - 1]]->token.text : NULL;
+    for (;;) {
+        bool pointer = false;
+        while (i < semicolon && children[i]->token.type == TOKEN_OPERATOR && children[i]->token.text[0] == '*' &&
+               children[i]->token.text[strspn(children[i]->token.text, "*")] == '\0') {
+            pointer = true;
+            i = ast_skip_trivia(children, semicolon, i + 1);
+        }
+        if (!name) {
+            if (i >= semicolon || children[i]->token.type != TOKEN_IDENTIFIER) {
+                return false;
+            }
+            name = children[i]->token.text;
+            i = ast_skip_trivia(children, semicolon, i + 1);
+        }
+
+        /* Arrays of constant length: "name[4][2]" */
+        size_t elements = 1;
+        while (i < semicolon && is_field_token(&children[i]->token, "[")) {
+            i = ast_skip_trivia(children, semicolon, i + 1);
+            if (i >= semicolon || children[i]->token.type != TOKEN_NUMBER) {
+                return false;
+            }
+            char *end = NULL;
+            unsigned long long length = strtoull(children[i]->token.text, &end, 0);
+            if (!end || *end != '\0' || length == 0) {
+                return false;
+            }
+            elements *= (size_t)length;
+            i = ast_skip_trivia(children, semicolon, i + 1);
+            if (i >= semicolon || !is_field_token(&children[i]->token, "]")) {
+                return false;
+            }
+            i = ast_skip_trivia(children, semicolon, i + 1);
+        }
+
+        if (!pointer && !base_known) {
+            return false;
+        }
+        size_t size = pointer ? pointer_size : base_size;
+        size_t align = pointer ? pointer_align : base_align;
+        if (!add_struct_field(body, name, size * elements, align)) {
+            return false;
+        }
+        if (i >= semicolon) {
+            return true;
+        }
+        if (!is_field_token(&children[i]->token, ",")) {
+            return false;
+        }
+        i = ast_skip_trivia(children, semicolon, i + 1);
+        name = NULL;
+    }
+}
+
+/* Append a declaration to body, returns false on allocation failure */
+static bool add_struct_declaration(StructBody_t *body, size_t start, size_t end, size_t first_field) {
+    if (body->declaration_count >= body->declaration_capacity) {
+        size_t new_capacity = body->declaration_capacity == 0 ? 16 : body->declaration_capacity * 2;
+        StructDeclaration_t *new_declarations = realloc(body->declarations, new_capacity * sizeof(StructDeclaration_t));
+        if (!new_declarations) {
+            return false;
+        }
+        body->declarations = new_declarations;
+        body->declaration_capacity = new_capacity;
+    }
+    StructDeclaration_t *declaration = &body->declarations[body->declaration_count++];
+    declaration->start = start;
+    declaration->end = end;
+    declaration->first_field = first_field;
+    declaration->field_count = body->field_count - first_field;
+    declaration->align = 1;
+    for (size_t f = first_field; f < body->field_count; f++) {
+        if (body->fields[f].align > declaration->align) {
+            declaration->align = body->fields[f].align;
+        }
+    }
+    return true;
+}
+
+/* Split the body between the braces at open and close into declarations and estimate their fields */
+static void parse_struct_body(ASTNode_t **children, size_t open, size_t close, StructBody_t *body) {
+    memset(body, 0, sizeof(*body));
+    body->layout = true;
+    size_t start = open + 1;
+    size_t i = start;
+    while (i < close) {
+        const Token *token = &children[i]->token;
+        if (token->type == TOKEN_PREPROCESSOR || is_field_token(token, "{") || is_field_token(token, "}")) {
+            /* Nested types and conditional fields are never estimated */
+            body->layout = false;
+            body->unknown = token->text;
+            return;
+        }
+        if (!is_field_token(token, ";")) {
+            i++;
+            continue;
+        }
+
+        /* The comment closing the declaration's line moves with it */
+        size_t end = i + 1;
+        if (end < close && children[end]->token.type == TOKEN_WHITESPACE && children[end]->token.text &&
+            !strchr(children[end]->token.text, '\n') && end + 1 < close && children[end + 1]->token.type == TOKEN_COMMENT) {
+            end += 2;
+        } else if (end < close && children[end]->token.type == TOKEN_COMMENT) {
+            end++;
+        }
+
+        size_t first_field = body->field_count;
+        if (!parse_field_declaration(children, start, i, body) || !add_struct_declaration(body, start, end, first_field)) {
+            size_t first = ast_skip_trivia(children, i, start);
+            body->layout = false;
+            body->unknown = first < i ? children[first]->token.text : ";";
+            return;
+        }
+        start = end;
+        i = end;
+    }
+
+    /* Only whitespace and comments may follow the last declaration */
+    if (ast_skip_trivia(children, close, start) < close) {
+        body->layout = false;
+        body->unknown = children[ast_skip_trivia(children, close, start)]->token.text;
+    }
+}
+
+/* Release the fields and declarations of a struct body */
+static void free_struct_body(StructBody_t *body) {
+    free(body->fields);
+    free(body->declarations);
+}
+
+/* Estimate the size and alignment of fields laid out in order, returns the size */
+static size_t layout_fields(const StructField_t *fields, const size_t *order, size_t count, size_t *align) {
+    size_t offset = 0;
+    *align = 1;
+    for (size_t f = 0; f < count; f++) {
+        const StructField_t *field = &fields[order ? order[f] : f];
+        offset = (offset + field->align - 1) / field->align * field->align;
+        offset += field->size;
+        if (field->align > *align) {
+            *align = field->align;
+        }
+    }
+    return (offset + *align - 1) / *align * *align;
+}
+
+/* Print the size, alignment and padding holes of a struct to g_layout_report */
+static void report_struct_layout(const char *filename, int line, const char *name, const StructBody_t *body,
+                                 size_t natural_size, bool compacted, bool exported) {
+    FILE *out = g_layout_report;
+    if (!body->layout) {
+        fprintf(out, "%s:%d: struct %s: layout unknown (near '%s')\n", filename, line, name,
+                body->unknown ? body->unknown : "");
+        return;
+    }
+
+    size_t align;
+    size_t size = layout_fields(body->fields, NULL, body->field_count, &align);
+    size_t data = 0;
+    for (size_t f = 0; f < body->field_count; f++) {
+        data += body->fields[f].size;
+    }
+    fprintf(out, "%s:%d: struct %s: size %zu, align %zu, padding %zu", filename, line, name, size, align, size - data);
+    if (compacted) {
+        fprintf(out, " (%zu before layout(compact))", natural_size);
+    }
+    fprintf(out, "\n");
+
+    size_t offset = 0;
+    for (size_t f = 0; f < body->field_count; f++) {
+        const StructField_t *field = &body->fields[f];
+        size_t aligned = (offset + field->align - 1) / field->align * field->align;
+        if (aligned > offset) {
+            fprintf(out, "%s:%d:   %zu byte%s of padding before '%s' (offset %zu)\n", filename, line, aligned - offset,
+                    aligned - offset == 1 ? "" : "s", field->name, offset);
+        }
+        offset = aligned + field->size;
+    }
+    if (size > offset) {
+        fprintf(out, "%s:%d:   %zu byte%s of padding at the end (offset %zu)\n", filename, line, size - offset,
+                size - offset == 1 ? "" : "s", offset);
+    }
+
+    /* Sorted by descending alignment the fields leave no hole but the tail */
+    if (!compacted) {
+        size_t *order = malloc(body->field_count * sizeof(size_t));
+        if (!order) {
+            return;
+        }
+        size_t placed = 0;
+        for (size_t a = align; a > 0; a /= 2) {
+            for (size_t f = 0; f < body->field_count; f++) {
+                if (body->fields[f].align == a) {
+                    order[placed++] = f;
+                }
+            }
+        }
+        size_t sorted_align;
+        size_t sorted = placed == body->field_count ? layout_fields(body->fields, order, placed, &sorted_align) : size;
+        free(order);
+        if (sorted < size) {
+            fprintf(out, "%s:%d:   size %zu with fields sorted by alignment%s\n", filename, line, sorted,
+                    exported ? "" : " (#pragma czar layout(compact))");
+        }
+    }
+}
+
+/* Reorder the declarations of body by descending alignment (stable), returns true if any moved */
+static bool compact_struct_body(ASTNode_t *ast, StructBody_t *body) {
+    size_t count = body->declaration_count;
+    size_t first = body->declarations[0].start;
+    size_t last = body->declarations[count - 1].end;
+    ASTNode_t **nodes = malloc((last - first) * sizeof(ASTNode_t *));
+    StructDeclaration_t *sorted = malloc(count * sizeof(StructDeclaration_t));
+    StructField_t *fields = malloc(body->field_count * sizeof(StructField_t));
+    if (!nodes || !sorted || !fields) {
+        free(nodes);
+        free(sorted);
+        free(fields);
+        return false;
+    }
+
+    /* Insertion sort keeps declarations of one alignment in source order */
+    memcpy(sorted, body->declarations, count * sizeof(StructDeclaration_t));
+    bool moved = false;
+    for (size_t d = 1; d < count; d++) {
+        StructDeclaration_t current = sorted[d];
+        size_t k = d;
+        while (k > 0 && sorted[k - 1].align < current.align) {
+            sorted[k] = sorted[k - 1];
+            k--;
+            moved = true;
+        }
+        sorted[k] = current;
+    }
+
+    if (moved) {
+        size_t used = 0;
+        size_t field_used = 0;
+        for (size_t d = 0; d < count; d++) {
+            for (size_t c = sorted[d].start; c < sorted[d].end; c++) {
+                nodes[used++] = ast->children[c];
+            }
+            memcpy(fields + field_used, body->fields + sorted[d].first_field, sorted[d].field_count * sizeof(StructField_t));
+            field_used += sorted[d].field_count;
+        }
+        memcpy(ast->children + first, nodes, used * sizeof(ASTNode_t *));
+        memcpy(body->fields, fields, field_used * sizeof(StructField_t));
+    }
+    free(nodes);
+    free(sorted);
+    free(fields);
+    return moved;
+}
+
+/* Check if the struct keyword at index is preceded by export */
+static bool is_exported_struct(ASTNode_t **children, size_t index) {
+    size_t prev = ast_prev_significant(children, index);
+    return prev != AST_NO_MATCH && children[prev]->token.type == TOKEN_IDENTIFIER && children[prev]->token.text &&
+           strcmp(children[prev]->token.text, "export") == 0;
+}
+
+/* Estimate the layout of the struct at index (body between open and close), report it and,
+ * under #pragma czar layout(compact), sort the fields of private structs by alignment.
+ * Returns true if fields moved. */
+static bool analyze_struct_layout(ASTNode_t *ast, size_t index, size_t open, size_t close,
+                                  const char *name, const char *filename) {
+    bool compact = g_pragmas && g_pragmas->layout_compact;
+    if (!compact && !g_layout_report) {
+        return false;
+    }
+
+    StructBody_t body;
+    parse_struct_body(ast->children, open, close, &body);
+    bool exported = is_exported_struct(ast->children, index);
+    bool compacted = false;
+    size_t natural_size = 0;
+    if (body.layout && body.field_count > 0) {
+        size_t align;
+        natural_size = layout_fields(body.fields, NULL, body.field_count, &align);
+        if (compact && !exported && body.declaration_count > 1) {
+            compacted = compact_struct_body(ast, &body);
+        }
+        size_t size = layout_fields(body.fields, NULL, body.field_count, &align);
+        track_struct_layout(name, size, align);
+    }
+    if (g_layout_report) {
+        report_struct_layout(filename ? filename : "<input>", ast->children[index]->token.line, name, &body,
+                             natural_size, compacted, exported);
+    }
+    free_struct_body(&body);
+    return compacted;
+}
+
+/* Check if the child at index is the punctuation or operator text */
+static bool child_is_token(ASTNode_t **children, size_t count, size_t index, const char *text) {
+    return index < count && children[index]->type == AST_TOKEN && is_field_token(&children[index]->token, text);
+}
+
+/* Report a positional initializer of the compacted struct name: the braces at open (holding
+ * an array of dimensions arrays) list values in source field order, which no longer holds */
+static void check_compact_initializer(ASTNode_t *ast, size_t open, size_t dimensions, const char *name,
+                                      const char *filename, const char *source) {
+    ASTNode_t **children = ast->children;
+    size_t close = ast_match(ast, open);
+    if (close == AST_NO_MATCH) {
+        return;
+    }
+    size_t first = ast_skip_trivia(children, close, open + 1);
+    if (first == close || child_is_token(children, close, first, ".") ||
+        (children[first]->token.type == TOKEN_NUMBER && strcmp(children[first]->token.text, "0") == 0 &&
+         ast_skip_trivia(children, close, first + 1) == close)) {
+        return; /* {}, {0} and designated initializers */
+    }
+    if (dimensions == 0) {
+        char error_msg[512];
+        snprintf(error_msg, sizeof(error_msg), ERR_LAYOUT_COMPACT_POSITIONAL_INIT, name);
+        cz_error_at(filename, source, children[open]->token.line, children[open]->token.column, error_msg);
+        return;
+    }
+
+    /* Array elements: "[i] = { ... }", "{ ... }", or field values with elided braces */
+    for (size_t i = first; i < close; i = ast_skip_trivia(children, close, i + 1)) {
+        if (child_is_token(children, close, i, "[")) {
+            size_t end = ast_match(ast, i);
+            if (end == AST_NO_MATCH) {
+                return;
+            }
+            i = ast_skip_trivia(children, close, end + 1);
+            if (child_is_token(children, close, i, "=")) {
+                i = ast_skip_trivia(children, close, i + 1);
+            }
+        }
+        if (child_is_token(children, close, i, "{")) {
+            check_compact_initializer(ast, i, dimensions - 1, name, filename, source);
+        } else if (i < close && (children[i]->token.type == TOKEN_NUMBER || children[i]->token.type == TOKEN_STRING ||
+                                 children[i]->token.type == TOKEN_CHAR)) {
+            check_compact_initializer(ast, open, 0, name, filename, source);
+        }
+        /* Skip to the ',' ending the element */
+        while (i < close && !child_is_token(children, close, i, ",")) {
+            size_t end = child_is_token(children, close, i, "{") || child_is_token(children, close, i, "(") ||
+                         child_is_token(children, close, i, "[") ? ast_match(ast, i) : AST_NO_MATCH;
+            i = end != AST_NO_MATCH ? end + 1 : i + 1;
+        }
+    }
+}
+
+/* Check the initializers of each declarator after the compacted struct name at index:
+ * "Name a = {...}, b[2] = {...};" */
+static void check_compact_declarators(ASTNode_t *ast, size_t index, const char *name, const char *filename,
+                                      const char *source) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    size_t i = ast_skip_trivia(children, count, index + 1);
+    while (i < count && children[i]->token.type == TOKEN_IDENTIFIER) {
+        size_t dimensions = 0;
+        i = ast_skip_trivia(children, count, i + 1);
+        while (child_is_token(children, count, i, "[")) {
+            size_t end = ast_match(ast, i);
+            if (end == AST_NO_MATCH) {
+                return;
+            }
+            dimensions++;
+            i = ast_skip_trivia(children, count, end + 1);
+        }
+        if (!child_is_token(children, count, i, "=")) {
+            if (!child_is_token(children, count, i, ",")) {
+                return; /* Not a declaration, e.g. "Name make(void)" */
+            }
+            i = ast_skip_trivia(children, count, i + 1);
+            continue;
+        }
+        i = ast_skip_trivia(children, count, i + 1);
+        if (!child_is_token(children, count, i, "{")) {
+            return;
+        }
+        check_compact_initializer(ast, i, dimensions, name, filename, source);
+        size_t end = ast_match(ast, i);
+        if (end == AST_NO_MATCH) {
+            return;
+        }
+        i = ast_skip_trivia(children, count, end + 1);
+        if (!child_is_token(children, count, i, ",")) {
+            return;
+        }
+        i = ast_skip_trivia(children, count, i + 1);
+    }
+}
+
+/* Reject positional brace initializers and compound literals of the structs whose fields moved */
+static void check_compact_initializers(ASTNode_t *ast, const HashTable_t *compacted, const char *filename,
+                                       const char *source) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+    for (size_t i = 0; i < count; i++) {
+        Token *token = &children[i]->token;
+        if (children[i]->type != AST_TOKEN || token->type != TOKEN_IDENTIFIER ||
+            hash_table_get(compacted, (uint64_t)(uint32_t)cz_token_symbol(token)) == HASH_TABLE_MISSING) {
+            continue;
+        }
+        const char *name = cz_symbol_name(cz_token_symbol(token));
+        size_t prev = ast_prev_significant(children, i);
+        size_t next = ast_skip_trivia(children, count, i + 1);
+        if (prev != AST_NO_MATCH && child_is_token(children, count, prev, "(") &&
+            child_is_token(children, count, next, ")")) {
+            /* Compound literal: (Name){ ... } */
+            size_t open = ast_skip_trivia(children, count, next + 1);
+            if (child_is_token(children, count, open, "{")) {
+                check_compact_initializer(ast, open, 0, name, filename, source);
+            }
+        } else if (child_is_token(children, count, next, "{")) {
+            /* Struct literal: Name { ... } */
+            check_compact_initializer(ast, next, 0, name, filename, source);
+        } else {
+            check_compact_declarators(ast, i, name, filename, source);
         }
     }
-    return NULL;
 }
 
 /* Transform named struct declarations into typedef structs */
-void transpiler_transform_structs(ASTNode_t *ast) {
+void transpiler_transform_structs(ASTNode_t *ast, const char *filename, const char *source) {
     if (!ast || ast->type != AST_TRANSLATION_UNIT) {
         return;
     }
 
+    /* Mappings are per translation unit, so output never depends on earlier files */
+    struct_name_count = 0;
+    hash_table_clear(&struct_name_index);
+    struct_layout_count = 0;
+    hash_table_clear(&struct_layout_index);
+    HashTable_t compacted;
+    hash_table_init(&compacted);
+
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
+
     /* Look for pattern: struct identifier { ... }; */
     /* Transform to: typedef struct { ... } identifier; */
 
@@ -103,8 +735,7 @@ void transpiler_transform_structs(ASTNode_t *ast) {
         Token *t3 = &n3->token;
 
         /* Check for: struct <whitespace> identifier */
-        if ((t1->type == TOKEN_IDENTIFIER || t1->type == TOKEN_KEYWORD) && 
-            t1->text && strcmp(t1->text, "struct") == 0 &&
+        if (t1->symbol == SYM_STRUCT &&
             t2->type == TOKEN_WHITESPACE &&
             t3->type == TOKEN_IDENTIFIER) {
 
@@ -163,35 +794,32 @@ void transpiler_transform_structs(ASTNode_t *ast) {
             /* Transform: struct Name { ... } to typedef struct Name { ... } Name */
             /* This allows users to use Name directly in CZar code */
 
-            /* Step 1: Save the struct name (t3->text) */
-            char *struct_name = strdup(t3->text);
+            /* Step 1: Save the struct name (t3->text, interned so it survives the rewrite) */
+            const char *struct_name = cz_symbol_name(cz_token_symbol(t3));
             if (!struct_name) {
                 continue; /* Memory allocation failed */
             }
+            if (analyze_struct_layout(ast, i, brace_idx, closing_brace_idx, struct_name, filename)) {
+                hash_table_put(&compacted, (uint64_t)(uint32_t)cz_token_symbol(t3), 0);
+            }
 
             /* Step 2: Replace "struct" with "typedef struct" */
             char *new_text = strdup("typedef struct");
             if (!new_text) {
-                free(struct_name);
                 continue; /* Memory allocation failed */
             }
-            free(t1->text);
-            t1->text = new_text;
-            t1->length = strlen(new_text);
+            token_take_text(t1, new_text);
 
             /* Step 3: Modify the struct name to add _s suffix */
             /* Change "struct Name" to "struct Name_s" */
             size_t struct_name_len = strlen(struct_name);
             char *struct_tag_name = malloc(struct_name_len + 3); /* +2 for "_s" + 1 for null */
             if (!struct_tag_name) {
-                free(struct_name);
                 continue;
             }
             snprintf(struct_tag_name, struct_name_len + 3, "%s_s", struct_name);
             
-            free(t3->text);
-            t3->text = struct_tag_name;
-            t3->length = strlen(struct_tag_name);
+            token_take_text(t3, struct_tag_name);
 
             /* Step 4: After the closing brace, add the typedef name */
             /* Look for whitespace and semicolon after closing brace */
@@ -213,7 +841,6 @@ void transpiler_transform_structs(ASTNode_t *ast) {
                 /* Use Name_t for typedef instead of Name */
                 char *typedef_name = malloc(struct_name_len + 3); /* +2 for "_t" + 1 for null */
                 if (!typedef_name) {
-                    free(struct_name);
                     continue;
                 }
                 snprintf(typedef_name, struct_name_len + 3, "%s_t", struct_name);
@@ -223,75 +850,31 @@ void transpiler_transform_structs(ASTNode_t *ast) {
 
                 /* We need to insert: " Name" before the semicolon */
                 /* Create a new token for the space */
-                ASTNode_t *space_node = malloc(sizeof(ASTNode_t));
-                if (space_node) {
-                    space_node->type = AST_TOKEN;
-                    space_node->token.type = TOKEN_WHITESPACE;
-                    space_node->token.text = strdup(" ");
-                    space_node->token.length = 1;
-                    space_node->token.line = t1->line;
-                    space_node->token.column = 0;
-                    space_node->children = NULL;
-                    space_node->child_count = 0;
-                    space_node->child_capacity = 0;
-                }
-
-                /* Create a new token for the typedef name (Name_t) */
-                ASTNode_t *name_node = malloc(sizeof(ASTNode_t));
-                if (name_node) {
-                    name_node->type = AST_TOKEN;
-                    name_node->token.type = TOKEN_IDENTIFIER;
-                    name_node->token.text = typedef_name; /* Transfer ownership */
-                    name_node->token.length = strlen(typedef_name);
-                    name_node->token.line = t1->line;
-                    name_node->token.column = 0;
-                    name_node->children = NULL;
-                    name_node->child_count = 0;
-                    name_node->child_capacity = 0;
+                ASTNode_t *space_node = ast_token_create(TOKEN_WHITESPACE, " ", t1->line, 0);
 
+                /* Create a new token for the typedef name (Name_t, text copied into the arena) */
+                ASTNode_t *name_node = ast_token_create(TOKEN_IDENTIFIER, typedef_name, t1->line, 0);
+                free(typedef_name);
+                if (space_node && name_node) {
                     /* Insert the nodes before the semicolon */
-                    /* We need to grow the children array and shift elements */
-                    size_t new_count = ast->child_count + 2;
-                    if (new_count > ast->child_capacity) {
-                        size_t new_capacity = new_count * 2;
-                        ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-                        if (new_children) {
-                            ast->children = new_children;
-                            ast->child_capacity = new_capacity;
-                        } else {
-                            /* Memory allocation failed, clean up */
-                            free(space_node);
-                            free(name_node);
-                            free(struct_name);
-                            continue;
-                        }
-                    }
-
-                    /* Shift elements to make room */
-                    for (size_t j = ast->child_count; j > insert_pos; j--) {
-                        ast->children[j + 1] = ast->children[j - 1];
-                    }
-
-                    /* Insert the new nodes */
-                    ast->children[insert_pos] = space_node;
-                    ast->children[insert_pos + 1] = name_node;
-                    ast->child_count += 2;
+                    ast_rewrite_insert(&rewrite, insert_pos, space_node);
+                    ast_rewrite_insert(&rewrite, insert_pos, name_node);
 
                     /* Skip ahead so we don't process this struct again */
-                    i = semicolon_idx + 2;
-
-                    /* Free struct_name */
-                    free(struct_name);
-                } else {
-                    free(struct_name);
-                    free(typedef_name);
-                    if (space_node) free(space_node);
+                    i = semicolon_idx;
                 }
-            } else {
-                free(struct_name);
             }
         }
     }
+
+    ast_rewrite_commit(&rewrite);
+    if (compacted.count > 0) {
+        /* Fields moved in place: brackets and significant links are stale */
+        ast_invalidate_matches(ast);
+        ast_link_significant(ast);
+        check_compact_initializers(ast, &compacted, filename, source);
+    }
+    hash_table_free(&compacted);
 }
 
 /* Transform struct initialization syntax
@@ -305,6 +888,9 @@ void transpiler_transform_struct_init(ASTNode_t *ast) {
         return;
     }
 
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
+
     /* Look for pattern: = { or = StructName { */
     for (size_t i = 0; i < ast->child_count; i++) {
         if (i + 2 >= ast->child_count) {
@@ -351,46 +937,10 @@ void transpiler_transform_struct_init(ASTNode_t *ast) {
                 ast->children[close_idx]->token.text &&
                 strcmp(ast->children[close_idx]->token.text, "}") == 0) {
                 /* Insert 0 between { and } */
-                ASTNode_t *zero_node = malloc(sizeof(ASTNode_t));
+                ASTNode_t *zero_node = ast_token_create(TOKEN_NUMBER, "0", next->token.line, 0);
                 if (zero_node) {
-                    zero_node->type = AST_TOKEN;
-                    zero_node->token.type = TOKEN_NUMBER;
-                    zero_node->token.text = strdup("0");
-                    zero_node->token.length = 1;
-                    zero_node->token.line = next->token.line;
-                    zero_node->token.column = 0;
-                    zero_node->children = NULL;
-                    zero_node->child_count = 0;
-                    zero_node->child_capacity = 0;
-
-                    if (zero_node->token.text) {
-                        /* Insert zero_node between { and } */
-                        size_t insert_pos = next_idx + 1;
-                        size_t new_count = ast->child_count + 1;
-
-                        if (new_count > ast->child_capacity) {
-                            size_t new_capacity = new_count * 2;
-                            ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-                            if (new_children) {
-                                ast->children = new_children;
-                                ast->child_capacity = new_capacity;
-                            } else {
-                                free(zero_node->token.text);
-                                free(zero_node);
-                                continue;
-                            }
-                        }
-
-                        /* Shift elements */
-                        for (size_t j = ast->child_count; j > insert_pos; j--) {
-                            ast->children[j] = ast->children[j - 1];
-                        }
-
-                        ast->children[insert_pos] = zero_node;
-                        ast->child_count++;
-                    } else {
-                        free(zero_node);
-                    }
+                    /* Insert zero_node between { and } */
+                    ast_rewrite_insert(&rewrite, next_idx + 1, zero_node);
                 }
             }
         }
@@ -433,236 +983,30 @@ void transpiler_transform_struct_init(ASTNode_t *ast) {
 
                 /* Transform by removing the struct name */
                 /* = StructName { -> = { */
-                free(next->token.text);
-                next->token.text = strdup("");
-                next->token.length = 0;
+                ast_rewrite_delete(&rewrite, next_idx);
 
                 /* If empty, add 0 */
                 if (is_empty) {
-
-                    ASTNode_t *zero_node = malloc(sizeof(ASTNode_t));
+                    ASTNode_t *zero_node = ast_token_create(TOKEN_NUMBER, "0", ast->children[brace_idx]->token.line, 0);
                     if (zero_node) {
-                        zero_node->type = AST_TOKEN;
-                        zero_node->token.type = TOKEN_NUMBER;
-                        zero_node->token.text = strdup("0");
-                        zero_node->token.length = 1;
-                        zero_node->token.line = ast->children[brace_idx]->token.line;
-                        zero_node->token.column = 0;
-                        zero_node->children = NULL;
-                        zero_node->child_count = 0;
-                        zero_node->child_capacity = 0;
-
-                        if (zero_node->token.text) {
-                            /* Insert before } */
-                            size_t insert_pos = brace_idx + 1;
-                            size_t new_count = ast->child_count + 1;
-
-                            if (new_count > ast->child_capacity) {
-                                size_t new_capacity = new_count * 2;
-                                ASTNode_t **new_children = realloc(ast->children, new_capacity * sizeof(ASTNode_t *));
-                                if (new_children) {
-                                    ast->children = new_children;
-                                    ast->child_capacity = new_capacity;
-                                } else {
-                                    free(zero_node->token.text);
-                                    free(zero_node);
-                                    continue;
-                                }
-                            }
-
-                            /* Shift elements */
-                            for (size_t j = ast->child_count; j > insert_pos; j--) {
-                                ast->children[j] = ast->children[j - 1];
-                            }
-
-                            ast->children[insert_pos] = zero_node;
-                            ast->child_count++;
-                        } else {
-                            free(zero_node);
-                        }
+                        /* Insert after { */
+                        ast_rewrite_insert(&rewrite, brace_idx + 1, zero_node);
                     }
                 }
             }
         }
     }
-}
 
-/* Parse a .cz.h header file to extract typedef struct patterns
- * Returns 1 on success, 0 on failure
- */
-static int parse_header_for_typedefs(const char *source_filename, const char *header_path) {
-    /* Construct full path to header file */
-    char full_path[1024];
-    const char *last_slash = strrchr(source_filename, '/');
-    if (last_slash) {
-        size_t dir_len = last_slash - source_filename + 1;
-        if (dir_len + strlen(header_path) + 1 > sizeof(full_path)) {
-            return 0;
-        }
-        memcpy(full_path, source_filename, dir_len);
-        strcpy(full_path + dir_len, header_path);
-    } else {
-        if (strlen(header_path) + 1 > sizeof(full_path)) {
-            return 0;
-        }
-        strcpy(full_path, header_path);
-    }
-    
-    /* Try to open the header file */
-    FILE *f = fopen(full_path, "r");
-    if (!f) {
-        return 0;
-    }
-    
-    /* Read the file content */
-    fseek(f, 0, SEEK_END);
-    long file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    
-    if (file_size <= 0 || file_size > 1024 * 1024) { /* Max 1MB */
-        fclose(f);
-        return 0;
-    }
-    
-    char *content = malloc(file_size + 1);
-    if (!content) {
-        fclose(f);
-        return 0;
-    }
-    
-    size_t read_size = fread(content, 1, file_size, f);
-    fclose(f);
-    content[read_size] = '\0';
-    
-    /* Simple regex-like scan for: typedef struct Name_s { ... } Name_t; */
-    /* We look for "typedef struct <name>_s" followed eventually by "} <name>_t;" */
-    char *p = content;
-    while ((p = strstr(p, "typedef struct ")) != NULL) {
-        p += 15; /* Skip "typedef struct " */
-        
-        /* Extract struct tag name */
-        while (*p == ' ' || *p == '\t') p++;
-        if (!*p) break;
-        
-        char *tag_start = p;
-        while (*p && (isalnum(*p) || *p == '_')) p++;
-        if (p == tag_start) continue;
-        
-        size_t tag_len = p - tag_start;
-        if (tag_len < 3) continue; /* Need at least X_s */
-        
-        /* Check if ends with _s */
-        if (tag_start[tag_len - 2] != '_' || tag_start[tag_len - 1] != 's') {
-            continue;
-        }
-        
-        /* Extract base name (without _s) */
-        char base_name[MAX_STRUCT_NAME_LEN];
-        if (tag_len - 2 >= sizeof(base_name)) continue;
-        memcpy(base_name, tag_start, tag_len - 2);
-        base_name[tag_len - 2] = '\0';
-        
-        /* Find the closing brace and typedef name */
-        /* Look for "} Name_t;" */
-        char *typedef_pattern = malloc(tag_len + 10); /* "} " + base + "_t;" */
-        if (!typedef_pattern) continue;
-        sprintf(typedef_pattern, "} %s_t", base_name);
-        
-        char *typedef_loc = strstr(p, typedef_pattern);
-        if (typedef_loc) {
-            /* Found a match - track this mapping */
-            char typedef_name[MAX_TYPEDEF_NAME_LEN];
-            snprintf(typedef_name, sizeof(typedef_name), "%s_t", base_name);
-            track_struct_name(base_name, typedef_name);
-        }
-        
-        free(typedef_pattern);
-    }
-    
-    free(content);
-    return 1;
+    ast_rewrite_commit(&rewrite);
 }
 
-/* Scan the AST for #import directives and parse the corresponding .cz.h files
- * to extract typedef information
- */
-static void scan_imports_for_typedefs(ASTNode_t *ast, const char *source_filename) {
-    if (!ast || ast->type != AST_TRANSLATION_UNIT || !source_filename) {
-        return;
-    }
-    
-    for (size_t i = 0; i < ast->child_count; i++) {
-        if (ast->children[i]->type != AST_TOKEN) {
-            continue;
-        }
-        
-        Token *t = &ast->children[i]->token;
-        
-        /* Look for #import directives */
-        if (t->type == TOKEN_PREPROCESSOR && t->text &&
-            t->length >= 7 && strncmp(t->text, "#import", 7) == 0) {
-            
-            /* Extract the module path from #import "path" */
-            const char *quote_start = strchr(t->text, '"');
-            if (!quote_start) continue;
-            
-            const char *quote_end = strchr(quote_start + 1, '"');
-            if (!quote_end) continue;
-            
-            size_t path_len = quote_end - quote_start - 1;
-            char module_path[512];
-            if (path_len >= sizeof(module_path)) continue;
-            
-            memcpy(module_path, quote_start + 1, path_len);
-            module_path[path_len] = '\0';
-            
-            /* Check if it's a directory or a single file */
-            /* Construct the full path to check */
-            char full_module_path[1024];
-            const char *last_slash = strrchr(source_filename, '/');
-            if (last_slash) {
-                size_t dir_len = last_slash - source_filename + 1;
-                if (dir_len + strlen(module_path) + 1 > sizeof(full_module_path)) continue;
-                memcpy(full_module_path, source_filename, dir_len);
-                strcpy(full_module_path + dir_len, module_path);
-            } else {
-                if (strlen(module_path) + 1 > sizeof(full_module_path)) continue;
-                strcpy(full_module_path, module_path);
-            }
-            
-            struct stat st;
-            if (stat(full_module_path, &st) == 0 && S_ISDIR(st.st_mode)) {
-                /* It's a directory - scan for .cz.h files */
-                DIR *dir = opendir(full_module_path);
-                if (dir) {
-                    struct dirent *entry;
-                    while ((entry = readdir(dir)) != NULL) {
-                        /* Check if file ends with .cz.h */
-                        size_t name_len = strlen(entry->d_name);
-                        if (name_len > 5 && strcmp(entry->d_name + name_len - 5, ".cz.h") == 0) {
-                            /* Validate path length before constructing */
-                            if (strlen(module_path) + 1 + name_len + 1 > MAX_PATH_LEN) {
-                                continue; /* Path too long, skip this file */
-                            }
-                            /* Parse this header file */
-                            char header_path[MAX_PATH_LEN];
-                            snprintf(header_path, sizeof(header_path), "%s/%s", module_path, entry->d_name);
-                            parse_header_for_typedefs(source_filename, header_path);
-                        }
-                    }
-                    closedir(dir);
-                }
-            } else {
-                /* Validate path length before constructing */
-                if (strlen(module_path) + 5 + 1 > MAX_PATH_LEN) {
-                    continue; /* Path too long, skip */
-                }
-                /* Try single file: module_path.cz.h */
-                char header_path[MAX_PATH_LEN];
-                snprintf(header_path, sizeof(header_path), "%s.cz.h", module_path);
-                parse_header_for_typedefs(source_filename, header_path);
-            }
-        }
+/* Track Name -> Name_t for every struct typedef of an imported header */
+static void track_header_typedefs(const HeaderIndex_t *header, void *context) {
+    (void)context;
+    for (size_t i = 0; i < header->typedef_count; i++) {
+        char typedef_name[MAX_TYPEDEF_NAME_LEN];
+        snprintf(typedef_name, sizeof(typedef_name), "%s_t", header->typedefs[i]);
+        track_struct_name(header->typedefs[i], typedef_name);
     }
 }
 
@@ -793,7 +1137,7 @@ void transpiler_replace_struct_names(ASTNode_t *ast, const char *filename) {
     
     /* First, scan for #import directives and parse imported .cz.h files */
     if (filename) {
-        scan_imports_for_typedefs(ast, filename);
+        header_index_imports(ast, filename, track_header_typedefs, NULL);
     }
     
     /* Then, scan for existing typedef patterns in the current AST */
@@ -809,7 +1153,7 @@ void transpiler_replace_struct_names(ASTNode_t *ast, const char *filename) {
         
         /* Check if this is an identifier we need to replace */
         if (t->type == TOKEN_IDENTIFIER && t->text) {
-            const char *typedef_name = get_typedef_name(t->text);
+            const char *typedef_name = get_typedef_name(t);
             
             if (typedef_name) {
                 /* Check if preceded by "struct" keyword - if so, skip replacement */
@@ -825,9 +1169,8 @@ void transpiler_replace_struct_names(ASTNode_t *ast, const char *filename) {
                             }
                             /* Found a non-whitespace token */
                             /* Note: "typedef struct" is a single token created during transformation */
-                            if ((prev->type == TOKEN_IDENTIFIER || prev->type == TOKEN_KEYWORD) && 
-                                prev->text && 
-                                (strcmp(prev->text, "struct") == 0 || strcmp(prev->text, "typedef struct") == 0)) {
+                            if (prev->symbol == SYM_STRUCT ||
+                                (prev->text && strcmp(prev->text, "typedef struct") == 0)) {
                                 preceded_by_struct = 1;
                             }
                             break;
@@ -839,9 +1182,7 @@ void transpiler_replace_struct_names(ASTNode_t *ast, const char *filename) {
                     /* Replace Name with Name_t */
                     char *new_text = strdup(typedef_name);
                     if (new_text) {
-                        free(t->text);
-                        t->text = new_text;
-                        t->length = strlen(new_text);
+                        token_take_text(t, new_text);
                     }
                 }
             }
@@ -9,12 +9,25 @@
 #pragma once
 
 #include "../parser.h"
+#include "../worker.h"
+#include <stdio.h>
 
-/* Transform named struct declarations into typedef structs */
-void transpiler_transform_structs(ASTNode_t *ast);
+/* Stream receiving struct layout reports (cz --layout-report, NULL when off) */
+extern CZ_THREAD_LOCAL FILE *g_layout_report;
+
+/* Transform named struct declarations into typedef structs. Estimates each layout for
+ * g_layout_report and sorts private fields by alignment under #pragma czar layout(compact),
+ * rejecting positional initializers of the structs it reorders. */
+void transpiler_transform_structs(ASTNode_t *ast, const char *filename, const char *source);
 
 /* Transform struct initialization syntax */
 void transpiler_transform_struct_init(ASTNode_t *ast);
 
 /* Replace all uses of struct names with their _t variants */
 void transpiler_replace_struct_names(ASTNode_t *ast, const char *filename);
+
+/* Release the struct name mappings of the current translation unit */
+void transpiler_free_struct_tables(void);
+
+/* Get the bytes held by the struct name mappings and layouts (cz --stats) */
+size_t transpiler_struct_table_bytes(void);
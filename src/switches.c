@@ -8,8 +8,11 @@
 
 #include "cz.h"
 #include "switches.h"
+#include "unreachable.h"
 #include "../transpiler.h"
+#include "../rewrite.h"
 #include "errors.h"
+#include "scopes.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,26 +25,13 @@ static int token_text_equals(Token *token, const char *text) {
     return strcmp(token->text, text) == 0;
 }
 
-/* Skip whitespace and comment tokens */
-static size_t skip_whitespace(ASTNode_t **children, size_t count, size_t i) {
-    while (i < count) {
-        if (children[i]->type != AST_TOKEN) {
-            i++;
-            continue;
-        }
-        TokenType type = children[i]->token.type;
-        if (type != TOKEN_WHITESPACE && type != TOKEN_COMMENT) {
-            break;
-        }
-        i++;
-    }
-    return i;
-}
-
 /* Validate that each case in a switch has explicit control flow */
-static void validate_switch_case_control_flow_internal(ASTNode_t **children, size_t count, size_t switch_pos) {
+static void validate_switch_case_control_flow_internal(ASTNode_t *ast, size_t switch_pos) {
+    ASTNode_t **children = ast->children;
+    size_t count = ast->child_count;
+
     /* Find the switch body */
-    size_t i = skip_whitespace(children, count, switch_pos + 1);
+    size_t i = ast_skip_trivia(children, count, switch_pos + 1);
 
     /* Skip switch expression: ( ... ) */
     if (i >= count || children[i]->type != AST_TOKEN ||
@@ -49,18 +39,12 @@ static void validate_switch_case_control_flow_internal(ASTNode_t **children, siz
         return;
     }
 
-    int paren_depth = 1;
-    i++;
-    while (i < count && paren_depth > 0) {
-        if (children[i]->type == AST_TOKEN &&
-            children[i]->token.type == TOKEN_PUNCTUATION) {
-            if (token_text_equals(&children[i]->token, "(")) paren_depth++;
-            else if (token_text_equals(&children[i]->token, ")")) paren_depth--;
-        }
-        i++;
+    size_t close_paren = ast_match(ast, i);
+    if (close_paren == AST_NO_MATCH) {
+        return;
     }
 
-    i = skip_whitespace(children, count, i);
+    i = ast_skip_trivia(children, count, close_paren + 1);
 
     /* Find opening brace */
     if (i >= count || children[i]->type != AST_TOKEN ||
@@ -71,19 +55,9 @@ static void validate_switch_case_control_flow_internal(ASTNode_t **children, siz
     size_t switch_body_start = i;
 
     /* Find closing brace */
-    int brace_depth = 1;
-    i++;
-    size_t switch_body_end = i;
-    while (i < count && brace_depth > 0) {
-        if (children[i]->type == AST_TOKEN &&
-            children[i]->token.type == TOKEN_PUNCTUATION) {
-            if (token_text_equals(&children[i]->token, "{")) brace_depth++;
-            else if (token_text_equals(&children[i]->token, "}")) {
-                brace_depth--;
-                if (brace_depth == 0) switch_body_end = i;
-            }
-        }
-        i++;
+    size_t switch_body_end = ast_match(ast, switch_body_start);
+    if (switch_body_end == AST_NO_MATCH) {
+        return;
     }
 
     /* Scan for case/default labels and validate control flow */
@@ -114,7 +88,7 @@ static void validate_switch_case_control_flow_internal(ASTNode_t **children, siz
             }
 
             /* Now scan from after the colon to the next case/default/closing brace */
-            j = skip_whitespace(children, count, j + 1);
+            j = ast_skip_trivia(children, count, j + 1);
             size_t case_body_start = j;
             size_t case_body_end = switch_body_end;
 
@@ -194,7 +168,7 @@ static void validate_switch_case_control_flow_internal(ASTNode_t **children, siz
                     char error_msg[512];
                     snprintf(error_msg, sizeof(error_msg),
                              ERR_SWITCH_CASE_NO_CONTROL_FLOW);
-                    cz_error(g_filename, g_source, children[case_start]->token.line, error_msg);
+                    cz_error_at(g_filename, g_source, children[case_start]->token.line, children[case_start]->token.column, error_msg);
                 }
             }
 
@@ -224,7 +198,7 @@ void transpiler_validate_switch_case_control_flow(ASTNode_t *ast, const char *fi
         /* Look for switch keyword */
         if ((tok->type == TOKEN_KEYWORD || tok->type == TOKEN_IDENTIFIER) &&
             strcmp(tok->text, "switch") == 0) {
-            validate_switch_case_control_flow_internal(children, count, i);
+            validate_switch_case_control_flow_internal(ast, i);
         }
     }
 }
@@ -258,14 +232,12 @@ void transpiler_transform_switch_continue_to_fallthrough(ASTNode_t *ast) {
                 /* Only transform if we're in a switch but not in a loop */
                 if (switch_depth > 0 && loop_depth == 0) {
                     /* Replace continue with __attribute__((fallthrough)) or comment */
-                    free(token->text);
                     #ifdef __GNUC__
-                    token->text = strdup("__attribute__((fallthrough))");
+                    const char *fallthrough = "__attribute__((fallthrough))";
                     #else
-                    token->text = strdup("/* fallthrough */");
+                    const char *fallthrough = "/* fallthrough */";
                     #endif
-                    if (token->text) {
-                        token->length = strlen(token->text);
+                    if (token_set_text(token, fallthrough)) {
                         token->type = TOKEN_COMMENT;
                     }
                 }
@@ -283,133 +255,7 @@ void transpiler_transform_switch_continue_to_fallthrough(ASTNode_t *ast) {
 
 /* Helper to create a new AST token node */
 static ASTNode_t *create_token_node(TokenType type, const char *text, int line, int column) {
-    ASTNode_t *node = malloc(sizeof(ASTNode_t));
-    if (!node) return NULL;
-
-    node->type = AST_TOKEN;
-    node->token.type = type;
-    node->token.text = strdup(text);
-    if (!node->token.text) {
-        free(node);
-        return NULL;
-    }
-    node->token.length = strlen(text);
-    node->token.line = line;
-    node->token.column = column;
-    node->children = NULL;
-    node->child_count = 0;
-    node->child_capacity = 0;
-
-    return node;
-}
-
-/* Helper to insert a child at a specific position in an AST node */
-static int ast_insert_child(ASTNode_t *parent, size_t position, ASTNode_t *child) {
-    if (!parent || !child || position > parent->child_count) {
-        return 0;
-    }
-
-    /* Grow children array if needed */
-    if (parent->child_count >= parent->child_capacity) {
-        size_t new_capacity = parent->child_capacity == 0 ? 8 : parent->child_capacity * 2;
-        ASTNode_t **new_children = realloc(parent->children, new_capacity * sizeof(ASTNode_t *));
-        if (!new_children) {
-            return 0;
-        }
-        parent->children = new_children;
-        parent->child_capacity = new_capacity;
-    }
-
-    /* Shift elements to make room */
-    for (size_t i = parent->child_count; i > position; i--) {
-        parent->children[i] = parent->children[i - 1];
-    }
-
-    parent->children[position] = child;
-    parent->child_count++;
-    return 1;
-}
-
-/* Find the function name containing this position */
-static const char *find_function_name(ASTNode_t **children, size_t count, size_t current_pos) {
-    int brace_depth = 0;
-    const char *function_name = NULL;
-    const char *last_function_name = NULL;
-
-    /* Scan from start to find which function we're in at current_pos */
-    for (size_t i = 0; i < current_pos && i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
-
-        Token *tok = &children[i]->token;
-
-        if (tok->type == TOKEN_PUNCTUATION) {
-            if (token_text_equals(tok, "{")) {
-                brace_depth++;
-                /* Check if this is a function opening brace */
-                /* Look back for function name pattern: identifier ( ... ) { */
-                /* Skip back over whitespace and find identifier before ( */
-                for (int j = (int)i - 1; j >= 0 && j >= (int)i - 30; j--) {
-                    if (children[j]->type != AST_TOKEN) continue;
-                    Token *jtok = &children[j]->token;
-
-                    if (jtok->type == TOKEN_WHITESPACE || jtok->type == TOKEN_COMMENT) continue;
-
-                    /* Look for closing paren ) */
-                    if (jtok->type == TOKEN_PUNCTUATION && token_text_equals(jtok, ")")) {
-                        /* Found ), now look back for identifier before matching ( */
-                        int paren_depth_local = 1;
-                        int found_func = 0;
-                        for (int k = j - 1; k >= 0 && k >= j - 30; k--) {
-                            if (children[k]->type != AST_TOKEN) continue;
-                            Token *ktok = &children[k]->token;
-
-                            if (ktok->type == TOKEN_PUNCTUATION) {
-                                if (token_text_equals(ktok, ")")) paren_depth_local++;
-                                else if (token_text_equals(ktok, "(")) {
-                                    paren_depth_local--;
-                                    if (paren_depth_local == 0) {
-                                        /* Found matching (, look for identifier before it */
-                                        for (int m = k - 1; m >= 0 && m >= k - 5; m--) {
-                                            if (children[m]->type != AST_TOKEN) continue;
-                                            Token *mtok = &children[m]->token;
-                                            if (mtok->type == TOKEN_WHITESPACE || mtok->type == TOKEN_COMMENT) continue;
-                                            if (mtok->type == TOKEN_IDENTIFIER) {
-                                                /* Avoid keywords */
-                                                if (strcmp(mtok->text, "if") != 0 &&
-                                                    strcmp(mtok->text, "while") != 0 &&
-                                                    strcmp(mtok->text, "for") != 0 &&
-                                                    strcmp(mtok->text, "switch") != 0) {
-                                                    last_function_name = mtok->text;
-                                                    found_func = 1;
-                                                }
-                                                break;
-                                            }
-                                            break; /* Not an identifier */
-                                        }
-                                        break; /* Found matching ( */
-                                    }
-                                }
-                            }
-                        }
-                        if (found_func) break;
-                    }
-                    break; /* First non-whitespace token after { wasn't ) */
-                }
-                /* If we just entered the first brace level, this is the function */
-                if (brace_depth == 1 && last_function_name) {
-                    function_name = last_function_name;
-                }
-            } else if (token_text_equals(tok, "}")) {
-                brace_depth--;
-                /* If we exit all braces, clear function name */
-                if (brace_depth == 0) {
-                    function_name = NULL;
-                }
-            }
-        }
-    }
-
-    return function_name;
+    return ast_token_create(type, text, line, column);
 }
 
 /* Insert default cases into switches that lack them */
@@ -420,6 +266,8 @@ void transpiler_insert_switch_default_cases(ASTNode_t *ast, const char *filename
 
     ASTNode_t **children = ast->children;
     size_t count = ast->child_count;
+    ASTRewrite_t rewrite;
+    ast_rewrite_init(&rewrite, ast);
 
     for (size_t i = 0; i < count; i++) {
         if (children[i]->type != AST_TOKEN) continue;
@@ -430,7 +278,7 @@ void transpiler_insert_switch_default_cases(ASTNode_t *ast, const char *filename
             strcmp(token->text, "switch") == 0) {
 
             /* Find the switch expression */
-            size_t j = skip_whitespace(children, count, i + 1);
+            size_t j = ast_skip_trivia(children, count, i + 1);
 
             if (j >= count || children[j]->type != AST_TOKEN ||
                 !token_text_equals(&children[j]->token, "(")) {
@@ -438,18 +286,12 @@ void transpiler_insert_switch_default_cases(ASTNode_t *ast, const char *filename
             }
 
             /* Find closing paren and opening brace */
-            int paren_depth = 1;
-            j++;
-            while (j < count && paren_depth > 0) {
-                if (children[j]->type == AST_TOKEN &&
-                    children[j]->token.type == TOKEN_PUNCTUATION) {
-                    if (token_text_equals(&children[j]->token, "(")) paren_depth++;
-                    else if (token_text_equals(&children[j]->token, ")")) paren_depth--;
-                }
-                j++;
+            size_t close_paren = ast_match(ast, j);
+            if (close_paren == AST_NO_MATCH) {
+                continue;
             }
 
-            j = skip_whitespace(children, count, j);
+            j = ast_skip_trivia(children, count, close_paren + 1);
 
             /* Find switch body braces */
             if (j >= count || children[j]->type != AST_TOKEN ||
@@ -460,21 +302,9 @@ void transpiler_insert_switch_default_cases(ASTNode_t *ast, const char *filename
             size_t switch_body_start = j;
 
             /* Find closing brace */
-            int brace_depth = 1;
-            j++;
-            size_t switch_body_end = j;
-            while (j < count && brace_depth > 0) {
-                if (children[j]->type == AST_TOKEN &&
-                    children[j]->token.type == TOKEN_PUNCTUATION) {
-                    if (token_text_equals(&children[j]->token, "{")) brace_depth++;
-                    else if (token_text_equals(&children[j]->token, "}")) {
-                        brace_depth--;
-                        if (brace_depth == 0) {
-                            switch_body_end = j;
-                        }
-                    }
-                }
-                j++;
+            size_t switch_body_end = ast_match(ast, switch_body_start);
+            if (switch_body_end == AST_NO_MATCH) {
+                continue;
             }
 
             /* Check if there's a default */
@@ -496,10 +326,10 @@ void transpiler_insert_switch_default_cases(ASTNode_t *ast, const char *filename
             if (!has_default) {
                 int line = children[switch_body_end]->token.line;
                 /* Find function name at the switch statement location */
-                const char *func_name = find_function_name(children, count, switch_body_start);
+                const char *func_name = scope_map_function(ast, switch_body_start);
                 if (!func_name) func_name = "<unknown>";
 
-                /* Insert: default: { fprintf(stderr, "file:line: func: Unreachable code reached: \n"); abort(); } */
+                /* Insert: default: { _cz_fail("file:line: func: Unreachable code reached: \n"); } */
                 /* Build nodes in forward order */
                 ASTNode_t *nodes[20];
                 int node_count = 0;
@@ -509,24 +339,22 @@ void transpiler_insert_switch_default_cases(ASTNode_t *ast, const char *filename
                 nodes[node_count++] = create_token_node(TOKEN_PUNCTUATION, ":", line, 0);
                 nodes[node_count++] = create_token_node(TOKEN_WHITESPACE, " ", line, 0);
 
-                /* Create inline expansion: { fprintf(stderr, "...\n"); abort(); } */
-                char inline_code[512];
-                snprintf(inline_code, sizeof(inline_code),
-                         "{ fprintf(stderr, \"%s:%d: %s: Unreachable code reached: \\n\"); abort(); }",
-                         filename ? filename : "<unknown>", line, func_name);
+                /* Create inline expansion: { _cz_fail("...\n"); } (or _cz_unreachable() in release mode) */
+                char *inline_code = unreachable_site_code(filename, line, func_name,
+                                                          "Unreachable code reached", "", 1);
+                if (!inline_code) {
+                    continue;
+                }
 
                 nodes[node_count++] = create_token_node(TOKEN_PUNCTUATION, inline_code, line, 0);
+                free(inline_code);
                 nodes[node_count++] = create_token_node(TOKEN_WHITESPACE, "\n    ", line, 0);
 
-                /* Insert all nodes in reverse order before the closing brace */
-                for (int n = node_count - 1; n >= 0; n--) {
-                    if (nodes[n] && !ast_insert_child(ast, switch_body_end, nodes[n])) {
-                        /* Failed to insert, free the node */
-                        free(nodes[n]->token.text);
-                        free(nodes[n]);
-                    }
-                }
+                /* Insert all nodes before the closing brace */
+                ast_rewrite_insert_many(&rewrite, switch_body_end, nodes, (size_t)node_count);
             }
         }
     }
+
+    ast_rewrite_commit(&rewrite);
 }
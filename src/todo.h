@@ -9,6 +9,10 @@
 #pragma once
 
 #include "../parser.h"
+#include "../rewrite.h"
 
 /* Expand TODO() calls inline with .cz file location */
 void transpiler_expand_todo(ASTNode_t *ast, const char *filename);
+
+/* Expand the TODO(...) call at index, returns the last child index it consumed */
+size_t transpiler_visit_todo(ASTNode_t *ast, size_t index, const char *filename, ASTRewrite_t *rewrite);
@@ -10,6 +10,7 @@
 #include "types.h"
 #include <string.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* CZar type mapping structure */
 typedef struct {
@@ -53,3 +54,106 @@ const char *transpiler_get_c_type(const char *identifier) {
     }
     return NULL;
 }
+
+/* Alignment probes: the offset of value is the alignment of T (offsetof of a named type keeps C99) */
+#define LAYOUT_PROBE(id, T) typedef struct { char pad; T value; } LayoutProbe_##id;
+LAYOUT_PROBE(bool, _Bool)
+LAYOUT_PROBE(char, char)
+LAYOUT_PROBE(short, short)
+LAYOUT_PROBE(int, int)
+LAYOUT_PROBE(long, long)
+LAYOUT_PROBE(llong, long long)
+LAYOUT_PROBE(float, float)
+LAYOUT_PROBE(double, double)
+LAYOUT_PROBE(ldouble, long double)
+LAYOUT_PROBE(i8, int8_t)
+LAYOUT_PROBE(i16, int16_t)
+LAYOUT_PROBE(i32, int32_t)
+LAYOUT_PROBE(i64, int64_t)
+LAYOUT_PROBE(size, size_t)
+LAYOUT_PROBE(ptrdiff, ptrdiff_t)
+LAYOUT_PROBE(intptr, intptr_t)
+LAYOUT_PROBE(pointer, void *)
+#undef LAYOUT_PROBE
+
+/* Size and alignment of a scalar type spelling */
+typedef struct {
+    const char *name;
+    size_t size;
+    size_t align;
+} TypeLayout;
+
+#define LAYOUT(name, id, T) {name, sizeof(T), offsetof(LayoutProbe_##id, value)}
+
+/* Scalar type layouts (signedness never changes the layout) */
+static const TypeLayout type_layouts[] = {
+    LAYOUT("bool", bool, _Bool),
+    LAYOUT("_Bool", bool, _Bool),
+    LAYOUT("char", char, char),
+    LAYOUT("signed char", char, char),
+    LAYOUT("unsigned char", char, char),
+    LAYOUT("short", short, short),
+    LAYOUT("short int", short, short),
+    LAYOUT("unsigned short", short, short),
+    LAYOUT("unsigned short int", short, short),
+    LAYOUT("int", int, int),
+    LAYOUT("signed", int, int),
+    LAYOUT("unsigned", int, int),
+    LAYOUT("signed int", int, int),
+    LAYOUT("unsigned int", int, int),
+    LAYOUT("long", long, long),
+    LAYOUT("long int", long, long),
+    LAYOUT("unsigned long", long, long),
+    LAYOUT("unsigned long int", long, long),
+    LAYOUT("long long", llong, long long),
+    LAYOUT("unsigned long long", llong, long long),
+    LAYOUT("float", float, float),
+    LAYOUT("double", double, double),
+    LAYOUT("long double", ldouble, long double),
+
+    /* Fixed-width types, CZar and <stdint.h> spellings */
+    LAYOUT("u8", i8, int8_t),
+    LAYOUT("i8", i8, int8_t),
+    LAYOUT("uint8_t", i8, int8_t),
+    LAYOUT("int8_t", i8, int8_t),
+    LAYOUT("u16", i16, int16_t),
+    LAYOUT("i16", i16, int16_t),
+    LAYOUT("uint16_t", i16, int16_t),
+    LAYOUT("int16_t", i16, int16_t),
+    LAYOUT("u32", i32, int32_t),
+    LAYOUT("i32", i32, int32_t),
+    LAYOUT("uint32_t", i32, int32_t),
+    LAYOUT("int32_t", i32, int32_t),
+    LAYOUT("u64", i64, int64_t),
+    LAYOUT("i64", i64, int64_t),
+    LAYOUT("uint64_t", i64, int64_t),
+    LAYOUT("int64_t", i64, int64_t),
+    LAYOUT("f32", float, float),
+    LAYOUT("f64", double, double),
+
+    /* Architecture-dependent size types */
+    LAYOUT("usize", size, size_t),
+    LAYOUT("size_t", size, size_t),
+    LAYOUT("isize", ptrdiff, ptrdiff_t),
+    LAYOUT("ptrdiff_t", ptrdiff, ptrdiff_t),
+    LAYOUT("intptr_t", intptr, intptr_t),
+    LAYOUT("uintptr_t", intptr, intptr_t),
+    LAYOUT("void *", pointer, void *),
+
+    {NULL, 0, 0} /* Sentinel */
+};
+
+#undef LAYOUT
+
+/* Get the size and alignment of a scalar type (CZar or C spelling, words separated by one space,
+ * "void *" for pointers) on the ABI cz was built for, returns false for other types */
+bool transpiler_get_type_layout(const char *name, size_t *size, size_t *align) {
+    for (int i = 0; type_layouts[i].name != NULL; i++) {
+        if (strcmp(name, type_layouts[i].name) == 0) {
+            *size = type_layouts[i].size;
+            *align = type_layouts[i].align;
+            return true;
+        }
+    }
+    return false;
+}
@@ -8,5 +8,12 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+
 /* Check if identifier is a CZar type and return C equivalent */
 const char *transpiler_get_c_type(const char *identifier);
+
+/* Get the size and alignment of a scalar type (CZar or C spelling, words separated by one space,
+ * "void *" for pointers) on the ABI cz was built for, returns false for other types */
+bool transpiler_get_type_layout(const char *name, size_t *size, size_t *align);
@@ -4,11 +4,31 @@
  * https://github.com/shkschneider/czar
  *
  * Handles inline expansion of UNREACHABLE() calls without macros.
+ * Sites call shared helpers emitted once per .cz.c: a cold diagnostic one,
+ * or with #pragma czar debug false an optimizer hint for UNREACHABLE().
  */
 
 #pragma once
 
 #include "../parser.h"
+#include "../rewrite.h"
+#include "../sink.h"
+#include <stddef.h>
 
 /* Expand UNREACHABLE() calls inline with .cz file location */
 void transpiler_expand_unreachable(ASTNode_t *ast, const char *filename);
+
+/* Expand the UNREACHABLE(...) call at index, returns the last child index it consumed */
+size_t transpiler_visit_unreachable(ASTNode_t *ast, size_t index, const char *filename, ASTRewrite_t *rewrite);
+
+/* Build the code of a failure site (free() it, NULL when out of memory):
+ * "{ _cz_fail("file:line: function: reason: message\n"); }",
+ * or "{ _cz_unreachable(); }" for prunable sites (UNREACHABLE, missing defaults) in release mode */
+char *unreachable_site_code(const char *filename, int line, const char *function,
+                            const char *reason, const char *message, int prunable);
+
+/* Emit the helpers the failure sites of this translation unit call */
+void transpiler_emit_unreachable_helpers(OutputSink_t *output);
+
+/* Forget the helpers used by the translation unit */
+void transpiler_free_unreachable_tables(void);
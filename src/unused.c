@@ -15,7 +15,7 @@
 #define ATTRIBUTE_UNUSED "__attribute__((unused))"
 
 /* Counter for generating unique unused variable names */
-static int unused_counter = 0;
+static CZ_THREAD_LOCAL int unused_counter = 0;
 
 /* Transform _ identifier to unique unused variable name */
 char *transpiler_transform_unused_identifier(void) {
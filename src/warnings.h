@@ -12,11 +12,19 @@
 /* Warning reporting function */
 void cz_warning(const char *filename, const char *source, int line, const char *message);
 
+/* Warning reporting with a caret under column (1-based, 0 if unknown) */
+void cz_warning_at(const char *filename, const char *source, int line, int column, const char *message);
+
 /* Cast Warnings */
 #define WARN_CAST_WITHOUT_FALLBACK \
     "cast<%s>(value) without fallback. " \
     "Consider the safer cast<%s>(value, fallback)."
 
+/* Mutability Warnings */
+#define WARN_RESTRICT_ALIASED_ARGUMENT \
+    "Call to '%s' passes the same pointer as arguments %zu and %zu, but its mut pointer parameters are restrict. " \
+    "Pass distinct objects, or remove #pragma czar restrict."
+
 /* Enum/Switch Warnings */
 #define WARN_UNSCOPED_ENUM_CONSTANT \
     "Unscoped enum constant '%s' in switch. " \
@@ -24,12 +32,9 @@ void cz_warning(const char *filename, const char *source, int line, const char *
 #define WARN_SWITCH_MISSING_DEFAULT \
     "Switch statement should have a default case. " \
     "Consider adding 'default: UNREACHABLE(\"\");' or appropriate handling."
-
-/* Tracking Limit Warnings */
-#define WARN_MAX_METHOD_TRACKING_LIMIT \
-    "Maximum method tracking limit (%d) reached"
-#define WARN_MAX_STRUCT_TYPE_TRACKING_LIMIT \
-    "Maximum struct type tracking limit (%d) reached"
-#define WARN_MAX_ENUM_TRACKING_LIMIT \
-    "Maximum number of tracked enums (%d) reached. " \
-    "Exhaustiveness checking may be incomplete for enum '%s'."
+#define WARN_ENUM_NAMES_NOT_DENSE \
+    "#pragma czar names ignored: values of enum '%s' are not contiguous integer literals."
+#define WARN_TABLE_SWITCH_IGNORED \
+    "#pragma czar table ignored: %s."
+#define WARN_UNKNOWN_FEATURE \
+    "#pragma czar feature ignores '%.*s': expected '-name' of a feature to skip."
@@ -0,0 +1,145 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Per-file memory accounting for cz --stats.
+ */
+
+#include "src/cz.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #define PSAPI_VERSION 2
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+/* Stats being recorded, NULL when --stats is off */
+CZ_THREAD_LOCAL Stats_t *g_stats = NULL;
+
+/* Initialize empty stats */
+void stats_init(Stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+/* Free stats storage */
+void stats_free(Stats_t *stats) {
+    free(stats->tables);
+    stats_init(stats);
+}
+
+/* Add bytes to the table of feature name */
+void stats_table(Stats_t *stats, const char *name, size_t bytes) {
+    for (size_t i = 0; i < stats->table_count; i++) {
+        if (strcmp(stats->tables[i].name, name) == 0) {
+            stats->tables[i].bytes += bytes;
+            return;
+        }
+    }
+    if (stats->table_count >= stats->table_capacity) {
+        size_t new_capacity = stats->table_capacity == 0 ? 16 : stats->table_capacity * 2;
+        StatsTable_t *new_tables = realloc(stats->tables, new_capacity * sizeof(StatsTable_t));
+        if (!new_tables) {
+            return;
+        }
+        stats->tables = new_tables;
+        stats->table_capacity = new_capacity;
+    }
+    stats->tables[stats->table_count].name = name;
+    stats->tables[stats->table_count].bytes = bytes;
+    stats->table_count++;
+}
+
+/* Count node and every node below it */
+size_t stats_count_nodes(const ASTNode_t *node) {
+    if (!node) {
+        return 0;
+    }
+    size_t count = 1;
+    for (size_t i = 0; i < node->child_count; i++) {
+        count += stats_count_nodes(node->children[i]);
+    }
+    return count;
+}
+
+/* Get the peak resident set of the process in bytes (0 if unknown) */
+size_t stats_peak_rss(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return (size_t)counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+/* Add stats into total (the peak resident set is the largest one) */
+void stats_merge(Stats_t *total, const Stats_t *stats) {
+    total->files += stats->files;
+    total->tokens += stats->tokens;
+    total->nodes += stats->nodes;
+    total->text_bytes += stats->text_bytes;
+    total->arena_bytes += stats->arena_bytes;
+    total->symbol_bytes += stats->symbol_bytes;
+    for (size_t i = 0; i < stats->table_count; i++) {
+        stats_table(total, stats->tables[i].name, stats->tables[i].bytes);
+    }
+    if (stats->peak_rss > total->peak_rss) {
+        total->peak_rss = stats->peak_rss;
+    }
+}
+
+/* Bytes accounted for: token text, AST arena, interner and feature tables */
+static size_t held_bytes(const Stats_t *stats) {
+    size_t bytes = stats->text_bytes + stats->arena_bytes + stats->symbol_bytes;
+    for (size_t i = 0; i < stats->table_count; i++) {
+        bytes += stats->tables[i].bytes;
+    }
+    return bytes;
+}
+
+/* Print stats as a table or JSON, labelled with a file name (or "total") */
+void stats_print(FILE *output, const Stats_t *stats, const char *label, ProfileFormat format) {
+    if (format == PROFILE_FORMAT_JSON) {
+        fprintf(output, "{\"file\": ");
+        profile_print_json_string(output, label);
+        fprintf(output, ", \"files\": %zu, \"tokens\": %zu, \"nodes\": %zu, \"text_bytes\": %zu, "
+                "\"arena_bytes\": %zu, \"symbol_bytes\": %zu, \"tables\": {",
+                stats->files, stats->tokens, stats->nodes, stats->text_bytes,
+                stats->arena_bytes, stats->symbol_bytes);
+        for (size_t i = 0; i < stats->table_count; i++) {
+            fprintf(output, "%s", i > 0 ? ", " : "");
+            profile_print_json_string(output, stats->tables[i].name);
+            fprintf(output, ": %zu", stats->tables[i].bytes);
+        }
+        fprintf(output, "}, \"held_bytes\": %zu, \"peak_rss\": %zu}\n", held_bytes(stats), stats->peak_rss);
+        return;
+    }
+
+    fprintf(output, "[CZ] stats: %s\n", label);
+    fprintf(output, "  %-24s %12zu\n", "tokens", stats->tokens);
+    fprintf(output, "  %-24s %12zu\n", "nodes", stats->nodes);
+    fprintf(output, "  %-24s %12zu\n", "token text bytes", stats->text_bytes);
+    fprintf(output, "  %-24s %12zu\n", "ast arena bytes", stats->arena_bytes);
+    fprintf(output, "  %-24s %12zu\n", "symbol bytes", stats->symbol_bytes);
+    for (size_t i = 0; i < stats->table_count; i++) {
+        fprintf(output, "  tables: %-16s %12zu\n", stats->tables[i].name, stats->tables[i].bytes);
+    }
+    fprintf(output, "  %-24s %12zu\n", "held bytes", held_bytes(stats));
+    fprintf(output, "  %-24s %12zu\n", "peak rss bytes", stats->peak_rss);
+}
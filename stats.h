@@ -0,0 +1,59 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Per-file memory accounting for cz --stats.
+ */
+
+#pragma once
+
+#include "parser.h"
+#include "profile.h"
+#include "worker.h"
+#include <stdio.h>
+#include <stddef.h>
+
+/* Bytes held by the symbol tables of one feature */
+typedef struct {
+    const char *name;            /* Feature name */
+    size_t bytes;                /* Bytes held once the file is transpiled */
+} StatsTable_t;
+
+/* Sizes of what transpiling a file holds in memory */
+typedef struct {
+    size_t files;                /* Number of files merged in */
+    size_t tokens;               /* Tokens parsed */
+    size_t nodes;                /* AST nodes once transformed */
+    size_t text_bytes;           /* Bytes of token text in the lexer pool */
+    size_t arena_bytes;          /* Bytes handed out by the AST arena */
+    size_t symbol_bytes;         /* Bytes held by the interned identifiers */
+    StatsTable_t *tables;        /* Per-feature symbol tables, in registration order */
+    size_t table_count;          /* Number of tables */
+    size_t table_capacity;       /* Capacity of tables array */
+    size_t peak_rss;             /* Peak resident set of the process so far (0 if unknown) */
+} Stats_t;
+
+/* Stats being recorded, NULL when --stats is off */
+extern CZ_THREAD_LOCAL Stats_t *g_stats;
+
+/* Initialize empty stats */
+void stats_init(Stats_t *stats);
+
+/* Free stats storage */
+void stats_free(Stats_t *stats);
+
+/* Add bytes to the table of feature name */
+void stats_table(Stats_t *stats, const char *name, size_t bytes);
+
+/* Count node and every node below it */
+size_t stats_count_nodes(const ASTNode_t *node);
+
+/* Get the peak resident set of the process in bytes (0 if unknown) */
+size_t stats_peak_rss(void);
+
+/* Add stats into total (the peak resident set is the largest one) */
+void stats_merge(Stats_t *total, const Stats_t *stats);
+
+/* Print stats as a table or JSON, labelled with a file name (or "total") */
+void stats_print(FILE *output, const Stats_t *stats, const char *label, ProfileFormat format);
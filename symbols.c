@@ -0,0 +1,200 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Interns identifiers and keywords into stable symbol IDs.
+ */
+
+#include "symbols.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Keyword names indexed by their fixed symbol ID */
+static const char *keyword_names[SYM_FIRST_IDENTIFIER] = {
+    NULL,
+    /* C keywords */
+    "auto", "break", "case", "char", "const", "continue", "default", "do",
+    "double", "else", "enum", "extern", "float", "for", "goto", "if",
+    "inline", "int", "long", "register", "restrict", "return", "short", "signed",
+    "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned", "void",
+    "volatile", "while", "_Alignas", "_Alignof", "_Atomic", "_Bool", "_Complex",
+    "_Generic", "_Imaginary", "_Noreturn", "_Static_assert", "_Thread_local",
+    /* CZar keywords */
+    "mut", "defer", "unreachable", "todo", "fixme",
+};
+
+/* Keyword hash table size (power of two) */
+#define KEYWORD_SLOTS 128
+
+/* Keyword slots: symbol ID or SYM_NONE, built on first use */
+static unsigned char keyword_slots[KEYWORD_SLOTS];
+static int keyword_slots_ready = 0;
+
+/* Hash a keyword candidate (perfect for the current keyword set, probing covers additions) */
+static unsigned keyword_hash(const char *text, size_t length) {
+    unsigned first = (unsigned char)text[0];
+    unsigned second = length > 1 ? (unsigned char)text[1] : 0;
+    unsigned last = (unsigned char)text[length - 1];
+    return (first * 17 + last * 49 + second * 3 + (unsigned)length) & (KEYWORD_SLOTS - 1);
+}
+
+/* Fill the keyword slot table */
+static void build_keyword_slots(void) {
+    for (int id = SYM_NONE + 1; id < SYM_FIRST_IDENTIFIER; id++) {
+        const char *name = keyword_names[id];
+        unsigned slot = keyword_hash(name, strlen(name));
+        while (keyword_slots[slot] != SYM_NONE) {
+            slot = (slot + 1) & (KEYWORD_SLOTS - 1);
+        }
+        keyword_slots[slot] = (unsigned char)id;
+    }
+    keyword_slots_ready = 1;
+}
+
+/* Classify text as a keyword, returns SYM_NONE for anything else */
+int symbols_keyword(const char *text, size_t length) {
+    if (!text || length == 0) {
+        return SYM_NONE;
+    }
+
+    if (!keyword_slots_ready) {
+        build_keyword_slots();
+    }
+
+    unsigned slot = keyword_hash(text, length);
+    while (keyword_slots[slot] != SYM_NONE) {
+        const char *name = keyword_names[keyword_slots[slot]];
+        if (strncmp(name, text, length) == 0 && name[length] == '\0') {
+            return keyword_slots[slot];
+        }
+        slot = (slot + 1) & (KEYWORD_SLOTS - 1);
+    }
+
+    return SYM_NONE;
+}
+
+/* FNV-1a hash of identifier text */
+static size_t identifier_hash(const char *text, size_t length) {
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/* Initialize an empty symbol table */
+void symbols_init(SymbolTable *table) {
+    /* Built here too so the table is ready before any worker thread reads it */
+    if (!keyword_slots_ready) {
+        build_keyword_slots();
+    }
+    table->names = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->slots = NULL;
+    table->slot_count = 0;
+}
+
+/* Free all interned names */
+void symbols_free(SymbolTable *table) {
+    for (size_t i = 0; i < table->count; i++) {
+        free(table->names[i]);
+    }
+    free(table->names);
+    free(table->slots);
+    symbols_init(table);
+}
+
+/* Rehash all interned names into a larger slot array */
+static int grow_slots(SymbolTable *table) {
+    size_t new_count = table->slot_count == 0 ? 256 : table->slot_count * 2;
+    int *new_slots = calloc(new_count, sizeof(int));
+    if (!new_slots) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < table->count; i++) {
+        const char *name = table->names[i];
+        size_t slot = identifier_hash(name, strlen(name)) & (new_count - 1);
+        while (new_slots[slot] != 0) {
+            slot = (slot + 1) & (new_count - 1);
+        }
+        new_slots[slot] = (int)(i + SYM_FIRST_IDENTIFIER);
+    }
+
+    free(table->slots);
+    table->slots = new_slots;
+    table->slot_count = new_count;
+    return 1;
+}
+
+/* Intern text and return its symbol ID (keywords get their fixed ID) */
+int symbols_intern(SymbolTable *table, const char *text, size_t length) {
+    if (!table || !text || length == 0) {
+        return SYM_NONE;
+    }
+
+    int keyword = symbols_keyword(text, length);
+    if (keyword != SYM_NONE) {
+        return keyword;
+    }
+
+    /* Keep the load factor under one half */
+    if ((table->count + 1) * 2 > table->slot_count && !grow_slots(table)) {
+        return SYM_NONE;
+    }
+
+    size_t slot = identifier_hash(text, length) & (table->slot_count - 1);
+    while (table->slots[slot] != 0) {
+        const char *name = table->names[table->slots[slot] - SYM_FIRST_IDENTIFIER];
+        if (strncmp(name, text, length) == 0 && name[length] == '\0') {
+            return table->slots[slot];
+        }
+        slot = (slot + 1) & (table->slot_count - 1);
+    }
+
+    /* New identifier */
+    if (table->count >= table->capacity) {
+        size_t new_capacity = table->capacity == 0 ? 128 : table->capacity * 2;
+        char **new_names = realloc(table->names, new_capacity * sizeof(char *));
+        if (!new_names) {
+            return SYM_NONE;
+        }
+        table->names = new_names;
+        table->capacity = new_capacity;
+    }
+
+    char *name = malloc(length + 1);
+    if (!name) {
+        return SYM_NONE;
+    }
+    memcpy(name, text, length);
+    name[length] = '\0';
+
+    int id = (int)(table->count + SYM_FIRST_IDENTIFIER);
+    table->names[table->count++] = name;
+    table->slots[slot] = id;
+    return id;
+}
+
+/* Get the name of a symbol ID, or NULL if unknown */
+const char *symbols_name(const SymbolTable *table, int id) {
+    if (id > SYM_NONE && id < SYM_FIRST_IDENTIFIER) {
+        return keyword_names[id];
+    }
+    if (table && id >= SYM_FIRST_IDENTIFIER && (size_t)(id - SYM_FIRST_IDENTIFIER) < table->count) {
+        return table->names[id - SYM_FIRST_IDENTIFIER];
+    }
+    return NULL;
+}
+
+/* Get the bytes held by the interned names and their hash */
+size_t symbols_bytes(const SymbolTable *table) {
+    size_t bytes = table->capacity * sizeof(char *) + table->slot_count * sizeof(int);
+    for (size_t i = 0; i < table->count; i++) {
+        bytes += strlen(table->names[i]) + 1;
+    }
+    return bytes;
+}
@@ -0,0 +1,54 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Interns identifiers and keywords into stable symbol IDs.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/* Fixed symbol IDs for C and CZar keywords (C11 underscore keywords drop the underscore) */
+typedef enum {
+    SYM_NONE = 0,
+    /* C keywords */
+    SYM_AUTO, SYM_BREAK, SYM_CASE, SYM_CHAR, SYM_CONST, SYM_CONTINUE, SYM_DEFAULT, SYM_DO,
+    SYM_DOUBLE, SYM_ELSE, SYM_ENUM, SYM_EXTERN, SYM_FLOAT, SYM_FOR, SYM_GOTO, SYM_IF,
+    SYM_INLINE, SYM_INT, SYM_LONG, SYM_REGISTER, SYM_RESTRICT, SYM_RETURN, SYM_SHORT, SYM_SIGNED,
+    SYM_SIZEOF, SYM_STATIC, SYM_STRUCT, SYM_SWITCH, SYM_TYPEDEF, SYM_UNION, SYM_UNSIGNED, SYM_VOID,
+    SYM_VOLATILE, SYM_WHILE, SYM_ALIGNAS, SYM_ALIGNOF, SYM_ATOMIC, SYM_BOOL, SYM_COMPLEX,
+    SYM_GENERIC, SYM_IMAGINARY, SYM_NORETURN, SYM_STATIC_ASSERT, SYM_THREAD_LOCAL,
+    /* CZar keywords */
+    SYM_MUT, SYM_DEFER, SYM_UNREACHABLE, SYM_TODO, SYM_FIXME,
+    /* First ID handed out to interned identifiers */
+    SYM_FIRST_IDENTIFIER
+} SymbolKeyword;
+
+/* Per-run table of interned identifiers */
+typedef struct {
+    char **names;           /* Interned names, indexed by ID - SYM_FIRST_IDENTIFIER */
+    size_t count;           /* Number of interned names */
+    size_t capacity;        /* Capacity of names array */
+    int *slots;             /* Open-addressing hash of IDs (0 = empty) */
+    size_t slot_count;      /* Number of hash slots (power of two) */
+} SymbolTable;
+
+/* Initialize an empty symbol table */
+void symbols_init(SymbolTable *table);
+
+/* Free all interned names */
+void symbols_free(SymbolTable *table);
+
+/* Classify text as a keyword, returns SYM_NONE for anything else */
+int symbols_keyword(const char *text, size_t length);
+
+/* Intern text and return its symbol ID (keywords get their fixed ID) */
+int symbols_intern(SymbolTable *table, const char *text, size_t length);
+
+/* Get the name of a symbol ID, or NULL if unknown */
+const char *symbols_name(const SymbolTable *table, int id);
+
+/* Get the bytes held by the interned names and their hash */
+size_t symbols_bytes(const SymbolTable *table);
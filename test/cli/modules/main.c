@@ -0,0 +1,6 @@
+#include "start.cz.h"
+
+int main(void) {
+    start();
+    return 0;
+}
@@ -1,9 +1,63 @@
 #include "../../dist/cz.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Body of the benchmark checked below */
+static void bench_itoa(void *arg, unsigned long long iterations) {
+    (void)arg;
+    char buf[CZ_ITOA_MAX];
+    for (unsigned long long i = 0; i < iterations; i++) {
+        cz_do_not_optimize(cz_itoa((long long)i, buf));
+    }
+}
+
+/* Producers logging through a tiny blocking ring while it stops */
+static cz_task_group_t g_loggers;
+
+static void task_log(void *ctx) {
+    (void)ctx;
+    for (int i = 0; i < 1000; i++) {
+        cz_log_debug("racing the stop");
+    }
+}
+
+/* Tasks of the group below, each spawning two more down to a depth */
+static cz_task_group_t g_tasks;
+static _Atomic int g_tasks_run = 0;
+
+static void task_tree(void *ctx) {
+    uintptr_t depth = (uintptr_t)ctx;
+    g_tasks_run++;
+    if (depth > 0) {
+        cz_task_spawn(&g_tasks, task_tree, (void *)(depth - 1));
+        cz_task_spawn(&g_tasks, task_tree, (void *)(depth - 1));
+    }
+}
+
+/* Body of the parallel loops below */
+static void range_squares(size_t begin, size_t end, void *ctx) {
+    unsigned long long *squares = ctx;
+    for (size_t i = begin; i < end; i++) {
+        squares[i] += (unsigned long long)i * i;
+    }
+}
+
+/* Body of the parallel loop pushing its indexes to the queue at ctx */
+static void range_push(size_t begin, size_t end, void *ctx) {
+    for (size_t i = begin; i < end; i++) {
+        cz_assert(cz_mpmc_push(ctx, &i));
+    }
+}
 
 int main(void) {
     const char *name = "world";
     cz_assert(name != NULL);
+    /* Debug assertions and assumptions are checked (and evaluated) without NDEBUG */
+    int checks = 0;
+    cz_debug_assert(++checks == 1);
+    cz_assume(++checks == 2);
+    cz_assert(checks == 2);
     cz_log_debug("Hello");
     char clock[1024];
     sprintf(&clock[0], "t = %llu ns", cz_monotonic_clock_ns());
@@ -12,6 +66,337 @@ int main(void) {
     char timer[1024];
     sprintf(&timer[0], "t + %llu ns", cz_monotonic_timer_ns());
     cz_log_warn(timer);
+
+    /* Cycle counter differences convert to about the elapsed time, coarse clocks trail the precise one */
+    unsigned long long before_ns = cz_monotonic_clock_ns();
+    unsigned long long before = cz_cycles();
+    cz_nanosleep(2000000ULL);
+    unsigned long long cycles = cz_cycles() - before;
+    unsigned long long slept_ns = cz_monotonic_clock_ns() - before_ns;
+    cz_assert(cz_cycles_to_ns(cycles) > slept_ns / 2 && cz_cycles_to_ns(cycles) < slept_ns * 2);
+    cz_assert(cz_monotonic_coarse_ns() <= cz_monotonic_clock_ns());
+    cz_assert(cz_monotonic_coarse_timer_ns() <= cz_monotonic_timer_ns());
     fprintf(stdout, "%s", cz_format("Hello, {{}}!\n", name));
+
+    /* Formatting into caller storage reports the full length and truncates safely */
+    char small[8];
+    size_t length = cz_format_to(&small[0], sizeof(small), "{} + {} = {{sum}}", 40, 2, 42L);
+    cz_assert(length == cz_format_len("{} + {} = {{sum}}", 40, 2, 42L));
+    cz_assert(length == strlen("40 + 2 = 42") && strcmp(&small[0], "40 + 2 ") == 0);
+    char *long_line = cz_format("[{}] {}", "a string longer than the sixty-four bytes once estimated per argument, surely", 'x');
+    cz_assert(long_line && strlen(long_line) == cz_format_len("[{}] {}", "a string longer than the sixty-four bytes once estimated per argument, surely", 'x'));
+    free(long_line);
+
+    /* Compiled and static templates format like cz_format() */
+    cz_format_template_t *tpl = cz_format_compile("{{name}} is {} years {old");
+    cz_assert(tpl && tpl->count == 4);
+    char *age = cz_format_apply(tpl, name, 7);
+    cz_assert(strcmp(age, "world is 7 years {old") == 0);
+    free(age);
+    cz_format_template_free(tpl);
+    static const cz_format_segment_t hello_segments[] = { CZ_FORMAT_TEXT("Hello, "), CZ_FORMAT_SLOT, CZ_FORMAT_TEXT("!") };
+    static const cz_format_template_t hello = CZ_FORMAT_TEMPLATE(hello_segments);
+    char greeting[32];
+    cz_assert(cz_format_apply_to(&greeting[0], sizeof(greeting), &hello, name) == 13);
+    cz_assert(strcmp(&greeting[0], "Hello, world!") == 0);
+
+    /* Conversions: exact integers, shortest round-trip doubles, hex pointers */
+    char number[CZ_DTOA_MAX];
+    cz_assert(cz_itoa(-9223372036854775807LL - 1, &number[0]) == 20 && strcmp(&number[0], "-9223372036854775808") == 0);
+    cz_assert(cz_utoa(18446744073709551615ULL, &number[0]) == 20 && strcmp(&number[0], "18446744073709551615") == 0);
+    cz_assert(cz_utoa(7, &number[0]) == 1 && strcmp(&number[0], "7") == 0);
+    cz_assert(cz_dtoa(0.1, &number[0]) == 3 && strcmp(&number[0], "0.1") == 0);
+    cz_assert(cz_dtoa(-2.5e-3, &number[0]) && strcmp(&number[0], "-0.0025") == 0);
+    cz_assert(cz_dtoa(0.1 + 0.2, &number[0]) && strcmp(&number[0], "0.30000000000000004") == 0);
+    cz_assert(cz_dtoa(1e300, &number[0]) && strcmp(&number[0], "1e+300") == 0);
+    for (int i = 1; i < 10000; i++) {
+        double value = (double)rand() / (double)(i * 7919) * (i % 2 ? 1e-9 : 1e9);
+        cz_dtoa(value, &number[0]);
+        cz_assert(strtod(&number[0], NULL) == value);
+    }
+    cz_assert(cz_ptoa((void *)0x1f, &number[0]) == 4 && strcmp(&number[0], "0x1f") == 0);
+    char *mixed = cz_format("{} {} {}", 1.5, -3, (size_t)4);
+    cz_assert(strcmp(mixed, "1.5 -3 4") == 0);
+    free(mixed);
+
+    /* Async logging: messages are queued and written by a background thread */
+    cz_assert(cz_log_async_start(16, CZ_LOG_OVERFLOW_BLOCK));
+    for (int i = 0; i < 64; i++) {
+        char line[CZ_ITOA_MAX + 16];
+        cz_format_to(&line[0], sizeof(line), "async #{}", i);
+        cz_log_debug(&line[0]);
+    }
+    cz_log_flush();
+    cz_assert(cz_log_dropped() == 0);
+    cz_log_async_stop();
+    cz_log_info("sync again");
+
+    /* Stopping under producers: the ring outlives them, blocked ones log synchronously */
+    cz_threadpool_t *loggers = cz_threadpool_create(4);
+    cz_assert(loggers != NULL);
+    for (int round = 0; round < 8; round++) {
+        cz_assert(cz_log_async_start(2, CZ_LOG_OVERFLOW_BLOCK));
+        cz_task_group_init(&g_loggers, loggers);
+        for (int t = 0; t < 4; t++) {
+            cz_task_spawn(&g_loggers, task_log, NULL);
+        }
+        cz_nanosleep((unsigned long long)round * 100000);
+        cz_log_async_stop();
+        cz_task_group_wait(&g_loggers);
+    }
+    cz_threadpool_destroy(loggers);
+
+    /* Suppressed levels never evaluate nor format their arguments */
+    int evaluated = 0;
+    cz_log_set_level(CZ_LOG_INFO);
+    cz_assert(!cz_log_enabled(CZ_LOG_DEBUG) && cz_log_enabled(CZ_LOG_ERROR));
+    cz_logf(CZ_LOG_DEBUG, "hidden {}", ++evaluated);
+    cz_logf(CZ_LOG_INFO, "shown {} {}", ++evaluated, 2.5);
+    cz_assert(evaluated == 1);
+    cz_log_set_level(CZ_LOG_DEBUG);
+
+    /* Arenas: aligned bump allocations, marks rewind, oversized requests get their own block */
+    cz_arena_t arena = CZ_ARENA_INIT;
+    char *first = cz_arena_alloc(&arena, 3);
+    double *values = cz_arena_array(&arena, double, 4);
+    cz_assert(first && values && ((uintptr_t)values % _Alignof(double)) == 0);
+    cz_arena_mark_t mark = cz_arena_mark(&arena);
+    void *page = cz_arena_alloc_aligned(&arena, 100, 4096);
+    cz_assert(page && ((uintptr_t)page % 4096) == 0);
+    char *huge = cz_arena_alloc(&arena, CZ_ARENA_BLOCK_SIZE * 2);
+    cz_assert(huge && huge != first);
+    huge[CZ_ARENA_BLOCK_SIZE * 2 - 1] = 'x';
+    cz_arena_reset(&arena, mark);
+    cz_assert(cz_arena_alloc_aligned(&arena, 100, 4096) == page);
+    cz_assert(cz_arena_alloc(&arena, CZ_ARENA_BLOCK_SIZE * 2) == huge);
+    cz_assert(cz_arena_alloc_aligned(&arena, 1, 3) == NULL);
+    cz_arena_release(&arena);
+    cz_assert(arena.head == NULL && arena.spare == NULL);
+    cz_arena_t *scratch = cz_arena_scratch();
+    cz_arena_mark_t start = cz_arena_mark(scratch);
+    cz_assert(cz_arena_new(scratch, cz_arena_mark_t) != NULL);
+    cz_arena_reset(scratch, start);
+    cz_arena_release(scratch);
+
+    /* Pools: blocks come back through the cache first, batches move between cache and pool */
+    typedef struct { long id; char name[24]; } connection_t;
+    cz_pool_t *pool = cz_pool_create_for(connection_t, true);
+    cz_assert(pool != NULL);
+    cz_pool_cache_t cache;
+    cz_pool_cache_init(&cache, pool);
+    connection_t *connections[200];
+    for (int i = 0; i < 200; i++) {
+        connections[i] = cz_pool_cache_new(&cache, connection_t);
+        cz_assert(connections[i] && ((uintptr_t)connections[i] % _Alignof(connection_t)) == 0);
+        connections[i]->id = i;
+    }
+    for (int i = 0; i < 200; i++) {
+        cz_assert(connections[i]->id == i);
+        cz_pool_cache_free(&cache, connections[i]);
+    }
+    cz_assert(cz_pool_cache_alloc(&cache) == connections[199]);
+    cz_pool_cache_free(&cache, connections[199]);
+    cz_pool_cache_flush(&cache);
+    cz_assert(cache.count == 0 && cache.free == NULL);
+    void *shared = cz_pool_alloc(pool);
+    cz_pool_free(pool, shared);
+    cz_pool_destroy(pool);
+
+    /* String builders start inline, move to the heap once and keep their storage across resets */
+    cz_strbuf_t sb = CZ_STRBUF_INIT;
+    cz_assert(cz_strbuf_puts(&sb, "id=") && cz_strbuf_putc(&sb, '#'));
+    cz_assert(cz_strbuf_appendf(&sb, "{}/{}", 42, "x") && sb.heap == NULL);
+    cz_assert(strcmp(cz_strbuf_str(&sb), "id=#42/x") == 0 && sb.len == 8);
+    for (int i = 0; i < 30; i++) {
+        cz_assert(cz_strbuf_appendf(&sb, " {}", i));
+    }
+    cz_assert(sb.heap != NULL && sb.len == strlen(cz_strbuf_str(&sb)) && sb.len == 8 + 10 * 2 + 20 * 3);
+    char *heap = sb.heap;
+    cz_strbuf_reset(&sb);
+    cz_assert(cz_strbuf_str(&sb)[0] == '\0' && cz_strbuf_append(&sb, "abc", 2) && sb.heap == heap);
+    char *taken = cz_strbuf_take(&sb);
+    cz_assert(taken == heap && strcmp(taken, "ab") == 0 && sb.heap == NULL && sb.len == 0);
+    free(taken);
+    cz_assert(cz_strbuf_puts(&sb, "small"));
+    taken = cz_strbuf_take(&sb);
+    cz_assert(strcmp(taken, "small") == 0);
+    free(taken);
+    cz_strbuf_free(&sb);
+
+    /* Maps: integer and string keys, removals, rehashes that keep the insertion order */
+    cz_map_t ids;
+    cz_map_init(&ids, CZ_MAP_INT);
+    for (uintptr_t i = 0; i < 1000; i++) {
+        cz_assert(cz_map_put_int(&ids, i * 7919, (void *)(i + 1)));
+    }
+    cz_assert(ids.count == 1000 && *cz_map_get_int(&ids, 42 * 7919) == (void *)43);
+    cz_assert(cz_map_get_int(&ids, 3) == NULL && cz_map_get_string(&ids, "3") == NULL);
+    for (uintptr_t i = 0; i < 1000; i += 2) {
+        cz_assert(cz_map_remove_int(&ids, i * 7919));
+    }
+    cz_assert(!cz_map_remove_int(&ids, 0) && ids.count == 500);
+    for (uintptr_t i = 1000; i < 3000; i++) {
+        cz_assert(cz_map_put_int(&ids, i * 7919, (void *)(i + 1)));
+    }
+    size_t cursor = 0;
+    uintptr_t previous = 0;
+    size_t visited = 0;
+    for (cz_map_entry_t *e; (e = cz_map_next(&ids, &cursor)) != NULL; visited++) {
+        cz_assert((uintptr_t)e->value > previous && e->key.integer == ((uintptr_t)e->value - 1) * 7919);
+        previous = (uintptr_t)e->value;
+    }
+    cz_assert(visited == 2500 && ids.count == 2500);
+    cz_map_free(&ids);
+    cz_map_t names;
+    cz_map_init(&names, CZ_MAP_STRING);
+    cz_assert(cz_map_reserve(&names, 100));
+    size_t slot_count = names.slot_count;
+    char key[32];
+    for (int i = 0; i < 100; i++) {
+        cz_format_to(&key[0], sizeof(key), "name number {}", i);
+        cz_assert(cz_map_put_string(&names, &key[0], NULL));
+    }
+    cz_assert(names.slot_count == slot_count && names.count == 100);
+    cz_assert(cz_map_get_string(&names, "name number 99") && !cz_map_get_string(&names, "name number 100"));
+    cz_assert(cz_map_put_string(&names, "name number 7", &names) && *cz_map_get_string(&names, "name number 7") == &names);
+    cz_assert(names.count == 100 && cz_map_remove_string(&names, "name number 7"));
+    cz_assert(!cz_map_get_string(&names, "name number 7") && cz_map_get_string(&names, "name number 8"));
+    cz_map_clear(&names);
+    cz_assert(names.count == 0 && !cz_map_get_string(&names, "name number 8"));
+    cz_map_free(&names);
+
+    /* Parallel loops visit every index exactly once, task groups wait for nested spawns */
+    cz_threadpool_t *threads = cz_threadpool_create(3);
+    cz_assert(threads != NULL && cz_threadpool_workers(threads) == 3);
+    unsigned long long *squares = calloc(100000, sizeof(unsigned long long));
+    cz_assert(squares != NULL);
+    cz_parallel_for_in(threads, 0, 100000, 64, range_squares, squares);
+    cz_parallel_for(10, 100000, 0, range_squares, squares);
+    bool squared = true;
+    for (size_t i = 0; i < 100000; i++) {
+        squared = squared && squares[i] == (unsigned long long)i * i * (i < 10 ? 1 : 2);
+    }
+    cz_assert(squared);
+    free(squares);
+    cz_task_group_init(&g_tasks, threads);
+    cz_task_spawn(&g_tasks, task_tree, (void *)(uintptr_t)10);
+    cz_task_group_wait(&g_tasks);
+    cz_assert(g_tasks_run == 2047);
+    cz_threadpool_destroy(threads);
+    cz_assert(cz_threadpool_default() != NULL && cz_threadpool_workers(cz_threadpool_default()) > 0);
+
+    /* Queues round their capacity up, wrap around, move batches and hand every element over once */
+    cz_spsc_t *spsc = cz_spsc_create_for(5, int);
+    cz_assert(spsc != NULL);
+    int ints[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    int popped[8] = { 0 };
+    cz_assert(cz_spsc_push_n(spsc, ints, 6) == 6 && cz_spsc_pop_n(spsc, popped, 4) == 4 && popped[3] == 4);
+    cz_assert(cz_spsc_push_n(spsc, ints, 8) == 6 && cz_spsc_count(spsc) == 8 && !cz_spsc_push(spsc, &ints[0]));
+    cz_assert(cz_spsc_pop_n(spsc, popped, 8) == 8 && popped[1] == 6 && popped[2] == 1 && popped[7] == 6);
+    cz_assert(!cz_spsc_pop(spsc, &popped[0]) && cz_spsc_count(spsc) == 0);
+    cz_spsc_destroy(spsc);
+    cz_mpmc_t *mpmc = cz_mpmc_create_for(4096, size_t);
+    cz_assert(mpmc != NULL);
+    cz_parallel_for(0, 4000, 16, range_push, mpmc);
+    cz_assert(cz_mpmc_count(mpmc) == 4000);
+    bool *seen = calloc(4000, sizeof(bool));
+    cz_assert(seen != NULL);
+    size_t batch[64];
+    size_t received = 0;
+    for (size_t n; (n = cz_mpmc_pop_n(mpmc, batch, 64)) > 0; received += n) {
+        for (size_t i = 0; i < n; i++) {
+            cz_assert(batch[i] < 4000 && !seen[batch[i]]);
+            seen[batch[i]] = true;
+        }
+    }
+    cz_assert(received == 4000 && cz_mpmc_count(mpmc) == 0);
+    free(seen);
+    cz_mpmc_destroy(mpmc);
+
+    /* Mapped files split into line views, the last line may lack its newline */
+    FILE *text = fopen("lines.txt", "wb");
+    cz_assert(text != NULL);
+    fputs("first\r\n\nthird line\nlast", text);
+    fclose(text);
+    cz_file_t file;
+    cz_assert(cz_mmap_file(&file, "lines.txt") && file.size == 23 && file.mapped == 23);
+    cz_lines_t lines = cz_lines(file.data, file.size);
+    const char *line = NULL;
+    size_t line_length = 0;
+    cz_assert(cz_lines_next(&lines, &line, &line_length) && line_length == 5 && strncmp(line, "first", 5) == 0);
+    cz_assert(cz_lines_next(&lines, &line, &line_length) && line_length == 0);
+    cz_assert(cz_lines_next(&lines, &line, &line_length) && line_length == 10 && line == file.data + 8);
+    cz_assert(cz_lines_next(&lines, &line, &line_length) && line_length == 4 && strncmp(line, "last", 4) == 0);
+    cz_assert(!cz_lines_next(&lines, &line, &line_length));
+    cz_munmap_file(&file);
+    cz_assert(file.data == NULL);
+    text = fopen("lines.txt", "wb");
+    cz_assert(text != NULL);
+    fclose(text);
+    cz_assert(cz_mmap_file(&file, "lines.txt") && file.size == 0);
+    lines = cz_lines(file.data, file.size);
+    cz_assert(!cz_lines_next(&lines, &line, &line_length));
+    cz_munmap_file(&file);
+    remove("lines.txt");
+    cz_assert(!cz_mmap_file(&file, "lines.txt"));
+
+    /* Vectors grow geometrically, shrink to their length and hand their buffer over without copying */
+    cz_vec_t vec = CZ_VEC_INIT(int);
+    for (int i = 0; i < 100; i++) {
+        cz_assert(cz_vec_push_value(&vec, int, i));
+    }
+    cz_assert(vec.len == 100 && vec.cap == 128 && cz_vec_at(&vec, int, 42) == 42);
+    *(int *)cz_vec_push(&vec) = 100;
+    cz_vec_pop(&vec);
+    const int tail[] = { 100, 101 };
+    cz_assert(cz_vec_append(&vec, tail, 2) && cz_vec_data(&vec, int)[101] == 101);
+    cz_assert(cz_vec_resize(&vec, 110) && cz_vec_at(&vec, int, 109) == 0);
+    cz_vec_shrink(&vec);
+    cz_assert(vec.cap == 110);
+    cz_assert(cz_vec_reserve(&vec, 1000) && vec.cap == 1000 && vec.len == 110);
+    void *buffer = vec.data;
+    cz_vec_t moved = cz_vec_move(&vec);
+    cz_assert(moved.data == buffer && moved.len == 110 && vec.data == NULL && vec.len == 0);
+    cz_assert(cz_vec_push_value(&vec, int, 7) && vec.cap == CZ_VEC_MIN_CAP);
+    cz_vec_clear(&vec);
+    cz_vec_shrink(&vec);
+    cz_assert(vec.data == NULL && vec.cap == 0);
+    free(cz_vec_take(&moved));
+    cz_assert(moved.data == NULL && moved.cap == 0);
+    cz_vec_free(&vec);
+
+    /* Benchmarks calibrate their iterations and order their statistics */
+    cz_bench_options_t options;
+    cz_bench_options(0, NULL, &options);
+    options.warmup_ns = 100000ULL;
+    options.sample_ns = 100000ULL;
+    options.samples = 5;
+    cz_bench_t bench = { "itoa", bench_itoa, NULL };
+    cz_bench_result_t result;
+    cz_assert(cz_bench_run(&bench, &options, &result) && result.iterations > 1);
+    cz_assert(result.min_ns <= result.median_ns && result.median_ns <= result.p99_ns);
+    options.filter = "dtoa";
+    cz_assert(!cz_bench_run(&bench, &options, &result));
+
+    /* Trace zones nest per thread and are written as Chrome trace JSON */
+    cz_trace_begin("ignored while disabled");
+    cz_trace_enable(true);
+    cz_trace_begin("outer");
+    {
+        CZ_TRACE_SCOPE("inner \"quoted\"");
+    }
+    cz_trace_end();
+    cz_trace_enable(false);
+    cz_assert(cz_trace_dropped() == 0);
+    cz_assert(cz_trace_write("trace.json"));
+    FILE *trace = fopen("trace.json", "r");
+    cz_assert(trace != NULL);
+    char json[1024];
+    size_t json_length = fread(json, 1, sizeof(json) - 1, trace);
+    json[json_length] = '\0';
+    fclose(trace);
+    remove("trace.json");
+    cz_assert(strstr(json, "\"name\": \"outer\"") && strstr(json, "inner \\\"quoted\\\""));
+    cz_assert(!strstr(json, "ignored") && strstr(json, "\"ph\": \"E\""));
     return 0;
 }
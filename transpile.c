@@ -0,0 +1,358 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Transpiles one .cz input into its .cz.h and .cz.c outputs.
+ */
+
+#include "src/cz.h"
+#include "transpile.h"
+#include "input.h"
+#include "lexer.h"
+#include "parser.h"
+#include "transpiler.h"
+#include "sink.h"
+#include "compact.h"
+#include "profile.h"
+#include "stats.h"
+#include "depfile.h"
+#include "worker.h"
+#include "src/errors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Report a failure to replace an output file */
+static void output_write_failed(const char *path) {
+    char error_msg[512];
+    snprintf(error_msg, sizeof(error_msg), ERR_CANNOT_WRITE_OUTPUT_FILE, path);
+    cz_error(NULL, NULL, 0, error_msg);
+}
+
+/* Build output_base + suffix (NULL on allocation failure) */
+static char *output_path(const char *output_base, const char *suffix) {
+    size_t len = strlen(output_base) + strlen(suffix) + 1;
+    char *path = malloc(len);
+    if (path) {
+        snprintf(path, len, "%s%s", output_base, suffix);
+    }
+    return path;
+}
+
+/* Check that the dependency file of output_base exists */
+static bool dependencies_exist(const char *output_base) {
+    char *path = output_path(output_base, ".d");
+    FILE *file = path ? fopen(path, "r") : NULL;
+    free(path);
+    if (!file) {
+        return false;
+    }
+    fclose(file);
+    return true;
+}
+
+/* Stop recording and write the recorded dependencies to output_base.d (object file output_base.o, as cc -MD names it) */
+static void finish_dependencies(DependencyList_t *dependencies, const char *output_base,
+                                const char *header_file, const char *source_file) {
+    g_dependencies = NULL;
+    const char *outputs[] = { header_file, source_file };
+    char *path = output_path(output_base, ".d");
+    char *object = output_path(output_base, ".o");
+    if (!path || !object || !dependency_write(dependencies, path, outputs, 2, object)) {
+        output_write_failed(path ? path : output_base);
+    }
+    free(path);
+    free(object);
+    dependency_list_free(dependencies);
+}
+
+/* Add what transpiling the file holds in memory to g_stats (before the transpiler is cleaned up) */
+static void record_stats(const Transpiler_t *transpiler, const Parser *parser, size_t tokens,
+                         size_t text_bytes, const SymbolTable *symbols) {
+    g_stats->tokens += tokens;
+    g_stats->nodes += stats_count_nodes(transpiler->ast);
+    g_stats->text_bytes += text_bytes;
+    g_stats->arena_bytes += parser->arena.allocated;
+    g_stats->symbol_bytes += symbols ? symbols_bytes(symbols) : 0;
+    for (size_t i = 0; i < transpiler->registry.count; i++) {
+        const Feature *feature = transpiler->registry.features[i];
+        if (feature->table_bytes) {
+            stats_table(g_stats, feature->name, feature->table_bytes());
+        }
+    }
+    g_stats->peak_rss = stats_peak_rss();
+}
+
+/* Transpile a request into output_base.h and output_base.c (or its output sinks), interning names in symbols.
+ * Inputs whose key and outputs still match the request's record, or cache_dir's entry, are skipped. */
+bool transpile(const TranspileRequest_t *request, SymbolTable *symbols, const char *cache_dir) {
+    const char *input_file = request->input_file;
+    const char *output_base = request->output_base ? request->output_base : input_file;
+    bool amalgamated = request->header_output && request->source_output;
+    bool streamed = request->stream_output != NULL;
+    bool source_only = !amalgamated && request->source_output != NULL;
+    if (amalgamated || streamed || source_only) {
+        /* Members of an amalgamation and streams are neither cached nor tracked: no file is written */
+        cache_dir = NULL;
+    }
+
+    /* A previous transpile on this thread may have failed while recording */
+    g_dependencies = NULL;
+
+    /* Generate output file names */
+    size_t input_len = strlen(output_base);
+
+    /* Check for overflow: input_len + 3 should not overflow */
+    if (input_len > SIZE_MAX - 3) {
+        cz_error(NULL, NULL, 0, "Input filename too long");
+        return false;
+    }
+
+    char *header_file = malloc(input_len + 3);  /* input_file + .h + \0 */
+    char *source_file = malloc(input_len + 3);  /* input_file + .c + \0 */
+
+    if (!header_file || !source_file) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        free(header_file);
+        free(source_file);
+        return false;
+    }
+
+    snprintf(header_file, input_len + 3, "%s.h", output_base);
+    snprintf(source_file, input_len + 3, "%s.c", output_base);
+
+    /* Extract just the filename for the include directive */
+    const char *filename_only = strrchr(output_base, '/');
+    filename_only = filename_only ? filename_only + 1 : output_base;
+    size_t filename_len = strlen(filename_only);
+
+    /* Check for overflow: filename_len + 3 should not overflow */
+    if (filename_len > SIZE_MAX - 3) {
+        cz_error(NULL, NULL, 0, "Filename too long");
+        free(header_file);
+        free(source_file);
+        return false;
+    }
+
+    char *header_name = malloc(filename_len + 3);
+    if (!header_name) {
+        cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+        free(header_file);
+        free(source_file);
+        return false;
+    }
+    snprintf(header_name, filename_len + 3, "%s.h", filename_only);
+
+    /* Open input file (mapped read-only where possible), unless the request holds the source */
+    InputFile_t input;
+    InputStatus status = INPUT_OK;
+    if (request->data) {
+        input.data = NULL;
+        input.size = 0;
+        input.mapped = 0;
+    } else {
+        status = input_open(&input, input_file);
+    }
+    if (status != INPUT_OK) {
+        char error_msg[512];
+        if (status == INPUT_OPEN_FAILED) {
+            snprintf(error_msg, sizeof(error_msg), ERR_CANNOT_OPEN_INPUT_FILE, input_file);
+        } else if (status == INPUT_SIZE_FAILED) {
+            snprintf(error_msg, sizeof(error_msg), "%s", ERR_FAILED_TO_GET_INPUT_FILE_SIZE);
+        } else {
+            snprintf(error_msg, sizeof(error_msg), "%s", ERR_MEMORY_ALLOCATION_FAILED);
+        }
+        cz_error(NULL, NULL, 0, error_msg);
+        free(header_file);
+        free(source_file);
+        free(header_name);
+        return false;
+    }
+
+    const char *data = request->data ? request->data : input.data;
+    size_t size = request->data ? request->size : input.size;
+
+    /* Skip inputs whose outputs are already up to date */
+    bool caching = !amalgamated && !streamed && !source_only && (cache_dir || request->record);
+    uint64_t cache_key = caching ? cache_input_key(input_file, data, size, request->minimal_headers, request->compact, request->trace) : 0;
+    bool up_to_date = !request->dependencies || dependencies_exist(output_base);
+    if (caching && up_to_date &&
+        ((request->record && cache_record_matches(request->record, cache_key, header_file, source_file)) ||
+         (cache_dir && cache_lookup(cache_dir, input_file, cache_key, header_file, source_file)))) {
+        fprintf(worker_stdout(), "%s %s\n", header_file, source_file);
+        input_close(&input);
+        free(header_file);
+        free(source_file);
+        free(header_name);
+        return true;
+    }
+
+    /* Record every file read or included from here on (cz -MD), the input first */
+    DependencyList_t dependencies;
+    bool recording = request->dependencies && !amalgamated && !streamed && !source_only;
+    if (recording) {
+        dependency_list_init(&dependencies);
+        g_dependencies = &dependencies;
+        dependency_record(input_file, DEPENDENCY_READ);
+    }
+
+    /* Handle empty input file */
+    if (size == 0) {
+        input_close(&input);
+        /* For empty input, create empty output files (an amalgamation or a stream gets nothing from it) */
+        OutputFile_t h_out, c_out;
+        if (!amalgamated && !streamed && output_open(&h_out, header_file)) output_commit(&h_out);
+        if (!amalgamated && !streamed && !source_only && output_open(&c_out, source_file)) output_commit(&c_out);
+        if (recording) {
+            finish_dependencies(&dependencies, output_base, header_file, source_file);
+        }
+        free(header_file);
+        free(source_file);
+        free(header_name);
+        return true;
+    }
+
+    /* Lexing runs inside parsing, the parser times its lexer calls */
+    ProfileMark_t parse_mark;
+    profile_begin(&parse_mark, 0);
+
+    /* Initialize lexer with the shared symbol table */
+    Lexer lexer;
+    lexer_init(&lexer, data, size);
+    lexer.symbols = symbols;
+
+    /* Initialize parser */
+    Parser parser;
+    parser_init(&parser, &lexer);
+
+    /* Parse input into AST */
+    ASTNode_t *ast = parser_parse(&parser);
+    if (!ast) {
+        cz_error(NULL, NULL, 0, ERR_FAILED_TO_PARSE_INPUT);
+        parser_cleanup(&parser);
+        lexer_cleanup(&lexer);
+        input_close(&input);
+        free(header_file);
+        free(source_file);
+        free(header_name);
+        return false;
+    }
+
+    if (g_profile) {
+        unsigned long long parse_ns = profile_clock_ns() - parse_mark.ns;
+        size_t parse_bytes = arena_total_allocated() - parse_mark.bytes;
+        profile_record("lex", "tokens", parser.lex_ns, ast->child_count, 0, 0, lexer.pool_used);
+        profile_record("parse", "ast", parse_ns - parser.lex_ns, ast->child_count, ast->child_count, 0, parse_bytes);
+    }
+    size_t parsed_tokens = ast->child_count;
+
+    /* Initialize transpiler */
+    Transpiler_t transpiler;
+    transpiler_init(&transpiler, ast, input_file, data);
+    transpiler.symbols = symbols;
+    transpiler.amalgamated = amalgamated;
+    transpiler.header_inlined = streamed;
+    transpiler.minimal_headers = request->minimal_headers;
+    transpiler.trace = request->trace;
+
+    /* Transform AST */
+    transpiler_transform(&transpiler);
+
+    if (streamed) {
+        /* The header, then the source without its own #include: one translation unit */
+        ProfileMark_t emit_mark;
+        size_t stream_start = request->stream_output->length;
+        profile_begin(&emit_mark, ast->child_count);
+        transpiler_emit_header(&transpiler, request->stream_output);
+        profile_end(&emit_mark, "emit", "header");
+        profile_begin(&emit_mark, ast->child_count);
+        transpiler_emit_source(&transpiler, request->stream_output, header_name);
+        profile_end(&emit_mark, "emit", "source");
+        if (request->compact) {
+            compact_sink(request->stream_output, stream_start);
+        }
+    } else if (amalgamated) {
+        /* Append both outputs to the amalgamation */
+        ProfileMark_t emit_mark;
+        size_t header_start = request->header_output->length;
+        size_t source_start = request->source_output->length;
+        profile_begin(&emit_mark, ast->child_count);
+        transpiler_emit_header(&transpiler, request->header_output);
+        profile_end(&emit_mark, "emit", "header");
+        profile_begin(&emit_mark, ast->child_count);
+        transpiler_emit_source(&transpiler, request->source_output, header_name);
+        profile_end(&emit_mark, "emit", "source");
+        if (request->compact) {
+            compact_sink(request->header_output, header_start);
+            compact_sink(request->source_output, source_start);
+        }
+    } else {
+        /* Emit header file into memory, then replace it only if its bytes change */
+        OutputSink_t sink;
+        sink_init(&sink, NULL);
+        ProfileMark_t emit_mark;
+        profile_begin(&emit_mark, ast->child_count);
+        transpiler_emit_header(&transpiler, &sink);
+        if (request->compact) {
+            compact_sink(&sink, 0);
+        }
+        if (sink.failed || !output_write(header_file, sink.data, sink.length)) {
+            sink_free(&sink);
+            output_write_failed(header_file);
+        }
+        profile_end(&emit_mark, "emit", "header");
+
+        /* Emit source file the same way, reusing the buffer, or into the request's sink */
+        sink.length = 0;
+        profile_begin(&emit_mark, ast->child_count);
+        if (source_only) {
+            size_t source_start = request->source_output->length;
+            transpiler_emit_source(&transpiler, request->source_output, header_name);
+            if (request->compact) {
+                compact_sink(request->source_output, source_start);
+            }
+        } else {
+            transpiler_emit_source(&transpiler, &sink, header_name);
+            if (request->compact) {
+                compact_sink(&sink, 0);
+            }
+            if (sink.failed || !output_write(source_file, sink.data, sink.length)) {
+                sink_free(&sink);
+                output_write_failed(source_file);
+            }
+        }
+        profile_end(&emit_mark, "emit", "source");
+        sink_free(&sink);
+
+        if (recording) {
+            finish_dependencies(&dependencies, output_base, header_file, source_file);
+        }
+        if (request->record) {
+            cache_record_outputs(request->record, cache_key, header_file, source_file);
+        }
+        if (cache_dir) {
+            cache_store(cache_dir, input_file, cache_key, header_file, source_file);
+        }
+
+        if (!source_only) {
+            fprintf(worker_stdout(), "%s %s\n", header_file, source_file);
+        }
+    }
+
+    if (g_stats) {
+        record_stats(&transpiler, &parser, parsed_tokens, lexer.pool_used, symbols);
+    }
+
+    /* Clean up */
+    transpiler_cleanup(&transpiler);
+    ast_node_free(ast);
+    parser_cleanup(&parser);
+    lexer_cleanup(&lexer);
+    input_close(&input);
+    free(header_file);
+    free(source_file);
+    free(header_name);
+
+    return true;
+}
@@ -0,0 +1,36 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Transpiles one .cz input into its .cz.h and .cz.c outputs.
+ */
+
+#pragma once
+
+#include "symbols.h"
+#include "cache.h"
+#include "sink.h"
+#include <stddef.h>
+#include <stdbool.h>
+
+/* One input to transpile */
+typedef struct {
+    const char *input_file;      /* Source path (names diagnostics, resolves imports and siblings) */
+    const char *output_base;     /* Outputs are output_base.h and output_base.c (NULL for input_file) */
+    const char *data;            /* In-memory source, NUL-terminated at data[size] (NULL to read input_file) */
+    size_t size;                 /* Length of data */
+    CacheRecord_t *record;       /* Outputs of the previous transpile of this input, updated (NULL for none) */
+    bool dependencies;           /* Also write output_base.d listing every file read or included (-MD) */
+    bool minimal_headers;        /* Forward declare opaque structs, include only referenced siblings */
+    bool compact;                /* Strip comments and redundant whitespace from the outputs (--compact) */
+    bool trace;                  /* Open a libczar trace zone in every exported function (--trace) */
+    OutputSink_t *header_output; /* Append the header here instead of writing files, as one file of a */
+    OutputSink_t *source_output; /* module amalgamation (both NULL to write output_base.h and .c); with */
+                                 /* source_output alone, output_base.h is written and the source appended */
+    OutputSink_t *stream_output; /* Append the header then the source here as one translation unit (NULL for files) */
+} TranspileRequest_t;
+
+/* Transpile a request into output_base.h and output_base.c (or its output sinks), interning names in symbols.
+ * Inputs whose key and outputs still match the request's record, or cache_dir's entry, are skipped. */
+bool transpile(const TranspileRequest_t *request, SymbolTable *symbols, const char *cache_dir);
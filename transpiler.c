@@ -18,44 +18,147 @@
 #include "src/errors.h"
 #include "src/fixme.h"
 #include "src/functions.h"
+#include "src/ifexpr.h"
 #include "src/methods.h"
 #include "src/mutability.h"
 #include "src/pragma.h"
+#include "src/scopes.h"
 #include "src/structs.h"
 #include "src/todo.h"
 #include "src/types.h"
 #include "src/unreachable.h"
+#include "src/hints.h"
 #include "src/unused.h"
 #include "src/validation.h"
 #include "src/warnings.h"
 #include "features.h"
+#include "profile.h"
+#include "depfile.h"
+#include "dirlist.h"
+#include "siblings.h"
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
 #include <ctype.h>
-#include <dirent.h>
 #include <sys/stat.h>
 #include <libgen.h>
 
 /* Global context for error/warning reporting */
-const char *g_filename = NULL;
-const char *g_source = NULL;
+CZ_THREAD_LOCAL const char *g_filename = NULL;
+CZ_THREAD_LOCAL const char *g_source = NULL;
+
+/* Shared interner, falls back to a private table when none was attached */
+static CZ_THREAD_LOCAL SymbolTable fallback_symbols;
+CZ_THREAD_LOCAL SymbolTable *g_symbols = NULL;
+
+/* Get the shared interner */
+static SymbolTable *shared_symbols(void) {
+    return g_symbols ? g_symbols : &fallback_symbols;
+}
+
+/* Intern length bytes of text in the shared table, returns its symbol ID */
+int cz_intern_length(const char *text, size_t length) {
+    return symbols_intern(shared_symbols(), text, length);
+}
+
+/* Intern a NUL-terminated name in the shared table, returns its symbol ID */
+int cz_intern(const char *name) {
+    return name ? cz_intern_length(name, strlen(name)) : SYM_NONE;
+}
+
+/* Get the interned copy of a name (equal names share one pointer), or NULL */
+const char *cz_intern_name(const char *name) {
+    return cz_symbol_name(cz_intern(name));
+}
+
+/* Get the symbol ID of a token's text (IDs assigned by the lexer are reused) */
+int cz_token_symbol(const Token *token) {
+    if (!token || !token->text) {
+        return SYM_NONE;
+    }
+    /* Rewritten text only keeps keyword IDs, so any other ID came from lexing with g_symbols */
+    if (token->symbol != SYM_NONE && g_symbols) {
+        return token->symbol;
+    }
+    return cz_intern_length(token->text, token->length);
+}
+
+/* Get the interned text of a symbol ID (stable until the table is freed), or NULL */
+const char *cz_symbol_name(int id) {
+    return symbols_name(shared_symbols(), id);
+}
+
+/* Skip the features listed as #pragma czar feature(-name, ...) in this translation unit only */
+static void disable_pragma_features(Transpiler_t *transpiler) {
+    ASTNode_t *ast = transpiler->ast;
+    if (!ast || ast->type != AST_TRANSLATION_UNIT) {
+        return;
+    }
+
+    for (size_t i = 0; i < ast->child_count; i++) {
+        const Token *token = &ast->children[i]->token;
+        if (ast->children[i]->type != AST_TOKEN || !pragma_czar_is(token, "feature")) {
+            continue;
+        }
+        const char *list = strchr(token->text, '(');
+        const char *end = list ? strchr(list, ')') : NULL;
+        if (!end) {
+            continue;
+        }
+
+        for (const char *name = list + 1; name < end; ) {
+            name += strspn(name, " \t,");
+            size_t length = strcspn(name, " \t,)");
+            if (length == 0) {
+                break;
+            }
+            if (name[0] != '-' || !feature_registry_disable(&transpiler->registry, name + 1, length - 1)) {
+                char warning_msg[256];
+                snprintf(warning_msg, sizeof(warning_msg), WARN_UNKNOWN_FEATURE, (int)length, name);
+                cz_warning_at(transpiler->filename, transpiler->source, token->line, token->column, warning_msg);
+            }
+            name += length;
+        }
+    }
+}
 
 /* Initialize transpiler with AST */
 void transpiler_init(Transpiler_t *transpiler, ASTNode_t *ast, const char *filename, const char *source) {
     transpiler->ast = ast;
     transpiler->filename = filename;
     transpiler->source = source;
+    transpiler->symbols = NULL;
+    /* Index line starts once so diagnostics don't rescan the source */
+    line_table_build(&transpiler->lines, source);
+    g_lines = &transpiler->lines;
     /* Initialize pragma context with defaults */
     pragma_context_init(&transpiler->pragma_ctx);
     /* Parse pragmas from AST to update context */
     transpiler_parse_pragmas(ast, &transpiler->pragma_ctx);
+    g_pragmas = &transpiler->pragma_ctx;
     /* Reset unused counter for each translation unit */
     transpiler_reset_unused_counter();
     /* Initialize feature registry and register all features */
     feature_registry_init(&transpiler->registry);
     register_all_features(&transpiler->registry);
+    transpiler->amalgamated = false;
+    transpiler->header_inlined = false;
+    transpiler->minimal_headers = false;
+    transpiler->trace = false;
+    hash_table_init(&transpiler->identifiers);
+    transpiler->declarations.entries = NULL;
+    transpiler->declarations.count = 0;
+    transpiler->declarations.capacity = 0;
+    /* Fix the execution order once so phases don't re-check dependencies */
+    const char *failed = NULL;
+    if (!feature_registry_resolve(&transpiler->registry, &failed)) {
+        char error_msg[256];
+        snprintf(error_msg, sizeof(error_msg), ERR_FEATURE_DEPENDENCY_UNRESOLVED, failed ? failed : "<unknown>");
+        cz_error(filename, NULL, 0, error_msg);
+    }
+    /* Then drop what this file turned off */
+    disable_pragma_features(transpiler);
 }
 
 /* Clean up transpiler resources */
@@ -64,72 +167,44 @@ void transpiler_cleanup(Transpiler_t *transpiler) {
         return;
     }
     feature_registry_free(&transpiler->registry);
+    line_table_free(&transpiler->lines);
+    hash_table_free(&transpiler->identifiers);
+    free(transpiler->declarations.entries);
+    transpiler->declarations.entries = NULL;
+    transpiler->declarations.count = 0;
+    transpiler->declarations.capacity = 0;
+
+    /* Release the feature tables of this translation unit */
+    transpiler_free_enum_tables();
+    transpiler_free_method_tables();
+    transpiler_free_function_tables();
+    transpiler_free_struct_tables();
+    transpiler_free_autodereference_tables();
+    scope_map_free();
+    transpiler_free_defer_tables();
+    transpiler_free_cast_tables();
+    transpiler_free_ifexpr_tables();
+    transpiler_free_unreachable_tables();
+    transpiler_free_hint_tables();
+    if (g_pragmas == &transpiler->pragma_ctx) {
+        g_pragmas = NULL;
+    }
 }
 
-/* Transform AST node recursively */
-static void transform_node(ASTNode_t *node) {
-    if (!node) {
+/* Remember every identifier of the source, so only the siblings it references are included */
+static void collect_identifiers(Transpiler_t *transpiler) {
+    hash_table_clear(&transpiler->identifiers);
+    if (transpiler->ast->type != AST_TRANSLATION_UNIT) {
         return;
     }
-
-    /* Transform token nodes */
-    if (node->type == AST_TOKEN && node->token.type == TOKEN_IDENTIFIER) {
-        /* Check if this is the special _ identifier */
-        if (strcmp(node->token.text, "_") == 0) {
-            /* Replace _ with unique unused variable name */
-            char *new_text = transpiler_transform_unused_identifier();
-            if (new_text) {
-                free(node->token.text);
-                node->token.text = new_text;
-                node->token.length = strlen(new_text);
-            } else {
-                /* If transformation fails, create a fallback name to avoid duplicate _ */
-                static int fallback_counter = 0;
-                char fallback[32];
-                snprintf(fallback, sizeof(fallback), "_unused_fallback_%d", fallback_counter++);
-                char *fallback_text = strdup(fallback);
-                if (fallback_text) {
-                    free(node->token.text);
-                    node->token.text = fallback_text;
-                    node->token.length = strlen(fallback_text);
-                }
-                /* If even fallback fails, keep original _ (may cause C compilation error) */
-            }
-        } else {
-            /* Check if this identifier is a CZar type */
-            const char *c_type = transpiler_get_c_type(node->token.text);
-            if (c_type) {
-                /* Replace CZar type with C type */
-                char *new_text = strdup(c_type);
-                if (new_text) {
-                    free(node->token.text);
-                    node->token.text = new_text;
-                    node->token.length = strlen(c_type);
-                }
-                /* If strdup fails, keep the original text */
-            } else {
-                /* Check if this identifier is a CZar constant */
-                const char *c_constant = transpiler_get_c_constant(node->token.text);
-                if (c_constant) {
-                    /* Replace CZar constant with C constant */
-                    char *new_text = strdup(c_constant);
-                    if (new_text) {
-                        free(node->token.text);
-                        node->token.text = new_text;
-                        node->token.length = strlen(c_constant);
-                    }
-                    /* If strdup fails, keep the original text */
-                } else {
-                    /* Check if this identifier is a CZar function */
-                }
-            }
+    for (size_t i = 0; i < transpiler->ast->child_count; i++) {
+        ASTNode_t *node = transpiler->ast->children[i];
+        if (node->type == AST_TOKEN && node->token.type == TOKEN_IDENTIFIER && node->token.text &&
+            !hash_table_put(&transpiler->identifiers, hash_key_string(node->token.text), i)) {
+            cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+            return;
         }
     }
-
-    /* Recursively transform children */
-    for (size_t i = 0; i < node->child_count; i++) {
-        transform_node(node->children[i]);
-    }
 }
 
 /* Transform AST (apply CZar-specific transformations) */
@@ -138,17 +213,37 @@ void transpiler_transform(Transpiler_t *transpiler) {
         return;
     }
 
+    /* Features intern names in the same table as the lexer */
+    g_symbols = transpiler->symbols;
+
+    /* Siblings are matched against the names the source wrote, before features rename them */
+    if (transpiler->minimal_headers) {
+        collect_identifiers(transpiler);
+    }
+
+    /* Skip the features whose trigger words the source never mentions */
+    ProfileMark_t mark;
+    profile_begin(&mark, transpiler->ast->child_count);
+    feature_registry_prescan(&transpiler->registry, transpiler->source);
+    profile_end(&mark, "transform", "prescan");
+
     /* Execute validation phase for all enabled features */
     feature_registry_validate(&transpiler->registry, transpiler->ast, transpiler->filename, transpiler->source);
 
-    /* Execute transformation phase for all enabled features */
+    /* Execute transformation phase for all enabled features (types and constants run last) */
     feature_registry_transform(&transpiler->registry, transpiler->ast, transpiler->filename, transpiler->source);
 
-    /* Apply identifier transformations (types, constants, unused) */
-    transform_node(transpiler->ast);
-
     /* Transform cast expressions (must be after types are transformed) */
-    transpiler_transform_casts(transpiler->ast);
+    if (feature_registry_runs(&transpiler->registry, "casts")) {
+        profile_begin(&mark, transpiler->ast->child_count);
+        transpiler_transform_casts(transpiler->ast);
+        profile_end(&mark, "transform", "casts");
+    }
+
+    /* Classify top-level declarations once for the header and source emitters */
+    profile_begin(&mark, transpiler->ast->child_count);
+    transpiler_index_declarations(transpiler);
+    profile_end(&mark, "transform", "declarations");
 }
 
 /* Helper function to check if a path is a directory */
@@ -205,61 +300,75 @@ static char* resolve_module_path(const char *source_filename, const char *module
     return full_path;
 }
 
+/* Record the generated header of directory/cz_name, or of module path directory.cz when cz_name is NULL, as included (cz -MD) */
+static void record_header_dependency(const char *directory, const char *cz_name) {
+    if (!g_dependencies) {
+        return;
+    }
+    size_t len = strlen(cz_name ? cz_name : directory) + sizeof(".cz.h");
+    char *name = malloc(len);
+    if (!name) {
+        return;
+    }
+    if (cz_name) {
+        snprintf(name, len, "%s.h", cz_name);
+        dependency_record_in(directory, name, DEPENDENCY_INCLUDED);
+    } else {
+        snprintf(name, len, "%s.cz.h", directory);
+        dependency_record(name, DEPENDENCY_INCLUDED);
+    }
+    free(name);
+}
+
 /* Helper function to emit includes for all .cz files in a module directory */
-static void emit_module_includes(const char *source_filename, const char *module_path, FILE *output) {
+static void emit_module_includes(const char *source_filename, const char *module_path, OutputSink_t *output) {
     /* Resolve full path to module directory */
     char *full_module_path = resolve_module_path(source_filename, module_path);
     if (!full_module_path) {
         /* If path resolution fails, emit a comment */
-        fprintf(output, "/* Warning: could not resolve module path: %s */\n", module_path);
+        sink_printf(output, "/* Warning: could not resolve module path: %s */\n", module_path);
         return;
     }
 
     /* Check if it's a directory */
     if (!is_directory(full_module_path)) {
         /* Not a directory - treat as single file import (old behavior) */
-        fprintf(output, "#include \"%s.cz.h\"", module_path);
+        sink_printf(output, "#include \"%s.cz.h\"", module_path);
+        record_header_dependency(full_module_path, NULL);
         free(full_module_path);
         return;
     }
 
-    /* Open directory and scan for .cz files */
-    DIR *dir = opendir(full_module_path);
-    if (!dir) {
+    /* List the module's .cz files (sorted, read once per run) */
+    const DirListing_t *listing = dir_listing_cz(full_module_path);
+    if (!listing) {
         /* Directory doesn't exist or can't be opened */
-        fprintf(output, "/* Warning: could not open module directory: %s */\n", module_path);
+        sink_printf(output, "/* Warning: could not open module directory: %s */\n", module_path);
         free(full_module_path);
         return;
     }
 
-    struct dirent *entry;
     int found_files = 0;
-
-    while ((entry = readdir(dir)) != NULL) {
-        /* Check if file ends with .cz */
-        size_t name_len = strlen(entry->d_name);
-        const size_t cz_ext_len = 3; /* length of ".cz" */
-        if (name_len > cz_ext_len && strcmp(entry->d_name + name_len - cz_ext_len, ".cz") == 0) {
-            /* Emit #include for this .cz file's header */
-            if (found_files > 0) {
-                fprintf(output, "\n");
-            }
-            fprintf(output, "#include \"%s/%s.h\"", module_path, entry->d_name);
-            found_files++;
+    for (size_t i = 0; i < listing->count; i++) {
+        /* Emit #include for this .cz file's header */
+        if (found_files > 0) {
+            sink_putc(output, '\n');
         }
+        sink_printf(output, "#include \"%s/%s.h\"", module_path, listing->names[i]);
+        record_header_dependency(full_module_path, listing->names[i]);
+        found_files++;
     }
 
-    closedir(dir);
     free(full_module_path);
 
     if (found_files == 0) {
         /* No .cz files found in directory */
-        fprintf(output, "/* Warning: no .cz files found in module: %s */", module_path);
+        sink_printf(output, "/* Warning: no .cz files found in module: %s */", module_path);
     }
 }
 
 /* Emit AST node recursively */
-static void emit_node(ASTNode_t *node, FILE *output, const char *source_filename) {
+static void emit_node(ASTNode_t *node, OutputSink_t *output, const char *source_filename) {
     if (!node) {
         return;
     }
@@ -294,19 +403,19 @@ static void emit_node(ASTNode_t *node, FILE *output, const char *source_filename
                             const char *rest = quote_end + 1;
                             size_t rest_len = (import_start + node->token.length) - rest;
                             if (rest_len > 0) {
-                                fwrite(rest, 1, rest_len, output);
+                                sink_write(output, rest, rest_len);
                             }
                             return;
                         } else {
                             /* Memory allocation failed - emit warning and continue with default */
-                            fprintf(output, "/* Warning: memory allocation failed for import directive */\n");
+                            sink_puts(output, "/* Warning: memory allocation failed for import directive */\n");
                         }
                     }
                 }
             }
 
             /* Regular token emission */
-            fwrite(node->token.text, 1, node->token.length, output);
+            sink_write(output, node->token.text, node->token.length);
         }
     }
 
@@ -317,20 +426,20 @@ static void emit_node(ASTNode_t *node, FILE *output, const char *source_filename
 }
 
 /* Emit transformed AST as C code to output file */
-void transpiler_emit(Transpiler_t *transpiler, FILE *output) {
+void transpiler_emit(Transpiler_t *transpiler, OutputSink_t *output) {
     if (!transpiler || !transpiler->ast || !output) {
         return;
     }
 
     /* Emit standard C includes */
-    fprintf(output, "#include <stdlib.h>\n");
-    fprintf(output, "#include <stdio.h>\n");
-    fprintf(output, "#include <stdint.h>\n");
-    fprintf(output, "#include <stdbool.h>\n");
-    fprintf(output, "#include <assert.h>\n");
-    fprintf(output, "#include <stdarg.h>\n");
-    fprintf(output, "#include <string.h>\n");
-    fprintf(output, "\n");
+    sink_puts(output, "#include <stdlib.h>\n");
+    sink_puts(output, "#include <stdio.h>\n");
+    sink_puts(output, "#include <stdint.h>\n");
+    sink_puts(output, "#include <stdbool.h>\n");
+    sink_puts(output, "#include <assert.h>\n");
+    sink_puts(output, "#include <stdarg.h>\n");
+    sink_puts(output, "#include <string.h>\n");
+    sink_putc(output, '\n');
 
     emit_node(transpiler->ast, output, transpiler->filename);
 }
@@ -390,6 +499,11 @@ static int has_export_keyword(ASTNode_t **children, size_t start_pos, size_t cou
     return 0;
 }
 
+/* Helper to check if a token is a semicolon, possibly followed by generated definitions (enum name tables) */
+static int is_semicolon(ASTNode_t *node) {
+    return node->type == AST_TOKEN && node->token.type == TOKEN_PUNCTUATION && node->token.text[0] == ';';
+}
+
 /* Helper to check if position i is at the START of a function definition */
 static int is_function_start(ASTNode_t **children, size_t i, size_t count) {
     /* Position i should be at or near the return type of the function
@@ -452,6 +566,9 @@ static int is_function_start(ASTNode_t **children, size_t i, size_t count) {
         if (children[j]->type != AST_TOKEN) continue;
 
         Token *t = &children[j]->token;
+        if (is_semicolon(children[j])) {
+            return 0;  /* Semicolon before brace - not a definition */
+        }
         if (t->type == TOKEN_PUNCTUATION && t->length == 1) {
             if (t->text[0] == '(') {
                 found_open_paren = 1;
@@ -463,8 +580,6 @@ static int is_function_start(ASTNode_t **children, size_t i, size_t count) {
                 } else {
                     return 0;  /* Brace without proper function signature */
                 }
-            } else if (t->text[0] == ';') {
-                return 0;  /* Semicolon before brace - not a definition */
             }
         }
     }
@@ -477,7 +592,15 @@ static int is_preprocessor(ASTNode_t *node) {
 }
 
 /* Forward declaration */
-static size_t find_brace_block_end(ASTNode_t **children, size_t start, size_t count);
+static size_t find_brace_block_end(ASTNode_t *parent, size_t start);
+
+/* Helper to check if a token is the identifier or keyword text */
+static int is_word(ASTNode_t *node, const char *text) {
+    size_t length = strlen(text);
+    return node && node->type == AST_TOKEN &&
+           (node->token.type == TOKEN_IDENTIFIER || node->token.type == TOKEN_KEYWORD) &&
+           node->token.length == length && strncmp(node->token.text, text, length) == 0;
+}
 
 /* Helper to check if position i is EXACTLY at a struct/enum/union/typedef keyword */
 static int is_at_struct_or_typedef_keyword(ASTNode_t **children, size_t i, size_t count) {
@@ -514,32 +637,21 @@ static size_t find_preprocessor_end(ASTNode_t **children, size_t start, size_t c
     return start;
 }
 
-/* Helper to find the end of a function body */
-static size_t find_function_end(ASTNode_t **children, size_t start, size_t count) {
-    int brace_depth = 0;
-    int started = 0;
+/* Helper to find the end of a function body (closer of the first brace from start) */
+static size_t find_function_end(ASTNode_t *parent, size_t start) {
+    for (size_t i = start; i < parent->child_count; i++) {
+        if (parent->children[i]->type != AST_TOKEN) continue;
 
-    for (size_t i = start; i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
-
-        Token *t = &children[i]->token;
-        if (t->type == TOKEN_PUNCTUATION && t->length == 1) {
-            if (t->text[0] == '{') {
-                brace_depth++;
-                started = 1;
-            } else if (t->text[0] == '}') {
-                brace_depth--;
-                if (started && brace_depth == 0) {
-                    return i;
-                }
-            }
+        Token *t = &parent->children[i]->token;
+        if (t->type == TOKEN_PUNCTUATION && t->length == 1 && t->text[0] == '{') {
+            return find_brace_block_end(parent, i);
         }
     }
-    return count;
+    return parent->child_count;
 }
 
 /* Helper to emit nodes in a range, skipping the export keyword */
-static void emit_node_range_skip_export(ASTNode_t **children, size_t start, size_t end, FILE *output, const char *source_filename) {
+static void emit_node_range_skip_export(ASTNode_t **children, size_t start, size_t end, OutputSink_t *output, const char *source_filename) {
     for (size_t j = start; j < end; j++) {
         /* Skip the export keyword itself */
         if (is_export_keyword(children[j])) {
@@ -549,136 +661,379 @@ static void emit_node_range_skip_export(ASTNode_t **children, size_t start, size
     }
 }
 
+/* Helper to find the first token of the type declaration whose keyword is at i, and whether it is exported */
+static size_t find_declaration_start(ASTNode_t **children, size_t i, bool *exported) {
+    size_t decl_start = i;
+    *exported = false;
+
+    /* Look backward for export keyword (within last few tokens) */
+    for (size_t j = (i > 10 ? i - 10 : 0); j < i; j++) {
+        if (is_export_keyword(children[j])) {
+            *exported = true;
+            decl_start = j;  /* Start from export keyword */
+            break;
+        }
+        /* Stop if we hit a semicolon or brace */
+        if (children[j]->type == AST_TOKEN && children[j]->token.type == TOKEN_PUNCTUATION &&
+            children[j]->token.length == 1 && (children[j]->token.text[0] == ';' || children[j]->token.text[0] == '}')) {
+            decl_start = j + 1;
+        }
+    }
+    return decl_start;
+}
+
+/* Helper to find the last token of the type declaration whose keyword is at i (semicolon or brace block) */
+static size_t find_declaration_end(ASTNode_t *parent, size_t i) {
+    ASTNode_t **children = parent->children;
+    size_t count = parent->child_count;
+    size_t decl_end = i;
+
+    for (size_t j = i; j < count; j++) {
+        if (is_semicolon(children[j])) {
+            decl_end = j;
+            break;
+        }
+        if (children[j]->type == AST_TOKEN && children[j]->token.type == TOKEN_PUNCTUATION && children[j]->token.length == 1) {
+            if (children[j]->token.text[0] == '{') {
+                decl_end = find_brace_block_end(parent, j);
+                /* Look for semicolon after closing brace (for typedef) */
+                for (size_t k = decl_end + 1; k < count && k < decl_end + 20; k++) {
+                    if (is_semicolon(children[k])) {
+                        decl_end = k;
+                        break;
+                    }
+                    /* Skip whitespace, comments, and identifiers (type name) */
+                    if (children[k]->type == AST_TOKEN &&
+                        children[k]->token.type != TOKEN_WHITESPACE &&
+                        children[k]->token.type != TOKEN_COMMENT &&
+                        children[k]->token.type != TOKEN_IDENTIFIER) {
+                        break;  /* Stop at other tokens */
+                    }
+                }
+                break;
+            }
+        }
+    }
+    return decl_end;
+}
+
+/* Append a declaration to the index (dropped on allocation failure) */
+static void add_declaration(DeclarationIndex_t *index, DeclarationKind kind, size_t start, size_t body,
+                            size_t end, bool exported) {
+    if (index->count >= index->capacity) {
+        size_t new_capacity = index->capacity == 0 ? 16 : index->capacity * 2;
+        Declaration_t *new_entries = realloc(index->entries, new_capacity * sizeof(Declaration_t));
+        if (!new_entries) {
+            cz_error(NULL, NULL, 0, ERR_MEMORY_ALLOCATION_FAILED);
+            return;
+        }
+        index->entries = new_entries;
+        index->capacity = new_capacity;
+    }
+    Declaration_t *decl = &index->entries[index->count++];
+    decl->kind = kind;
+    decl->start = start;
+    decl->body = body;
+    decl->end = end;
+    decl->exported = exported;
+    decl->opaque = false;
+    decl->tag = start;
+    decl->open = start;
+    decl->close = end;
+}
+
+/* Helper to skip whitespace and comments from i, returns the next significant token (or limit) */
+static size_t skip_blank(ASTNode_t **children, size_t i, size_t limit) {
+    while (i < limit && children[i]->type == AST_TOKEN &&
+           (children[i]->token.type == TOKEN_WHITESPACE || children[i]->token.type == TOKEN_COMMENT)) {
+        i++;
+    }
+    return i;
+}
+
+/* Helper to check if a token is the single character c */
+static int is_char(ASTNode_t *node, char c) {
+    return node->type == AST_TOKEN && node->token.length == 1 && node->token.text[0] == c;
+}
+
+/* Match a private "typedef struct Tag { ... } Name;" whose typedef is at i and whose semicolon is
+ * at most at limit, filling candidate with its tokens; returns false for anything else */
+static bool match_private_struct(ASTNode_t *parent, size_t i, size_t limit, Declaration_t *candidate) {
+    ASTNode_t **children = parent->children;
+    size_t j;
+    if (is_word(children[i], "typedef struct")) {
+        j = i + 1;
+    } else if (is_word(children[i], "typedef")) {
+        j = skip_blank(children, i + 1, limit);
+        if (j > limit || !is_word(children[j], "struct")) {
+            return false;
+        }
+        j++;
+    } else {
+        return false;
+    }
+
+    /* Exported structs keep their body in the header */
+    size_t before = i;
+    while (before > 0 && children[before - 1]->type == AST_TOKEN &&
+           (children[before - 1]->token.type == TOKEN_WHITESPACE || children[before - 1]->token.type == TOKEN_COMMENT)) {
+        before--;
+    }
+    if (before > 0 && is_export_keyword(children[before - 1])) {
+        return false;
+    }
+
+    size_t tag = skip_blank(children, j, limit);
+    if (tag > limit || children[tag]->token.type != TOKEN_IDENTIFIER) {
+        return false;
+    }
+    size_t open = skip_blank(children, tag + 1, limit);
+    if (open > limit || !is_char(children[open], '{')) {
+        return false;
+    }
+    size_t close = find_brace_block_end(parent, open);
+    size_t name = skip_blank(children, close + 1, limit);
+    if (close > limit || name > limit || children[name]->token.type != TOKEN_IDENTIFIER) {
+        return false;
+    }
+    size_t end = skip_blank(children, name + 1, limit);
+    if (end > limit || !is_char(children[end], ';')) {
+        return false;
+    }
+
+    candidate->kind = DECLARATION_TYPE;
+    candidate->start = i;
+    candidate->body = i;
+    candidate->end = end;
+    candidate->exported = false;
+    candidate->opaque = true;
+    candidate->tag = tag;
+    candidate->open = open;
+    candidate->close = close;
+    return true;
+}
+
+/* Check whether the header only uses the candidate struct through pointers, at least once */
+static bool used_by_pointer_only(const Transpiler_t *transpiler, const Declaration_t *candidate) {
+    ASTNode_t **children = transpiler->ast->children;
+    size_t count = transpiler->ast->child_count;
+    const char *tag = children[candidate->tag]->token.text;
+    const char *name = children[skip_blank(children, candidate->close + 1, count)]->token.text;
+    const DeclarationIndex_t *index = &transpiler->declarations;
+    size_t pointer_uses = 0;
+
+    for (size_t d = 0; d < index->count; d++) {
+        const Declaration_t *decl = &index->entries[d];
+        size_t first = decl->start;
+        size_t last = decl->end + 1;
+        if (decl->kind == DECLARATION_PREPROCESSOR) {
+            /* Macros may use the struct any way */
+            const char *text = children[decl->start]->token.text;
+            if (text && (strstr(text, tag) || strstr(text, name))) {
+                return false;
+            }
+            continue;
+        } else if (decl->kind == DECLARATION_FUNCTION) {
+            /* Only exported signatures reach the header */
+            if (!decl->exported) continue;
+            last = decl->body;
+        } else if (decl->kind == DECLARATION_INCLUDE || (decl->kind == DECLARATION_TYPE && !decl->exported)) {
+            continue;
+        }
+
+        for (size_t j = first; j < last; j++) {
+            if (j >= candidate->start && j <= candidate->end) {
+                continue;
+            }
+            ASTNode_t *node = children[j];
+            if (node->type != AST_TOKEN || node->token.type != TOKEN_IDENTIFIER || !node->token.text ||
+                (strcmp(node->token.text, name) != 0 && strcmp(node->token.text, tag) != 0)) {
+                continue;
+            }
+            size_t next = skip_blank(children, j + 1, count);
+            if (next >= count || children[next]->type != AST_TOKEN || !children[next]->token.text ||
+                children[next]->token.text[0] != '*') {
+                return false;
+            }
+            pointer_uses++;
+        }
+    }
+    return pointer_uses > 0;
+}
+
+/* Split the private structs the header only uses by pointer out of the token runs (minimal headers) */
+static void index_opaque_structs(Transpiler_t *transpiler) {
+    const DeclarationIndex_t *index = &transpiler->declarations;
+    DeclarationIndex_t split = { NULL, 0, 0 };
+
+    for (size_t d = 0; d < index->count; d++) {
+        const Declaration_t *decl = &index->entries[d];
+        if (decl->kind != DECLARATION_TOKENS) {
+            add_declaration(&split, decl->kind, decl->start, decl->body, decl->end, decl->exported);
+            continue;
+        }
+        size_t run_start = decl->start;
+        for (size_t j = decl->start; j <= decl->end; j++) {
+            Declaration_t candidate;
+            if (!match_private_struct(transpiler->ast, j, decl->end, &candidate) ||
+                !used_by_pointer_only(transpiler, &candidate)) {
+                continue;
+            }
+            if (j > run_start) {
+                add_declaration(&split, DECLARATION_TOKENS, run_start, run_start, j - 1, false);
+            }
+            add_declaration(&split, DECLARATION_TYPE, candidate.start, candidate.body, candidate.end, false);
+            split.entries[split.count - 1] = candidate;
+            j = candidate.end;
+            run_start = j + 1;
+        }
+        if (run_start <= decl->end) {
+            add_declaration(&split, DECLARATION_TOKENS, run_start, run_start, decl->end, false);
+        }
+    }
+
+    free(transpiler->declarations.entries);
+    transpiler->declarations = split;
+}
+
+/* Classify the top-level declarations of the transformed AST (functions, types, directives, other tokens) */
+void transpiler_index_declarations(Transpiler_t *transpiler) {
+    DeclarationIndex_t *index = &transpiler->declarations;
+    index->count = 0;
+    if (!transpiler->ast || transpiler->ast->type != AST_TRANSLATION_UNIT) {
+        return;
+    }
+
+    ASTNode_t **children = transpiler->ast->children;
+    size_t count = transpiler->ast->child_count;
+    for (size_t i = 0; i < count; i++) {
+        if (is_preprocessor(children[i])) {
+            /* User #include directives are indexed apart: the header only keeps the quoted ones */
+            if (children[i]->token.length >= 8 && strncmp(children[i]->token.text, "#include", 8) == 0) {
+                size_t end = find_preprocessor_end(children, i, count);
+                add_declaration(index, DECLARATION_INCLUDE, i, i, end, false);
+                i = end;
+                continue;
+            }
+            /* Keep other preprocessor directives like #pragma */
+            add_declaration(index, DECLARATION_PREPROCESSOR, i, i, i, false);
+            continue;
+        }
+
+        if (is_function_start(children, i, count)) {
+            bool exported = has_export_keyword(children, i, count);
+
+            /* Find where the opening brace is */
+            size_t brace_pos = i;
+            while (brace_pos < count) {
+                if (children[brace_pos]->type == AST_TOKEN &&
+                    children[brace_pos]->token.type == TOKEN_PUNCTUATION &&
+                    children[brace_pos]->token.length == 1 &&
+                    children[brace_pos]->token.text[0] == '{') {
+                    break;
+                }
+                brace_pos++;
+            }
+            size_t end = find_function_end(transpiler->ast, brace_pos);
+            if (end >= count) end = count - 1;
+            add_declaration(index, DECLARATION_FUNCTION, i, brace_pos, end, exported);
+            i = end;
+        } else if (is_at_struct_or_typedef_keyword(children, i, count)) {
+            bool exported = false;
+            size_t start = find_declaration_start(children, i, &exported);
+            size_t end = find_declaration_end(transpiler->ast, i);
+            if (end >= count) end = count - 1;
+            add_declaration(index, DECLARATION_TYPE, start, i, end, exported);
+            i = end;
+        } else if (index->count > 0 && index->entries[index->count - 1].kind == DECLARATION_TOKENS &&
+                   index->entries[index->count - 1].end + 1 == i) {
+            /* Extend the current run of other tokens */
+            index->entries[index->count - 1].end = i;
+        } else {
+            add_declaration(index, DECLARATION_TOKENS, i, i, i, false);
+        }
+    }
+
+    if (transpiler->minimal_headers) {
+        index_opaque_structs(transpiler);
+    }
+}
+
+/* Emit the standard includes every generated header has */
+static void emit_standard_includes(OutputSink_t *output) {
+    sink_puts(output, "#include <stdlib.h>\n");
+    sink_puts(output, "#include <stdio.h>\n");
+    sink_puts(output, "#include <stdint.h>\n");
+    sink_puts(output, "#include <stddef.h>\n");
+    sink_puts(output, "#include <stdbool.h>\n");
+    sink_puts(output, "#include <assert.h>\n");
+    sink_puts(output, "#include <stdarg.h>\n");
+    sink_puts(output, "#include <string.h>\n");
+    sink_putc(output, '\n');
+}
+
+/* Emit the #pragma once and standard includes every generated header starts with */
+void transpiler_emit_header_prelude(OutputSink_t *output) {
+    sink_puts(output, "#pragma once\n\n");
+    emit_standard_includes(output);
+}
+
 /* Emit transformed AST as C header file (declarations only) */
-void transpiler_emit_header(Transpiler_t *transpiler, FILE *output) {
+void transpiler_emit_header(Transpiler_t *transpiler, OutputSink_t *output) {
     if (!transpiler || !transpiler->ast || !output) {
         return;
     }
 
-    /* Emit pragma once */
-    fprintf(output, "#pragma once\n\n");
+    /* An amalgamated header has one prelude for the whole module, an inlined one is the main file */
+    if (transpiler->header_inlined) {
+        emit_standard_includes(output);
+    } else if (!transpiler->amalgamated) {
+        transpiler_emit_header_prelude(output);
+    }
 
-    /* Emit standard C includes */
-    fprintf(output, "#include <stdlib.h>\n");
-    fprintf(output, "#include <stdio.h>\n");
-    fprintf(output, "#include <stdint.h>\n");
-    fprintf(output, "#include <stddef.h>\n");
-    fprintf(output, "#include <stdbool.h>\n");
-    fprintf(output, "#include <assert.h>\n");
-    fprintf(output, "#include <stdarg.h>\n");
-    fprintf(output, "#include <string.h>\n");
-    fprintf(output, "\n");
+    /* Prototypes of hot/cold functions need the hint macros */
+    transpiler_emit_hint_helpers(output, true);
 
     /* Emit everything except function bodies, and only exported items */
     if (transpiler->ast->type == AST_TRANSLATION_UNIT) {
         ASTNode_t **children = transpiler->ast->children;
-        size_t count = transpiler->ast->child_count;
-
-        for (size_t i = 0; i < count; i++) {
-            /* Skip user #include directives (already in standard includes) */
-            if (is_preprocessor(children[i])) {
-                if (children[i]->type == AST_TOKEN &&
-                    children[i]->token.type == TOKEN_PREPROCESSOR &&
-                    children[i]->token.length >= 8 &&
-                    strncmp(children[i]->token.text, "#include", 8) == 0) {
-                    size_t end = find_preprocessor_end(children, i, count);
-                    i = end;
-                    continue;
-                }
-                /* Keep other preprocessor directives like #pragma */
-                emit_node(children[i], output, transpiler->filename);
-                continue;
-            }
-
-            /* Check if this is a function definition (has body) */
-            if (is_function_start(children, i, count)) {
-                /* Check if this function has export keyword */
-                int is_exported = has_export_keyword(children, i, count);
-
-                /* Find where the opening brace is */
-                size_t brace_pos = i;
-                while (brace_pos < count) {
-                    if (children[brace_pos]->type == AST_TOKEN &&
-                        children[brace_pos]->token.type == TOKEN_PUNCTUATION &&
-                        children[brace_pos]->token.length == 1 &&
-                        children[brace_pos]->token.text[0] == '{') {
-                        break;
-                    }
-                    brace_pos++;
+        const DeclarationIndex_t *index = &transpiler->declarations;
+
+        for (size_t d = 0; d < index->count; d++) {
+            const Declaration_t *decl = &index->entries[d];
+            switch (decl->kind) {
+            case DECLARATION_TOKENS:
+                /* Whitespace, comments, etc. as-is, but skip standalone export keywords */
+                emit_node_range_skip_export(children, decl->start, decl->end + 1, output, transpiler->filename);
+                break;
+            case DECLARATION_PREPROCESSOR:
+                emit_node(children[decl->start], output, transpiler->filename);
+                break;
+            case DECLARATION_INCLUDE:
+                /* <system> headers are already in the standard includes, "project" headers declare what the code uses */
+                if (strchr(children[decl->start]->token.text, '"')) {
+                    emit_node_range_skip_export(children, decl->start, decl->end + 1, output, transpiler->filename);
                 }
-
-                if (is_exported) {
+                break;
+            case DECLARATION_FUNCTION:
+                if (decl->exported) {
                     /* Emit function signature (up to but not including the opening brace), skip export keyword */
-                    emit_node_range_skip_export(children, i, brace_pos, output, transpiler->filename);
+                    emit_node_range_skip_export(children, decl->start, decl->body, output, transpiler->filename);
 
                     /* Replace function body with semicolon for declaration */
-                    fprintf(output, ";\n");
-                }
-
-                /* Skip to end of function body */
-                i = find_function_end(children, brace_pos, count);
-            } else if (is_at_struct_or_typedef_keyword(children, i, count)) {
-                /* We're at the struct/typedef/enum/union keyword itself */
-                /* Scan backward to see if there's an export keyword before this */
-                int is_exported = 0;
-                size_t decl_start = i;
-
-                /* Look backward for export keyword (within last few tokens) */
-                for (size_t j = (i > 10 ? i - 10 : 0); j < i; j++) {
-                    if (is_export_keyword(children[j])) {
-                        is_exported = 1;
-                        decl_start = j;  /* Start from export keyword */
-                        break;
-                    }
-                    /* Stop if we hit a semicolon or brace */
-                    if (children[j]->type == AST_TOKEN && children[j]->token.type == TOKEN_PUNCTUATION &&
-                        children[j]->token.length == 1 && (children[j]->token.text[0] == ';' || children[j]->token.text[0] == '}')) {
-                        decl_start = j + 1;
-                    }
-                }
-
-                /* Find the end of this declaration */
-                size_t decl_end = i;
-                for (size_t j = i; j < count; j++) {
-                    if (children[j]->type == AST_TOKEN && children[j]->token.type == TOKEN_PUNCTUATION && children[j]->token.length == 1) {
-                        if (children[j]->token.text[0] == '{') {
-                            decl_end = find_brace_block_end(children, j, count);
-                            /* Look for semicolon after closing brace (for typedef) */
-                            for (size_t k = decl_end + 1; k < count && k < decl_end + 20; k++) {
-                                if (children[k]->type == AST_TOKEN && children[k]->token.type == TOKEN_PUNCTUATION &&
-                                    children[k]->token.length == 1 && children[k]->token.text[0] == ';') {
-                                    decl_end = k;
-                                    break;
-                                }
-                                /* Skip whitespace, comments, and identifiers (type name) */
-                                if (children[k]->type == AST_TOKEN &&
-                                    children[k]->token.type != TOKEN_WHITESPACE &&
-                                    children[k]->token.type != TOKEN_COMMENT &&
-                                    children[k]->token.type != TOKEN_IDENTIFIER) {
-                                    break;  /* Stop at other tokens */
-                                }
-                            }
-                            break;
-                        } else if (children[j]->token.text[0] == ';') {
-                            decl_end = j;
-                            break;
-                        }
-                    }
+                    sink_puts(output, ";\n");
                 }
-
-                if (is_exported) {
+                break;
+            case DECLARATION_TYPE:
+                if (decl->opaque) {
+                    /* Consumers only hold pointers: the body stays in the source */
+                    const char *name = children[skip_blank(children, decl->close + 1, decl->end)]->token.text;
+                    sink_printf(output, "typedef struct %s %s;", children[decl->tag]->token.text, name);
+                } else if (decl->exported) {
                     /* Emit the struct/typedef declaration, skip export keyword */
-                    emit_node_range_skip_export(children, decl_start, decl_end + 1, output, transpiler->filename);
-                }
-
-                /* Skip past this entire declaration */
-                i = decl_end;
-            } else {
-                /* For other tokens (whitespace, comments, etc.), emit as-is */
-                /* But skip standalone export keywords */
-                if (!is_export_keyword(children[i])) {
-                    emit_node(children[i], output, transpiler->filename);
+                    emit_node_range_skip_export(children, decl->start, decl->end + 1, output, transpiler->filename);
                 }
+                break;
             }
         }
     } else {
@@ -686,47 +1041,122 @@ void transpiler_emit_header(Transpiler_t *transpiler, FILE *output) {
     }
 }
 
-/* Helper to find end of any brace block */
-static size_t find_brace_block_end(ASTNode_t **children, size_t start, size_t count) {
-    int brace_depth = 0;
-    int started = 0;
+/* Helper to find end of the brace block opened at start */
+static size_t find_brace_block_end(ASTNode_t *parent, size_t start) {
+    size_t end = ast_match(parent, start);
+    return end == AST_NO_MATCH ? parent->child_count : end;
+}
 
-    for (size_t i = start; i < count; i++) {
-        if (children[i]->type != AST_TOKEN) continue;
+/* Find the name of a function: the identifier right before the first '(' (NULL if none) */
+static const char *function_name(ASTNode_t **children, const Declaration_t *decl, size_t *length) {
+    const char *name = NULL;
+    *length = 0;
+    for (size_t j = decl->start; j < decl->body; j++) {
+        Token *t = &children[j]->token;
+        if (children[j]->type == AST_TOKEN && t->type == TOKEN_PUNCTUATION && t->length == 1 && t->text[0] == '(') {
+            break;
+        }
+        if (children[j]->type == AST_TOKEN && t->type == TOKEN_IDENTIFIER) {
+            name = t->text;
+            *length = t->length;
+        }
+    }
+    return name;
+}
 
-        Token *t = &children[i]->token;
-        if (t->type == TOKEN_PUNCTUATION && t->length == 1) {
-            if (t->text[0] == '{') {
-                if (!started) {
-                    /* This is the opening brace we're starting from */
-                    brace_depth = 1;
-                    started = 1;
-                } else {
-                    brace_depth++;
-                }
-            } else if (t->text[0] == '}') {
-                brace_depth--;
-                if (started && brace_depth == 0) {
-                    return i;
-                }
-            }
+/* Emit the whitespace and comments leading a private function, then "static " unless it already has
+ * storage or is main; returns the index to continue emitting from */
+static size_t emit_static_prefix(ASTNode_t **children, const Declaration_t *decl, OutputSink_t *output,
+                                 const char *source_filename) {
+    size_t name_length = 0;
+    const char *name = function_name(children, decl, &name_length);
+    if (name && name_length == 4 && strncmp(name, "main", 4) == 0) {
+        return decl->start;
+    }
+
+    size_t j = decl->start;
+    while (j < decl->body && children[j]->type == AST_TOKEN &&
+           (children[j]->token.type == TOKEN_WHITESPACE || children[j]->token.type == TOKEN_COMMENT)) {
+        emit_node(children[j], output, source_filename);
+        j++;
+    }
+    for (size_t k = j; k < decl->body; k++) {
+        if (is_word(children[k], "static") || is_word(children[k], "extern")) {
+            return j;
+        }
+    }
+    sink_puts(output, "static ");
+    return j;
+}
+
+/* Check whether the source must include the header of its sibling name in directory: always, unless
+ * minimal headers find none of the sibling's names in the source (the sibling is then read for the outputs) */
+static bool sibling_needed(const Transpiler_t *transpiler, const char *directory, const char *name) {
+    if (!transpiler->minimal_headers) {
+        return true;
+    }
+    dependency_record_in(directory, name, DEPENDENCY_READ);
+    size_t len = strlen(directory) + strlen(name) + 2;
+    char *path = malloc(len);
+    if (!path) {
+        return true;
+    }
+    snprintf(path, len, "%s/%s", directory, name);
+    bool needed = sibling_referenced(path, &transpiler->identifiers);
+    free(path);
+    return needed;
+}
+
+/* Emit "struct Tag { ... };" for each struct the header forward declares */
+static void emit_opaque_structs(Transpiler_t *transpiler, OutputSink_t *output) {
+    ASTNode_t **children = transpiler->ast->children;
+    const DeclarationIndex_t *index = &transpiler->declarations;
+    for (size_t d = 0; d < index->count; d++) {
+        const Declaration_t *decl = &index->entries[d];
+        if (!decl->opaque) {
+            continue;
+        }
+        sink_printf(output, "\nstruct %s ", children[decl->tag]->token.text);
+        for (size_t j = decl->open; j <= decl->close; j++) {
+            emit_node(children[j], output, transpiler->filename);
         }
+        sink_puts(output, ";\n");
     }
-    return count;
 }
 
 /* Emit transformed AST as C source file (implementations only) */
-void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *header_name) {
+void transpiler_emit_source(Transpiler_t *transpiler, OutputSink_t *output, const char *header_name) {
     if (!transpiler || !transpiler->ast || !output) {
         return;
     }
 
-    /* Include the generated header */
-    fprintf(output, "#include \"%s\"\n", header_name);
+    /* Include the generated header (an amalgamation includes the module header once, a stream holds it) */
+    if (!transpiler->amalgamated && !transpiler->header_inlined) {
+        sink_printf(output, "#include \"%s\"\n", header_name);
+    }
+
+    /* Bodies of the structs the header forward declares, before any code that uses their fields */
+    emit_opaque_structs(transpiler, output);
+
+    /* Helpers of UNREACHABLE, TODO, FIXME and missing switch defaults, then likely/unlikely */
+    transpiler_emit_unreachable_helpers(output);
+    transpiler_emit_hint_helpers(output, false);
 
     /* Emit code from enabled features (e.g., defer cleanup functions) */
     feature_registry_emit(&transpiler->registry, output);
 
+    /* Traced functions open a libczar zone closed at return */
+    if (transpiler->trace) {
+        sink_puts(output, "void *cz_trace_zone(const char *name);\n");
+        sink_puts(output, "void cz_trace_end_zone(void **zone);\n");
+    }
+
+    /* Siblings are part of the same amalgamation, their declarations are in its header */
+    if (transpiler->amalgamated) {
+        sink_putc(output, '\n');
+        goto emit_functions;
+    }
+
     /* Auto-include all other .cz.h files from the same module (directory) */
     /* This happens unconditionally for module directories */
     /* Skip for directories that look like test collections */
@@ -741,29 +1171,17 @@ void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *
             /* Skip auto-include for "test" directories (but not subdirectories like "test/app") */
             if (strcmp(base_dir_name, "test") == 0) {
                 /* Count .cz files - if many, it's likely a test collection */
-                DIR *dir_test = opendir(dir_result_test);
-                if (dir_test) {
-                    struct dirent *entry_test;
-                    int cz_count = 0;
-                    while ((entry_test = readdir(dir_test)) != NULL) {
-                        size_t name_len = strlen(entry_test->d_name);
-                        if (name_len > 3 && strcmp(entry_test->d_name + name_len - 3, ".cz") == 0) {
-                            cz_count++;
-                            if (cz_count > 5) {
-                                /* Many test files, don't auto-include */
-                                skip_auto_include = 1;
-                                break;
-                            }
-                        }
-                    }
-                    closedir(dir_test);
+                const DirListing_t *listing_test = dir_listing_cz(dir_result_test);
+                if (listing_test && listing_test->count > 5) {
+                    /* Many test files, don't auto-include */
+                    skip_auto_include = 1;
                 }
             }
             free(dir_copy_test);
         }
 
         if (skip_auto_include) {
-            fprintf(output, "\n");
+            sink_putc(output, '\n');
             goto emit_functions;
         }
     }
@@ -772,7 +1190,7 @@ void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *
         /* Get directory path */
         char *dir_copy = strdup(transpiler->filename);
         if (!dir_copy) {
-            fprintf(output, "\n");
+            sink_putc(output, '\n');
             goto emit_functions;
         }
         char *dir_result = dirname(dir_copy);
@@ -780,7 +1198,7 @@ void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *
         free(dir_copy);
 
         if (!dir_path) {
-            fprintf(output, "\n");
+            sink_putc(output, '\n');
             goto emit_functions;
         }
 
@@ -788,7 +1206,7 @@ void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *
         char *basename_copy = strdup(transpiler->filename);
         if (!basename_copy) {
             free(dir_path);
-            fprintf(output, "\n");
+            sink_putc(output, '\n');
             goto emit_functions;
         }
         char *basename_result = basename(basename_copy);
@@ -797,15 +1215,13 @@ void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *
 
         if (!base_name) {
             free(dir_path);
-            fprintf(output, "\n");
+            sink_putc(output, '\n');
             goto emit_functions;
         }
 
-        /* Open directory and scan for other .cz files */
-        DIR *dir = opendir(dir_path);
-        if (dir) {
-            struct dirent *entry;
-
+        /* List the other .cz files of the directory (sorted, read once per run) */
+        const DirListing_t *listing = dir_listing_cz(dir_path);
+        if (listing) {
             /* Determine if we need a directory prefix for includes */
             /* If dir_path is "." we don't need a prefix, otherwise we do */
             int need_prefix = (strcmp(dir_path, ".") != 0);
@@ -822,18 +1238,15 @@ void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *
                 }
             }
 
-            while ((entry = readdir(dir)) != NULL) {
-                /* Check if file ends with .cz and is not the current file */
-                size_t name_len = strlen(entry->d_name);
-                const size_t cz_ext_len = 3; /* length of ".cz" */
-                if (name_len > cz_ext_len && strcmp(entry->d_name + name_len - cz_ext_len, ".cz") == 0) {
-                    /* Skip the current file itself */
-                    if (strcmp(entry->d_name, base_name) != 0) {
-                        if (dir_prefix) {
-                            fprintf(output, "#include \"%s/%s.h\"\n", dir_prefix, entry->d_name);
-                        } else {
-                            fprintf(output, "#include \"%s.h\"\n", entry->d_name);
-                        }
+            for (size_t i = 0; i < listing->count; i++) {
+                /* Skip the current file itself */
+                const char *name = listing->names[i];
+                if (strcmp(name, base_name) != 0 && sibling_needed(transpiler, dir_path, name)) {
+                    record_header_dependency(dir_path, name);
+                    if (dir_prefix) {
+                        sink_printf(output, "#include \"%s/%s.h\"\n", dir_prefix, name);
+                    } else {
+                        sink_printf(output, "#include \"%s.h\"\n", name);
                     }
                 }
             }
@@ -841,122 +1254,46 @@ void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *
             if (dir_prefix) {
                 free(dir_prefix);
             }
-            closedir(dir);
         }
 
         free(base_name);
         free(dir_path);
     }
 
-    fprintf(output, "\n");
+    sink_putc(output, '\n');
 
 emit_functions:
     /* Emit function definitions and non-exported structs/typedefs */
     if (transpiler->ast->type == AST_TRANSLATION_UNIT) {
         ASTNode_t **children = transpiler->ast->children;
-        size_t count = transpiler->ast->child_count;
-
-        /* Scan through tokens looking for function definitions and non-exported items */
-        for (size_t i = 0; i < count; i++) {
-            /* Check if we're at the start of a function definition */
-            if (is_function_start(children, i, count)) {
-                /* Find the end of the function body */
-                size_t func_end = find_function_end(children, i, count);
+        const DeclarationIndex_t *index = &transpiler->declarations;
 
+        for (size_t d = 0; d < index->count; d++) {
+            const Declaration_t *decl = &index->entries[d];
+            if (decl->kind == DECLARATION_FUNCTION) {
                 /* Emit the entire function definition, skip export keyword */
-                emit_node_range_skip_export(children, i, func_end + 1, output, transpiler->filename);
-                fprintf(output, "\n\n");
-
-                /* Skip past the function */
-                i = func_end;
-            } else if (is_at_struct_or_typedef_keyword(children, i, count)) {
-                /* We're at a struct/typedef/enum/union keyword */
-                /* Scan backward to see if there's an export keyword */
-                int is_exported = 0;
-                size_t decl_start = i;
-
-                for (size_t j = (i > 10 ? i - 10 : 0); j < i; j++) {
-                    if (is_export_keyword(children[j])) {
-                        is_exported = 1;
-                        decl_start = j;
-                        break;
-                    }
-                    if (children[j]->type == AST_TOKEN && children[j]->token.type == TOKEN_PUNCTUATION &&
-                        children[j]->token.length == 1 && (children[j]->token.text[0] == ';' || children[j]->token.text[0] == '}')) {
-                        decl_start = j + 1;
-                    }
+                size_t start = decl->start;
+                if (transpiler->amalgamated && !decl->exported) {
+                    /* Private functions stay private to the amalgamated translation unit */
+                    start = emit_static_prefix(children, decl, output, transpiler->filename);
                 }
-
-                /* Only emit non-exported structs/typedefs in the source file */
-                if (!is_exported) {
-                    /* Find the end of this declaration (semicolon or brace block) */
-                    size_t decl_end = i;
-
-                    /* Find the opening brace or semicolon */
-                    for (size_t j = i; j < count; j++) {
-                        if (children[j]->type == AST_TOKEN && children[j]->token.type == TOKEN_PUNCTUATION && children[j]->token.length == 1) {
-                            if (children[j]->token.text[0] == '{') {
-                                decl_end = find_brace_block_end(children, j, count);
-                                /* Look for semicolon after closing brace (for typedef) */
-                                for (size_t k = decl_end + 1; k < count && k < decl_end + 20; k++) {
-                                    if (children[k]->type == AST_TOKEN && children[k]->token.type == TOKEN_PUNCTUATION &&
-                                        children[k]->token.length == 1 && children[k]->token.text[0] == ';') {
-                                        decl_end = k;
-                                        break;
-                                    }
-                                    /* Skip whitespace, comments, and identifiers (type name) */
-                                    if (children[k]->type == AST_TOKEN &&
-                                        children[k]->token.type != TOKEN_WHITESPACE &&
-                                        children[k]->token.type != TOKEN_COMMENT &&
-                                        children[k]->token.type != TOKEN_IDENTIFIER) {
-                                        break;  /* Stop at other tokens */
-                                    }
-                                }
-                                break;
-                            } else if (children[j]->token.text[0] == ';') {
-                                decl_end = j;
-                                break;
-                            }
-                        }
-                    }
-
-                    /* Emit the struct/typedef declaration from decl_start */
-                    for (size_t j = decl_start; j <= decl_end && j < count; j++) {
-                        emit_node(children[j], output, transpiler->filename);
-                    }
-                    fprintf(output, "\n\n");
-
-                    i = decl_end;
-                } else {
-                    /* It's exported, skip it (already in header) - find the end and skip past it */
-                    size_t decl_end = i;
-                    for (size_t j = i; j < count; j++) {
-                        if (children[j]->type == AST_TOKEN && children[j]->token.type == TOKEN_PUNCTUATION && children[j]->token.length == 1) {
-                            if (children[j]->token.text[0] == '{') {
-                                decl_end = find_brace_block_end(children, j, count);
-                                for (size_t k = decl_end + 1; k < count && k < decl_end + 20; k++) {
-                                    if (children[k]->type == AST_TOKEN && children[k]->token.type == TOKEN_PUNCTUATION &&
-                                        children[k]->token.length == 1 && children[k]->token.text[0] == ';') {
-                                        decl_end = k;
-                                        break;
-                                    }
-                                    /* Skip whitespace, comments, and identifiers (type name) */
-                                    if (children[k]->type == AST_TOKEN &&
-                                        children[k]->token.type != TOKEN_WHITESPACE &&
-                                        children[k]->token.type != TOKEN_COMMENT &&
-                                        children[k]->token.type != TOKEN_IDENTIFIER) {
-                                        break;  /* Stop at other tokens */
-                                    }
-                                }
-                                break;
-                            } else if (children[j]->token.text[0] == ';') {
-                                decl_end = j;
-                                break;
-                            }
-                        }
-                    }
-                    i = decl_end;
+                size_t name_length = 0;
+                const char *name = function_name(children, decl, &name_length);
+                if (transpiler->trace && decl->exported && name) {
+                    /* The zone opens on the line of the brace, so line numbers are unchanged */
+                    emit_node_range_skip_export(children, start, decl->body + 1, output, transpiler->filename);
+                    sink_printf(output, " __attribute__((cleanup(cz_trace_end_zone))) void *_cz_trace_zone = "
+                                        "cz_trace_zone(\"%.*s\");", (int)name_length, name);
+                    start = decl->body + 1;
+                }
+                emit_node_range_skip_export(children, start, decl->end + 1, output, transpiler->filename);
+                sink_puts(output, "\n\n");
+            } else if (decl->kind == DECLARATION_TYPE && !decl->exported && !decl->opaque) {
+                /* Only emit non-exported structs/typedefs in the source file (exported ones are in the header) */
+                for (size_t j = decl->start; j <= decl->end; j++) {
+                    emit_node(children[j], output, transpiler->filename);
                 }
+                sink_puts(output, "\n\n");
             }
             /* Skip all other tokens - they're in the header or are whitespace */
         }
@@ -9,17 +9,58 @@
 #pragma once
 
 #include "parser.h"
+#include "src/lines.h"
 #include "src/pragma.h"
 #include "registry.h"
+#include "hashtable.h"
+#include "sink.h"
 #include <stdio.h>
+#include <stdbool.h>
+
+/* Kind of a top-level declaration */
+typedef enum {
+    DECLARATION_TOKENS,          /* Run of other top-level tokens (whitespace, comments, stray export) */
+    DECLARATION_PREPROCESSOR,    /* Preprocessor directive other than #include */
+    DECLARATION_INCLUDE,         /* User #include line (the header has its own standard includes, keeps "quoted" ones) */
+    DECLARATION_FUNCTION,        /* Function definition */
+    DECLARATION_TYPE             /* struct/union/enum/typedef declaration */
+} DeclarationKind;
+
+/* One top-level declaration, as token indices in the translation unit */
+typedef struct {
+    DeclarationKind kind;        /* What the tokens declare */
+    size_t start;                /* First token (a type starts at its export keyword when it has one) */
+    size_t body;                 /* Opening brace of a function, the keyword of a type (start otherwise) */
+    size_t end;                  /* Last token (inclusive) */
+    bool exported;               /* Declared with export: goes to the header */
+    bool opaque;                 /* Private struct the header only uses by pointer: forward declared there */
+    size_t tag;                  /* Opaque struct: its tag (the open and closing braces follow) */
+    size_t open;                 /* Opaque struct: opening brace of its body */
+    size_t close;                /* Opaque struct: closing brace of its body */
+} Declaration_t;
+
+/* Top-level declarations in order, classified once for both emitters */
+typedef struct {
+    Declaration_t *entries;      /* Declarations */
+    size_t count;                /* Number of declarations */
+    size_t capacity;             /* Capacity of entries array */
+} DeclarationIndex_t;
 
 /* Transpiler structure */
 typedef struct Transpiler_s {
     ASTNode_t *ast;
     const char *filename;
     const char *source;
+    SymbolTable *symbols;      /* Interner shared by the lexer and every feature (outlives the file) */
+    LineTable_t lines;         /* Line starts of source for diagnostics */
     PragmaContext pragma_ctx;  /* Pragma settings */
     FeatureRegistry registry;  /* Feature registry */
+    DeclarationIndex_t declarations; /* Top-level declarations of the transformed AST */
+    bool amalgamated;          /* Emitting one file of a module amalgamation (cz --amalgamate) */
+    bool header_inlined;       /* The header precedes the source in one stream (cz --stdout) */
+    bool minimal_headers;      /* Forward declare opaque structs, include only referenced siblings */
+    bool trace;                /* Open a libczar trace zone in every exported function (cz --trace) */
+    HashTable_t identifiers;   /* hash_key_string of every identifier in the untransformed source (minimal headers) */
 } Transpiler_t;
 
 /* Initialize transpiler with AST */
@@ -31,12 +72,18 @@ void transpiler_cleanup(Transpiler_t *transpiler);
 /* Transform AST (apply CZar-specific transformations) */
 void transpiler_transform(Transpiler_t *transpiler);
 
+/* Classify the top-level declarations of the transformed AST (done by transpiler_transform) */
+void transpiler_index_declarations(Transpiler_t *transpiler);
+
 /* Emit transformed AST as C code to output file */
-void transpiler_emit(Transpiler_t *transpiler, FILE *output);
+void transpiler_emit(Transpiler_t *transpiler, OutputSink_t *output);
+
+/* Emit the #pragma once and standard includes every generated header starts with */
+void transpiler_emit_header_prelude(OutputSink_t *output);
 
 /* Emit transformed AST as C header file (declarations only) */
-void transpiler_emit_header(Transpiler_t *transpiler, FILE *output);
+void transpiler_emit_header(Transpiler_t *transpiler, OutputSink_t *output);
 
 /* Emit transformed AST as C source file (implementations only) */
-void transpiler_emit_source(Transpiler_t *transpiler, FILE *output, const char *header_name);
+void transpiler_emit_source(Transpiler_t *transpiler, OutputSink_t *output, const char *header_name);
 
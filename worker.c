@@ -0,0 +1,259 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Worker pool transpiling independent files in parallel (cz -j N).
+ */
+
+#include "src/cz.h"
+#include "worker.h"
+#include <stdlib.h>
+#include <setjmp.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define WORKER_THREADS
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+/* Buffers capturing the current job's output (NULL outside workers) */
+static CZ_THREAD_LOCAL FILE *capture_out = NULL;
+static CZ_THREAD_LOCAL FILE *capture_err = NULL;
+
+/* Where worker_fail returns to (NULL outside workers) */
+static CZ_THREAD_LOCAL jmp_buf *fail_jump = NULL;
+
+/* Stream for output and warnings of the current job (stdout outside workers) */
+FILE *worker_stdout(void) {
+    return capture_out ? capture_out : stdout;
+}
+
+/* Stream for errors of the current job (stderr outside workers) */
+FILE *worker_stderr(void) {
+    return capture_err ? capture_err : stderr;
+}
+
+/* Abandon the current job after a fatal error (exits with status outside workers) */
+void worker_fail(int status) {
+    if (fail_jump) {
+        longjmp(*fail_jump, 1);
+    }
+    exit(status);
+}
+
+#ifdef WORKER_THREADS
+/* Guards state shared by every worker */
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* Serialize access to state shared by every worker (e.g., caches filled by whichever file needs them first) */
+void worker_lock(void) {
+#ifdef WORKER_THREADS
+    pthread_mutex_lock(&shared_lock);
+#endif
+}
+
+/* Release worker_lock */
+void worker_unlock(void) {
+#ifdef WORKER_THREADS
+    pthread_mutex_unlock(&shared_lock);
+#endif
+}
+
+/* Get the number of online processors (at least 1) */
+unsigned worker_cpu_count(void) {
+#ifdef WORKER_THREADS
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0) {
+        return (unsigned)count;
+    }
+#endif
+    return 1;
+}
+
+/* Parse a -j thread count (0 for one per CPU), returns false if text is not a number */
+bool worker_parse_jobs(const char *text, unsigned *jobs) {
+    if (!text || !*text) {
+        return false;
+    }
+    char *end = NULL;
+    unsigned long value = strtoul(text, &end, 10);
+    if (*end != '\0' || value > 1024) {
+        return false;
+    }
+    *jobs = value == 0 ? worker_cpu_count() : (unsigned)value;
+    return true;
+}
+
+#ifdef WORKER_THREADS
+
+/* Captured output of one job */
+typedef struct {
+    char *out;                   /* Captured stdout text */
+    size_t out_size;             /* Length of out */
+    char *err;                   /* Captured stderr text */
+    size_t err_size;             /* Length of err */
+    bool ran;                    /* Job was run (not skipped) */
+    bool failed;                 /* Job failed or called worker_fail */
+} WorkerResult_t;
+
+/* Queue shared by the workers */
+typedef struct {
+    pthread_mutex_t lock;        /* Guards next and stop */
+    size_t next;                 /* Next job to hand out */
+    size_t stop;                 /* Jobs at or after this index are skipped */
+    size_t count;                /* Number of jobs */
+    WorkerJobFunc job;           /* Job function */
+    void *context;               /* Job context */
+    WorkerResult_t *results;     /* Per-job results */
+} WorkerQueue_t;
+
+/* Run one job with its output captured and fatal errors returning here */
+static void capture_job(WorkerJobFunc job, size_t index, void *context, WorkerResult_t *result) {
+    result->ran = true;
+    capture_out = open_memstream(&result->out, &result->out_size);
+    capture_err = open_memstream(&result->err, &result->err_size);
+
+    jmp_buf jump;
+    if (setjmp(jump) == 0) {
+        fail_jump = &jump;
+        if (!job(index, context)) {
+            result->failed = true;
+        }
+    } else {
+        result->failed = true;
+    }
+    fail_jump = NULL;
+
+    if (capture_out) fclose(capture_out);
+    if (capture_err) fclose(capture_err);
+    capture_out = NULL;
+    capture_err = NULL;
+}
+
+/* Print the captured output of a job */
+static void replay_result(const WorkerResult_t *result) {
+    if (result->out) fwrite(result->out, 1, result->out_size, stdout);
+    fflush(stdout);
+    if (result->err) fwrite(result->err, 1, result->err_size, stderr);
+}
+
+/* Run one job of the queue with its output captured */
+static void run_captured(WorkerQueue_t *queue, size_t index) {
+    WorkerResult_t *result = &queue->results[index];
+    capture_job(queue->job, index, queue->context, result);
+
+    if (result->failed) {
+        pthread_mutex_lock(&queue->lock);
+        if (index + 1 < queue->stop) {
+            queue->stop = index + 1;
+        }
+        pthread_mutex_unlock(&queue->lock);
+    }
+}
+
+/* Worker thread: take jobs from the queue until it is empty */
+static void *worker_main(void *arg) {
+    WorkerQueue_t *queue = (WorkerQueue_t *)arg;
+    while (1) {
+        pthread_mutex_lock(&queue->lock);
+        size_t index = queue->next;
+        if (index >= queue->stop) {
+            pthread_mutex_unlock(&queue->lock);
+            break;
+        }
+        queue->next++;
+        pthread_mutex_unlock(&queue->lock);
+
+        run_captured(queue, index);
+    }
+    return NULL;
+}
+
+#endif
+
+/* Run jobs 0..count-1 on up to threads workers, printing each job's output in job order.
+ * Like a serial run, jobs after the first failure are skipped, returns false if one failed. */
+bool worker_run(size_t count, unsigned threads, WorkerJobFunc job, void *context) {
+    if (!job) {
+        return false;
+    }
+    if (threads > count) {
+        threads = (unsigned)count;
+    }
+
+#ifdef WORKER_THREADS
+    if (threads > 1) {
+        WorkerQueue_t queue;
+        queue.next = 0;
+        queue.stop = count;
+        queue.count = count;
+        queue.job = job;
+        queue.context = context;
+        queue.results = calloc(count, sizeof(WorkerResult_t));
+        pthread_t *workers = malloc(threads * sizeof(pthread_t));
+        if (queue.results && workers && pthread_mutex_init(&queue.lock, NULL) == 0) {
+            unsigned started = 0;
+            while (started < threads && pthread_create(&workers[started], NULL, worker_main, &queue) == 0) {
+                started++;
+            }
+            /* Without any thread the queue is drained here */
+            if (started == 0) {
+                worker_main(&queue);
+            }
+            for (unsigned i = 0; i < started; i++) {
+                pthread_join(workers[i], NULL);
+            }
+            pthread_mutex_destroy(&queue.lock);
+
+            /* Replay output in job order, up to the first failure */
+            bool ok = true;
+            for (size_t i = 0; i < count && ok; i++) {
+                WorkerResult_t *result = &queue.results[i];
+                if (!result->ran) {
+                    break;
+                }
+                replay_result(result);
+                ok = !result->failed;
+            }
+            for (size_t i = 0; i < count; i++) {
+                free(queue.results[i].out);
+                free(queue.results[i].err);
+            }
+            free(queue.results);
+            free(workers);
+            return ok;
+        }
+        free(queue.results);
+        free(workers);
+    }
+#endif
+
+    /* Serial run, fatal errors exit right away */
+    for (size_t i = 0; i < count; i++) {
+        if (!job(i, context)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Run one job in the calling thread with fatal errors contained (they fail the job instead
+ * of exiting), printing its output once it ends. Returns false if the job failed. */
+bool worker_run_isolated(WorkerJobFunc job, size_t index, void *context) {
+    if (!job) {
+        return false;
+    }
+#ifdef WORKER_THREADS
+    WorkerResult_t result = {0};
+    capture_job(job, index, context, &result);
+    replay_result(&result);
+    fflush(stderr);
+    free(result.out);
+    free(result.err);
+    return !result.failed;
+#else
+    return job(index, context);
+#endif
+}
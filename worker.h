@@ -0,0 +1,56 @@
+/*
+ * CZar - semantic authority layer for C
+ * MIT License Copyright (c) 2026 ShkSchneider
+ * https://github.com/shkschneider/czar
+ *
+ * Worker pool transpiling independent files in parallel (cz -j N).
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Storage class for state owned by the thread transpiling a file */
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+    #define CZ_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+    #define CZ_THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+    #define CZ_THREAD_LOCAL __declspec(thread)
+#else
+    #define CZ_THREAD_LOCAL
+#endif
+
+/* Job run for one file index, returns false on failure */
+typedef bool (*WorkerJobFunc)(size_t index, void *context);
+
+/* Stream for output and warnings of the current job (stdout outside workers) */
+FILE *worker_stdout(void);
+
+/* Stream for errors of the current job (stderr outside workers) */
+FILE *worker_stderr(void);
+
+/* Abandon the current job after a fatal error (exits with status outside workers) */
+void worker_fail(int status);
+
+/* Serialize access to state shared by every worker (e.g., caches filled by whichever file needs them first) */
+void worker_lock(void);
+
+/* Release worker_lock */
+void worker_unlock(void);
+
+/* Get the number of online processors (at least 1) */
+unsigned worker_cpu_count(void);
+
+/* Parse a -j thread count (0 for one per CPU), returns false if text is not a number */
+bool worker_parse_jobs(const char *text, unsigned *jobs);
+
+/* Run jobs 0..count-1 on up to threads workers, printing each job's output in job order.
+ * Like a serial run, jobs after the first failure are skipped, returns false if one failed. */
+bool worker_run(size_t count, unsigned threads, WorkerJobFunc job, void *context);
+
+/* Run one job in the calling thread with fatal errors contained (they fail the job instead
+ * of exiting), printing its output once it ends. Returns false if the job failed. */
+bool worker_run_isolated(WorkerJobFunc job, size_t index, void *context);